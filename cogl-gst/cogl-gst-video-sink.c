@@ -37,6 +37,11 @@
 
 #include <ulib.h>
 
+/* The reference count of pooled textures is needed to tell whether
+ * anything other than the pool still uses them. Everything else in
+ * cogl-gst only uses the public api */
+#include "cogl-object-private.h"
+
 /* We just need the public Cogl api for cogl-gst but we first need to
  * undef COGL_COMPILATION to avoid getting an error that normally
  * checks cogl.h isn't used internally. */
@@ -47,6 +52,10 @@
 
 #define COGL_GST_DEFAULT_PRIORITY G_PRIORITY_HIGH_IDLE
 
+/* Enough to hold one retired frame of the formats with the most
+ * planes plus a little slack for when the caps change */
+#define COGL_GST_TEXTURE_POOL_SIZE 6
+
 #define BASE_SINK_CAPS "{ AYUV," \
                        "YV12," \
                        "I420," \
@@ -81,7 +90,8 @@ G_DEFINE_TYPE (CoglGstVideoSink, cogl_gst_video_sink, GST_TYPE_BASE_SINK);
 enum
 {
   PROP_0,
-  PROP_UPDATE_PRIORITY
+  PROP_UPDATE_PRIORITY,
+  PROP_PIXEL_BUFFER_UPLOADS
 };
 
 enum
@@ -154,11 +164,29 @@ typedef struct _CoglGstRenderer
                       GstBuffer *buffer);
 } CoglGstRenderer;
 
+/* A texture that isn't used by any frame anymore and can be updated
+ * with the data of a new frame of the same format and size */
+typedef struct _CoglGstPooledTexture
+{
+  CoglTexture *texture;
+  CoglPixelFormat format;
+} CoglGstPooledTexture;
+
 struct _CoglGstVideoSinkPrivate
 {
   CoglContext *ctx;
   CoglPipeline *pipeline;
   CoglTexture *frame[3];
+  CoglPixelFormat frame_format[3];
+  /* The textures of the previous frame. These are kept out of the
+   * pool for one more frame because the application may still have
+   * unflushed drawing that samples from them. Pooled textures are
+   * also only reused once nothing else references them */
+  CoglTexture *last_frame[3];
+  CoglPixelFormat last_frame_format[3];
+  GQueue texture_pool;
+  CoglBool use_pixel_buffers;
+  CoglPixelBuffer *upload_buffers[3];
   CoglBool frame_dirty;
   CoglGstVideoFormat format;
   CoglBool bgr;
@@ -403,21 +431,118 @@ cogl_gst_video_sink_get_pipeline (CoglGstVideoSink *vt)
   return priv->pipeline;
 }
 
+static void
+release_texture_to_pool (CoglGstVideoSink *sink,
+                         CoglTexture *texture,
+                         CoglPixelFormat format)
+{
+  CoglGstVideoSinkPrivate *priv = sink->priv;
+  CoglGstPooledTexture *pooled = g_slice_new (CoglGstPooledTexture);
+
+  pooled->texture = texture;
+  pooled->format = format;
+  g_queue_push_tail (&priv->texture_pool, pooled);
+
+  while (g_queue_get_length (&priv->texture_pool) >
+         COGL_GST_TEXTURE_POOL_SIZE)
+    {
+      pooled = g_queue_pop_head (&priv->texture_pool);
+      cogl_object_unref (pooled->texture);
+      g_slice_free (CoglGstPooledTexture, pooled);
+    }
+}
+
+/* A texture is only updated in place once the pool holds the last
+ * reference to it. Drawing that is still queued in a journal holds a
+ * reference on its pipeline, and through that on the textures it
+ * samples, so this also makes sure that the new contents can't show
+ * up in drawing that was done before the frame arrived */
+static CoglBool
+pooled_texture_is_unused (CoglTexture *texture)
+{
+  return ((CoglObject *) texture)->ref_count == 1;
+}
+
+static CoglTexture *
+take_pooled_texture (CoglGstVideoSink *sink,
+                     int width,
+                     int height,
+                     CoglPixelFormat format)
+{
+  CoglGstVideoSinkPrivate *priv = sink->priv;
+  GList *l;
+
+  for (l = priv->texture_pool.head; l; l = l->next)
+    {
+      CoglGstPooledTexture *pooled = l->data;
+
+      if (pooled->format == format &&
+          cogl_texture_get_width (pooled->texture) == width &&
+          cogl_texture_get_height (pooled->texture) == height &&
+          pooled_texture_is_unused (pooled->texture))
+        {
+          CoglTexture *texture = pooled->texture;
+
+          g_queue_delete_link (&priv->texture_pool, l);
+          g_slice_free (CoglGstPooledTexture, pooled);
+
+          return texture;
+        }
+    }
+
+  return NULL;
+}
+
 static void
 clear_frame_textures (CoglGstVideoSink *sink)
 {
   CoglGstVideoSinkPrivate *priv = sink->priv;
   int i;
 
+  /* Textures only become available for reuse once a whole frame has
+   * gone by since they were last displayed */
   for (i = 0; i < U_N_ELEMENTS (priv->frame); i++)
     {
-      if (priv->frame[i] == NULL)
-        break;
-      else
+      if (priv->last_frame[i])
+        release_texture_to_pool (sink,
+                                 priv->last_frame[i],
+                                 priv->last_frame_format[i]);
+
+      priv->last_frame[i] = priv->frame[i];
+      priv->last_frame_format[i] = priv->frame_format[i];
+    }
+
+  memset (priv->frame, 0, sizeof (priv->frame));
+
+  priv->frame_dirty = TRUE;
+}
+
+static void
+free_frame_textures (CoglGstVideoSink *sink)
+{
+  CoglGstVideoSinkPrivate *priv = sink->priv;
+  CoglGstPooledTexture *pooled;
+  int i;
+
+  for (i = 0; i < U_N_ELEMENTS (priv->frame); i++)
+    {
+      if (priv->frame[i])
         cogl_object_unref (priv->frame[i]);
+      if (priv->last_frame[i])
+        cogl_object_unref (priv->last_frame[i]);
+      if (priv->upload_buffers[i])
+        cogl_object_unref (priv->upload_buffers[i]);
     }
 
   memset (priv->frame, 0, sizeof (priv->frame));
+  memset (priv->last_frame, 0, sizeof (priv->last_frame));
+  memset (priv->upload_buffers, 0, sizeof (priv->upload_buffers));
+
+  while ((pooled = g_queue_pop_head (&priv->texture_pool)))
+    {
+      cogl_object_unref (pooled->texture);
+      g_slice_free (CoglGstPooledTexture, pooled);
+    }
 
   priv->frame_dirty = TRUE;
 }
@@ -487,6 +612,124 @@ video_texture_new_from_data (CoglContext *ctx,
   return tex;
 }
 
+/* Streams the data through a pixel buffer so that the driver can
+ * copy it into the texture asynchronously instead of having to do it
+ * before cogl_texture_set_region() returns */
+static CoglBool
+upload_via_pixel_buffer (CoglGstVideoSink *sink,
+                         int plane,
+                         CoglTexture *texture,
+                         int width,
+                         int height,
+                         CoglPixelFormat format,
+                         int rowstride,
+                         const uint8_t *data)
+{
+  CoglGstVideoSinkPrivate *priv = sink->priv;
+  CoglPixelBuffer *pixel_buffer = priv->upload_buffers[plane];
+  size_t size = (size_t) rowstride * height;
+  CoglBitmap *bitmap;
+  CoglBool ret;
+  uint8_t *map;
+
+  if (pixel_buffer &&
+      cogl_buffer_get_size (COGL_BUFFER (pixel_buffer)) != size)
+    {
+      cogl_object_unref (pixel_buffer);
+      pixel_buffer = NULL;
+    }
+
+  if (pixel_buffer == NULL)
+    {
+      pixel_buffer = cogl_pixel_buffer_new (priv->ctx, size, NULL, NULL);
+      if (pixel_buffer == NULL)
+        return FALSE;
+
+      cogl_buffer_set_update_hint (COGL_BUFFER (pixel_buffer),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+      priv->upload_buffers[plane] = pixel_buffer;
+    }
+
+  /* Discarding the previous contents lets the driver hand us fresh
+   * storage if the last upload from this buffer is still pending */
+  map = cogl_buffer_map (COGL_BUFFER (pixel_buffer),
+                         COGL_BUFFER_ACCESS_WRITE,
+                         COGL_BUFFER_MAP_HINT_DISCARD,
+                         NULL);
+  if (map == NULL)
+    return FALSE;
+
+  memcpy (map, data, size);
+  cogl_buffer_unmap (COGL_BUFFER (pixel_buffer));
+
+  bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (pixel_buffer),
+                                        format,
+                                        width, height,
+                                        rowstride,
+                                        0); /* offset */
+  ret = cogl_texture_set_region_from_bitmap (texture,
+                                             0, 0, /* src_x, src_y */
+                                             width, height,
+                                             bitmap,
+                                             0, 0, /* dst_x, dst_y */
+                                             0, /* level */
+                                             NULL);
+  cogl_object_unref (bitmap);
+
+  return ret;
+}
+
+/* Uploads one plane of a frame, reusing a texture from the pool if
+ * there is one of the right format and size so that we don't have to
+ * allocate new textures for every frame */
+static CoglTexture *
+video_texture_upload (CoglGstVideoSink *sink,
+                      int plane,
+                      int width,
+                      int height,
+                      CoglPixelFormat format,
+                      int rowstride,
+                      const uint8_t *data)
+{
+  CoglGstVideoSinkPrivate *priv = sink->priv;
+  CoglTexture *tex;
+
+  priv->frame_format[plane] = format;
+
+  tex = take_pooled_texture (sink, width, height, format);
+
+  if (tex)
+    {
+      CoglBool uploaded = FALSE;
+
+      if (priv->use_pixel_buffers)
+        uploaded = upload_via_pixel_buffer (sink, plane, tex,
+                                            width, height,
+                                            format, rowstride, data);
+
+      if (!uploaded)
+        uploaded = cogl_texture_set_region (tex,
+                                            width, height,
+                                            format,
+                                            rowstride,
+                                            data,
+                                            0, 0, /* dst_x, dst_y */
+                                            0, /* level */
+                                            NULL);
+
+      if (uploaded)
+        return tex;
+
+      cogl_object_unref (tex);
+    }
+
+  return video_texture_new_from_data (priv->ctx,
+                                      width, height,
+                                      format,
+                                      rowstride,
+                                      data);
+}
+
 static void
 cogl_gst_rgb24_glsl_setup_pipeline (CoglGstVideoSink *sink,
                                     CoglPipeline *pipeline)
@@ -540,11 +783,12 @@ cogl_gst_rgb24_upload (CoglGstVideoSink *sink,
 
   clear_frame_textures (sink);
 
-  priv->frame[0] = video_texture_new_from_data (priv->ctx, priv->info.width,
-                                                priv->info.height,
-                                                format,
-                                                priv->info.stride[0],
-                                                frame.data[0]);
+  priv->frame[0] = video_texture_upload (sink, 0,
+                                         priv->info.width,
+                                         priv->info.height,
+                                         format,
+                                         priv->info.stride[0],
+                                         frame.data[0]);
 
   gst_video_frame_unmap (&frame);
 
@@ -648,11 +892,12 @@ cogl_gst_rgb32_upload (CoglGstVideoSink *sink,
 
   clear_frame_textures (sink);
 
-  priv->frame[0] = video_texture_new_from_data (priv->ctx, priv->info.width,
-                                                priv->info.height,
-                                                format,
-                                                priv->info.stride[0],
-                                                frame.data[0]);
+  priv->frame[0] = video_texture_upload (sink, 0,
+                                         priv->info.width,
+                                         priv->info.height,
+                                         format,
+                                         priv->info.stride[0],
+                                         frame.data[0]);
 
   gst_video_frame_unmap (&frame);
 
@@ -701,25 +946,25 @@ cogl_gst_yv12_upload (CoglGstVideoSink *sink,
   clear_frame_textures (sink);
 
   priv->frame[0] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 0),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 0),
-                                 format,
-                                 priv->info.stride[0], frame.data[0]);
+    video_texture_upload (sink, 0,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 0),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 0),
+                          format,
+                          priv->info.stride[0], frame.data[0]);
 
   priv->frame[2] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1),
-                                 format,
-                                 priv->info.stride[1], frame.data[1]);
+    video_texture_upload (sink, 2,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1),
+                          format,
+                          priv->info.stride[1], frame.data[1]);
 
   priv->frame[1] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 2),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 2),
-                                 format,
-                                 priv->info.stride[2], frame.data[2]);
+    video_texture_upload (sink, 1,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 2),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 2),
+                          format,
+                          priv->info.stride[2], frame.data[2]);
 
   gst_video_frame_unmap (&frame);
 
@@ -746,25 +991,25 @@ cogl_gst_i420_upload (CoglGstVideoSink *sink,
   clear_frame_textures (sink);
 
   priv->frame[0] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 0),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 0),
-                                 format,
-                                 priv->info.stride[0], frame.data[0]);
+    video_texture_upload (sink, 0,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 0),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 0),
+                          format,
+                          priv->info.stride[0], frame.data[0]);
 
   priv->frame[1] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1),
-                                 format,
-                                 priv->info.stride[1], frame.data[1]);
+    video_texture_upload (sink, 1,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1),
+                          format,
+                          priv->info.stride[1], frame.data[1]);
 
   priv->frame[2] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 2),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 2),
-                                 format,
-                                 priv->info.stride[2], frame.data[2]);
+    video_texture_upload (sink, 2,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 2),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 2),
+                          format,
+                          priv->info.stride[2], frame.data[2]);
 
   gst_video_frame_unmap (&frame);
 
@@ -892,11 +1137,12 @@ cogl_gst_ayuv_upload (CoglGstVideoSink *sink,
 
   clear_frame_textures (sink);
 
-  priv->frame[0] = video_texture_new_from_data (priv->ctx, priv->info.width,
-                                                priv->info.height,
-                                                format,
-                                                priv->info.stride[0],
-                                                frame.data[0]);
+  priv->frame[0] = video_texture_upload (sink, 0,
+                                         priv->info.width,
+                                         priv->info.height,
+                                         format,
+                                         priv->info.stride[0],
+                                         frame.data[0]);
 
   gst_video_frame_unmap (&frame);
 
@@ -976,20 +1222,20 @@ cogl_gst_nv12_upload (CoglGstVideoSink *sink,
   clear_frame_textures (sink);
 
   priv->frame[0] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 0),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 0),
-                                 COGL_PIXEL_FORMAT_A_8,
-                                 priv->info.stride[0],
-                                 frame.data[0]);
+    video_texture_upload (sink, 0,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 0),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 0),
+                          COGL_PIXEL_FORMAT_A_8,
+                          priv->info.stride[0],
+                          frame.data[0]);
 
   priv->frame[1] =
-    video_texture_new_from_data (priv->ctx,
-                                 GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1),
-                                 GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1),
-                                 COGL_PIXEL_FORMAT_RG_88,
-                                 priv->info.stride[1],
-                                 frame.data[1]);
+    video_texture_upload (sink, 1,
+                          GST_VIDEO_INFO_COMP_WIDTH (&priv->info, 1),
+                          GST_VIDEO_INFO_COMP_HEIGHT (&priv->info, 1),
+                          COGL_PIXEL_FORMAT_RG_88,
+                          priv->info.stride[1],
+                          frame.data[1]);
 
   gst_video_frame_unmap (&frame);
 
@@ -1084,6 +1330,9 @@ cogl_gst_video_sink_set_context (CoglGstVideoSink *vt,
 
   if (priv->ctx)
     {
+      /* The textures belong to the old context so they can't be
+       * reused with the new one */
+      free_frame_textures (vt);
       cogl_object_unref (priv->ctx);
       g_slist_free (priv->renderers);
       priv->renderers = NULL;
@@ -1375,6 +1624,7 @@ cogl_gst_video_sink_init (CoglGstVideoSink *sink)
                                                    CoglGstVideoSinkPrivate);
   priv->custom_start = 0;
   priv->default_sample = TRUE;
+  g_queue_init (&priv->texture_pool);
 }
 
 static GstFlowReturn
@@ -1416,7 +1666,7 @@ cogl_gst_video_sink_dispose (GObject *object)
   self = COGL_GST_VIDEO_SINK (object);
   priv = self->priv;
 
-  clear_frame_textures (self);
+  free_frame_textures (self);
 
   if (priv->pipeline)
     {
@@ -1468,6 +1718,9 @@ cogl_gst_video_sink_set_property (GObject *object,
     case PROP_UPDATE_PRIORITY:
       cogl_gst_video_sink_set_priority (sink, g_value_get_int (value));
       break;
+    case PROP_PIXEL_BUFFER_UPLOADS:
+      sink->priv->use_pixel_buffers = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1488,6 +1741,9 @@ cogl_gst_video_sink_get_property (GObject *object,
     case PROP_UPDATE_PRIORITY:
       g_value_set_int (value, g_source_get_priority ((GSource *) priv->source));
       break;
+    case PROP_PIXEL_BUFFER_UPLOADS:
+      g_value_set_boolean (value, priv->use_pixel_buffers);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1555,6 +1811,17 @@ cogl_gst_video_sink_class_init (CoglGstVideoSinkClass *klass)
 
   g_object_class_install_property (go_class, PROP_UPDATE_PRIORITY, pspec);
 
+  pspec = g_param_spec_boolean ("pixel-buffer-uploads",
+                                "Pixel Buffer Uploads",
+                                "Whether to stream frame data to reused "
+                                "textures through pixel buffers",
+                                FALSE,
+                                COGL_GST_PARAM_READWRITE);
+
+  g_object_class_install_property (go_class,
+                                   PROP_PIXEL_BUFFER_UPLOADS,
+                                   pspec);
+
   video_sink_signals[PIPELINE_READY_SIGNAL] =
     g_signal_new ("pipeline-ready",
                   COGL_GST_TYPE_VIDEO_SINK,
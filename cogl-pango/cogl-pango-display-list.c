@@ -32,9 +32,12 @@
 
 #include <glib.h>
 #include <string.h>
+#include <math.h>
 
 #include "cogl-pango-display-list.h"
 #include "cogl-pango-pipeline-cache.h"
+#include "cogl-pango-distance-field.h"
+#include "cogl-pango-text-batch.h"
 #include "cogl/cogl-context-private.h"
 
 typedef enum
@@ -51,6 +54,7 @@ struct _CoglPangoDisplayList
 {
   CoglBool                color_override;
   CoglColor               color;
+  float                   distance_field_scale;
   GSList                 *nodes;
   GSList                 *last_node;
   CoglPangoPipelineCache *pipeline_cache;
@@ -83,6 +87,14 @@ struct _CoglPangoDisplayListNode
       GArray *rectangles;
       /* A primitive representing those vertices */
       CoglPrimitive *primitive;
+      /* Whether the rectangles have been drawn from the context's
+         stream buffer. The primitive is only created the second time
+         they are drawn so that text that is only drawn once doesn't
+         allocate a buffer */
+      CoglBool streamed;
+      /* The size of distance field glyphs relative to their size in
+         the texture */
+      float distance_field_scale;
     } texture;
 
     struct
@@ -93,6 +105,9 @@ struct _CoglPangoDisplayListNode
 
     struct
     {
+      /* The corners are kept so that the trapezoid can be added to a
+         text batch */
+      CoglVertexP2 vertices[4];
       CoglPrimitive *primitive;
     } trapezoid;
   } d;
@@ -104,6 +119,7 @@ _cogl_pango_display_list_new (CoglPangoPipelineCache *pipeline_cache)
   CoglPangoDisplayList *dl = g_slice_new0 (CoglPangoDisplayList);
 
   dl->pipeline_cache = pipeline_cache;
+  dl->distance_field_scale = 1.0f;
 
   return dl;
 }
@@ -132,6 +148,13 @@ _cogl_pango_display_list_remove_color_override (CoglPangoDisplayList *dl)
   dl->color_override = FALSE;
 }
 
+void
+_cogl_pango_display_list_set_distance_field_scale (CoglPangoDisplayList *dl,
+                                                   float scale)
+{
+  dl->distance_field_scale = scale;
+}
+
 void
 _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
                                       CoglTexture *texture,
@@ -148,6 +171,7 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
   if (dl->last_node
       && (node = dl->last_node->data)->type == COGL_PANGO_DISPLAY_LIST_TEXTURE
       && node->d.texture.texture == texture
+      && node->d.texture.distance_field_scale == dl->distance_field_scale
       && (dl->color_override
           ? (node->color_override && cogl_color_equal (&dl->color, &node->color))
           : !node->color_override))
@@ -158,6 +182,7 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
           cogl_object_unref (node->d.texture.primitive);
           node->d.texture.primitive = NULL;
         }
+      node->d.texture.streamed = FALSE;
     }
   else
     {
@@ -172,6 +197,8 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
       node->d.texture.rectangles
         = g_array_new (FALSE, FALSE, sizeof (CoglPangoDisplayListRectangle));
       node->d.texture.primitive = NULL;
+      node->d.texture.streamed = FALSE;
+      node->d.texture.distance_field_scale = dl->distance_field_scale;
 
       _cogl_pango_display_list_append_node (dl, node);
     }
@@ -233,6 +260,7 @@ _cogl_pango_display_list_add_trapezoid (CoglPangoDisplayList *dl,
   node->color = dl->color;
   node->pipeline = NULL;
 
+  memcpy (node->d.trapezoid.vertices, vertices, sizeof (vertices));
   node->d.trapezoid.primitive =
     cogl_primitive_new_p2 (ctx,
                            COGL_VERTICES_MODE_TRIANGLE_FAN,
@@ -255,6 +283,122 @@ emit_rectangles_through_journal (CoglFramebuffer *fb,
                                              node->d.texture.rectangles->len);
 }
 
+static void
+write_rectangle_vertices (CoglPangoDisplayListNode *node,
+                          CoglVertexP2T2 *v)
+{
+  int i;
+
+  /* Copy the rectangles into the buffer and expand into four
+     vertices instead of just two */
+  for (i = 0; i < node->d.texture.rectangles->len; i++)
+    {
+      const CoglPangoDisplayListRectangle *rectangle
+        = &g_array_index (node->d.texture.rectangles,
+                          CoglPangoDisplayListRectangle, i);
+
+      v->x = rectangle->x_1;
+      v->y = rectangle->y_1;
+      v->s = rectangle->s_1;
+      v->t = rectangle->t_1;
+      v++;
+      v->x = rectangle->x_1;
+      v->y = rectangle->y_2;
+      v->s = rectangle->s_1;
+      v->t = rectangle->t_2;
+      v++;
+      v->x = rectangle->x_2;
+      v->y = rectangle->y_2;
+      v->s = rectangle->s_2;
+      v->t = rectangle->t_2;
+      v++;
+      v->x = rectangle->x_2;
+      v->y = rectangle->y_1;
+      v->s = rectangle->s_2;
+      v->t = rectangle->t_1;
+      v++;
+    }
+}
+
+static CoglPrimitive *
+create_rectangles_primitive (CoglContext *ctx,
+                             CoglPangoDisplayListNode *node,
+                             CoglAttributeBuffer *buffer,
+                             size_t offset)
+{
+  CoglAttribute *attributes[2];
+  CoglPrimitive *prim;
+
+  attributes[0] = cogl_attribute_new (buffer,
+                                      "cogl_position_in",
+                                      sizeof (CoglVertexP2T2),
+                                      offset +
+                                      G_STRUCT_OFFSET (CoglVertexP2T2, x),
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[1] = cogl_attribute_new (buffer,
+                                      "cogl_tex_coord0_in",
+                                      sizeof (CoglVertexP2T2),
+                                      offset +
+                                      G_STRUCT_OFFSET (CoglVertexP2T2, s),
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  prim = cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                             node->d.texture.rectangles->len *
+                                             4,
+                                             attributes,
+                                             2 /* n_attributes */);
+
+#ifdef CLUTTER_COGL_HAS_GL
+  if (_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_QUADS))
+    cogl_primitive_set_mode (prim, GL_QUADS);
+  else
+#endif
+    {
+      /* GLES doesn't support GL_QUADS so instead we use a VBO
+         with indexed vertices to generate GL_TRIANGLES from the
+         quads */
+
+      CoglIndices *indices =
+        cogl_get_rectangle_indices (ctx, node->d.texture.rectangles->len);
+
+      cogl_primitive_set_indices (prim, indices,
+                                  node->d.texture.rectangles->len * 6);
+    }
+
+  cogl_object_unref (attributes[0]);
+  cogl_object_unref (attributes[1]);
+
+  return prim;
+}
+
+static void
+emit_streamed_geometry (CoglFramebuffer *fb,
+                        CoglPipeline *pipeline,
+                        CoglPangoDisplayListNode *node)
+{
+  CoglContext *ctx = fb->context;
+  CoglAttributeBuffer *buffer;
+  CoglVertexP2T2 *verts;
+  CoglPrimitive *prim;
+  size_t offset;
+
+  verts = _cogl_stream_buffer_map (ctx->stream_buffer,
+                                   node->d.texture.rectangles->len * 4 *
+                                   sizeof (CoglVertexP2T2),
+                                   &buffer,
+                                   &offset);
+  write_rectangle_vertices (node, verts);
+  _cogl_stream_buffer_unmap (ctx->stream_buffer);
+
+  prim = create_rectangles_primitive (ctx, node, buffer, offset);
+  cogl_primitive_draw (prim, fb, pipeline);
+  cogl_object_unref (prim);
+
+  _cogl_stream_buffer_release (ctx->stream_buffer);
+}
+
 static void
 emit_vertex_buffer_geometry (CoglFramebuffer *fb,
                              CoglPipeline *pipeline,
@@ -268,17 +412,23 @@ emit_vertex_buffer_geometry (CoglFramebuffer *fb,
    * we load the vertices into a VBO, and this has the added advantage
    * that if the text doesn't change from frame to frame the VBO can
    * be re-used avoiding the repeated cost of validating the data and
-   * mapping it into the GPU... */
+   * mapping it into the GPU... The first time the text is drawn it
+   * isn't known whether it will be drawn again so the vertices are
+   * only written to the context's stream buffer. */
+
+  if (node->d.texture.primitive == NULL && !node->d.texture.streamed)
+    {
+      emit_streamed_geometry (fb, pipeline, node);
+      node->d.texture.streamed = TRUE;
+      return;
+    }
 
   if (node->d.texture.primitive == NULL)
     {
       CoglAttributeBuffer *buffer;
-      CoglVertexP2T2 *verts, *v;
+      CoglVertexP2T2 *verts;
       int n_verts;
       CoglBool allocated = FALSE;
-      CoglAttribute *attributes[2];
-      CoglPrimitive *prim;
-      int i;
       CoglError *ignore_error = NULL;
 
       n_verts = node->d.texture.rectangles->len * 4;
@@ -298,37 +448,7 @@ emit_vertex_buffer_geometry (CoglFramebuffer *fb,
           allocated = TRUE;
         }
 
-      v = verts;
-
-      /* Copy the rectangles into the buffer and expand into four
-         vertices instead of just two */
-      for (i = 0; i < node->d.texture.rectangles->len; i++)
-        {
-          const CoglPangoDisplayListRectangle *rectangle
-            = &g_array_index (node->d.texture.rectangles,
-                              CoglPangoDisplayListRectangle, i);
-
-          v->x = rectangle->x_1;
-          v->y = rectangle->y_1;
-          v->s = rectangle->s_1;
-          v->t = rectangle->t_1;
-          v++;
-          v->x = rectangle->x_1;
-          v->y = rectangle->y_2;
-          v->s = rectangle->s_1;
-          v->t = rectangle->t_2;
-          v++;
-          v->x = rectangle->x_2;
-          v->y = rectangle->y_2;
-          v->s = rectangle->s_2;
-          v->t = rectangle->t_2;
-          v++;
-          v->x = rectangle->x_2;
-          v->y = rectangle->y_1;
-          v->s = rectangle->s_2;
-          v->t = rectangle->t_1;
-          v++;
-        }
+      write_rectangle_vertices (node, verts);
 
       if (allocated)
         {
@@ -342,46 +462,10 @@ emit_vertex_buffer_geometry (CoglFramebuffer *fb,
       else
         cogl_buffer_unmap (COGL_BUFFER (buffer));
 
-      attributes[0] = cogl_attribute_new (buffer,
-                                          "cogl_position_in",
-                                          sizeof (CoglVertexP2T2),
-                                          G_STRUCT_OFFSET (CoglVertexP2T2, x),
-                                          2, /* n_components */
-                                          COGL_ATTRIBUTE_TYPE_FLOAT);
-      attributes[1] = cogl_attribute_new (buffer,
-                                          "cogl_tex_coord0_in",
-                                          sizeof (CoglVertexP2T2),
-                                          G_STRUCT_OFFSET (CoglVertexP2T2, s),
-                                          2, /* n_components */
-                                          COGL_ATTRIBUTE_TYPE_FLOAT);
-
-      prim = cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
-                                                 n_verts,
-                                                 attributes,
-                                                 2 /* n_attributes */);
-
-#ifdef CLUTTER_COGL_HAS_GL
-      if (_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_QUADS))
-        cogl_primitive_set_mode (prim, GL_QUADS);
-      else
-#endif
-        {
-          /* GLES doesn't support GL_QUADS so instead we use a VBO
-             with indexed vertices to generate GL_TRIANGLES from the
-             quads */
-
-          CoglIndices *indices =
-            cogl_get_rectangle_indices (ctx, node->d.texture.rectangles->len);
-
-          cogl_primitive_set_indices (prim, indices,
-                                      node->d.texture.rectangles->len * 6);
-        }
-
-      node->d.texture.primitive = prim;
+      node->d.texture.primitive =
+        create_rectangles_primitive (ctx, node, buffer, 0 /* offset */);
 
       cogl_object_unref (buffer);
-      cogl_object_unref (attributes[0]);
-      cogl_object_unref (attributes[1]);
     }
 
   cogl_primitive_draw (node->d.texture.primitive,
@@ -405,47 +489,140 @@ _cogl_framebuffer_draw_display_list_texture (CoglFramebuffer *fb,
     emit_vertex_buffer_geometry (fb, pipeline, node);
 }
 
+/* Returns how many framebuffer pixels one unit of the current
+   modelview covers near the origin */
+static float
+get_device_scale (CoglFramebuffer *fb)
+{
+  CoglMatrix modelview, projection, transform;
+  float viewport[4];
+  float window[3][2];
+  float dx, dy;
+  float scale_x, scale_y;
+  int i;
+
+  cogl_framebuffer_get_modelview_matrix (fb, &modelview);
+  cogl_framebuffer_get_projection_matrix (fb, &projection);
+  cogl_matrix_multiply (&transform, &projection, &modelview);
+  cogl_framebuffer_get_viewport4fv (fb, viewport);
+
+  /* Project the origin and a unit step along each axis */
+  for (i = 0; i < 3; i++)
+    {
+      float x = i == 1 ? 1.0f : 0.0f;
+      float y = i == 2 ? 1.0f : 0.0f;
+      float z = 0.0f;
+      float w = 1.0f;
+
+      cogl_matrix_transform_point (&transform, &x, &y, &z, &w);
+
+      /* The point is behind the viewer so there's no sensible scale */
+      if (w <= 0.0f)
+        return 1.0f;
+
+      window[i][0] = x / w * viewport[2] / 2.0f;
+      window[i][1] = y / w * viewport[3] / 2.0f;
+    }
+
+  dx = window[1][0] - window[0][0];
+  dy = window[1][1] - window[0][1];
+  scale_x = sqrtf (dx * dx + dy * dy);
+
+  dx = window[2][0] - window[0][0];
+  dy = window[2][1] - window[0][1];
+  scale_y = sqrtf (dx * dx + dy * dy);
+
+  return MAX (scale_x, scale_y);
+}
+
+static float
+get_distance_field_width (CoglPangoDisplayListNode *node,
+                          float device_scale)
+{
+  float pixels_per_texel = node->d.texture.distance_field_scale * device_scale;
+
+  /* The distance field value changes by 1/(2*spread) per texel so
+     this is how much it changes across one pixel */
+  if (pixels_per_texel > 0.0f)
+    return 1.0f / (2.0f * COGL_PANGO_DISTANCE_FIELD_SPREAD * pixels_per_texel);
+  else
+    return 1.0f;
+}
+
+static void
+update_distance_field_width (CoglPangoDisplayList *dl,
+                             CoglPangoDisplayListNode *node,
+                             float device_scale)
+{
+  cogl_pipeline_set_uniform_1f (node->pipeline,
+                                dl->pipeline_cache->
+                                distance_field_width_location,
+                                get_distance_field_width (node,
+                                                          device_scale));
+}
+
+static void
+ensure_node_pipeline (CoglPangoDisplayList *dl,
+                      CoglPangoDisplayListNode *node)
+{
+  if (node->pipeline == NULL)
+    {
+      if (node->type == COGL_PANGO_DISPLAY_LIST_TEXTURE)
+        node->pipeline =
+          _cogl_pango_pipeline_cache_get (dl->pipeline_cache,
+                                          node->d.texture.texture);
+      else
+        node->pipeline =
+          _cogl_pango_pipeline_cache_get (dl->pipeline_cache,
+                                          NULL);
+    }
+}
+
+static void
+get_node_color (CoglPangoDisplayListNode *node,
+                const CoglColor *color,
+                CoglColor *draw_color)
+{
+  if (node->color_override)
+    /* Use the override color but preserve the alpha from the
+       draw color */
+    cogl_color_init_from_4ub (draw_color,
+                              cogl_color_get_red_byte (&node->color),
+                              cogl_color_get_green_byte (&node->color),
+                              cogl_color_get_blue_byte (&node->color),
+                              cogl_color_get_alpha_byte (color));
+  else
+    *draw_color = *color;
+  cogl_color_premultiply (draw_color);
+}
+
 void
 _cogl_pango_display_list_render (CoglFramebuffer *fb,
                                  CoglPangoDisplayList *dl,
                                  const CoglColor *color)
 {
   GSList *l;
+  float device_scale = -1.0f;
 
   for (l = dl->nodes; l; l = l->next)
     {
       CoglPangoDisplayListNode *node = l->data;
       CoglColor draw_color;
 
-      if (node->pipeline == NULL)
-        {
-          if (node->type == COGL_PANGO_DISPLAY_LIST_TEXTURE)
-            node->pipeline =
-              _cogl_pango_pipeline_cache_get (dl->pipeline_cache,
-                                              node->d.texture.texture);
-          else
-            node->pipeline =
-              _cogl_pango_pipeline_cache_get (dl->pipeline_cache,
-                                              NULL);
-        }
-
-      if (node->color_override)
-        /* Use the override color but preserve the alpha from the
-           draw color */
-        cogl_color_init_from_4ub (&draw_color,
-                                  cogl_color_get_red_byte (&node->color),
-                                  cogl_color_get_green_byte (&node->color),
-                                  cogl_color_get_blue_byte (&node->color),
-                                  cogl_color_get_alpha_byte (color));
-      else
-        draw_color = *color;
-      cogl_color_premultiply (&draw_color);
+      ensure_node_pipeline (dl, node);
 
+      get_node_color (node, color, &draw_color);
       cogl_pipeline_set_color (node->pipeline, &draw_color);
 
       switch (node->type)
         {
         case COGL_PANGO_DISPLAY_LIST_TEXTURE:
+          if (dl->pipeline_cache->use_distance_field)
+            {
+              if (device_scale < 0.0f)
+                device_scale = get_device_scale (fb);
+              update_distance_field_width (dl, node, device_scale);
+            }
           _cogl_framebuffer_draw_display_list_texture (fb, node->pipeline, node);
           break;
 
@@ -466,6 +643,81 @@ _cogl_pango_display_list_render (CoglFramebuffer *fb,
     }
 }
 
+void
+_cogl_pango_display_list_add_to_batch (CoglFramebuffer *fb,
+                                       CoglPangoDisplayList *dl,
+                                       const CoglColor *color,
+                                       CoglPangoTextBatch *batch)
+{
+  GSList *l;
+  float device_scale = -1.0f;
+
+  _cogl_pango_text_batch_set_target (batch, fb);
+
+  for (l = dl->nodes; l; l = l->next)
+    {
+      CoglPangoDisplayListNode *node = l->data;
+      CoglColor draw_color;
+
+      ensure_node_pipeline (dl, node);
+
+      /* The color is stored in the vertices so the pipeline can be
+         shared with nodes that have a different color */
+      get_node_color (node, color, &draw_color);
+
+      switch (node->type)
+        {
+        case COGL_PANGO_DISPLAY_LIST_TEXTURE:
+          {
+            int width_location = -1;
+            float width = 0.0f;
+
+            if (dl->pipeline_cache->use_distance_field)
+              {
+                if (device_scale < 0.0f)
+                  device_scale = get_device_scale (fb);
+                width_location =
+                  dl->pipeline_cache->distance_field_width_location;
+                width = get_distance_field_width (node, device_scale);
+              }
+
+            _cogl_pango_text_batch_add_rectangles
+              (batch,
+               node->pipeline,
+               width_location,
+               width,
+               &draw_color,
+               (const float *) node->d.texture.rectangles->data,
+               node->d.texture.rectangles->len);
+          }
+          break;
+
+        case COGL_PANGO_DISPLAY_LIST_RECTANGLE:
+          {
+            CoglVertexP2 vertices[4] = {
+              { node->d.rectangle.x_1, node->d.rectangle.y_1 },
+              { node->d.rectangle.x_1, node->d.rectangle.y_2 },
+              { node->d.rectangle.x_2, node->d.rectangle.y_2 },
+              { node->d.rectangle.x_2, node->d.rectangle.y_1 }
+            };
+
+            _cogl_pango_text_batch_add_quad (batch,
+                                             node->pipeline,
+                                             &draw_color,
+                                             vertices);
+          }
+          break;
+
+        case COGL_PANGO_DISPLAY_LIST_TRAPEZOID:
+          _cogl_pango_text_batch_add_quad (batch,
+                                           node->pipeline,
+                                           &draw_color,
+                                           node->d.trapezoid.vertices);
+          break;
+        }
+    }
+}
+
 static void
 _cogl_pango_display_list_node_free (CoglPangoDisplayListNode *node)
 {
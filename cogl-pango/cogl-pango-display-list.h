@@ -31,6 +31,7 @@
 
 #include <glib.h>
 #include "cogl-pango-pipeline-cache.h"
+#include "cogl-pango-text-batch.h"
 
 COGL_BEGIN_DECLS
 
@@ -46,6 +47,13 @@ _cogl_pango_display_list_set_color_override (CoglPangoDisplayList *dl,
 void
 _cogl_pango_display_list_remove_color_override (CoglPangoDisplayList *dl);
 
+/* Sets the size that distance field glyphs added after this call are
+   drawn at relative to the size they are stored at. This is only
+   used if the pipeline cache uses distance fields */
+void
+_cogl_pango_display_list_set_distance_field_scale (CoglPangoDisplayList *dl,
+                                                   float scale);
+
 void
 _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
                                       CoglTexture *texture,
@@ -73,6 +81,14 @@ _cogl_pango_display_list_render (CoglFramebuffer *framebuffer,
                                  CoglPangoDisplayList *dl,
                                  const CoglColor *color);
 
+/* Adds the display list to @batch instead of drawing it straight
+   away. The display list can be modified or freed afterwards */
+void
+_cogl_pango_display_list_add_to_batch (CoglFramebuffer *framebuffer,
+                                       CoglPangoDisplayList *dl,
+                                       const CoglColor *color,
+                                       CoglPangoTextBatch *batch);
+
 void
 _cogl_pango_display_list_clear (CoglPangoDisplayList *dl);
 
@@ -0,0 +1,185 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <math.h>
+
+#include "cogl-pango-distance-field.h"
+
+#define INF 1e20f
+
+/* One dimensional squared Euclidean distance transform of the
+ * sampled function in @grid using the algorithm from Felzenszwalb
+ * and Huttenlocher, "Distance Transforms of Sampled Functions". @f,
+ * @v and @z are scratch arrays of at least @length, @length and
+ * @length + 1 elements */
+static void
+edt_1d (float *grid,
+        int offset,
+        int stride,
+        int length,
+        float *f,
+        int *v,
+        float *z)
+{
+  int q, k;
+
+  v[0] = 0;
+  z[0] = -INF;
+  z[1] = INF;
+  f[0] = grid[offset];
+
+  for (q = 1, k = 0; q < length; q++)
+    {
+      float s;
+
+      f[q] = grid[offset + q * stride];
+
+      /* Remove the parabolas that are hidden by the one at q. If all
+         of them are then k ends up at -1 */
+      do
+        {
+          int r = v[k];
+
+          s = (f[q] - f[r] + q * q - r * r) / (q - r) / 2.0f;
+        }
+      while (s <= z[k] && --k > -1);
+
+      k++;
+      v[k] = q;
+      z[k] = s;
+      z[k + 1] = INF;
+    }
+
+  for (q = 0, k = 0; q < length; q++)
+    {
+      int r;
+
+      while (z[k + 1] < q)
+        k++;
+
+      r = v[k];
+      grid[offset + q * stride] = f[r] + (q - r) * (q - r);
+    }
+}
+
+static void
+edt_2d (float *grid,
+        int width,
+        int height,
+        float *f,
+        int *v,
+        float *z)
+{
+  int x, y;
+
+  for (x = 0; x < width; x++)
+    edt_1d (grid, x, width, height, f, v, z);
+
+  for (y = 0; y < height; y++)
+    edt_1d (grid, y * width, 1, width, f, v, z);
+}
+
+void
+_cogl_pango_distance_field_from_coverage (uint8_t *data,
+                                          int width,
+                                          int height,
+                                          int rowstride,
+                                          float spread)
+{
+  int size = width * height;
+  int length = MAX (width, height);
+  float *outer, *inner, *f, *z;
+  int *v;
+  int x, y;
+
+  if (size <= 0)
+    return;
+
+  outer = g_new (float, size * 2 + length * 2 + 1);
+  inner = outer + size;
+  f = inner + size;
+  z = f + length;
+  v = g_new (int, length);
+
+  /* Partially covered pixels are treated as being the distance to
+     the middle of the coverage range away from the edge so that the
+     antialiasing from the rasterizer isn't lost */
+  for (y = 0; y < height; y++)
+    {
+      const uint8_t *p = data + y * rowstride;
+
+      for (x = 0; x < width; x++)
+        {
+          float a = p[x] / 255.0f;
+          int i = y * width + x;
+
+          if (p[x] == 255)
+            {
+              outer[i] = 0.0f;
+              inner[i] = INF;
+            }
+          else if (p[x] == 0)
+            {
+              outer[i] = INF;
+              inner[i] = 0.0f;
+            }
+          else
+            {
+              float d = MAX (0.0f, 0.5f - a);
+              outer[i] = d * d;
+              d = MAX (0.0f, a - 0.5f);
+              inner[i] = d * d;
+            }
+        }
+    }
+
+  edt_2d (outer, width, height, f, v, z);
+  edt_2d (inner, width, height, f, v, z);
+
+  for (y = 0; y < height; y++)
+    {
+      uint8_t *p = data + y * rowstride;
+
+      for (x = 0; x < width; x++)
+        {
+          int i = y * width + x;
+          /* Positive outside of the shape */
+          float d = sqrtf (outer[i]) - sqrtf (inner[i]);
+          float value = 0.5f - d / (2.0f * spread);
+
+          p[x] = CLAMP (value, 0.0f, 1.0f) * 255.0f + 0.5f;
+        }
+    }
+
+  g_free (v);
+  g_free (outer);
+}
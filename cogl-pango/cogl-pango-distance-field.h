@@ -0,0 +1,57 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_PANGO_DISTANCE_FIELD_H__
+#define __COGL_PANGO_DISTANCE_FIELD_H__
+
+#include <glib.h>
+
+#include "cogl/cogl-types.h"
+
+COGL_BEGIN_DECLS
+
+/* The distance in pixels of the reference size over which the
+   distance field falls from fully inside to fully outside a glyph.
+   Glyphs are padded by this much on each side */
+#define COGL_PANGO_DISTANCE_FIELD_SPREAD 4
+
+/* Replaces an 8-bit coverage image in place with a signed distance
+   field. The edge of the shape maps to 128. Pixels that are @spread
+   or more pixels inside the shape become 255 and the ones that are
+   @spread or more outside become 0. */
+void
+_cogl_pango_distance_field_from_coverage (uint8_t *data,
+                                          int width,
+                                          int height,
+                                          int rowstride,
+                                          float spread);
+
+COGL_END_DECLS
+
+#endif /* __COGL_PANGO_DISTANCE_FIELD_H__ */
@@ -77,6 +77,10 @@ cogl_pango_font_map_new (CoglContext *context)
   CoglPangoFontMapPriv *priv = g_new0 (CoglPangoFontMapPriv, 1);
 
   priv->ctx = context;
+  /* The renderer remembers the thread it was created on as the one
+     that is allowed to touch the context so it is created here
+     instead of the first time it is needed */
+  priv->renderer = _cogl_pango_renderer_new (context);
 
   /* XXX: The public pango api doesn't let us sub-class
    * PangoCairoFontMap so we attach our own private data using qdata
@@ -100,8 +104,6 @@ PangoRenderer *
 _cogl_pango_font_map_get_renderer (CoglPangoFontMap *fm)
 {
   CoglPangoFontMapPriv *priv = _cogl_pango_font_map_get_priv (fm);
-  if (G_UNLIKELY (!priv->renderer))
-    priv->renderer = _cogl_pango_renderer_new (priv->ctx);
   return priv->renderer;
 }
 
@@ -148,6 +150,60 @@ cogl_pango_font_map_get_use_mipmapping (CoglPangoFontMap *fm)
     _cogl_pango_renderer_get_use_mipmapping (COGL_PANGO_RENDERER (renderer));
 }
 
+void
+cogl_pango_font_map_set_use_worker_threads (CoglPangoFontMap *fm,
+                                            CoglBool value)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  _cogl_pango_renderer_set_use_worker_threads (COGL_PANGO_RENDERER (renderer),
+                                               value);
+}
+
+CoglBool
+cogl_pango_font_map_get_use_worker_threads (CoglPangoFontMap *fm)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  return _cogl_pango_renderer_get_use_worker_threads
+    (COGL_PANGO_RENDERER (renderer));
+}
+
+void
+cogl_pango_font_map_begin_batch (CoglPangoFontMap *fm)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  _cogl_pango_renderer_begin_batch (COGL_PANGO_RENDERER (renderer));
+}
+
+void
+cogl_pango_font_map_end_batch (CoglPangoFontMap *fm)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  _cogl_pango_renderer_end_batch (COGL_PANGO_RENDERER (renderer));
+}
+
+void
+cogl_pango_font_map_set_use_distance_field (CoglPangoFontMap *fm,
+                                            CoglBool value)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  _cogl_pango_renderer_set_use_distance_field (COGL_PANGO_RENDERER (renderer),
+                                               value);
+}
+
+CoglBool
+cogl_pango_font_map_get_use_distance_field (CoglPangoFontMap *fm)
+{
+  PangoRenderer *renderer = _cogl_pango_font_map_get_renderer (fm);
+
+  return _cogl_pango_renderer_get_use_distance_field
+    (COGL_PANGO_RENDERER (renderer));
+}
+
 static GQuark
 cogl_pango_font_map_get_priv_key (void)
 {
@@ -29,12 +29,20 @@
 #include <config.h>
 
 #include <glib.h>
+#include <string.h>
 
 #include "cogl-pango-glyph-cache.h"
 #include "cogl-pango-private.h"
+#include "cogl-pango-distance-field.h"
 #include "cogl/cogl-atlas-set.h"
 #include "cogl/cogl-atlas-texture-private.h"
 #include "cogl/cogl-context-private.h"
+#include "cogl/cogl-worker-pool-private.h"
+
+/* The dirty glyphs are only shared out over the worker pool in bands
+   of at least this many so that drawing a few glyphs doesn't wake up
+   all of the threads */
+#define COGL_PANGO_GLYPH_CACHE_MIN_GLYPHS_PER_BAND 8
 
 typedef struct _CoglPangoGlyphCacheKey     CoglPangoGlyphCacheKey;
 
@@ -44,8 +52,56 @@ typedef struct _AtlasClosureState
   CoglAtlas *atlas;
   CoglAtlasReorganizeClosure *reorganize_closure;
   CoglAtlasAllocateClosure *allocate_closure;
+
+  /* A copy of the atlas's texture in CPU memory that dirty glyphs are
+     drawn into so that they can all be uploaded with a single call.
+     This is only used for the atlases in the cache's own atlas set
+     because the global atlases also contain other textures. The
+     staging buffer is replaced whenever the atlas gets a new texture
+     but that always marks all of the glyphs in the atlas as dirty so
+     nothing is lost. */
+  CoglTexture *staging_texture;
+  CoglPixelFormat staging_format;
+  uint8_t *staging_data;
+  int staging_rowstride;
+
+  /* The region of the staging buffer that has been drawn to since the
+     last upload. This is empty when dirty_x1 >= dirty_x2 */
+  int dirty_x1, dirty_y1;
+  int dirty_x2, dirty_y2;
 } AtlasClosureState;
 
+/* A glyph that needs to be drawn during
+   _cogl_pango_glyph_cache_set_dirty_glyphs */
+typedef struct
+{
+  PangoFont *font;
+  PangoGlyph glyph;
+  CoglPangoGlyphCacheValue *value;
+
+  /* Glyphs in the global atlas are drawn into the scratch buffer at
+     this offset. The scratch buffer is only resized once all of the
+     jobs are collected so the pointer is filled in afterwards */
+  CoglBool in_scratch;
+  size_t scratch_offset;
+
+  uint8_t *data;
+  int rowstride;
+  CoglPixelFormat format;
+} GlyphJob;
+
+struct _CoglPangoPrerenderedGlyph
+{
+  int draw_x;
+  int draw_y;
+  int draw_width;
+  int draw_height;
+
+  CoglPixelFormat format;
+  int rowstride;
+  uint8_t *data;
+};
+
 struct _CoglPangoGlyphCache
 {
   CoglContext *ctx;
@@ -67,9 +123,34 @@ struct _CoglPangoGlyphCache
      iterating the hash table if we know none of them are dirty */
   CoglBool has_dirty_glyphs;
 
+  /* Scratch buffer used to draw glyphs that are in the global atlas.
+     These have to be uploaded individually */
+  uint8_t *scratch_data;
+  size_t scratch_size;
+
+  /* Array of GlyphJobs that is reused for each dirty pass */
+  GArray *jobs;
+
+  /* Whether the glyphs are drawn on the context's worker pool as well
+     as the calling thread */
+  CoglBool use_worker_threads;
+
+  /* Glyphs that were drawn by _cogl_pango_glyph_cache_prerender on
+     another thread and haven't been looked up yet. The mutex guards
+     this table and any changes to hash_table so that the other
+     threads can check which glyphs are already cached. The context's
+     thread is the only one that modifies hash_table so it can read it
+     without locking */
+  GMutex prerender_mutex;
+  GHashTable *prerendered;
+
   /* Whether mipmapping is being used for this cache. This only
      affects whether we decide to put the glyph in the global atlas */
   CoglBool use_mipmapping;
+
+  /* Whether the glyphs are stored as distance fields. These are
+     padded and are never put in the global atlas */
+  CoglBool use_distance_field;
 };
 
 struct _CoglPangoGlyphCacheKey
@@ -78,14 +159,22 @@ struct _CoglPangoGlyphCacheKey
   PangoGlyph  glyph;
 };
 
+static void
+cogl_pango_prerendered_glyph_free (CoglPangoPrerenderedGlyph *prerendered)
+{
+  g_free (prerendered->data);
+  g_slice_free (CoglPangoPrerenderedGlyph, prerendered);
+}
+
 static void
 cogl_pango_glyph_cache_value_free (CoglPangoGlyphCacheValue *value)
 {
+  if (value->prerendered)
+    cogl_pango_prerendered_glyph_free (value->prerendered);
   if (value->texture)
-    {
-      cogl_object_unref (value->texture);
-      cogl_object_unref (value->atlas);
-    }
+    cogl_object_unref (value->texture);
+  if (value->atlas)
+    cogl_object_unref (value->atlas);
   g_slice_free (CoglPangoGlyphCacheValue, value);
 }
 
@@ -143,10 +232,9 @@ allocate_glyph_cb (CoglAtlas *atlas,
   float tex_width, tex_height;
 
   if (value->texture)
-    {
-      cogl_object_unref (value->texture);
-      cogl_object_unref (value->atlas);
-    }
+    cogl_object_unref (value->texture);
+  if (value->atlas)
+    cogl_object_unref (value->atlas);
   value->atlas = cogl_object_ref (atlas);
   value->texture = cogl_object_ref (texture);
 
@@ -177,7 +265,7 @@ atlas_callback (CoglAtlasSet *set,
   switch (event)
     {
     case COGL_ATLAS_SET_EVENT_ADDED:
-      state = g_slice_new (AtlasClosureState);
+      state = g_slice_new0 (AtlasClosureState);
       state->atlas = atlas;
       state->reorganize_closure =
         cogl_atlas_add_post_reorganize_callback (atlas,
@@ -211,7 +299,8 @@ add_global_atlas_cb (CoglAtlas *atlas,
 
 CoglPangoGlyphCache *
 cogl_pango_glyph_cache_new (CoglContext *ctx,
-                            CoglBool use_mipmapping)
+                            CoglBool use_mipmapping,
+                            CoglBool use_distance_field)
 {
   CoglPangoGlyphCache *cache;
 
@@ -227,6 +316,13 @@ cogl_pango_glyph_cache_new (CoglContext *ctx,
      (UDestroyNotify) cogl_pango_glyph_cache_key_free,
      (UDestroyNotify) cogl_pango_glyph_cache_value_free);
 
+  g_mutex_init (&cache->prerender_mutex);
+  cache->prerendered = g_hash_table_new_full
+    (cogl_pango_glyph_cache_hash_func,
+     cogl_pango_glyph_cache_equal_func,
+     (UDestroyNotify) cogl_pango_glyph_cache_key_free,
+     (UDestroyNotify) cogl_pango_prerendered_glyph_free);
+
   _cogl_list_init (&cache->atlas_closures);
 
   cache->atlas_set = cogl_atlas_set_new (ctx);
@@ -237,6 +333,10 @@ cogl_pango_glyph_cache_new (CoglContext *ctx,
   cogl_atlas_set_set_migration_enabled (cache->atlas_set, FALSE);
   cogl_atlas_set_set_clear_enabled (cache->atlas_set, TRUE);
 
+  /* Glyphs are all roughly the same size so they pack much better
+   * along a skyline than with the default binary tree */
+  cogl_atlas_set_set_packing (cache->atlas_set, COGL_ATLAS_PACKING_SKYLINE);
+
   /* We want to be notified when new atlases are added to our local
    * atlas set so they can be monitored for being re-arranged... */
   cogl_atlas_set_add_atlas_callback (cache->atlas_set,
@@ -260,7 +360,15 @@ cogl_pango_glyph_cache_new (CoglContext *ctx,
 
   cache->has_dirty_glyphs = FALSE;
 
+  cache->scratch_data = NULL;
+  cache->scratch_size = 0;
+
+  cache->jobs = g_array_new (FALSE, FALSE, sizeof (GlyphJob));
+
+  cache->use_worker_threads = FALSE;
+
   cache->use_mipmapping = use_mipmapping;
+  cache->use_distance_field = use_distance_field;
 
   return cache;
 }
@@ -270,7 +378,10 @@ cogl_pango_glyph_cache_clear (CoglPangoGlyphCache *cache)
 {
   cache->has_dirty_glyphs = FALSE;
 
+  g_mutex_lock (&cache->prerender_mutex);
   g_hash_table_remove_all (cache->hash_table);
+  g_hash_table_remove_all (cache->prerendered);
+  g_mutex_unlock (&cache->prerender_mutex);
 }
 
 void
@@ -284,13 +395,23 @@ cogl_pango_glyph_cache_free (CoglPangoGlyphCache *cache)
                                                   state->reorganize_closure);
       cogl_atlas_remove_allocate_callback (state->atlas,
                                            state->allocate_closure);
+      if (state->staging_texture)
+        {
+          cogl_object_unref (state->staging_texture);
+          g_free (state->staging_data);
+        }
       _cogl_list_remove (&state->list_node);
       g_slice_free (AtlasClosureState, state);
     }
 
   cogl_pango_glyph_cache_clear (cache);
 
+  g_free (cache->scratch_data);
+  g_array_free (cache->jobs, TRUE);
+
   g_hash_table_unref (cache->hash_table);
+  g_hash_table_unref (cache->prerendered);
+  g_mutex_clear (&cache->prerender_mutex);
 
   g_hook_list_clear (&cache->reorganize_callbacks);
 
@@ -314,6 +435,10 @@ cogl_pango_glyph_cache_add_to_global_atlas (CoglPangoGlyphCache *cache,
   if (cache->use_mipmapping)
     return FALSE;
 
+  /* Distance fields need to be in an alpha-only texture */
+  if (cache->use_distance_field)
+    return FALSE;
+
   texture = cogl_atlas_texture_new_with_size (cache->ctx,
                                               value->draw_width,
                                               value->draw_height);
@@ -355,6 +480,40 @@ cogl_pango_glyph_cache_add_to_local_atlas (CoglPangoGlyphCache *cache,
   return TRUE;
 }
 
+/* Works out the area that the glyph will be drawn in. Returns FALSE
+   if the glyph doesn't take up any space */
+static CoglBool
+get_glyph_draw_rectangle (CoglPangoGlyphCache *cache,
+                          PangoFont *font,
+                          PangoGlyph glyph,
+                          CoglPangoGlyphCacheValue *value)
+{
+  PangoRectangle ink_rect;
+
+  pango_font_get_glyph_extents (font, glyph, &ink_rect, NULL);
+  pango_extents_to_pixels (&ink_rect, NULL);
+
+  value->draw_x = ink_rect.x;
+  value->draw_y = ink_rect.y;
+  value->draw_width = ink_rect.width;
+  value->draw_height = ink_rect.height;
+
+  if (ink_rect.width < 1 || ink_rect.height < 1)
+    return FALSE;
+
+  /* Leave room for the distance field to fall off outside of the
+     glyph */
+  if (cache->use_distance_field)
+    {
+      value->draw_x -= COGL_PANGO_DISTANCE_FIELD_SPREAD;
+      value->draw_y -= COGL_PANGO_DISTANCE_FIELD_SPREAD;
+      value->draw_width += COGL_PANGO_DISTANCE_FIELD_SPREAD * 2;
+      value->draw_height += COGL_PANGO_DISTANCE_FIELD_SPREAD * 2;
+    }
+
+  return TRUE;
+}
+
 CoglPangoGlyphCacheValue *
 cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
                                CoglBool             create,
@@ -372,22 +531,45 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
   if (create && value == NULL)
     {
       CoglPangoGlyphCacheKey *key;
-      PangoRectangle ink_rect;
+      CoglPangoPrerenderedGlyph *prerendered;
+      CoglBool has_area;
+      void *prerendered_key;
 
       value = g_slice_new (CoglPangoGlyphCacheValue);
+      value->atlas = NULL;
       value->texture = NULL;
 
-      pango_font_get_glyph_extents (font, glyph, &ink_rect, NULL);
-      pango_extents_to_pixels (&ink_rect, NULL);
+      /* If the glyph was already drawn on another thread then take
+         over its image */
+      g_mutex_lock (&cache->prerender_mutex);
+      if (g_hash_table_lookup_extended (cache->prerendered,
+                                        &lookup_key,
+                                        &prerendered_key,
+                                        (void **) &prerendered))
+        {
+          g_hash_table_steal (cache->prerendered, &lookup_key);
+          cogl_pango_glyph_cache_key_free (prerendered_key);
+        }
+      else
+        prerendered = NULL;
+      g_mutex_unlock (&cache->prerender_mutex);
+
+      value->prerendered = prerendered;
 
-      value->draw_x = ink_rect.x;
-      value->draw_y = ink_rect.y;
-      value->draw_width = ink_rect.width;
-      value->draw_height = ink_rect.height;
+      if (prerendered)
+        {
+          value->draw_x = prerendered->draw_x;
+          value->draw_y = prerendered->draw_y;
+          value->draw_width = prerendered->draw_width;
+          value->draw_height = prerendered->draw_height;
+          has_area = TRUE;
+        }
+      else
+        has_area = get_glyph_draw_rectangle (cache, font, glyph, value);
 
       /* If the glyph is zero-sized then we don't need to reserve any
          space for it and we can just avoid painting anything */
-      if (ink_rect.width < 1 || ink_rect.height < 1)
+      if (!has_area)
         value->dirty = FALSE;
       else
         {
@@ -414,12 +596,156 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
       key->font = g_object_ref (font);
       key->glyph = glyph;
 
+      g_mutex_lock (&cache->prerender_mutex);
       g_hash_table_insert (cache->hash_table, key, value);
+      g_mutex_unlock (&cache->prerender_mutex);
     }
 
   return value;
 }
 
+typedef struct
+{
+  CoglPangoGlyphCache *cache;
+  /* The state for the atlas of the last glyph that was drawn. Glyphs
+     from the same atlas tend to be next to each other in the hash
+     table so this avoids most of the searches */
+  AtlasClosureState *last_state;
+  size_t scratch_used;
+} SetDirtyGlyphsData;
+
+/* The jobs from one call to _cogl_pango_glyph_cache_set_dirty_glyphs
+   that are shared out between the calling thread and the worker
+   pool */
+typedef struct
+{
+  CoglPangoGlyphCacheDirtyFunc func;
+  GlyphJob *jobs;
+} GlyphJobBatch;
+
+static CoglPixelFormat
+get_argb_format (void)
+{
+  /* Glyphs that aren't alpha-only are drawn as 32-bit premultiplied
+     ARGB pixels in native byte order. Cogl's pixel formats specify
+     the actual byte order so we need to use a different format
+     depending on the architecture */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  return COGL_PIXEL_FORMAT_BGRA_8888_PRE;
+#else
+  return COGL_PIXEL_FORMAT_ARGB_8888_PRE;
+#endif
+}
+
+static CoglPixelFormat
+get_upload_format (CoglTexture *texture)
+{
+  if (_cogl_texture_get_format (texture) == COGL_PIXEL_FORMAT_A_8)
+    return COGL_PIXEL_FORMAT_A_8;
+  else
+    return get_argb_format ();
+}
+
+static int
+get_bytes_per_pixel (CoglPixelFormat format)
+{
+  return format == COGL_PIXEL_FORMAT_A_8 ? 1 : 4;
+}
+
+static int
+get_rowstride (CoglPixelFormat format, int width)
+{
+  /* Cairo requires each row to be aligned to 4 bytes */
+  return (width * get_bytes_per_pixel (format) + 3) & ~3;
+}
+
+static AtlasClosureState *
+get_staging_state (SetDirtyGlyphsData *data,
+                   CoglPangoGlyphCacheValue *value)
+{
+  AtlasClosureState *state = data->last_state;
+
+  if (state == NULL || state->atlas != value->atlas)
+    {
+      _cogl_list_for_each (state, &data->cache->atlas_closures, list_node)
+        if (state->atlas == value->atlas)
+          break;
+
+      g_assert (&state->list_node != &data->cache->atlas_closures);
+
+      data->last_state = state;
+    }
+
+  if (state->staging_texture != value->texture)
+    {
+      int height = cogl_texture_get_height (value->texture);
+
+      if (state->staging_texture)
+        {
+          cogl_object_unref (state->staging_texture);
+          g_free (state->staging_data);
+        }
+
+      state->staging_texture = cogl_object_ref (value->texture);
+      state->staging_format = get_upload_format (value->texture);
+      state->staging_rowstride =
+        get_rowstride (state->staging_format,
+                       cogl_texture_get_width (value->texture));
+      /* Start with a clear buffer so that the borders around the
+         glyphs will be empty */
+      state->staging_data = g_malloc0 (state->staging_rowstride * height);
+
+      state->dirty_x1 = state->dirty_y1 = G_MAXINT;
+      state->dirty_x2 = state->dirty_y2 = 0;
+    }
+
+  return state;
+}
+
+static void
+add_staging_job (SetDirtyGlyphsData *data,
+                 GlyphJob *job)
+{
+  CoglPangoGlyphCacheValue *value = job->value;
+  AtlasClosureState *state = get_staging_state (data, value);
+  int bpp = get_bytes_per_pixel (state->staging_format);
+  int y;
+
+  job->in_scratch = FALSE;
+  job->format = state->staging_format;
+  job->rowstride = state->staging_rowstride;
+  job->data = (state->staging_data +
+               value->ty_pixel * state->staging_rowstride +
+               value->tx_pixel * bpp);
+
+  /* The glyph may be replacing a glyph that was previously drawn in
+     the same place */
+  for (y = 0; y < value->draw_height; y++)
+    memset (job->data + y * job->rowstride, 0, value->draw_width * bpp);
+
+  state->dirty_x1 = MIN (state->dirty_x1, value->tx_pixel);
+  state->dirty_y1 = MIN (state->dirty_y1, value->ty_pixel);
+  state->dirty_x2 = MAX (state->dirty_x2,
+                         value->tx_pixel + value->draw_width);
+  state->dirty_y2 = MAX (state->dirty_y2,
+                         value->ty_pixel + value->draw_height);
+}
+
+static void
+add_scratch_job (SetDirtyGlyphsData *data,
+                 GlyphJob *job)
+{
+  CoglPangoGlyphCacheValue *value = job->value;
+
+  job->in_scratch = TRUE;
+  job->format = get_upload_format (value->texture);
+  job->rowstride = get_rowstride (job->format, value->draw_width);
+  job->scratch_offset = data->scratch_used;
+  job->data = NULL;
+
+  data->scratch_used += job->rowstride * value->draw_height;
+}
+
 static void
 _cogl_pango_glyph_cache_set_dirty_glyphs_cb (void *key_ptr,
                                              void *value_ptr,
@@ -427,32 +753,300 @@ _cogl_pango_glyph_cache_set_dirty_glyphs_cb (void *key_ptr,
 {
   CoglPangoGlyphCacheKey *key = key_ptr;
   CoglPangoGlyphCacheValue *value = value_ptr;
-  CoglPangoGlyphCacheDirtyFunc func = user_data;
+  SetDirtyGlyphsData *data = user_data;
+  GArray *jobs = data->cache->jobs;
 
   if (value->dirty)
     {
-      func (key->font, key->glyph, value);
+      GlyphJob *job;
+
+      g_array_set_size (jobs, jobs->len + 1);
+      job = &g_array_index (jobs, GlyphJob, jobs->len - 1);
+
+      job->font = key->font;
+      job->glyph = key->glyph;
+      job->value = value;
+
+      /* Glyphs in the global atlas don't have a CoglAtlas */
+      if (value->atlas)
+        add_staging_job (data, job);
+      else
+        add_scratch_job (data, job);
 
       value->dirty = FALSE;
     }
 }
 
+/* Copies a glyph that was drawn on another thread into the area for
+   the job. The glyph was drawn without knowing which atlas it would
+   end up in so it may need converting between the alpha-only and the
+   ARGB format */
+static void
+copy_prerendered_glyph (GlyphJob *job,
+                        CoglPangoPrerenderedGlyph *prerendered)
+{
+  int width = prerendered->draw_width;
+  int x, y;
+
+  for (y = 0; y < prerendered->draw_height; y++)
+    {
+      const uint8_t *src = prerendered->data + y * prerendered->rowstride;
+      uint8_t *dst = job->data + y * job->rowstride;
+
+      if (prerendered->format == job->format)
+        memcpy (dst, src, width * get_bytes_per_pixel (job->format));
+      else if (job->format == COGL_PIXEL_FORMAT_A_8)
+        {
+          /* The glyphs are drawn in white so the alpha is all that
+             is needed */
+          for (x = 0; x < width; x++)
+            dst[x] = ((const uint32_t *) src)[x] >> 24;
+        }
+      else
+        {
+          for (x = 0; x < width; x++)
+            ((uint32_t *) dst)[x] = src[x] * 0x01010101;
+        }
+    }
+}
+
+static void
+draw_glyph_rows (int first_row,
+                 int n_rows,
+                 void *user_data)
+{
+  GlyphJobBatch *batch = user_data;
+  int i;
+
+  for (i = first_row; i < first_row + n_rows; i++)
+    {
+      GlyphJob *job = batch->jobs + i;
+      CoglPangoGlyphCacheValue *value = job->value;
+
+      if (value->prerendered)
+        {
+          copy_prerendered_glyph (job, value->prerendered);
+
+          /* If the glyph gets dirty again it will be drawn normally */
+          cogl_pango_prerendered_glyph_free (value->prerendered);
+          value->prerendered = NULL;
+        }
+      else
+        batch->func (job->font, job->glyph, value,
+                     job->data, job->rowstride, job->format);
+    }
+}
+
+static void
+draw_glyphs (CoglPangoGlyphCache *cache,
+             CoglPangoGlyphCacheDirtyFunc func)
+{
+  GlyphJobBatch batch;
+
+  batch.func = func;
+  batch.jobs = &g_array_index (cache->jobs, GlyphJob, 0);
+
+  /* Each glyph is drawn into its own area so the rows of the batch
+     can be handled on any thread */
+  if (cache->use_worker_threads)
+    _cogl_worker_pool_run_rows (_cogl_context_get_worker_pool (cache->ctx),
+                                cache->jobs->len,
+                                COGL_PANGO_GLYPH_CACHE_MIN_GLYPHS_PER_BAND,
+                                draw_glyph_rows,
+                                &batch);
+  else
+    draw_glyph_rows (0, cache->jobs->len, &batch);
+}
+
+static void
+upload_staging (AtlasClosureState *state)
+{
+  int bpp;
+
+  if (state->dirty_x1 >= state->dirty_x2)
+    return;
+
+  bpp = get_bytes_per_pixel (state->staging_format);
+
+  /* Copy the rectangle enclosing all of the glyphs that were drawn in
+     one go. Any other glyphs in the rectangle are already in the
+     staging buffer so they will be rewritten with the same data */
+  cogl_texture_set_region (state->staging_texture,
+                           state->dirty_x2 - state->dirty_x1,
+                           state->dirty_y2 - state->dirty_y1,
+                           state->staging_format,
+                           state->staging_rowstride,
+                           state->staging_data +
+                           state->dirty_y1 * state->staging_rowstride +
+                           state->dirty_x1 * bpp,
+                           state->dirty_x1, /* dst_x */
+                           state->dirty_y1, /* dst_y */
+                           0, /* level */
+                           NULL); /* don't catch errors */
+
+  state->dirty_x1 = state->dirty_y1 = G_MAXINT;
+  state->dirty_x2 = state->dirty_y2 = 0;
+}
+
 void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
                                           CoglPangoGlyphCacheDirtyFunc func)
 {
+  SetDirtyGlyphsData data;
+  AtlasClosureState *state;
+  int i;
+
   /* If we know that there are no dirty glyphs then we can shortcut
      out early */
   if (!cache->has_dirty_glyphs)
     return;
 
+  data.cache = cache;
+  data.last_state = NULL;
+  data.scratch_used = 0;
+
+  /* Work out where each glyph will be drawn. This touches the atlases
+     so it has to happen on this thread */
+  g_array_set_size (cache->jobs, 0);
   g_hash_table_foreach (cache->hash_table,
                         _cogl_pango_glyph_cache_set_dirty_glyphs_cb,
-                        func);
+                        &data);
+
+  if (data.scratch_used > cache->scratch_size)
+    {
+      g_free (cache->scratch_data);
+      cache->scratch_data = g_malloc (data.scratch_used);
+      cache->scratch_size = data.scratch_used;
+    }
+  memset (cache->scratch_data, 0, data.scratch_used);
+
+  for (i = 0; i < cache->jobs->len; i++)
+    {
+      GlyphJob *job = &g_array_index (cache->jobs, GlyphJob, i);
+
+      if (job->in_scratch)
+        job->data = cache->scratch_data + job->scratch_offset;
+    }
+
+  /* The glyphs don't overlap so they can be drawn in any order and on
+     any thread */
+  draw_glyphs (cache, func);
+
+  /* Glyphs in the global atlas have to be uploaded individually */
+  for (i = 0; i < cache->jobs->len; i++)
+    {
+      GlyphJob *job = &g_array_index (cache->jobs, GlyphJob, i);
+
+      if (job->in_scratch)
+        cogl_texture_set_region (job->value->texture,
+                                 job->value->draw_width,
+                                 job->value->draw_height,
+                                 job->format,
+                                 job->rowstride,
+                                 job->data,
+                                 job->value->tx_pixel, /* dst_x */
+                                 job->value->ty_pixel, /* dst_y */
+                                 0, /* level */
+                                 NULL); /* don't catch errors */
+    }
+
+  _cogl_list_for_each (state, &cache->atlas_closures, list_node)
+    if (state->staging_texture)
+      upload_staging (state);
 
   cache->has_dirty_glyphs = FALSE;
 }
 
+void
+_cogl_pango_glyph_cache_set_use_worker_threads (CoglPangoGlyphCache *cache,
+                                                CoglBool value)
+{
+  cache->use_worker_threads = value;
+}
+
+CoglBool
+_cogl_pango_glyph_cache_get_use_worker_threads (CoglPangoGlyphCache *cache)
+{
+  return cache->use_worker_threads;
+}
+
+/* Checks whether the glyph is either in the cache or waiting to be
+   added to it. This must be called with the prerender mutex locked */
+static CoglBool
+is_glyph_known_locked (CoglPangoGlyphCache *cache,
+                       CoglPangoGlyphCacheKey *key)
+{
+  return (g_hash_table_contains (cache->hash_table, key) ||
+          g_hash_table_contains (cache->prerendered, key));
+}
+
+void
+_cogl_pango_glyph_cache_prerender (CoglPangoGlyphCache *cache,
+                                   PangoFont *font,
+                                   PangoGlyph glyph,
+                                   CoglPangoGlyphCacheDirtyFunc func)
+{
+  CoglPangoGlyphCacheKey lookup_key;
+  CoglPangoGlyphCacheKey *key;
+  CoglPangoGlyphCacheValue value;
+  CoglPangoPrerenderedGlyph *prerendered;
+  CoglBool known;
+
+  lookup_key.font = font;
+  lookup_key.glyph = glyph;
+
+  g_mutex_lock (&cache->prerender_mutex);
+  known = is_glyph_known_locked (cache, &lookup_key);
+  g_mutex_unlock (&cache->prerender_mutex);
+
+  if (known)
+    return;
+
+  /* Glyphs without any area are cheap to add on the context's
+     thread */
+  memset (&value, 0, sizeof (value));
+  if (!get_glyph_draw_rectangle (cache, font, glyph, &value))
+    return;
+
+  prerendered = g_slice_new (CoglPangoPrerenderedGlyph);
+  prerendered->draw_x = value.draw_x;
+  prerendered->draw_y = value.draw_y;
+  prerendered->draw_width = value.draw_width;
+  prerendered->draw_height = value.draw_height;
+
+  /* Guess which kind of atlas the glyph will end up in. If the guess
+     is wrong the image gets converted when it is uploaded */
+  if (cache->use_mipmapping || cache->use_distance_field)
+    prerendered->format = COGL_PIXEL_FORMAT_A_8;
+  else
+    prerendered->format = get_argb_format ();
+
+  prerendered->rowstride = get_rowstride (prerendered->format,
+                                          value.draw_width);
+  prerendered->data = g_malloc0 (prerendered->rowstride * value.draw_height);
+
+  func (font, glyph, &value,
+        prerendered->data,
+        prerendered->rowstride,
+        prerendered->format);
+
+  g_mutex_lock (&cache->prerender_mutex);
+
+  /* The glyph may have been added while it was being drawn */
+  if (is_glyph_known_locked (cache, &lookup_key))
+    cogl_pango_prerendered_glyph_free (prerendered);
+  else
+    {
+      key = g_slice_new (CoglPangoGlyphCacheKey);
+      key->font = g_object_ref (font);
+      key->glyph = glyph;
+
+      g_hash_table_insert (cache->prerendered, key, prerendered);
+    }
+
+  g_mutex_unlock (&cache->prerender_mutex);
+}
+
 void
 _cogl_pango_glyph_cache_add_reorganize_callback (CoglPangoGlyphCache *cache,
                                                  GHookFunc func,
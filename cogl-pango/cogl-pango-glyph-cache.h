@@ -39,6 +39,7 @@ COGL_BEGIN_DECLS
 
 typedef struct _CoglPangoGlyphCache      CoglPangoGlyphCache;
 typedef struct _CoglPangoGlyphCacheValue CoglPangoGlyphCacheValue;
+typedef struct _CoglPangoPrerenderedGlyph CoglPangoPrerenderedGlyph;
 
 struct _CoglPangoGlyphCacheValue
 {
@@ -61,15 +62,29 @@ struct _CoglPangoGlyphCacheValue
   /* This will be set to TRUE when the glyph atlas is reorganized
      which means the glyph will need to be redrawn */
   CoglBool   dirty;
+
+  /* The image of the glyph if it was drawn on another thread by
+     _cogl_pango_glyph_cache_prerender. It is copied into the texture
+     instead of drawing the glyph the first time it is dirty */
+  CoglPangoPrerenderedGlyph *prerendered;
 };
 
+/* Called to redraw a dirty glyph. The glyph should be drawn into
+   @data which points to a cleared area of draw_width x draw_height
+   pixels in @format with @rowstride bytes per row. The glyph cache
+   uploads the data to the glyph's texture afterwards so that glyphs
+   sharing a texture can be uploaded together */
 typedef void (* CoglPangoGlyphCacheDirtyFunc) (PangoFont *font,
                                                PangoGlyph glyph,
-                                               CoglPangoGlyphCacheValue *value);
+                                               CoglPangoGlyphCacheValue *value,
+                                               uint8_t *data,
+                                               int rowstride,
+                                               CoglPixelFormat format);
 
 CoglPangoGlyphCache *
 cogl_pango_glyph_cache_new (CoglContext *ctx,
-                            CoglBool use_mipmapping);
+                            CoglBool use_mipmapping,
+                            CoglBool use_distance_field);
 
 void
 cogl_pango_glyph_cache_free (CoglPangoGlyphCache *cache);
@@ -97,6 +112,28 @@ void
 _cogl_pango_glyph_cache_set_dirty_glyphs (CoglPangoGlyphCache *cache,
                                           CoglPangoGlyphCacheDirtyFunc func);
 
+/* Sets whether _cogl_pango_glyph_cache_set_dirty_glyphs shares the
+   glyphs out over the context's worker pool. If this is TRUE then
+   the dirty function must be safe to call from any thread. */
+void
+_cogl_pango_glyph_cache_set_use_worker_threads (CoglPangoGlyphCache *cache,
+                                                CoglBool value);
+
+CoglBool
+_cogl_pango_glyph_cache_get_use_worker_threads (CoglPangoGlyphCache *cache);
+
+/* Draws the glyph with @func into memory owned by the cache without
+   touching any Cogl state so that it can be called from any thread.
+   Nothing happens if the glyph is already cached. The next time the
+   glyph is looked up with create set to TRUE on the context's thread
+   it is given space in an atlas and the drawn image is uploaded
+   instead of drawing it again. */
+void
+_cogl_pango_glyph_cache_prerender (CoglPangoGlyphCache *cache,
+                                   PangoFont *font,
+                                   PangoGlyph glyph,
+                                   CoglPangoGlyphCacheDirtyFunc func);
+
 COGL_END_DECLS
 
 #endif /* __COGL_PANGO_GLYPH_CACHE_H__ */
@@ -35,6 +35,7 @@
 
 #include <glib.h>
 #include "cogl-pango-pipeline-cache.h"
+#include "cogl-pango-distance-field.h"
 
 #include "cogl/cogl-context-private.h"
 #include "cogl/cogl-texture-private.h"
@@ -74,7 +75,8 @@ _cogl_pango_pipeline_cache_value_destroy (void *data)
 
 CoglPangoPipelineCache *
 _cogl_pango_pipeline_cache_new (CoglContext *ctx,
-                                CoglBool use_mipmapping)
+                                CoglBool use_mipmapping,
+                                CoglBool use_distance_field)
 {
   CoglPangoPipelineCache *cache = g_new (CoglPangoPipelineCache, 1);
 
@@ -91,8 +93,12 @@ _cogl_pango_pipeline_cache_new (CoglContext *ctx,
 
   cache->base_texture_rgba_pipeline = NULL;
   cache->base_texture_alpha_pipeline = NULL;
+  cache->base_texture_distance_field_pipeline = NULL;
+
+  cache->distance_field_width_location = -1;
 
   cache->use_mipmapping = use_mipmapping;
+  cache->use_distance_field = use_distance_field;
 
   return cache;
 }
@@ -152,6 +158,44 @@ get_base_texture_alpha_pipeline (CoglPangoPipelineCache *cache)
   return cache->base_texture_alpha_pipeline;
 }
 
+static CoglPipeline *
+get_base_texture_distance_field_pipeline (CoglPangoPipelineCache *cache)
+{
+  if (cache->base_texture_distance_field_pipeline == NULL)
+    {
+      CoglPipeline *pipeline;
+      CoglSnippet *snippet;
+
+      pipeline = cogl_pipeline_copy (get_base_texture_alpha_pipeline (cache));
+      cache->base_texture_distance_field_pipeline = pipeline;
+
+      /* The texture contains a distance field where 0.5 is the edge
+       * of the glyph. This converts it back to a coverage value that
+       * ramps up over one pixel so that the alpha combine mode above
+       * can use it. The display list updates the width of the ramp
+       * according to the size the glyphs are drawn at */
+      snippet =
+        cogl_snippet_new (COGL_SNIPPET_HOOK_TEXTURE_LOOKUP,
+                          "uniform float cogl_pango_distance_field_width;",
+                          "cogl_texel.a = "
+                          "clamp ((cogl_texel.a - 0.5) / "
+                          "cogl_pango_distance_field_width + 0.5, "
+                          "0.0, 1.0);");
+      cogl_pipeline_add_layer_snippet (pipeline, 0, snippet);
+      cogl_object_unref (snippet);
+
+      cache->distance_field_width_location =
+        cogl_pipeline_get_uniform_location (pipeline,
+                                            "cogl_pango_distance_field_width");
+      cogl_pipeline_set_uniform_1f (pipeline,
+                                    cache->distance_field_width_location,
+                                    1.0f /
+                                    (2.0f * COGL_PANGO_DISTANCE_FIELD_SPREAD));
+    }
+
+  return cache->base_texture_distance_field_pipeline;
+}
+
 typedef struct
 {
   CoglPangoPipelineCache *cache;
@@ -190,7 +234,10 @@ _cogl_pango_pipeline_cache_get (CoglPangoPipelineCache *cache,
 
       entry->texture = cogl_object_ref (texture);
 
-      if (_cogl_texture_get_format (entry->texture) == COGL_PIXEL_FORMAT_A_8)
+      if (cache->use_distance_field)
+        base = get_base_texture_distance_field_pipeline (cache);
+      else if (_cogl_texture_get_format (entry->texture) ==
+               COGL_PIXEL_FORMAT_A_8)
         base = get_base_texture_alpha_pipeline (cache);
       else
         base = get_base_texture_rgba_pipeline (cache);
@@ -231,6 +278,8 @@ _cogl_pango_pipeline_cache_free (CoglPangoPipelineCache *cache)
     cogl_object_unref (cache->base_texture_rgba_pipeline);
   if (cache->base_texture_alpha_pipeline)
     cogl_object_unref (cache->base_texture_alpha_pipeline);
+  if (cache->base_texture_distance_field_pipeline)
+    cogl_object_unref (cache->base_texture_distance_field_pipeline);
 
   g_hash_table_destroy (cache->hash_table);
 
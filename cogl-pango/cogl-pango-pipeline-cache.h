@@ -48,14 +48,22 @@ typedef struct _CoglPangoPipelineCache
 
   CoglPipeline *base_texture_alpha_pipeline;
   CoglPipeline *base_texture_rgba_pipeline;
+  CoglPipeline *base_texture_distance_field_pipeline;
+
+  /* Location of the uniform that the display list sets to the change
+     in the distance field value across one pixel. Only valid if
+     use_distance_field is TRUE */
+  int distance_field_width_location;
 
   CoglBool use_mipmapping;
+  CoglBool use_distance_field;
 } CoglPangoPipelineCache;
 
 
 CoglPangoPipelineCache *
 _cogl_pango_pipeline_cache_new (CoglContext *ctx,
-                                CoglBool use_mipmapping);
+                                CoglBool use_mipmapping,
+                                CoglBool use_distance_field);
 
 /* Returns a pipeline that can be used to render glyphs in the given
    texture. The pipeline has a new reference so it is up to the caller
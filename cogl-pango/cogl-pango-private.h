@@ -66,6 +66,23 @@ _cogl_pango_renderer_set_use_mipmapping (CoglPangoRenderer *renderer,
 CoglBool
 _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer);
 
+void
+_cogl_pango_renderer_set_use_worker_threads (CoglPangoRenderer *renderer,
+                                             CoglBool value);
+CoglBool
+_cogl_pango_renderer_get_use_worker_threads (CoglPangoRenderer *renderer);
+
+void
+_cogl_pango_renderer_begin_batch (CoglPangoRenderer *renderer);
+void
+_cogl_pango_renderer_end_batch (CoglPangoRenderer *renderer);
+
+void
+_cogl_pango_renderer_set_use_distance_field (CoglPangoRenderer *renderer,
+                                             CoglBool value);
+CoglBool
+_cogl_pango_renderer_get_use_distance_field (CoglPangoRenderer *renderer);
+
 
 
 CoglContext *
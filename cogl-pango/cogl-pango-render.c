@@ -52,6 +52,13 @@
 #include "cogl-pango-private.h"
 #include "cogl-pango-glyph-cache.h"
 #include "cogl-pango-display-list.h"
+#include "cogl-pango-distance-field.h"
+
+/* Distance field glyphs are stored at one of these pixel sizes. Each
+   size is used for fonts up to twice as big. The next size up is four
+   times bigger so it covers fonts from half its size */
+#define COGL_PANGO_DISTANCE_FIELD_MIN_REFERENCE_SIZE 32.0f
+#define COGL_PANGO_DISTANCE_FIELD_MAX_REFERENCE_SIZE 512.0f
 
 enum
 {
@@ -65,6 +72,8 @@ typedef struct
 {
   CoglPangoGlyphCache *glyph_cache;
   CoglPangoPipelineCache *pipeline_cache;
+  /* Function used to draw the glyphs of the glyph cache */
+  CoglPangoGlyphCacheDirtyFunc dirty_func;
 } CoglPangoRendererCaches;
 
 struct _CoglPangoRenderer
@@ -73,15 +82,39 @@ struct _CoglPangoRenderer
 
   CoglContext *ctx;
 
+  /* The thread that the renderer was created on. This is assumed to
+     be the thread that uses the CoglContext */
+  GThread *context_thread;
+
   /* Two caches of glyphs as textures and their corresponding pipeline
      caches, one with mipmapped textures and one without */
   CoglPangoRendererCaches no_mipmap_caches;
   CoglPangoRendererCaches mipmap_caches;
+  /* Caches of glyphs stored as distance fields at a reference size so
+     that each glyph can be used for a range of sizes */
+  CoglPangoRendererCaches distance_field_caches;
 
   CoglBool use_mipmapping;
+  CoglBool use_distance_field;
+
+  /* Maps each PangoFont to the CoglPangoDistanceFieldFont that its
+     glyphs are drawn with in distance field mode */
+  GHashTable *distance_field_fonts;
+  /* Context used to load the reference fonts. Hinting is disabled for
+     it because the glyphs will be scaled */
+  PangoContext *distance_field_context;
+  /* Guards the two members above because the glyph cache can also be
+     filled in from other threads */
+  GMutex distance_field_mutex;
 
   /* The current display list that is being built */
   CoglPangoDisplayList *display_list;
+
+  /* Collects the display lists of all the layouts that are shown
+     between cogl_pango_font_map_begin_batch() and
+     cogl_pango_font_map_end_batch() */
+  CoglPangoTextBatch *text_batch;
+  CoglBool batching;
 };
 
 struct _CoglPangoRendererClass
@@ -89,6 +122,15 @@ struct _CoglPangoRendererClass
   PangoRendererClass class_instance;
 };
 
+typedef struct
+{
+  /* The same font at the reference size or NULL if it couldn't be
+     loaded */
+  PangoFont *font;
+  /* The size of the original font relative to the reference size */
+  float scale;
+} CoglPangoDistanceFieldFont;
+
 typedef struct _CoglPangoLayoutQdata CoglPangoLayoutQdata;
 
 /* An instance of this struct gets attached to each PangoLayout to
@@ -101,15 +143,36 @@ struct _CoglPangoLayoutQdata
   /* A reference to the first line of the layout. This is just used to
      detect changes */
   PangoLayoutLine *first_line;
-  /* Whether mipmapping was previously used to render this layout. We
-     need to regenerate the display list if the mipmapping value is
-     changed because it will be using a different set of textures */
-  CoglBool mipmapping_used;
+  /* The caches that were previously used to render this layout. We
+     need to regenerate the display list if the mipmapping or distance
+     field mode is changed because it will be using a different set of
+     textures */
+  CoglPangoRendererCaches *caches_used;
 };
 
 static void
 _cogl_pango_ensure_glyph_cache_for_layout_line (PangoLayoutLine *line);
 
+static void
+cogl_pango_distance_field_font_free (CoglPangoDistanceFieldFont *df_font);
+
+static void
+cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
+                                     PangoGlyph glyph,
+                                     CoglPangoGlyphCacheValue *value,
+                                     uint8_t *data,
+                                     int rowstride,
+                                     CoglPixelFormat format);
+
+static void
+cogl_pango_renderer_set_dirty_distance_field_glyph
+                                   (PangoFont *font,
+                                    PangoGlyph glyph,
+                                    CoglPangoGlyphCacheValue *value,
+                                    uint8_t *data,
+                                    int rowstride,
+                                    CoglPixelFormat format);
+
 typedef struct
 {
   CoglPangoDisplayList *display_list;
@@ -151,7 +214,8 @@ static void
 cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
                                 CoglPangoGlyphCacheValue *cache_value,
                                 float                     x1,
-                                float                     y1)
+                                float                     y1,
+                                float                     scale)
 {
   CoglPangoRendererSliceCbData data;
 
@@ -160,8 +224,8 @@ cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
   data.display_list = priv->display_list;
   data.x1 = x1;
   data.y1 = y1;
-  data.x2 = x1 + (float) cache_value->draw_width;
-  data.y2 = y1 + (float) cache_value->draw_height;
+  data.x2 = x1 + (float) cache_value->draw_width * scale;
+  data.y2 = y1 + (float) cache_value->draw_height * scale;
 
   /* We iterate the internal sub textures of the texture so that we
      can get a pointer to the base texture even if the texture is in
@@ -216,14 +280,35 @@ _cogl_pango_renderer_constructed (GObject *gobject)
   CoglContext *ctx = renderer->ctx;
 
   renderer->no_mipmap_caches.pipeline_cache =
-    _cogl_pango_pipeline_cache_new (ctx, FALSE);
+    _cogl_pango_pipeline_cache_new (ctx, FALSE, FALSE);
   renderer->mipmap_caches.pipeline_cache =
-    _cogl_pango_pipeline_cache_new (ctx, TRUE);
+    _cogl_pango_pipeline_cache_new (ctx, TRUE, FALSE);
+  renderer->distance_field_caches.pipeline_cache =
+    _cogl_pango_pipeline_cache_new (ctx, FALSE, TRUE);
 
   renderer->no_mipmap_caches.glyph_cache =
-    cogl_pango_glyph_cache_new (ctx, FALSE);
+    cogl_pango_glyph_cache_new (ctx, FALSE, FALSE);
   renderer->mipmap_caches.glyph_cache =
-    cogl_pango_glyph_cache_new (ctx, TRUE);
+    cogl_pango_glyph_cache_new (ctx, TRUE, FALSE);
+  renderer->distance_field_caches.glyph_cache =
+    cogl_pango_glyph_cache_new (ctx, FALSE, TRUE);
+
+  renderer->no_mipmap_caches.dirty_func = cogl_pango_renderer_set_dirty_glyph;
+  renderer->mipmap_caches.dirty_func = cogl_pango_renderer_set_dirty_glyph;
+  renderer->distance_field_caches.dirty_func =
+    cogl_pango_renderer_set_dirty_distance_field_glyph;
+
+  renderer->context_thread = g_thread_self ();
+
+  g_mutex_init (&renderer->distance_field_mutex);
+  renderer->distance_field_fonts =
+    g_hash_table_new_full (g_direct_hash,
+                           g_direct_equal,
+                           g_object_unref,
+                           (UDestroyNotify)
+                           cogl_pango_distance_field_font_free);
+
+  renderer->text_batch = _cogl_pango_text_batch_new (ctx);
 
   _cogl_pango_renderer_set_use_mipmapping (renderer, FALSE);
 
@@ -292,13 +377,34 @@ cogl_pango_renderer_finalize (GObject *object)
 
   cogl_pango_glyph_cache_free (priv->no_mipmap_caches.glyph_cache);
   cogl_pango_glyph_cache_free (priv->mipmap_caches.glyph_cache);
+  cogl_pango_glyph_cache_free (priv->distance_field_caches.glyph_cache);
 
   _cogl_pango_pipeline_cache_free (priv->no_mipmap_caches.pipeline_cache);
   _cogl_pango_pipeline_cache_free (priv->mipmap_caches.pipeline_cache);
+  _cogl_pango_pipeline_cache_free
+    (priv->distance_field_caches.pipeline_cache);
+
+  _cogl_pango_text_batch_free (priv->text_batch);
+
+  g_hash_table_destroy (priv->distance_field_fonts);
+  if (priv->distance_field_context)
+    g_object_unref (priv->distance_field_context);
+  g_mutex_clear (&priv->distance_field_mutex);
 
   G_OBJECT_CLASS (_cogl_pango_renderer_parent_class)->finalize (object);
 }
 
+static CoglPangoRendererCaches *
+cogl_pango_renderer_get_caches (CoglPangoRenderer *priv)
+{
+  if (priv->use_distance_field)
+    return &priv->distance_field_caches;
+  else if (priv->use_mipmapping)
+    return &priv->mipmap_caches;
+  else
+    return &priv->no_mipmap_caches;
+}
+
 static CoglPangoRenderer *
 cogl_pango_get_renderer_from_context (PangoContext *context)
 {
@@ -334,12 +440,8 @@ cogl_pango_layout_qdata_forget_display_list (CoglPangoLayoutQdata *qdata)
 {
   if (qdata->display_list)
     {
-      CoglPangoRendererCaches *caches = qdata->mipmapping_used ?
-        &qdata->renderer->mipmap_caches :
-        &qdata->renderer->no_mipmap_caches;
-
       _cogl_pango_glyph_cache_remove_reorganize_callback
-        (caches->glyph_cache,
+        (qdata->caches_used->glyph_cache,
          (GHookFunc) cogl_pango_layout_qdata_forget_display_list,
          qdata);
 
@@ -394,14 +496,12 @@ cogl_pango_show_layout (CoglFramebuffer *fb,
   if (qdata->display_list &&
       ((qdata->first_line &&
         qdata->first_line->layout != layout) ||
-       qdata->mipmapping_used != priv->use_mipmapping))
+       qdata->caches_used != cogl_pango_renderer_get_caches (priv)))
     cogl_pango_layout_qdata_forget_display_list (qdata);
 
   if (qdata->display_list == NULL)
     {
-      CoglPangoRendererCaches *caches = priv->use_mipmapping ?
-        &priv->mipmap_caches :
-        &priv->no_mipmap_caches;
+      CoglPangoRendererCaches *caches = cogl_pango_renderer_get_caches (priv);
 
       cogl_pango_ensure_glyph_cache_for_layout (layout);
 
@@ -419,15 +519,21 @@ cogl_pango_show_layout (CoglFramebuffer *fb,
       pango_renderer_draw_layout (PANGO_RENDERER (priv), layout, 0, 0);
       priv->display_list = NULL;
 
-      qdata->mipmapping_used = priv->use_mipmapping;
+      qdata->caches_used = caches;
     }
 
   cogl_framebuffer_push_matrix (fb);
   cogl_framebuffer_translate (fb, x, y, 0);
 
-  _cogl_pango_display_list_render (fb,
-                                   qdata->display_list,
-                                   color);
+  if (priv->batching)
+    _cogl_pango_display_list_add_to_batch (fb,
+                                           qdata->display_list,
+                                           color,
+                                           priv->text_batch);
+  else
+    _cogl_pango_display_list_render (fb,
+                                     qdata->display_list,
+                                     color);
 
   cogl_framebuffer_pop_matrix (fb);
 
@@ -463,9 +569,7 @@ cogl_pango_show_layout_line (CoglFramebuffer *fb,
   if (G_UNLIKELY (!priv))
     return;
 
-  caches = (priv->use_mipmapping ?
-            &priv->mipmap_caches :
-            &priv->no_mipmap_caches);
+  caches = cogl_pango_renderer_get_caches (priv);
 
   priv->display_list = _cogl_pango_display_list_new (caches->pipeline_cache);
 
@@ -474,9 +578,15 @@ cogl_pango_show_layout_line (CoglFramebuffer *fb,
   pango_renderer_draw_layout_line (PANGO_RENDERER (priv), line,
                                    pango_x, pango_y);
 
-  _cogl_pango_display_list_render (fb,
-                                   priv->display_list,
-                                   color);
+  if (priv->batching)
+    _cogl_pango_display_list_add_to_batch (fb,
+                                           priv->display_list,
+                                           color,
+                                           priv->text_batch);
+  else
+    _cogl_pango_display_list_render (fb,
+                                     priv->display_list,
+                                     color);
 
   _cogl_pango_display_list_free (priv->display_list);
   priv->display_list = NULL;
@@ -487,6 +597,11 @@ _cogl_pango_renderer_clear_glyph_cache (CoglPangoRenderer *renderer)
 {
   cogl_pango_glyph_cache_clear (renderer->mipmap_caches.glyph_cache);
   cogl_pango_glyph_cache_clear (renderer->no_mipmap_caches.glyph_cache);
+  cogl_pango_glyph_cache_clear (renderer->distance_field_caches.glyph_cache);
+
+  g_mutex_lock (&renderer->distance_field_mutex);
+  g_hash_table_remove_all (renderer->distance_field_fonts);
+  g_mutex_unlock (&renderer->distance_field_mutex);
 }
 
 void
@@ -502,16 +617,168 @@ _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer)
   return renderer->use_mipmapping;
 }
 
+void
+_cogl_pango_renderer_begin_batch (CoglPangoRenderer *renderer)
+{
+  renderer->batching = TRUE;
+}
+
+void
+_cogl_pango_renderer_end_batch (CoglPangoRenderer *renderer)
+{
+  _cogl_pango_text_batch_end (renderer->text_batch);
+  renderer->batching = FALSE;
+}
+
+void
+_cogl_pango_renderer_set_use_distance_field (CoglPangoRenderer *renderer,
+                                             CoglBool value)
+{
+  renderer->use_distance_field = value;
+}
+
+CoglBool
+_cogl_pango_renderer_get_use_distance_field (CoglPangoRenderer *renderer)
+{
+  return renderer->use_distance_field;
+}
+
+void
+_cogl_pango_renderer_set_use_worker_threads (CoglPangoRenderer *renderer,
+                                             CoglBool value)
+{
+  _cogl_pango_glyph_cache_set_use_worker_threads
+    (renderer->no_mipmap_caches.glyph_cache, value);
+  _cogl_pango_glyph_cache_set_use_worker_threads
+    (renderer->mipmap_caches.glyph_cache, value);
+  _cogl_pango_glyph_cache_set_use_worker_threads
+    (renderer->distance_field_caches.glyph_cache, value);
+}
+
+CoglBool
+_cogl_pango_renderer_get_use_worker_threads (CoglPangoRenderer *renderer)
+{
+  return _cogl_pango_glyph_cache_get_use_worker_threads
+    (renderer->no_mipmap_caches.glyph_cache);
+}
+
+static void
+cogl_pango_distance_field_font_free (CoglPangoDistanceFieldFont *df_font)
+{
+  if (df_font->font)
+    g_object_unref (df_font->font);
+  g_slice_free (CoglPangoDistanceFieldFont, df_font);
+}
+
+static float
+get_distance_field_reference_size (float size)
+{
+  float reference_size = COGL_PANGO_DISTANCE_FIELD_MIN_REFERENCE_SIZE;
+
+  while (size > reference_size * 2.0f &&
+         reference_size < COGL_PANGO_DISTANCE_FIELD_MAX_REFERENCE_SIZE)
+    reference_size *= 4.0f;
+
+  return reference_size;
+}
+
+/* The distance field fonts can also be looked up from a thread
+   pre-warming the glyph cache so this must be called with
+   distance_field_mutex held */
+static CoglPangoDistanceFieldFont *
+cogl_pango_renderer_get_distance_field_font_locked (CoglPangoRenderer *priv,
+                                                    PangoFont *font)
+{
+  CoglPangoDistanceFieldFont *df_font;
+  PangoFontMap *font_map;
+  PangoFontDescription *desc;
+  float size, reference_size;
+
+  df_font = g_hash_table_lookup (priv->distance_field_fonts, font);
+  if (df_font)
+    return df_font;
+
+  font_map = pango_font_get_font_map (font);
+
+  if (priv->distance_field_context == NULL)
+    {
+      cairo_font_options_t *options = cairo_font_options_create ();
+
+      priv->distance_field_context = pango_font_map_create_context (font_map);
+
+      /* Hinting would distort the glyphs for all of the other sizes
+         that they are used for */
+      cairo_font_options_set_hint_style (options, CAIRO_HINT_STYLE_NONE);
+      cairo_font_options_set_hint_metrics (options, CAIRO_HINT_METRICS_OFF);
+      cairo_font_options_set_antialias (options, CAIRO_ANTIALIAS_GRAY);
+      pango_cairo_context_set_font_options (priv->distance_field_context,
+                                            options);
+      cairo_font_options_destroy (options);
+    }
+
+  desc = pango_font_describe_with_absolute_size (font);
+  size = pango_font_description_get_size (desc) / (float) PANGO_SCALE;
+  reference_size = get_distance_field_reference_size (size);
+  pango_font_description_set_absolute_size (desc,
+                                            reference_size * PANGO_SCALE);
+
+  df_font = g_slice_new (CoglPangoDistanceFieldFont);
+  df_font->font = pango_font_map_load_font (font_map,
+                                            priv->distance_field_context,
+                                            desc);
+  df_font->scale = size / reference_size;
+
+  pango_font_description_free (desc);
+
+  g_hash_table_insert (priv->distance_field_fonts,
+                       g_object_ref (font),
+                       df_font);
+
+  return df_font;
+}
+
+static CoglPangoDistanceFieldFont *
+cogl_pango_renderer_get_distance_field_font (CoglPangoRenderer *priv,
+                                             PangoFont *font)
+{
+  CoglPangoDistanceFieldFont *df_font;
+
+  /* The entries are only ever removed from the context's thread so
+     the returned font stays valid without holding the lock */
+  g_mutex_lock (&priv->distance_field_mutex);
+  df_font = cogl_pango_renderer_get_distance_field_font_locked (priv, font);
+  g_mutex_unlock (&priv->distance_field_mutex);
+
+  return df_font;
+}
+
+/* Looks up the glyph in the cache for the current mode. In distance
+   field mode the glyph comes from a font of a different size so
+   @scale is set to the size the glyph should be drawn at relative to
+   the size of the cached image */
 static CoglPangoGlyphCacheValue *
 cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                       CoglBool       create,
                                       PangoFont     *font,
-                                      PangoGlyph     glyph)
+                                      PangoGlyph     glyph,
+                                      float         *scale)
 {
   CoglPangoRenderer *priv = COGL_PANGO_RENDERER (renderer);
-  CoglPangoRendererCaches *caches = (priv->use_mipmapping ?
-                                     &priv->mipmap_caches :
-                                     &priv->no_mipmap_caches);
+  CoglPangoRendererCaches *caches = cogl_pango_renderer_get_caches (priv);
+
+  if (priv->use_distance_field)
+    {
+      CoglPangoDistanceFieldFont *df_font =
+        cogl_pango_renderer_get_distance_field_font (priv, font);
+
+      if (df_font->font == NULL)
+        return NULL;
+
+      font = df_font->font;
+      *scale = df_font->scale;
+    }
+  else
+    *scale = 1.0f;
 
   return cogl_pango_glyph_cache_lookup (caches->glyph_cache,
                                         create, font, glyph);
@@ -520,45 +787,45 @@ cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
 static void
 cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
                                      PangoGlyph glyph,
-                                     CoglPangoGlyphCacheValue *value)
+                                     CoglPangoGlyphCacheValue *value,
+                                     uint8_t *data,
+                                     int rowstride,
+                                     CoglPixelFormat format)
 {
   cairo_surface_t *surface;
   cairo_t *cr;
   cairo_scaled_font_t *scaled_font;
   cairo_glyph_t cairo_glyph;
   cairo_format_t format_cairo;
-  CoglPixelFormat format_cogl;
+
+  /* NB: This may be called from one of the context's worker threads
+     or from a thread pre-warming the glyph cache so it must not touch
+     the renderer or any Cogl state. The font's scaled font is already
+     created when the glyph extents are queried so getting it here
+     doesn't modify the font. Cairo does its own locking for the
+     scaled font's glyph cache */
 
   COGL_NOTE (PANGO, "redrawing glyph %i", glyph);
 
-  /* Glyphs that don't take up any space will end up without a
-     texture. These should never become dirty so they shouldn't end up
-     here */
-  _COGL_RETURN_IF_FAIL (value->texture != NULL);
+  /* Glyphs that don't take up any space will never be drawn so they
+     shouldn't end up here. The glyph might not have a texture yet if
+     it is being pre-rendered so that can't be checked instead */
+  _COGL_RETURN_IF_FAIL (value->draw_width > 0 && value->draw_height > 0);
 
-  if (_cogl_texture_get_format (value->texture) == COGL_PIXEL_FORMAT_A_8)
-    {
-      format_cairo = CAIRO_FORMAT_A8;
-      format_cogl = COGL_PIXEL_FORMAT_A_8;
-    }
+  /* The glyph cache gives us either an alpha-only buffer or one with
+     Cairo's native-endian ARGB layout */
+  if (format == COGL_PIXEL_FORMAT_A_8)
+    format_cairo = CAIRO_FORMAT_A8;
   else
-    {
-      format_cairo = CAIRO_FORMAT_ARGB32;
-
-      /* Cairo stores the data in native byte order as ARGB but Cogl's
-         pixel formats specify the actual byte order. Therefore we
-         need to use a different format depending on the
-         architecture */
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-      format_cogl = COGL_PIXEL_FORMAT_BGRA_8888_PRE;
-#else
-      format_cogl = COGL_PIXEL_FORMAT_ARGB_8888_PRE;
-#endif
-    }
-
-  surface = cairo_image_surface_create (format_cairo,
-                                        value->draw_width,
-                                        value->draw_height);
+    format_cairo = CAIRO_FORMAT_ARGB32;
+
+  /* This just wraps the glyph cache's buffer so it doesn't allocate
+     any pixels */
+  surface = cairo_image_surface_create_for_data (data,
+                                                 format_cairo,
+                                                 value->draw_width,
+                                                 value->draw_height,
+                                                 rowstride);
   cr = cairo_create (surface);
 
   scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
@@ -575,22 +842,32 @@ cogl_pango_renderer_set_dirty_glyph (PangoFont *font,
 
   cairo_destroy (cr);
   cairo_surface_flush (surface);
-
-  /* Copy the glyph to the texture */
-  cogl_texture_set_region (value->texture,
-                           value->draw_width,
-                           value->draw_height,
-                           format_cogl,
-                           cairo_image_surface_get_stride (surface),
-                           cairo_image_surface_get_data (surface),
-                           value->tx_pixel, /* dst_x */
-                           value->ty_pixel, /* dst_y */
-                           0, /* level */
-                           NULL); /* don't catch errors */
-
   cairo_surface_destroy (surface);
 }
 
+static void
+cogl_pango_renderer_set_dirty_distance_field_glyph
+                                   (PangoFont *font,
+                                    PangoGlyph glyph,
+                                    CoglPangoGlyphCacheValue *value,
+                                    uint8_t *data,
+                                    int rowstride,
+                                    CoglPixelFormat format)
+{
+  /* Distance field caches are always alpha-only. The glyph is drawn
+     normally first and the coverage is then converted in place. The
+     glyph cache has already padded the glyph by the spread so the
+     field has room to fall off around the outline */
+  cogl_pango_renderer_set_dirty_glyph (font, glyph, value,
+                                       data, rowstride, format);
+
+  _cogl_pango_distance_field_from_coverage (data,
+                                            value->draw_width,
+                                            value->draw_height,
+                                            rowstride,
+                                            COGL_PANGO_DISTANCE_FIELD_SPREAD);
+}
+
 static void
 _cogl_pango_ensure_glyph_cache_for_layout_line_internal (PangoLayoutLine *line)
 {
@@ -611,6 +888,7 @@ _cogl_pango_ensure_glyph_cache_for_layout_line_internal (PangoLayoutLine *line)
       for (i = 0; i < glyphs->num_glyphs; i++)
         {
           PangoGlyphInfo *gi = &glyphs->glyphs[i];
+          float scale;
 
           /* If the glyph isn't cached then this will reserve
              space for it now. We won't actually draw the glyph
@@ -620,8 +898,53 @@ _cogl_pango_ensure_glyph_cache_for_layout_line_internal (PangoLayoutLine *line)
              settled */
           cogl_pango_renderer_get_cached_glyph (renderer, TRUE,
                                                 run->item->analysis.font,
-                                                gi->glyph);
+                                                gi->glyph,
+                                                &scale);
+        }
+    }
+}
+
+static void
+_cogl_pango_prerender_glyphs_for_layout_line (CoglPangoRenderer *priv,
+                                              CoglPangoRendererCaches *caches,
+                                              PangoLayoutLine *line)
+{
+  GSList *l;
+
+  for (l = line->runs; l; l = l->next)
+    {
+      PangoLayoutRun *run = l->data;
+      PangoGlyphString *glyphs = run->glyphs;
+      PangoFont *font;
+      int i;
+
+      if (priv->use_distance_field)
+        {
+          CoglPangoDistanceFieldFont *df_font;
+
+          /* The context's thread may clear the distance field fonts
+             at any time so a reference is kept for as long as the
+             font is used here */
+          g_mutex_lock (&priv->distance_field_mutex);
+          df_font =
+            cogl_pango_renderer_get_distance_field_font_locked
+            (priv, run->item->analysis.font);
+          font = df_font->font ? g_object_ref (df_font->font) : NULL;
+          g_mutex_unlock (&priv->distance_field_mutex);
+
+          if (font == NULL)
+            continue;
         }
+      else
+        font = g_object_ref (run->item->analysis.font);
+
+      for (i = 0; i < glyphs->num_glyphs; i++)
+        _cogl_pango_glyph_cache_prerender (caches->glyph_cache,
+                                           font,
+                                           glyphs->glyphs[i].glyph,
+                                           caches->dirty_func);
+
+      g_object_unref (font);
     }
 }
 
@@ -629,9 +952,12 @@ static void
 _cogl_pango_set_dirty_glyphs (CoglPangoRenderer *priv)
 {
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->mipmap_caches.glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (priv->mipmap_caches.glyph_cache, priv->mipmap_caches.dirty_func);
   _cogl_pango_glyph_cache_set_dirty_glyphs
-    (priv->no_mipmap_caches.glyph_cache, cogl_pango_renderer_set_dirty_glyph);
+    (priv->no_mipmap_caches.glyph_cache, priv->no_mipmap_caches.dirty_func);
+  _cogl_pango_glyph_cache_set_dirty_glyphs
+    (priv->distance_field_caches.glyph_cache,
+     priv->distance_field_caches.dirty_func);
 }
 
 static void
@@ -665,6 +991,29 @@ cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout)
   if ((iter = pango_layout_get_iter (layout)) == NULL)
     return;
 
+  /* Away from the context's thread the glyphs can only be rasterized
+     into memory owned by the glyph cache. They are given space in an
+     atlas and uploaded the next time the layout is prepared on the
+     context's thread */
+  if (g_thread_self () != priv->context_thread)
+    {
+      CoglPangoRendererCaches *caches = cogl_pango_renderer_get_caches (priv);
+
+      do
+        {
+          PangoLayoutLine *line;
+
+          line = pango_layout_iter_get_line_readonly (iter);
+
+          _cogl_pango_prerender_glyphs_for_layout_line (priv, caches, line);
+        }
+      while (pango_layout_iter_next_line (iter));
+
+      pango_layout_iter_free (iter);
+
+      return;
+    }
+
   do
     {
       PangoLayoutLine *line;
@@ -815,7 +1164,7 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
   for (i = 0; i < glyphs->num_glyphs; i++)
     {
       PangoGlyphInfo *gi = glyphs->glyphs + i;
-      float x, y;
+      float x, y, scale;
 
       cogl_pango_renderer_get_device_units (renderer,
 					    xi + gi->geometry.x_offset,
@@ -853,7 +1202,8 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
             cogl_pango_renderer_get_cached_glyph (renderer,
                                                   FALSE,
                                                   font,
-                                                  gi->glyph);
+                                                  gi->glyph,
+                                                  &scale);
 
           /* cogl_pango_ensure_glyph_cache_for_layout should always be
              called before rendering a layout so we should never have
@@ -870,10 +1220,14 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
             }
 	  else if (cache_value->texture)
 	    {
-	      x += (float)(cache_value->draw_x);
-	      y += (float)(cache_value->draw_y);
+	      x += (float)(cache_value->draw_x) * scale;
+	      y += (float)(cache_value->draw_y) * scale;
+
+              _cogl_pango_display_list_set_distance_field_scale
+                (priv->display_list, scale);
 
-              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y);
+              cogl_pango_renderer_draw_glyph (priv, cache_value,
+                                              x, y, scale);
 	    }
 	}
 
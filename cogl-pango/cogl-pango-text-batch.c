@@ -0,0 +1,557 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+#include <string.h>
+
+#include "cogl-pango-text-batch.h"
+#include "cogl/cogl-clip-stack.h"
+#include "cogl/cogl-context-private.h"
+
+/* The batch is drawn with the rectangle indices which are 16-bit so
+   this is the most quads we can draw from one buffer */
+#define COGL_PANGO_TEXT_BATCH_MAX_QUADS (65536 / 4)
+
+typedef struct
+{
+  /* The position is already in clip space */
+  float x, y, z, w;
+  float s, t;
+  uint8_t r, g, b, a;
+} CoglPangoTextBatchVertex;
+
+typedef struct
+{
+  CoglPipeline *pipeline;
+  int distance_field_width_location;
+  float distance_field_width;
+  /* Array of CoglPangoTextBatchVertex. This isn't freed when the
+     group is emptied so that it can be reused */
+  GArray *vertices;
+} CoglPangoTextBatchGroup;
+
+struct _CoglPangoTextBatch
+{
+  CoglContext *ctx;
+
+  /* The state that the quads in the batch will be drawn with. The
+     framebuffer is NULL if nothing has been added since the batch was
+     ended */
+  CoglFramebuffer *framebuffer;
+  CoglClipStack *clip_stack;
+  float viewport[4];
+
+  /* The projection and modelview of the framebuffer combined at the
+     last call to _cogl_pango_text_batch_set_target() */
+  CoglMatrix transform;
+
+  /* Array of CoglPangoTextBatchGroup. Only the first n_groups are in
+     use */
+  GArray *groups;
+  int n_groups;
+  int last_group;
+  int n_quads;
+};
+
+CoglPangoTextBatch *
+_cogl_pango_text_batch_new (CoglContext *ctx)
+{
+  CoglPangoTextBatch *batch = g_slice_new0 (CoglPangoTextBatch);
+
+  batch->ctx = ctx;
+  batch->groups = g_array_new (FALSE, TRUE, sizeof (CoglPangoTextBatchGroup));
+
+  return batch;
+}
+
+static void
+set_target_state (CoglPangoTextBatch *batch,
+                  CoglFramebuffer *framebuffer)
+{
+  CoglClipStack *clip_stack = _cogl_framebuffer_get_clip_stack (framebuffer);
+
+  if (batch->framebuffer != framebuffer)
+    {
+      cogl_object_ref (framebuffer);
+      if (batch->framebuffer)
+        cogl_object_unref (batch->framebuffer);
+      batch->framebuffer = framebuffer;
+    }
+
+  if (batch->clip_stack != clip_stack)
+    {
+      _cogl_clip_stack_ref (clip_stack);
+      _cogl_clip_stack_unref (batch->clip_stack);
+      batch->clip_stack = clip_stack;
+    }
+
+  cogl_framebuffer_get_viewport4fv (framebuffer, batch->viewport);
+}
+
+void
+_cogl_pango_text_batch_set_target (CoglPangoTextBatch *batch,
+                                   CoglFramebuffer *framebuffer)
+{
+  CoglMatrix projection, modelview;
+
+  if (batch->framebuffer != framebuffer ||
+      batch->clip_stack != _cogl_framebuffer_get_clip_stack (framebuffer))
+    {
+      _cogl_pango_text_batch_flush (batch);
+      set_target_state (batch, framebuffer);
+    }
+  else
+    {
+      float viewport[4];
+
+      cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
+
+      if (memcmp (viewport, batch->viewport, sizeof (viewport)))
+        {
+          _cogl_pango_text_batch_flush (batch);
+          set_target_state (batch, framebuffer);
+        }
+    }
+
+  cogl_framebuffer_get_projection_matrix (framebuffer, &projection);
+  cogl_framebuffer_get_modelview_matrix (framebuffer, &modelview);
+  cogl_matrix_multiply (&batch->transform, &projection, &modelview);
+}
+
+static CoglPangoTextBatchGroup *
+get_group (CoglPangoTextBatch *batch,
+           CoglPipeline *pipeline,
+           int distance_field_width_location,
+           float distance_field_width)
+{
+  CoglPangoTextBatchGroup *group;
+  int i;
+
+  /* Consecutive quads nearly always use the same group */
+  if (batch->last_group < batch->n_groups)
+    {
+      group = &g_array_index (batch->groups,
+                              CoglPangoTextBatchGroup,
+                              batch->last_group);
+      if (group->pipeline == pipeline &&
+          group->distance_field_width_location ==
+          distance_field_width_location &&
+          group->distance_field_width == distance_field_width)
+        return group;
+    }
+
+  for (i = 0; i < batch->n_groups; i++)
+    {
+      group = &g_array_index (batch->groups, CoglPangoTextBatchGroup, i);
+
+      if (group->pipeline == pipeline &&
+          group->distance_field_width_location ==
+          distance_field_width_location &&
+          group->distance_field_width == distance_field_width)
+        {
+          batch->last_group = i;
+          return group;
+        }
+    }
+
+  if (batch->n_groups >= batch->groups->len)
+    g_array_set_size (batch->groups, batch->n_groups + 1);
+
+  group = &g_array_index (batch->groups,
+                          CoglPangoTextBatchGroup,
+                          batch->n_groups);
+
+  group->pipeline = cogl_object_ref (pipeline);
+  group->distance_field_width_location = distance_field_width_location;
+  group->distance_field_width = distance_field_width;
+  if (group->vertices == NULL)
+    group->vertices = g_array_new (FALSE, FALSE,
+                                   sizeof (CoglPangoTextBatchVertex));
+
+  batch->last_group = batch->n_groups++;
+
+  return group;
+}
+
+static CoglPangoTextBatchVertex *
+add_vertices (CoglPangoTextBatchGroup *group,
+              const CoglColor *color,
+              int n_vertices)
+{
+  CoglPangoTextBatchVertex *v;
+  int first = group->vertices->len;
+  int i;
+
+  g_array_set_size (group->vertices, first + n_vertices);
+  v = &g_array_index (group->vertices, CoglPangoTextBatchVertex, first);
+
+  for (i = 0; i < n_vertices; i++)
+    {
+      v[i].r = cogl_color_get_red_byte (color);
+      v[i].g = cogl_color_get_green_byte (color);
+      v[i].b = cogl_color_get_blue_byte (color);
+      v[i].a = cogl_color_get_alpha_byte (color);
+    }
+
+  return v;
+}
+
+static void
+project_vertices (CoglPangoTextBatch *batch,
+                  CoglPangoTextBatchVertex *v,
+                  int n_vertices)
+{
+  /* The 2D positions have been written to the start of each vertex
+     so this can work in place */
+  cogl_matrix_project_points (&batch->transform,
+                              2, /* n_components */
+                              sizeof (CoglPangoTextBatchVertex),
+                              &v->x,
+                              sizeof (CoglPangoTextBatchVertex),
+                              &v->x,
+                              n_vertices);
+}
+
+void
+_cogl_pango_text_batch_add_rectangles (CoglPangoTextBatch *batch,
+                                       CoglPipeline *pipeline,
+                                       int distance_field_width_location,
+                                       float distance_field_width,
+                                       const CoglColor *color,
+                                       const float *rectangles,
+                                       int n_rectangles)
+{
+  _COGL_RETURN_IF_FAIL (batch->framebuffer != NULL);
+
+  while (n_rectangles > 0)
+    {
+      CoglPangoTextBatchGroup *group;
+      CoglPangoTextBatchVertex *v;
+      int n_quads, i;
+
+      if (batch->n_quads >= COGL_PANGO_TEXT_BATCH_MAX_QUADS)
+        _cogl_pango_text_batch_flush (batch);
+
+      n_quads = MIN (n_rectangles,
+                     COGL_PANGO_TEXT_BATCH_MAX_QUADS - batch->n_quads);
+
+      group = get_group (batch,
+                         pipeline,
+                         distance_field_width_location,
+                         distance_field_width);
+      v = add_vertices (group, color, n_quads * 4);
+
+      for (i = 0; i < n_quads; i++)
+        {
+          const float *r = rectangles + i * 8;
+
+          v[i * 4 + 0].x = r[0];
+          v[i * 4 + 0].y = r[1];
+          v[i * 4 + 0].s = r[4];
+          v[i * 4 + 0].t = r[5];
+          v[i * 4 + 1].x = r[0];
+          v[i * 4 + 1].y = r[3];
+          v[i * 4 + 1].s = r[4];
+          v[i * 4 + 1].t = r[7];
+          v[i * 4 + 2].x = r[2];
+          v[i * 4 + 2].y = r[3];
+          v[i * 4 + 2].s = r[6];
+          v[i * 4 + 2].t = r[7];
+          v[i * 4 + 3].x = r[2];
+          v[i * 4 + 3].y = r[1];
+          v[i * 4 + 3].s = r[6];
+          v[i * 4 + 3].t = r[5];
+        }
+
+      project_vertices (batch, v, n_quads * 4);
+
+      batch->n_quads += n_quads;
+      rectangles += n_quads * 8;
+      n_rectangles -= n_quads;
+    }
+}
+
+void
+_cogl_pango_text_batch_add_quad (CoglPangoTextBatch *batch,
+                                 CoglPipeline *pipeline,
+                                 const CoglColor *color,
+                                 const CoglVertexP2 *vertices)
+{
+  CoglPangoTextBatchGroup *group;
+  CoglPangoTextBatchVertex *v;
+  int i;
+
+  _COGL_RETURN_IF_FAIL (batch->framebuffer != NULL);
+
+  if (batch->n_quads >= COGL_PANGO_TEXT_BATCH_MAX_QUADS)
+    _cogl_pango_text_batch_flush (batch);
+
+  group = get_group (batch, pipeline, -1, 0.0f);
+  v = add_vertices (group, color, 4);
+
+  for (i = 0; i < 4; i++)
+    {
+      v[i].x = vertices[i].x;
+      v[i].y = vertices[i].y;
+      v[i].s = 0.0f;
+      v[i].t = 0.0f;
+    }
+
+  project_vertices (batch, v, 4);
+
+  batch->n_quads++;
+}
+
+/* Each flush writes the vertices to a region of the context's stream
+   buffer and returns a primitive that draws from it with the shared
+   rectangle indices. The region must be released once the primitive
+   has been drawn */
+static CoglPrimitive *
+upload_vertices (CoglPangoTextBatch *batch)
+{
+  CoglStreamBuffer *stream = batch->ctx->stream_buffer;
+  CoglAttributeBuffer *buffer;
+  CoglAttribute *attributes[3];
+  CoglPrimitive *primitive;
+  size_t offset;
+  uint8_t *data;
+  int i;
+
+  data = _cogl_stream_buffer_map (stream,
+                                  batch->n_quads * 4 *
+                                  sizeof (CoglPangoTextBatchVertex),
+                                  &buffer,
+                                  &offset);
+
+  for (i = 0; i < batch->n_groups; i++)
+    {
+      CoglPangoTextBatchGroup *group =
+        &g_array_index (batch->groups, CoglPangoTextBatchGroup, i);
+      size_t size = group->vertices->len * sizeof (CoglPangoTextBatchVertex);
+
+      memcpy (data, group->vertices->data, size);
+      data += size;
+    }
+
+  _cogl_stream_buffer_unmap (stream);
+
+  attributes[0] = cogl_attribute_new (buffer,
+                                      "cogl_position_in",
+                                      sizeof (CoglPangoTextBatchVertex),
+                                      offset +
+                                      G_STRUCT_OFFSET (CoglPangoTextBatchVertex,
+                                                       x),
+                                      4, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[1] = cogl_attribute_new (buffer,
+                                      "cogl_tex_coord0_in",
+                                      sizeof (CoglPangoTextBatchVertex),
+                                      offset +
+                                      G_STRUCT_OFFSET (CoglPangoTextBatchVertex,
+                                                       s),
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[2] = cogl_attribute_new (buffer,
+                                      "cogl_color_in",
+                                      sizeof (CoglPangoTextBatchVertex),
+                                      offset +
+                                      G_STRUCT_OFFSET (CoglPangoTextBatchVertex,
+                                                       r),
+                                      4, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+
+  primitive =
+    cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                        0, /* n_vertices */
+                                        attributes,
+                                        3 /* n_attributes */);
+
+  for (i = 0; i < 3; i++)
+    cogl_object_unref (attributes[i]);
+
+  return primitive;
+}
+
+static void
+draw_groups (CoglPangoTextBatch *batch,
+             CoglPrimitive *primitive)
+{
+  CoglFramebuffer *fb = batch->framebuffer;
+  CoglClipStack *old_clip_stack = NULL;
+  CoglMatrix old_projection, identity;
+  float old_viewport[4];
+  CoglBool restore_viewport;
+  int first_vertex = 0;
+  int i;
+
+  /* The positions are already in clip space */
+  cogl_matrix_init_identity (&identity);
+  cogl_framebuffer_get_projection_matrix (fb, &old_projection);
+  cogl_framebuffer_set_projection_matrix (fb, &identity);
+  cogl_framebuffer_push_matrix (fb);
+  cogl_framebuffer_identity_matrix (fb);
+
+  /* The application may have changed the state since the last quads
+     were added, for example by popping a clip at the end of the
+     frame, so put back the state that they were added with */
+  if (_cogl_framebuffer_get_clip_stack (fb) != batch->clip_stack)
+    {
+      old_clip_stack =
+        _cogl_clip_stack_ref (_cogl_framebuffer_get_clip_stack (fb));
+      _cogl_framebuffer_set_clip_stack (fb, batch->clip_stack);
+    }
+
+  cogl_framebuffer_get_viewport4fv (fb, old_viewport);
+  restore_viewport = memcmp (old_viewport,
+                             batch->viewport,
+                             sizeof (old_viewport)) != 0;
+  if (restore_viewport)
+    cogl_framebuffer_set_viewport (fb,
+                                   batch->viewport[0],
+                                   batch->viewport[1],
+                                   batch->viewport[2],
+                                   batch->viewport[3]);
+
+  cogl_primitive_set_indices (primitive,
+                              cogl_get_rectangle_indices (batch->ctx,
+                                                          batch->n_quads),
+                              batch->n_quads * 6);
+
+  for (i = 0; i < batch->n_groups; i++)
+    {
+      CoglPangoTextBatchGroup *group =
+        &g_array_index (batch->groups, CoglPangoTextBatchGroup, i);
+      int n_vertices = group->vertices->len / 4 * 6;
+
+      if (group->distance_field_width_location != -1)
+        cogl_pipeline_set_uniform_1f (group->pipeline,
+                                      group->distance_field_width_location,
+                                      group->distance_field_width);
+
+      /* These are indices into the rectangle indices which refer to
+         the quads in the order that they were uploaded */
+      cogl_primitive_set_first_vertex (primitive, first_vertex);
+      cogl_primitive_set_n_vertices (primitive, n_vertices);
+      cogl_primitive_draw (primitive, fb, group->pipeline);
+
+      first_vertex += n_vertices;
+    }
+
+  if (restore_viewport)
+    cogl_framebuffer_set_viewport (fb,
+                                   old_viewport[0],
+                                   old_viewport[1],
+                                   old_viewport[2],
+                                   old_viewport[3]);
+
+  if (old_clip_stack)
+    {
+      _cogl_framebuffer_set_clip_stack (fb, old_clip_stack);
+      _cogl_clip_stack_unref (old_clip_stack);
+    }
+
+  cogl_framebuffer_pop_matrix (fb);
+  cogl_framebuffer_set_projection_matrix (fb, &old_projection);
+}
+
+static void
+clear_groups (CoglPangoTextBatch *batch)
+{
+  int i;
+
+  for (i = 0; i < batch->n_groups; i++)
+    {
+      CoglPangoTextBatchGroup *group =
+        &g_array_index (batch->groups, CoglPangoTextBatchGroup, i);
+
+      cogl_object_unref (group->pipeline);
+      group->pipeline = NULL;
+      g_array_set_size (group->vertices, 0);
+    }
+
+  batch->n_groups = 0;
+  batch->last_group = 0;
+  batch->n_quads = 0;
+}
+
+void
+_cogl_pango_text_batch_flush (CoglPangoTextBatch *batch)
+{
+  CoglPrimitive *primitive;
+
+  if (batch->n_quads == 0)
+    return;
+
+  primitive = upload_vertices (batch);
+  draw_groups (batch, primitive);
+  cogl_object_unref (primitive);
+  _cogl_stream_buffer_release (batch->ctx->stream_buffer);
+
+  clear_groups (batch);
+}
+
+void
+_cogl_pango_text_batch_end (CoglPangoTextBatch *batch)
+{
+  _cogl_pango_text_batch_flush (batch);
+
+  if (batch->framebuffer)
+    {
+      cogl_object_unref (batch->framebuffer);
+      batch->framebuffer = NULL;
+    }
+
+  _cogl_clip_stack_unref (batch->clip_stack);
+  batch->clip_stack = NULL;
+}
+
+void
+_cogl_pango_text_batch_free (CoglPangoTextBatch *batch)
+{
+  int i;
+
+  /* Anything that wasn't flushed is dropped */
+  clear_groups (batch);
+  _cogl_pango_text_batch_end (batch);
+
+  for (i = 0; i < batch->groups->len; i++)
+    {
+      CoglPangoTextBatchGroup *group =
+        &g_array_index (batch->groups, CoglPangoTextBatchGroup, i);
+
+      g_array_free (group->vertices, TRUE);
+    }
+  g_array_free (batch->groups, TRUE);
+
+  g_slice_free (CoglPangoTextBatch, batch);
+}
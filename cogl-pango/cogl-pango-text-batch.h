@@ -0,0 +1,94 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_PANGO_TEXT_BATCH_H__
+#define __COGL_PANGO_TEXT_BATCH_H__
+
+#include <glib.h>
+
+#include "cogl/cogl-context-private.h"
+
+COGL_BEGIN_DECLS
+
+/* A text batch collects the quads of many display lists so that they
+   can be drawn with one draw call per pipeline instead of one per
+   display list node. The quads are transformed into clip space on
+   the CPU when they are added so each display list can be drawn with
+   a different modelview matrix. They are all drawn with the clip
+   stack and viewport of the framebuffer at the time they were
+   added. */
+typedef struct _CoglPangoTextBatch CoglPangoTextBatch;
+
+CoglPangoTextBatch *
+_cogl_pango_text_batch_new (CoglContext *ctx);
+
+/* Prepares to add quads that would be drawn to @framebuffer with its
+   current transform. If the framebuffer, clip stack or viewport is
+   different from the last call then the quads that are already in
+   the batch are drawn first */
+void
+_cogl_pango_text_batch_set_target (CoglPangoTextBatch *batch,
+                                   CoglFramebuffer *framebuffer);
+
+/* Adds rectangles in the format expected by
+   cogl_framebuffer_draw_textured_rectangles. If
+   @distance_field_width_location isn't -1 then that uniform will be
+   set to @distance_field_width before they are drawn. @color must be
+   premultiplied */
+void
+_cogl_pango_text_batch_add_rectangles (CoglPangoTextBatch *batch,
+                                       CoglPipeline *pipeline,
+                                       int distance_field_width_location,
+                                       float distance_field_width,
+                                       const CoglColor *color,
+                                       const float *rectangles,
+                                       int n_rectangles);
+
+/* Adds an untextured quad with the given corners in the same order
+   as the rectangles */
+void
+_cogl_pango_text_batch_add_quad (CoglPangoTextBatch *batch,
+                                 CoglPipeline *pipeline,
+                                 const CoglColor *color,
+                                 const CoglVertexP2 *vertices);
+
+/* Draws everything that has been added so far */
+void
+_cogl_pango_text_batch_flush (CoglPangoTextBatch *batch);
+
+/* Draws everything and forgets the framebuffer */
+void
+_cogl_pango_text_batch_end (CoglPangoTextBatch *batch);
+
+void
+_cogl_pango_text_batch_free (CoglPangoTextBatch *batch);
+
+COGL_END_DECLS
+
+#endif /* __COGL_PANGO_TEXT_BATCH_H__ */
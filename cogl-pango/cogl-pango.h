@@ -69,7 +69,8 @@ typedef PangoCairoFontMap CoglPangoFontMap;
  * cogl_pango_font_map_new:
  * @context: A #CoglContext
  *
- * Creates a new font map.
+ * Creates a new font map. This must be called on the thread that is
+ * using @context.
  *
  * Return value: (transfer full): the newly created #PangoFontMap
  *
@@ -116,6 +117,18 @@ cogl_pango_font_map_clear_glyph_cache (CoglPangoFontMap *font_map);
  * This api should be used to avoid mid-scene modifications of
  * glyph-cache textures which can lead to undefined rendering results.
  *
+ * When called on the thread that is using the #CoglContext any new
+ * glyphs are drawn and uploaded straight away. Drawing them can be
+ * shared with the context's worker threads, see
+ * cogl_pango_font_map_set_use_worker_threads().
+ *
+ * This can also be called from another thread to pre-warm the glyph
+ * cache before the text is needed. In that case the new glyphs are
+ * only drawn into memory and no Cogl state is touched. They are given
+ * space in the glyph cache textures and uploaded the next time the
+ * layout is prepared on the context's thread, either by calling this
+ * function there or by drawing the layout.
+ *
  * Since: 1.0
  */
 void
@@ -149,6 +162,123 @@ cogl_pango_font_map_set_use_mipmapping (CoglPangoFontMap *font_map,
 CoglBool
 cogl_pango_font_map_get_use_mipmapping (CoglPangoFontMap *font_map);
 
+/**
+ * cogl_pango_font_map_set_use_worker_threads:
+ * @font_map: a #CoglPangoFontMap
+ * @value: %TRUE to draw new glyphs on the context's worker threads
+ *
+ * Sets whether the renderer for @font_map shares drawing new glyphs
+ * with the worker threads of its #CoglContext before they are
+ * uploaded to the glyph cache textures. The number of worker threads
+ * can be limited with the COGL_MAX_WORKER_THREADS environment
+ * variable. The thread that calls into Cogl Pango always takes a
+ * share of the glyphs as well and it is still the only thread that
+ * touches Cogl, so the upload itself is not affected. This helps
+ * when a large amount of new text appears at once, for example after
+ * switching language.
+ *
+ * The default is %FALSE which means all glyphs are drawn on the
+ * calling thread.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_pango_font_map_set_use_worker_threads (CoglPangoFontMap *font_map,
+                                            CoglBool value);
+
+/**
+ * cogl_pango_font_map_get_use_worker_threads:
+ * @font_map: a #CoglPangoFontMap
+ *
+ * Retrieves whether the renderer for @font_map draws new glyphs on
+ * the context's worker threads.
+ *
+ * Return value: %TRUE if the worker threads are used, %FALSE otherwise.
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglBool
+cogl_pango_font_map_get_use_worker_threads (CoglPangoFontMap *font_map);
+
+/**
+ * cogl_pango_font_map_begin_batch:
+ * @font_map: a #CoglPangoFontMap
+ *
+ * Starts collecting the text of every layout that is shown with
+ * cogl_pango_show_layout() or cogl_pango_show_layout_line() using
+ * @font_map instead of drawing it straight away. When
+ * cogl_pango_font_map_end_batch() is called all of the text is drawn
+ * with one draw call for each glyph cache texture. This is much
+ * faster than drawing each layout separately when a frame contains
+ * many small labels.
+ *
+ * Because the text is drawn at the end, anything else that is drawn
+ * to the framebuffer in the meantime will end up underneath it, and
+ * text that uses different textures may be stacked in a different
+ * order. Each layout keeps the transform that was current when it
+ * was shown. If a layout is shown with a different framebuffer,
+ * clip or viewport then the text collected so far is drawn first.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_pango_font_map_begin_batch (CoglPangoFontMap *font_map);
+
+/**
+ * cogl_pango_font_map_end_batch:
+ * @font_map: a #CoglPangoFontMap
+ *
+ * Draws all of the text that was collected since
+ * cogl_pango_font_map_begin_batch() was called and goes back to
+ * drawing each layout when it is shown.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_pango_font_map_end_batch (CoglPangoFontMap *font_map);
+
+/**
+ * cogl_pango_font_map_set_use_distance_field:
+ * @font_map: a #CoglPangoFontMap
+ * @value: %TRUE to render glyphs from signed distance fields
+ *
+ * Sets whether the renderer for @font_map should store glyphs as
+ * signed distance fields. Each glyph is then drawn once at one of a
+ * few reference sizes and the same cached image is used for every
+ * font size up to twice as big and down to half the size. This
+ * greatly reduces the number of glyphs that need to be rasterized
+ * when text is animated or shown at many different sizes, and the
+ * edges stay sharp when the text is scaled up by a transformation.
+ *
+ * Distance field glyphs are always drawn without hinting and they
+ * can't use subpixel antialiasing so small text may look slightly
+ * softer than with the default mode. When this is enabled it takes
+ * precedence over cogl_pango_font_map_set_use_mipmapping().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_pango_font_map_set_use_distance_field (CoglPangoFontMap *font_map,
+                                            CoglBool value);
+
+/**
+ * cogl_pango_font_map_get_use_distance_field:
+ * @font_map: a #CoglPangoFontMap
+ *
+ * Retrieves whether the renderer for @font_map renders glyphs from
+ * signed distance fields.
+ *
+ * Return value: %TRUE if distance fields are used, %FALSE otherwise.
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglBool
+cogl_pango_font_map_get_use_distance_field (CoglPangoFontMap *font_map);
+
 /**
  * cogl_pango_show_layout:
  * @framebuffer: A #CoglFramebuffer to draw too.
@@ -33,6 +33,7 @@
 
 #include "cogl-object.h"
 #include "cogl-attribute-private.h"
+#include "cogl-path.h"
 
 typedef struct _floatVec2
 {
@@ -40,11 +41,26 @@ typedef struct _floatVec2
   float y;
 } floatVec2;
 
+typedef enum
+{
+  COGL_PATH_NODE_TYPE_POINT,
+  /* The node is one of the two control points of a cubic bezier
+     curve that ends at the next point node. Curves are kept in this
+     form until the path is drawn so that they can be flattened with
+     a tolerance that matches the current transform */
+  COGL_PATH_NODE_TYPE_CUBIC_CONTROL,
+  /* A point added by cogl_path_close to return to the start of the
+     sub-path. This is only different from a normal point when the
+     path is stroked */
+  COGL_PATH_NODE_TYPE_CLOSE
+} CoglPathNodeType;
+
 typedef struct _CoglPathNode
 {
   float x;
   float y;
   unsigned int path_size;
+  CoglPathNodeType type;
 } CoglPathNode;
 
 typedef struct _CoglBezQuad
@@ -73,6 +89,61 @@ struct _CoglPath
 
 #define COGL_PATH_N_ATTRIBUTES 2
 
+/* The number of flattened versions of a path that are kept around
+   for different scales. This is enough to cover a zoom animation
+   crossing a couple of scale buckets without re-tessellating */
+#define COGL_PATH_N_TESSELLATIONS 4
+
+typedef struct _CoglPathTessellation
+{
+  /* The quantized scale that the curves were flattened for. The
+     bucket is a number of half-octaves above a scale of 1 */
+  int                  scale_bucket;
+  /* Used to pick the least recently used tessellation to replace */
+  unsigned int         age;
+
+  /* The path nodes with all of the curves flattened into lines. If
+     the path doesn't contain any curves then this is NULL and the
+     nodes of the path are used directly */
+  UArray              *path_nodes;
+
+  /* The first time a tessellation is filled or stroked the geometry
+     is only generated on the CPU and drawn through the context's
+     stream buffer, because many paths are built, drawn once and
+     thrown away. The geometry is kept in these arrays and only
+     uploaded to buffers of its own if it is drawn again */
+  UArray              *fill_vertices;
+  UArray              *fill_indices;
+  CoglIndicesType      fill_indices_type;
+  UArray              *stroke_vertices;
+  UArray              *stroke_indices;
+
+  CoglAttributeBuffer *fill_attribute_buffer;
+  CoglIndices         *fill_vbo_indices;
+  unsigned int         fill_vbo_n_indices;
+  CoglAttribute       *fill_attributes[COGL_PATH_N_ATTRIBUTES + 1];
+  CoglPrimitive       *fill_primitive;
+
+  /* All of the sub-paths are stroked with a single primitive. This
+     is NULL if the stroke hasn't been built yet or if it didn't
+     produce any geometry */
+  CoglPrimitive       *stroke_primitive;
+  CoglBool             stroke_built;
+} CoglPathTessellation;
+
+typedef struct _CoglPathStrokeStyle
+{
+  /* A width of zero means the stroke is drawn as 1 pixel lines */
+  float                width;
+  CoglPathLineJoin     line_join;
+  CoglPathLineCap      line_cap;
+  float                miter_limit;
+
+  float               *dashes;
+  int                  n_dashes;
+  float                dash_offset;
+} CoglPathStrokeStyle;
+
 struct _CoglPathData
 {
   unsigned int         ref_count;
@@ -81,6 +152,8 @@ struct _CoglPathData
 
   CoglPathFillRule     fill_rule;
 
+  CoglPathStrokeStyle  stroke_style;
+
   UArray              *path_nodes;
 
   floatVec2            path_start;
@@ -89,15 +162,12 @@ struct _CoglPathData
   floatVec2            path_nodes_min;
   floatVec2            path_nodes_max;
 
-  CoglAttributeBuffer *fill_attribute_buffer;
-  CoglIndices         *fill_vbo_indices;
-  unsigned int         fill_vbo_n_indices;
-  CoglAttribute       *fill_attributes[COGL_PATH_N_ATTRIBUTES + 1];
-  CoglPrimitive       *fill_primitive;
+  /* The number of cubic curves in path_nodes. If this is zero then
+     the geometry doesn't depend on the scale the path is drawn at */
+  unsigned int         n_curves;
 
-  CoglAttributeBuffer *stroke_attribute_buffer;
-  CoglAttribute      **stroke_attributes;
-  unsigned int         stroke_n_attributes;
+  CoglPathTessellation *tessellations[COGL_PATH_N_TESSELLATIONS];
+  unsigned int         tessellation_age;
 
   /* This is used as an optimisation for when the path contains a
      single contour specified using cogl2_path_rectangle. Cogl is more
@@ -108,6 +178,21 @@ struct _CoglPathData
   CoglBool             is_rectangle;
 };
 
+/* Generates the geometry to stroke the path described by @nodes,
+   which must already have its curves flattened. The positions are
+   appended to @vertices as floatVec2s and the indices are appended to
+   @indices as uint32_ts. If the style has a width of zero then the
+   indices describe COGL_VERTICES_MODE_LINES, otherwise they describe
+   COGL_VERTICES_MODE_TRIANGLES. @tolerance is the maximum distance in
+   path units that round joins and caps may deviate from a true
+   circle */
+void
+_cogl_path_stroker_stroke (const CoglPathStrokeStyle *style,
+                           UArray *nodes,
+                           float tolerance,
+                           UArray *vertices,
+                           UArray *indices);
+
 void
 _cogl_add_path_to_stencil_buffer (CoglPath  *path,
                                   CoglBool   merge,
@@ -0,0 +1,605 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <config.h>
+
+#include <ulib.h>
+
+#include <math.h>
+
+#include "cogl-util.h"
+#include "cogl-path-private.h"
+
+typedef struct _CoglPathStroker
+{
+  const CoglPathStrokeStyle *style;
+  float half_width;
+  float tolerance;
+  UArray *vertices;
+  UArray *indices;
+} CoglPathStroker;
+
+static uint32_t
+add_vertex (CoglPathStroker *stroker,
+            float x,
+            float y)
+{
+  floatVec2 vertex;
+
+  vertex.x = x;
+  vertex.y = y;
+  u_array_append_val (stroker->vertices, vertex);
+
+  return stroker->vertices->len - 1;
+}
+
+static void
+add_index (CoglPathStroker *stroker,
+           uint32_t index)
+{
+  u_array_append_val (stroker->indices, index);
+}
+
+static void
+add_triangle (CoglPathStroker *stroker,
+              uint32_t a,
+              uint32_t b,
+              uint32_t c)
+{
+  add_index (stroker, a);
+  add_index (stroker, b);
+  add_index (stroker, c);
+}
+
+/* Adds two triangles covering the quad a, b, c, d where a-b and c-d
+   are opposite edges */
+static void
+add_quad (CoglPathStroker *stroker,
+          const floatVec2 *a,
+          const floatVec2 *b,
+          const floatVec2 *c,
+          const floatVec2 *d)
+{
+  uint32_t first = add_vertex (stroker, a->x, a->y);
+
+  add_vertex (stroker, b->x, b->y);
+  add_vertex (stroker, c->x, c->y);
+  add_vertex (stroker, d->x, d->y);
+
+  add_triangle (stroker, first, first + 1, first + 2);
+  add_triangle (stroker, first + 2, first + 1, first + 3);
+}
+
+static void
+append_point (UArray *points,
+              float x,
+              float y)
+{
+  floatVec2 point;
+
+  /* Zero length segments have no direction so they are dropped */
+  if (points->len > 0)
+    {
+      floatVec2 *last = &u_array_index (points, floatVec2, points->len - 1);
+
+      if (last->x == x && last->y == y)
+        return;
+    }
+
+  point.x = x;
+  point.y = y;
+  u_array_append_val (points, point);
+}
+
+static void
+get_direction (const floatVec2 *from,
+               const floatVec2 *to,
+               floatVec2 *direction)
+{
+  float dx = to->x - from->x;
+  float dy = to->y - from->y;
+  float length = sqrtf (dx * dx + dy * dy);
+
+  direction->x = dx / length;
+  direction->y = dy / length;
+}
+
+/* Adds a triangle fan around @center for an arc of the stroke's
+   circle. The arc starts at @center + @start, which must have a
+   length of half the stroke width, and is rotated by @sweep
+   radians */
+static void
+add_arc (CoglPathStroker *stroker,
+         const floatVec2 *center,
+         const floatVec2 *start,
+         float sweep)
+{
+  float max_step;
+  uint32_t center_index, prev_index;
+  int n_steps;
+  int i;
+
+  /* Pick the largest step where the chords stay within the tolerance
+     of the circle */
+  if (stroker->tolerance < stroker->half_width)
+    max_step = 2.0f * acosf (1.0f - stroker->tolerance / stroker->half_width);
+  else
+    max_step = G_PI / 2.0f;
+
+  n_steps = ceilf (fabsf (sweep) / max_step);
+  n_steps = CLAMP (n_steps, 1, 1024);
+
+  center_index = add_vertex (stroker, center->x, center->y);
+  prev_index = add_vertex (stroker,
+                           center->x + start->x,
+                           center->y + start->y);
+
+  for (i = 1; i <= n_steps; i++)
+    {
+      float angle = sweep * i / n_steps;
+      float cos_angle = cosf (angle);
+      float sin_angle = sinf (angle);
+      uint32_t index;
+
+      index = add_vertex (stroker,
+                          center->x +
+                          start->x * cos_angle - start->y * sin_angle,
+                          center->y +
+                          start->x * sin_angle + start->y * cos_angle);
+      add_triangle (stroker, center_index, prev_index, index);
+      prev_index = index;
+    }
+}
+
+/* Fills in the outer corner between a segment with direction @d0
+   ending at @point and a segment with direction @d1 starting there.
+   The inner side is already covered by the overlapping segments */
+static void
+add_join (CoglPathStroker *stroker,
+          const floatVec2 *point,
+          const floatVec2 *d0,
+          const floatVec2 *d1)
+{
+  float h = stroker->half_width;
+  float cross = d0->x * d1->y - d0->y * d1->x;
+  float dot = d0->x * d1->x + d0->y * d1->y;
+  floatVec2 outer0, outer1;
+  float side;
+
+  /* The segments continue in a straight line */
+  if (fabsf (cross) < 1e-6f && dot > 0.0f)
+    return;
+
+  /* The outer side of the corner is on the opposite side to the
+     direction the path turns */
+  side = cross > 0.0f ? -1.0f : 1.0f;
+
+  outer0.x = -d0->y * side * h;
+  outer0.y = d0->x * side * h;
+  outer1.x = -d1->y * side * h;
+  outer1.y = d1->x * side * h;
+
+  switch (stroker->style->line_join)
+    {
+    case COGL_PATH_LINE_JOIN_ROUND:
+      {
+        float sweep;
+
+        /* If the path doubles back on itself then there's no shorter
+           way round so we have to pick a direction. This goes round
+           the front of the first segment */
+        if (cross == 0.0f)
+          sweep = -side * G_PI;
+        else
+          sweep = atan2f (outer0.x * outer1.y - outer0.y * outer1.x,
+                          outer0.x * outer1.x + outer0.y * outer1.y);
+
+        add_arc (stroker, point, &outer0, sweep);
+      }
+      return;
+
+    case COGL_PATH_LINE_JOIN_MITER:
+      /* The miter length divided by half the width is
+         1/cos(θ/2) = sqrt(2/(1+cos(θ))) where θ is the angle between
+         the two segments */
+      if (dot > -1.0f + 1e-6f &&
+          2.0f / (1.0f + dot) <= (stroker->style->miter_limit *
+                                  stroker->style->miter_limit))
+        {
+          floatVec2 tip;
+          uint32_t first;
+
+          tip.x = point->x + (outer0.x + outer1.x) / (1.0f + dot);
+          tip.y = point->y + (outer0.y + outer1.y) / (1.0f + dot);
+
+          first = add_vertex (stroker, point->x, point->y);
+          add_vertex (stroker, point->x + outer0.x, point->y + outer0.y);
+          add_vertex (stroker, tip.x, tip.y);
+          add_vertex (stroker, point->x + outer1.x, point->y + outer1.y);
+
+          add_triangle (stroker, first, first + 1, first + 2);
+          add_triangle (stroker, first, first + 2, first + 3);
+          return;
+        }
+      /* flow through */
+
+    case COGL_PATH_LINE_JOIN_BEVEL:
+      {
+        uint32_t first = add_vertex (stroker, point->x, point->y);
+
+        add_vertex (stroker, point->x + outer0.x, point->y + outer0.y);
+        add_vertex (stroker, point->x + outer1.x, point->y + outer1.y);
+
+        add_triangle (stroker, first, first + 1, first + 2);
+      }
+      return;
+    }
+}
+
+/* Adds a cap at @point for the end of a stroke heading in
+   @direction */
+static void
+add_cap (CoglPathStroker *stroker,
+         const floatVec2 *point,
+         const floatVec2 *direction)
+{
+  float h = stroker->half_width;
+  floatVec2 normal;
+
+  normal.x = -direction->y * h;
+  normal.y = direction->x * h;
+
+  switch (stroker->style->line_cap)
+    {
+    case COGL_PATH_LINE_CAP_BUTT:
+      break;
+
+    case COGL_PATH_LINE_CAP_ROUND:
+      /* Rotating the normal by -π/2 points along the direction so
+         this goes round the front of the end point */
+      add_arc (stroker, point, &normal, -G_PI);
+      break;
+
+    case COGL_PATH_LINE_CAP_SQUARE:
+      {
+        floatVec2 a, b, c, d;
+
+        a.x = point->x + normal.x;
+        a.y = point->y + normal.y;
+        b.x = point->x - normal.x;
+        b.y = point->y - normal.y;
+        c.x = a.x + direction->x * h;
+        c.y = a.y + direction->y * h;
+        d.x = b.x + direction->x * h;
+        d.y = b.y + direction->y * h;
+
+        add_quad (stroker, &a, &b, &c, &d);
+      }
+      break;
+    }
+}
+
+/* Strokes a run of points where consecutive points are never equal */
+static void
+stroke_polyline (CoglPathStroker *stroker,
+                 const floatVec2 *points,
+                 int n_points,
+                 CoglBool closed)
+{
+  int n_segments = closed ? n_points : n_points - 1;
+  floatVec2 first_direction, prev_direction;
+  int i;
+
+  if (n_points < 2)
+    return;
+
+  if (stroker->half_width <= 0.0f)
+    {
+      uint32_t first = add_vertex (stroker, points[0].x, points[0].y);
+
+      for (i = 1; i < n_points; i++)
+        {
+          add_vertex (stroker, points[i].x, points[i].y);
+          add_index (stroker, first + i - 1);
+          add_index (stroker, first + i);
+        }
+
+      if (closed)
+        {
+          add_index (stroker, first + n_points - 1);
+          add_index (stroker, first);
+        }
+
+      return;
+    }
+
+  get_direction (&points[0], &points[1], &first_direction);
+  prev_direction = first_direction;
+
+  for (i = 0; i < n_segments; i++)
+    {
+      const floatVec2 *from = &points[i];
+      const floatVec2 *to = &points[(i + 1) % n_points];
+      floatVec2 direction;
+      floatVec2 a, b, c, d;
+      float nx, ny;
+
+      get_direction (from, to, &direction);
+
+      nx = -direction.y * stroker->half_width;
+      ny = direction.x * stroker->half_width;
+
+      a.x = from->x + nx;
+      a.y = from->y + ny;
+      b.x = from->x - nx;
+      b.y = from->y - ny;
+      c.x = to->x + nx;
+      c.y = to->y + ny;
+      d.x = to->x - nx;
+      d.y = to->y - ny;
+
+      add_quad (stroker, &a, &b, &c, &d);
+
+      if (i > 0)
+        add_join (stroker, from, &prev_direction, &direction);
+
+      prev_direction = direction;
+    }
+
+  if (closed)
+    add_join (stroker, &points[0], &prev_direction, &first_direction);
+  else
+    {
+      floatVec2 backwards;
+
+      backwards.x = -first_direction.x;
+      backwards.y = -first_direction.y;
+
+      add_cap (stroker, &points[0], &backwards);
+      add_cap (stroker, &points[n_points - 1], &prev_direction);
+    }
+}
+
+/* Strokes a sub-path that collapsed to a single point. Only round
+   caps have a shape that doesn't depend on the direction */
+static void
+stroke_dot (CoglPathStroker *stroker,
+            const floatVec2 *point)
+{
+  floatVec2 start;
+
+  if (stroker->half_width <= 0.0f ||
+      stroker->style->line_cap != COGL_PATH_LINE_CAP_ROUND)
+    return;
+
+  start.x = stroker->half_width;
+  start.y = 0.0f;
+
+  add_arc (stroker, point, &start, 2.0f * G_PI);
+}
+
+static void
+stroke_dashed (CoglPathStroker *stroker,
+               const floatVec2 *points,
+               int n_points,
+               CoglBool closed)
+{
+  const CoglPathStrokeStyle *style = stroker->style;
+  int n_segments = closed ? n_points : n_points - 1;
+  UArray *dash = u_array_new (FALSE, FALSE, sizeof (floatVec2));
+  UArray *first_dash = NULL;
+  CoglBool started_on;
+  CoglBool on = TRUE;
+  CoglBool toggled = FALSE;
+  float remaining;
+  float period = 0.0f;
+  float offset;
+  int dash_index = 0;
+  int i;
+
+  for (i = 0; i < style->n_dashes; i++)
+    period += style->dashes[i];
+  /* An odd number of dashes needs two repetitions before the pattern
+     is back in the same state */
+  if (style->n_dashes & 1)
+    period *= 2.0f;
+
+  offset = fmodf (style->dash_offset, period);
+  if (offset < 0.0f)
+    offset += period;
+
+  /* Skip into the pattern by the offset */
+  remaining = style->dashes[0];
+  while (offset >= remaining)
+    {
+      offset -= remaining;
+      dash_index = (dash_index + 1) % style->n_dashes;
+      on = !on;
+      remaining = style->dashes[dash_index];
+    }
+  remaining -= offset;
+
+  started_on = on;
+
+  if (on)
+    append_point (dash, points[0].x, points[0].y);
+
+  for (i = 0; i < n_segments; i++)
+    {
+      const floatVec2 *from = &points[i];
+      const floatVec2 *to = &points[(i + 1) % n_points];
+      floatVec2 direction;
+      float dx = to->x - from->x;
+      float dy = to->y - from->y;
+      float length = sqrtf (dx * dx + dy * dy);
+      float position = 0.0f;
+
+      get_direction (from, to, &direction);
+
+      while (length - position > remaining)
+        {
+          float x, y;
+
+          position += remaining;
+          x = from->x + direction.x * position;
+          y = from->y + direction.y * position;
+
+          if (on)
+            {
+              append_point (dash, x, y);
+
+              /* The first dash of a closed path might need to be
+                 joined up with the last one so it's kept until the
+                 end */
+              if (closed && started_on && !toggled)
+                {
+                  first_dash = dash;
+                  dash = u_array_new (FALSE, FALSE, sizeof (floatVec2));
+                }
+              else
+                {
+                  stroke_polyline (stroker,
+                                   (floatVec2 *) dash->data, dash->len,
+                                   FALSE);
+                  u_array_set_size (dash, 0);
+                }
+            }
+          else
+            append_point (dash, x, y);
+
+          toggled = TRUE;
+          on = !on;
+          dash_index = (dash_index + 1) % style->n_dashes;
+          remaining = style->dashes[dash_index];
+        }
+
+      remaining -= length - position;
+
+      if (on)
+        append_point (dash, to->x, to->y);
+    }
+
+  if (!toggled)
+    /* The whole path is inside a single dash */
+    stroke_polyline (stroker, points, n_points, closed);
+  else
+    {
+      if (on && first_dash)
+        {
+          /* The last dash runs into the first one across the start
+             of the path */
+          for (i = 0; i < first_dash->len; i++)
+            {
+              floatVec2 *point = &u_array_index (first_dash, floatVec2, i);
+              append_point (dash, point->x, point->y);
+            }
+          stroke_polyline (stroker,
+                           (floatVec2 *) dash->data, dash->len,
+                           FALSE);
+        }
+      else
+        {
+          if (on)
+            stroke_polyline (stroker,
+                             (floatVec2 *) dash->data, dash->len,
+                             FALSE);
+          if (first_dash)
+            stroke_polyline (stroker,
+                             (floatVec2 *) first_dash->data, first_dash->len,
+                             FALSE);
+        }
+    }
+
+  if (first_dash)
+    u_array_free (first_dash, TRUE);
+  u_array_free (dash, TRUE);
+}
+
+void
+_cogl_path_stroker_stroke (const CoglPathStrokeStyle *style,
+                           UArray *nodes,
+                           float tolerance,
+                           UArray *vertices,
+                           UArray *indices)
+{
+  CoglPathStroker stroker;
+  UArray *points = u_array_new (FALSE, FALSE, sizeof (floatVec2));
+  unsigned int path_start;
+  CoglPathNode *node;
+  unsigned int i;
+
+  stroker.style = style;
+  stroker.half_width = style->width / 2.0f;
+  stroker.tolerance = tolerance;
+  stroker.vertices = vertices;
+  stroker.indices = indices;
+
+  for (path_start = 0;
+       path_start < nodes->len;
+       path_start += node->path_size)
+    {
+      const floatVec2 *first, *last;
+      CoglBool closed;
+
+      node = &u_array_index (nodes, CoglPathNode, path_start);
+
+      closed = node[node->path_size - 1].type == COGL_PATH_NODE_TYPE_CLOSE;
+
+      u_array_set_size (points, 0);
+      for (i = 0; i < node->path_size; i++)
+        append_point (points, node[i].x, node[i].y);
+
+      if (points->len == 1)
+        {
+          /* A lone move-to doesn't draw anything but a sub-path with
+             only zero length segments draws a dot */
+          if (node->path_size > 1)
+            stroke_dot (&stroker, &u_array_index (points, floatVec2, 0));
+          continue;
+        }
+
+      /* The closing node returns to the first point so the closing
+         segment is implied instead */
+      first = &u_array_index (points, floatVec2, 0);
+      last = &u_array_index (points, floatVec2, points->len - 1);
+      if (closed && first->x == last->x && first->y == last->y)
+        u_array_set_size (points, points->len - 1);
+
+      if (style->n_dashes > 0)
+        stroke_dashed (&stroker,
+                       (floatVec2 *) points->data, points->len,
+                       closed);
+      else
+        stroke_polyline (&stroker,
+                         (floatVec2 *) points->data, points->len,
+                         closed);
+    }
+
+  u_array_free (points, TRUE);
+}
@@ -57,47 +57,102 @@
 
 #define _COGL_MAX_BEZ_RECURSE_DEPTH 16
 
+/* Scales are quantized into half-octave buckets. Beyond this many
+   buckets in either direction the tolerance stops changing */
+#define _COGL_PATH_MAX_SCALE_BUCKET 16
+
+/* The maximum distance in pixels that round joins and caps of a wide
+   stroke may be from a true circle */
+#define _COGL_PATH_STROKE_TOLERANCE 0.25f
+
 static void _cogl_path_free (CoglPath *path);
 
-static void _cogl_path_build_fill_attribute_buffer (CoglPath *path);
-static CoglPrimitive *_cogl_path_get_fill_primitive (CoglPath *path);
-static void _cogl_path_build_stroke_attribute_buffer (CoglPath *path);
+static void
+_cogl_path_tessellate_fill (CoglPath *path,
+                            CoglPathTessellation *tessellation);
+static void
+_cogl_path_build_fill_attribute_buffer (CoglPath *path,
+                                        CoglPathTessellation *tessellation);
+static void
+_cogl_path_draw_fill_streamed (CoglPathTessellation *tessellation,
+                               CoglFramebuffer *framebuffer,
+                               CoglPipeline *pipeline,
+                               CoglDrawFlags flags);
+static void
+_cogl_path_build_stroke_geometry (CoglPath *path,
+                                  CoglPathTessellation *tessellation);
+static void
+_cogl_path_draw_streamed (CoglFramebuffer *framebuffer,
+                          CoglPipeline *pipeline,
+                          CoglDrawFlags flags,
+                          CoglVerticesMode mode,
+                          UArray *vertices,
+                          size_t vertex_size,
+                          int n_attributes,
+                          CoglIndicesType indices_type,
+                          UArray *indices);
+static CoglPrimitive *
+_cogl_path_get_fill_primitive (CoglPath *path,
+                               CoglPathTessellation *tessellation);
+static CoglPrimitive *
+_cogl_path_get_stroke_primitive (CoglPath *path,
+                                 CoglPathTessellation *tessellation);
+static CoglPathTessellation *
+_cogl_path_get_tessellation_for_framebuffer (CoglPath *path,
+                                             CoglBool scale_dependent,
+                                             CoglFramebuffer *framebuffer);
 
 COGL_OBJECT_DEFINE (Path, path);
 
 static void
-_cogl_path_data_clear_vbos (CoglPathData *data)
+_cogl_path_tessellation_free (CoglPathTessellation *tessellation)
 {
   int i;
 
-  if (data->fill_attribute_buffer)
+  if (tessellation->fill_attribute_buffer)
     {
-      cogl_object_unref (data->fill_attribute_buffer);
-      cogl_object_unref (data->fill_vbo_indices);
+      cogl_object_unref (tessellation->fill_attribute_buffer);
+      cogl_object_unref (tessellation->fill_vbo_indices);
 
       for (i = 0; i < COGL_PATH_N_ATTRIBUTES; i++)
-        cogl_object_unref (data->fill_attributes[i]);
-
-      data->fill_attribute_buffer = NULL;
+        cogl_object_unref (tessellation->fill_attributes[i]);
     }
 
-  if (data->fill_primitive)
+  if (tessellation->fill_primitive)
+    cogl_object_unref (tessellation->fill_primitive);
+
+  if (tessellation->stroke_primitive)
+    cogl_object_unref (tessellation->stroke_primitive);
+
+  if (tessellation->path_nodes)
+    u_array_free (tessellation->path_nodes, TRUE);
+
+  if (tessellation->fill_vertices)
     {
-      cogl_object_unref (data->fill_primitive);
-      data->fill_primitive = NULL;
+      u_array_free (tessellation->fill_vertices, TRUE);
+      u_array_free (tessellation->fill_indices, TRUE);
     }
 
-  if (data->stroke_attribute_buffer)
+  if (tessellation->stroke_vertices)
     {
-      cogl_object_unref (data->stroke_attribute_buffer);
+      u_array_free (tessellation->stroke_vertices, TRUE);
+      u_array_free (tessellation->stroke_indices, TRUE);
+    }
 
-      for (i = 0; i < data->stroke_n_attributes; i++)
-        cogl_object_unref (data->stroke_attributes[i]);
+  u_slice_free (CoglPathTessellation, tessellation);
+}
 
-      u_free (data->stroke_attributes);
+static void
+_cogl_path_data_clear_vbos (CoglPathData *data)
+{
+  int i;
 
-      data->stroke_attribute_buffer = NULL;
-    }
+  for (i = 0; i < COGL_PATH_N_TESSELLATIONS; i++)
+    if (data->tessellations[i])
+      {
+        _cogl_path_tessellation_free (data->tessellations[i]);
+        data->tessellations[i] = NULL;
+      }
 }
 
 static void
@@ -108,6 +163,7 @@ _cogl_path_data_unref (CoglPathData *data)
       _cogl_path_data_clear_vbos (data);
 
       u_array_free (data->path_nodes, TRUE);
+      u_free (data->stroke_style.dashes);
 
       u_slice_free (CoglPathData, data);
     }
@@ -131,10 +187,12 @@ _cogl_path_modify (CoglPath *path)
       u_array_append_vals (path->data->path_nodes,
                            old_data->path_nodes->data,
                            old_data->path_nodes->len);
+      path->data->stroke_style.dashes =
+        u_memdup (old_data->stroke_style.dashes,
+                  old_data->stroke_style.n_dashes * sizeof (float));
 
-      path->data->fill_attribute_buffer = NULL;
-      path->data->fill_primitive = NULL;
-      path->data->stroke_attribute_buffer = NULL;
+      memset (path->data->tessellations, 0,
+              sizeof (path->data->tessellations));
       path->data->ref_count = 1;
 
       _cogl_path_data_unref (old_data);
@@ -166,11 +224,164 @@ cogl_path_get_fill_rule (CoglPath *path)
   return path->data->fill_rule;
 }
 
+void
+cogl_path_set_stroke_width (CoglPath *path,
+                            float width)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+  _COGL_RETURN_IF_FAIL (width >= 0.0f);
+
+  if (path->data->stroke_style.width != width)
+    {
+      _cogl_path_modify (path);
+
+      path->data->stroke_style.width = width;
+    }
+}
+
+float
+cogl_path_get_stroke_width (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), 0.0f);
+
+  return path->data->stroke_style.width;
+}
+
+void
+cogl_path_set_line_join (CoglPath *path,
+                         CoglPathLineJoin line_join)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+
+  if (path->data->stroke_style.line_join != line_join)
+    {
+      _cogl_path_modify (path);
+
+      path->data->stroke_style.line_join = line_join;
+    }
+}
+
+CoglPathLineJoin
+cogl_path_get_line_join (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), COGL_PATH_LINE_JOIN_MITER);
+
+  return path->data->stroke_style.line_join;
+}
+
+void
+cogl_path_set_line_cap (CoglPath *path,
+                        CoglPathLineCap line_cap)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+
+  if (path->data->stroke_style.line_cap != line_cap)
+    {
+      _cogl_path_modify (path);
+
+      path->data->stroke_style.line_cap = line_cap;
+    }
+}
+
+CoglPathLineCap
+cogl_path_get_line_cap (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), COGL_PATH_LINE_CAP_BUTT);
+
+  return path->data->stroke_style.line_cap;
+}
+
+void
+cogl_path_set_miter_limit (CoglPath *path,
+                           float miter_limit)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+  _COGL_RETURN_IF_FAIL (miter_limit >= 1.0f);
+
+  if (path->data->stroke_style.miter_limit != miter_limit)
+    {
+      _cogl_path_modify (path);
+
+      path->data->stroke_style.miter_limit = miter_limit;
+    }
+}
+
+float
+cogl_path_get_miter_limit (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), 10.0f);
+
+  return path->data->stroke_style.miter_limit;
+}
+
+void
+cogl_path_set_dash (CoglPath *path,
+                    const float *dashes,
+                    int n_dashes,
+                    float offset)
+{
+  CoglPathStrokeStyle *style;
+  float total = 0.0f;
+  int i;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+  _COGL_RETURN_IF_FAIL (n_dashes >= 0);
+  _COGL_RETURN_IF_FAIL (n_dashes == 0 || dashes != NULL);
+
+  for (i = 0; i < n_dashes; i++)
+    {
+      _COGL_RETURN_IF_FAIL (dashes[i] >= 0.0f);
+      total += dashes[i];
+    }
+
+  /* A pattern with no length would never advance */
+  _COGL_RETURN_IF_FAIL (n_dashes == 0 || total > 0.0f);
+
+  _cogl_path_modify (path);
+
+  style = &path->data->stroke_style;
+
+  u_free (style->dashes);
+  style->dashes = u_memdup (dashes, n_dashes * sizeof (float));
+  style->n_dashes = n_dashes;
+  style->dash_offset = offset;
+}
+
+const float *
+cogl_path_get_dash (CoglPath *path,
+                    int *n_dashes,
+                    float *offset)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), NULL);
+
+  *n_dashes = path->data->stroke_style.n_dashes;
+  if (offset)
+    *offset = path->data->stroke_style.dash_offset;
+
+  return path->data->stroke_style.dashes;
+}
+
 static void
-_cogl_path_add_node (CoglPath *path,
-                     CoglBool new_sub_path,
-		     float x,
-		     float y)
+_cogl_path_data_add_to_bounds (CoglPathData *data,
+                               float x,
+                               float y)
+{
+  if (x < data->path_nodes_min.x)
+    data->path_nodes_min.x = x;
+  if (x > data->path_nodes_max.x)
+    data->path_nodes_max.x = x;
+  if (y < data->path_nodes_min.y)
+    data->path_nodes_min.y = y;
+  if (y > data->path_nodes_max.y)
+    data->path_nodes_max.y = y;
+}
+
+static void
+_cogl_path_add_node_with_type (CoglPath *path,
+                               CoglBool new_sub_path,
+                               float x,
+                               float y,
+                               CoglPathNodeType type)
 {
   CoglPathNode new_node;
   CoglPathData *data;
@@ -182,6 +393,7 @@ _cogl_path_add_node (CoglPath *path,
   new_node.x = x;
   new_node.y = y;
   new_node.path_size = 0;
+  new_node.type = type;
 
   if (new_sub_path || data->path_nodes->len == 0)
     data->last_path = data->path_nodes->len;
@@ -190,22 +402,16 @@ _cogl_path_add_node (CoglPath *path,
 
   u_array_index (data->path_nodes, CoglPathNode, data->last_path).path_size++;
 
+  /* Control points don't lie on the path so they don't contribute to
+     the bounds. cogl_path_curve_to adds the extents of the curve
+     itself instead */
   if (data->path_nodes->len == 1)
     {
       data->path_nodes_min.x = data->path_nodes_max.x = x;
       data->path_nodes_min.y = data->path_nodes_max.y = y;
     }
-  else
-    {
-      if (x < data->path_nodes_min.x)
-        data->path_nodes_min.x = x;
-      if (x > data->path_nodes_max.x)
-        data->path_nodes_max.x = x;
-      if (y < data->path_nodes_min.y)
-        data->path_nodes_min.y = y;
-      if (y > data->path_nodes_max.y)
-        data->path_nodes_max.y = y;
-    }
+  else if (type != COGL_PATH_NODE_TYPE_CUBIC_CONTROL)
+    _cogl_path_data_add_to_bounds (data, x, y);
 
   /* Once the path nodes have been modified then we'll assume it's no
      longer a rectangle. cogl_path_rectangle will set this back to
@@ -213,16 +419,35 @@ _cogl_path_add_node (CoglPath *path,
   data->is_rectangle = FALSE;
 }
 
+static void
+_cogl_path_add_node (CoglPath *path,
+                     CoglBool new_sub_path,
+		     float x,
+		     float y)
+{
+  _cogl_path_add_node_with_type (path, new_sub_path, x, y,
+                                 COGL_PATH_NODE_TYPE_POINT);
+}
+
+static CoglVerticesMode
+_cogl_path_get_stroke_mode (CoglPathData *data)
+{
+  return (data->stroke_style.width > 0.0f ?
+          COGL_VERTICES_MODE_TRIANGLES :
+          COGL_VERTICES_MODE_LINES);
+}
+
 void
 cogl_path_stroke (CoglPath *path,
                   CoglFramebuffer *framebuffer,
                   CoglPipeline *pipeline)
 {
   CoglPathData *data;
+  CoglPathStrokeStyle *style;
+  CoglPathTessellation *tessellation;
+  CoglPrimitive *primitive;
   CoglPipeline *copy = NULL;
-  unsigned int path_start;
-  int path_num = 0;
-  CoglPathNode *node;
+  CoglBool scale_dependent;
 
   _COGL_RETURN_IF_FAIL (cogl_is_path (path));
   _COGL_RETURN_IF_FAIL (cogl_is_framebuffer (framebuffer));
@@ -240,25 +465,42 @@ cogl_path_stroke (CoglPath *path,
       pipeline = copy;
     }
 
-  _cogl_path_build_stroke_attribute_buffer (path);
+  style = &data->stroke_style;
 
-  for (path_start = 0;
-       path_start < data->path_nodes->len;
-       path_start += node->path_size)
-    {
-      CoglPrimitive *primitive;
+  /* Round joins and caps are flattened with a tolerance that depends
+     on the scale even if the path itself has no curves */
+  scale_dependent = (data->n_curves > 0 ||
+                     (style->width > 0.0f &&
+                      (style->line_join == COGL_PATH_LINE_JOIN_ROUND ||
+                       style->line_cap == COGL_PATH_LINE_CAP_ROUND)));
 
-      node = &u_array_index (data->path_nodes, CoglPathNode, path_start);
+  tessellation =
+    _cogl_path_get_tessellation_for_framebuffer (path,
+                                                 scale_dependent,
+                                                 framebuffer);
 
-      primitive =
-        cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_LINE_STRIP,
-                                            node->path_size,
-                                            &data->stroke_attributes[path_num],
-                                            1);
-      cogl_primitive_draw (primitive, framebuffer, pipeline);
-      cogl_object_unref (primitive);
+  /* The geometry only gets its own buffers the second time it is
+     drawn */
+  if (!tessellation->stroke_built &&
+      tessellation->stroke_vertices == NULL)
+    {
+      _cogl_path_build_stroke_geometry (path, tessellation);
+      _cogl_path_draw_streamed (framebuffer,
+                                pipeline,
+                                0, /* flags */
+                                _cogl_path_get_stroke_mode (data),
+                                tessellation->stroke_vertices,
+                                sizeof (floatVec2),
+                                1, /* n_attributes */
+                                COGL_INDICES_TYPE_UNSIGNED_INT,
+                                tessellation->stroke_indices);
+    }
+  else
+    {
+      primitive = _cogl_path_get_stroke_primitive (path, tessellation);
 
-      path_num++;
+      if (primitive)
+        cogl_primitive_draw (primitive, framebuffer, pipeline);
     }
 
   if (copy)
@@ -365,6 +607,7 @@ _cogl_path_fill_nodes (CoglPath *path,
   else
     {
       CoglBool needs_fallback = FALSE;
+      CoglPathTessellation *tessellation;
       CoglPrimitive *primitive;
 
       _cogl_pipeline_foreach_layer_internal (pipeline,
@@ -378,7 +621,25 @@ _cogl_path_fill_nodes (CoglPath *path,
           return;
         }
 
-      primitive = _cogl_path_get_fill_primitive (path);
+      tessellation =
+        _cogl_path_get_tessellation_for_framebuffer (path,
+                                                     path->data->n_curves > 0,
+                                                     framebuffer);
+
+      /* The geometry only gets its own buffers the second time it is
+         drawn */
+      if (tessellation->fill_primitive == NULL &&
+          tessellation->fill_vertices == NULL)
+        {
+          _cogl_path_tessellate_fill (path, tessellation);
+          _cogl_path_draw_fill_streamed (tessellation,
+                                         framebuffer,
+                                         pipeline,
+                                         flags);
+          return;
+        }
+
+      primitive = _cogl_path_get_fill_primitive (path, tessellation);
 
       _cogl_primitive_draw (primitive,
                             framebuffer,
@@ -472,8 +733,10 @@ cogl_path_close (CoglPath *path)
 {
   _COGL_RETURN_IF_FAIL (cogl_is_path (path));
 
-  _cogl_path_add_node (path, FALSE, path->data->path_start.x,
-                       path->data->path_start.y);
+  _cogl_path_add_node_with_type (path, FALSE,
+                                 path->data->path_start.x,
+                                 path->data->path_start.y,
+                                 COGL_PATH_NODE_TYPE_CLOSE);
 
   path->data->path_pen = path->data->path_start;
 }
@@ -735,9 +998,14 @@ cogl_path_round_rectangle (CoglPath *path,
   cogl_path_close (path);
 }
 
+/* Flattens @cubic into line segments and appends the points to
+   @nodes. The start and end points of the curve are not added. The
+   curve is subdivided until the control points are within
+   @tolerance of the chord, measured in the same units as the curve */
 static void
-_cogl_path_bezier3_sub (CoglPath *path,
-                        CoglBezCubic *cubic)
+_cogl_path_bezier3_sub (CoglBezCubic *cubic,
+                        float tolerance,
+                        UArray *nodes)
 {
   CoglBezCubic cubics[_COGL_MAX_BEZ_RECURSE_DEPTH];
   CoglBezCubic *cleft;
@@ -784,14 +1052,20 @@ _cogl_path_bezier3_sub (CoglPath *path,
       if (dif1.y < dif2.y) dif1.y = dif2.y;
 
       /* Cancel if the curve is flat enough */
-      if (dif1.x + dif1.y <= 1.0 ||
+      if (dif1.x + dif1.y <= tolerance ||
 	  cindex == _COGL_MAX_BEZ_RECURSE_DEPTH-1)
 	{
+          CoglPathNode node;
+
 	  /* Add subdivision point (skip last) */
 	  if (cindex == 0)
             return;
 
-	  _cogl_path_add_node (path, FALSE, c->p4.x, c->p4.y);
+          node.x = c->p4.x;
+          node.y = c->p4.y;
+          node.path_size = 0;
+          node.type = COGL_PATH_NODE_TYPE_POINT;
+          u_array_append_val (nodes, node);
 
 	  --cindex;
 
@@ -831,6 +1105,145 @@ _cogl_path_bezier3_sub (CoglPath *path,
     }
 }
 
+static UArray *
+_cogl_path_flatten_nodes (CoglPathData *data,
+                          float tolerance)
+{
+  UArray *flat_nodes = u_array_new (FALSE, FALSE, sizeof (CoglPathNode));
+  unsigned int path_start;
+  CoglPathNode *node;
+  unsigned int i;
+
+  for (path_start = 0;
+       path_start < data->path_nodes->len;
+       path_start += node->path_size)
+    {
+      unsigned int flat_path_start = flat_nodes->len;
+
+      node = &u_array_index (data->path_nodes, CoglPathNode, path_start);
+
+      for (i = 0; i < node->path_size; i++)
+        {
+          if (node[i].type == COGL_PATH_NODE_TYPE_CUBIC_CONTROL)
+            {
+              CoglBezCubic cubic;
+
+              /* A curve always starts from the previous node and its
+                 two control nodes are followed by the end point */
+              cubic.p1.x = node[i - 1].x;
+              cubic.p1.y = node[i - 1].y;
+              cubic.p2.x = node[i].x;
+              cubic.p2.y = node[i].y;
+              cubic.p3.x = node[i + 1].x;
+              cubic.p3.y = node[i + 1].y;
+              cubic.p4.x = node[i + 2].x;
+              cubic.p4.y = node[i + 2].y;
+
+              _cogl_path_bezier3_sub (&cubic, tolerance, flat_nodes);
+
+              /* Skip the second control point. The end point will be
+                 added as a normal node */
+              i++;
+            }
+          else
+            {
+              CoglPathNode flat_node = node[i];
+
+              flat_node.path_size = 0;
+              u_array_append_val (flat_nodes, flat_node);
+            }
+        }
+
+      u_array_index (flat_nodes, CoglPathNode, flat_path_start).path_size =
+        flat_nodes->len - flat_path_start;
+    }
+
+  return flat_nodes;
+}
+
+/* Finds the values of t within the curve where the derivative of one
+   of the coordinates of a cubic bezier is zero, ie, the roots of
+   a*t²+b*t+c */
+static int
+_cogl_path_get_cubic_turning_points (float p1,
+                                     float p2,
+                                     float p3,
+                                     float p4,
+                                     float *roots)
+{
+  float a = 3.0f * (p4 - p1) + 9.0f * (p2 - p3);
+  float b = 6.0f * (p1 - 2.0f * p2 + p3);
+  float c = 3.0f * (p2 - p1);
+  float candidates[2];
+  int n_candidates = 0;
+  int n_roots = 0;
+  int i;
+
+  if (fabsf (a) < 1e-6f)
+    {
+      if (fabsf (b) >= 1e-6f)
+        candidates[n_candidates++] = -c / b;
+    }
+  else
+    {
+      float discriminant = b * b - 4.0f * a * c;
+
+      if (discriminant >= 0.0f)
+        {
+          float sqrt_discriminant = sqrtf (discriminant);
+
+          candidates[n_candidates++] = (-b + sqrt_discriminant) / (2.0f * a);
+          candidates[n_candidates++] = (-b - sqrt_discriminant) / (2.0f * a);
+        }
+    }
+
+  for (i = 0; i < n_candidates; i++)
+    if (candidates[i] > 0.0f && candidates[i] < 1.0f)
+      roots[n_roots++] = candidates[i];
+
+  return n_roots;
+}
+
+static void
+_cogl_path_add_cubic_to_bounds (CoglPathData *data,
+                                const CoglBezCubic *cubic)
+{
+  float roots[4];
+  int n_roots;
+  int i;
+
+  /* The end points are already part of the bounds so we only need to
+     add the points where the curve turns around */
+  n_roots = _cogl_path_get_cubic_turning_points (cubic->p1.x,
+                                                 cubic->p2.x,
+                                                 cubic->p3.x,
+                                                 cubic->p4.x,
+                                                 roots);
+  n_roots += _cogl_path_get_cubic_turning_points (cubic->p1.y,
+                                                  cubic->p2.y,
+                                                  cubic->p3.y,
+                                                  cubic->p4.y,
+                                                  roots + n_roots);
+
+  for (i = 0; i < n_roots; i++)
+    {
+      float t = roots[i];
+      float mt = 1.0f - t;
+      float x, y;
+
+      x = (mt * mt * mt * cubic->p1.x +
+           3.0f * mt * mt * t * cubic->p2.x +
+           3.0f * mt * t * t * cubic->p3.x +
+           t * t * t * cubic->p4.x);
+      y = (mt * mt * mt * cubic->p1.y +
+           3.0f * mt * mt * t * cubic->p2.y +
+           3.0f * mt * t * t * cubic->p3.y +
+           t * t * t * cubic->p4.y);
+
+      _cogl_path_data_add_to_bounds (data, x, y);
+    }
+}
+
 void
 cogl_path_curve_to (CoglPath *path,
                     float x_1,
@@ -844,6 +1257,10 @@ cogl_path_curve_to (CoglPath *path,
 
   _COGL_RETURN_IF_FAIL (cogl_is_path (path));
 
+  /* The curve needs a node to start from */
+  if (path->data->path_nodes->len == 0)
+    cogl_path_move_to (path, path->data->path_pen.x, path->data->path_pen.y);
+
   /* Prepare cubic curve */
   cubic.p1 = path->data->path_pen;
   cubic.p2.x = x_1;
@@ -853,11 +1270,18 @@ cogl_path_curve_to (CoglPath *path,
   cubic.p4.x = x_3;
   cubic.p4.y = y_3;
 
-  /* Run subdivision */
-  _cogl_path_bezier3_sub (path, &cubic);
-
-  /* Add last point */
+  /* The curve is only flattened when the path is drawn because that's
+     when we know how precise it needs to be. Until then we just
+     store the control points */
+  _cogl_path_add_node_with_type (path, FALSE, x_1, y_1,
+                                 COGL_PATH_NODE_TYPE_CUBIC_CONTROL);
+  _cogl_path_add_node_with_type (path, FALSE, x_2, y_2,
+                                 COGL_PATH_NODE_TYPE_CUBIC_CONTROL);
   _cogl_path_add_node (path, FALSE, cubic.p4.x, cubic.p4.y);
+
+  _cogl_path_add_cubic_to_bounds (path->data, &cubic);
+
+  path->data->n_curves++;
   path->data->path_pen = cubic.p4;
 }
 
@@ -897,11 +1321,21 @@ cogl_path_new (CoglContext *context)
   data->ref_count = 1;
   data->context = context;
   data->fill_rule = COGL_PATH_FILL_RULE_EVEN_ODD;
+  data->stroke_style.width = 0.0f;
+  data->stroke_style.line_join = COGL_PATH_LINE_JOIN_MITER;
+  data->stroke_style.line_cap = COGL_PATH_LINE_CAP_BUTT;
+  data->stroke_style.miter_limit = 10.0f;
+  data->stroke_style.dashes = NULL;
+  data->stroke_style.n_dashes = 0;
+  data->stroke_style.dash_offset = 0.0f;
   data->path_nodes = u_array_new (FALSE, FALSE, sizeof (CoglPathNode));
+  data->path_start.x = 0.0f;
+  data->path_start.y = 0.0f;
+  data->path_pen = data->path_start;
   data->last_path = 0;
-  data->fill_attribute_buffer = NULL;
-  data->stroke_attribute_buffer = NULL;
-  data->fill_primitive = NULL;
+  data->n_curves = 0;
+  memset (data->tessellations, 0, sizeof (data->tessellations));
+  data->tessellation_age = 0;
   data->is_rectangle = FALSE;
 
   return _cogl_path_object_new (path);
@@ -1140,6 +1574,27 @@ _cogl_path_tesselator_add_index (CoglPathTesselator *tess, int vertex_index)
     }
 }
 
+static unsigned int
+_cogl_path_tesselator_get_index (CoglIndicesType indices_type,
+                                 UArray *indices,
+                                 int i)
+{
+  switch (indices_type)
+    {
+    case COGL_INDICES_TYPE_UNSIGNED_BYTE:
+      return u_array_index (indices, uint8_t, i);
+
+    case COGL_INDICES_TYPE_UNSIGNED_SHORT:
+      return u_array_index (indices, uint16_t, i);
+
+    case COGL_INDICES_TYPE_UNSIGNED_INT:
+      return u_array_index (indices, uint32_t, i);
+    }
+
+  u_assert_not_reached ();
+  return 0;
+}
+
 static void
 _cogl_path_tesselator_vertex (void *vertex_data,
                               CoglPathTesselator *tess)
@@ -1280,26 +1735,28 @@ _cogl_path_tesselator_combine (double coords[3],
 }
 
 static void
-_cogl_path_build_fill_attribute_buffer (CoglPath *path)
+_cogl_path_tessellate_fill (CoglPath *path,
+                            CoglPathTessellation *tessellation)
 {
   CoglPathTesselator tess;
   unsigned int path_start = 0;
   CoglPathData *data = path->data;
+  UArray *path_nodes;
   int i;
 
-  /* If we've already got a vbo then we don't need to do anything */
-  if (data->fill_attribute_buffer)
-    return;
+  path_nodes = (tessellation->path_nodes ?
+                tessellation->path_nodes :
+                data->path_nodes);
 
   tess.primitive_type = FALSE;
 
   /* Generate a vertex for each point on the path */
   tess.vertices = u_array_new (FALSE, FALSE, sizeof (CoglPathTesselatorVertex));
-  u_array_set_size (tess.vertices, data->path_nodes->len);
-  for (i = 0; i < data->path_nodes->len; i++)
+  u_array_set_size (tess.vertices, path_nodes->len);
+  for (i = 0; i < path_nodes->len; i++)
     {
       CoglPathNode *node =
-        &u_array_index (data->path_nodes, CoglPathNode, i);
+        &u_array_index (path_nodes, CoglPathNode, i);
       CoglPathTesselatorVertex *vertex =
         &u_array_index (tess.vertices, CoglPathTesselatorVertex, i);
 
@@ -1322,7 +1779,7 @@ _cogl_path_build_fill_attribute_buffer (CoglPath *path)
     }
 
   tess.indices_type =
-    _cogl_path_tesselator_get_indices_type_for_size (data->path_nodes->len);
+    _cogl_path_tesselator_get_indices_type_for_size (path_nodes->len);
   _cogl_path_tesselator_allocate_indices_array (&tess);
 
   tess.glu_tess = gluNewTess ();
@@ -1348,10 +1805,10 @@ _cogl_path_build_fill_attribute_buffer (CoglPath *path)
 
   gluTessBeginPolygon (tess.glu_tess, &tess);
 
-  while (path_start < data->path_nodes->len)
+  while (path_start < path_nodes->len)
     {
       CoglPathNode *node =
-        &u_array_index (data->path_nodes, CoglPathNode, path_start);
+        &u_array_index (path_nodes, CoglPathNode, path_start);
 
       gluTessBeginContour (tess.glu_tess);
 
@@ -1371,54 +1828,329 @@ _cogl_path_build_fill_attribute_buffer (CoglPath *path)
 
   gluDeleteTess (tess.glu_tess);
 
-  data->fill_attribute_buffer =
+  tessellation->fill_vertices = tess.vertices;
+  tessellation->fill_indices = tess.indices;
+  tessellation->fill_indices_type = tess.indices_type;
+}
+
+static void
+_cogl_path_build_fill_attribute_buffer (CoglPath *path,
+                                        CoglPathTessellation *tessellation)
+{
+  CoglPathData *data = path->data;
+  UArray *vertices;
+  UArray *indices;
+
+  /* If we've already got a vbo then we don't need to do anything */
+  if (tessellation->fill_attribute_buffer)
+    return;
+
+  if (tessellation->fill_vertices == NULL)
+    _cogl_path_tessellate_fill (path, tessellation);
+
+  vertices = tessellation->fill_vertices;
+  indices = tessellation->fill_indices;
+  tessellation->fill_vertices = NULL;
+  tessellation->fill_indices = NULL;
+
+  tessellation->fill_attribute_buffer =
     cogl_attribute_buffer_new (data->context,
                                sizeof (CoglPathTesselatorVertex) *
-                               tess.vertices->len,
-                               tess.vertices->data);
-  u_array_free (tess.vertices, TRUE);
+                               vertices->len,
+                               vertices->data);
+  u_array_free (vertices, TRUE);
 
-  data->fill_attributes[0] =
-    cogl_attribute_new (data->fill_attribute_buffer,
+  tessellation->fill_attributes[0] =
+    cogl_attribute_new (tessellation->fill_attribute_buffer,
                         "cogl_position_in",
                         sizeof (CoglPathTesselatorVertex),
                         G_STRUCT_OFFSET (CoglPathTesselatorVertex, x),
                         2, /* n_components */
                         COGL_ATTRIBUTE_TYPE_FLOAT);
-  data->fill_attributes[1] =
-    cogl_attribute_new (data->fill_attribute_buffer,
+  tessellation->fill_attributes[1] =
+    cogl_attribute_new (tessellation->fill_attribute_buffer,
                         "cogl_tex_coord0_in",
                         sizeof (CoglPathTesselatorVertex),
                         G_STRUCT_OFFSET (CoglPathTesselatorVertex, s),
                         2, /* n_components */
                         COGL_ATTRIBUTE_TYPE_FLOAT);
 
-  data->fill_vbo_indices = cogl_indices_new (data->context,
-                                             tess.indices_type,
-                                             tess.indices->data,
-                                             tess.indices->len);
-  data->fill_vbo_n_indices = tess.indices->len;
-  u_array_free (tess.indices, TRUE);
+  tessellation->fill_vbo_indices =
+    cogl_indices_new (data->context,
+                      tessellation->fill_indices_type,
+                      indices->data,
+                      indices->len);
+  tessellation->fill_vbo_n_indices = indices->len;
+  u_array_free (indices, TRUE);
 }
 
 static CoglPrimitive *
-_cogl_path_get_fill_primitive (CoglPath *path)
+_cogl_path_get_fill_primitive (CoglPath *path,
+                               CoglPathTessellation *tessellation)
 {
-  if (path->data->fill_primitive)
-    return path->data->fill_primitive;
+  if (tessellation->fill_primitive)
+    return tessellation->fill_primitive;
 
-  _cogl_path_build_fill_attribute_buffer (path);
+  _cogl_path_build_fill_attribute_buffer (path, tessellation);
 
-  path->data->fill_primitive =
+  tessellation->fill_primitive =
     cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
-                                        path->data->fill_vbo_n_indices,
-                                        path->data->fill_attributes,
+                                        tessellation->fill_vbo_n_indices,
+                                        tessellation->fill_attributes,
                                         COGL_PATH_N_ATTRIBUTES);
-  cogl_primitive_set_indices (path->data->fill_primitive,
-                              path->data->fill_vbo_indices,
-                              path->data->fill_vbo_n_indices);
+  cogl_primitive_set_indices (tessellation->fill_primitive,
+                              tessellation->fill_vbo_indices,
+                              tessellation->fill_vbo_n_indices);
+
+  return tessellation->fill_primitive;
+}
+
+static void
+_cogl_path_draw_streamed (CoglFramebuffer *framebuffer,
+                          CoglPipeline *pipeline,
+                          CoglDrawFlags flags,
+                          CoglVerticesMode mode,
+                          UArray *vertices,
+                          size_t vertex_size,
+                          int n_attributes,
+                          CoglIndicesType indices_type,
+                          UArray *indices)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglAttributeBuffer *attribute_buffer;
+  CoglAttribute *attributes[COGL_PATH_N_ATTRIBUTES];
+  size_t offset;
+  uint8_t *data;
+  int i;
+
+  if (indices->len == 0)
+    return;
+
+  /* The indices are expanded while copying so that the draw doesn't
+     need an index buffer either */
+  data = _cogl_stream_buffer_map (ctx->stream_buffer,
+                                  vertex_size * indices->len,
+                                  &attribute_buffer,
+                                  &offset);
+  for (i = 0; i < indices->len; i++)
+    {
+      unsigned int index =
+        _cogl_path_tesselator_get_index (indices_type, indices, i);
+
+      memcpy (data + i * vertex_size,
+              vertices->data + index * vertex_size,
+              vertex_size);
+    }
+  _cogl_stream_buffer_unmap (ctx->stream_buffer);
+
+  attributes[0] = cogl_attribute_new (attribute_buffer,
+                                      "cogl_position_in",
+                                      vertex_size,
+                                      offset,
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  if (n_attributes > 1)
+    attributes[1] = cogl_attribute_new (attribute_buffer,
+                                        "cogl_tex_coord0_in",
+                                        vertex_size,
+                                        offset + sizeof (float) * 2,
+                                        2, /* n_components */
+                                        COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  _cogl_framebuffer_draw_attributes (framebuffer,
+                                     pipeline,
+                                     mode,
+                                     0, /* first_vertex */
+                                     indices->len,
+                                     attributes,
+                                     n_attributes,
+                                     flags);
+
+  for (i = 0; i < n_attributes; i++)
+    cogl_object_unref (attributes[i]);
+
+  _cogl_stream_buffer_release (ctx->stream_buffer);
+}
+
+static void
+_cogl_path_draw_fill_streamed (CoglPathTessellation *tessellation,
+                               CoglFramebuffer *framebuffer,
+                               CoglPipeline *pipeline,
+                               CoglDrawFlags flags)
+{
+  _cogl_path_draw_streamed (framebuffer,
+                            pipeline,
+                            flags,
+                            COGL_VERTICES_MODE_TRIANGLES,
+                            tessellation->fill_vertices,
+                            sizeof (CoglPathTesselatorVertex),
+                            COGL_PATH_N_ATTRIBUTES,
+                            tessellation->fill_indices_type,
+                            tessellation->fill_indices);
+}
+
+/* Estimates how many window pixels one unit of the path's coordinate
+   space covers around the middle of the path. This is only exact for
+   affine transforms but it's good enough to pick how finely the
+   curves need to be flattened */
+static float
+_cogl_path_get_scale (CoglPath *path,
+                      CoglMatrixEntry *modelview_entry,
+                      CoglMatrixEntry *projection_entry,
+                      const float *viewport)
+{
+  CoglPathData *data = path->data;
+  CoglMatrix modelview, projection, transform;
+  float center_x, center_y;
+  float window[3][2];
+  float dx, dy;
+  float scale_x, scale_y;
+  int i;
+
+  cogl_matrix_entry_get (modelview_entry, &modelview);
+  cogl_matrix_entry_get (projection_entry, &projection);
+  cogl_matrix_multiply (&transform, &projection, &modelview);
+
+  center_x = (data->path_nodes_min.x + data->path_nodes_max.x) / 2.0f;
+  center_y = (data->path_nodes_min.y + data->path_nodes_max.y) / 2.0f;
+
+  /* Project the center and a unit step along each axis */
+  for (i = 0; i < 3; i++)
+    {
+      float x = center_x + (i == 1 ? 1.0f : 0.0f);
+      float y = center_y + (i == 2 ? 1.0f : 0.0f);
+      float z = 0.0f;
+      float w = 1.0f;
+
+      cogl_matrix_transform_point (&transform, &x, &y, &z, &w);
+
+      /* The point is behind the viewer so there's no sensible scale */
+      if (w <= 0.0f)
+        return 1.0f;
+
+      window[i][0] = x / w * viewport[2] / 2.0f;
+      window[i][1] = y / w * viewport[3] / 2.0f;
+    }
+
+  dx = window[1][0] - window[0][0];
+  dy = window[1][1] - window[0][1];
+  scale_x = sqrtf (dx * dx + dy * dy);
+
+  dx = window[2][0] - window[0][0];
+  dy = window[2][1] - window[0][1];
+  scale_y = sqrtf (dx * dx + dy * dy);
+
+  return MAX (scale_x, scale_y);
+}
+
+static int
+_cogl_path_get_scale_bucket (float scale)
+{
+  int bucket;
+
+  /* This also catches NaNs from degenerate transforms */
+  if (!(scale > 0.0f))
+    return 0;
+
+  /* Quantize the scale into half-octaves. This rounds up so that the
+     curves are never flattened more coarsely than the actual scale
+     needs. The small bias stops rounding errors in an untransformed
+     2D setup from tipping a scale of 1 into the next bucket */
+  bucket = ceilf (log2f (scale) * 2.0f - 0.01f);
+
+  return CLAMP (bucket,
+                -_COGL_PATH_MAX_SCALE_BUCKET,
+                _COGL_PATH_MAX_SCALE_BUCKET);
+}
 
-  return path->data->fill_primitive;
+static float
+_cogl_path_get_tolerance_for_bucket (int scale_bucket)
+{
+  return powf (2.0f, -scale_bucket / 2.0f);
+}
+
+static CoglPathTessellation *
+_cogl_path_get_tessellation (CoglPath *path,
+                             CoglBool scale_dependent,
+                             CoglMatrixEntry *modelview_entry,
+                             CoglMatrixEntry *projection_entry,
+                             const float *viewport)
+{
+  CoglPathData *data = path->data;
+  CoglPathTessellation *tessellation;
+  int scale_bucket;
+  int slot = 0;
+  int i;
+
+  /* If there are no curves then the geometry is usually the same at
+     any scale so we don't need to bother looking at the transform */
+  if (!scale_dependent)
+    scale_bucket = 0;
+  else
+    scale_bucket =
+      _cogl_path_get_scale_bucket (_cogl_path_get_scale (path,
+                                                         modelview_entry,
+                                                         projection_entry,
+                                                         viewport));
+
+  for (i = 0; i < COGL_PATH_N_TESSELLATIONS; i++)
+    {
+      tessellation = data->tessellations[i];
+
+      if (tessellation == NULL)
+        {
+          slot = i;
+          break;
+        }
+
+      if (tessellation->scale_bucket == scale_bucket)
+        {
+          tessellation->age = ++data->tessellation_age;
+          return tessellation;
+        }
+
+      /* Otherwise remember the least recently used entry to replace */
+      if (tessellation->age < data->tessellations[slot]->age)
+        slot = i;
+    }
+
+  if (data->tessellations[slot])
+    _cogl_path_tessellation_free (data->tessellations[slot]);
+
+  tessellation = u_slice_new0 (CoglPathTessellation);
+  tessellation->scale_bucket = scale_bucket;
+  tessellation->age = ++data->tessellation_age;
+
+  /* A curve is flat enough when its control points are within a
+     pixel of the chord, so at a scale of 1 this is the same
+     tolerance that was always used */
+  if (data->n_curves > 0)
+    tessellation->path_nodes =
+      _cogl_path_flatten_nodes (data,
+                                _cogl_path_get_tolerance_for_bucket
+                                (scale_bucket));
+
+  data->tessellations[slot] = tessellation;
+
+  return tessellation;
+}
+
+static CoglPathTessellation *
+_cogl_path_get_tessellation_for_framebuffer (CoglPath *path,
+                                             CoglBool scale_dependent,
+                                             CoglFramebuffer *framebuffer)
+{
+  float viewport[4];
+
+  cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
+
+  return _cogl_path_get_tessellation (path,
+                                      scale_dependent,
+                                      _cogl_framebuffer_get_modelview_entry
+                                      (framebuffer),
+                                      _cogl_framebuffer_get_projection_entry
+                                      (framebuffer),
+                                      viewport);
 }
 
 static CoglClipStack *
@@ -1444,7 +2176,14 @@ _cogl_clip_stack_push_from_path (CoglClipStack *stack,
                                             viewport);
   else
     {
-      CoglPrimitive *primitive = _cogl_path_get_fill_primitive (path);
+      CoglPathTessellation *tessellation =
+        _cogl_path_get_tessellation (path,
+                                     path->data->n_curves > 0,
+                                     modelview_entry,
+                                     projection_entry,
+                                     viewport);
+      CoglPrimitive *primitive =
+        _cogl_path_get_fill_primitive (path, tessellation);
 
       return _cogl_clip_stack_push_primitive (stack,
                                               primitive,
@@ -1485,65 +2224,118 @@ cogl_framebuffer_push_path_clip (CoglFramebuffer *framebuffer,
 }
 
 static void
-_cogl_path_build_stroke_attribute_buffer (CoglPath *path)
+_cogl_path_build_stroke_geometry (CoglPath *path,
+                                  CoglPathTessellation *tessellation)
 {
   CoglPathData *data = path->data;
-  CoglBuffer *buffer;
-  unsigned int n_attributes = 0;
-  unsigned int path_start;
-  CoglPathNode *node;
-  floatVec2 *buffer_p;
-  unsigned int i;
+  UArray *path_nodes;
+  float tolerance;
+
+  path_nodes = (tessellation->path_nodes ?
+                tessellation->path_nodes :
+                data->path_nodes);
+
+  tolerance = (_COGL_PATH_STROKE_TOLERANCE *
+               _cogl_path_get_tolerance_for_bucket
+               (tessellation->scale_bucket));
+
+  tessellation->stroke_vertices =
+    u_array_new (FALSE, FALSE, sizeof (floatVec2));
+  tessellation->stroke_indices =
+    u_array_new (FALSE, FALSE, sizeof (uint32_t));
+
+  _cogl_path_stroker_stroke (&data->stroke_style,
+                             path_nodes,
+                             tolerance,
+                             tessellation->stroke_vertices,
+                             tessellation->stroke_indices);
+}
 
-  /* If we've already got a cached vbo then we don't need to do anything */
-  if (data->stroke_attribute_buffer)
-    return;
+static CoglPrimitive *
+_cogl_path_get_stroke_primitive (CoglPath *path,
+                                 CoglPathTessellation *tessellation)
+{
+  CoglPathData *data = path->data;
+  CoglAttributeBuffer *attribute_buffer;
+  CoglAttribute *attribute;
+  CoglIndices *indices;
+  CoglIndicesType indices_type;
+  UArray *vertices;
+  UArray *index_array;
 
-  data->stroke_attribute_buffer =
-    cogl_attribute_buffer_new_with_size (data->context,
-                                         data->path_nodes->len *
-                                         sizeof (floatVec2));
+  if (tessellation->stroke_built)
+    return tessellation->stroke_primitive;
 
-  buffer = COGL_BUFFER (data->stroke_attribute_buffer);
-  buffer_p = _cogl_buffer_map_for_fill_or_fallback (buffer);
+  tessellation->stroke_built = TRUE;
 
-  /* Copy the vertices in and count the number of sub paths. Each sub
-     path will form a separate attribute so we can paint the disjoint
-     line strips */
-  for (path_start = 0;
-       path_start < data->path_nodes->len;
-       path_start += node->path_size)
-    {
-      node = &u_array_index (data->path_nodes, CoglPathNode, path_start);
+  if (tessellation->stroke_vertices == NULL)
+    _cogl_path_build_stroke_geometry (path, tessellation);
 
-      for (i = 0; i < node->path_size; i++)
-        {
-          buffer_p[path_start + i].x = node[i].x;
-          buffer_p[path_start + i].y = node[i].y;
-        }
+  vertices = tessellation->stroke_vertices;
+  index_array = tessellation->stroke_indices;
+  tessellation->stroke_vertices = NULL;
+  tessellation->stroke_indices = NULL;
 
-      n_attributes++;
-    }
+  if (index_array->len == 0)
+    goto done;
 
-  _cogl_buffer_unmap_for_fill_or_fallback (buffer);
+  attribute_buffer =
+    cogl_attribute_buffer_new (data->context,
+                               vertices->len * sizeof (floatVec2),
+                               vertices->data);
+  attribute = cogl_attribute_new (attribute_buffer,
+                                  "cogl_position_in",
+                                  sizeof (floatVec2),
+                                  0, /* offset */
+                                  2, /* n_components */
+                                  COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  /* Pack the indices into the smallest type that can hold them */
+  indices_type =
+    _cogl_path_tesselator_get_indices_type_for_size (vertices->len);
+  if (indices_type == COGL_INDICES_TYPE_UNSIGNED_INT)
+    indices = cogl_indices_new (data->context,
+                                indices_type,
+                                index_array->data,
+                                index_array->len);
+  else
+    {
+      CoglPathTesselator tess;
+      int i;
 
-  data->stroke_attributes = u_new (CoglAttribute *, n_attributes);
+      tess.indices_type = indices_type;
+      _cogl_path_tesselator_allocate_indices_array (&tess);
 
-  /* Now we can loop the sub paths again to create the attributes */
-  for (i = 0, path_start = 0;
-       path_start < data->path_nodes->len;
-       i++, path_start += node->path_size)
-    {
-      node = &u_array_index (data->path_nodes, CoglPathNode, path_start);
+      for (i = 0; i < index_array->len; i++)
+        _cogl_path_tesselator_add_index (&tess,
+                                         u_array_index (index_array,
+                                                        uint32_t, i));
+
+      indices = cogl_indices_new (data->context,
+                                  indices_type,
+                                  tess.indices->data,
+                                  tess.indices->len);
 
-      data->stroke_attributes[i] =
-        cogl_attribute_new (data->stroke_attribute_buffer,
-                            "cogl_position_in",
-                            sizeof (floatVec2),
-                            path_start * sizeof (floatVec2),
-                            2, /* n_components */
-                            COGL_ATTRIBUTE_TYPE_FLOAT);
+      u_array_free (tess.indices, TRUE);
     }
 
-  data->stroke_n_attributes = n_attributes;
+  tessellation->stroke_primitive =
+    cogl_primitive_new_with_attributes (_cogl_path_get_stroke_mode (data),
+                                        index_array->len,
+                                        &attribute,
+                                        1);
+  cogl_primitive_set_indices (tessellation->stroke_primitive,
+                              indices,
+                              index_array->len);
+
+  /* The primitive keeps its own references */
+  cogl_object_unref (indices);
+  cogl_object_unref (attribute);
+  cogl_object_unref (attribute_buffer);
+
+ done:
+  u_array_free (vertices, TRUE);
+  u_array_free (index_array, TRUE);
+
+  return tessellation->stroke_primitive;
 }
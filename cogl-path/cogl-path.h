@@ -466,6 +466,209 @@ cogl_path_set_fill_rule (CoglPath *path, CoglPathFillRule fill_rule);
 CoglPathFillRule
 cogl_path_get_fill_rule (CoglPath *path);
 
+/**
+ * CoglPathLineJoin:
+ * @COGL_PATH_LINE_JOIN_MITER: The outer edges of the two segments are
+ *   extended until they meet at a sharp corner. If the corner would
+ *   be longer than the miter limit then a bevel join is used instead.
+ * @COGL_PATH_LINE_JOIN_ROUND: The corner is rounded off with a circle
+ *   centered on the joining point.
+ * @COGL_PATH_LINE_JOIN_BEVEL: The corner is cut off with a straight
+ *   line across the outer edges of the two segments.
+ *
+ * #CoglPathLineJoin specifies how two connected segments of a stroked
+ * path are joined when the stroke is wider than a hairline.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+typedef enum {
+  COGL_PATH_LINE_JOIN_MITER,
+  COGL_PATH_LINE_JOIN_ROUND,
+  COGL_PATH_LINE_JOIN_BEVEL
+} CoglPathLineJoin;
+
+/**
+ * CoglPathLineCap:
+ * @COGL_PATH_LINE_CAP_BUTT: The stroke stops exactly at the end point.
+ * @COGL_PATH_LINE_CAP_ROUND: The end of the stroke is a semi-circle
+ *   centered on the end point.
+ * @COGL_PATH_LINE_CAP_SQUARE: The stroke is extended past the end
+ *   point by half of the stroke width.
+ *
+ * #CoglPathLineCap specifies how the ends of open sub-paths and of
+ * dashes are drawn when the stroke is wider than a hairline.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+typedef enum {
+  COGL_PATH_LINE_CAP_BUTT,
+  COGL_PATH_LINE_CAP_ROUND,
+  COGL_PATH_LINE_CAP_SQUARE
+} CoglPathLineCap;
+
+/**
+ * cogl_path_set_stroke_width:
+ * @path: A #CoglPath
+ * @width: The width of the stroke in the coordinate space of the path
+ *
+ * Sets the width used when the path is stroked with
+ * cogl_path_stroke(). The width is transformed along with the path.
+ * A width of 0 gives a hairline which is always 1 pixel wide
+ * regardless of the transformation. The default width is 0.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_path_set_stroke_width (CoglPath *path,
+                            float width);
+
+/**
+ * cogl_path_get_stroke_width:
+ * @path: A #CoglPath
+ *
+ * Return value: the stroke width set with cogl_path_set_stroke_width().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+float
+cogl_path_get_stroke_width (CoglPath *path);
+
+/**
+ * cogl_path_set_line_join:
+ * @path: A #CoglPath
+ * @line_join: The new join style
+ *
+ * Sets how connected segments are joined when the path is stroked.
+ * The default is %COGL_PATH_LINE_JOIN_MITER.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_path_set_line_join (CoglPath *path,
+                         CoglPathLineJoin line_join);
+
+/**
+ * cogl_path_get_line_join:
+ * @path: A #CoglPath
+ *
+ * Return value: the join style set with cogl_path_set_line_join().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglPathLineJoin
+cogl_path_get_line_join (CoglPath *path);
+
+/**
+ * cogl_path_set_line_cap:
+ * @path: A #CoglPath
+ * @line_cap: The new cap style
+ *
+ * Sets how the ends of open sub-paths and dashes are drawn when the
+ * path is stroked. The default is %COGL_PATH_LINE_CAP_BUTT.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_path_set_line_cap (CoglPath *path,
+                        CoglPathLineCap line_cap);
+
+/**
+ * cogl_path_get_line_cap:
+ * @path: A #CoglPath
+ *
+ * Return value: the cap style set with cogl_path_set_line_cap().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglPathLineCap
+cogl_path_get_line_cap (CoglPath *path);
+
+/**
+ * cogl_path_set_miter_limit:
+ * @path: A #CoglPath
+ * @miter_limit: The maximum ratio of the miter length to the stroke
+ *   width
+ *
+ * Sets the limit used to decide whether a %COGL_PATH_LINE_JOIN_MITER
+ * join is drawn as a miter or a bevel. If the distance from the
+ * joining point to the tip of the miter divided by half of the stroke
+ * width is greater than @miter_limit then a bevel is used instead. The
+ * default is 10.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_path_set_miter_limit (CoglPath *path,
+                           float miter_limit);
+
+/**
+ * cogl_path_get_miter_limit:
+ * @path: A #CoglPath
+ *
+ * Return value: the miter limit set with cogl_path_set_miter_limit().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+float
+cogl_path_get_miter_limit (CoglPath *path);
+
+/**
+ * cogl_path_set_dash:
+ * @path: A #CoglPath
+ * @dashes: (array length=n_dashes) (allow-none): The lengths of the
+ *   alternating on and off parts of the dash pattern
+ * @n_dashes: The number of lengths in @dashes
+ * @offset: How far into the pattern the stroke starts
+ *
+ * Sets a dash pattern to use when the path is stroked. The first
+ * length in @dashes is drawn, the next is skipped and so on. If
+ * @n_dashes is odd then the pattern is effectively repeated twice so
+ * that the on and off parts swap on the second repetition. The
+ * lengths are in the coordinate space of the path. Each visible dash
+ * gets the caps set with cogl_path_set_line_cap().
+ *
+ * Passing 0 for @n_dashes turns off dashing, which is the default.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_path_set_dash (CoglPath *path,
+                    const float *dashes,
+                    int n_dashes,
+                    float offset);
+
+/**
+ * cogl_path_get_dash:
+ * @path: A #CoglPath
+ * @n_dashes: (out): Return location for the number of lengths in the
+ *   pattern
+ * @offset: (out) (allow-none): Return location for the dash offset
+ *
+ * Retrieves the dash pattern set with cogl_path_set_dash().
+ *
+ * Return value: (array length=n_dashes): The lengths of the pattern.
+ *   This is owned by the path and is only valid until the path is
+ *   next modified.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+const float *
+cogl_path_get_dash (CoglPath *path,
+                    int *n_dashes,
+                    float *offset);
+
 /**
  * cogl_framebuffer_fill_path:
  * @path: The #CoglPath to fill
@@ -496,14 +699,20 @@ cogl_path_fill (CoglPath *path,
  * @framebuffer: A #CoglFramebuffer
  * @pipeline: A #CoglPipeline to render with
  *
- * Draws a list of line primitives corresponding to the edge of the
- * given @path using the specified GPU @pipeline to the given
- * @framebuffer.
+ * Draws the outline of the given @path using the specified GPU
+ * @pipeline to the given @framebuffer.
+ *
+ * The stroke uses the width, joins, caps and dash pattern set on the
+ * path. If the width is 0 the outline is drawn as lines with a width
+ * of 1 pixel regardless of the current transformation matrix.
+ * Otherwise the stroke is tessellated into triangles. All of the
+ * sub-paths are drawn with a single primitive which is cached until
+ * the path is modified.
  *
- * <note>Cogl does not provide any sophisticated path stroking
- * features for things like stroke width, dashes or caps. The stroke
- * line will have a width of 1 pixel regardless of the current
- * transformation matrix.</note>
+ * <note>Parts of a wide stroke that overlap, such as the joins, are
+ * drawn more than once. Strokes drawn with a translucent pipeline may
+ * therefore look darker where the path crosses itself or turns
+ * sharply.</note>
  *
  * Since: 2.0
  */
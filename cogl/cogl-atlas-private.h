@@ -38,7 +38,10 @@
 typedef enum
 {
   COGL_ATLAS_CLEAR_TEXTURE     = (1 << 0),
-  COGL_ATLAS_DISABLE_MIGRATION = (1 << 1)
+  COGL_ATLAS_DISABLE_MIGRATION = (1 << 1),
+  COGL_ATLAS_SKYLINE_PACKING   = (1 << 2),
+  COGL_ATLAS_GROW_IN_PLACE     = (1 << 3),
+  COGL_ATLAS_DISABLE_GROWTH    = (1 << 4)
 } CoglAtlasFlags;
 
 struct _CoglAtlas
@@ -46,6 +46,8 @@ struct _CoglAtlasSet
   USList *atlases;
 
   CoglTextureComponents components;
+  CoglAtlasPacking packing;
+  CoglAtlasGrowth growth;
   CoglPixelFormat internal_format;
 
   CoglList atlas_closures;
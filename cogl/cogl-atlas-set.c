@@ -85,6 +85,8 @@ cogl_atlas_set_new (CoglContext *context)
 
   set->clear_enabled = FALSE;
   set->migration_enabled = TRUE;
+  set->packing = COGL_ATLAS_PACKING_BINARY_TREE;
+  set->growth = COGL_ATLAS_GROWTH_REPACK;
 
   _cogl_list_init (&set->atlas_closures);
 
@@ -154,6 +156,36 @@ cogl_atlas_set_get_migration_enabled (CoglAtlasSet *set)
   return set->migration_enabled;
 }
 
+void
+cogl_atlas_set_set_packing (CoglAtlasSet *set,
+                            CoglAtlasPacking packing)
+{
+  _COGL_RETURN_IF_FAIL (set->atlases == NULL);
+
+  set->packing = packing;
+}
+
+CoglAtlasPacking
+cogl_atlas_set_get_packing (CoglAtlasSet *set)
+{
+  return set->packing;
+}
+
+void
+cogl_atlas_set_set_growth (CoglAtlasSet *set,
+                           CoglAtlasGrowth growth)
+{
+  _COGL_RETURN_IF_FAIL (set->atlases == NULL);
+
+  set->growth = growth;
+}
+
+CoglAtlasGrowth
+cogl_atlas_set_get_growth (CoglAtlasSet *set)
+{
+  return set->growth;
+}
+
 CoglAtlasSetAtlasClosure *
 cogl_atlas_set_add_atlas_callback (CoglAtlasSet *set,
                                    CoglAtlasSetAtlasCallback callback,
@@ -205,6 +237,21 @@ cogl_atlas_set_allocate_space (CoglAtlasSet *set,
   if (!set->migration_enabled)
     flags |= COGL_ATLAS_DISABLE_MIGRATION;
 
+  if (set->packing == COGL_ATLAS_PACKING_SKYLINE)
+    flags |= COGL_ATLAS_SKYLINE_PACKING;
+
+  switch (set->growth)
+    {
+    case COGL_ATLAS_GROWTH_REPACK:
+      break;
+    case COGL_ATLAS_GROWTH_EXTEND:
+      flags |= COGL_ATLAS_GROW_IN_PLACE;
+      break;
+    case COGL_ATLAS_GROWTH_NEW_ATLAS:
+      flags |= COGL_ATLAS_DISABLE_GROWTH;
+      break;
+    }
+
   atlas = _cogl_atlas_new (set->context,
                            set->internal_format,
                            flags);
@@ -257,6 +304,15 @@ cogl_atlas_set_allocate_space (CoglAtlasSet *set,
   return atlas;
 }
 
+void
+cogl_atlas_set_compact (CoglAtlasSet *set)
+{
+  USList *l;
+
+  for (l = set->atlases; l; l = l->next)
+    cogl_atlas_compact (l->data);
+}
+
 void
 cogl_atlas_set_foreach (CoglAtlasSet *atlas_set,
                         CoglAtlasSetForeachCallback callback,
@@ -73,6 +73,15 @@
  * cogl_atlas_set_set_migration_enabled(). With migrations disabled
  * then previous allocations will be re-allocated space in any
  * replacement texture, but no image data will be copied.
+ *
+ * The algorithm used to pack allocations into each texture can be
+ * chosen with cogl_atlas_set_set_packing().
+ *
+ * Moving every allocation to a new texture can cause a noticeable
+ * stall so instead of that cogl_atlas_set_set_growth() can make the
+ * set extend the texture in place or start a new atlas when one is
+ * full. The allocations can then be repacked at a convenient time
+ * with cogl_atlas_set_compact().
  */
 typedef struct _CoglAtlasSet CoglAtlasSet;
 
@@ -117,6 +126,127 @@ cogl_atlas_set_set_migration_enabled (CoglAtlasSet *set,
 CoglBool
 cogl_atlas_set_get_migration_enabled (CoglAtlasSet *set);
 
+/**
+ * CoglAtlasPacking:
+ * @COGL_ATLAS_PACKING_BINARY_TREE: Recursively splits the free space
+ *   of each atlas into two. This copes well with allocations of
+ *   widely varying sizes.
+ * @COGL_ATLAS_PACKING_SKYLINE: Packs allocations in rows along the
+ *   top edge of the used space. This is faster and wastes less space
+ *   when most allocations are a similar size, such as glyphs.
+ *
+ * The algorithms that can be used to pack allocations into the
+ * textures of a #CoglAtlasSet.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+typedef enum _CoglAtlasPacking
+{
+  COGL_ATLAS_PACKING_BINARY_TREE,
+  COGL_ATLAS_PACKING_SKYLINE
+} CoglAtlasPacking;
+
+/**
+ * cogl_atlas_set_set_packing:
+ * @set: A #CoglAtlasSet
+ * @packing: The #CoglAtlasPacking algorithm to use
+ *
+ * Sets the algorithm used to pack allocations into the atlases of
+ * @set. This can't be changed once you start allocating from the
+ * set. The default is %COGL_ATLAS_PACKING_BINARY_TREE.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_atlas_set_set_packing (CoglAtlasSet *set,
+                            CoglAtlasPacking packing);
+
+/**
+ * cogl_atlas_set_get_packing:
+ * @set: A #CoglAtlasSet
+ *
+ * Return value: The #CoglAtlasPacking algorithm used by @set
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglAtlasPacking
+cogl_atlas_set_get_packing (CoglAtlasSet *set);
+
+/**
+ * CoglAtlasGrowth:
+ * @COGL_ATLAS_GROWTH_REPACK: Packs all of the allocations together
+ *   with the new one into a new texture, doubling its size if needed.
+ *   This keeps the atlases compact but every allocation is copied to
+ *   its new position.
+ * @COGL_ATLAS_GROWTH_EXTEND: Doubles the size of the texture and
+ *   copies the old contents to its top-left corner in a single blit.
+ *   Existing allocations keep their positions.
+ * @COGL_ATLAS_GROWTH_NEW_ATLAS: Never grows an atlas once it has been
+ *   created. New allocations that don't fit go into another atlas of
+ *   the set.
+ *
+ * What a #CoglAtlasSet does when there isn't enough space in any of
+ * its atlases for a new allocation.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+typedef enum _CoglAtlasGrowth
+{
+  COGL_ATLAS_GROWTH_REPACK,
+  COGL_ATLAS_GROWTH_EXTEND,
+  COGL_ATLAS_GROWTH_NEW_ATLAS
+} CoglAtlasGrowth;
+
+/**
+ * cogl_atlas_set_set_growth:
+ * @set: A #CoglAtlasSet
+ * @growth: The #CoglAtlasGrowth mode to use
+ *
+ * Sets how the atlases of @set make room for allocations that don't
+ * fit. This can't be changed once you start allocating from the set.
+ * The default is %COGL_ATLAS_GROWTH_REPACK.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_atlas_set_set_growth (CoglAtlasSet *set,
+                           CoglAtlasGrowth growth);
+
+/**
+ * cogl_atlas_set_get_growth:
+ * @set: A #CoglAtlasSet
+ *
+ * Return value: The #CoglAtlasGrowth mode used by @set
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglAtlasGrowth
+cogl_atlas_set_get_growth (CoglAtlasSet *set);
+
+/**
+ * cogl_atlas_set_compact:
+ * @set: A #CoglAtlasSet
+ *
+ * Repacks the allocations of every atlas in @set to remove any
+ * fragmentation, possibly into a smaller texture. Allocations are
+ * moved in the same way as when an atlas grows with
+ * %COGL_ATLAS_GROWTH_REPACK so the allocate callbacks will be
+ * invoked. This is mostly useful with the other growth modes and can
+ * be called at a time when a stall won't be noticed, such as after
+ * loading a new screen.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_atlas_set_compact (CoglAtlasSet *set);
+
 
 void
 cogl_atlas_set_clear (CoglAtlasSet *set);
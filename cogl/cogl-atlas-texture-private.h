@@ -55,6 +55,10 @@ struct _CoglAtlasTexture
      atlas by the texture (but not vice versa so there is no cycle) */
   CoglAtlas            *atlas;
 
+  /* Set while the texture holds a reference on itself for the
+     duration of a reorganization of its atlas */
+  CoglBool              reorganizing;
+
   /* Either a CoglSubTexture representing the atlas region for easy
    * rendering or if the texture has been migrated out of the atlas it
    * may be some other texture type such as CoglTexture2D */
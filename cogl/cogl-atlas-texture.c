@@ -90,9 +90,16 @@ _cogl_atlas_texture_allocate_cb (CoglAtlas *atlas,
   atlas_tex->sub_texture = COGL_TEXTURE (
     _cogl_atlas_texture_create_sub_texture (texture, allocation));
 
-  /* Update the position */
+  /* Update the position. The callback is also invoked for textures
+     that are already in the atlas when it is reorganized so the
+     reference is only taken the first time */
   atlas_tex->allocation = *allocation;
-  atlas_tex->atlas = cogl_object_ref (atlas);
+  if (atlas_tex->atlas != atlas)
+    {
+      if (atlas_tex->atlas)
+        cogl_object_unref (atlas_tex->atlas);
+      atlas_tex->atlas = cogl_object_ref (atlas);
+    }
 }
 
 static void
@@ -107,6 +114,7 @@ _cogl_atlas_texture_pre_reorganize_foreach_cb
   /* Keep a reference to the texture because we don't want it to be
      destroyed during the reorganization */
   cogl_object_ref (atlas_tex);
+  atlas_tex->reorganizing = TRUE;
 }
 
 static void
@@ -171,12 +179,14 @@ _cogl_atlas_texture_post_reorganize_cb (CoglAtlas *atlas,
 
       for (i = 0; i < data.n_textures; i++)
         {
-          /* Ignore textures that don't have an atlas yet. This will
-             happen when a new texture is added because we allocate
-             the structure for the texture so that it can get stored
-             in the atlas but it isn't a valid object yet */
-          if (data.textures[i]->atlas)
-            cogl_object_unref (data.textures[i]);
+          /* Ignore the texture that caused the reorganization. It
+             was added to the atlas after the references were taken
+             so it doesn't have one to remove */
+          if (data.textures[i]->reorganizing)
+            {
+              data.textures[i]->reorganizing = FALSE;
+              cogl_object_unref (data.textures[i]);
+            }
         }
     }
 }
@@ -652,9 +662,10 @@ _cogl_atlas_texture_create_base (CoglContext *ctx,
   /* We need to allocate the texture now because we need the pointer
      to set as the data for the rectangle in the atlas */
   atlas_tex = u_new0 (CoglAtlasTexture, 1);
-  /* Mark it as having no atlas so we don't try to unref it in
-     _cogl_atlas_texture_post_reorganize_cb */
+  /* Mark it as having no atlas and no reference for
+     _cogl_atlas_texture_post_reorganize_cb to remove */
   atlas_tex->atlas = NULL;
+  atlas_tex->reorganizing = FALSE;
 
   _cogl_texture_init (COGL_TEXTURE (atlas_tex),
                       ctx,
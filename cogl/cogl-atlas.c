@@ -209,13 +209,12 @@ _cogl_atlas_get_next_size (int *map_width,
     *map_height <<= 1;
 }
 
-static void
-_cogl_atlas_get_initial_size (CoglAtlas *atlas,
-                              int *map_width,
-                              int *map_height)
+static CoglBool
+_cogl_atlas_size_supported (CoglAtlas *atlas,
+                            int width,
+                            int height)
 {
   CoglContext *ctx = atlas->context;
-  unsigned int size;
   GLenum gl_intformat;
   GLenum gl_format;
   GLenum gl_type;
@@ -226,6 +225,21 @@ _cogl_atlas_get_initial_size (CoglAtlas *atlas,
                                           &gl_format,
                                           &gl_type);
 
+  return ctx->texture_driver->size_supported (ctx,
+                                              GL_TEXTURE_2D,
+                                              gl_intformat,
+                                              gl_format,
+                                              gl_type,
+                                              width, height);
+}
+
+static void
+_cogl_atlas_get_initial_size (CoglAtlas *atlas,
+                              int *map_width,
+                              int *map_height)
+{
+  unsigned int size;
+
   /* At least on Intel hardware, the texture size will be rounded up
      to at least 1MB so we might as well try to aim for that as an
      initial minimum size. If the format is only 1 byte per pixel we
@@ -238,13 +252,7 @@ _cogl_atlas_get_initial_size (CoglAtlas *atlas,
 
   /* Some platforms might not support this large size so we'll
      decrease the size until it can */
-  while (size > 1 &&
-         !ctx->texture_driver->size_supported (ctx,
-                                               GL_TEXTURE_2D,
-                                               gl_intformat,
-                                               gl_format,
-                                               gl_type,
-                                               size, size))
+  while (size > 1 && !_cogl_atlas_size_supported (atlas, size, size))
     size >>= 1;
 
   *map_width = size;
@@ -258,29 +266,20 @@ _cogl_atlas_create_map (CoglAtlas *atlas,
                         int n_textures,
                         CoglAtlasRepositionData *textures)
 {
-  CoglContext *ctx = atlas->context;
-  GLenum gl_intformat;
-  GLenum gl_format;
-  GLenum gl_type;
-
-  ctx->driver_vtable->pixel_format_to_gl (ctx,
-                                          atlas->internal_format,
-                                          &gl_intformat,
-                                          &gl_format,
-                                          &gl_type);
+  CoglRectangleMapType rectangle_map_type =
+    ((atlas->flags & COGL_ATLAS_SKYLINE_PACKING) ?
+     COGL_RECTANGLE_MAP_TYPE_SKYLINE :
+     COGL_RECTANGLE_MAP_TYPE_TREE);
 
   /* Keep trying increasingly larger atlases until we can fit all of
      the textures */
-  while (ctx->texture_driver->size_supported (ctx,
-                                              GL_TEXTURE_2D,
-                                              gl_intformat,
-                                              gl_format,
-                                              gl_type,
-                                              map_width, map_height))
+  while (_cogl_atlas_size_supported (atlas, map_width, map_height))
     {
-      CoglRectangleMap *new_atlas = _cogl_rectangle_map_new (map_width,
-                                                             map_height,
-                                                             NULL);
+      CoglRectangleMap *new_atlas =
+        _cogl_rectangle_map_new_with_type (rectangle_map_type,
+                                           map_width,
+                                           map_height,
+                                           NULL);
       int i;
 
       COGL_NOTE (ATLAS, "Trying to resize the atlas to %ux%u",
@@ -386,49 +385,26 @@ _cogl_atlas_compare_size_cb (const void *a,
   return a_size < b_size ? 1 : a_size > b_size ? -1 : 0;
 }
 
-CoglBool
-_cogl_atlas_allocate_space (CoglAtlas *atlas,
-                            int width,
-                            int height,
-                            void *allocation_data)
+/* Sorts all of the allocations by size and packs them into a new
+   texture, blitting each one to its new position. If allocation_data
+   is not NULL then space for a new allocation of the given size is
+   made at the same time. Otherwise this is compacting the atlas so it
+   starts from the initial size and might end up smaller */
+static CoglBool
+_cogl_atlas_reorganize (CoglAtlas *atlas,
+                        int width,
+                        int height,
+                        void *allocation_data)
 {
   CoglAtlasGetRectanglesData data;
   CoglRectangleMap *new_map;
   CoglTexture2D *new_tex;
   int map_width, map_height;
   CoglBool ret;
-  CoglAtlasAllocation new_allocation;
-
-  /* Check if we can fit the rectangle into the existing map */
-  if (atlas->map &&
-      _cogl_rectangle_map_add (atlas->map, width, height,
-                               allocation_data,
-                               (CoglRectangleMapEntry *)&new_allocation))
-    {
-      COGL_NOTE (ATLAS, "%p: Atlas is %ix%i, has %i textures and is %i%% waste",
-                 atlas,
-                 _cogl_rectangle_map_get_width (atlas->map),
-                 _cogl_rectangle_map_get_height (atlas->map),
-                 _cogl_rectangle_map_get_n_rectangles (atlas->map),
-                 /* waste as a percentage */
-                 _cogl_rectangle_map_get_remaining_space (atlas->map) *
-                 100 / (_cogl_rectangle_map_get_width (atlas->map) *
-                        _cogl_rectangle_map_get_height (atlas->map)));
-
-      _cogl_closure_list_invoke (&atlas->allocate_closures,
-                                 CoglAtlasAllocateCallback,
-                                 atlas,
-                                 atlas->texture,
-                                 &new_allocation,
-                                 allocation_data);
 
-      return TRUE;
-    }
-
-  /* If we make it here then we need to reorganize the atlas. First
-     we'll notify any users of the atlas that this is going to happen
-     so that for example in CoglAtlasTexture it can notify that the
-     storage has changed and cause a flush */
+  /* First we'll notify any users of the atlas that this is going to
+     happen so that for example in CoglAtlasTexture it can notify that
+     the storage has changed and cause a flush */
   _cogl_closure_list_invoke (&atlas->pre_reorganize_closures,
                              CoglAtlasReorganizeCallback,
                              atlas);
@@ -450,11 +426,14 @@ _cogl_atlas_allocate_space (CoglAtlas *atlas,
 
   /* Add the new rectangle as a dummy texture so that it can be
      positioned with the rest */
-  data.textures[data.n_textures].old_position.x = 0;
-  data.textures[data.n_textures].old_position.y = 0;
-  data.textures[data.n_textures].old_position.width = width;
-  data.textures[data.n_textures].old_position.height = height;
-  data.textures[data.n_textures++].allocation_data = allocation_data;
+  if (allocation_data)
+    {
+      data.textures[data.n_textures].old_position.x = 0;
+      data.textures[data.n_textures].old_position.y = 0;
+      data.textures[data.n_textures].old_position.width = width;
+      data.textures[data.n_textures].old_position.height = height;
+      data.textures[data.n_textures++].allocation_data = allocation_data;
+    }
 
   /* The atlasing algorithm works a lot better if the rectangles are
      added in decreasing order of size so we'll first sort the
@@ -464,7 +443,7 @@ _cogl_atlas_allocate_space (CoglAtlas *atlas,
          _cogl_atlas_compare_size_cb);
 
   /* Try to create a new atlas that can contain all of the textures */
-  if (atlas->map)
+  if (atlas->map && allocation_data)
     {
       map_width = _cogl_rectangle_map_get_width (atlas->map);
       map_height = _cogl_rectangle_map_get_height (atlas->map);
@@ -564,13 +543,175 @@ _cogl_atlas_allocate_space (CoglAtlas *atlas,
 
   u_free (data.textures);
 
-  _cogl_closure_list_invoke (&atlas->pre_reorganize_closures,
+  _cogl_closure_list_invoke (&atlas->post_reorganize_closures,
                              CoglAtlasReorganizeCallback,
                              atlas);
 
   return ret;
 }
 
+static void
+_cogl_atlas_notify_allocation_cb (const CoglRectangleMapEntry *rectangle,
+                                  void *rect_data,
+                                  void *user_data)
+{
+  CoglAtlas *atlas = user_data;
+
+  _cogl_closure_list_invoke (&atlas->allocate_closures,
+                             CoglAtlasAllocateCallback,
+                             atlas,
+                             atlas->texture,
+                             (CoglAtlasAllocation *) rectangle,
+                             rect_data);
+}
+
+/* Makes space for a new allocation by replacing the texture with a
+   bigger one that has the old contents copied to its top-left corner
+   in a single blit. None of the existing allocations move */
+static CoglBool
+_cogl_atlas_extend (CoglAtlas *atlas,
+                    int width,
+                    int height,
+                    void *allocation_data)
+{
+  int old_width = _cogl_rectangle_map_get_width (atlas->map);
+  int old_height = _cogl_rectangle_map_get_height (atlas->map);
+  int map_width = old_width;
+  int map_height = old_height;
+  CoglAtlasAllocation new_allocation;
+  CoglTexture2D *new_tex;
+  CoglBool added;
+
+  /* Keep doubling the size until either the strip added to the right
+     or the one added to the bottom is big enough for the new
+     rectangle. Nothing else in the map can have space for it or it
+     would have already been added */
+  do
+    {
+      _cogl_atlas_get_next_size (&map_width, &map_height);
+
+      if (!_cogl_atlas_size_supported (atlas, map_width, map_height))
+        {
+          COGL_NOTE (ATLAS, "%p: Could not extend the atlas to fit texture",
+                     atlas);
+          return FALSE;
+        }
+    }
+  while ((width > map_width - old_width || height > old_height) &&
+         (width > map_width || height > map_height - old_height));
+
+  new_tex = _cogl_atlas_create_texture (atlas, map_width, map_height);
+  if (new_tex == NULL)
+    {
+      COGL_NOTE (ATLAS, "%p: Could not create a CoglTexture2D", atlas);
+      return FALSE;
+    }
+
+  COGL_NOTE (ATLAS, "%p: Atlas extended to %ix%i",
+             atlas, map_width, map_height);
+
+  _cogl_closure_list_invoke (&atlas->pre_reorganize_closures,
+                             CoglAtlasReorganizeCallback,
+                             atlas);
+
+  if (!(atlas->flags & COGL_ATLAS_DISABLE_MIGRATION))
+    {
+      CoglBlitData blit_data;
+
+      _cogl_blit_begin (&blit_data, COGL_TEXTURE (new_tex), atlas->texture);
+      _cogl_blit (&blit_data, 0, 0, 0, 0, old_width, old_height);
+      _cogl_blit_end (&blit_data);
+    }
+
+  cogl_object_unref (atlas->texture);
+  atlas->texture = COGL_TEXTURE (new_tex);
+
+  _cogl_rectangle_map_grow (atlas->map, map_width, map_height);
+
+  /* The allocations are in the same place but they need to know
+     about the new texture */
+  _cogl_rectangle_map_foreach (atlas->map,
+                               _cogl_atlas_notify_allocation_cb,
+                               atlas);
+
+  added = _cogl_rectangle_map_add (atlas->map, width, height,
+                                   allocation_data,
+                                   (CoglRectangleMapEntry *)&new_allocation);
+  u_assert (added);
+
+  _cogl_closure_list_invoke (&atlas->allocate_closures,
+                             CoglAtlasAllocateCallback,
+                             atlas,
+                             atlas->texture,
+                             &new_allocation,
+                             allocation_data);
+
+  _cogl_closure_list_invoke (&atlas->post_reorganize_closures,
+                             CoglAtlasReorganizeCallback,
+                             atlas);
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_atlas_allocate_space (CoglAtlas *atlas,
+                            int width,
+                            int height,
+                            void *allocation_data)
+{
+  CoglAtlasAllocation new_allocation;
+
+  /* Check if we can fit the rectangle into the existing map */
+  if (atlas->map &&
+      _cogl_rectangle_map_add (atlas->map, width, height,
+                               allocation_data,
+                               (CoglRectangleMapEntry *)&new_allocation))
+    {
+      COGL_NOTE (ATLAS, "%p: Atlas is %ix%i, has %i textures and is %i%% waste",
+                 atlas,
+                 _cogl_rectangle_map_get_width (atlas->map),
+                 _cogl_rectangle_map_get_height (atlas->map),
+                 _cogl_rectangle_map_get_n_rectangles (atlas->map),
+                 /* waste as a percentage */
+                 _cogl_rectangle_map_get_remaining_space (atlas->map) *
+                 100 / (_cogl_rectangle_map_get_width (atlas->map) *
+                        _cogl_rectangle_map_get_height (atlas->map)));
+
+      _cogl_closure_list_invoke (&atlas->allocate_closures,
+                                 CoglAtlasAllocateCallback,
+                                 atlas,
+                                 atlas->texture,
+                                 &new_allocation,
+                                 allocation_data);
+
+      return TRUE;
+    }
+
+  /* A new atlas always needs to go through _cogl_atlas_reorganize to
+     pick its initial size */
+  if (atlas->map == NULL)
+    return _cogl_atlas_reorganize (atlas, width, height, allocation_data);
+
+  /* Otherwise the atlas is full and how to make more space depends
+     on the growth mode */
+  if ((atlas->flags & COGL_ATLAS_DISABLE_GROWTH))
+    return FALSE;
+  else if ((atlas->flags & COGL_ATLAS_GROW_IN_PLACE))
+    return _cogl_atlas_extend (atlas, width, height, allocation_data);
+  else
+    return _cogl_atlas_reorganize (atlas, width, height, allocation_data);
+}
+
+void
+cogl_atlas_compact (CoglAtlas *atlas)
+{
+  if (atlas->map == NULL ||
+      _cogl_rectangle_map_get_n_rectangles (atlas->map) == 0)
+    return;
+
+  _cogl_atlas_reorganize (atlas, 0, 0, NULL);
+}
+
 void
 _cogl_atlas_remove (CoglAtlas *atlas,
                     int x,
@@ -71,6 +71,15 @@ cogl_atlas_remove_allocate_callback (CoglAtlas *atlas,
 CoglTexture *
 cogl_atlas_get_texture (CoglAtlas *atlas);
 
+/* Repacks all of the allocations into the smallest texture that can
+ * hold them, moving them around to remove any fragmentation. This is
+ * what the atlas does automatically when it runs out of space with
+ * %COGL_ATLAS_GROWTH_REPACK but with the other growth modes it only
+ * happens when this is called. It invokes the reorganize and allocate
+ * callbacks in the same way. */
+void
+cogl_atlas_compact (CoglAtlas *atlas);
+
 typedef void (*CoglAtlasForeachCallback) (CoglAtlas *atlas,
                                           const CoglAtlasAllocation *allocation,
                                           void *allocation_data,
@@ -75,6 +75,9 @@ struct _CoglAttribute
       size_t offset;
       int n_components;
       CoglAttributeType type;
+      /* The number of instances that share each value or 0 if the
+       * attribute isn't instanced */
+      int divisor;
     } buffered;
     struct {
       CoglContext *context;
@@ -83,6 +86,11 @@ struct _CoglAttribute
   } d;
 
   int immutable_ref;
+
+  /* Set by the driver when the attribute is referenced from a cached
+   * vertex array object so that it knows to discard it when the
+   * attribute changes */
+  CoglBool has_vertex_arrays;
 };
 
 typedef enum
@@ -99,7 +107,13 @@ typedef enum
   COGL_DRAW_COLOR_ATTRIBUTE_IS_OPAQUE = 1 << 3,
   /* This forcibly disables the debug option to divert all drawing to
    * wireframes */
-  COGL_DRAW_SKIP_DEBUG_WIREFRAME = 1 << 4
+  COGL_DRAW_SKIP_DEBUG_WIREFRAME = 1 << 4,
+  /* The attributes are expected to be drawn again with the same
+   * layout so the driver can cache the vertex array state for them
+   * instead of setting up each attribute for every draw. This is
+   * used for CoglPrimitives but not for transient attributes such as
+   * the ones created by the journal */
+  COGL_DRAW_CACHE_VERTEX_ARRAY = 1 << 5
 } CoglDrawFlags;
 
 /* During CoglContext initialization we register the "cogl_color_in"
@@ -135,5 +149,12 @@ _cogl_flush_attributes_state (CoglFramebuffer *framebuffer,
 int
 _cogl_attribute_get_n_components (CoglAttribute *attribute);
 
+void
+_cogl_attribute_invalidate_vertex_arrays (CoglAttribute *attribute);
+
+CoglBool
+_cogl_attributes_have_instance_divisor (CoglAttribute **attributes,
+                                        int n_attributes);
+
 #endif /* __COGL_ATTRIBUTE_PRIVATE_H */
 
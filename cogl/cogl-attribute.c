@@ -246,8 +246,10 @@ cogl_attribute_new (CoglAttributeBuffer *attribute_buffer,
   attribute->d.buffered.offset = offset;
   attribute->d.buffered.n_components = n_components;
   attribute->d.buffered.type = type;
+  attribute->d.buffered.divisor = 0;
 
   attribute->immutable_ref = 0;
+  attribute->has_vertex_arrays = FALSE;
 
   if (attribute->name_state->name_id != COGL_ATTRIBUTE_NAME_ID_CUSTOM_ARRAY)
     {
@@ -292,6 +294,7 @@ _cogl_attribute_new_const (CoglContext *context,
 
   attribute->is_buffered = FALSE;
   attribute->normalized = FALSE;
+  attribute->has_vertex_arrays = FALSE;
 
   attribute->d.constant.context = cogl_object_ref (context);
 
@@ -495,9 +498,38 @@ cogl_attribute_set_normalized (CoglAttribute *attribute,
   if (U_UNLIKELY (attribute->immutable_ref))
     warn_about_midscene_changes ();
 
+  _cogl_attribute_invalidate_vertex_arrays (attribute);
+
   attribute->normalized = normalized;
 }
 
+void
+cogl_attribute_set_instance_divisor (CoglAttribute *attribute,
+                                     int divisor)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_attribute (attribute));
+  _COGL_RETURN_IF_FAIL (attribute->is_buffered);
+  _COGL_RETURN_IF_FAIL (divisor >= 0);
+
+  if (U_UNLIKELY (attribute->immutable_ref))
+    warn_about_midscene_changes ();
+
+  _cogl_attribute_invalidate_vertex_arrays (attribute);
+
+  attribute->d.buffered.divisor = divisor;
+}
+
+int
+cogl_attribute_get_instance_divisor (CoglAttribute *attribute)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_attribute (attribute), 0);
+
+  if (!attribute->is_buffered)
+    return 0;
+
+  return attribute->d.buffered.divisor;
+}
+
 CoglAttributeBuffer *
 cogl_attribute_get_buffer (CoglAttribute *attribute)
 {
@@ -517,6 +549,8 @@ cogl_attribute_set_buffer (CoglAttribute *attribute,
   if (U_UNLIKELY (attribute->immutable_ref))
     warn_about_midscene_changes ();
 
+  _cogl_attribute_invalidate_vertex_arrays (attribute);
+
   cogl_object_ref (attribute_buffer);
 
   cogl_object_unref (attribute->d.buffered.attribute_buffer);
@@ -547,9 +581,25 @@ _cogl_attribute_immutable_unref (CoglAttribute *attribute)
   _cogl_buffer_immutable_unref (buffer);
 }
 
+void
+_cogl_attribute_invalidate_vertex_arrays (CoglAttribute *attribute)
+{
+  CoglContext *ctx;
+
+  if (!attribute->has_vertex_arrays)
+    return;
+
+  ctx = COGL_BUFFER (attribute->d.buffered.attribute_buffer)->context;
+  ctx->driver_vtable->attribute_invalidate (ctx, attribute);
+
+  attribute->has_vertex_arrays = FALSE;
+}
+
 static void
 _cogl_attribute_free (CoglAttribute *attribute)
 {
+  _cogl_attribute_invalidate_vertex_arrays (attribute);
+
   if (attribute->is_buffered)
     cogl_object_unref (attribute->d.buffered.attribute_buffer);
   else
@@ -670,3 +720,16 @@ _cogl_attribute_get_n_components (CoglAttribute *attribute)
   else
     return attribute->d.constant.boxed.size;
 }
+
+CoglBool
+_cogl_attributes_have_instance_divisor (CoglAttribute **attributes,
+                                        int n_attributes)
+{
+  int i;
+
+  for (i = 0; i < n_attributes; i++)
+    if (attributes[i]->is_buffered && attributes[i]->d.buffered.divisor)
+      return TRUE;
+
+  return FALSE;
+}
@@ -500,6 +500,45 @@ cogl_attribute_set_normalized (CoglAttribute *attribute,
 CoglBool
 cogl_attribute_get_normalized (CoglAttribute *attribute);
 
+/**
+ * cogl_attribute_set_instance_divisor:
+ * @attribute: A #CoglAttribute
+ * @divisor: The number of instances that use each value
+ *
+ * Sets how the values of @attribute advance when the primitive is
+ * drawn with cogl_primitive_draw_instanced(). If @divisor is 0 then
+ * the attribute advances once per vertex as normal. Otherwise it
+ * advances once every @divisor instances so that, for example, with
+ * a divisor of 1 every instance of the primitive gets the next value
+ * from the attribute buffer. This can be used to give each instance
+ * its own position or color.
+ *
+ * The divisor can only be set on attributes that are backed by a
+ * #CoglAttributeBuffer. Attributes with a non-zero divisor should
+ * only be drawn with cogl_primitive_draw_instanced().
+ *
+ * The default value of this property is 0.
+ *
+ * Stability: unstable
+ * Since: 2.0
+ */
+void
+cogl_attribute_set_instance_divisor (CoglAttribute *attribute,
+                                     int divisor);
+
+/**
+ * cogl_attribute_get_instance_divisor:
+ * @attribute: A #CoglAttribute
+ *
+ * Return value: the value of the instance divisor property set with
+ * cogl_attribute_set_instance_divisor().
+ *
+ * Stability: unstable
+ * Since: 2.0
+ */
+int
+cogl_attribute_get_instance_divisor (CoglAttribute *attribute);
+
 /**
  * cogl_attribute_get_buffer:
  * @attribute: A #CoglAttribute
@@ -32,6 +32,8 @@
 #include "config.h"
 #endif
 
+#include <test-fixtures/test-unit.h>
+
 #include "cogl-private.h"
 #include "cogl-bitmap-private.h"
 #include "cogl-context-private.h"
@@ -39,6 +41,18 @@
 
 #include <string.h>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define COGL_BITMAP_USE_SSE2
+#if defined (__GNUC__) && (defined (__x86_64) || defined (__i386))
+#include <tmmintrin.h>
+#define COGL_BITMAP_USE_SSSE3
+#endif
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+#include <arm_neon.h>
+#define COGL_BITMAP_USE_NEON
+#endif
+
 #define component_type uint8_t
 #define component_size 8
 /* We want to specially optimise the packing when we are converting
@@ -274,6 +288,8 @@ _cogl_bitmap_unpremult_unpacked_span_16 (uint16_t *data,
           data[1] = (data[1] * 65535) / alpha;
           data[2] = (data[2] * 65535) / alpha;
         }
+
+      data += 4;
     }
 }
 
@@ -288,7 +304,47 @@ _cogl_bitmap_premult_unpacked_span_16 (uint16_t *data,
       data[0] = (data[0] * alpha) / 65535;
       data[1] = (data[1] * alpha) / 65535;
       data[2] = (data[2] * alpha) / 65535;
+
+      data += 4;
+    }
+}
+
+/* Premultiplies a row of one of the 32-bit formats in place */
+static void
+_cogl_bitmap_premult_span_8 (CoglPixelFormat format,
+                             uint8_t *data,
+                             int width)
+{
+  if (format & COGL_AFIRST_BIT)
+    {
+      while (width-- > 0)
+        {
+          _cogl_premult_alpha_first (data);
+          data += 4;
+        }
+    }
+  else
+    _cogl_bitmap_premult_unpacked_span_8 (data, width);
+}
+
+static void
+_cogl_bitmap_unpremult_span_8 (CoglPixelFormat format,
+                               uint8_t *data,
+                               int width)
+{
+  if (format & COGL_AFIRST_BIT)
+    {
+      while (width-- > 0)
+        {
+          if (data[0] == 0)
+            _cogl_unpremult_alpha_0 (data);
+          else
+            _cogl_unpremult_alpha_first (data);
+          data += 4;
+        }
     }
+  else
+    _cogl_bitmap_unpremult_unpacked_span_8 (data, width);
 }
 
 static CoglBool
@@ -322,6 +378,18 @@ _cogl_bitmap_needs_short_temp_buffer (CoglPixelFormat format)
     case COGL_PIXEL_FORMAT_DEPTH_32:
     case COGL_PIXEL_FORMAT_DEPTH_24_STENCIL_8:
     case COGL_PIXEL_FORMAT_ANY:
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
       u_assert_not_reached ();
 
     case COGL_PIXEL_FORMAT_A_8:
@@ -357,29 +425,965 @@ _cogl_bitmap_needs_short_temp_buffer (CoglPixelFormat format)
   u_assert_not_reached ();
 }
 
+/* Direct conversions
+ *
+ * Converting via the temporary RGBA row is flexible but it means
+ * touching every pixel three times. The most common conversions
+ * between the 8-bit formats are just a rearrangement of the bytes of
+ * each pixel, so for those we convert straight from the source row to
+ * the destination row instead. The rearrangement is described by an
+ * order array which gives, for each byte of a destination pixel, the
+ * byte of the source pixel to copy it from. When the source has no
+ * alpha component, index 3 refers to an opaque alpha value. RGB_565
+ * is handled as if it was a three byte format containing the
+ * unpacked components in RGB order. */
+
+typedef void (* CoglBitmapConvertRowFunc) (const uint8_t *src,
+                                           uint8_t *dst,
+                                           int width,
+                                           const int8_t *order);
+
+typedef struct
+{
+  CoglBitmapConvertRowFunc convert_4_to_4;
+  CoglBitmapConvertRowFunc convert_3_to_4;
+  CoglBitmapConvertRowFunc convert_4_to_3;
+  CoglBitmapConvertRowFunc convert_3_to_3;
+  CoglBitmapConvertRowFunc convert_565_to_4;
+  CoglBitmapConvertRowFunc convert_4_to_565;
+} CoglBitmapConvertFuncs;
+
+typedef struct
+{
+  CoglBitmapConvertRowFunc func;
+  int8_t order[4];
+} CoglBitmapDirectConversion;
+
+typedef enum
+{
+  COGL_BITMAP_LAYOUT_3,
+  COGL_BITMAP_LAYOUT_4,
+  COGL_BITMAP_LAYOUT_565
+} CoglBitmapLayout;
+
+/* The 8-bit expansion and packing of the 5 and 6 bit components used
+   by _cogl_unpack_rgb_565_8 and _cogl_pack_rgb_565_8. These are also
+   used to check the vectorized versions below which replace the
+   division with a multiplication and a shift that gives exactly the
+   same result for every input */
+#define EXPAND_5(b) (((b) * 255 + 15) / 31)
+#define EXPAND_6(b) (((b) * 255 + 31) / 63)
+#define SHRINK_5(b) (((b) * 31 + 127) / 255)
+#define SHRINK_6(b) (((b) * 63 + 127) / 255)
+
+static void
+convert_row_4_to_4 (const uint8_t *src,
+                    uint8_t *dst,
+                    int width,
+                    const int8_t *order)
+{
+  while (width-- > 0)
+    {
+      dst[0] = src[order[0]];
+      dst[1] = src[order[1]];
+      dst[2] = src[order[2]];
+      dst[3] = src[order[3]];
+      src += 4;
+      dst += 4;
+    }
+}
+
+static void
+convert_row_3_to_4 (const uint8_t *src,
+                    uint8_t *dst,
+                    int width,
+                    const int8_t *order)
+{
+  uint8_t pixel[4];
+
+  pixel[3] = 255;
+
+  while (width-- > 0)
+    {
+      pixel[0] = src[0];
+      pixel[1] = src[1];
+      pixel[2] = src[2];
+      dst[0] = pixel[order[0]];
+      dst[1] = pixel[order[1]];
+      dst[2] = pixel[order[2]];
+      dst[3] = pixel[order[3]];
+      src += 3;
+      dst += 4;
+    }
+}
+
+static void
+convert_row_4_to_3 (const uint8_t *src,
+                    uint8_t *dst,
+                    int width,
+                    const int8_t *order)
+{
+  while (width-- > 0)
+    {
+      dst[0] = src[order[0]];
+      dst[1] = src[order[1]];
+      dst[2] = src[order[2]];
+      src += 4;
+      dst += 3;
+    }
+}
+
+static void
+convert_row_3_to_3 (const uint8_t *src,
+                    uint8_t *dst,
+                    int width,
+                    const int8_t *order)
+{
+  while (width-- > 0)
+    {
+      dst[0] = src[order[0]];
+      dst[1] = src[order[1]];
+      dst[2] = src[order[2]];
+      src += 3;
+      dst += 3;
+    }
+}
+
+static void
+convert_row_565_to_4 (const uint8_t *src,
+                      uint8_t *dst,
+                      int width,
+                      const int8_t *order)
+{
+  uint8_t pixel[4];
+
+  pixel[3] = 255;
+
+  while (width-- > 0)
+    {
+      uint16_t v = *(const uint16_t *) src;
+
+      pixel[0] = EXPAND_5 (v >> 11);
+      pixel[1] = EXPAND_6 ((v >> 5) & 63);
+      pixel[2] = EXPAND_5 (v & 31);
+      dst[0] = pixel[order[0]];
+      dst[1] = pixel[order[1]];
+      dst[2] = pixel[order[2]];
+      dst[3] = pixel[order[3]];
+      src += 2;
+      dst += 4;
+    }
+}
+
+static void
+convert_row_4_to_565 (const uint8_t *src,
+                      uint8_t *dst,
+                      int width,
+                      const int8_t *order)
+{
+  while (width-- > 0)
+    {
+      uint16_t *v = (uint16_t *) dst;
+
+      *v = ((SHRINK_5 (src[order[0]]) << 11) |
+            (SHRINK_6 (src[order[1]]) << 5) |
+            SHRINK_5 (src[order[2]]));
+      src += 4;
+      dst += 2;
+    }
+}
+
+#ifdef COGL_BITMAP_USE_SSE2
+
+/* Without SSSE3 there is no byte shuffle so the bytes of each pixel
+   are moved with shifts instead. All of the bytes that move by the
+   same amount are handled with a single shift and mask */
+static void
+convert_row_4_to_4_sse2 (const uint8_t *src,
+                         uint8_t *dst,
+                         int width,
+                         const int8_t *order)
+{
+  __m128i counts[4];
+  __m128i masks[4];
+  int deltas[4];
+  int n_groups = 0;
+  int i, j;
+
+  for (i = 0; i < 4; i++)
+    {
+      int delta = i - order[i];
+      uint32_t mask = 0xffU << (i * 8);
+
+      for (j = 0; j < n_groups; j++)
+        if (deltas[j] == delta)
+          break;
+
+      if (j == n_groups)
+        {
+          deltas[j] = delta;
+          counts[j] = _mm_cvtsi32_si128 (ABS (delta) * 8);
+          masks[j] = _mm_setzero_si128 ();
+          n_groups++;
+        }
+
+      masks[j] = _mm_or_si128 (masks[j], _mm_set1_epi32 ((int) mask));
+    }
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i out = _mm_setzero_si128 ();
+
+      for (i = 0; i < n_groups; i++)
+        {
+          __m128i moved = (deltas[i] >= 0 ?
+                           _mm_sll_epi32 (in, counts[i]) :
+                           _mm_srl_epi32 (in, counts[i]));
+
+          out = _mm_or_si128 (out, _mm_and_si128 (moved, masks[i]));
+        }
+
+      _mm_storeu_si128 ((__m128i *) dst, out);
+
+      src += 16;
+      dst += 16;
+    }
+
+  convert_row_4_to_4 (src, dst, width, order);
+}
+
+static void
+convert_row_565_to_4_sse2 (const uint8_t *src,
+                           uint8_t *dst,
+                           int width,
+                           const int8_t *order)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i mask_5 = _mm_set1_epi16 (31);
+  const __m128i mask_6 = _mm_set1_epi16 (63);
+  __m128i shifts[3];
+  __m128i alpha = _mm_setzero_si128 ();
+  int i;
+
+  /* Work out where each unpacked component ends up in the 32-bit
+     destination pixel */
+  for (i = 0; i < 4; i++)
+    {
+      if (order[i] == 3)
+        alpha = _mm_set1_epi32 ((int) (0xffU << (i * 8)));
+      else
+        shifts[order[i]] = _mm_cvtsi32_si128 (i * 8);
+    }
+
+  for (; width >= 8; width -= 8)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i components[3];
+      __m128i out_lo = alpha, out_hi = alpha;
+
+      /* (b * 527 + 23) >> 6 is the same as EXPAND_5 and
+         (b * 259 + 33) >> 6 is the same as EXPAND_6 */
+      components[0] = _mm_srli_epi16 (v, 11);
+      components[0] =
+        _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (components[0],
+                                                        _mm_set1_epi16 (527)),
+                                       _mm_set1_epi16 (23)),
+                        6);
+      components[1] = _mm_and_si128 (_mm_srli_epi16 (v, 5), mask_6);
+      components[1] =
+        _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (components[1],
+                                                        _mm_set1_epi16 (259)),
+                                       _mm_set1_epi16 (33)),
+                        6);
+      components[2] = _mm_and_si128 (v, mask_5);
+      components[2] =
+        _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (components[2],
+                                                        _mm_set1_epi16 (527)),
+                                       _mm_set1_epi16 (23)),
+                        6);
+
+      for (i = 0; i < 3; i++)
+        {
+          __m128i lo = _mm_unpacklo_epi16 (components[i], zero);
+          __m128i hi = _mm_unpackhi_epi16 (components[i], zero);
+
+          out_lo = _mm_or_si128 (out_lo, _mm_sll_epi32 (lo, shifts[i]));
+          out_hi = _mm_or_si128 (out_hi, _mm_sll_epi32 (hi, shifts[i]));
+        }
+
+      _mm_storeu_si128 ((__m128i *) dst, out_lo);
+      _mm_storeu_si128 ((__m128i *) (dst + 16), out_hi);
+
+      src += 16;
+      dst += 32;
+    }
+
+  convert_row_565_to_4 (src, dst, width, order);
+}
+
+static void
+convert_row_4_to_565_sse2 (const uint8_t *src,
+                           uint8_t *dst,
+                           int width,
+                           const int8_t *order)
+{
+  const __m128i mask_8 = _mm_set1_epi32 (0xff);
+  __m128i shifts[3];
+  int i;
+
+  for (i = 0; i < 3; i++)
+    shifts[i] = _mm_cvtsi32_si128 (order[i] * 8);
+
+  for (; width >= 8; width -= 8)
+    {
+      __m128i lo = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i hi = _mm_loadu_si128 ((const __m128i *) (src + 16));
+      __m128i components[3];
+      __m128i r, g, b;
+
+      for (i = 0; i < 3; i++)
+        {
+          __m128i c_lo = _mm_and_si128 (_mm_srl_epi32 (lo, shifts[i]), mask_8);
+          __m128i c_hi = _mm_and_si128 (_mm_srl_epi32 (hi, shifts[i]), mask_8);
+
+          /* The values are all less than 256 so the signed saturation
+             doesn't matter */
+          components[i] = _mm_packs_epi32 (c_lo, c_hi);
+        }
+
+      /* (c * 249 + 1014) >> 11 is the same as SHRINK_5 and
+         (c * 253 + 505) >> 10 is the same as SHRINK_6. The
+         intermediate values fit in an unsigned 16-bit integer */
+      r = _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (components[0],
+                                                          _mm_set1_epi16 (249)),
+                                         _mm_set1_epi16 (1014)),
+                          11);
+      g = _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (components[1],
+                                                          _mm_set1_epi16 (253)),
+                                         _mm_set1_epi16 (505)),
+                          10);
+      b = _mm_srli_epi16 (_mm_add_epi16 (_mm_mullo_epi16 (components[2],
+                                                          _mm_set1_epi16 (249)),
+                                         _mm_set1_epi16 (1014)),
+                          11);
+
+      _mm_storeu_si128 ((__m128i *) dst,
+                        _mm_or_si128 (_mm_or_si128 (_mm_slli_epi16 (r, 11),
+                                                    _mm_slli_epi16 (g, 5)),
+                                      b));
+
+      src += 32;
+      dst += 16;
+    }
+
+  convert_row_4_to_565 (src, dst, width, order);
+}
+
+#endif /* COGL_BITMAP_USE_SSE2 */
+
+#ifdef COGL_BITMAP_USE_SSSE3
+
+/* These are only used if the CPU supports SSSE3 which is checked at
+   runtime. They use pshufb to rearrange all of the bytes in a vector
+   with a single instruction */
+
+static void __attribute__ ((target ("ssse3")))
+convert_row_4_to_4_ssse3 (const uint8_t *src,
+                          uint8_t *dst,
+                          int width,
+                          const int8_t *order)
+{
+  uint8_t shuffle_bytes[16];
+  __m128i shuffle;
+  int i, j;
+
+  for (j = 0; j < 4; j++)
+    for (i = 0; i < 4; i++)
+      shuffle_bytes[j * 4 + i] = j * 4 + order[i];
+  shuffle = _mm_loadu_si128 ((const __m128i *) shuffle_bytes);
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) src);
+      _mm_storeu_si128 ((__m128i *) dst, _mm_shuffle_epi8 (in, shuffle));
+      src += 16;
+      dst += 16;
+    }
+
+  convert_row_4_to_4 (src, dst, width, order);
+}
+
+static void __attribute__ ((target ("ssse3")))
+convert_row_3_to_4_ssse3 (const uint8_t *src,
+                          uint8_t *dst,
+                          int width,
+                          const int8_t *order)
+{
+  uint8_t shuffle_bytes[16];
+  uint8_t alpha_bytes[16];
+  __m128i shuffle, alpha;
+  int i, j;
+
+  for (j = 0; j < 4; j++)
+    for (i = 0; i < 4; i++)
+      {
+        /* A shuffle index with the top bit set gives zero */
+        shuffle_bytes[j * 4 + i] = order[i] == 3 ? 0x80 : j * 3 + order[i];
+        alpha_bytes[j * 4 + i] = order[i] == 3 ? 0xff : 0x00;
+      }
+  shuffle = _mm_loadu_si128 ((const __m128i *) shuffle_bytes);
+  alpha = _mm_loadu_si128 ((const __m128i *) alpha_bytes);
+
+  /* Each iteration converts four pixels but reads 16 bytes so we have
+     to stop while there are still at least 6 pixels left */
+  for (; width >= 6; width -= 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) src);
+      _mm_storeu_si128 ((__m128i *) dst,
+                        _mm_or_si128 (_mm_shuffle_epi8 (in, shuffle), alpha));
+      src += 12;
+      dst += 16;
+    }
+
+  convert_row_3_to_4 (src, dst, width, order);
+}
+
+static void __attribute__ ((target ("ssse3")))
+store_12_bytes (uint8_t *dst, __m128i value)
+{
+  uint32_t last;
+
+  _mm_storel_epi64 ((__m128i *) dst, value);
+  last = _mm_cvtsi128_si32 (_mm_srli_si128 (value, 8));
+  memcpy (dst + 8, &last, sizeof (last));
+}
+
+static void __attribute__ ((target ("ssse3")))
+convert_row_4_to_3_ssse3 (const uint8_t *src,
+                          uint8_t *dst,
+                          int width,
+                          const int8_t *order)
+{
+  uint8_t shuffle_bytes[16];
+  __m128i shuffle;
+  int i, j;
+
+  memset (shuffle_bytes, 0x80, sizeof (shuffle_bytes));
+  for (j = 0; j < 4; j++)
+    for (i = 0; i < 3; i++)
+      shuffle_bytes[j * 3 + i] = j * 4 + order[i];
+  shuffle = _mm_loadu_si128 ((const __m128i *) shuffle_bytes);
+
+  for (; width >= 4; width -= 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) src);
+      store_12_bytes (dst, _mm_shuffle_epi8 (in, shuffle));
+      src += 16;
+      dst += 12;
+    }
+
+  convert_row_4_to_3 (src, dst, width, order);
+}
+
+static void __attribute__ ((target ("ssse3")))
+convert_row_3_to_3_ssse3 (const uint8_t *src,
+                          uint8_t *dst,
+                          int width,
+                          const int8_t *order)
+{
+  uint8_t shuffle_bytes[16];
+  __m128i shuffle;
+  int i, j;
+
+  memset (shuffle_bytes, 0x80, sizeof (shuffle_bytes));
+  for (j = 0; j < 4; j++)
+    for (i = 0; i < 3; i++)
+      shuffle_bytes[j * 3 + i] = j * 3 + order[i];
+  shuffle = _mm_loadu_si128 ((const __m128i *) shuffle_bytes);
+
+  for (; width >= 6; width -= 4)
+    {
+      __m128i in = _mm_loadu_si128 ((const __m128i *) src);
+      store_12_bytes (dst, _mm_shuffle_epi8 (in, shuffle));
+      src += 12;
+      dst += 12;
+    }
+
+  convert_row_3_to_3 (src, dst, width, order);
+}
+
+#endif /* COGL_BITMAP_USE_SSSE3 */
+
+#ifdef COGL_BITMAP_USE_NEON
+
+/* NEON can load and store interleaved components directly so these
+   handle any order by just picking which of the deinterleaved
+   registers to store */
+
+static void
+convert_row_4_to_4_neon (const uint8_t *src,
+                         uint8_t *dst,
+                         int width,
+                         const int8_t *order)
+{
+  for (; width >= 16; width -= 16)
+    {
+      uint8x16x4_t in = vld4q_u8 (src);
+      uint8x16x4_t out;
+
+      out.val[0] = in.val[order[0]];
+      out.val[1] = in.val[order[1]];
+      out.val[2] = in.val[order[2]];
+      out.val[3] = in.val[order[3]];
+      vst4q_u8 (dst, out);
+
+      src += 64;
+      dst += 64;
+    }
+
+  convert_row_4_to_4 (src, dst, width, order);
+}
+
+static void
+convert_row_3_to_4_neon (const uint8_t *src,
+                         uint8_t *dst,
+                         int width,
+                         const int8_t *order)
+{
+  uint8x16_t alpha = vdupq_n_u8 (255);
+
+  for (; width >= 16; width -= 16)
+    {
+      uint8x16x3_t in = vld3q_u8 (src);
+      uint8x16_t components[4];
+      uint8x16x4_t out;
+
+      components[0] = in.val[0];
+      components[1] = in.val[1];
+      components[2] = in.val[2];
+      components[3] = alpha;
+
+      out.val[0] = components[order[0]];
+      out.val[1] = components[order[1]];
+      out.val[2] = components[order[2]];
+      out.val[3] = components[order[3]];
+      vst4q_u8 (dst, out);
+
+      src += 48;
+      dst += 64;
+    }
+
+  convert_row_3_to_4 (src, dst, width, order);
+}
+
+static void
+convert_row_4_to_3_neon (const uint8_t *src,
+                         uint8_t *dst,
+                         int width,
+                         const int8_t *order)
+{
+  for (; width >= 16; width -= 16)
+    {
+      uint8x16x4_t in = vld4q_u8 (src);
+      uint8x16x3_t out;
+
+      out.val[0] = in.val[order[0]];
+      out.val[1] = in.val[order[1]];
+      out.val[2] = in.val[order[2]];
+      vst3q_u8 (dst, out);
+
+      src += 64;
+      dst += 48;
+    }
+
+  convert_row_4_to_3 (src, dst, width, order);
+}
+
+static void
+convert_row_3_to_3_neon (const uint8_t *src,
+                         uint8_t *dst,
+                         int width,
+                         const int8_t *order)
+{
+  for (; width >= 16; width -= 16)
+    {
+      uint8x16x3_t in = vld3q_u8 (src);
+      uint8x16x3_t out;
+
+      out.val[0] = in.val[order[0]];
+      out.val[1] = in.val[order[1]];
+      out.val[2] = in.val[order[2]];
+      vst3q_u8 (dst, out);
+
+      src += 48;
+      dst += 48;
+    }
+
+  convert_row_3_to_3 (src, dst, width, order);
+}
+
+static void
+convert_row_565_to_4_neon (const uint8_t *src,
+                           uint8_t *dst,
+                           int width,
+                           const int8_t *order)
+{
+  const uint16x8_t mask_5 = vdupq_n_u16 (31);
+  const uint16x8_t mask_6 = vdupq_n_u16 (63);
+
+  for (; width >= 8; width -= 8)
+    {
+      uint16x8_t v = vld1q_u16 ((const uint16_t *) src);
+      uint16x8_t r = vshrq_n_u16 (v, 11);
+      uint16x8_t g = vandq_u16 (vshrq_n_u16 (v, 5), mask_6);
+      uint16x8_t b = vandq_u16 (v, mask_5);
+      uint8x8_t components[4];
+      uint8x8x4_t out;
+
+      /* (b * 527 + 23) >> 6 is the same as EXPAND_5 and
+         (b * 259 + 33) >> 6 is the same as EXPAND_6 */
+      components[0] =
+        vshrn_n_u16 (vmlaq_n_u16 (vdupq_n_u16 (23), r, 527), 6);
+      components[1] =
+        vshrn_n_u16 (vmlaq_n_u16 (vdupq_n_u16 (33), g, 259), 6);
+      components[2] =
+        vshrn_n_u16 (vmlaq_n_u16 (vdupq_n_u16 (23), b, 527), 6);
+      components[3] = vdup_n_u8 (255);
+
+      out.val[0] = components[order[0]];
+      out.val[1] = components[order[1]];
+      out.val[2] = components[order[2]];
+      out.val[3] = components[order[3]];
+      vst4_u8 (dst, out);
+
+      src += 16;
+      dst += 32;
+    }
+
+  convert_row_565_to_4 (src, dst, width, order);
+}
+
+static void
+convert_row_4_to_565_neon (const uint8_t *src,
+                           uint8_t *dst,
+                           int width,
+                           const int8_t *order)
+{
+  for (; width >= 8; width -= 8)
+    {
+      uint8x8x4_t in = vld4_u8 (src);
+      uint16x8_t r, g, b;
+
+      /* (c * 249 + 1014) >> 11 is the same as SHRINK_5 and
+         (c * 253 + 505) >> 10 is the same as SHRINK_6 */
+      r = vmlaq_n_u16 (vdupq_n_u16 (1014), vmovl_u8 (in.val[order[0]]), 249);
+      g = vmlaq_n_u16 (vdupq_n_u16 (505), vmovl_u8 (in.val[order[1]]), 253);
+      b = vmlaq_n_u16 (vdupq_n_u16 (1014), vmovl_u8 (in.val[order[2]]), 249);
+
+      vst1q_u16 ((uint16_t *) dst,
+                 vorrq_u16 (vorrq_u16 (vshlq_n_u16 (vshrq_n_u16 (r, 11), 11),
+                                       vshlq_n_u16 (vshrq_n_u16 (g, 10), 5)),
+                            vshrq_n_u16 (b, 11)));
+
+      src += 32;
+      dst += 16;
+    }
+
+  convert_row_4_to_565 (src, dst, width, order);
+}
+
+#endif /* COGL_BITMAP_USE_NEON */
+
+#undef EXPAND_5
+#undef EXPAND_6
+#undef SHRINK_5
+#undef SHRINK_6
+
+static const CoglBitmapConvertFuncs *
+get_convert_funcs (void)
+{
+  static CoglBitmapConvertFuncs funcs;
+  static CoglBool initialized = FALSE;
+
+  /* NB: this doesn't need any locking because every thread would
+     pick the same functions */
+  if (initialized)
+    return &funcs;
+
+  funcs.convert_4_to_4 = convert_row_4_to_4;
+  funcs.convert_3_to_4 = convert_row_3_to_4;
+  funcs.convert_4_to_3 = convert_row_4_to_3;
+  funcs.convert_3_to_3 = convert_row_3_to_3;
+  funcs.convert_565_to_4 = convert_row_565_to_4;
+  funcs.convert_4_to_565 = convert_row_4_to_565;
+
+#ifdef COGL_BITMAP_USE_SSE2
+  funcs.convert_4_to_4 = convert_row_4_to_4_sse2;
+  funcs.convert_565_to_4 = convert_row_565_to_4_sse2;
+  funcs.convert_4_to_565 = convert_row_4_to_565_sse2;
+#endif
+
+#ifdef COGL_BITMAP_USE_SSSE3
+  if (__builtin_cpu_supports ("ssse3"))
+    {
+      funcs.convert_4_to_4 = convert_row_4_to_4_ssse3;
+      funcs.convert_3_to_4 = convert_row_3_to_4_ssse3;
+      funcs.convert_4_to_3 = convert_row_4_to_3_ssse3;
+      funcs.convert_3_to_3 = convert_row_3_to_3_ssse3;
+    }
+#endif
+
+#ifdef COGL_BITMAP_USE_NEON
+  funcs.convert_4_to_4 = convert_row_4_to_4_neon;
+  funcs.convert_3_to_4 = convert_row_3_to_4_neon;
+  funcs.convert_4_to_3 = convert_row_4_to_3_neon;
+  funcs.convert_3_to_3 = convert_row_3_to_3_neon;
+  funcs.convert_565_to_4 = convert_row_565_to_4_neon;
+  funcs.convert_4_to_565 = convert_row_4_to_565_neon;
+#endif
+
+  initialized = TRUE;
+
+  return &funcs;
+}
+
+/* Gets the layout of the formats that can be converted directly. The
+   positions array is filled in with the byte that holds each of the
+   red, green, blue and alpha components or -1 if the component isn't
+   present */
+static CoglBool
+get_direct_layout (CoglPixelFormat format,
+                   CoglBitmapLayout *layout,
+                   int8_t *positions)
+{
+  static const struct
+  {
+    CoglPixelFormat format;
+    CoglBitmapLayout layout;
+    int8_t positions[4];
+  } layouts[] =
+    {
+      { COGL_PIXEL_FORMAT_RGB_888, COGL_BITMAP_LAYOUT_3, { 0, 1, 2, -1 } },
+      { COGL_PIXEL_FORMAT_BGR_888, COGL_BITMAP_LAYOUT_3, { 2, 1, 0, -1 } },
+      { COGL_PIXEL_FORMAT_RGBA_8888, COGL_BITMAP_LAYOUT_4, { 0, 1, 2, 3 } },
+      { COGL_PIXEL_FORMAT_BGRA_8888, COGL_BITMAP_LAYOUT_4, { 2, 1, 0, 3 } },
+      { COGL_PIXEL_FORMAT_ARGB_8888, COGL_BITMAP_LAYOUT_4, { 1, 2, 3, 0 } },
+      { COGL_PIXEL_FORMAT_ABGR_8888, COGL_BITMAP_LAYOUT_4, { 3, 2, 1, 0 } },
+      { COGL_PIXEL_FORMAT_RGB_565, COGL_BITMAP_LAYOUT_565, { 0, 1, 2, -1 } }
+    };
+  int i;
+
+  for (i = 0; i < U_N_ELEMENTS (layouts); i++)
+    if (layouts[i].format == (format & ~COGL_PREMULT_BIT))
+      {
+        *layout = layouts[i].layout;
+        memcpy (positions, layouts[i].positions, sizeof (layouts[i].positions));
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+static CoglBool
+_cogl_bitmap_find_direct_conversion (CoglPixelFormat src_format,
+                                     CoglPixelFormat dst_format,
+                                     CoglBitmapDirectConversion *conversion)
+{
+  const CoglBitmapConvertFuncs *funcs;
+  CoglBitmapLayout src_layout, dst_layout;
+  int8_t src_positions[4], dst_positions[4];
+  int component;
+
+  if (!get_direct_layout (src_format, &src_layout, src_positions) ||
+      !get_direct_layout (dst_format, &dst_layout, dst_positions))
+    return FALSE;
+
+  funcs = get_convert_funcs ();
+
+  if (dst_layout == COGL_BITMAP_LAYOUT_4)
+    {
+      if (src_layout == COGL_BITMAP_LAYOUT_4)
+        conversion->func = funcs->convert_4_to_4;
+      else if (src_layout == COGL_BITMAP_LAYOUT_3)
+        conversion->func = funcs->convert_3_to_4;
+      else
+        conversion->func = funcs->convert_565_to_4;
+    }
+  else if (dst_layout == COGL_BITMAP_LAYOUT_3)
+    {
+      if (src_layout == COGL_BITMAP_LAYOUT_4)
+        conversion->func = funcs->convert_4_to_3;
+      else if (src_layout == COGL_BITMAP_LAYOUT_3)
+        conversion->func = funcs->convert_3_to_3;
+      else
+        return FALSE;
+    }
+  else
+    {
+      if (src_layout == COGL_BITMAP_LAYOUT_4)
+        conversion->func = funcs->convert_4_to_565;
+      else
+        return FALSE;
+    }
+
+  memset (conversion->order, 0, sizeof (conversion->order));
+
+  for (component = 0; component < 4; component++)
+    {
+      int dst_pos = dst_positions[component];
+      int src_pos = src_positions[component];
+
+      if (dst_pos == -1)
+        continue;
+
+      /* The only component that can be missing from the source is
+         alpha */
+      conversion->order[dst_pos] = src_pos == -1 ? 3 : src_pos;
+    }
+
+  return TRUE;
+}
+
+/* Bitmaps with at least this many pixels are split into bands of
+   rows that are converted on the context's worker threads */
+#define COGL_BITMAP_THREADED_CONVERSION_THRESHOLD (512 * 512)
+
+/* The minimum number of rows that is worth passing to a worker
+   thread */
+#define COGL_BITMAP_MIN_ROWS_PER_BAND 16
+
+typedef struct
+{
+  CoglPixelFormat src_format;
+  CoglPixelFormat dst_format;
+  const uint8_t *src_data;
+  uint8_t *dst_data;
+  int src_rowstride;
+  int dst_rowstride;
+  int width;
+  CoglBool need_premult;
+  CoglBool use_16;
+  CoglBitmapDirectConversion direct_conversion;
+} CoglBitmapConvertState;
+
+static void
+_cogl_bitmap_foreach_row_band (CoglContext *ctx,
+                               int width,
+                               int height,
+                               CoglWorkerRowsFunc func,
+                               void *user_data)
+{
+  if (width * height >= COGL_BITMAP_THREADED_CONVERSION_THRESHOLD)
+    _cogl_worker_pool_run_rows (_cogl_context_get_worker_pool (ctx),
+                                height,
+                                COGL_BITMAP_MIN_ROWS_PER_BAND,
+                                func,
+                                user_data);
+  else
+    func (0, height, user_data);
+}
+
+static void
+convert_rows_direct (int first_row,
+                     int n_rows,
+                     void *user_data)
+{
+  CoglBitmapConvertState *state = user_data;
+  int y;
+
+  for (y = first_row; y < first_row + n_rows; y++)
+    {
+      const uint8_t *src = state->src_data + y * state->src_rowstride;
+      uint8_t *dst = state->dst_data + y * state->dst_rowstride;
+
+      state->direct_conversion.func (src, dst,
+                                     state->width,
+                                     state->direct_conversion.order);
+
+      /* The premult conversion can only be needed if both formats
+         have an alpha component so the destination will be one of
+         the 32-bit formats */
+      if (state->need_premult)
+        {
+          if (state->dst_format & COGL_PREMULT_BIT)
+            _cogl_bitmap_premult_span_8 (state->dst_format, dst, state->width);
+          else
+            _cogl_bitmap_unpremult_span_8 (state->dst_format,
+                                           dst,
+                                           state->width);
+        }
+    }
+}
+
+static void
+convert_rows_unpacked (int first_row,
+                       int n_rows,
+                       void *user_data)
+{
+  CoglBitmapConvertState *state = user_data;
+  int width = state->width;
+  void *tmp_row;
+  int y;
+
+  /* Allocate a buffer to hold a temporary RGBA row */
+  tmp_row = u_malloc (width *
+                      (state->use_16 ? sizeof (uint16_t) : sizeof (uint8_t)) *
+                      4);
+
+  for (y = first_row; y < first_row + n_rows; y++)
+    {
+      const uint8_t *src = state->src_data + y * state->src_rowstride;
+      uint8_t *dst = state->dst_data + y * state->dst_rowstride;
+
+      if (state->use_16)
+        _cogl_unpack_16 (state->src_format, src, tmp_row, width);
+      else
+        _cogl_unpack_8 (state->src_format, src, tmp_row, width);
+
+      /* Handle premultiplication */
+      if (state->need_premult)
+        {
+          if (state->dst_format & COGL_PREMULT_BIT)
+            {
+              if (state->use_16)
+                _cogl_bitmap_premult_unpacked_span_16 (tmp_row, width);
+              else
+                _cogl_bitmap_premult_unpacked_span_8 (tmp_row, width);
+            }
+          else
+            {
+              if (state->use_16)
+                _cogl_bitmap_unpremult_unpacked_span_16 (tmp_row, width);
+              else
+                _cogl_bitmap_unpremult_unpacked_span_8 (tmp_row, width);
+            }
+        }
+
+      if (state->use_16)
+        _cogl_pack_16 (state->dst_format, tmp_row, dst, width);
+      else
+        _cogl_pack_8 (state->dst_format, tmp_row, dst, width);
+    }
+
+  u_free (tmp_row);
+}
+
 CoglBool
 _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
                                   CoglBitmap *dst_bmp,
                                   CoglError **error)
 {
+  CoglContext *ctx = _cogl_bitmap_get_context (src_bmp);
+  CoglBitmapConvertState state;
   uint8_t *src_data;
-  uint8_t *dst_data;
-  uint8_t *src;
-  uint8_t *dst;
-  void *tmp_row;
-  int src_rowstride;
-  int dst_rowstride;
-  int y;
   int width, height;
   CoglPixelFormat src_format;
   CoglPixelFormat dst_format;
-  CoglBool use_16;
   CoglBool need_premult;
 
   src_format = cogl_bitmap_get_format (src_bmp);
-  src_rowstride = cogl_bitmap_get_rowstride (src_bmp);
   dst_format = cogl_bitmap_get_format (dst_bmp);
-  dst_rowstride = cogl_bitmap_get_rowstride (dst_bmp);
   width = cogl_bitmap_get_width (src_bmp);
   height = cogl_bitmap_get_height (src_bmp);
 
@@ -424,63 +1428,43 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
   src_data = _cogl_bitmap_map (src_bmp, COGL_BUFFER_ACCESS_READ, 0, error);
   if (src_data == NULL)
     return FALSE;
-  dst_data = _cogl_bitmap_map (dst_bmp,
-                               COGL_BUFFER_ACCESS_WRITE,
-                               COGL_BUFFER_MAP_HINT_DISCARD,
-                               error);
-  if (dst_data == NULL)
+  state.dst_data = _cogl_bitmap_map (dst_bmp,
+                                     COGL_BUFFER_ACCESS_WRITE,
+                                     COGL_BUFFER_MAP_HINT_DISCARD,
+                                     error);
+  if (state.dst_data == NULL)
     {
       _cogl_bitmap_unmap (src_bmp);
       return FALSE;
     }
 
-  use_16 = _cogl_bitmap_needs_short_temp_buffer (dst_format);
-
-  /* Allocate a buffer to hold a temporary RGBA row */
-  tmp_row = u_malloc (width *
-                      (use_16 ? sizeof (uint16_t) : sizeof (uint8_t)) * 4);
+  state.src_format = src_format;
+  state.dst_format = dst_format;
+  state.src_data = src_data;
+  state.src_rowstride = cogl_bitmap_get_rowstride (src_bmp);
+  state.dst_rowstride = cogl_bitmap_get_rowstride (dst_bmp);
+  state.width = width;
+  state.need_premult = need_premult;
 
-  /* FIXME: Optimize */
-  for (y = 0; y < height; y++)
+  if (_cogl_bitmap_find_direct_conversion (src_format, dst_format,
+                                           &state.direct_conversion))
     {
-      src = src_data + y * src_rowstride;
-      dst = dst_data + y * dst_rowstride;
-
-      if (use_16)
-        _cogl_unpack_16 (src_format, src, tmp_row, width);
-      else
-        _cogl_unpack_8 (src_format, src, tmp_row, width);
-
-      /* Handle premultiplication */
-      if (need_premult)
-        {
-          if (dst_format & COGL_PREMULT_BIT)
-            {
-              if (use_16)
-                _cogl_bitmap_premult_unpacked_span_16 (tmp_row, width);
-              else
-                _cogl_bitmap_premult_unpacked_span_8 (tmp_row, width);
-            }
-          else
-            {
-              if (use_16)
-                _cogl_bitmap_unpremult_unpacked_span_16 (tmp_row, width);
-              else
-                _cogl_bitmap_unpremult_unpacked_span_8 (tmp_row, width);
-            }
-        }
+      _cogl_bitmap_foreach_row_band (ctx, width, height,
+                                     convert_rows_direct,
+                                     &state);
+    }
+  else
+    {
+      state.use_16 = _cogl_bitmap_needs_short_temp_buffer (dst_format);
 
-      if (use_16)
-        _cogl_pack_16 (dst_format, tmp_row, dst, width);
-      else
-        _cogl_pack_8 (dst_format, tmp_row, dst, width);
+      _cogl_bitmap_foreach_row_band (ctx, width, height,
+                                     convert_rows_unpacked,
+                                     &state);
     }
 
   _cogl_bitmap_unmap (src_bmp);
   _cogl_bitmap_unmap (dst_bmp);
 
-  u_free (tmp_row);
-
   return TRUE;
 }
 
@@ -612,134 +1596,209 @@ _cogl_bitmap_convert_for_upload (CoglBitmap *src_bmp,
   return dst_bmp;
 }
 
-CoglBool
-_cogl_bitmap_unpremult (CoglBitmap *bmp,
-                        CoglError **error)
+typedef struct
 {
-  uint8_t *p, *data;
-  uint16_t *tmp_row;
-  int x,y;
   CoglPixelFormat format;
-  int width, height;
+  uint8_t *data;
   int rowstride;
+  int width;
+} CoglBitmapPremultState;
 
-  format = cogl_bitmap_get_format (bmp);
-  width = cogl_bitmap_get_width (bmp);
-  height = cogl_bitmap_get_height (bmp);
-  rowstride = cogl_bitmap_get_rowstride (bmp);
-
-  if ((data = _cogl_bitmap_map (bmp,
-                                COGL_BUFFER_ACCESS_READ |
-                                COGL_BUFFER_ACCESS_WRITE,
-                                0,
-                                error)) == NULL)
-    return FALSE;
+static void
+unpremult_rows (int first_row,
+                int n_rows,
+                void *user_data)
+{
+  CoglBitmapPremultState *state = user_data;
+  uint16_t *tmp_row;
+  int y;
 
   /* If we can't directly unpremult the data inline then we'll
      allocate a temporary row and unpack the data. This assumes if we
       can fast premult then we can also fast unpremult */
-  if (_cogl_bitmap_can_fast_premult (format))
+  if (_cogl_bitmap_can_fast_premult (state->format))
     tmp_row = NULL;
   else
-    tmp_row = u_malloc (sizeof (uint16_t) * 4 * width);
+    tmp_row = u_malloc (sizeof (uint16_t) * 4 * state->width);
 
-  for (y = 0; y < height; y++)
+  for (y = first_row; y < first_row + n_rows; y++)
     {
-      p = (uint8_t*) data + y * rowstride;
+      uint8_t *p = state->data + y * state->rowstride;
 
       if (tmp_row)
         {
-          _cogl_unpack_16 (format, p, tmp_row, width);
-          _cogl_bitmap_unpremult_unpacked_span_16 (tmp_row, width);
-          _cogl_pack_16 (format, tmp_row, p, width);
+          _cogl_unpack_16 (state->format, p, tmp_row, state->width);
+          _cogl_bitmap_unpremult_unpacked_span_16 (tmp_row, state->width);
+          _cogl_pack_16 (state->format, tmp_row, p, state->width);
         }
       else
-        {
-          if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  if (p[0] == 0)
-                    _cogl_unpremult_alpha_0 (p);
-                  else
-                    _cogl_unpremult_alpha_first (p);
-                  p += 4;
-                }
-            }
-          else
-            _cogl_bitmap_unpremult_unpacked_span_8 (p, width);
-        }
+        _cogl_bitmap_unpremult_span_8 (state->format, p, state->width);
     }
 
   u_free (tmp_row);
-
-  _cogl_bitmap_unmap (bmp);
-
-  _cogl_bitmap_set_format (bmp, format & ~COGL_PREMULT_BIT);
-
-  return TRUE;
 }
 
-CoglBool
-_cogl_bitmap_premult (CoglBitmap *bmp,
-                      CoglError **error)
+static void
+premult_rows (int first_row,
+              int n_rows,
+              void *user_data)
 {
-  uint8_t *p, *data;
+  CoglBitmapPremultState *state = user_data;
   uint16_t *tmp_row;
-  int x,y;
-  CoglPixelFormat format;
-  int width, height;
-  int rowstride;
-
-  format = cogl_bitmap_get_format (bmp);
-  width = cogl_bitmap_get_width (bmp);
-  height = cogl_bitmap_get_height (bmp);
-  rowstride = cogl_bitmap_get_rowstride (bmp);
-
-  if ((data = _cogl_bitmap_map (bmp,
-                                COGL_BUFFER_ACCESS_READ |
-                                COGL_BUFFER_ACCESS_WRITE,
-                                0,
-                                error)) == NULL)
-    return FALSE;
+  int y;
 
   /* If we can't directly premult the data inline then we'll allocate
      a temporary row and unpack the data. */
-  if (_cogl_bitmap_can_fast_premult (format))
+  if (_cogl_bitmap_can_fast_premult (state->format))
     tmp_row = NULL;
   else
-    tmp_row = u_malloc (sizeof (uint16_t) * 4 * width);
+    tmp_row = u_malloc (sizeof (uint16_t) * 4 * state->width);
 
-  for (y = 0; y < height; y++)
+  for (y = first_row; y < first_row + n_rows; y++)
     {
-      p = (uint8_t*) data + y * rowstride;
+      uint8_t *p = state->data + y * state->rowstride;
 
       if (tmp_row)
         {
-          _cogl_unpack_16 (format, p, tmp_row, width);
-          _cogl_bitmap_premult_unpacked_span_16 (tmp_row, width);
-          _cogl_pack_16 (format, tmp_row, p, width);
+          _cogl_unpack_16 (state->format, p, tmp_row, state->width);
+          _cogl_bitmap_premult_unpacked_span_16 (tmp_row, state->width);
+          _cogl_pack_16 (state->format, tmp_row, p, state->width);
         }
       else
-        {
-          if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  _cogl_premult_alpha_first (p);
-                  p += 4;
-                }
-            }
-          else
-            _cogl_bitmap_premult_unpacked_span_8 (p, width);
-        }
+        _cogl_bitmap_premult_span_8 (state->format, p, state->width);
     }
 
   u_free (tmp_row);
+}
+
+static CoglBool
+_cogl_bitmap_foreach_premult_row_band (CoglBitmap *bmp,
+                                       CoglWorkerRowsFunc func,
+                                       CoglError **error)
+{
+  CoglBitmapPremultState state;
+  int height;
+
+  state.format = cogl_bitmap_get_format (bmp);
+  state.width = cogl_bitmap_get_width (bmp);
+  state.rowstride = cogl_bitmap_get_rowstride (bmp);
+  height = cogl_bitmap_get_height (bmp);
+
+  if ((state.data = _cogl_bitmap_map (bmp,
+                                      COGL_BUFFER_ACCESS_READ |
+                                      COGL_BUFFER_ACCESS_WRITE,
+                                      0,
+                                      error)) == NULL)
+    return FALSE;
+
+  _cogl_bitmap_foreach_row_band (_cogl_bitmap_get_context (bmp),
+                                 state.width, height,
+                                 func,
+                                 &state);
 
   _cogl_bitmap_unmap (bmp);
 
-  _cogl_bitmap_set_format (bmp, format | COGL_PREMULT_BIT);
+  return TRUE;
+}
+
+CoglBool
+_cogl_bitmap_unpremult (CoglBitmap *bmp,
+                        CoglError **error)
+{
+  if (!_cogl_bitmap_foreach_premult_row_band (bmp, unpremult_rows, error))
+    return FALSE;
+
+  _cogl_bitmap_set_format (bmp,
+                           cogl_bitmap_get_format (bmp) & ~COGL_PREMULT_BIT);
 
   return TRUE;
 }
+
+CoglBool
+_cogl_bitmap_premult (CoglBitmap *bmp,
+                      CoglError **error)
+{
+  if (!_cogl_bitmap_foreach_premult_row_band (bmp, premult_rows, error))
+    return FALSE;
+
+  _cogl_bitmap_set_format (bmp,
+                           cogl_bitmap_get_format (bmp) | COGL_PREMULT_BIT);
+
+  return TRUE;
+}
+
+UNIT_TEST (check_direct_bitmap_conversions,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  static const CoglPixelFormat formats[] =
+    {
+      COGL_PIXEL_FORMAT_RGB_888,
+      COGL_PIXEL_FORMAT_BGR_888,
+      COGL_PIXEL_FORMAT_RGB_565,
+      COGL_PIXEL_FORMAT_RGBA_8888,
+      COGL_PIXEL_FORMAT_BGRA_8888,
+      COGL_PIXEL_FORMAT_ARGB_8888,
+      COGL_PIXEL_FORMAT_ABGR_8888,
+      COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+      COGL_PIXEL_FORMAT_BGRA_8888_PRE,
+      COGL_PIXEL_FORMAT_ARGB_8888_PRE,
+      COGL_PIXEL_FORMAT_ABGR_8888_PRE
+    };
+  /* An odd width so that the scalar code handles the end of the row
+     after the vectorized code */
+  const int width = 67;
+  uint8_t src[67 * 4];
+  uint8_t tmp_row[67 * 4];
+  uint8_t expected[67 * 4];
+  uint8_t result[67 * 4];
+  int src_num, dst_num;
+  int i;
+
+  for (i = 0; i < sizeof (src); i++)
+    src[i] = i * 71 + 13;
+
+  for (src_num = 0; src_num < U_N_ELEMENTS (formats); src_num++)
+    for (dst_num = 0; dst_num < U_N_ELEMENTS (formats); dst_num++)
+      {
+        CoglPixelFormat src_format = formats[src_num];
+        CoglPixelFormat dst_format = formats[dst_num];
+        CoglBitmapDirectConversion conversion;
+        CoglBool need_premult;
+
+        if (src_format == dst_format ||
+            !_cogl_bitmap_find_direct_conversion (src_format, dst_format,
+                                                  &conversion))
+          continue;
+
+        need_premult = ((src_format & COGL_PREMULT_BIT) !=
+                        (dst_format & COGL_PREMULT_BIT) &&
+                        (src_format & dst_format & COGL_A_BIT));
+        /* Clear both buffers so that the whole buffer can be compared
+           regardless of the size of the destination format */
+        memset (expected, 0, sizeof (expected));
+        memset (result, 0, sizeof (result));
+
+        /* Convert using the unpacked path */
+        _cogl_unpack_8 (src_format, src, tmp_row, width);
+        if (need_premult)
+          {
+            if (dst_format & COGL_PREMULT_BIT)
+              _cogl_bitmap_premult_unpacked_span_8 (tmp_row, width);
+            else
+              _cogl_bitmap_unpremult_unpacked_span_8 (tmp_row, width);
+          }
+        _cogl_pack_8 (dst_format, tmp_row, expected, width);
+
+        conversion.func (src, result, width, conversion.order);
+        if (need_premult)
+          {
+            if (dst_format & COGL_PREMULT_BIT)
+              _cogl_bitmap_premult_span_8 (dst_format, result, width);
+            else
+              _cogl_bitmap_unpremult_span_8 (dst_format, result, width);
+          }
+
+        u_assert_cmpint (memcmp (expected, result, sizeof (result)), ==, 0);
+      }
+}
@@ -376,6 +376,18 @@ G_PASTE (_cogl_unpack_, component_size) (CoglPixelFormat format,
     case COGL_PIXEL_FORMAT_DEPTH_32:
     case COGL_PIXEL_FORMAT_DEPTH_24_STENCIL_8:
     case COGL_PIXEL_FORMAT_ANY:
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
       u_assert_not_reached ();
     }
 }
@@ -715,6 +727,18 @@ G_PASTE (_cogl_pack_, component_size) (CoglPixelFormat format,
     case COGL_PIXEL_FORMAT_DEPTH_32:
     case COGL_PIXEL_FORMAT_DEPTH_24_STENCIL_8:
     case COGL_PIXEL_FORMAT_ANY:
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
       u_assert_not_reached ();
     }
 }
@@ -69,9 +69,26 @@ typedef enum _CoglBufferFlags
   COGL_BUFFER_FLAG_NONE            = 0,
   COGL_BUFFER_FLAG_BUFFER_OBJECT   = 1UL << 0,  /* real openGL buffer object */
   COGL_BUFFER_FLAG_MAPPED          = 1UL << 1,
-  COGL_BUFFER_FLAG_MAPPED_FALLBACK = 1UL << 2
+  COGL_BUFFER_FLAG_MAPPED_FALLBACK = 1UL << 2,
+  /* The CPU copy of the contents has been read to expand an instanced
+   * draw so it is kept for the lifetime of the buffer */
+  COGL_BUFFER_FLAG_KEEP_SHADOW     = 1UL << 3
 } CoglBufferFlags;
 
+/* Internal map hints that can be combined with the public
+ * CoglBufferMapHints. They are only passed to the driver if the
+ * corresponding private feature is available.
+ *
+ * UNSYNCHRONIZED tells the driver not to wait for the GPU to finish
+ * with the buffer so the caller needs to track that itself.
+ *
+ * PERSISTENT keeps the buffer usable for drawing while it is mapped.
+ * This must be used the first time the buffer is mapped because it
+ * needs immutable storage.
+ */
+#define COGL_BUFFER_MAP_HINT_UNSYNCHRONIZED (1 << 16)
+#define COGL_BUFFER_MAP_HINT_PERSISTENT (1 << 17)
+
 typedef enum {
   COGL_BUFFER_USAGE_HINT_TEXTURE,
   COGL_BUFFER_USAGE_HINT_ATTRIBUTE_BUFFER,
@@ -108,6 +125,18 @@ struct _CoglBuffer
    * ... or points to allocated memory in the fallback paths */
   uint8_t *data;
 
+  /* A copy of the contents kept on the CPU in case the buffer is used
+   * for an instanced draw that has to be expanded on a driver that
+   * can't map buffers for reading. It is dropped the first time the
+   * buffer is drawn directly unless the expansion has read it. Maps
+   * are served from the copy and any writes are uploaded when the
+   * buffer is unmapped */
+  uint8_t *shadow_data;
+  size_t map_offset;
+  size_t map_size;
+  CoglBufferAccess map_access;
+  CoglBufferMapHint map_hints;
+
   int immutable_ref;
 
   unsigned int store_created:1;
@@ -146,16 +175,31 @@ _cogl_buffer_immutable_ref (CoglBuffer *buffer);
 void
 _cogl_buffer_immutable_unref (CoglBuffer *buffer);
 
+/* Frees the CPU copy of the buffer contents, if it has one. This can
+ * be used for internal buffers that are known never to be read back
+ * so that they don't pay for the copy */
+void
+_cogl_buffer_discard_shadow (CoglBuffer *buffer);
+
+/* Called before the buffer is used by a draw that doesn't need its
+ * contents on the CPU. Unless an instanced draw has already read the
+ * buffer, the copy is freed so that it doesn't cost memory and later
+ * maps go straight to the driver */
+void
+_cogl_buffer_release_shadow (CoglBuffer *buffer);
+
 /* This is a wrapper around cogl_buffer_map_range for internal use
    when we want to map the buffer for write only to replace the entire
    contents. If the map fails then it will fallback to writing to a
    temporary buffer. When _cogl_buffer_unmap_for_fill_or_fallback is
    called the temporary buffer will be copied into the array. Note
-   that these calls share a global array so they can not be nested. */
+   that these calls share a global array so they can not be nested.
+   The hints are passed on to cogl_buffer_map_range. */
 void *
 _cogl_buffer_map_range_for_fill_or_fallback (CoglBuffer *buffer,
                                              size_t offset,
-                                             size_t size);
+                                             size_t size,
+                                             CoglBufferMapHint hints);
 void *
 _cogl_buffer_map_for_fill_or_fallback (CoglBuffer *buffer);
 
@@ -49,6 +49,7 @@
 #include "cogl-context-private.h"
 #include "cogl-object-private.h"
 #include "cogl-pixel-buffer-private.h"
+#include "cogl-instancing-private.h"
 
 /* XXX:
  * The CoglObject macros don't support any form of inheritance, so for
@@ -131,6 +132,7 @@ _cogl_buffer_initialize (CoglBuffer *buffer,
   buffer->usage_hint = usage_hint;
   buffer->update_hint = update_hint;
   buffer->data = NULL;
+  buffer->shadow_data = NULL;
   buffer->immutable_ref = 0;
 
   if (default_target == COGL_BUFFER_BIND_TARGET_PIXEL_PACK ||
@@ -163,9 +165,45 @@ _cogl_buffer_initialize (CoglBuffer *buffer,
       ctx->driver_vtable->buffer_create (buffer);
 
       buffer->flags |= COGL_BUFFER_FLAG_BUFFER_OBJECT;
+
+      /* Expanding instanced draws on the CPU needs to read the
+       * vertices and indices back but most GLES drivers can't map a
+       * buffer for reading. The data is usually uploaded before it is
+       * known whether the buffer will be drawn instanced so a copy is
+       * kept until the buffer is first drawn */
+      if ((default_target == COGL_BUFFER_BIND_TARGET_ATTRIBUTE_BUFFER ||
+           default_target == COGL_BUFFER_BIND_TARGET_INDEX_BUFFER) &&
+          !cogl_has_feature (ctx, COGL_FEATURE_ID_MAP_BUFFER_FOR_READ) &&
+          _cogl_instancing_needs_expansion (ctx))
+        {
+          buffer->shadow_data = u_malloc (size);
+          ctx->n_buffer_shadows++;
+        }
     }
 }
 
+void
+_cogl_buffer_discard_shadow (CoglBuffer *buffer)
+{
+  _COGL_RETURN_IF_FAIL (!(buffer->flags & COGL_BUFFER_FLAG_MAPPED));
+
+  if (buffer->shadow_data == NULL)
+    return;
+
+  u_free (buffer->shadow_data);
+  buffer->shadow_data = NULL;
+  buffer->context->n_buffer_shadows--;
+}
+
+void
+_cogl_buffer_release_shadow (CoglBuffer *buffer)
+{
+  if (buffer->shadow_data &&
+      !(buffer->flags & (COGL_BUFFER_FLAG_KEEP_SHADOW |
+                         COGL_BUFFER_FLAG_MAPPED)))
+    _cogl_buffer_discard_shadow (buffer);
+}
+
 void
 _cogl_buffer_fini (CoglBuffer *buffer)
 {
@@ -176,6 +214,8 @@ _cogl_buffer_fini (CoglBuffer *buffer)
     buffer->context->driver_vtable->buffer_destroy (buffer);
   else
     u_free (buffer->data);
+
+  _cogl_buffer_discard_shadow (buffer);
 }
 
 unsigned int
@@ -246,6 +286,17 @@ cogl_buffer_map_range (CoglBuffer *buffer,
   if (U_UNLIKELY (buffer->immutable_ref))
     warn_about_midscene_changes ();
 
+  if (buffer->shadow_data)
+    {
+      buffer->map_offset = offset;
+      buffer->map_size = size;
+      buffer->map_access = access;
+      buffer->map_hints = hints;
+      buffer->flags |= COGL_BUFFER_FLAG_MAPPED;
+
+      return buffer->shadow_data + offset;
+    }
+
   buffer->data = buffer->vtable.map_range (buffer,
                                            offset,
                                            size,
@@ -256,6 +307,40 @@ cogl_buffer_map_range (CoglBuffer *buffer,
   return buffer->data;
 }
 
+/* Uploads the range of the CPU copy that was mapped for writing. The
+ * driver is given the same hints as the original map so that, for
+ * example, discarding the buffer can still orphan its storage */
+static void
+upload_shadow (CoglBuffer *buffer)
+{
+  const uint8_t *src = buffer->shadow_data + buffer->map_offset;
+  CoglError *ignore_error = NULL;
+  uint8_t *dst;
+
+  dst = buffer->vtable.map_range (buffer,
+                                  buffer->map_offset,
+                                  buffer->map_size,
+                                  COGL_BUFFER_ACCESS_WRITE,
+                                  buffer->map_hints,
+                                  &ignore_error);
+  if (dst)
+    {
+      memcpy (dst, src, buffer->map_size);
+      buffer->vtable.unmap (buffer);
+      return;
+    }
+
+  cogl_error_free (ignore_error);
+
+  /* Note: like cogl_attribute_buffer_new() this doesn't report
+   * errors so an allocation failure in the driver will abort */
+  buffer->vtable.set_data (buffer,
+                           buffer->map_offset,
+                           src,
+                           buffer->map_size,
+                           NULL);
+}
+
 void
 cogl_buffer_unmap (CoglBuffer *buffer)
 {
@@ -265,19 +350,33 @@ cogl_buffer_unmap (CoglBuffer *buffer)
   if (!(buffer->flags & COGL_BUFFER_FLAG_MAPPED))
     return;
 
+  if (buffer->shadow_data)
+    {
+      buffer->flags &= ~COGL_BUFFER_FLAG_MAPPED;
+
+      if ((buffer->map_access & COGL_BUFFER_ACCESS_WRITE))
+        upload_shadow (buffer);
+
+      return;
+    }
+
   buffer->vtable.unmap (buffer);
 }
 
 void *
 _cogl_buffer_map_for_fill_or_fallback (CoglBuffer *buffer)
 {
-  return _cogl_buffer_map_range_for_fill_or_fallback (buffer, 0, buffer->size);
+  return _cogl_buffer_map_range_for_fill_or_fallback (buffer,
+                                                      0, /* offset */
+                                                      buffer->size,
+                                                      COGL_BUFFER_MAP_HINT_DISCARD);
 }
 
 void *
 _cogl_buffer_map_range_for_fill_or_fallback (CoglBuffer *buffer,
                                              size_t offset,
-                                             size_t size)
+                                             size_t size,
+                                             CoglBufferMapHint hints)
 {
   CoglContext *ctx = buffer->context;
   void *ret;
@@ -291,7 +390,7 @@ _cogl_buffer_map_range_for_fill_or_fallback (CoglBuffer *buffer,
                                offset,
                                size,
                                COGL_BUFFER_ACCESS_WRITE,
-                               COGL_BUFFER_MAP_HINT_DISCARD,
+                               hints,
                                &ignore_error);
 
   if (ret)
@@ -360,7 +459,13 @@ cogl_buffer_set_data (CoglBuffer *buffer,
   if (U_UNLIKELY (buffer->immutable_ref))
     warn_about_midscene_changes ();
 
-  return buffer->vtable.set_data (buffer, offset, data, size, error);
+  if (!buffer->vtable.set_data (buffer, offset, data, size, error))
+    return FALSE;
+
+  if (buffer->shadow_data)
+    memcpy (buffer->shadow_data + offset, data, size);
+
+  return TRUE;
 }
 
 CoglBuffer *
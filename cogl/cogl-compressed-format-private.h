@@ -0,0 +1,120 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_COMPRESSED_FORMAT_PRIVATE_H
+#define __COGL_COMPRESSED_FORMAT_PRIVATE_H
+
+#include "cogl-context.h"
+#include "cogl-types.h"
+
+/* GL enums for the compressed internal formats. These are shared by
+ * the GL drivers and the KTX loader so they are defined here in case
+ * the GL headers are too old to have them */
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_6x6_KHR
+#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR 0x93B4
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_8x8_KHR
+#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR 0x93B7
+#endif
+
+/* Returns the size in pixels of the blocks that make up @format and
+ * the number of bytes that each block takes */
+void
+_cogl_compressed_format_get_block_size (CoglPixelFormat format,
+                                        int *block_width,
+                                        int *block_height,
+                                        int *block_bytes);
+
+/* Returns the number of bytes taken by a single image of the given
+ * size. Partial blocks at the right and bottom edges take up a whole
+ * block */
+size_t
+_cogl_compressed_format_get_image_size (CoglPixelFormat format,
+                                        int width,
+                                        int height);
+
+/* Returns the number of bytes taken by @n_levels mipmap levels
+ * packed one after the other starting with the largest */
+size_t
+_cogl_compressed_format_get_data_size (CoglPixelFormat format,
+                                       int width,
+                                       int height,
+                                       int n_levels);
+
+/* Whether the driver can take data in @format directly without
+ * decoding it on the CPU first */
+CoglBool
+_cogl_compressed_format_is_supported (CoglContext *ctx,
+                                      CoglPixelFormat format);
+
+/* Decodes an image in one of the ETC or S3TC formats into
+ * COGL_PIXEL_FORMAT_RGBA_8888 so that compressed textures can still
+ * be used when the driver doesn't support them. Fails with
+ * COGL_TEXTURE_ERROR_FORMAT for formats that have no software
+ * decoder */
+CoglBool
+_cogl_compressed_format_decode (CoglPixelFormat format,
+                                int width,
+                                int height,
+                                const uint8_t *data,
+                                int dst_rowstride,
+                                uint8_t *dst,
+                                CoglError **error);
+
+#endif /* __COGL_COMPRESSED_FORMAT_PRIVATE_H */
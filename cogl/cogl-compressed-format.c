@@ -0,0 +1,839 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-context-private.h"
+#include "cogl-private.h"
+#include "cogl-texture.h"
+#include "cogl-compressed-format-private.h"
+#include "cogl-error-private.h"
+
+#include <test-fixtures/test-unit.h>
+
+/* The modifier tables for the ETC1 and ETC2 individual and
+ * differential modes, indexed by the table codeword and then the
+ * two-bit pixel index */
+static const int
+etc_modifier_table[8][4] =
+  {
+    { 2, 8, -2, -8 },
+    { 5, 17, -5, -17 },
+    { 9, 29, -9, -29 },
+    { 13, 42, -13, -42 },
+    { 18, 60, -18, -60 },
+    { 24, 80, -24, -80 },
+    { 33, 106, -33, -106 },
+    { 47, 183, -47, -183 }
+  };
+
+/* The distances used by the ETC2 'T' and 'H' modes */
+static const int
+etc_distance_table[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+/* The modifier tables for the EAC alpha block of ETC2_RGBA_8 */
+static const int
+eac_modifier_table[16][8] =
+  {
+    { -3, -6, -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 },
+    { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 },
+    { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 },
+    { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },
+    { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },
+    { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },
+    { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },
+    { -3, -5, -7, -9, 2, 4, 6, 8 }
+  };
+
+typedef enum
+{
+  S3TC_COLOR_MODE_DXT1_RGB,
+  S3TC_COLOR_MODE_DXT1_RGBA,
+  /* DXT3 and DXT5 always use the four color mode */
+  S3TC_COLOR_MODE_FOUR_COLOR
+} S3TCColorMode;
+
+void
+_cogl_compressed_format_get_block_size (CoglPixelFormat format,
+                                        int *block_width,
+                                        int *block_height,
+                                        int *block_bytes)
+{
+  int width = 4, height = 4, bytes = 16;
+
+  switch (format)
+    {
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+      bytes = 8;
+      break;
+
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+      break;
+
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+      width = height = 6;
+      break;
+
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
+      width = height = 8;
+      break;
+
+    default:
+      /* Treat uncompressed formats as 1x1 blocks so that the size
+       * calculations still work */
+      width = height = 1;
+      bytes = _cogl_pixel_format_get_bytes_per_pixel (format);
+      break;
+    }
+
+  if (block_width)
+    *block_width = width;
+  if (block_height)
+    *block_height = height;
+  if (block_bytes)
+    *block_bytes = bytes;
+}
+
+size_t
+_cogl_compressed_format_get_image_size (CoglPixelFormat format,
+                                        int width,
+                                        int height)
+{
+  int block_width, block_height, block_bytes;
+
+  _cogl_compressed_format_get_block_size (format,
+                                          &block_width,
+                                          &block_height,
+                                          &block_bytes);
+
+  return ((size_t) ((width + block_width - 1) / block_width) *
+          ((height + block_height - 1) / block_height) *
+          block_bytes);
+}
+
+size_t
+_cogl_compressed_format_get_data_size (CoglPixelFormat format,
+                                       int width,
+                                       int height,
+                                       int n_levels)
+{
+  size_t size = 0;
+  int i;
+
+  for (i = 0; i < n_levels; i++)
+    {
+      size += _cogl_compressed_format_get_image_size (format, width, height);
+      width = MAX (width >> 1, 1);
+      height = MAX (height >> 1, 1);
+    }
+
+  return size;
+}
+
+CoglBool
+_cogl_compressed_format_is_supported (CoglContext *ctx,
+                                      CoglPixelFormat format)
+{
+  switch (format)
+    {
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+      /* ETC2 is a superset of ETC1 so the data can be uploaded as
+       * ETC2_RGB_8 instead */
+      return (cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_ETC1) ||
+              cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_ETC2));
+
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+      return cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_ETC2);
+
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+      return cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_S3TC);
+
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+      return cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_BPTC);
+
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
+      return cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_ASTC);
+
+    default:
+      return FALSE;
+    }
+}
+
+static uint32_t
+read_be32 (const uint8_t *p)
+{
+  return (((uint32_t) p[0] << 24) |
+          ((uint32_t) p[1] << 16) |
+          ((uint32_t) p[2] << 8) |
+          (uint32_t) p[3]);
+}
+
+static uint32_t
+read_le32 (const uint8_t *p)
+{
+  return (((uint32_t) p[3] << 24) |
+          ((uint32_t) p[2] << 16) |
+          ((uint32_t) p[1] << 8) |
+          (uint32_t) p[0]);
+}
+
+static uint8_t
+clamp_byte (int value)
+{
+  return CLAMP (value, 0, 255);
+}
+
+static int
+sign_extend_3 (int value)
+{
+  return (value & 4) ? value - 8 : value;
+}
+
+/* Blocks are always decoded into a 4x4 array of RGBA pixels in
+ * row-major order */
+static void
+set_pixel (uint8_t *block,
+           int x,
+           int y,
+           int r,
+           int g,
+           int b,
+           int a)
+{
+  uint8_t *p = block + (y * 4 + x) * 4;
+
+  p[0] = clamp_byte (r);
+  p[1] = clamp_byte (g);
+  p[2] = clamp_byte (b);
+  p[3] = clamp_byte (a);
+}
+
+/* Returns the two-bit index of a pixel in an ETC block. The pixels
+ * are stored in column-major order with the most significant bits of
+ * all of the pixels in the top half of the word */
+static int
+get_etc_pixel_index (uint32_t lo, int x, int y)
+{
+  int i = x * 4 + y;
+
+  return ((lo >> (i + 15)) & 2) | ((lo >> i) & 1);
+}
+
+static void
+decode_etc2_paint_colors (uint32_t lo,
+                          int paint_colors[4][3],
+                          CoglBool opaque,
+                          uint8_t *block)
+{
+  int x, y;
+
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        int index = get_etc_pixel_index (lo, x, y);
+
+        if (!opaque && index == 2)
+          set_pixel (block, x, y, 0, 0, 0, 0);
+        else
+          set_pixel (block, x, y,
+                     paint_colors[index][0],
+                     paint_colors[index][1],
+                     paint_colors[index][2],
+                     255);
+      }
+}
+
+static void
+decode_etc2_t_block (uint32_t hi,
+                     uint32_t lo,
+                     CoglBool opaque,
+                     uint8_t *block)
+{
+  int colors[2][3];
+  int paint_colors[4][3];
+  int distance;
+  int i;
+
+  colors[0][0] = (((hi >> 27) & 3) << 2) | ((hi >> 24) & 3);
+  colors[0][1] = (hi >> 20) & 0xf;
+  colors[0][2] = (hi >> 16) & 0xf;
+  colors[1][0] = (hi >> 12) & 0xf;
+  colors[1][1] = (hi >> 8) & 0xf;
+  colors[1][2] = (hi >> 4) & 0xf;
+
+  distance = etc_distance_table[(((hi >> 2) & 3) << 1) | (hi & 1)];
+
+  for (i = 0; i < 3; i++)
+    {
+      int c0 = (colors[0][i] << 4) | colors[0][i];
+      int c1 = (colors[1][i] << 4) | colors[1][i];
+
+      paint_colors[0][i] = c0;
+      paint_colors[1][i] = c1 + distance;
+      paint_colors[2][i] = c1;
+      paint_colors[3][i] = c1 - distance;
+    }
+
+  decode_etc2_paint_colors (lo, paint_colors, opaque, block);
+}
+
+static void
+decode_etc2_h_block (uint32_t hi,
+                     uint32_t lo,
+                     CoglBool opaque,
+                     uint8_t *block)
+{
+  int colors[2][3];
+  int paint_colors[4][3];
+  int distance_index;
+  int distance;
+  int i;
+
+  colors[0][0] = (hi >> 27) & 0xf;
+  colors[0][1] = (((hi >> 24) & 7) << 1) | ((hi >> 20) & 1);
+  colors[0][2] = (((hi >> 19) & 1) << 3) | ((hi >> 15) & 7);
+  colors[1][0] = (hi >> 11) & 0xf;
+  colors[1][1] = (hi >> 7) & 0xf;
+  colors[1][2] = (hi >> 3) & 0xf;
+
+  /* The least significant bit of the distance is implied by the
+   * order of the two colors */
+  distance_index = (((hi >> 2) & 1) << 2) | ((hi & 1) << 1);
+  if (((colors[0][0] << 8) | (colors[0][1] << 4) | colors[0][2]) >=
+      ((colors[1][0] << 8) | (colors[1][1] << 4) | colors[1][2]))
+    distance_index |= 1;
+  distance = etc_distance_table[distance_index];
+
+  for (i = 0; i < 3; i++)
+    {
+      int c0 = (colors[0][i] << 4) | colors[0][i];
+      int c1 = (colors[1][i] << 4) | colors[1][i];
+
+      paint_colors[0][i] = c0 + distance;
+      paint_colors[1][i] = c0 - distance;
+      paint_colors[2][i] = c1 + distance;
+      paint_colors[3][i] = c1 - distance;
+    }
+
+  decode_etc2_paint_colors (lo, paint_colors, opaque, block);
+}
+
+static void
+decode_etc2_planar_block (uint32_t hi,
+                          uint32_t lo,
+                          uint8_t *block)
+{
+  int o[3], h[3], v[3];
+  int x, y, i;
+
+  o[0] = (hi >> 25) & 0x3f;
+  o[1] = (((hi >> 24) & 1) << 6) | ((hi >> 17) & 0x3f);
+  o[2] = (((hi >> 16) & 1) << 5) | (((hi >> 11) & 3) << 3) | ((hi >> 7) & 7);
+  h[0] = (((hi >> 2) & 0x1f) << 1) | (hi & 1);
+  h[1] = (lo >> 25) & 0x7f;
+  h[2] = (lo >> 19) & 0x3f;
+  v[0] = (lo >> 13) & 0x3f;
+  v[1] = (lo >> 6) & 0x7f;
+  v[2] = lo & 0x3f;
+
+  /* Red and blue have six bits and green has seven */
+  for (i = 0; i < 3; i += 2)
+    {
+      o[i] = (o[i] << 2) | (o[i] >> 4);
+      h[i] = (h[i] << 2) | (h[i] >> 4);
+      v[i] = (v[i] << 2) | (v[i] >> 4);
+    }
+  o[1] = (o[1] << 1) | (o[1] >> 6);
+  h[1] = (h[1] << 1) | (h[1] >> 6);
+  v[1] = (v[1] << 1) | (v[1] >> 6);
+
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        int c[3];
+
+        for (i = 0; i < 3; i++)
+          c[i] = ((x * (h[i] - o[i]) + y * (v[i] - o[i]) +
+                   4 * o[i] + 2) >> 2);
+
+        set_pixel (block, x, y, c[0], c[1], c[2], 255);
+      }
+}
+
+/* Decodes an 8-byte ETC1 or ETC2 color block. The extra ETC2 modes
+ * are encoded as overflows of the differential mode so they are only
+ * checked for if @etc2 is set. @punchthrough selects the
+ * ETC2_RGB_8_A_1 interpretation where the differential bit instead
+ * marks whether the block is opaque */
+static void
+decode_etc_color_block (const uint8_t *src,
+                        CoglBool etc2,
+                        CoglBool punchthrough,
+                        uint8_t *block)
+{
+  uint32_t hi = read_be32 (src);
+  uint32_t lo = read_be32 (src + 4);
+  CoglBool differential = (hi >> 1) & 1;
+  CoglBool flip = hi & 1;
+  CoglBool opaque = TRUE;
+  int base_colors[2][3];
+  int tables[2];
+  int x, y, i;
+
+  if (punchthrough)
+    {
+      opaque = differential;
+      differential = TRUE;
+    }
+
+  if (differential)
+    {
+      int base[3], delta[3];
+
+      for (i = 0; i < 3; i++)
+        {
+          base[i] = (hi >> (27 - i * 8)) & 0x1f;
+          delta[i] = sign_extend_3 ((hi >> (24 - i * 8)) & 7);
+        }
+
+      if (etc2)
+        {
+          if (base[0] + delta[0] < 0 || base[0] + delta[0] > 31)
+            {
+              decode_etc2_t_block (hi, lo, opaque, block);
+              return;
+            }
+          if (base[1] + delta[1] < 0 || base[1] + delta[1] > 31)
+            {
+              decode_etc2_h_block (hi, lo, opaque, block);
+              return;
+            }
+          if (base[2] + delta[2] < 0 || base[2] + delta[2] > 31)
+            {
+              decode_etc2_planar_block (hi, lo, block);
+              return;
+            }
+        }
+
+      for (i = 0; i < 3; i++)
+        {
+          int second = (base[i] + delta[i]) & 0x1f;
+
+          base_colors[0][i] = (base[i] << 3) | (base[i] >> 2);
+          base_colors[1][i] = (second << 3) | (second >> 2);
+        }
+    }
+  else
+    {
+      for (i = 0; i < 3; i++)
+        {
+          int first = (hi >> (28 - i * 8)) & 0xf;
+          int second = (hi >> (24 - i * 8)) & 0xf;
+
+          base_colors[0][i] = (first << 4) | first;
+          base_colors[1][i] = (second << 4) | second;
+        }
+    }
+
+  tables[0] = (hi >> 5) & 7;
+  tables[1] = (hi >> 2) & 7;
+
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        int sub_block = flip ? y >= 2 : x >= 2;
+        int index = get_etc_pixel_index (lo, x, y);
+        const int *base = base_colors[sub_block];
+        int modifier;
+
+        if (!opaque)
+          {
+            /* Non-opaque punchthrough blocks replace the small
+             * negative modifier with a transparent pixel and have no
+             * small positive modifier */
+            if (index == 2)
+              {
+                set_pixel (block, x, y, 0, 0, 0, 0);
+                continue;
+              }
+            else if (index == 0)
+              {
+                set_pixel (block, x, y, base[0], base[1], base[2], 255);
+                continue;
+              }
+          }
+
+        modifier = etc_modifier_table[tables[sub_block]][index];
+
+        set_pixel (block, x, y,
+                   base[0] + modifier,
+                   base[1] + modifier,
+                   base[2] + modifier,
+                   255);
+      }
+}
+
+static void
+decode_eac_alpha_block (const uint8_t *src,
+                        uint8_t *block)
+{
+  int base = src[0];
+  int multiplier = src[1] >> 4;
+  const int *table = eac_modifier_table[src[1] & 0xf];
+  uint64_t bits = 0;
+  int x, y, i;
+
+  for (i = 2; i < 8; i++)
+    bits = (bits << 8) | src[i];
+
+  /* The indices are three bits each in column-major order starting
+   * from the most significant bit */
+  for (x = 0; x < 4; x++)
+    for (y = 0; y < 4; y++)
+      {
+        int index = (bits >> (45 - (x * 4 + y) * 3)) & 7;
+
+        block[(y * 4 + x) * 4 + 3] =
+          clamp_byte (base + table[index] * multiplier);
+      }
+}
+
+static void
+expand_565 (int color, int *out)
+{
+  int r = (color >> 11) & 0x1f;
+  int g = (color >> 5) & 0x3f;
+  int b = color & 0x1f;
+
+  out[0] = (r << 3) | (r >> 2);
+  out[1] = (g << 2) | (g >> 4);
+  out[2] = (b << 3) | (b >> 2);
+  out[3] = 255;
+}
+
+static void
+decode_s3tc_color_block (const uint8_t *src,
+                         S3TCColorMode mode,
+                         uint8_t *block)
+{
+  int c0 = src[0] | (src[1] << 8);
+  int c1 = src[2] | (src[3] << 8);
+  uint32_t indices = read_le32 (src + 4);
+  int colors[4][4];
+  int x, y, i;
+
+  expand_565 (c0, colors[0]);
+  expand_565 (c1, colors[1]);
+
+  if (c0 > c1 || mode == S3TC_COLOR_MODE_FOUR_COLOR)
+    {
+      for (i = 0; i < 3; i++)
+        {
+          colors[2][i] = (2 * colors[0][i] + colors[1][i]) / 3;
+          colors[3][i] = (colors[0][i] + 2 * colors[1][i]) / 3;
+        }
+      colors[2][3] = colors[3][3] = 255;
+    }
+  else
+    {
+      for (i = 0; i < 3; i++)
+        {
+          colors[2][i] = (colors[0][i] + colors[1][i]) / 2;
+          colors[3][i] = 0;
+        }
+      colors[2][3] = 255;
+      colors[3][3] = mode == S3TC_COLOR_MODE_DXT1_RGBA ? 0 : 255;
+    }
+
+  /* The indices are two bits each in row-major order starting from
+   * the least significant bit */
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        const int *color = colors[(indices >> ((y * 4 + x) * 2)) & 3];
+
+        set_pixel (block, x, y, color[0], color[1], color[2], color[3]);
+      }
+}
+
+static void
+decode_dxt3_alpha_block (const uint8_t *src,
+                         uint8_t *block)
+{
+  int i;
+
+  for (i = 0; i < 16; i++)
+    {
+      int alpha = (src[i / 2] >> ((i & 1) * 4)) & 0xf;
+
+      block[i * 4 + 3] = (alpha << 4) | alpha;
+    }
+}
+
+static void
+decode_dxt5_alpha_block (const uint8_t *src,
+                         uint8_t *block)
+{
+  int alphas[8];
+  uint64_t bits = 0;
+  int i;
+
+  alphas[0] = src[0];
+  alphas[1] = src[1];
+
+  if (alphas[0] > alphas[1])
+    {
+      for (i = 1; i < 7; i++)
+        alphas[i + 1] = ((7 - i) * alphas[0] + i * alphas[1]) / 7;
+    }
+  else
+    {
+      for (i = 1; i < 5; i++)
+        alphas[i + 1] = ((5 - i) * alphas[0] + i * alphas[1]) / 5;
+      alphas[6] = 0;
+      alphas[7] = 255;
+    }
+
+  for (i = 7; i >= 2; i--)
+    bits = (bits << 8) | src[i];
+
+  for (i = 0; i < 16; i++)
+    block[i * 4 + 3] = alphas[(bits >> (i * 3)) & 7];
+}
+
+static void
+decode_block (CoglPixelFormat format,
+              const uint8_t *src,
+              uint8_t *block)
+{
+  switch (format)
+    {
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+      decode_etc_color_block (src, FALSE, FALSE, block);
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+      decode_etc_color_block (src, TRUE, FALSE, block);
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+      decode_etc_color_block (src, TRUE, TRUE, block);
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+      decode_etc_color_block (src + 8, TRUE, FALSE, block);
+      decode_eac_alpha_block (src, block);
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+      decode_s3tc_color_block (src, S3TC_COLOR_MODE_DXT1_RGB, block);
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+      decode_s3tc_color_block (src, S3TC_COLOR_MODE_DXT1_RGBA, block);
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+      decode_s3tc_color_block (src + 8, S3TC_COLOR_MODE_FOUR_COLOR, block);
+      decode_dxt3_alpha_block (src, block);
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+      decode_s3tc_color_block (src + 8, S3TC_COLOR_MODE_FOUR_COLOR, block);
+      decode_dxt5_alpha_block (src, block);
+      break;
+    default:
+      u_assert_not_reached ();
+    }
+}
+
+CoglBool
+_cogl_compressed_format_decode (CoglPixelFormat format,
+                                int width,
+                                int height,
+                                const uint8_t *data,
+                                int dst_rowstride,
+                                uint8_t *dst,
+                                CoglError **error)
+{
+  int block_bytes;
+  int bx, by;
+
+  switch (format)
+    {
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+      break;
+
+    default:
+      _cogl_set_error (error,
+                       COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_FORMAT,
+                       "The driver doesn't support this compressed format "
+                       "and there is no software decoder for it");
+      return FALSE;
+    }
+
+  _cogl_compressed_format_get_block_size (format, NULL, NULL, &block_bytes);
+
+  for (by = 0; by < height; by += 4)
+    for (bx = 0; bx < width; bx += 4)
+      {
+        uint8_t block[4 * 4 * 4];
+        int copy_width = MIN (width - bx, 4);
+        int copy_height = MIN (height - by, 4);
+        int y;
+
+        decode_block (format, data, block);
+        data += block_bytes;
+
+        for (y = 0; y < copy_height; y++)
+          memcpy (dst + (by + y) * dst_rowstride + bx * 4,
+                  block + y * 4 * 4,
+                  copy_width * 4);
+      }
+
+  return TRUE;
+}
+
+static void
+check_decoded_pixel (const uint8_t *image,
+                     int x,
+                     int y,
+                     int r,
+                     int g,
+                     int b,
+                     int a)
+{
+  const uint8_t *p = image + (y * 4 + x) * 4;
+
+  u_assert_cmpint (p[0], ==, r);
+  u_assert_cmpint (p[1], ==, g);
+  u_assert_cmpint (p[2], ==, b);
+  u_assert_cmpint (p[3], ==, a);
+}
+
+UNIT_TEST (check_compressed_format_sizes,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  u_assert_cmpint (_cogl_compressed_format_get_image_size
+                   (COGL_PIXEL_FORMAT_ETC1_RGB_8, 16, 16), ==, 128);
+  /* Partial blocks take up a whole block */
+  u_assert_cmpint (_cogl_compressed_format_get_image_size
+                   (COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA, 5, 3), ==, 32);
+  u_assert_cmpint (_cogl_compressed_format_get_image_size
+                   (COGL_PIXEL_FORMAT_ASTC_6x6_RGBA, 12, 13), ==, 96);
+  /* 8x8, 4x4, 2x2 and 1x1 levels */
+  u_assert_cmpint (_cogl_compressed_format_get_data_size
+                   (COGL_PIXEL_FORMAT_ETC2_RGBA_8, 8, 8, 4), ==, 112);
+}
+
+UNIT_TEST (check_compressed_format_decode,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  /* Individual mode, base colors 0x88/0x44/0x22, table 0 on the left
+   * and 1 on the right, with the bottom right pixel but one using
+   * the large negative modifier */
+  static const uint8_t etc1[] =
+    { 0x88, 0x44, 0x22, 0x04, 0x20, 0x00, 0x20, 0x00 };
+  /* Four color mode from red to blue */
+  static const uint8_t dxt1_four[] =
+    { 0x00, 0xf8, 0x1f, 0x00, 0xe4, 0x00, 0x00, 0x00 };
+  /* Three color mode from blue to red with a transparent pixel */
+  static const uint8_t dxt1_three[] =
+    { 0x1f, 0x00, 0x00, 0xf8, 0xe4, 0x00, 0x00, 0x00 };
+  /* Eight alpha mode from 255 to 0 followed by solid red */
+  static const uint8_t dxt5[] =
+    { 0xff, 0x00, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0xf8, 0x00, 0xf8, 0x00, 0x00, 0x00, 0x00 };
+  /* EAC alpha with base 128, multiplier 2 and table 0 followed by
+   * the ETC1 block above */
+  static const uint8_t etc2_rgba[] =
+    { 0x80, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x88, 0x44, 0x22, 0x04, 0x20, 0x00, 0x20, 0x00 };
+  uint8_t image[4 * 4 * 4];
+
+  u_assert (_cogl_compressed_format_decode (COGL_PIXEL_FORMAT_ETC1_RGB_8,
+                                            4, 4, etc1, 16, image, NULL));
+  check_decoded_pixel (image, 0, 0, 138, 70, 36, 255);
+  check_decoded_pixel (image, 2, 0, 141, 73, 39, 255);
+  check_decoded_pixel (image, 3, 1, 119, 51, 17, 255);
+
+  u_assert (_cogl_compressed_format_decode (COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA,
+                                            4, 4, dxt1_four, 16, image, NULL));
+  check_decoded_pixel (image, 0, 0, 255, 0, 0, 255);
+  check_decoded_pixel (image, 1, 0, 0, 0, 255, 255);
+  check_decoded_pixel (image, 2, 0, 170, 0, 85, 255);
+  check_decoded_pixel (image, 3, 0, 85, 0, 170, 255);
+
+  u_assert (_cogl_compressed_format_decode (COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA,
+                                            4, 4, dxt1_three, 16, image, NULL));
+  check_decoded_pixel (image, 2, 0, 127, 0, 127, 255);
+  check_decoded_pixel (image, 3, 0, 0, 0, 0, 0);
+
+  u_assert (_cogl_compressed_format_decode (COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA,
+                                            4, 4, dxt5, 16, image, NULL));
+  check_decoded_pixel (image, 0, 0, 255, 0, 0, 255);
+  check_decoded_pixel (image, 1, 0, 255, 0, 0, 0);
+  check_decoded_pixel (image, 2, 0, 255, 0, 0, 218);
+
+  u_assert (_cogl_compressed_format_decode (COGL_PIXEL_FORMAT_ETC2_RGBA_8,
+                                            4, 4, etc2_rgba, 16, image, NULL));
+  check_decoded_pixel (image, 0, 0, 138, 70, 36, 122);
+  check_decoded_pixel (image, 0, 1, 138, 70, 36, 132);
+  check_decoded_pixel (image, 3, 1, 119, 51, 17, 122);
+}
@@ -41,5 +41,10 @@ extern char *_cogl_config_driver;
 extern char *_cogl_config_renderer;
 extern char *_cogl_config_disable_gl_extensions;
 extern char *_cogl_config_override_gl_version;
+extern char *_cogl_config_max_worker_threads;
+extern char *_cogl_config_pipeline_cache_max_entries;
+extern char *_cogl_config_program_cache_dir;
+extern char *_cogl_config_program_cache_max_size;
+extern char *_cogl_config_trace_file;
 
 #endif /* __COGL_CONFIG_PRIVATE_H */
@@ -43,6 +43,11 @@ char *_cogl_config_driver;
 char *_cogl_config_renderer;
 char *_cogl_config_disable_gl_extensions;
 char *_cogl_config_override_gl_version;
+char *_cogl_config_max_worker_threads;
+char *_cogl_config_pipeline_cache_max_entries;
+char *_cogl_config_program_cache_dir;
+char *_cogl_config_program_cache_max_size;
+char *_cogl_config_trace_file;
 
 #ifndef COGL_HAS_GLIB_SUPPORT
 
@@ -64,7 +69,13 @@ static const struct
     { "COGL_DRIVER", &_cogl_config_driver },
     { "COGL_RENDERER", &_cogl_config_renderer },
     { "COGL_DISABLE_GL_EXTENSIONS", &_cogl_config_disable_gl_extensions },
-    { "COGL_OVERRIDE_GL_VERSION", &_cogl_config_override_gl_version }
+    { "COGL_OVERRIDE_GL_VERSION", &_cogl_config_override_gl_version },
+    { "COGL_MAX_WORKER_THREADS", &_cogl_config_max_worker_threads },
+    { "COGL_PIPELINE_CACHE_MAX_ENTRIES",
+      &_cogl_config_pipeline_cache_max_entries },
+    { "COGL_PROGRAM_CACHE_DIR", &_cogl_config_program_cache_dir },
+    { "COGL_PROGRAM_CACHE_MAX_SIZE", &_cogl_config_program_cache_max_size },
+    { "COGL_TRACE_FILE", &_cogl_config_trace_file }
   };
 
 static void
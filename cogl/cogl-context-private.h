@@ -58,7 +58,10 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-onscreen-private.h"
 #include "cogl-fence-private.h"
+#include "cogl-stream-buffer-private.h"
 #include "cogl-poll-private.h"
+#include "cogl-worker-pool-private.h"
+#include "cogl-program-cache-private.h"
 #include "cogl-private.h"
 
 typedef struct
@@ -118,6 +121,15 @@ struct _CoglContext
    * custom attribute arrays */
   CoglBitmask       enable_custom_attributes_tmp;
   CoglBitmask       changed_bits_tmp;
+  /* The attribute locations that have a non-zero instance divisor */
+  CoglBitmask       instanced_attributes;
+
+  /* Vertex array objects created for the attribute layouts of
+   * CoglPrimitives. The two bitmasks above only track the state of
+   * the default vertex array object */
+  UHashTable       *vertex_array_cache;
+  GLuint            default_vertex_array;
+  GLuint            current_vertex_array;
 
   /* A few handy matrix constants */
   CoglMatrix        identity_matrix;
@@ -157,6 +169,9 @@ struct _CoglContext
   /* Global journal buffers */
   UArray           *journal_flush_attributes_array;
   UArray           *journal_clip_bounds;
+  UArray           *journal_reorder_batches;
+  UArray           *journal_reorder_batch_indices;
+  UArray           *journal_reorder_entries;
 
   /* Some simple caching, to minimize state changes... */
   CoglPipeline     *current_pipeline;
@@ -188,6 +203,11 @@ struct _CoglContext
   CoglList onscreen_dirty_queue;
   CoglClosure *onscreen_dispatch_idle;
 
+  /* Asynchronous reads whose data is ready, in the order they were
+   * started. See cogl-readback.c */
+  CoglList read_pixels_queue;
+  CoglClosure *read_pixels_dispatch_idle;
+
   CoglGLES2Context *current_gles2_context;
   UQueue gles2_context_stack;
 
@@ -245,6 +265,15 @@ struct _CoglContext
   CoglBool          buffer_map_fallback_in_use;
   size_t            buffer_map_fallback_offset;
 
+  /* The number of buffers that have a CPU copy of their contents.
+     Draws only need to check whether they can free the copies while
+     there are any */
+  int               n_buffer_shadows;
+
+  /* Ring of vertex data for geometry that is only drawn once such as
+     the journal's quads */
+  CoglStreamBuffer *stream_buffer;
+
   CoglWinsysRectangleState rectangle_state;
 
   CoglSamplerCache *sampler_cache;
@@ -281,6 +310,34 @@ struct _CoglContext
   CoglPollSource *fences_poll_source;
   CoglList fences;
 
+  /* Threads used to split up expensive CPU work such as converting
+     large bitmaps. This is created the first time it is needed */
+  CoglWorkerPool *worker_pool;
+
+  /* Persistent cache of linked program binaries. This is created the
+     first time it is needed and will stay NULL if it isn't configured
+     or the driver can't retrieve program binaries */
+  CoglProgramCache *program_cache;
+  CoglBool program_cache_initialized;
+
+  /* Ring buffer of events recorded when COGL_DEBUG=trace is
+     enabled. This is created when the first event is recorded */
+  CoglTraceBuffer *trace_buffer;
+
+  /* State for measuring GPU time with timer queries. The sections
+     recorded since the last swap are in gpu_timing_sections and are
+     moved to a frame in gpu_timing_pending_frames when an onscreen
+     is swapped until the results are available */
+  CoglBool gpu_timing_enabled;
+  int gpu_timing_depth;
+  CoglBool gpu_timing_active;
+  UArray *gpu_timing_sections;
+  CoglList gpu_timing_pending_frames;
+  CoglPollSource *gpu_timing_poll_source;
+  /* Labels used by the sections. The key and value are the same
+     string which is owned by the table */
+  UHashTable *gpu_timing_labels;
+
   /* This defines a list of function pointers that Cogl uses from
      either GL or GLES. All functions are accessed indirectly through
      these pointers rather than linking to them directly */
@@ -309,6 +366,12 @@ _cogl_context_get_default ();
 const CoglWinsysVtable *
 _cogl_context_get_winsys (CoglContext *context);
 
+CoglWorkerPool *
+_cogl_context_get_worker_pool (CoglContext *context);
+
+CoglProgramCache *
+_cogl_context_get_program_cache (CoglContext *context);
+
 /* Query the GL extensions and lookup the corresponding function
  * pointers. Theoretically the list of extensions can change for
  * different GL contexts so it is the winsys backend's responsiblity
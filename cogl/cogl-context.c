@@ -53,6 +53,7 @@
 #include "cogl-onscreen-private.h"
 #include "cogl-attribute-private.h"
 #include "cogl-gpu-info-private.h"
+#include "cogl-gpu-timing-private.h"
 #include "cogl-config-private.h"
 #include "cogl-error-private.h"
 
@@ -134,22 +135,6 @@ cogl_context_new (CoglDisplay *display,
 
   _cogl_init ();
 
-#ifdef COGL_ENABLE_PROFILE
-  /* We need to be absolutely sure that uprof has been initialized
-   * before calling _cogl_uprof_init. uprof_init (NULL, NULL)
-   * will be a NOP if it has been initialized but it will also
-   * mean subsequent parsing of the UProf GOptionGroup will have no
-   * affect.
-   *
-   * Sadly GOptionGroup based library initialization is extremely
-   * fragile by design because GOptionGroups have no notion of
-   * dependencies and so the order things are initialized isn't
-   * currently under tight control.
-   */
-  uprof_init (NULL, NULL);
-  _cogl_uprof_init ();
-#endif
-
   /* Allocate context memory */
   context = u_malloc0 (sizeof (CoglContext));
 
@@ -295,12 +280,23 @@ cogl_context_new (CoglDisplay *display,
 
   _cogl_list_init (&context->onscreen_events_queue);
   _cogl_list_init (&context->onscreen_dirty_queue);
+  _cogl_list_init (&context->read_pixels_queue);
 
   u_queue_init (&context->gles2_context_stack);
 
   context->journal_flush_attributes_array =
     u_array_new (TRUE, FALSE, sizeof (CoglAttribute *));
   context->journal_clip_bounds = NULL;
+  context->journal_reorder_batches = NULL;
+  context->journal_reorder_batch_indices = NULL;
+  context->journal_reorder_entries = NULL;
+
+  context->worker_pool = NULL;
+
+  context->program_cache = NULL;
+  context->program_cache_initialized = FALSE;
+
+  context->trace_buffer = NULL;
 
   context->current_pipeline = NULL;
   context->current_pipeline_changes_since_flush = 0;
@@ -308,6 +304,7 @@ cogl_context_new (CoglDisplay *display,
 
   _cogl_bitmask_init (&context->enabled_custom_attributes);
   _cogl_bitmask_init (&context->enable_custom_attributes_tmp);
+  _cogl_bitmask_init (&context->instanced_attributes);
   _cogl_bitmask_init (&context->changed_bits_tmp);
 
   context->max_texture_units = -1;
@@ -340,19 +337,20 @@ cogl_context_new (CoglDisplay *display,
   context->texture_download_pipeline = NULL;
   context->blit_texture_pipeline = NULL;
 
+  context->vertex_array_cache = NULL;
+  context->default_vertex_array = 0;
+  context->current_vertex_array = 0;
+
 #if defined (HAVE_COGL_GL)
   if ((context->driver == COGL_DRIVER_GL3))
     {
-      GLuint vertex_array;
-
       /* In a forward compatible context, GL 3 doesn't support rendering
-       * using the default vertex array object. Cogl doesn't use vertex
-       * array objects yet so for now we just create a dummy array
-       * object that we will use as our own default object. Eventually
-       * it could be good to attach the vertex array objects to
-       * CoglPrimitives */
-      context->glGenVertexArrays (1, &vertex_array);
-      context->glBindVertexArray (vertex_array);
+       * using the default vertex array object so we create a dummy
+       * array object that we will use as our own default object for
+       * any attributes that don't get a cached vertex array */
+      context->glGenVertexArrays (1, &context->default_vertex_array);
+      context->glBindVertexArray (context->default_vertex_array);
+      context->current_vertex_array = context->default_vertex_array;
     }
 #endif
 
@@ -409,8 +407,12 @@ cogl_context_new (CoglDisplay *display,
   context->buffer_map_fallback_array = u_byte_array_new ();
   context->buffer_map_fallback_in_use = FALSE;
 
+  context->stream_buffer = _cogl_stream_buffer_new (context);
+
   _cogl_list_init (&context->fences);
 
+  _cogl_gpu_timing_init (context);
+
   context->atlas_set = cogl_atlas_set_new (context);
   cogl_atlas_set_set_components (context->atlas_set, COGL_TEXTURE_COMPONENTS_RGBA);
   cogl_atlas_set_set_premultiplied (context->atlas_set, FALSE);
@@ -447,10 +449,29 @@ _cogl_context_free (CoglContext *context)
 
   u_warn_if_fail (context->gles2_context_stack.length == 0);
 
+  if (context->stream_buffer)
+    _cogl_stream_buffer_free (context->stream_buffer);
+
   if (context->journal_flush_attributes_array)
     u_array_free (context->journal_flush_attributes_array, TRUE);
   if (context->journal_clip_bounds)
     u_array_free (context->journal_clip_bounds, TRUE);
+  if (context->journal_reorder_batches)
+    u_array_free (context->journal_reorder_batches, TRUE);
+  if (context->journal_reorder_batch_indices)
+    u_array_free (context->journal_reorder_batch_indices, TRUE);
+  if (context->journal_reorder_entries)
+    u_array_free (context->journal_reorder_entries, TRUE);
+
+  if (context->worker_pool)
+    _cogl_worker_pool_free (context->worker_pool);
+
+  if (context->program_cache)
+    _cogl_program_cache_free (context->program_cache);
+
+  _cogl_trace_context_free (context);
+
+  _cogl_gpu_timing_context_free (context);
 
   if (context->rectangle_byte_indices)
     cogl_object_unref (context->rectangle_byte_indices);
@@ -470,8 +491,15 @@ _cogl_context_free (CoglContext *context)
   if (context->current_clip_stack_valid)
     _cogl_clip_stack_unref (context->current_clip_stack);
 
+  if (context->vertex_array_cache)
+    {
+      u_hash_table_destroy (context->vertex_array_cache);
+      context->vertex_array_cache = NULL;
+    }
+
   _cogl_bitmask_destroy (&context->enabled_custom_attributes);
   _cogl_bitmask_destroy (&context->enable_custom_attributes_tmp);
+  _cogl_bitmask_destroy (&context->instanced_attributes);
   _cogl_bitmask_destroy (&context->changed_bits_tmp);
 
   if (context->current_modelview_entry)
@@ -507,6 +535,47 @@ _cogl_context_get_default (void)
   return _cogl_context;
 }
 
+CoglWorkerPool *
+_cogl_context_get_worker_pool (CoglContext *context)
+{
+  if (context->worker_pool == NULL)
+    context->worker_pool = _cogl_worker_pool_new ();
+
+  return context->worker_pool;
+}
+
+CoglProgramCache *
+_cogl_context_get_program_cache (CoglContext *context)
+{
+  if (!context->program_cache_initialized)
+    {
+      context->program_cache_initialized = TRUE;
+
+      if (context->glGetProgramBinary &&
+          !COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_PROGRAM_CACHES))
+        {
+          /* The binaries can only be used with exactly the same
+           * driver so anything that identifies it is put in the
+           * key */
+          char *driver_key =
+            u_strdup_printf ("%s\n%s\n%s\n%s %i\nGLSL %i",
+                             (const char *) context->glGetString (GL_VENDOR),
+                             (const char *) context->glGetString (GL_RENDERER),
+                             (const char *) context->glGetString (GL_VERSION),
+                             context->gpu.driver_package_name,
+                             context->gpu.driver_package_version,
+                             context->glsl_version_to_use);
+
+          context->program_cache =
+            _cogl_program_cache_new_from_config (driver_key);
+
+          u_free (driver_key);
+        }
+    }
+
+  return context->program_cache;
+}
+
 CoglDisplay *
 cogl_context_get_display (CoglContext *context)
 {
@@ -232,6 +232,21 @@ cogl_is_context (void *object);
  *     the depth buffer to a texture.
  * @COGL_FEATURE_ID_PRESENTATION_TIME: Whether frame presentation
  *    time stamps will be recorded in #CoglFrameInfo objects.
+ * @COGL_FEATURE_ID_GPU_TIMING: Whether the time the GPU spends
+ *    rendering can be measured using cogl_set_gpu_timing_enabled().
+ * @COGL_FEATURE_ID_INSTANCING: Whether cogl_primitive_draw_instanced()
+ *    is accelerated by the GPU. If this isn't available the instances
+ *    are expanded on the CPU instead.
+ * @COGL_FEATURE_ID_TEXTURE_ETC1: Support for uploading textures in
+ *    %COGL_PIXEL_FORMAT_ETC1_RGB_8 without decoding them on the CPU.
+ * @COGL_FEATURE_ID_TEXTURE_ETC2: Support for uploading textures in
+ *    the ETC2 compressed formats without decoding them on the CPU.
+ * @COGL_FEATURE_ID_TEXTURE_S3TC: Support for uploading textures in
+ *    the S3TC compressed formats without decoding them on the CPU.
+ * @COGL_FEATURE_ID_TEXTURE_BPTC: Support for textures in
+ *    %COGL_PIXEL_FORMAT_BPTC_RGBA.
+ * @COGL_FEATURE_ID_TEXTURE_ASTC: Support for textures in the ASTC
+ *    compressed formats.
  *
  * All the capabilities that can vary between different GPUs supported
  * by Cogl. Applications that depend on any of these features should explicitly
@@ -263,6 +278,13 @@ typedef enum _CoglFeatureID
   COGL_FEATURE_ID_FENCE,
   COGL_FEATURE_ID_PER_VERTEX_POINT_SIZE,
   COGL_FEATURE_ID_TEXTURE_RG,
+  COGL_FEATURE_ID_GPU_TIMING,
+  COGL_FEATURE_ID_INSTANCING,
+  COGL_FEATURE_ID_TEXTURE_ETC1,
+  COGL_FEATURE_ID_TEXTURE_ETC2,
+  COGL_FEATURE_ID_TEXTURE_S3TC,
+  COGL_FEATURE_ID_TEXTURE_BPTC,
+  COGL_FEATURE_ID_TEXTURE_ASTC,
 
   /*< private >*/
   _COGL_N_FEATURE_IDS   /*< skip >*/
@@ -364,6 +386,49 @@ cogl_foreach_feature (CoglContext *context,
 int64_t
 cogl_get_clock_time (CoglContext *context);
 
+/**
+ * cogl_set_gpu_timing_enabled:
+ * @context: a #CoglContext pointer
+ * @enabled: whether to measure GPU timings
+ *
+ * Enables or disables measuring how long the GPU takes to execute
+ * rendering. While enabled, every journal flush and every primitive
+ * drawn with cogl_primitive_draw() is timed using GPU timer queries,
+ * including rendering to offscreen framebuffers. The timings
+ * recorded between two swaps are attached to the #CoglFrameInfo of
+ * the onscreen framebuffer swapped next.
+ *
+ * The results are collected asynchronously without stalling the CPU.
+ * Once they are all available a %COGL_FRAME_EVENT_GPU_TIMINGS event
+ * is sent to the frame callbacks of the onscreen and the timings can
+ * be read with cogl_frame_info_get_n_gpu_timings() and related
+ * functions.
+ *
+ * This is only supported if the %COGL_FEATURE_ID_GPU_TIMING feature
+ * is available. Timing adds a small overhead to every draw so it
+ * should only be enabled while profiling.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_set_gpu_timing_enabled (CoglContext *context,
+                             CoglBool enabled);
+
+/**
+ * cogl_get_gpu_timing_enabled:
+ * @context: a #CoglContext pointer
+ *
+ * Queries whether GPU timing was enabled with
+ * cogl_set_gpu_timing_enabled().
+ *
+ * Return value: %TRUE if GPU timing is enabled
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglBool
+cogl_get_gpu_timing_enabled (CoglContext *context);
+
 COGL_END_DECLS
 
 #endif /* __COGL_CONTEXT_H__ */
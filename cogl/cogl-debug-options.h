@@ -177,6 +177,18 @@ OPT (DISABLE_FAST_READ_PIXEL,
      N_("Disable read pixel optimization"),
      N_("Disable optimization for reading 1px for simple "
         "scenes of opaque rectangles"))
+OPT (DISABLE_JOURNAL_REORDER,
+     N_("Root Cause"),
+     "disable-journal-reorder",
+     N_("Disable journal reordering"),
+     N_("Disable reordering of non-overlapping rectangles in the journal "
+        "to improve batching"))
+OPT (DISABLE_INSTANCING,
+     N_("Root Cause"),
+     "disable-instancing",
+     N_("Disable instanced drawing"),
+     N_("Expand instanced draws on the CPU even if the driver "
+        "supports instancing"))
 OPT (CLIPPING,
      N_("Cogl Tracing"),
      "clipping",
@@ -187,3 +199,9 @@ OPT (PERFORMANCE,
      "performance",
      N_("Trace performance concerns"),
      N_("Tries to highlight sub-optimal Cogl usage."))
+OPT (TRACE,
+     N_("Cogl Tracing"),
+     "trace",
+     N_("Record a trace"),
+     N_("Records timing events and writes them as Chrome trace JSON to "
+        "COGL_TRACE_FILE when the context is destroyed"))
@@ -82,7 +82,10 @@ static const UDebugKey cogl_behavioural_debug_keys[] = {
   { "wireframe", COGL_DEBUG_WIREFRAME},
   { "disable-software-clip", COGL_DEBUG_DISABLE_SOFTWARE_CLIP},
   { "disable-program-caches", COGL_DEBUG_DISABLE_PROGRAM_CACHES},
-  { "disable-fast-read-pixel", COGL_DEBUG_DISABLE_FAST_READ_PIXEL}
+  { "disable-fast-read-pixel", COGL_DEBUG_DISABLE_FAST_READ_PIXEL},
+  { "disable-journal-reorder", COGL_DEBUG_DISABLE_JOURNAL_REORDER},
+  { "disable-instancing", COGL_DEBUG_DISABLE_INSTANCING},
+  { "trace", COGL_DEBUG_TRACE}
 };
 static const int n_cogl_behavioural_debug_keys =
   U_N_ELEMENTS (cogl_behavioural_debug_keys);
@@ -73,6 +73,9 @@ typedef enum {
   COGL_DEBUG_CLIPPING,
   COGL_DEBUG_WINSYS,
   COGL_DEBUG_PERFORMANCE,
+  COGL_DEBUG_DISABLE_JOURNAL_REORDER,
+  COGL_DEBUG_DISABLE_INSTANCING,
+  COGL_DEBUG_TRACE,
 
   COGL_DEBUG_N_FLAGS
 } CoglDebugFlags;
@@ -99,6 +99,7 @@ struct _CoglDriverVtable
                                    int n_vertices,
                                    CoglAttribute **attributes,
                                    int n_attributes,
+                                   int n_instances,
                                    CoglDrawFlags flags);
 
   void
@@ -110,6 +111,7 @@ struct _CoglDriverVtable
                                            CoglIndices *indices,
                                            CoglAttribute **attributes,
                                            int n_attributes,
+                                           int n_instances,
                                            CoglDrawFlags flags);
 
   CoglBool
@@ -214,6 +216,16 @@ struct _CoglDriverVtable
                               CoglAttribute **attributes,
                               int n_attributes);
 
+  /* Discards any state that the driver has cached for the given
+   * attribute because it is about to be modified or destroyed. This
+   * is only called for attributes that the driver has marked with
+   * has_vertex_arrays so it is optional if the driver never does
+   * that.
+   */
+  void
+  (* attribute_invalidate) (CoglContext *context,
+                            CoglAttribute *attribute);
+
   /* Flushes the clip stack to the GPU using a combination of the
    * stencil buffer, scissor and clip plane state.
    */
@@ -250,6 +262,37 @@ struct _CoglDriverVtable
                        const void *data,
                        unsigned int size,
                        CoglError **error);
+
+  /* Starts timing the GPU commands submitted until the matching call
+   * to gpu_timer_end and returns a handle for the timer or 0 if it
+   * couldn't be started. Only one timer can be running at a time.
+   *
+   * The gpu_timer functions are optional and only need to be
+   * implemented if the driver sets COGL_FEATURE_ID_GPU_TIMING
+   */
+  unsigned int
+  (* gpu_timer_begin) (CoglContext *context);
+
+  void
+  (* gpu_timer_end) (CoglContext *context,
+                     unsigned int timer);
+
+  /* Retrieves the elapsed GPU time in nanoseconds without blocking.
+   * Returns FALSE if the result isn't available yet */
+  CoglBool
+  (* gpu_timer_get_result) (CoglContext *context,
+                            unsigned int timer,
+                            int64_t *elapsed);
+
+  void
+  (* gpu_timer_free) (CoglContext *context,
+                      unsigned int timer);
+
+  /* Returns TRUE if something happened since the last call, such as
+   * a change of GPU frequency, that makes the results of any timers
+   * that are currently in flight unreliable */
+  CoglBool
+  (* gpu_timer_check_disjoint) (CoglContext *context);
 };
 
 #define COGL_DRIVER_ERROR (_cogl_driver_error_domain ())
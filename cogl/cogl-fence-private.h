@@ -45,13 +45,20 @@ typedef enum
   FENCE_TYPE_ERROR
 } CoglFenceType;
 
+/* A fence in the command stream that can be checked directly instead
+ * of waiting for a callback from the main loop */
+typedef struct
+{
+  CoglFenceType type;
+  void *fence_obj;
+} CoglFenceSync;
+
 struct _CoglFenceClosure
 {
   CoglList link;
   CoglFramebuffer *framebuffer;
 
-  CoglFenceType type;
-  void *fence_obj;
+  CoglFenceSync sync;
 
   CoglFenceCallback callback;
   void *user_data;
@@ -60,6 +67,25 @@ struct _CoglFenceClosure
 void
 _cogl_fence_submit (CoglFenceClosure *fence);
 
+/* Inserts a fence after the commands that have been issued so far. If
+ * neither the winsys nor GL can create fences then the type will be
+ * set to FENCE_TYPE_ERROR */
+void
+_cogl_fence_sync_insert (CoglContext *context,
+                         CoglFenceSync *sync);
+
+/* Returns whether the GPU has passed the fence. If @wait is TRUE
+ * then this blocks until it has. A fence that couldn't be created is
+ * always reported as complete. */
+CoglBool
+_cogl_fence_sync_is_complete (CoglContext *context,
+                              CoglFenceSync *sync,
+                              CoglBool wait);
+
+void
+_cogl_fence_sync_destroy (CoglContext *context,
+                          CoglFenceSync *sync);
+
 void
 _cogl_fence_cancel_fences_for_framebuffer (CoglFramebuffer *framebuffer);
 
@@ -44,33 +44,113 @@ cogl_fence_closure_get_user_data (CoglFenceClosure *closure)
   return closure->user_data;
 }
 
-static void
-_cogl_fence_check (CoglFenceClosure *fence)
+void
+_cogl_fence_sync_insert (CoglContext *context,
+                         CoglFenceSync *sync)
 {
-  CoglContext *context = fence->framebuffer->context;
+  const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
+
+  sync->type = FENCE_TYPE_ERROR;
+  sync->fence_obj = NULL;
+
+  if (winsys->fence_add)
+    {
+      sync->fence_obj = winsys->fence_add (context);
+      if (sync->fence_obj)
+        {
+          sync->type = FENCE_TYPE_WINSYS;
+          return;
+        }
+    }
+
+#ifdef GL_ARB_sync
+  if (context->glFenceSync)
+    {
+      sync->fence_obj = context->glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE,
+                                              0);
+      if (sync->fence_obj)
+        {
+          sync->type = FENCE_TYPE_GL_ARB;
+          return;
+        }
+    }
+#endif
+}
 
-  if (fence->type == FENCE_TYPE_WINSYS)
+CoglBool
+_cogl_fence_sync_is_complete (CoglContext *context,
+                              CoglFenceSync *sync,
+                              CoglBool wait)
+{
+  if (sync->type == FENCE_TYPE_WINSYS)
     {
       const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
-      CoglBool ret;
 
-      ret = winsys->fence_is_complete (context, fence->fence_obj);
-      if (!ret)
-        return;
+      if (winsys->fence_is_complete (context, sync->fence_obj))
+        return TRUE;
+
+      /* The winsys fences can't be waited on so the only way to
+       * block is to wait for everything */
+      if (!wait)
+        return FALSE;
+
+      context->glFinish ();
     }
 #ifdef GL_ARB_sync
-  else if (fence->type == FENCE_TYPE_GL_ARB)
+  else if (sync->type == FENCE_TYPE_GL_ARB)
     {
+      GLuint64 timeout = wait ? 1000000000 /* 1 second */ : 0;
       GLenum arb;
 
-      arb = context->glClientWaitSync (fence->fence_obj,
-                                       GL_SYNC_FLUSH_COMMANDS_BIT,
-                                       0);
-      if (arb != GL_ALREADY_SIGNALED && arb != GL_CONDITION_SATISFIED)
-        return;
+      do
+        arb = context->glClientWaitSync (sync->fence_obj,
+                                         GL_SYNC_FLUSH_COMMANDS_BIT,
+                                         timeout);
+      while (wait && arb == GL_TIMEOUT_EXPIRED);
+
+      if (arb == GL_ALREADY_SIGNALED || arb == GL_CONDITION_SATISFIED)
+        return TRUE;
+
+      if (!wait)
+        return FALSE;
+
+      /* The wait failed so fall back to waiting for everything */
+      context->glFinish ();
     }
 #endif
 
+  return TRUE;
+}
+
+void
+_cogl_fence_sync_destroy (CoglContext *context,
+                          CoglFenceSync *sync)
+{
+  if (sync->type == FENCE_TYPE_WINSYS)
+    {
+      const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
+
+      winsys->fence_destroy (context, sync->fence_obj);
+    }
+#ifdef GL_ARB_sync
+  else if (sync->type == FENCE_TYPE_GL_ARB)
+    {
+      context->glDeleteSync (sync->fence_obj);
+    }
+#endif
+
+  sync->type = FENCE_TYPE_ERROR;
+  sync->fence_obj = NULL;
+}
+
+static void
+_cogl_fence_check (CoglFenceClosure *fence)
+{
+  CoglContext *context = fence->framebuffer->context;
+
+  if (!_cogl_fence_sync_is_complete (context, &fence->sync, FALSE))
+    return;
+
   fence->callback (NULL, /* dummy CoglFence object */
                    fence->user_data);
   cogl_framebuffer_cancel_fence_callback (fence->framebuffer, fence);
@@ -113,34 +193,9 @@ void
 _cogl_fence_submit (CoglFenceClosure *fence)
 {
   CoglContext *context = fence->framebuffer->context;
-  const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
 
-  fence->type = FENCE_TYPE_ERROR;
+  _cogl_fence_sync_insert (context, &fence->sync);
 
-  if (winsys->fence_add)
-    {
-      fence->fence_obj = winsys->fence_add (context);
-      if (fence->fence_obj)
-        {
-          fence->type = FENCE_TYPE_WINSYS;
-          goto done;
-        }
-    }
-
-#ifdef GL_ARB_sync
-  if (context->glFenceSync)
-    {
-      fence->fence_obj = context->glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE,
-                                               0);
-      if (fence->fence_obj)
-        {
-          fence->type = FENCE_TYPE_GL_ARB;
-          goto done;
-        }
-    }
-#endif
-
- done:
   _cogl_list_insert (context->fences.prev, &fence->link);
 
   if (!context->fences_poll_source)
@@ -169,12 +224,12 @@ cogl_framebuffer_add_fence_callback (CoglFramebuffer *framebuffer,
   fence->framebuffer = framebuffer;
   fence->callback = callback;
   fence->user_data = user_data;
-  fence->fence_obj = NULL;
+  fence->sync.fence_obj = NULL;
 
   if (journal->entries->len)
     {
       _cogl_list_insert (journal->pending_fences.prev, &fence->link);
-      fence->type = FENCE_TYPE_PENDING;
+      fence->sync.type = FENCE_TYPE_PENDING;
     }
   else
     _cogl_fence_submit (fence);
@@ -188,27 +243,10 @@ cogl_framebuffer_cancel_fence_callback (CoglFramebuffer *framebuffer,
 {
   CoglContext *context = framebuffer->context;
 
-  if (fence->type == FENCE_TYPE_PENDING)
-    {
-      _cogl_list_remove (&fence->link);
-    }
-  else
-    {
-      _cogl_list_remove (&fence->link);
-
-      if (fence->type == FENCE_TYPE_WINSYS)
-        {
-          const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
+  _cogl_list_remove (&fence->link);
 
-          winsys->fence_destroy (context, fence->fence_obj);
-        }
-#ifdef GL_ARB_sync
-      else if (fence->type == FENCE_TYPE_GL_ARB)
-        {
-          context->glDeleteSync (fence->fence_obj);
-        }
-#endif
-    }
+  if (fence->sync.type != FENCE_TYPE_PENDING)
+    _cogl_fence_sync_destroy (context, &fence->sync);
 
   u_slice_free (CoglFenceClosure, fence);
 }
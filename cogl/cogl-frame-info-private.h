@@ -34,6 +34,12 @@
 #include "cogl-frame-info.h"
 #include "cogl-object-private.h"
 
+typedef struct _CoglFrameGpuTiming
+{
+  char *label;
+  int64_t duration;
+} CoglFrameGpuTiming;
+
 struct _CoglFrameInfo
 {
   CoglObject _parent;
@@ -43,6 +49,9 @@ struct _CoglFrameInfo
   float refresh_rate;
 
   CoglOutput *output;
+
+  int64_t gpu_time;
+  UArray *gpu_timings;
 };
 
 CoglFrameInfo *_cogl_frame_info_new (void);
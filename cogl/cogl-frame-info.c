@@ -51,6 +51,18 @@ _cogl_frame_info_new (void)
 static void
 _cogl_frame_info_free (CoglFrameInfo *info)
 {
+  if (info->gpu_timings)
+    {
+      int i;
+
+      for (i = 0; i < info->gpu_timings->len; i++)
+        u_free (u_array_index (info->gpu_timings,
+                               CoglFrameGpuTiming,
+                               i).label);
+
+      u_array_free (info->gpu_timings, TRUE);
+    }
+
   u_slice_free (CoglFrameInfo, info);
 }
 
@@ -77,3 +89,39 @@ cogl_frame_info_get_output (CoglFrameInfo *info)
 {
   return info->output;
 }
+
+int64_t
+cogl_frame_info_get_gpu_time (CoglFrameInfo *info)
+{
+  return info->gpu_time;
+}
+
+int
+cogl_frame_info_get_n_gpu_timings (CoglFrameInfo *info)
+{
+  return info->gpu_timings ? info->gpu_timings->len : 0;
+}
+
+const char *
+cogl_frame_info_get_gpu_timing_label (CoglFrameInfo *info,
+                                      int index)
+{
+  _COGL_RETURN_VAL_IF_FAIL (index >= 0 &&
+                            index < cogl_frame_info_get_n_gpu_timings (info),
+                            NULL);
+
+  return u_array_index (info->gpu_timings, CoglFrameGpuTiming, index).label;
+}
+
+int64_t
+cogl_frame_info_get_gpu_timing_duration (CoglFrameInfo *info,
+                                         int index)
+{
+  _COGL_RETURN_VAL_IF_FAIL (index >= 0 &&
+                            index < cogl_frame_info_get_n_gpu_timings (info),
+                            0);
+
+  return u_array_index (info->gpu_timings,
+                        CoglFrameGpuTiming,
+                        index).duration;
+}
@@ -129,6 +129,73 @@ float cogl_frame_info_get_refresh_rate (CoglFrameInfo *info);
 CoglOutput *
 cogl_frame_info_get_output (CoglFrameInfo *info);
 
+/**
+ * cogl_frame_info_get_gpu_time:
+ * @info: a #CoglFrameInfo object
+ *
+ * Gets the total time the GPU spent executing the rendering that was
+ * submitted for this frame. This is only valid after a
+ * %COGL_FRAME_EVENT_GPU_TIMINGS event has been received for the
+ * frame. GPU timing must have been enabled with
+ * cogl_set_gpu_timing_enabled().
+ *
+ * Return value: the GPU time in nanoseconds or 0 if it is not known
+ * Since: 2.0
+ * Stability: unstable
+ */
+int64_t
+cogl_frame_info_get_gpu_time (CoglFrameInfo *info);
+
+/**
+ * cogl_frame_info_get_n_gpu_timings:
+ * @info: a #CoglFrameInfo object
+ *
+ * Gets the number of individually timed sections of GPU work that
+ * were recorded for this frame. Each journal flush and each call to
+ * cogl_primitive_draw() is a separate section. The sections are in
+ * the order they were submitted. This is only valid after a
+ * %COGL_FRAME_EVENT_GPU_TIMINGS event has been received for the
+ * frame.
+ *
+ * Return value: the number of timed sections
+ * Since: 2.0
+ * Stability: unstable
+ */
+int
+cogl_frame_info_get_n_gpu_timings (CoglFrameInfo *info);
+
+/**
+ * cogl_frame_info_get_gpu_timing_label:
+ * @info: a #CoglFrameInfo object
+ * @index: the index of a timed section
+ *
+ * Gets the label that was pushed with
+ * cogl_framebuffer_push_gpu_timing_label() on the framebuffer being
+ * rendered to when a timed section was submitted.
+ *
+ * Return value: the label or %NULL if no label was pushed
+ * Since: 2.0
+ * Stability: unstable
+ */
+const char *
+cogl_frame_info_get_gpu_timing_label (CoglFrameInfo *info,
+                                      int index);
+
+/**
+ * cogl_frame_info_get_gpu_timing_duration:
+ * @info: a #CoglFrameInfo object
+ * @index: the index of a timed section
+ *
+ * Gets the time the GPU spent executing a timed section.
+ *
+ * Return value: the duration in nanoseconds
+ * Since: 2.0
+ * Stability: unstable
+ */
+int64_t
+cogl_frame_info_get_gpu_timing_duration (CoglFrameInfo *info,
+                                         int index);
+
 COGL_END_DECLS
 
 #endif /* __COGL_FRAME_INFO_H */
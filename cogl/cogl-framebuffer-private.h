@@ -164,6 +164,11 @@ struct _CoglFramebuffer
    * framebuffers... */
   UList              *deps;
 
+  /* Stack of labels pushed with
+   * cogl_framebuffer_push_gpu_timing_label(). The top of the stack
+   * is the first link */
+  UList              *gpu_timing_labels;
+
   /* As part of an optimization for reading-back single pixels from a
    * framebuffer in some simple cases where the geometry is still
    * available in the journal we need to track the bounds of the last
@@ -307,6 +312,12 @@ _cogl_framebuffer_remove_all_dependencies (CoglFramebuffer *framebuffer);
 void
 _cogl_framebuffer_flush_journal (CoglFramebuffer *framebuffer);
 
+void
+_cogl_framebuffer_get_journal_stats (CoglFramebuffer *framebuffer,
+                                     int *n_entries,
+                                     int *n_batches,
+                                     int *n_draw_calls);
+
 void
 _cogl_framebuffer_flush_dependency_journals (CoglFramebuffer *framebuffer);
 
@@ -444,6 +455,21 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                            int n_attributes,
                                            CoglDrawFlags flags);
 
+/* Draws @n_instances instances of the attributes. @indices can be
+ * NULL. This will expand the instances on the CPU if the driver
+ * doesn't support instancing */
+void
+_cogl_framebuffer_draw_instanced (CoglFramebuffer *framebuffer,
+                                  CoglPipeline *pipeline,
+                                  CoglVerticesMode mode,
+                                  int first_vertex,
+                                  int n_vertices,
+                                  CoglIndices *indices,
+                                  CoglAttribute **attributes,
+                                  int n_attributes,
+                                  int n_instances,
+                                  CoglDrawFlags flags);
+
 gboolean
 _cogl_framebuffer_try_creating_gl_fbo (CoglContext *ctx,
                                        CoglTexture *texture,
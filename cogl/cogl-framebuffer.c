@@ -54,6 +54,9 @@
 #include "cogl-primitives-private.h"
 #include "cogl-error-private.h"
 #include "cogl-texture-gl-private.h"
+#include "cogl-gpu-timing-private.h"
+#include "cogl-instancing-private.h"
+#include "cogl-buffer-private.h"
 
 extern CoglObjectClass _cogl_onscreen_class;
 
@@ -186,6 +189,8 @@ _cogl_framebuffer_free (CoglFramebuffer *framebuffer)
 
   cogl_object_unref (framebuffer->journal);
 
+  _cogl_gpu_timing_free_labels (framebuffer);
+
   if (ctx->viewport_scissor_workaround_framebuffer == framebuffer)
     ctx->viewport_scissor_workaround_framebuffer = NULL;
 
@@ -472,6 +477,10 @@ _cogl_framebuffer_set_clip_stack (CoglFramebuffer *framebuffer,
   _cogl_clip_stack_ref (stack);
   _cogl_clip_stack_unref (framebuffer->clip_stack);
   framebuffer->clip_stack = stack;
+
+  if (framebuffer->context->current_draw_buffer == framebuffer)
+    framebuffer->context->current_draw_buffer_changes |=
+      COGL_FRAMEBUFFER_STATE_CLIP;
 }
 
 void
@@ -594,6 +603,23 @@ _cogl_framebuffer_flush_journal (CoglFramebuffer *framebuffer)
   _cogl_journal_flush (framebuffer->journal);
 }
 
+/* This is exported so that the micro-perf benchmarks can see how
+ * well the journal is batching */
+void
+_cogl_framebuffer_get_journal_stats (CoglFramebuffer *framebuffer,
+                                     int *n_entries,
+                                     int *n_batches,
+                                     int *n_draw_calls)
+{
+  CoglJournalStats stats;
+
+  _cogl_journal_get_stats (framebuffer->journal, &stats);
+
+  *n_entries = stats.n_entries;
+  *n_batches = stats.n_batches;
+  *n_draw_calls = stats.n_draw_calls;
+}
+
 void
 _cogl_framebuffer_flush (CoglFramebuffer *framebuffer)
 {
@@ -2084,20 +2110,55 @@ draw_wireframe (CoglContext *ctx,
 }
 #endif
 
-/* This can be called directly by the CoglJournal to draw attributes
- * skipping the implicit journal flush, the framebuffer flush and
- * pipeline validation. */
-void
-_cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
-                                   CoglPipeline *pipeline,
-                                   CoglVerticesMode mode,
-                                   int first_vertex,
-                                   int n_vertices,
-                                   CoglAttribute **attributes,
-                                   int n_attributes,
-                                   CoglDrawFlags flags)
+static void
+begin_draw_timing (CoglFramebuffer *framebuffer,
+                   CoglDrawFlags flags)
+{
+  /* The driver would flush the journal as part of the draw which
+   * would then be counted as part of the time for this primitive so
+   * it is flushed first to time it separately */
+  if (!(flags & COGL_DRAW_SKIP_JOURNAL_FLUSH))
+    _cogl_framebuffer_flush_journal (framebuffer);
+
+  _cogl_gpu_timing_begin (framebuffer);
+}
+
+/* Buffers that are drawn directly don't need the CPU copy that is
+ * kept for expanding instanced draws */
+static void
+release_buffer_shadows (CoglIndices *indices,
+                        CoglAttribute **attributes,
+                        int n_attributes)
 {
+  int i;
+
+  for (i = 0; i < n_attributes; i++)
+    if (attributes[i]->is_buffered)
+      _cogl_buffer_release_shadow
+        (COGL_BUFFER (attributes[i]->d.buffered.attribute_buffer));
+
+  if (indices)
+    _cogl_buffer_release_shadow (COGL_BUFFER (cogl_indices_get_buffer (indices)));
+}
+
+static void
+draw_attributes (CoglFramebuffer *framebuffer,
+                 CoglPipeline *pipeline,
+                 CoglVerticesMode mode,
+                 int first_vertex,
+                 int n_vertices,
+                 CoglIndices *indices,
+                 CoglAttribute **attributes,
+                 int n_attributes,
+                 int n_instances,
+                 CoglDrawFlags flags)
+{
+  if (U_UNLIKELY (framebuffer->context->n_buffer_shadows))
+    release_buffer_shadows (indices, attributes, n_attributes);
+
 #ifdef COGL_ENABLE_DEBUG
+  /* Note: only the geometry of the first instance is drawn in
+   * wireframe mode */
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_WIREFRAME) &&
                   (flags & COGL_DRAW_SKIP_DEBUG_WIREFRAME) == 0) &&
       mode != COGL_VERTICES_MODE_LINES &&
@@ -2106,24 +2167,68 @@ _cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
     draw_wireframe (framebuffer->context,
                     framebuffer, pipeline,
                     mode, first_vertex, n_vertices,
-                    attributes, n_attributes, NULL,
+                    attributes, n_attributes, indices,
                     flags);
   else
 #endif
     {
       CoglContext *ctx = framebuffer->context;
 
-      ctx->driver_vtable->framebuffer_draw_attributes (framebuffer,
-                                                       pipeline,
-                                                       mode,
-                                                       first_vertex,
-                                                       n_vertices,
-                                                       attributes,
-                                                       n_attributes,
-                                                       flags);
+      if (U_UNLIKELY (ctx->gpu_timing_enabled))
+        begin_draw_timing (framebuffer, flags);
+
+      if (indices)
+        ctx->driver_vtable->
+          framebuffer_draw_indexed_attributes (framebuffer,
+                                               pipeline,
+                                               mode,
+                                               first_vertex,
+                                               n_vertices,
+                                               indices,
+                                               attributes,
+                                               n_attributes,
+                                               n_instances,
+                                               flags);
+      else
+        ctx->driver_vtable->framebuffer_draw_attributes (framebuffer,
+                                                         pipeline,
+                                                         mode,
+                                                         first_vertex,
+                                                         n_vertices,
+                                                         attributes,
+                                                         n_attributes,
+                                                         n_instances,
+                                                         flags);
+
+      _cogl_gpu_timing_end (framebuffer);
     }
 }
 
+/* This can be called directly by the CoglJournal to draw attributes
+ * skipping the implicit journal flush, the framebuffer flush and
+ * pipeline validation. */
+void
+_cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
+                                   CoglPipeline *pipeline,
+                                   CoglVerticesMode mode,
+                                   int first_vertex,
+                                   int n_vertices,
+                                   CoglAttribute **attributes,
+                                   int n_attributes,
+                                   CoglDrawFlags flags)
+{
+  draw_attributes (framebuffer,
+                   pipeline,
+                   mode,
+                   first_vertex,
+                   n_vertices,
+                   NULL, /* indices */
+                   attributes,
+                   n_attributes,
+                   1, /* n_instances */
+                   flags);
+}
+
 void
 _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                            CoglPipeline *pipeline,
@@ -2135,32 +2240,66 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                            int n_attributes,
                                            CoglDrawFlags flags)
 {
-#ifdef COGL_ENABLE_DEBUG
-  if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_WIREFRAME) &&
-                  (flags & COGL_DRAW_SKIP_DEBUG_WIREFRAME) == 0) &&
-      mode != COGL_VERTICES_MODE_LINES &&
-      mode != COGL_VERTICES_MODE_LINE_LOOP &&
-      mode != COGL_VERTICES_MODE_LINE_STRIP)
-    draw_wireframe (framebuffer->context,
-                    framebuffer, pipeline,
-                    mode, first_vertex, n_vertices,
-                    attributes, n_attributes, indices,
-                    flags);
-  else
-#endif
-    {
-      CoglContext *ctx = framebuffer->context;
+  draw_attributes (framebuffer,
+                   pipeline,
+                   mode,
+                   first_vertex,
+                   n_vertices,
+                   indices,
+                   attributes,
+                   n_attributes,
+                   1, /* n_instances */
+                   flags);
+}
 
-      ctx->driver_vtable->framebuffer_draw_indexed_attributes (framebuffer,
-                                                               pipeline,
-                                                               mode,
-                                                               first_vertex,
-                                                               n_vertices,
-                                                               indices,
-                                                               attributes,
-                                                               n_attributes,
-                                                               flags);
+void
+_cogl_framebuffer_draw_instanced (CoglFramebuffer *framebuffer,
+                                  CoglPipeline *pipeline,
+                                  CoglVerticesMode mode,
+                                  int first_vertex,
+                                  int n_vertices,
+                                  CoglIndices *indices,
+                                  CoglAttribute **attributes,
+                                  int n_attributes,
+                                  int n_instances,
+                                  CoglDrawFlags flags)
+{
+  CoglContext *ctx = framebuffer->context;
+
+  if (n_instances < 1)
+    return;
+
+  /* Without instancing support the driver can't draw anything that
+   * depends on the instance so the vertices are expanded instead. The
+   * expanded attributes are only temporary so there's no point in
+   * caching their vertex array */
+  if (_cogl_instancing_needs_expansion (ctx) &&
+      (n_instances > 1 ||
+       _cogl_attributes_have_instance_divisor (attributes, n_attributes)))
+    {
+      _cogl_instancing_draw_expanded (framebuffer,
+                                      pipeline,
+                                      mode,
+                                      first_vertex,
+                                      n_vertices,
+                                      indices,
+                                      attributes,
+                                      n_attributes,
+                                      n_instances,
+                                      flags & ~COGL_DRAW_CACHE_VERTEX_ARRAY);
+      return;
     }
+
+  draw_attributes (framebuffer,
+                   pipeline,
+                   mode,
+                   first_vertex,
+                   n_vertices,
+                   indices,
+                   attributes,
+                   n_attributes,
+                   n_instances,
+                   flags);
 }
 
 void
@@ -1433,6 +1433,43 @@ cogl_framebuffer_discard_buffers (CoglFramebuffer *framebuffer,
 void
 cogl_framebuffer_finish (CoglFramebuffer *framebuffer);
 
+/**
+ * cogl_framebuffer_push_gpu_timing_label:
+ * @framebuffer: A #CoglFramebuffer pointer
+ * @label: A name for the rendering that follows
+ *
+ * Pushes a label that will be used to tag the GPU timings of any
+ * rendering to @framebuffer until the label is popped again with
+ * cogl_framebuffer_pop_gpu_timing_label(). Labels can be nested in
+ * which case only the most recently pushed label is used. This can be
+ * used to attribute the GPU cost of a frame to the parts of an
+ * application that drew it.
+ *
+ * Labels are only used when GPU timing has been enabled with
+ * cogl_set_gpu_timing_enabled(). While it is enabled, changing the
+ * label flushes any rendering already queued on @framebuffer so that
+ * it isn't tagged with the new label.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_framebuffer_push_gpu_timing_label (CoglFramebuffer *framebuffer,
+                                        const char *label);
+
+/**
+ * cogl_framebuffer_pop_gpu_timing_label:
+ * @framebuffer: A #CoglFramebuffer pointer
+ *
+ * Restores the GPU timing label that was current before the last
+ * call to cogl_framebuffer_push_gpu_timing_label().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_framebuffer_pop_gpu_timing_label (CoglFramebuffer *framebuffer);
+
 /**
  * cogl_framebuffer_read_pixels_into_bitmap:
  * @framebuffer: A #CoglFramebuffer
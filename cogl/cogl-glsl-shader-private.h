@@ -29,6 +29,8 @@
 #ifndef _COGL_GLSL_SHADER_PRIVATE_H_
 #define _COGL_GLSL_SHADER_PRIVATE_H_
 
+#include <stdint.h>
+
 void
 _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
                                                GLuint shader_gl_handle,
@@ -37,4 +39,21 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
                                                const char **strings_in,
                                                const GLint *lengths_in);
 
+/*
+ * Compiles the shader and logs a warning if it fails
+ */
+void
+_cogl_glsl_shader_compile (CoglContext *ctx,
+                           GLuint shader_gl_handle);
+
+/*
+ * Hashes the generated source for a shader so that it can be used as
+ * part of the key for the program cache
+ */
+uint64_t
+_cogl_glsl_shader_hash_source (GLenum shader_gl_type,
+                               GLsizei count,
+                               const char **strings,
+                               const GLint *lengths);
+
 #endif /* _COGL_GLSL_SHADER_PRIVATE_H_ */
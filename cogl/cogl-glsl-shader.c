@@ -39,6 +39,7 @@
 #include "cogl-context-private.h"
 #include "cogl-util-gl-private.h"
 #include "cogl-glsl-shader-private.h"
+#include "cogl-program-cache-private.h"
 #include "cogl-glsl-shader-boilerplate.h"
 
 #include <string.h>
@@ -175,3 +176,55 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
 
   u_free (version_string);
 }
+
+void
+_cogl_glsl_shader_compile (CoglContext *ctx,
+                           GLuint shader_gl_handle)
+{
+  GLint compile_status;
+  COGL_STATIC_TIMER (compile_timer,
+                     "Mainloop", /* parent */
+                     "GLSL Compile",
+                     "The time spent compiling GLSL shaders",
+                     0 /* no application private data */);
+
+  COGL_TIMER_START (ctx, compile_timer);
+  GE( ctx, glCompileShader (shader_gl_handle) );
+  GE( ctx, glGetShaderiv (shader_gl_handle,
+                          GL_COMPILE_STATUS,
+                          &compile_status) );
+  COGL_TIMER_STOP (ctx, compile_timer);
+
+  if (!compile_status)
+    {
+      GLint len = 0;
+      char *shader_log;
+
+      GE( ctx, glGetShaderiv (shader_gl_handle, GL_INFO_LOG_LENGTH, &len) );
+      shader_log = u_alloca (len);
+      GE( ctx, glGetShaderInfoLog (shader_gl_handle, len, &len, shader_log) );
+      u_warning ("Shader compilation failed:\n%s", shader_log);
+    }
+}
+
+uint64_t
+_cogl_glsl_shader_hash_source (GLenum shader_gl_type,
+                               GLsizei count,
+                               const char **strings,
+                               const GLint *lengths)
+{
+  uint64_t hash = COGL_PROGRAM_CACHE_HASH_INIT;
+  int i;
+
+  /* The boilerplate only depends on the shader type and the
+   * properties of the context which are already part of the program
+   * cache's driver key so it doesn't need to be included */
+  hash = _cogl_program_cache_hash (hash,
+                                   &shader_gl_type,
+                                   sizeof (shader_gl_type));
+
+  for (i = 0; i < count; i++)
+    hash = _cogl_program_cache_hash (hash, strings[i], lengths[i]);
+
+  return hash;
+}
@@ -0,0 +1,86 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_GPU_TIMING_PRIVATE_H__
+#define __COGL_GPU_TIMING_PRIVATE_H__
+
+#include "cogl-context.h"
+#include "cogl-framebuffer.h"
+#include "cogl-onscreen.h"
+#include "cogl-frame-info.h"
+#include "cogl-list.h"
+
+/* The maximum number of sections that will be timed between two
+ * swaps. Any work after this is not timed. This stops an application
+ * that only renders offscreen from accumulating queries forever */
+#define COGL_GPU_TIMING_MAX_SECTIONS 256
+
+typedef struct _CoglGpuTimingSection
+{
+  /* Interned in CoglContext::gpu_timing_labels */
+  const char *label;
+  unsigned int timer;
+} CoglGpuTimingSection;
+
+typedef struct _CoglGpuTimingFrame
+{
+  /* Link in CoglContext::gpu_timing_pending_frames */
+  CoglList link;
+
+  CoglOnscreen *onscreen;
+  CoglFrameInfo *info;
+
+  /* Array of CoglGpuTimingSections */
+  UArray *sections;
+} CoglGpuTimingFrame;
+
+void
+_cogl_gpu_timing_init (CoglContext *context);
+
+void
+_cogl_gpu_timing_context_free (CoglContext *context);
+
+/* Starts timing the GPU work for @framebuffer if timing is enabled.
+ * Sections can be nested but only the outermost one is timed */
+void
+_cogl_gpu_timing_begin (CoglFramebuffer *framebuffer);
+
+void
+_cogl_gpu_timing_end (CoglFramebuffer *framebuffer);
+
+/* Attaches all of the sections recorded since the last swap to
+ * @info and starts waiting for their results */
+void
+_cogl_gpu_timing_end_frame (CoglOnscreen *onscreen,
+                            CoglFrameInfo *info);
+
+void
+_cogl_gpu_timing_free_labels (CoglFramebuffer *framebuffer);
+
+#endif /* __COGL_GPU_TIMING_PRIVATE_H__ */
@@ -0,0 +1,355 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-context-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-onscreen-private.h"
+#include "cogl-frame-info-private.h"
+#include "cogl-gpu-timing-private.h"
+#include "cogl-poll-private.h"
+#include "cogl-private.h"
+
+/* How often to check for results while there are frames waiting.
+ * The results are normally available within a frame or two */
+#define GPU_TIMING_CHECK_TIMEOUT 5000 /* microseconds */
+
+void
+_cogl_gpu_timing_init (CoglContext *context)
+{
+  context->gpu_timing_enabled = FALSE;
+  context->gpu_timing_depth = 0;
+  context->gpu_timing_active = FALSE;
+  context->gpu_timing_sections = NULL;
+  _cogl_list_init (&context->gpu_timing_pending_frames);
+  context->gpu_timing_poll_source = NULL;
+  context->gpu_timing_labels = u_hash_table_new_full (u_str_hash,
+                                                      u_str_equal,
+                                                      u_free,
+                                                      NULL);
+}
+
+static void
+free_sections (CoglContext *context,
+               UArray *sections)
+{
+  int i;
+
+  for (i = 0; i < sections->len; i++)
+    {
+      CoglGpuTimingSection *section =
+        &u_array_index (sections, CoglGpuTimingSection, i);
+
+      context->driver_vtable->gpu_timer_free (context, section->timer);
+    }
+
+  u_array_free (sections, TRUE);
+}
+
+static void
+free_frame (CoglContext *context,
+            CoglGpuTimingFrame *frame)
+{
+  _cogl_list_remove (&frame->link);
+
+  free_sections (context, frame->sections);
+  cogl_object_unref (frame->onscreen);
+  cogl_object_unref (frame->info);
+
+  u_slice_free (CoglGpuTimingFrame, frame);
+}
+
+void
+_cogl_gpu_timing_context_free (CoglContext *context)
+{
+  CoglGpuTimingFrame *frame, *tmp;
+
+  _cogl_list_for_each_safe (frame, tmp,
+                            &context->gpu_timing_pending_frames,
+                            link)
+    free_frame (context, frame);
+
+  if (context->gpu_timing_sections)
+    free_sections (context, context->gpu_timing_sections);
+
+  if (context->gpu_timing_poll_source)
+    _cogl_poll_renderer_remove_source (context->display->renderer,
+                                       context->gpu_timing_poll_source);
+
+  u_hash_table_destroy (context->gpu_timing_labels);
+}
+
+void
+cogl_set_gpu_timing_enabled (CoglContext *context,
+                             CoglBool enabled)
+{
+  _COGL_RETURN_IF_FAIL (!enabled ||
+                        cogl_has_feature (context,
+                                          COGL_FEATURE_ID_GPU_TIMING));
+
+  context->gpu_timing_enabled = !!enabled;
+}
+
+CoglBool
+cogl_get_gpu_timing_enabled (CoglContext *context)
+{
+  return context->gpu_timing_enabled;
+}
+
+static const char *
+intern_label (CoglContext *context,
+              const char *label)
+{
+  char *interned = u_hash_table_lookup (context->gpu_timing_labels, label);
+
+  if (interned == NULL)
+    {
+      interned = u_strdup (label);
+      u_hash_table_insert (context->gpu_timing_labels, interned, interned);
+    }
+
+  return interned;
+}
+
+void
+_cogl_gpu_timing_begin (CoglFramebuffer *framebuffer)
+{
+  CoglContext *context = framebuffer->context;
+  CoglGpuTimingSection section;
+
+  if (!context->gpu_timing_enabled)
+    return;
+
+  /* Only one timer query can be active at a time so nested sections
+   * are just counted as part of the outermost one */
+  if (context->gpu_timing_depth++ > 0)
+    return;
+
+  if (context->gpu_timing_sections == NULL)
+    context->gpu_timing_sections =
+      u_array_new (FALSE, FALSE, sizeof (CoglGpuTimingSection));
+  else if (context->gpu_timing_sections->len >= COGL_GPU_TIMING_MAX_SECTIONS)
+    return;
+
+  section.timer = context->driver_vtable->gpu_timer_begin (context);
+  if (section.timer == 0)
+    return;
+
+  if (framebuffer->gpu_timing_labels)
+    section.label = intern_label (context,
+                                  framebuffer->gpu_timing_labels->data);
+  else
+    section.label = NULL;
+
+  u_array_append_val (context->gpu_timing_sections, section);
+  context->gpu_timing_active = TRUE;
+}
+
+void
+_cogl_gpu_timing_end (CoglFramebuffer *framebuffer)
+{
+  CoglContext *context = framebuffer->context;
+  CoglGpuTimingSection *section;
+
+  /* The depth will be zero if timing was enabled part way through a
+   * section */
+  if (context->gpu_timing_depth == 0 ||
+      --context->gpu_timing_depth > 0 ||
+      !context->gpu_timing_active)
+    return;
+
+  section = &u_array_index (context->gpu_timing_sections,
+                            CoglGpuTimingSection,
+                            context->gpu_timing_sections->len - 1);
+  context->driver_vtable->gpu_timer_end (context, section->timer);
+  context->gpu_timing_active = FALSE;
+}
+
+/* Returns TRUE and fills in @info if the results for all of the
+ * sections in @frame are available */
+static CoglBool
+collect_frame (CoglContext *context,
+               CoglGpuTimingFrame *frame)
+{
+  CoglFrameInfo *info = frame->info;
+  UArray *timings;
+  int64_t total = 0;
+  int i;
+
+  timings = u_array_sized_new (FALSE, FALSE,
+                               sizeof (CoglFrameGpuTiming),
+                               frame->sections->len);
+
+  for (i = 0; i < frame->sections->len; i++)
+    {
+      CoglGpuTimingSection *section =
+        &u_array_index (frame->sections, CoglGpuTimingSection, i);
+      CoglFrameGpuTiming timing;
+
+      if (!context->driver_vtable->gpu_timer_get_result (context,
+                                                         section->timer,
+                                                         &timing.duration))
+        {
+          u_array_free (timings, TRUE);
+          return FALSE;
+        }
+
+      timing.label = section->label ? u_strdup (section->label) : NULL;
+      total += timing.duration;
+
+      u_array_append_val (timings, timing);
+    }
+
+  info->gpu_timings = timings;
+  info->gpu_time = total;
+
+  return TRUE;
+}
+
+static void
+_cogl_gpu_timing_poll_dispatch (void *user_data, int revents)
+{
+  CoglContext *context = user_data;
+  CoglGpuTimingFrame *frame, *tmp;
+
+  /* The frames are checked in order so that the events are delivered
+   * in the same order as the frames were swapped */
+  _cogl_list_for_each_safe (frame, tmp,
+                            &context->gpu_timing_pending_frames,
+                            link)
+    {
+      if (!collect_frame (context, frame))
+        break;
+
+      /* If something like a power management change happened while
+       * the queries were running then the results are meaningless so
+       * the frame is silently dropped */
+      if (context->driver_vtable->gpu_timer_check_disjoint &&
+          context->driver_vtable->gpu_timer_check_disjoint (context))
+        {
+          CoglFrameInfo *info = frame->info;
+          int i;
+
+          for (i = 0; i < info->gpu_timings->len; i++)
+            u_free (u_array_index (info->gpu_timings,
+                                   CoglFrameGpuTiming,
+                                   i).label);
+          u_array_free (info->gpu_timings, TRUE);
+          info->gpu_timings = NULL;
+          info->gpu_time = 0;
+        }
+      else
+        _cogl_onscreen_queue_event (frame->onscreen,
+                                    COGL_FRAME_EVENT_GPU_TIMINGS,
+                                    frame->info);
+
+      free_frame (context, frame);
+    }
+}
+
+static int64_t
+_cogl_gpu_timing_poll_prepare (void *user_data)
+{
+  CoglContext *context = user_data;
+
+  if (!_cogl_list_empty (&context->gpu_timing_pending_frames))
+    return GPU_TIMING_CHECK_TIMEOUT;
+  else
+    return -1;
+}
+
+void
+_cogl_gpu_timing_end_frame (CoglOnscreen *onscreen,
+                            CoglFrameInfo *info)
+{
+  CoglContext *context = COGL_FRAMEBUFFER (onscreen)->context;
+  CoglGpuTimingFrame *frame;
+
+  if (context->gpu_timing_sections == NULL ||
+      context->gpu_timing_sections->len == 0)
+    return;
+
+  /* A section can't span a swap */
+  u_warn_if_fail (!context->gpu_timing_active);
+
+  frame = u_slice_new (CoglGpuTimingFrame);
+  frame->onscreen = cogl_object_ref (onscreen);
+  frame->info = cogl_object_ref (info);
+  frame->sections = context->gpu_timing_sections;
+  context->gpu_timing_sections = NULL;
+
+  _cogl_list_insert (context->gpu_timing_pending_frames.prev, &frame->link);
+
+  if (!context->gpu_timing_poll_source)
+    {
+      context->gpu_timing_poll_source =
+        _cogl_poll_renderer_add_source (context->display->renderer,
+                                        _cogl_gpu_timing_poll_prepare,
+                                        _cogl_gpu_timing_poll_dispatch,
+                                        context);
+    }
+}
+
+void
+cogl_framebuffer_push_gpu_timing_label (CoglFramebuffer *framebuffer,
+                                        const char *label)
+{
+  _COGL_RETURN_IF_FAIL (label != NULL);
+
+  /* Make sure the queued rendering gets the old label */
+  if (framebuffer->context->gpu_timing_enabled)
+    _cogl_framebuffer_flush_journal (framebuffer);
+
+  framebuffer->gpu_timing_labels =
+    u_list_prepend (framebuffer->gpu_timing_labels, u_strdup (label));
+}
+
+void
+cogl_framebuffer_pop_gpu_timing_label (CoglFramebuffer *framebuffer)
+{
+  UList *top = framebuffer->gpu_timing_labels;
+
+  _COGL_RETURN_IF_FAIL (top != NULL);
+
+  if (framebuffer->context->gpu_timing_enabled)
+    _cogl_framebuffer_flush_journal (framebuffer);
+
+  u_free (top->data);
+  framebuffer->gpu_timing_labels = u_list_delete_link (top, top);
+}
+
+void
+_cogl_gpu_timing_free_labels (CoglFramebuffer *framebuffer)
+{
+  u_list_free_full (framebuffer->gpu_timing_labels, u_free);
+  framebuffer->gpu_timing_labels = NULL;
+}
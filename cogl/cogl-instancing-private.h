@@ -0,0 +1,70 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_INSTANCING_PRIVATE_H
+#define __COGL_INSTANCING_PRIVATE_H
+
+#include "cogl-framebuffer.h"
+#include "cogl-pipeline.h"
+#include "cogl-indices.h"
+#include "cogl-attribute-private.h"
+#include "cogl-context.h"
+
+/* Whether instanced draws need to be expanded on the CPU, either
+ * because the driver can't draw instances or because the
+ * disable-instancing debug option is set */
+CoglBool
+_cogl_instancing_needs_expansion (CoglContext *ctx);
+
+/* Converts the vertex indices in @indices to a list of separate
+ * points, lines or triangles so that they can be repeated without
+ * the instances joining up. The converted indices are appended to
+ * @out and the mode for drawing them is returned */
+CoglVerticesMode
+_cogl_instancing_unroll_indices (CoglVerticesMode mode,
+                                 const int *indices,
+                                 int n_indices,
+                                 UArray *out);
+
+/* Draws the instances without any help from the driver by copying
+ * the data for every vertex of every instance into a temporary
+ * attribute buffer */
+void
+_cogl_instancing_draw_expanded (CoglFramebuffer *framebuffer,
+                                CoglPipeline *pipeline,
+                                CoglVerticesMode mode,
+                                int first_vertex,
+                                int n_vertices,
+                                CoglIndices *indices,
+                                CoglAttribute **attributes,
+                                int n_attributes,
+                                int n_instances,
+                                CoglDrawFlags flags);
+
+#endif /* __COGL_INSTANCING_PRIVATE_H */
@@ -0,0 +1,621 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-context-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-buffer-private.h"
+#include "cogl-attribute-buffer.h"
+#include "cogl-instancing-private.h"
+#include "cogl-error-private.h"
+#include "cogl-debug.h"
+
+#include <test-fixtures/test-unit.h>
+
+typedef struct _MappedBuffer
+{
+  CoglBuffer *buffer;
+  const uint8_t *data;
+} MappedBuffer;
+
+/* Several attributes can share a buffer but a buffer can only be
+ * mapped once so the mappings are kept in a list */
+static const uint8_t *
+map_buffer (UArray *mapped_buffers,
+            CoglBuffer *buffer)
+{
+  MappedBuffer mapped;
+  CoglError *ignore_error = NULL;
+  int i;
+
+  for (i = 0; i < mapped_buffers->len; i++)
+    {
+      MappedBuffer *other = &u_array_index (mapped_buffers, MappedBuffer, i);
+
+      if (other->buffer == buffer)
+        return other->data;
+    }
+
+  mapped.buffer = buffer;
+  mapped.data = cogl_buffer_map (buffer,
+                                 COGL_BUFFER_ACCESS_READ,
+                                 0, /* hints */
+                                 &ignore_error);
+  if (mapped.data == NULL)
+    {
+      cogl_error_free (ignore_error);
+      return NULL;
+    }
+
+  u_array_append_val (mapped_buffers, mapped);
+
+  /* The buffer is drawn instanced so if the data came from its CPU
+   * copy then the copy has to stay for the next time */
+  buffer->flags |= COGL_BUFFER_FLAG_KEEP_SHADOW;
+
+  return mapped.data;
+}
+
+static void
+unmap_buffers (UArray *mapped_buffers)
+{
+  int i;
+
+  for (i = 0; i < mapped_buffers->len; i++)
+    cogl_buffer_unmap (u_array_index (mapped_buffers, MappedBuffer, i).buffer);
+
+  u_array_set_size (mapped_buffers, 0);
+}
+
+static size_t
+sizeof_attribute_type (CoglAttributeType type)
+{
+  switch (type)
+    {
+    case COGL_ATTRIBUTE_TYPE_BYTE:
+    case COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE:
+      return 1;
+    case COGL_ATTRIBUTE_TYPE_SHORT:
+    case COGL_ATTRIBUTE_TYPE_UNSIGNED_SHORT:
+      return 2;
+    case COGL_ATTRIBUTE_TYPE_FLOAT:
+      return 4;
+    }
+
+  u_return_val_if_reached (0);
+}
+
+static int
+read_index (const uint8_t *data,
+            CoglIndicesType type,
+            int index)
+{
+  switch (type)
+    {
+    case COGL_INDICES_TYPE_UNSIGNED_BYTE:
+      return data[index];
+    case COGL_INDICES_TYPE_UNSIGNED_SHORT:
+      return ((const uint16_t *) data)[index];
+    case COGL_INDICES_TYPE_UNSIGNED_INT:
+      return ((const uint32_t *) data)[index];
+    }
+
+  u_return_val_if_reached (0);
+}
+
+static void
+warn_about_read_back_failure (void)
+{
+  static CoglBool seen = FALSE;
+
+  if (!seen)
+    {
+      u_warning ("Instancing isn't supported by the driver and the "
+                 "attribute buffers could not be read back to expand "
+                 "the instances");
+      seen = TRUE;
+    }
+}
+
+CoglBool
+_cogl_instancing_needs_expansion (CoglContext *ctx)
+{
+  return (!cogl_has_feature (ctx, COGL_FEATURE_ID_INSTANCING) ||
+          U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_INSTANCING)));
+}
+
+CoglVerticesMode
+_cogl_instancing_unroll_indices (CoglVerticesMode mode,
+                                 const int *indices,
+                                 int n_indices,
+                                 UArray *out)
+{
+  int i;
+
+  switch (mode)
+    {
+    case COGL_VERTICES_MODE_POINTS:
+      u_array_append_vals (out, indices, n_indices);
+      return COGL_VERTICES_MODE_POINTS;
+
+    case COGL_VERTICES_MODE_LINES:
+      u_array_append_vals (out, indices, n_indices - n_indices % 2);
+      return COGL_VERTICES_MODE_LINES;
+
+    case COGL_VERTICES_MODE_LINE_STRIP:
+    case COGL_VERTICES_MODE_LINE_LOOP:
+      for (i = 0; i + 1 < n_indices; i++)
+        u_array_append_vals (out, indices + i, 2);
+      if (mode == COGL_VERTICES_MODE_LINE_LOOP && n_indices > 2)
+        {
+          u_array_append_val (out, indices[n_indices - 1]);
+          u_array_append_val (out, indices[0]);
+        }
+      return COGL_VERTICES_MODE_LINES;
+
+    case COGL_VERTICES_MODE_TRIANGLES:
+      u_array_append_vals (out, indices, n_indices - n_indices % 3);
+      return COGL_VERTICES_MODE_TRIANGLES;
+
+    case COGL_VERTICES_MODE_TRIANGLE_STRIP:
+      for (i = 0; i + 2 < n_indices; i++)
+        {
+          /* Every other triangle in a strip has its first two
+           * vertices swapped to keep the winding consistent */
+          if (i & 1)
+            {
+              u_array_append_val (out, indices[i + 1]);
+              u_array_append_val (out, indices[i]);
+            }
+          else
+            u_array_append_vals (out, indices + i, 2);
+          u_array_append_val (out, indices[i + 2]);
+        }
+      return COGL_VERTICES_MODE_TRIANGLES;
+
+    case COGL_VERTICES_MODE_TRIANGLE_FAN:
+      for (i = 1; i + 1 < n_indices; i++)
+        {
+          u_array_append_val (out, indices[0]);
+          u_array_append_vals (out, indices + i, 2);
+        }
+      return COGL_VERTICES_MODE_TRIANGLES;
+    }
+
+  u_return_val_if_reached (mode);
+}
+
+void
+_cogl_instancing_draw_expanded (CoglFramebuffer *framebuffer,
+                                CoglPipeline *pipeline,
+                                CoglVerticesMode mode,
+                                int first_vertex,
+                                int n_vertices,
+                                CoglIndices *indices,
+                                CoglAttribute **attributes,
+                                int n_attributes,
+                                int n_instances,
+                                CoglDrawFlags flags)
+{
+  CoglContext *ctx = framebuffer->context;
+  UArray *mapped_buffers;
+  UArray *unrolled;
+  CoglVerticesMode unrolled_mode;
+  CoglAttribute **expanded_attributes;
+  CoglAttributeBuffer *expanded_buffer;
+  size_t *attribute_offsets;
+  int *vertex_indices;
+  int n_unrolled;
+  int n_expanded;
+  uint8_t *data = NULL;
+  size_t data_size = 0;
+  int i, j, k;
+
+  mapped_buffers = u_array_new (FALSE, FALSE, sizeof (MappedBuffer));
+  unrolled = u_array_new (FALSE, FALSE, sizeof (int));
+  vertex_indices = u_new (int, n_vertices);
+  attribute_offsets = u_new0 (size_t, n_attributes);
+
+  if (indices)
+    {
+      CoglBuffer *index_buffer = COGL_BUFFER (cogl_indices_get_buffer (indices));
+      CoglIndicesType indices_type = cogl_indices_get_type (indices);
+      const uint8_t *index_data = map_buffer (mapped_buffers, index_buffer);
+
+      if (index_data == NULL)
+        goto read_back_failed;
+
+      index_data += cogl_indices_get_offset (indices);
+
+      for (i = 0; i < n_vertices; i++)
+        vertex_indices[i] = read_index (index_data,
+                                        indices_type,
+                                        first_vertex + i);
+    }
+  else
+    {
+      for (i = 0; i < n_vertices; i++)
+        vertex_indices[i] = first_vertex + i;
+    }
+
+  /* Strips, fans and loops would join up the instances so everything
+   * is converted to a list of separate primitives */
+  unrolled_mode = _cogl_instancing_unroll_indices (mode,
+                                                   vertex_indices,
+                                                   n_vertices,
+                                                   unrolled);
+  n_unrolled = unrolled->len;
+  n_expanded = n_unrolled * n_instances;
+
+  if (n_expanded == 0)
+    goto done;
+
+  /* Each attribute gets its own tightly packed region of the
+   * temporary buffer */
+  for (i = 0; i < n_attributes; i++)
+    {
+      CoglAttribute *attribute = attributes[i];
+
+      if (!attribute->is_buffered)
+        continue;
+
+      data_size = (data_size + 3) & ~(size_t) 3;
+      attribute_offsets[i] = data_size;
+      data_size += (attribute->d.buffered.n_components *
+                    sizeof_attribute_type (attribute->d.buffered.type) *
+                    n_expanded);
+    }
+
+  data = u_malloc (data_size);
+
+  for (i = 0; i < n_attributes; i++)
+    {
+      CoglAttribute *attribute = attributes[i];
+      CoglBuffer *buffer;
+      const uint8_t *src;
+      uint8_t *dst;
+      size_t element_size;
+      size_t stride;
+      int divisor;
+
+      if (!attribute->is_buffered)
+        continue;
+
+      buffer = COGL_BUFFER (attribute->d.buffered.attribute_buffer);
+      src = map_buffer (mapped_buffers, buffer);
+      if (src == NULL)
+        goto read_back_failed;
+
+      src += attribute->d.buffered.offset;
+      element_size = (attribute->d.buffered.n_components *
+                      sizeof_attribute_type (attribute->d.buffered.type));
+      stride = attribute->d.buffered.stride ?
+        attribute->d.buffered.stride : element_size;
+      divisor = attribute->d.buffered.divisor;
+      dst = data + attribute_offsets[i];
+
+      for (k = 0; k < n_instances; k++)
+        for (j = 0; j < n_unrolled; j++)
+          {
+            int index = (divisor ?
+                         k / divisor :
+                         u_array_index (unrolled, int, j));
+
+            memcpy (dst, src + index * stride, element_size);
+            dst += element_size;
+          }
+    }
+
+  unmap_buffers (mapped_buffers);
+
+  /* The expanded buffer is never read back so it doesn't need a
+   * copy of the data */
+  expanded_buffer = cogl_attribute_buffer_new_with_size (ctx, data_size);
+  _cogl_buffer_discard_shadow (COGL_BUFFER (expanded_buffer));
+  cogl_buffer_set_data (COGL_BUFFER (expanded_buffer),
+                        0, /* offset */
+                        data,
+                        data_size,
+                        NULL);
+  expanded_attributes = u_alloca (sizeof (CoglAttribute *) * n_attributes);
+
+  for (i = 0; i < n_attributes; i++)
+    {
+      CoglAttribute *attribute = attributes[i];
+
+      if (attribute->is_buffered)
+        {
+          size_t element_size =
+            (attribute->d.buffered.n_components *
+             sizeof_attribute_type (attribute->d.buffered.type));
+
+          expanded_attributes[i] =
+            cogl_attribute_new (expanded_buffer,
+                                attribute->name_state->name,
+                                element_size,
+                                attribute_offsets[i],
+                                attribute->d.buffered.n_components,
+                                attribute->d.buffered.type);
+          cogl_attribute_set_normalized (expanded_attributes[i],
+                                         attribute->normalized);
+        }
+      else
+        expanded_attributes[i] = cogl_object_ref (attribute);
+    }
+
+  _cogl_framebuffer_draw_attributes (framebuffer,
+                                     pipeline,
+                                     unrolled_mode,
+                                     0, /* first_vertex */
+                                     n_expanded,
+                                     expanded_attributes,
+                                     n_attributes,
+                                     flags);
+
+  for (i = 0; i < n_attributes; i++)
+    cogl_object_unref (expanded_attributes[i]);
+  cogl_object_unref (expanded_buffer);
+
+  goto done;
+
+read_back_failed:
+  warn_about_read_back_failure ();
+
+done:
+  unmap_buffers (mapped_buffers);
+  u_array_free (mapped_buffers, TRUE);
+  u_array_free (unrolled, TRUE);
+  u_free (vertex_indices);
+  u_free (attribute_offsets);
+  u_free (data);
+}
+
+static void
+check_unrolled (CoglVerticesMode mode,
+                int n_indices,
+                CoglVerticesMode expected_mode,
+                const int *expected,
+                int n_expected)
+{
+  static const int indices[] = { 10, 11, 12, 13, 14 };
+  UArray *out = u_array_new (FALSE, FALSE, sizeof (int));
+  CoglVerticesMode out_mode;
+  int i;
+
+  out_mode = _cogl_instancing_unroll_indices (mode, indices, n_indices, out);
+
+  u_assert_cmpint (out_mode, ==, expected_mode);
+  u_assert_cmpint (out->len, ==, n_expected);
+  for (i = 0; i < n_expected; i++)
+    u_assert_cmpint (u_array_index (out, int, i), ==, expected[i]);
+
+  u_array_free (out, TRUE);
+}
+
+UNIT_TEST (check_instancing_unroll_indices,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  static const int strip[] = { 10, 11, 12, 12, 11, 13, 12, 13, 14 };
+  static const int fan[] = { 10, 11, 12, 10, 12, 13 };
+  static const int loop[] = { 10, 11, 11, 12, 12, 13, 13, 10 };
+  static const int triangles[] = { 10, 11, 12 };
+
+  check_unrolled (COGL_VERTICES_MODE_TRIANGLE_STRIP, 5,
+                  COGL_VERTICES_MODE_TRIANGLES,
+                  strip, U_N_ELEMENTS (strip));
+  check_unrolled (COGL_VERTICES_MODE_TRIANGLE_FAN, 4,
+                  COGL_VERTICES_MODE_TRIANGLES,
+                  fan, U_N_ELEMENTS (fan));
+  check_unrolled (COGL_VERTICES_MODE_LINE_LOOP, 4,
+                  COGL_VERTICES_MODE_LINES,
+                  loop, U_N_ELEMENTS (loop));
+  /* Incomplete primitives are dropped */
+  check_unrolled (COGL_VERTICES_MODE_TRIANGLES, 5,
+                  COGL_VERTICES_MODE_TRIANGLES,
+                  triangles, U_N_ELEMENTS (triangles));
+}
+
+UNIT_TEST (check_instancing_expanded,
+           TEST_REQUIREMENT_GLSL, /* requirements */
+           0 /* no failure cases */)
+{
+  static const CoglVertexP2 quad[] =
+    { { 0, 0 }, { 0, 10 }, { 10, 0 }, { 10, 10 } };
+  static const uint8_t quad_indices[] = { 0, 1, 2, 2, 1, 3 };
+  static const struct { float x; uint8_t r, g, b, a; } instances[] =
+    {
+      { 0, 255, 0, 0, 255 },
+      { 10, 0, 255, 0, 255 },
+      { 20, 0, 0, 255, 255 }
+    };
+  CoglAttributeBuffer *quad_buffer, *instance_buffer, *plain_buffer;
+  CoglAttribute *attributes[3], *plain_attribute;
+  CoglIndices *indices;
+  CoglPrimitive *primitive, *plain_primitive;
+  CoglPipeline *pipeline;
+  CoglSnippet *snippet;
+  CoglBool shadowed;
+  int i;
+
+  /* Force the CPU expansion even if the driver supports instancing.
+   * The buffers are created afterwards so they get the CPU copy that
+   * the expansion reads from on drivers that can't map for reading */
+  COGL_DEBUG_SET_FLAG (COGL_DEBUG_DISABLE_INSTANCING);
+
+  shadowed = !cogl_has_feature (test_ctx,
+                                COGL_FEATURE_ID_MAP_BUFFER_FOR_READ);
+
+  quad_buffer = cogl_attribute_buffer_new (test_ctx, sizeof (quad), quad);
+  instance_buffer = cogl_attribute_buffer_new (test_ctx,
+                                               sizeof (instances),
+                                               instances);
+  indices = cogl_indices_new (test_ctx,
+                              COGL_INDICES_TYPE_UNSIGNED_BYTE,
+                              quad_indices,
+                              U_N_ELEMENTS (quad_indices));
+
+  if (!(COGL_BUFFER (quad_buffer)->flags & COGL_BUFFER_FLAG_BUFFER_OBJECT))
+    shadowed = FALSE;
+
+  if (shadowed)
+    {
+      u_assert (COGL_BUFFER (quad_buffer)->shadow_data != NULL);
+      u_assert (COGL_BUFFER (cogl_indices_get_buffer (indices))->shadow_data
+                != NULL);
+    }
+
+  attributes[0] = cogl_attribute_new (quad_buffer,
+                                      "cogl_position_in",
+                                      sizeof (CoglVertexP2),
+                                      0, /* offset */
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[1] = cogl_attribute_new (instance_buffer,
+                                      "instance_x",
+                                      sizeof (instances[0]),
+                                      0, /* offset */
+                                      1, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  cogl_attribute_set_instance_divisor (attributes[1], 1);
+  attributes[2] = cogl_attribute_new (instance_buffer,
+                                      "cogl_color_in",
+                                      sizeof (instances[0]),
+                                      sizeof (float),
+                                      4, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  cogl_attribute_set_instance_divisor (attributes[2], 1);
+
+  primitive =
+    cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                        U_N_ELEMENTS (quad_indices),
+                                        attributes,
+                                        U_N_ELEMENTS (attributes));
+  cogl_primitive_set_indices (primitive,
+                              indices,
+                              U_N_ELEMENTS (quad_indices));
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX_TRANSFORM,
+                              "in float instance_x;",
+                              "cogl_position_out = "
+                              "cogl_modelview_projection_matrix * "
+                              "(cogl_position_in + "
+                              "vec4 (instance_x, 0.0, 0.0, 0.0));");
+  cogl_pipeline_add_snippet (pipeline, snippet);
+  cogl_object_unref (snippet);
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  cogl_primitive_draw_instanced (primitive,
+                                 test_fb,
+                                 pipeline,
+                                 U_N_ELEMENTS (instances));
+
+  test_utils_check_pixel (test_fb, 5, 5, 0xff0000ff);
+  test_utils_check_pixel (test_fb, 15, 5, 0x00ff00ff);
+  test_utils_check_pixel (test_fb, 25, 5, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 35, 5, 0x000000ff);
+
+  /* Drawing the quad without instancing doesn't free the copy that
+   * the instanced draw needs */
+  plain_primitive =
+    cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                        U_N_ELEMENTS (quad_indices),
+                                        attributes,
+                                        1);
+  cogl_primitive_set_indices (plain_primitive,
+                              indices,
+                              U_N_ELEMENTS (quad_indices));
+  cogl_primitive_draw (plain_primitive, test_fb, pipeline);
+  cogl_object_unref (plain_primitive);
+
+  if (shadowed)
+    u_assert (COGL_BUFFER (quad_buffer)->shadow_data != NULL);
+
+  /* Updates to the buffer have to reach the copy so that the next
+   * expansion sees them */
+  cogl_buffer_set_data (COGL_BUFFER (instance_buffer),
+                        sizeof (instances[0]) + sizeof (float),
+                        &instances[2].r,
+                        4,
+                        NULL);
+  cogl_primitive_draw_instanced (primitive,
+                                 test_fb,
+                                 pipeline,
+                                 U_N_ELEMENTS (instances));
+
+  test_utils_check_pixel (test_fb, 15, 5, 0x0000ffff);
+
+  /* A buffer that is only drawn directly doesn't keep its copy */
+  plain_buffer = cogl_attribute_buffer_new (test_ctx, sizeof (quad), quad);
+  plain_attribute = cogl_attribute_new (plain_buffer,
+                                        "cogl_position_in",
+                                        sizeof (CoglVertexP2),
+                                        0, /* offset */
+                                        2, /* n_components */
+                                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  plain_primitive =
+    cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                        U_N_ELEMENTS (quad),
+                                        &plain_attribute,
+                                        1);
+
+  if (shadowed)
+    u_assert (COGL_BUFFER (plain_buffer)->shadow_data != NULL);
+
+  cogl_primitive_draw (plain_primitive, test_fb, pipeline);
+
+  u_assert (COGL_BUFFER (plain_buffer)->shadow_data == NULL);
+
+  cogl_object_unref (plain_primitive);
+  cogl_object_unref (plain_attribute);
+  cogl_object_unref (plain_buffer);
+
+  COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_DISABLE_INSTANCING);
+
+  for (i = 0; i < U_N_ELEMENTS (attributes); i++)
+    cogl_object_unref (attributes[i]);
+  cogl_object_unref (primitive);
+  cogl_object_unref (indices);
+  cogl_object_unref (instance_buffer);
+  cogl_object_unref (quad_buffer);
+  cogl_object_unref (pipeline);
+}
@@ -36,7 +36,15 @@
 #include "cogl-clip-stack.h"
 #include "cogl-fence-private.h"
 
-#define COGL_JOURNAL_VBO_POOL_SIZE 8
+/* Counters describing how well the journal manages to batch the
+ * logged geometry. These accumulate over the lifetime of the journal
+ * and are only intended for benchmarking */
+typedef struct _CoglJournalStats
+{
+  int n_entries;
+  int n_batches;
+  int n_draw_calls;
+} CoglJournalStats;
 
 typedef struct _CoglJournal
 {
@@ -54,20 +62,12 @@ typedef struct _CoglJournal
   UArray *vertices;
   size_t needed_vbo_len;
 
-  /* A pool of attribute buffers is used so that we can avoid repeatedly
-     reallocating buffers. Only one of these buffers at a time will be
-     used by Cogl but we keep more than one alive anyway in case the
-     GL driver is internally using the buffer and it would have to
-     allocate a new one when we start writing to it */
-  CoglAttributeBuffer *vbo_pool[COGL_JOURNAL_VBO_POOL_SIZE];
-  /* The next vbo to use from the pool. We just cycle through them in
-     order */
-  unsigned int next_vbo_in_pool;
-
   int fast_read_pixel_count;
 
   CoglList pending_fences;
 
+  CoglJournalStats stats;
+
 } CoglJournal;
 
 /* To improve batching of geometry when submitting vertices to OpenGL we
@@ -115,6 +115,10 @@ _cogl_journal_try_read_pixel (CoglJournal *journal,
                               CoglBitmap *bitmap,
                               CoglBool *found_intersection);
 
+void
+_cogl_journal_get_stats (CoglJournal *journal,
+                         CoglJournalStats *stats);
+
 CoglBool
 _cogl_is_journal (void *object);
 
@@ -41,6 +41,7 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-profile.h"
+#include "cogl-gpu-timing-private.h"
 #include "cogl-attribute-private.h"
 #include "cogl-point-in-poly-private.h"
 #include "cogl-private.h"
@@ -49,6 +50,14 @@
 #include <umodule.h>
 #include <math.h>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define COGL_JOURNAL_USE_SSE2
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+#include <arm_neon.h>
+#define COGL_JOURNAL_USE_NEON
+#endif
+
 /* XXX NB:
  * The data logged in logged_vertices is formatted as follows:
  *
@@ -97,6 +106,15 @@
    to do the clip */
 #define COGL_JOURNAL_HARDWARE_CLIP_THRESHOLD 8
 
+/* When reordering the journal an entry is only compared against this
+   many of the most recent batches. This bounds the cost of the
+   reordering pass for journals that don't batch well */
+#define COGL_JOURNAL_REORDER_WINDOW 32
+
+/* The maximum number of bounding boxes used to track the area covered
+   by a batch while reordering */
+#define COGL_JOURNAL_REORDER_MAX_BOUNDS 8
+
 typedef struct _CoglJournalFlushState
 {
   CoglContext *ctx;
@@ -125,22 +143,24 @@ typedef CoglBool (*CoglJournalBatchTest) (CoglJournalEntry *entry0,
 
 static void _cogl_journal_free (CoglJournal *journal);
 
+static CoglBool
+transform_entry_to_screen_polygon (const CoglMatrix *modelview,
+                                   const CoglMatrix *projection,
+                                   const float *viewport,
+                                   const CoglJournalEntry *entry,
+                                   const float *vertices,
+                                   float *poly);
+
 COGL_OBJECT_INTERNAL_DEFINE (Journal, journal);
 
 static void
 _cogl_journal_free (CoglJournal *journal)
 {
-  int i;
-
   if (journal->entries)
     u_array_free (journal->entries, TRUE);
   if (journal->vertices)
     u_array_free (journal->vertices, TRUE);
 
-  for (i = 0; i < COGL_JOURNAL_VBO_POOL_SIZE; i++)
-    if (journal->vbo_pool[i])
-      cogl_object_unref (journal->vbo_pool[i]);
-
   u_slice_free (CoglJournal, journal);
 }
 
@@ -291,7 +311,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                      "The time spent flushing modelview + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, time_flush_modelview_and_entries);
+  COGL_TIMER_START (ctx, time_flush_modelview_and_entries);
 
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     u_print ("BATCHING:     modelview batch len = %d\n", batch_len);
@@ -302,6 +322,8 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
 
   attributes = (CoglAttribute **)state->attributes->data;
 
+  state->journal->stats.n_draw_calls++;
+
   if (!_cogl_pipeline_get_real_blend_enabled (state->pipeline))
     draw_flags |= COGL_DRAW_COLOR_ATTRIBUTE_IS_OPAQUE;
 
@@ -400,7 +422,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
 
   state->current_vertex += (4 * batch_len);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, time_flush_modelview_and_entries);
+  COGL_TIMER_STOP (ctx, time_flush_modelview_and_entries);
 }
 
 static CoglBool
@@ -425,12 +447,13 @@ _cogl_journal_flush_pipeline_and_entries (CoglJournalEntry *batch_start,
                      "The time spent flushing pipeline + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, time_flush_pipeline_entries);
+  COGL_TIMER_START (state->ctx, time_flush_pipeline_entries);
 
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     u_print ("BATCHING:    pipeline batch len = %d\n", batch_len);
 
   state->pipeline = batch_start->pipeline;
+  state->journal->stats.n_batches++;
 
   /* If we haven't transformed the quads in software then we need to also break
    * up batches according to changes in the modelview matrix... */
@@ -445,7 +468,7 @@ _cogl_journal_flush_pipeline_and_entries (CoglJournalEntry *batch_start,
   else
     _cogl_journal_flush_modelview_and_entries (batch_start, batch_len, data);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, time_flush_pipeline_entries);
+  COGL_TIMER_STOP (state->ctx, time_flush_pipeline_entries);
 }
 
 static CoglBool
@@ -544,7 +567,7 @@ _cogl_journal_flush_texcoord_vbo_offsets_and_entries (
                      "+ entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, time_flush_texcoord_pipeline_entries);
+  COGL_TIMER_START (state->ctx, time_flush_texcoord_pipeline_entries);
 
   /* NB: attributes 0 and 1 are position and color */
 
@@ -565,7 +588,7 @@ _cogl_journal_flush_texcoord_vbo_offsets_and_entries (
                   compare_entry_pipelines,
                   _cogl_journal_flush_pipeline_and_entries,
                   data);
-  COGL_TIMER_STOP (_cogl_uprof_context, time_flush_texcoord_pipeline_entries);
+  COGL_TIMER_STOP (state->ctx, time_flush_texcoord_pipeline_entries);
 }
 
 static CoglBool
@@ -596,7 +619,7 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
                      "pipeline + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context,
+  COGL_TIMER_START (ctx,
                     time_flush_vbo_texcoord_pipeline_entries);
 
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
@@ -652,19 +675,27 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
     {
       uint8_t *verts;
 
+      CoglBuffer *buffer = COGL_BUFFER (state->attribute_buffer);
+      CoglBool persistent = !!(buffer->flags & COGL_BUFFER_FLAG_MAPPED);
+
       /* Mapping a buffer for read is probably a really bad thing to
          do but this will only happen during debugging so it probably
-         doesn't matter */
-      verts = ((uint8_t *)cogl_buffer_map (COGL_BUFFER (state->attribute_buffer),
-                                           COGL_BUFFER_ACCESS_READ, 0,
-                                           NULL) +
-               state->array_offset);
+         doesn't matter. If the stream buffer is persistently mapped
+         then it can be read directly */
+      if (persistent)
+        verts = buffer->data + state->array_offset;
+      else
+        verts = ((uint8_t *)cogl_buffer_map (buffer,
+                                             COGL_BUFFER_ACCESS_READ, 0,
+                                             NULL) +
+                 state->array_offset);
 
       _cogl_journal_dump_quad_batch (verts,
                                      batch_start->n_layers,
                                      batch_len);
 
-      cogl_buffer_unmap (COGL_BUFFER (state->attribute_buffer));
+      if (!persistent)
+        cogl_buffer_unmap (buffer);
     }
 
   batch_and_call (batch_start,
@@ -678,7 +709,7 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_JOURNAL)))
     u_print ("new vbo offset = %lu\n", (unsigned long)state->array_offset);
 
-  COGL_TIMER_STOP (_cogl_uprof_context,
+  COGL_TIMER_STOP (ctx,
                    time_flush_vbo_texcoord_pipeline_entries);
 }
 
@@ -716,7 +747,7 @@ _cogl_journal_flush_clip_stacks_and_entries (CoglJournalEntry *batch_start,
                      "pipeline + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context,
+  COGL_TIMER_START (ctx,
                     time_flush_clip_stack_pipeline_entries);
 
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
@@ -752,7 +783,7 @@ _cogl_journal_flush_clip_stacks_and_entries (CoglJournalEntry *batch_start,
                   _cogl_journal_flush_vbo_offsets_and_entries, /* callback */
                   data);
 
-  COGL_TIMER_STOP (_cogl_uprof_context,
+  COGL_TIMER_STOP (ctx,
                    time_flush_clip_stack_pipeline_entries);
 }
 
@@ -1020,12 +1051,12 @@ _cogl_journal_maybe_software_clip_entries (CoglJournalEntry *batch_start,
                      "Time spent software clipping",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context,
+  COGL_TIMER_START (state->ctx,
                     time_check_software_clip);
 
   maybe_software_clip_entries (batch_start, batch_len, state);
 
-  COGL_TIMER_STOP (_cogl_uprof_context,
+  COGL_TIMER_STOP (state->ctx,
                    time_check_software_clip);
 }
 
@@ -1035,140 +1066,644 @@ compare_entry_clip_stacks (CoglJournalEntry *entry0, CoglJournalEntry *entry1)
   return entry0->clip_stack == entry1->clip_stack;
 }
 
-/* Gets a new vertex array from the pool. A reference is taken on the
-   array so it can be treated as if it was just newly allocated */
-static CoglAttributeBuffer *
-create_attribute_buffer (CoglJournal *journal,
-                         size_t n_bytes)
+typedef struct
 {
-  CoglAttributeBuffer *vbo;
-  CoglContext *ctx = journal->framebuffer->context;
+  /* The entry that started the batch. Other entries can only join the
+     batch if they could be batched together with this one */
+  CoglJournalEntry *first_entry;
+  /* The screen space area covered by the entries in the batch. A
+     single bounding box would quickly end up covering the whole
+     screen so it is tracked as a small set of boxes instead */
+  ClipBounds bounds[COGL_JOURNAL_REORDER_MAX_BOUNDS];
+  int n_bounds;
+  int n_entries;
+  /* Where the next entry of this batch will be put in the reordered
+     journal */
+  int next_slot;
+} ReorderBatch;
+
+static CoglBool
+can_reorder_into_batch (CoglJournalEntry *batch_entry,
+                        CoglJournalEntry *entry)
+{
+  if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_TRANSFORM)) &&
+      !compare_entry_modelviews (batch_entry, entry))
+    return FALSE;
+
+  return (compare_entry_clip_stacks (batch_entry, entry) &&
+          compare_entry_strides (batch_entry, entry) &&
+          compare_entry_layer_numbers (batch_entry, entry) &&
+          compare_entry_pipelines (batch_entry, entry));
+}
+
+static CoglBool
+bounds_overlap (const ClipBounds *a, const ClipBounds *b)
+{
+  /* NB: rectangles that are only touching are treated as overlapping
+     so that rounding errors in the transformed vertices can't change
+     which rectangle wins a shared pixel */
+  return (a->x_1 <= b->x_2 && b->x_1 <= a->x_2 &&
+          a->y_1 <= b->y_2 && b->y_1 <= a->y_2);
+}
+
+static double
+bounds_area (const ClipBounds *bounds)
+{
+  /* NB: this is calculated with doubles so that the area of the
+     unbounded rectangle doesn't overflow */
+  return ((double) bounds->x_2 - bounds->x_1) *
+    ((double) bounds->y_2 - bounds->y_1);
+}
+
+static void
+union_bounds (ClipBounds *a, const ClipBounds *b)
+{
+  a->x_1 = MIN (a->x_1, b->x_1);
+  a->y_1 = MIN (a->y_1, b->y_1);
+  a->x_2 = MAX (a->x_2, b->x_2);
+  a->y_2 = MAX (a->y_2, b->y_2);
+}
+
+static CoglBool
+batch_overlaps_bounds (const ReorderBatch *batch, const ClipBounds *bounds)
+{
+  int i;
 
-  /* If CoglBuffers are being emulated with malloc then there's not
-     really any point in using the pool so we'll just allocate the
-     buffer directly */
-  if (!_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_VBOS))
-    return cogl_attribute_buffer_new_with_size (ctx, n_bytes);
+  for (i = 0; i < batch->n_bounds; i++)
+    if (bounds_overlap (batch->bounds + i, bounds))
+      return TRUE;
+
+  return FALSE;
+}
 
-  vbo = journal->vbo_pool[journal->next_vbo_in_pool];
+static double
+get_merge_waste (const ClipBounds *a, const ClipBounds *b)
+{
+  ClipBounds merged = *a;
+
+  union_bounds (&merged, b);
+
+  return bounds_area (&merged) - bounds_area (a) - bounds_area (b);
+}
+
+/* Frees up a slot in the batch's bounds by merging the two boxes that
+   would cover the least amount of empty space together */
+static void
+merge_closest_batch_bounds (ReorderBatch *batch)
+{
+  double best_waste = 0;
+  int best_a = -1, best_b = -1;
+  int a, b;
+
+  for (a = 0; a < batch->n_bounds; a++)
+    for (b = a + 1; b < batch->n_bounds; b++)
+      {
+        double waste = get_merge_waste (batch->bounds + a, batch->bounds + b);
+
+        if (best_a == -1 || waste < best_waste)
+          {
+            best_a = a;
+            best_b = b;
+            best_waste = waste;
+          }
+      }
+
+  union_bounds (batch->bounds + best_a, batch->bounds + best_b);
+  batch->bounds[best_b] = batch->bounds[--batch->n_bounds];
+}
+
+static void
+add_bounds_to_batch (ReorderBatch *batch, const ClipBounds *bounds)
+{
+  double best_waste = 0;
+  int best = -1;
+  int i;
 
-  if (vbo == NULL)
+  /* Find the box that would cover the least amount of empty space if
+   * it was grown to include the new bounds. Entries drawn next to
+   * each other, such as the glyphs of a run of text, can usually be
+   * merged without wasting anything. The threshold is relative to the
+   * new bounds so that rounding errors don't count. */
+  for (i = 0; i < batch->n_bounds; i++)
     {
-      vbo = cogl_attribute_buffer_new_with_size (ctx, n_bytes);
-      journal->vbo_pool[journal->next_vbo_in_pool] = vbo;
+      double waste = get_merge_waste (batch->bounds + i, bounds);
+
+      if (best == -1 || waste < best_waste)
+        {
+          best = i;
+          best_waste = waste;
+        }
     }
-  else if (cogl_buffer_get_size (COGL_BUFFER (vbo)) < n_bytes)
+
+  if (best != -1 && best_waste <= bounds_area (bounds) / 4)
     {
-      /* If the buffer is too small then we'll just recreate it */
-      cogl_object_unref (vbo);
-      vbo = cogl_attribute_buffer_new_with_size (ctx, n_bytes);
-      journal->vbo_pool[journal->next_vbo_in_pool] = vbo;
+      union_bounds (batch->bounds + best, bounds);
+      return;
     }
 
-  journal->next_vbo_in_pool = ((journal->next_vbo_in_pool + 1) %
-                               COGL_JOURNAL_VBO_POOL_SIZE);
+  /* Otherwise the entry gets its own box. If there's no room left
+   * then it's better to merge the two existing boxes that are closest
+   * to each other than to stretch one of them all the way over to the
+   * new bounds, which would likely cover where later entries go */
+  if (batch->n_bounds >= COGL_JOURNAL_REORDER_MAX_BOUNDS)
+    merge_closest_batch_bounds (batch);
 
-  return cogl_object_ref (vbo);
+  batch->bounds[batch->n_bounds++] = *bounds;
 }
 
-static CoglAttributeBuffer *
-upload_vertices (CoglJournal *journal,
-                 const CoglJournalEntry *entries,
-                 int n_entries,
-                 size_t needed_vbo_len,
-                 UArray *vertices)
+static void
+get_entry_reorder_bounds (CoglJournal *journal,
+                          CoglJournalEntry *entry,
+                          const CoglMatrix *modelview,
+                          const CoglMatrix *projection,
+                          const float *viewport,
+                          ClipBounds *bounds)
 {
-  CoglAttributeBuffer *attribute_buffer;
-  CoglBuffer *buffer;
-  const float *vin;
-  float *vout;
-  int entry_num;
+  const float *vertices = &u_array_index (journal->vertices, float,
+                                          entry->array_offset + 1);
+  float poly[16];
   int i;
+
+  /* If a vertex snippet is used then the geometry can end up anywhere
+     and if the quad crosses the near plane then we can't easily work
+     out its screen space bounds. In either case we assume the entry
+     covers everything so that nothing will be moved past it */
+  if (_cogl_pipeline_has_vertex_snippets (entry->pipeline) ||
+      !transform_entry_to_screen_polygon (modelview, projection, viewport,
+                                          entry, vertices, poly))
+    {
+      bounds->x_1 = -G_MAXFLOAT;
+      bounds->y_1 = -G_MAXFLOAT;
+      bounds->x_2 = G_MAXFLOAT;
+      bounds->y_2 = G_MAXFLOAT;
+      return;
+    }
+
+  bounds->x_1 = bounds->x_2 = poly[0];
+  bounds->y_1 = bounds->y_2 = poly[1];
+
+  for (i = 1; i < 4; i++)
+    {
+      bounds->x_1 = MIN (bounds->x_1, poly[i * 4]);
+      bounds->y_1 = MIN (bounds->y_1, poly[i * 4 + 1]);
+      bounds->x_2 = MAX (bounds->x_2, poly[i * 4]);
+      bounds->y_2 = MAX (bounds->y_2, poly[i * 4 + 1]);
+    }
+}
+
+/* The batching done while flushing only considers adjacent entries so
+ * if an application interleaves drawing with different pipelines, for
+ * example drawing text glyphs and solid rectangles in turn, then every
+ * entry ends up in its own batch. This pass moves entries earlier in
+ * the journal so that they join an earlier batch with compatible
+ * state. An entry is only allowed to move past entries that it
+ * doesn't overlap in screen space so the paint order of anything that
+ * could affect the same pixel is preserved. */
+static void
+reorder_entries (CoglJournal *journal)
+{
+  CoglFramebuffer *framebuffer = journal->framebuffer;
+  CoglContext *ctx = framebuffer->context;
+  CoglJournalEntry *entries = (CoglJournalEntry *) journal->entries->data;
+  int n_entries = journal->entries->len;
+  CoglJournalEntry *entries_copy;
+  CoglMatrixStack *projection_stack;
   CoglMatrixEntry *last_modelview_entry = NULL;
   CoglMatrix modelview;
+  CoglMatrix projection;
+  float viewport[4];
+  ReorderBatch *batches;
+  int *batch_indices;
+  int n_batches = 0;
+  CoglBool reordered = FALSE;
+  int entry_num;
+  int batch_num;
+  int slot;
 
-  u_assert (needed_vbo_len);
+  if (ctx->journal_reorder_batches == NULL)
+    {
+      ctx->journal_reorder_batches =
+        u_array_new (FALSE, FALSE, sizeof (ReorderBatch));
+      ctx->journal_reorder_batch_indices =
+        u_array_new (FALSE, FALSE, sizeof (int));
+      ctx->journal_reorder_entries =
+        u_array_new (FALSE, FALSE, sizeof (CoglJournalEntry));
+    }
 
-  attribute_buffer = create_attribute_buffer (journal, needed_vbo_len * 4);
-  buffer = COGL_BUFFER (attribute_buffer);
-  cogl_buffer_set_update_hint (buffer, COGL_BUFFER_UPDATE_HINT_STATIC);
+  /* NB: the batches array is only grown as batches are created
+     because each batch is relatively large */
+  u_array_set_size (ctx->journal_reorder_batches, 0);
+  u_array_set_size (ctx->journal_reorder_batch_indices, n_entries);
+  batches = (ReorderBatch *) ctx->journal_reorder_batches->data;
+  batch_indices = (int *) ctx->journal_reorder_batch_indices->data;
 
-  vout = _cogl_buffer_map_range_for_fill_or_fallback (buffer,
-                                                      0, /* offset */
-                                                      needed_vbo_len * 4);
-  vin = &u_array_index (vertices, float, 0);
+  projection_stack = _cogl_framebuffer_get_projection_stack (framebuffer);
+  cogl_matrix_stack_get (projection_stack, &projection);
+  cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
 
-  /* Expand the number of vertices from 2 to 4 while uploading */
   for (entry_num = 0; entry_num < n_entries; entry_num++)
     {
-      const CoglJournalEntry *entry = entries + entry_num;
-      size_t vb_stride = GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS (entry->n_layers);
-      size_t array_stride =
-        GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
+      CoglJournalEntry *entry = entries + entry_num;
+      int first_candidate = MAX (0, n_batches - COGL_JOURNAL_REORDER_WINDOW);
+      int target_batch = -1;
+      ClipBounds bounds;
 
-      /* Copy the color to all four of the vertices */
-      for (i = 0; i < 4; i++)
-        memcpy (vout + vb_stride * i + POS_STRIDE, vin, 4);
-      vin++;
+      if (entry->modelview_entry != last_modelview_entry)
+        {
+          cogl_matrix_entry_get (entry->modelview_entry, &modelview);
+          last_modelview_entry = entry->modelview_entry;
+        }
+
+      get_entry_reorder_bounds (journal, entry,
+                                &modelview, &projection, viewport,
+                                &bounds);
+
+      /* Walk backwards through the recent batches looking for one
+       * that the entry can join. We have to stop as soon as we find
+       * a batch that the entry overlaps because the entry must be
+       * painted after it. */
+      for (batch_num = n_batches - 1; batch_num >= first_candidate; batch_num--)
+        {
+          ReorderBatch *batch = batches + batch_num;
+
+          if (can_reorder_into_batch (batch->first_entry, entry))
+            {
+              target_batch = batch_num;
+              break;
+            }
+
+          if (batch_overlaps_bounds (batch, &bounds))
+            break;
+        }
 
-      if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_TRANSFORM)))
+      if (target_batch == -1)
         {
-          vout[vb_stride * 0] = vin[0];
-          vout[vb_stride * 0 + 1] = vin[1];
-          vout[vb_stride * 1] = vin[0];
-          vout[vb_stride * 1 + 1] = vin[array_stride + 1];
-          vout[vb_stride * 2] = vin[array_stride];
-          vout[vb_stride * 2 + 1] = vin[array_stride + 1];
-          vout[vb_stride * 3] = vin[array_stride];
-          vout[vb_stride * 3 + 1] = vin[1];
+          ReorderBatch *batch;
+
+          u_array_set_size (ctx->journal_reorder_batches, n_batches + 1);
+          batches = (ReorderBatch *) ctx->journal_reorder_batches->data;
+
+          batch = batches + n_batches;
+          batch->first_entry = entry;
+          batch->bounds[0] = bounds;
+          batch->n_bounds = 1;
+          batch->n_entries = 1;
+
+          target_batch = n_batches++;
         }
       else
         {
-          float v[8];
-
-          v[0] = vin[0];
-          v[1] = vin[1];
-          v[2] = vin[0];
-          v[3] = vin[array_stride + 1];
-          v[4] = vin[array_stride];
-          v[5] = vin[array_stride + 1];
-          v[6] = vin[array_stride];
-          v[7] = vin[1];
-
-          if (entry->modelview_entry != last_modelview_entry)
-            cogl_matrix_entry_get (entry->modelview_entry, &modelview);
-          cogl_matrix_transform_points (&modelview,
-                                        2, /* n_components */
-                                        sizeof (float) * 2, /* stride_in */
-                                        v, /* points_in */
-                                        /* strideout */
-                                        vb_stride * sizeof (float),
-                                        vout, /* points_out */
-                                        4 /* n_points */);
+          ReorderBatch *batch = batches + target_batch;
+
+          add_bounds_to_batch (batch, &bounds);
+          batch->n_entries++;
+
+          if (target_batch != n_batches - 1)
+            reordered = TRUE;
         }
 
-      for (i = 0; i < entry->n_layers; i++)
+      batch_indices[entry_num] = target_batch;
+    }
+
+  if (!reordered)
+    return;
+
+  if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
+    u_print ("BATCHING: reordered journal into %d batches\n", n_batches);
+
+  for (batch_num = 0, slot = 0; batch_num < n_batches; batch_num++)
+    {
+      batches[batch_num].next_slot = slot;
+      slot += batches[batch_num].n_entries;
+    }
+
+  /* The entries keep the same offset into the logged vertices so we
+     only need to shuffle the entries themselves */
+  u_array_set_size (ctx->journal_reorder_entries, n_entries);
+  entries_copy = (CoglJournalEntry *) ctx->journal_reorder_entries->data;
+  memcpy (entries_copy, entries, sizeof (CoglJournalEntry) * n_entries);
+
+  for (entry_num = 0; entry_num < n_entries; entry_num++)
+    {
+      ReorderBatch *batch = batches + batch_indices[entry_num];
+      entries[batch->next_slot++] = entries_copy[entry_num];
+    }
+}
+
+static void
+_cogl_journal_maybe_reorder_entries (CoglJournal *journal)
+{
+  COGL_STATIC_TIMER (time_reorder,
+                     "Journal Flush", /* parent */
+                     "flush: reorder",
+                     "Time spent reordering the journal entries",
+                     0 /* no application private data */);
+
+  if (journal->entries->len < 3)
+    return;
+
+  COGL_TIMER_START (journal->framebuffer->context, time_reorder);
+
+  reorder_entries (journal);
+
+  COGL_TIMER_STOP (journal->framebuffer->context, time_reorder);
+}
+
+/* The modelview matrix is affine in the journal's 2D positions so the
+ * transformed corners of a quad can be calculated as the sum of a
+ * term that only depends on x and a term that only depends on y. This
+ * keeps the columns of the matrix that are needed ready to be
+ * multiplied with a whole run of quads using the same modelview. The
+ * vectors have a fourth component so that each corner can be written
+ * with a single store. That component lands on the vertex's color
+ * which is always written afterwards. */
+typedef struct
+{
+#if defined (COGL_JOURNAL_USE_SSE2)
+  __m128 x_axis;
+  __m128 y_axis;
+  __m128 origin;
+#elif defined (COGL_JOURNAL_USE_NEON)
+  float32x4_t x_axis;
+  float32x4_t y_axis;
+  float32x4_t origin;
+#else
+  float x_axis[3];
+  float y_axis[3];
+  float origin[3];
+#endif
+} QuadTransform;
+
+static void
+init_quad_transform (QuadTransform *transform,
+                     const CoglMatrix *modelview)
+{
+#if defined (COGL_JOURNAL_USE_SSE2)
+  transform->x_axis = _mm_setr_ps (modelview->xx,
+                                   modelview->yx,
+                                   modelview->zx,
+                                   0.0f);
+  transform->y_axis = _mm_setr_ps (modelview->xy,
+                                   modelview->yy,
+                                   modelview->zy,
+                                   0.0f);
+  transform->origin = _mm_setr_ps (modelview->xw,
+                                   modelview->yw,
+                                   modelview->zw,
+                                   0.0f);
+#elif defined (COGL_JOURNAL_USE_NEON)
+  const float x_axis[4] = { modelview->xx, modelview->yx, modelview->zx, 0 };
+  const float y_axis[4] = { modelview->xy, modelview->yy, modelview->zy, 0 };
+  const float origin[4] = { modelview->xw, modelview->yw, modelview->zw, 0 };
+
+  transform->x_axis = vld1q_f32 (x_axis);
+  transform->y_axis = vld1q_f32 (y_axis);
+  transform->origin = vld1q_f32 (origin);
+#else
+  transform->x_axis[0] = modelview->xx;
+  transform->x_axis[1] = modelview->yx;
+  transform->x_axis[2] = modelview->zx;
+  transform->y_axis[0] = modelview->xy;
+  transform->y_axis[1] = modelview->yy;
+  transform->y_axis[2] = modelview->zy;
+  transform->origin[0] = modelview->xw;
+  transform->origin[1] = modelview->yw;
+  transform->origin[2] = modelview->zw;
+#endif
+}
+
+/* Writes the transformed positions for the four corners of the quad
+   (x_1, y_1) to (x_2, y_2) in the same order as the vertices in the
+   VBO */
+static inline void
+transform_quad (const QuadTransform *transform,
+                float x_1,
+                float y_1,
+                float x_2,
+                float y_2,
+                float *vout,
+                size_t vb_stride)
+{
+#if defined (COGL_JOURNAL_USE_SSE2)
+  __m128 left = _mm_add_ps (_mm_mul_ps (transform->x_axis, _mm_set1_ps (x_1)),
+                            transform->origin);
+  __m128 right = _mm_add_ps (_mm_mul_ps (transform->x_axis, _mm_set1_ps (x_2)),
+                             transform->origin);
+  __m128 top = _mm_mul_ps (transform->y_axis, _mm_set1_ps (y_1));
+  __m128 bottom = _mm_mul_ps (transform->y_axis, _mm_set1_ps (y_2));
+
+  _mm_storeu_ps (vout, _mm_add_ps (left, top));
+  _mm_storeu_ps (vout + vb_stride, _mm_add_ps (left, bottom));
+  _mm_storeu_ps (vout + vb_stride * 2, _mm_add_ps (right, bottom));
+  _mm_storeu_ps (vout + vb_stride * 3, _mm_add_ps (right, top));
+#elif defined (COGL_JOURNAL_USE_NEON)
+  float32x4_t left = vmlaq_n_f32 (transform->origin, transform->x_axis, x_1);
+  float32x4_t right = vmlaq_n_f32 (transform->origin, transform->x_axis, x_2);
+  float32x4_t top = vmulq_n_f32 (transform->y_axis, y_1);
+  float32x4_t bottom = vmulq_n_f32 (transform->y_axis, y_2);
+
+  vst1q_f32 (vout, vaddq_f32 (left, top));
+  vst1q_f32 (vout + vb_stride, vaddq_f32 (left, bottom));
+  vst1q_f32 (vout + vb_stride * 2, vaddq_f32 (right, bottom));
+  vst1q_f32 (vout + vb_stride * 3, vaddq_f32 (right, top));
+#else
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      float left = transform->x_axis[i] * x_1 + transform->origin[i];
+      float right = transform->x_axis[i] * x_2 + transform->origin[i];
+      float top = transform->y_axis[i] * y_1;
+      float bottom = transform->y_axis[i] * y_2;
+
+      vout[i] = left + top;
+      vout[vb_stride + i] = left + bottom;
+      vout[vb_stride * 2 + i] = right + bottom;
+      vout[vb_stride * 3 + i] = right + top;
+    }
+#endif
+}
+
+/* Expands the top left and bottom right texture coordinates of each
+   layer into the four corners of the quad */
+static inline void
+expand_quad_texcoords (const float *tin,
+                       size_t array_stride,
+                       int n_layers,
+                       float *tout,
+                       size_t vb_stride)
+{
+  int i = 0;
+
+#if defined (COGL_JOURNAL_USE_SSE2) || defined (COGL_JOURNAL_USE_NEON)
+  /* Two layers fit in a vector so the t coordinates can be swapped
+     between the corners with a single select */
+#if defined (COGL_JOURNAL_USE_SSE2)
+  const __m128 t_mask = _mm_castsi128_ps (_mm_set_epi32 (-1, 0, -1, 0));
+#else
+  static const uint32_t t_mask_values[4] = { 0, ~0U, 0, ~0U };
+  const uint32x4_t t_mask = vld1q_u32 (t_mask_values);
+#endif
+
+  for (; i + 1 < n_layers; i += 2)
+    {
+#if defined (COGL_JOURNAL_USE_SSE2)
+      __m128 tl = _mm_loadu_ps (tin + i * 2);
+      __m128 br = _mm_loadu_ps (tin + array_stride + i * 2);
+      __m128 bl = _mm_or_ps (_mm_and_ps (t_mask, br),
+                             _mm_andnot_ps (t_mask, tl));
+      __m128 tr = _mm_or_ps (_mm_and_ps (t_mask, tl),
+                             _mm_andnot_ps (t_mask, br));
+
+      _mm_storeu_ps (tout + i * 2, tl);
+      _mm_storeu_ps (tout + vb_stride + i * 2, bl);
+      _mm_storeu_ps (tout + vb_stride * 2 + i * 2, br);
+      _mm_storeu_ps (tout + vb_stride * 3 + i * 2, tr);
+#else
+      float32x4_t tl = vld1q_f32 (tin + i * 2);
+      float32x4_t br = vld1q_f32 (tin + array_stride + i * 2);
+
+      vst1q_f32 (tout + i * 2, tl);
+      vst1q_f32 (tout + vb_stride + i * 2, vbslq_f32 (t_mask, br, tl));
+      vst1q_f32 (tout + vb_stride * 2 + i * 2, br);
+      vst1q_f32 (tout + vb_stride * 3 + i * 2, vbslq_f32 (t_mask, tl, br));
+#endif
+    }
+#endif /* COGL_JOURNAL_USE_SSE2 || COGL_JOURNAL_USE_NEON */
+
+  for (; i < n_layers; i++)
+    {
+      tout[vb_stride * 0 + i * 2] = tin[i * 2];
+      tout[vb_stride * 0 + 1 + i * 2] = tin[i * 2 + 1];
+      tout[vb_stride * 1 + i * 2] = tin[i * 2];
+      tout[vb_stride * 1 + 1 + i * 2] = tin[array_stride + i * 2 + 1];
+      tout[vb_stride * 2 + i * 2] = tin[array_stride + i * 2];
+      tout[vb_stride * 2 + 1 + i * 2] = tin[array_stride + i * 2 + 1];
+      tout[vb_stride * 3 + i * 2] = tin[array_stride + i * 2];
+      tout[vb_stride * 3 + 1 + i * 2] = tin[i * 2 + 1];
+    }
+}
+
+/* Writes the vertices for a run of entries that all share the same
+   modelview. If transform is NULL then the positions are written
+   untransformed */
+static float *
+upload_entry_run (const QuadTransform *transform,
+                  const CoglJournalEntry *entries,
+                  int n_entries,
+                  UArray *vertices,
+                  float *vout)
+{
+  int entry_num;
+  int i;
+
+  for (entry_num = 0; entry_num < n_entries; entry_num++)
+    {
+      const CoglJournalEntry *entry = entries + entry_num;
+      size_t vb_stride = GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS (entry->n_layers);
+      size_t array_stride =
+        GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
+      /* NB: the entries may have been reordered so they aren't
+         necessarily in the same order as the logged vertices */
+      const float *vin = &u_array_index (vertices, float, entry->array_offset);
+      const float *pos = vin + 1;
+
+      if (transform)
+        transform_quad (transform,
+                        pos[0], pos[1],
+                        pos[array_stride], pos[array_stride + 1],
+                        vout, vb_stride);
+      else
         {
-          const float *tin = vin + 2;
-          float *tout = vout + POS_STRIDE + COLOR_STRIDE;
-
-          tout[vb_stride * 0 + i * 2] = tin[i * 2];
-          tout[vb_stride * 0 + 1 + i * 2] = tin[i * 2 + 1];
-          tout[vb_stride * 1 + i * 2] = tin[i * 2];
-          tout[vb_stride * 1 + 1 + i * 2] = tin[array_stride + i * 2 + 1];
-          tout[vb_stride * 2 + i * 2] = tin[array_stride + i * 2];
-          tout[vb_stride * 2 + 1 + i * 2] = tin[array_stride + i * 2 + 1];
-          tout[vb_stride * 3 + i * 2] = tin[array_stride + i * 2];
-          tout[vb_stride * 3 + 1 + i * 2] = tin[i * 2 + 1];
+          vout[vb_stride * 0] = pos[0];
+          vout[vb_stride * 0 + 1] = pos[1];
+          vout[vb_stride * 1] = pos[0];
+          vout[vb_stride * 1 + 1] = pos[array_stride + 1];
+          vout[vb_stride * 2] = pos[array_stride];
+          vout[vb_stride * 2 + 1] = pos[array_stride + 1];
+          vout[vb_stride * 3] = pos[array_stride];
+          vout[vb_stride * 3 + 1] = pos[1];
         }
 
-      vin += array_stride * 2;
+      /* Copy the color to all four of the vertices. This has to be
+         done after the positions because transform_quad may write
+         over it */
+      for (i = 0; i < 4; i++)
+        memcpy (vout + vb_stride * i + POS_STRIDE, vin, 4);
+
+      expand_quad_texcoords (pos + 2,
+                             array_stride,
+                             entry->n_layers,
+                             vout + POS_STRIDE + COLOR_STRIDE,
+                             vb_stride);
+
       vout += vb_stride * 4;
     }
 
-  _cogl_buffer_unmap_for_fill_or_fallback (buffer);
+  return vout;
+}
+
+/* Uploads the vertices into a region of the context's stream buffer.
+ * A reference is taken on the returned buffer and the region needs to
+ * be released once everything has been drawn from it */
+static CoglAttributeBuffer *
+upload_vertices (CoglJournal *journal,
+                 const CoglJournalEntry *entries,
+                 int n_entries,
+                 size_t needed_vbo_len,
+                 UArray *vertices,
+                 size_t *offset_out)
+{
+  CoglContext *ctx = journal->framebuffer->context;
+  CoglAttributeBuffer *attribute_buffer;
+  float *vout;
+
+  u_assert (needed_vbo_len);
+
+  vout = _cogl_stream_buffer_map (ctx->stream_buffer,
+                                  needed_vbo_len * 4,
+                                  &attribute_buffer,
+                                  offset_out);
+
+  /* Expand the number of vertices from 2 to 4 while uploading. The
+     entries are handled in runs that share a modelview so that the
+     matrix only has to be looked up once per run */
+  if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_TRANSFORM)))
+    {
+      upload_entry_run (NULL, entries, n_entries, vertices, vout);
+    }
+  else
+    {
+      int run_start = 0;
+
+      while (run_start < n_entries)
+        {
+          CoglMatrixEntry *modelview_entry =
+            entries[run_start].modelview_entry;
+          CoglMatrix modelview;
+          QuadTransform transform;
+          int run_end = run_start + 1;
+
+          while (run_end < n_entries &&
+                 entries[run_end].modelview_entry == modelview_entry)
+            run_end++;
+
+          cogl_matrix_entry_get (modelview_entry, &modelview);
+          init_quad_transform (&transform, &modelview);
+
+          vout = upload_entry_run (&transform,
+                                   entries + run_start,
+                                   run_end - run_start,
+                                   vertices,
+                                   vout);
+
+          run_start = run_end;
+        }
+    }
+
+  _cogl_stream_buffer_unmap (ctx->stream_buffer);
 
-  return attribute_buffer;
+  return cogl_object_ref (attribute_buffer);
 }
 
 void
@@ -1317,7 +1852,9 @@ _cogl_journal_flush (CoglJournal *journal)
 
   /* Note: we start the timer after flushing dependency journals so
    * that the timer isn't started recursively. */
-  COGL_TIMER_START (_cogl_uprof_context, flush_timer);
+  COGL_TIMER_START (ctx, flush_timer);
+
+  _cogl_gpu_timing_begin (framebuffer);
 
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     u_print ("BATCHING: journal len = %d\n", journal->entries->len);
@@ -1339,6 +1876,11 @@ _cogl_journal_flush (CoglJournal *journal)
 
   state.attributes = ctx->journal_flush_attributes_array;
 
+  journal->stats.n_entries += journal->entries->len;
+
+  if (U_LIKELY (!COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_JOURNAL_REORDER)))
+    _cogl_journal_maybe_reorder_entries (journal);
+
   if (U_UNLIKELY ((COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SOFTWARE_CLIP)) == 0))
     {
       /* We do an initial walk of the journal to analyse the clip stack
@@ -1360,8 +1902,8 @@ _cogl_journal_flush (CoglJournal *journal)
                      &u_array_index (journal->entries, CoglJournalEntry, 0),
                      journal->entries->len,
                      journal->needed_vbo_len,
-                     journal->vertices);
-  state.array_offset = 0;
+                     journal->vertices,
+                     &state.array_offset);
 
   /* batch_and_call() batches a list of journal entries according to some
    * given criteria and calls a callback once for each determined batch.
@@ -1397,14 +1939,17 @@ _cogl_journal_flush (CoglJournal *journal)
   u_array_set_size (state.attributes, 0);
 
   cogl_object_unref (state.attribute_buffer);
+  _cogl_stream_buffer_release (ctx->stream_buffer);
 
-  COGL_TIMER_START (_cogl_uprof_context, discard_timer);
+  _cogl_gpu_timing_end (framebuffer);
+
+  COGL_TIMER_START (ctx, discard_timer);
   _cogl_journal_discard (journal);
-  COGL_TIMER_STOP (_cogl_uprof_context, discard_timer);
+  COGL_TIMER_STOP (ctx, discard_timer);
 
   post_fences (journal);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, flush_timer);
+  COGL_TIMER_STOP (ctx, flush_timer);
 }
 
 static CoglBool
@@ -1450,7 +1995,7 @@ _cogl_journal_log_quad (CoglJournal  *journal,
                      "The time spent logging in the Cogl journal",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, log_timer);
+  COGL_TIMER_START (framebuffer->context, log_timer);
 
   /* Adding something to the journal should mean that we are in the
    * middle of the scene. Although this will also end up being set
@@ -1558,22 +2103,33 @@ _cogl_journal_log_quad (CoglJournal  *journal,
   if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_BATCHING)))
     _cogl_journal_flush (journal);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
+  COGL_TIMER_STOP (framebuffer->context, log_timer);
 }
 
-static void
-entry_to_screen_polygon (CoglFramebuffer *framebuffer,
-                         const CoglJournalEntry *entry,
-                         float *vertices,
-                         float *poly)
+/* Scale from OpenGL normalized device coordinates (ranging from -1 to 1)
+ * to Cogl window/framebuffer coordinates (ranging from 0 to buffer-size) with
+ * (0,0) being top left. */
+#define VIEWPORT_TRANSFORM_X(x, vp_origin_x, vp_width) \
+    (  ( ((x) + 1.0) * ((vp_width) / 2.0) ) + (vp_origin_x)  )
+/* Note: for Y we first flip all coordinates around the X axis while in
+ * normalized device coodinates */
+#define VIEWPORT_TRANSFORM_Y(y, vp_origin_y, vp_height) \
+    (  ( ((-(y)) + 1.0) * ((vp_height) / 2.0) ) + (vp_origin_y)  )
+
+/* Returns FALSE if any of the vertices end up behind the viewer in
+ * which case the screen coordinates aren't meaningful */
+static CoglBool
+transform_entry_to_screen_polygon (const CoglMatrix *modelview,
+                                   const CoglMatrix *projection,
+                                   const float *viewport,
+                                   const CoglJournalEntry *entry,
+                                   const float *vertices,
+                                   float *poly)
 {
   size_t array_stride =
     GET_JOURNAL_ARRAY_STRIDE_FOR_N_LAYERS (entry->n_layers);
-  CoglMatrixStack *projection_stack;
-  CoglMatrix projection;
-  CoglMatrix modelview;
+  CoglBool in_front = TRUE;
   int i;
-  float viewport[4];
 
   poly[0] = vertices[0];
   poly[1] = vertices[1];
@@ -1599,8 +2155,7 @@ entry_to_screen_polygon (CoglFramebuffer *framebuffer,
    * _cogl_transform_points utility...
    */
 
-  cogl_matrix_entry_get (entry->modelview_entry, &modelview);
-  cogl_matrix_transform_points (&modelview,
+  cogl_matrix_transform_points (modelview,
                                 2, /* n_components */
                                 sizeof (float) * 4, /* stride_in */
                                 poly, /* points_in */
@@ -1609,11 +2164,7 @@ entry_to_screen_polygon (CoglFramebuffer *framebuffer,
                                 poly, /* points_out */
                                 4 /* n_points */);
 
-  projection_stack =
-    _cogl_framebuffer_get_projection_stack (framebuffer);
-  cogl_matrix_stack_get (projection_stack, &projection);
-
-  cogl_matrix_project_points (&projection,
+  cogl_matrix_project_points (projection,
                               3, /* n_components */
                               sizeof (float) * 4, /* stride_in */
                               poly, /* points_in */
@@ -1622,24 +2173,15 @@ entry_to_screen_polygon (CoglFramebuffer *framebuffer,
                               poly, /* points_out */
                               4 /* n_points */);
 
-  cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
-
-/* Scale from OpenGL normalized device coordinates (ranging from -1 to 1)
- * to Cogl window/framebuffer coordinates (ranging from 0 to buffer-size) with
- * (0,0) being top left. */
-#define VIEWPORT_TRANSFORM_X(x, vp_origin_x, vp_width) \
-    (  ( ((x) + 1.0) * ((vp_width) / 2.0) ) + (vp_origin_x)  )
-/* Note: for Y we first flip all coordinates around the X axis while in
- * normalized device coodinates */
-#define VIEWPORT_TRANSFORM_Y(y, vp_origin_y, vp_height) \
-    (  ( ((-(y)) + 1.0) * ((vp_height) / 2.0) ) + (vp_origin_y)  )
-
   /* Scale from normalized device coordinates (in range [-1,1]) to
    * window coordinates ranging [0,window-size] ... */
   for (i = 0; i < 4; i++)
     {
       float w = poly[4 * i + 3];
 
+      if (w <= 0)
+        in_front = FALSE;
+
       /* Perform perspective division */
       poly[4 * i] /= w;
       poly[4 * i + 1] /= w;
@@ -1651,8 +2193,33 @@ entry_to_screen_polygon (CoglFramebuffer *framebuffer,
                                               viewport[1], viewport[3]);
     }
 
+  return in_front;
+}
+
 #undef VIEWPORT_TRANSFORM_X
 #undef VIEWPORT_TRANSFORM_Y
+
+static void
+entry_to_screen_polygon (CoglFramebuffer *framebuffer,
+                         const CoglJournalEntry *entry,
+                         float *vertices,
+                         float *poly)
+{
+  CoglMatrixStack *projection_stack;
+  CoglMatrix projection;
+  CoglMatrix modelview;
+  float viewport[4];
+
+  cogl_matrix_entry_get (entry->modelview_entry, &modelview);
+
+  projection_stack =
+    _cogl_framebuffer_get_projection_stack (framebuffer);
+  cogl_matrix_stack_get (projection_stack, &projection);
+
+  cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
+
+  transform_entry_to_screen_polygon (&modelview, &projection, viewport,
+                                     entry, vertices, poly);
 }
 
 static CoglBool
@@ -1728,6 +2295,13 @@ try_checking_point_hits_entry_after_clipping (CoglFramebuffer *framebuffer,
   return TRUE;
 }
 
+void
+_cogl_journal_get_stats (CoglJournal *journal,
+                         CoglJournalStats *stats)
+{
+  *stats = journal->stats;
+}
+
 CoglBool
 _cogl_journal_try_read_pixel (CoglJournal *journal,
                               int x,
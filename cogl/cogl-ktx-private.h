@@ -0,0 +1,74 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_KTX_PRIVATE_H
+#define __COGL_KTX_PRIVATE_H
+
+#include "cogl-types.h"
+#include "cogl-error.h"
+
+/* The compressed image data read from a KTX or KTX2 file. The data
+ * contains all of the mipmap levels packed one after the other
+ * starting with the largest and it is owned by the caller once the
+ * image has been successfully loaded */
+typedef struct _CoglKtxImage
+{
+  int width;
+  int height;
+  CoglPixelFormat format;
+  int n_levels;
+  uint8_t *data;
+  size_t data_size;
+} CoglKtxImage;
+
+/*
+ * _cogl_ktx_is_ktx_file:
+ * @filename: The name of the file to check
+ *
+ * Peeks at the start of @filename to check whether it is a KTX or
+ * KTX2 file. This doesn't validate anything beyond the identifier
+ * so _cogl_ktx_load_from_file() can still fail.
+ *
+ * Return value: %TRUE if the file starts with a KTX identifier
+ */
+CoglBool
+_cogl_ktx_is_ktx_file (const char *filename);
+
+CoglBool
+_cogl_ktx_load_from_data (const uint8_t *data,
+                          size_t size,
+                          CoglKtxImage *image,
+                          CoglError **error);
+
+CoglBool
+_cogl_ktx_load_from_file (const char *filename,
+                          CoglKtxImage *image,
+                          CoglError **error);
+
+#endif /* __COGL_KTX_PRIVATE_H */
@@ -0,0 +1,541 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cogl-util.h"
+#include "cogl-bitmap.h"
+#include "cogl-private.h"
+#include "cogl-ktx-private.h"
+#include "cogl-compressed-format-private.h"
+#include "cogl-error-private.h"
+
+#include <test-fixtures/test-unit.h>
+
+#define KTX_IDENTIFIER_SIZE 12
+#define KTX1_HEADER_SIZE 64
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+#define KTX1_ENDIANNESS 0x04030201
+
+static const uint8_t
+ktx1_identifier[KTX_IDENTIFIER_SIZE] =
+  { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+static const uint8_t
+ktx2_identifier[KTX_IDENTIFIER_SIZE] =
+  { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+typedef struct
+{
+  unsigned int gl_internal_format;
+  unsigned int vk_format;
+  CoglPixelFormat format;
+} CoglKtxFormat;
+
+/* Only the formats that have a corresponding CoglPixelFormat are
+ * listed. ETC1 has no Vulkan format because it is a subset of ETC2 */
+static const CoglKtxFormat
+ktx_formats[] =
+  {
+    { GL_ETC1_RGB8_OES, 0, COGL_PIXEL_FORMAT_ETC1_RGB_8 },
+    { GL_COMPRESSED_RGB8_ETC2, 147, COGL_PIXEL_FORMAT_ETC2_RGB_8 },
+    { GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, 149,
+      COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1 },
+    { GL_COMPRESSED_RGBA8_ETC2_EAC, 151, COGL_PIXEL_FORMAT_ETC2_RGBA_8 },
+    { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 131, COGL_PIXEL_FORMAT_S3TC_DXT1_RGB },
+    { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 133,
+      COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA },
+    { GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, 135,
+      COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA },
+    { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 137,
+      COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA },
+    { GL_COMPRESSED_RGBA_BPTC_UNORM, 145, COGL_PIXEL_FORMAT_BPTC_RGBA },
+    { GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 157, COGL_PIXEL_FORMAT_ASTC_4x4_RGBA },
+    { GL_COMPRESSED_RGBA_ASTC_6x6_KHR, 165, COGL_PIXEL_FORMAT_ASTC_6x6_RGBA },
+    { GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 171, COGL_PIXEL_FORMAT_ASTC_8x8_RGBA }
+  };
+
+static uint32_t
+read_uint32 (const uint8_t *p,
+             CoglBool swap)
+{
+  if (swap)
+    return (((uint32_t) p[0] << 24) |
+            ((uint32_t) p[1] << 16) |
+            ((uint32_t) p[2] << 8) |
+            (uint32_t) p[3]);
+  else
+    return (((uint32_t) p[3] << 24) |
+            ((uint32_t) p[2] << 16) |
+            ((uint32_t) p[1] << 8) |
+            (uint32_t) p[0]);
+}
+
+static uint64_t
+read_uint64_le (const uint8_t *p)
+{
+  return ((uint64_t) read_uint32 (p + 4, FALSE) << 32) |
+    read_uint32 (p, FALSE);
+}
+
+/* KTX1 stores the header fields in the byte order of the machine that
+ * wrote the file. The endianness field tells us whether it matches
+ * the little-endian order that read_uint32 assumes by default */
+static CoglBool
+ktx1_needs_swap (const uint8_t *data)
+{
+  return read_uint32 (data + KTX_IDENTIFIER_SIZE, FALSE) != KTX1_ENDIANNESS;
+}
+
+static CoglBool
+set_corrupt_error (CoglError **error,
+                   const char *message)
+{
+  _cogl_set_error (error,
+                   COGL_BITMAP_ERROR,
+                   COGL_BITMAP_ERROR_CORRUPT_IMAGE,
+                   "Invalid KTX file: %s",
+                   message);
+  return FALSE;
+}
+
+static CoglBool
+check_dimensions (uint32_t width,
+                  uint32_t height,
+                  uint32_t depth,
+                  uint32_t n_array_elements,
+                  uint32_t n_faces,
+                  uint32_t n_levels,
+                  CoglError **error)
+{
+  if (width == 0 || height == 0 || width > 65536 || height > 65536)
+    return set_corrupt_error (error, "bad image size");
+
+  if (depth > 1 || n_array_elements > 1 || n_faces != 1)
+    {
+      _cogl_set_error (error,
+                       COGL_BITMAP_ERROR,
+                       COGL_BITMAP_ERROR_UNKNOWN_TYPE,
+                       "Only single 2D images are supported "
+                       "from KTX files");
+      return FALSE;
+    }
+
+  if (n_levels > _cogl_util_fls (MAX (width, height)))
+    return set_corrupt_error (error, "too many mipmap levels");
+
+  return TRUE;
+}
+
+static CoglBool
+lookup_format (CoglBool vulkan,
+               uint32_t value,
+               CoglPixelFormat *format,
+               CoglError **error)
+{
+  int i;
+
+  for (i = 0; i < U_N_ELEMENTS (ktx_formats); i++)
+    {
+      unsigned int id = (vulkan ?
+                         ktx_formats[i].vk_format :
+                         ktx_formats[i].gl_internal_format);
+
+      if (id != 0 && id == value)
+        {
+          *format = ktx_formats[i].format;
+          return TRUE;
+        }
+    }
+
+  _cogl_set_error (error,
+                   COGL_BITMAP_ERROR,
+                   COGL_BITMAP_ERROR_UNKNOWN_TYPE,
+                   "Unsupported KTX texture format 0x%x",
+                   (unsigned int) value);
+
+  return FALSE;
+}
+
+static CoglBool
+load_ktx1 (const uint8_t *data,
+           size_t size,
+           CoglKtxImage *image,
+           CoglError **error)
+{
+  CoglBool swap;
+  uint32_t internal_format;
+  uint32_t width, height, depth;
+  uint32_t n_array_elements, n_faces, n_levels;
+  uint32_t key_value_size;
+  CoglPixelFormat format;
+  size_t offset;
+  size_t data_size;
+  uint8_t *dst;
+  int level;
+
+  if (size < KTX1_HEADER_SIZE)
+    return set_corrupt_error (error, "truncated header");
+
+  swap = ktx1_needs_swap (data);
+  if (swap && read_uint32 (data + 12, TRUE) != KTX1_ENDIANNESS)
+    return set_corrupt_error (error, "bad endianness field");
+
+  internal_format = read_uint32 (data + 28, swap);
+  width = read_uint32 (data + 36, swap);
+  height = read_uint32 (data + 40, swap);
+  depth = read_uint32 (data + 44, swap);
+  n_array_elements = read_uint32 (data + 48, swap);
+  n_faces = read_uint32 (data + 52, swap);
+  n_levels = read_uint32 (data + 56, swap);
+  key_value_size = read_uint32 (data + 60, swap);
+
+  /* Zero levels means the loader should generate the mipmaps but we
+   * leave that to the texture */
+  if (n_levels == 0)
+    n_levels = 1;
+
+  if (!lookup_format (FALSE, internal_format, &format, error) ||
+      !check_dimensions (width, height, depth,
+                         n_array_elements, n_faces, n_levels,
+                         error))
+    return FALSE;
+
+  if (key_value_size > size - KTX1_HEADER_SIZE)
+    return set_corrupt_error (error, "truncated key/value data");
+
+  data_size = _cogl_compressed_format_get_data_size (format,
+                                                     width, height,
+                                                     n_levels);
+  dst = u_malloc (data_size);
+  image->data = dst;
+
+  offset = KTX1_HEADER_SIZE + key_value_size;
+
+  for (level = 0; level < n_levels; level++)
+    {
+      size_t level_size =
+        _cogl_compressed_format_get_image_size (format,
+                                                MAX (width >> level, 1),
+                                                MAX (height >> level, 1));
+
+      if (size - offset < 4 ||
+          read_uint32 (data + offset, swap) != level_size ||
+          size - offset - 4 < level_size)
+        {
+          u_free (dst);
+          return set_corrupt_error (error, "bad mipmap level size");
+        }
+
+      offset += 4;
+      memcpy (dst, data + offset, level_size);
+      dst += level_size;
+
+      /* Each level is padded to a multiple of four bytes */
+      offset += (level_size + 3) & ~(size_t) 3;
+      offset = MIN (offset, size);
+    }
+
+  image->width = width;
+  image->height = height;
+  image->format = format;
+  image->n_levels = n_levels;
+  image->data_size = data_size;
+
+  return TRUE;
+}
+
+static CoglBool
+load_ktx2 (const uint8_t *data,
+           size_t size,
+           CoglKtxImage *image,
+           CoglError **error)
+{
+  uint32_t vk_format;
+  uint32_t width, height, depth;
+  uint32_t n_layers, n_faces, n_levels;
+  uint32_t supercompression_scheme;
+  CoglPixelFormat format;
+  size_t data_size;
+  uint8_t *dst;
+  int level;
+
+  if (size < KTX2_HEADER_SIZE)
+    return set_corrupt_error (error, "truncated header");
+
+  /* KTX2 is always little-endian */
+  vk_format = read_uint32 (data + 12, FALSE);
+  width = read_uint32 (data + 20, FALSE);
+  height = read_uint32 (data + 24, FALSE);
+  depth = read_uint32 (data + 28, FALSE);
+  n_layers = read_uint32 (data + 32, FALSE);
+  n_faces = read_uint32 (data + 36, FALSE);
+  n_levels = read_uint32 (data + 40, FALSE);
+  supercompression_scheme = read_uint32 (data + 44, FALSE);
+
+  if (n_levels == 0)
+    n_levels = 1;
+
+  if (!lookup_format (TRUE, vk_format, &format, error) ||
+      !check_dimensions (width, height, depth,
+                         n_layers, n_faces, n_levels,
+                         error))
+    return FALSE;
+
+  if (supercompression_scheme != 0)
+    {
+      _cogl_set_error (error,
+                       COGL_BITMAP_ERROR,
+                       COGL_BITMAP_ERROR_UNKNOWN_TYPE,
+                       "Supercompressed KTX2 files are not supported");
+      return FALSE;
+    }
+
+  if ((size - KTX2_HEADER_SIZE) / KTX2_LEVEL_INDEX_ENTRY_SIZE < n_levels)
+    return set_corrupt_error (error, "truncated level index");
+
+  data_size = _cogl_compressed_format_get_data_size (format,
+                                                     width, height,
+                                                     n_levels);
+  dst = u_malloc (data_size);
+  image->data = dst;
+
+  /* The level index is always ordered from the base level but the
+   * data itself is stored with the smallest level first so each one
+   * is copied separately */
+  for (level = 0; level < n_levels; level++)
+    {
+      const uint8_t *entry = (data + KTX2_HEADER_SIZE +
+                              level * KTX2_LEVEL_INDEX_ENTRY_SIZE);
+      uint64_t level_offset = read_uint64_le (entry);
+      uint64_t level_length = read_uint64_le (entry + 8);
+      size_t level_size =
+        _cogl_compressed_format_get_image_size (format,
+                                                MAX (width >> level, 1),
+                                                MAX (height >> level, 1));
+
+      if (level_length != level_size ||
+          level_offset > size ||
+          size - level_offset < level_size)
+        {
+          u_free (image->data);
+          return set_corrupt_error (error, "bad mipmap level size");
+        }
+
+      memcpy (dst, data + level_offset, level_size);
+      dst += level_size;
+    }
+
+  image->width = width;
+  image->height = height;
+  image->format = format;
+  image->n_levels = n_levels;
+  image->data_size = data_size;
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_ktx_is_ktx_file (const char *filename)
+{
+  uint8_t identifier[KTX_IDENTIFIER_SIZE];
+  CoglBool ret = FALSE;
+  FILE *file;
+
+  file = fopen (filename, "rb");
+  if (file == NULL)
+    return FALSE;
+
+  if (fread (identifier, 1, sizeof (identifier), file) == sizeof (identifier))
+    ret = (!memcmp (identifier, ktx1_identifier, sizeof (identifier)) ||
+           !memcmp (identifier, ktx2_identifier, sizeof (identifier)));
+
+  fclose (file);
+
+  return ret;
+}
+
+CoglBool
+_cogl_ktx_load_from_data (const uint8_t *data,
+                          size_t size,
+                          CoglKtxImage *image,
+                          CoglError **error)
+{
+  if (size >= KTX_IDENTIFIER_SIZE)
+    {
+      if (!memcmp (data, ktx1_identifier, KTX_IDENTIFIER_SIZE))
+        return load_ktx1 (data, size, image, error);
+      else if (!memcmp (data, ktx2_identifier, KTX_IDENTIFIER_SIZE))
+        return load_ktx2 (data, size, image, error);
+    }
+
+  _cogl_set_error (error,
+                   COGL_BITMAP_ERROR,
+                   COGL_BITMAP_ERROR_UNKNOWN_TYPE,
+                   "Not a KTX file");
+
+  return FALSE;
+}
+
+CoglBool
+_cogl_ktx_load_from_file (const char *filename,
+                          CoglKtxImage *image,
+                          CoglError **error)
+{
+  char *contents;
+  size_t length;
+  CoglBool ret;
+
+  if (!u_file_get_contents (filename, &contents, &length, NULL))
+    {
+      _cogl_set_error (error,
+                       COGL_BITMAP_ERROR,
+                       COGL_BITMAP_ERROR_FAILED,
+                       "Failed to read %s",
+                       filename);
+      return FALSE;
+    }
+
+  ret = _cogl_ktx_load_from_data ((const uint8_t *) contents,
+                                  length,
+                                  image,
+                                  error);
+
+  u_free (contents);
+
+  return ret;
+}
+
+static void
+write_uint32_le (uint8_t *p,
+                 uint32_t value)
+{
+  p[0] = value & 0xff;
+  p[1] = (value >> 8) & 0xff;
+  p[2] = (value >> 16) & 0xff;
+  p[3] = value >> 24;
+}
+
+UNIT_TEST (check_ktx1_load,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  /* An 8x8 ETC1 image with two mipmap levels and four bytes of
+   * key/value data */
+  uint8_t file[KTX1_HEADER_SIZE + 4 + 4 + 32 + 4 + 8];
+  CoglKtxImage image;
+  CoglError *error = NULL;
+  int i;
+
+  memset (file, 0, sizeof (file));
+  memcpy (file, ktx1_identifier, KTX_IDENTIFIER_SIZE);
+  write_uint32_le (file + 12, KTX1_ENDIANNESS);
+  write_uint32_le (file + 28, GL_ETC1_RGB8_OES);
+  write_uint32_le (file + 36, 8);
+  write_uint32_le (file + 40, 8);
+  write_uint32_le (file + 52, 1);
+  write_uint32_le (file + 56, 2);
+  write_uint32_le (file + 60, 4);
+  write_uint32_le (file + 68, 32);
+  for (i = 0; i < 32; i++)
+    file[72 + i] = i;
+  write_uint32_le (file + 104, 8);
+  for (i = 0; i < 8; i++)
+    file[108 + i] = 100 + i;
+
+  u_assert (_cogl_ktx_load_from_data (file, sizeof (file), &image, &error));
+  u_assert_cmpint (image.width, ==, 8);
+  u_assert_cmpint (image.height, ==, 8);
+  u_assert_cmpint (image.format, ==, COGL_PIXEL_FORMAT_ETC1_RGB_8);
+  u_assert_cmpint (image.n_levels, ==, 2);
+  u_assert_cmpint (image.data_size, ==, 40);
+  u_assert_cmpint (image.data[31], ==, 31);
+  u_assert_cmpint (image.data[32], ==, 100);
+  u_free (image.data);
+
+  /* A level that is too small for the image should be rejected */
+  write_uint32_le (file + 68, 24);
+  u_assert (!_cogl_ktx_load_from_data (file, sizeof (file), &image, &error));
+  u_assert_cmpint (error->code, ==, COGL_BITMAP_ERROR_CORRUPT_IMAGE);
+  cogl_error_free (error);
+}
+
+UNIT_TEST (check_ktx2_load,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  /* An 8x4 DXT1 image with two levels stored smallest first */
+  uint8_t file[KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_ENTRY_SIZE * 2 + 8 + 16];
+  int data_offset = KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_ENTRY_SIZE * 2;
+  CoglKtxImage image;
+  CoglError *error = NULL;
+  int i;
+
+  memset (file, 0, sizeof (file));
+  memcpy (file, ktx2_identifier, KTX_IDENTIFIER_SIZE);
+  write_uint32_le (file + 12, 131);
+  write_uint32_le (file + 20, 8);
+  write_uint32_le (file + 24, 4);
+  write_uint32_le (file + 36, 1);
+  write_uint32_le (file + 40, 2);
+  /* Level 0 */
+  write_uint32_le (file + KTX2_HEADER_SIZE, data_offset + 8);
+  write_uint32_le (file + KTX2_HEADER_SIZE + 8, 16);
+  write_uint32_le (file + KTX2_HEADER_SIZE + 16, 16);
+  /* Level 1 */
+  write_uint32_le (file + KTX2_HEADER_SIZE + 24, data_offset);
+  write_uint32_le (file + KTX2_HEADER_SIZE + 32, 8);
+  write_uint32_le (file + KTX2_HEADER_SIZE + 40, 8);
+  for (i = 0; i < 24; i++)
+    file[data_offset + i] = i;
+
+  u_assert (_cogl_ktx_load_from_data (file, sizeof (file), &image, &error));
+  u_assert_cmpint (image.width, ==, 8);
+  u_assert_cmpint (image.height, ==, 4);
+  u_assert_cmpint (image.format, ==, COGL_PIXEL_FORMAT_S3TC_DXT1_RGB);
+  u_assert_cmpint (image.n_levels, ==, 2);
+  u_assert_cmpint (image.data_size, ==, 24);
+  /* The base level should have been moved to the front */
+  u_assert_cmpint (image.data[0], ==, 8);
+  u_assert_cmpint (image.data[16], ==, 0);
+  u_free (image.data);
+
+  /* Supercompression isn't supported */
+  write_uint32_le (file + 44, 1);
+  u_assert (!_cogl_ktx_load_from_data (file, sizeof (file), &image, &error));
+  u_assert_cmpint (error->code, ==, COGL_BITMAP_ERROR_UNKNOWN_TYPE);
+  cogl_error_free (error);
+}
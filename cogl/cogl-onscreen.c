@@ -41,6 +41,7 @@
 #include "cogl-object-private.h"
 #include "cogl-closure-list-private.h"
 #include "cogl-poll-private.h"
+#include "cogl-gpu-timing-private.h"
 
 static void _cogl_onscreen_free (CoglOnscreen *onscreen);
 
@@ -243,6 +244,11 @@ cogl_onscreen_swap_buffers_with_damage (CoglOnscreen *onscreen,
   CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (onscreen);
   const CoglWinsysVtable *winsys;
   CoglFrameInfo *info;
+  COGL_STATIC_TIMER (swap_buffers_timer,
+                     "Mainloop", /* parent */
+                     "Swap Buffers",
+                     "The time spent in the winsys swapping buffers",
+                     0 /* no application private data */);
 
   _COGL_RETURN_IF_FAIL  (framebuffer->type == COGL_FRAMEBUFFER_TYPE_ONSCREEN);
 
@@ -252,9 +258,13 @@ cogl_onscreen_swap_buffers_with_damage (CoglOnscreen *onscreen,
 
   _cogl_framebuffer_flush_journal (framebuffer);
 
+  _cogl_gpu_timing_end_frame (onscreen, info);
+
   winsys = _cogl_framebuffer_get_winsys (framebuffer);
+  COGL_TIMER_START (framebuffer->context, swap_buffers_timer);
   winsys->onscreen_swap_buffers_with_damage (onscreen,
                                              rectangles, n_rectangles);
+  COGL_TIMER_STOP (framebuffer->context, swap_buffers_timer);
   cogl_framebuffer_discard_buffers (framebuffer,
                                     COGL_BUFFER_BIT_COLOR |
                                     COGL_BUFFER_BIT_DEPTH |
@@ -292,6 +302,11 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
   CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (onscreen);
   const CoglWinsysVtable *winsys;
   CoglFrameInfo *info;
+  COGL_STATIC_TIMER (swap_region_timer,
+                     "Mainloop", /* parent */
+                     "Swap Region",
+                     "The time spent in the winsys swapping a region",
+                     0 /* no application private data */);
 
   _COGL_RETURN_IF_FAIL  (framebuffer->type == COGL_FRAMEBUFFER_TYPE_ONSCREEN);
 
@@ -301,15 +316,19 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
 
   _cogl_framebuffer_flush_journal (framebuffer);
 
+  _cogl_gpu_timing_end_frame (onscreen, info);
+
   winsys = _cogl_framebuffer_get_winsys (framebuffer);
 
   /* This should only be called if the winsys advertises
      COGL_WINSYS_FEATURE_SWAP_REGION */
   _COGL_RETURN_IF_FAIL (winsys->onscreen_swap_region != NULL);
 
+  COGL_TIMER_START (framebuffer->context, swap_region_timer);
   winsys->onscreen_swap_region (COGL_ONSCREEN (framebuffer),
                                 rectangles,
                                 n_rectangles);
+  COGL_TIMER_STOP (framebuffer->context, swap_region_timer);
 
   cogl_framebuffer_discard_buffers (framebuffer,
                                     COGL_BUFFER_BIT_COLOR |
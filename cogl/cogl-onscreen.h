@@ -511,7 +511,20 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
  *                             since the #CoglFrameInfo should hold
  *                             the most data at this point. No other
  *                             events should be expected after a
- *                             @COGL_FRAME_EVENT_COMPLETE event.
+ *                             @COGL_FRAME_EVENT_COMPLETE event
+ *                             except for a
+ *                             @COGL_FRAME_EVENT_GPU_TIMINGS event.
+ * @COGL_FRAME_EVENT_GPU_TIMINGS: Notifies that the GPU timings of a
+ *                                frame have been collected. This is
+ *                                only sent if GPU timing was enabled
+ *                                with cogl_set_gpu_timing_enabled()
+ *                                and anything was rendered for the
+ *                                frame. It is not sent if the driver
+ *                                reports that the measurements were
+ *                                invalidated, for example by a change
+ *                                of GPU clock. It can arrive before or
+ *                                after the @COGL_FRAME_EVENT_COMPLETE
+ *                                event.
  *
  * Identifiers that are passed to #CoglFrameCallback functions
  * (registered using cogl_onscreen_add_frame_callback()) that
@@ -534,7 +547,8 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
 typedef enum _CoglFrameEvent
 {
   COGL_FRAME_EVENT_SYNC = 1,
-  COGL_FRAME_EVENT_COMPLETE
+  COGL_FRAME_EVENT_COMPLETE,
+  COGL_FRAME_EVENT_GPU_TIMINGS
 } CoglFrameEvent;
 
 /**
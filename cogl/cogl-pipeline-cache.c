@@ -118,6 +118,22 @@ _cogl_pipeline_cache_get_combined_template (CoglPipelineCache *cache,
                                         key_pipeline);
 }
 
+void
+_cogl_pipeline_cache_get_stats (CoglPipelineCache *cache,
+                                CoglPipelineCacheStats *vertex_stats,
+                                CoglPipelineCacheStats *fragment_stats,
+                                CoglPipelineCacheStats *combined_stats)
+{
+  if (vertex_stats)
+    _cogl_pipeline_hash_table_get_stats (&cache->vertex_hash, vertex_stats);
+  if (fragment_stats)
+    _cogl_pipeline_hash_table_get_stats (&cache->fragment_hash,
+                                         fragment_stats);
+  if (combined_stats)
+    _cogl_pipeline_hash_table_get_stats (&cache->combined_hash,
+                                         combined_stats);
+}
+
 #ifdef ENABLE_UNIT_TESTS
 
 static void
@@ -166,6 +182,7 @@ UNIT_TEST (check_pipeline_pruning,
     &test_ctx->pipeline_cache->fragment_hash;
   CoglPipelineHashTable *combined_hash =
     &test_ctx->pipeline_cache->combined_hash;
+  CoglPipelineCacheStats stats;
   int i;
 
   fb_width = cogl_framebuffer_get_width (test_fb);
@@ -178,36 +195,45 @@ UNIT_TEST (check_pipeline_pruning,
                                  -1,
                                  100);
 
-  /* Create 18 unique pipelines. This should end up being more than
-   * the initial expected minimum size so it will trigger the garbage
-   * collection. However all of the pipelines will be in use so they
-   * won't be collected */
+  /* Limit the tables to fewer entries than the number of pipelines
+   * that will be created so that eviction gets triggered */
+  fragment_hash->max_entries = 16;
+  combined_hash->max_entries = 16;
+
+  /* Create 18 unique pipelines. This is more than the budget but all
+   * of the pipelines will be in use so they won't be evicted */
   create_pipelines (pipelines, 18);
 
-  /* These pipelines should all have unique entries in the cache. We
-   * should have run the garbage collection once and at that point the
-   * expected minimum size would have been 17 */
   u_assert_cmpint (u_hash_table_size (fragment_hash->table), ==, 18);
   u_assert_cmpint (u_hash_table_size (combined_hash->table), ==, 18);
-  u_assert_cmpint (fragment_hash->expected_min_size, ==, 17);
-  u_assert_cmpint (combined_hash->expected_min_size, ==, 17);
+
+  _cogl_pipeline_cache_get_stats (test_ctx->pipeline_cache,
+                                  NULL, /* vertex */
+                                  &stats,
+                                  NULL /* combined */);
+  u_assert_cmpint (stats.n_entries, ==, 18);
+  u_assert_cmpint (stats.n_misses, ==, 18);
+  u_assert_cmpint (stats.n_evictions, ==, 0);
 
   /* Destroy the original pipelines and create some new ones. This
-   * should run the garbage collector again but this time the
-   * pipelines won't be in use so it should free some of them */
+   * time the old pipelines won't be in use so they should be evicted
+   * as the new ones are added */
   for (i = 0; i < 18; i++)
     cogl_object_unref (pipelines[i]);
 
   create_pipelines (pipelines, 18);
 
-  /* The garbage collection should have freed half of the original 18
-   * pipelines which means there should now be 18*1.5 = 27 */
-  u_assert_cmpint (u_hash_table_size (fragment_hash->table), ==, 27);
-  u_assert_cmpint (u_hash_table_size (combined_hash->table), ==, 27);
-  /* The 35th pipeline would have caused the garbage collection. At
-   * that point there would be 35-18=17 used unique pipelines. */
-  u_assert_cmpint (fragment_hash->expected_min_size, ==, 17);
-  u_assert_cmpint (combined_hash->expected_min_size, ==, 17);
+  /* All of the old entries should have been evicted because the 18
+   * new ones that are in use are already over budget */
+  u_assert_cmpint (u_hash_table_size (fragment_hash->table), ==, 18);
+  u_assert_cmpint (u_hash_table_size (combined_hash->table), ==, 18);
+
+  _cogl_pipeline_cache_get_stats (test_ctx->pipeline_cache,
+                                  NULL, /* vertex */
+                                  &stats,
+                                  NULL /* combined */);
+  u_assert_cmpint (stats.n_misses, ==, 36);
+  u_assert_cmpint (stats.n_evictions, ==, 18);
 
   for (i = 0; i < 18; i++)
     cogl_object_unref (pipelines[i]);
@@ -44,6 +44,19 @@ typedef struct
   int usage_count;
 } CoglPipelineCacheEntry;
 
+typedef struct
+{
+  /* The number of entries currently in the table and the number it
+   * tries to stay under */
+  int n_entries;
+  int max_entries;
+
+  /* Running totals since the cache was created */
+  unsigned long n_hits;
+  unsigned long n_misses;
+  unsigned long n_evictions;
+} CoglPipelineCacheStats;
+
 CoglPipelineCache *
 _cogl_pipeline_cache_new (void);
 
@@ -90,4 +103,15 @@ CoglPipelineCacheEntry *
 _cogl_pipeline_cache_get_combined_template (CoglPipelineCache *cache,
                                             CoglPipeline *key_pipeline);
 
+/*
+ * Retrieves the counters for each of the three template tables. Any
+ * of the stats pointers can be NULL if the caller isn't interested
+ * in that table.
+ */
+void
+_cogl_pipeline_cache_get_stats (CoglPipelineCache *cache,
+                                CoglPipelineCacheStats *vertex_stats,
+                                CoglPipelineCacheStats *fragment_stats,
+                                CoglPipelineCacheStats *combined_stats);
+
 #endif /* __COGL_PIPELINE_CACHE_H__ */
@@ -35,10 +35,24 @@
 #include "config.h"
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "cogl-context-private.h"
 #include "cogl-pipeline-private.h"
 #include "cogl-pipeline-hash-table.h"
 #include "cogl-pipeline-cache.h"
+#include "cogl-config-private.h"
+
+/* The number of entries each table will try to stay under unless it
+ * is overridden with the COGL_PIPELINE_CACHE_MAX_ENTRIES option */
+#define COGL_PIPELINE_HASH_TABLE_DEFAULT_MAX_ENTRIES 64
+
+/* When the table is over budget, adding a pipeline will only look at
+ * this many entries from the old end of the list. This keeps the cost
+ * of each insertion bounded so that there are no spikes when lots of
+ * the entries are still in use. */
+#define COGL_PIPELINE_HASH_TABLE_MAX_EVICTION_SCAN 8
 
 typedef struct
 {
@@ -56,9 +70,8 @@ typedef struct
    * entry as both the key and the value */
   CoglPipelineHashTable *hash;
 
-  /* The number of unique pipelines that had been created when this
-   * pipeline was last accessed */
-  int age;
+  /* Link in the hash table's LRU list */
+  CoglList lru_link;
 } CoglPipelineHashTableEntry;
 
 static void
@@ -66,6 +79,8 @@ value_destroy_cb (void *value)
 {
   CoglPipelineHashTableEntry *entry = value;
 
+  _cogl_list_remove (&entry->lru_link);
+
   cogl_object_unref (entry->parent.pipeline);
 
   u_slice_free (CoglPipelineHashTableEntry, entry);
@@ -94,6 +109,24 @@ entry_equal (const void *a,
                                0);
 }
 
+static int
+get_max_entries (void)
+{
+  const char *max_entries_string;
+  int max_entries;
+
+  max_entries_string = u_getenv ("COGL_PIPELINE_CACHE_MAX_ENTRIES");
+  if (max_entries_string == NULL)
+    max_entries_string = _cogl_config_pipeline_cache_max_entries;
+
+  if (max_entries_string == NULL)
+    return COGL_PIPELINE_HASH_TABLE_DEFAULT_MAX_ENTRIES;
+
+  max_entries = atoi (max_entries_string);
+
+  return MAX (max_entries, 1);
+}
+
 void
 _cogl_pipeline_hash_table_init (CoglPipelineHashTable *hash,
                                 unsigned int main_state,
@@ -101,15 +134,16 @@ _cogl_pipeline_hash_table_init (CoglPipelineHashTable *hash,
                                 const char *debug_string)
 {
   hash->n_unique_pipelines = 0;
+  hash->max_entries = get_max_entries ();
   hash->debug_string = debug_string;
   hash->main_state = main_state;
   hash->layer_state = layer_state;
-  /* We'll only start pruning once we get to 16 unique pipelines */
-  hash->expected_min_size = 8;
   hash->table = u_hash_table_new_full (entry_hash,
                                        entry_equal,
                                        NULL, /* key destroy */
                                        value_destroy_cb);
+  _cogl_list_init (&hash->lru_list);
+  memset (&hash->stats, 0, sizeof (hash->stats));
 }
 
 void
@@ -119,60 +153,38 @@ _cogl_pipeline_hash_table_destroy (CoglPipelineHashTable *hash)
 }
 
 static void
-collect_prunable_entries_cb (void *key,
-                             void *value,
-                             void *user_data)
+evict_old_pipelines (CoglPipelineHashTable *hash)
 {
-  UQueue *entries = user_data;
-  CoglPipelineCacheEntry *entry = value;
-
-  if (entry->usage_count == 0)
-    u_queue_push_tail (entries, entry);
-}
-
-static int
-compare_pipeline_age_cb (const void *a,
-                         const void *b)
-{
-  const CoglPipelineHashTableEntry *ae = a;
-  const CoglPipelineHashTableEntry *be = b;
-
-  return be->age - ae->age;
-}
-
-static void
-prune_old_pipelines (CoglPipelineHashTable *hash)
-{
-  UQueue entries;
-  UList *l;
+  /* The +1 is to leave room for the pipeline that we're about to add */
+  int n_excess = u_hash_table_size (hash->table) - hash->max_entries + 1;
   int i;
 
-  /* Collect all of the prunable entries into a UQueue */
-  u_queue_init (&entries);
-  u_hash_table_foreach (hash->table,
-                        collect_prunable_entries_cb,
-                        &entries);
-
-  /* Sort the entries by increasing order of age */
-  entries.head = u_list_sort (entries.head, compare_pipeline_age_cb);
-
-  /* The +1 is to include the pipeline that we're about to add */
-  hash->expected_min_size = (u_hash_table_size (hash->table) -
-                             entries.length +
-                             1);
-
-  /* Remove oldest half of the prunable pipelines. We still want to
-   * keep some of the prunable entries that are recently used because
-   * it's not unlikely that the application will recreate the same
-   * pipeline */
-  for (l = entries.head, i = 0; i < entries.length / 2; l = l->next, i++)
+  /* Walk from the least recently used end of the list, removing
+   * entries that aren't in use until we are back under budget. Only a
+   * few entries are looked at each time so the work is spread across
+   * the insertions. Entries that are still in use are moved to the
+   * head because they are effectively recently used and otherwise
+   * they would block the list */
+  for (i = 0;
+       i < COGL_PIPELINE_HASH_TABLE_MAX_EVICTION_SCAN && n_excess > 0;
+       i++)
     {
-      CoglPipelineCacheEntry *entry = l->data;
-
-      u_hash_table_remove (hash->table, entry);
+      CoglPipelineHashTableEntry *entry;
+
+      _cogl_list_set_iterator (hash->lru_list.prev, entry, lru_link);
+
+      if (entry->parent.usage_count == 0)
+        {
+          u_hash_table_remove (hash->table, entry);
+          hash->stats.n_evictions++;
+          n_excess--;
+        }
+      else
+        {
+          _cogl_list_remove (&entry->lru_link);
+          _cogl_list_insert (&hash->lru_list, &entry->lru_link);
+        }
     }
-
-  u_list_free (entries.head);
 }
 
 CoglPipelineCacheEntry *
@@ -193,26 +205,29 @@ _cogl_pipeline_hash_table_get (CoglPipelineHashTable *hash,
 
   if (entry)
     {
-      entry->age = hash->n_unique_pipelines;
+      /* Move the entry to the head of the LRU list */
+      _cogl_list_remove (&entry->lru_link);
+      _cogl_list_insert (&hash->lru_list, &entry->lru_link);
+      hash->stats.n_hits++;
       return &entry->parent;
     }
 
+  hash->stats.n_misses++;
+
   if (hash->n_unique_pipelines == 50)
     u_warning ("Over 50 separate %s have been generated which is very "
                "unusual, so something is probably wrong!\n",
                hash->debug_string);
 
-  /* If we are going to have more than twice the expected minimum
-   * number of pipelines in the hash then we'll try pruning and update
-   * the minimum */
-  if (u_hash_table_size (hash->table) >= hash->expected_min_size * 2)
-    prune_old_pipelines (hash);
+  /* Make room for the new entry before it is added so that it can't
+   * be evicted itself */
+  if (u_hash_table_size (hash->table) >= hash->max_entries)
+    evict_old_pipelines (hash);
 
   entry = u_slice_new (CoglPipelineHashTableEntry);
   entry->parent.usage_count = 0;
   entry->hash = hash;
   entry->hash_value = dummy_entry.hash_value;
-  entry->age = hash->n_unique_pipelines;
 
   copy_state = hash->main_state;
   if (hash->layer_state)
@@ -226,8 +241,18 @@ _cogl_pipeline_hash_table_get (CoglPipelineHashTable *hash,
                                                      hash->layer_state);
 
   u_hash_table_insert (hash->table, entry, entry);
+  _cogl_list_insert (&hash->lru_list, &entry->lru_link);
 
   hash->n_unique_pipelines++;
 
   return &entry->parent;
 }
+
+void
+_cogl_pipeline_hash_table_get_stats (CoglPipelineHashTable *hash,
+                                     CoglPipelineCacheStats *stats)
+{
+  *stats = hash->stats;
+  stats->n_entries = u_hash_table_size (hash->table);
+  stats->max_entries = hash->max_entries;
+}
@@ -32,6 +32,7 @@
 #define __COGL_PIPELINE_HASH_H__
 
 #include "cogl-pipeline-cache.h"
+#include "cogl-list.h"
 
 typedef struct
 {
@@ -41,10 +42,10 @@ typedef struct
    * generated */
   int n_unique_pipelines;
 
-  /* This is the expected minimum size we could prune the hash table
-   * to if we were to remove all pipelines that are not in use. This
-   * is only updated after we prune the table */
-  int expected_min_size;
+  /* The number of entries the table will try to stay under. Entries
+   * that are still in use can't be evicted so the table may
+   * temporarily grow past this */
+  int max_entries;
 
   /* String that will be used to describe the usage of this hash table
    * in the debug warning when too many pipelines are generated. This
@@ -55,6 +56,12 @@ typedef struct
   unsigned int layer_state;
 
   UHashTable *table;
+
+  /* All of the entries in the order they were last used. The most
+   * recently used entry is at the head */
+  CoglList lru_list;
+
+  CoglPipelineCacheStats stats;
 } CoglPipelineHashTable;
 
 void
@@ -78,4 +85,8 @@ CoglPipelineCacheEntry *
 _cogl_pipeline_hash_table_get (CoglPipelineHashTable *hash,
                                CoglPipeline *key_pipeline);
 
+void
+_cogl_pipeline_hash_table_get_stats (CoglPipelineHashTable *hash,
+                                     CoglPipelineCacheStats *stats);
+
 #endif /* __COGL_PIPELINE_HASH_H__ */
@@ -1231,7 +1231,7 @@ _cogl_pipeline_pre_change_notify (CoglPipeline     *pipeline,
                            "must be copied to allow modification",
                            0 /* no application private data */);
 
-      COGL_COUNTER_INC (_cogl_uprof_context, pipeline_copy_on_write_counter);
+      COGL_COUNTER_INC (ctx, pipeline_copy_on_write_counter);
 
       new_authority =
         cogl_pipeline_copy (_cogl_pipeline_get_parent (pipeline));
@@ -1809,7 +1809,7 @@ fallback_layer_cb (CoglPipelineLayer *layer, void *user_data)
   if (!(state->fallback_layers & 1<<state->i))
     return TRUE;
 
-  COGL_COUNTER_INC (_cogl_uprof_context, layer_fallback_counter);
+  COGL_COUNTER_INC (ctx, layer_fallback_counter);
 
   switch (texture_type)
     {
@@ -1870,7 +1870,8 @@ _cogl_pipeline_apply_overrides (CoglPipeline *pipeline,
                        "override options to a pipeline",
                        0 /* no application private data */);
 
-  COGL_COUNTER_INC (_cogl_uprof_context, apply_overrides_counter);
+  COGL_COUNTER_INC (_cogl_context_get_default (),
+                    apply_overrides_counter);
 
   if (options->flags & COGL_PIPELINE_FLUSH_DISABLE_MASK)
     {
@@ -2095,7 +2096,7 @@ _cogl_pipeline_equal (CoglPipeline *pipeline0,
                      "The time spent comparing cogl pipelines",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, pipeline_equal_timer);
+  COGL_TIMER_START (_cogl_context_get_default (), pipeline_equal_timer);
 
   if (pipeline0 == pipeline1)
     {
@@ -2228,7 +2229,7 @@ _cogl_pipeline_equal (CoglPipeline *pipeline0,
 
   ret = TRUE;
 done:
-  COGL_TIMER_STOP (_cogl_uprof_context, pipeline_equal_timer);
+  COGL_TIMER_STOP (_cogl_context_get_default (), pipeline_equal_timer);
   return ret;
 }
 
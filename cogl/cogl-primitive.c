@@ -639,5 +639,25 @@ cogl_primitive_draw (CoglPrimitive *primitive,
                      CoglFramebuffer *framebuffer,
                      CoglPipeline *pipeline)
 {
-  _cogl_primitive_draw (primitive, framebuffer, pipeline, 0 /* flags */);
+  /* This goes through the instanced path so that attributes with a
+   * divisor are still handled if the driver doesn't support them */
+  cogl_primitive_draw_instanced (primitive, framebuffer, pipeline, 1);
+}
+
+void
+cogl_primitive_draw_instanced (CoglPrimitive *primitive,
+                               CoglFramebuffer *framebuffer,
+                               CoglPipeline *pipeline,
+                               int n_instances)
+{
+  _cogl_framebuffer_draw_instanced (framebuffer,
+                                    pipeline,
+                                    primitive->mode,
+                                    primitive->first_vertex,
+                                    primitive->n_vertices,
+                                    primitive->indices,
+                                    primitive->attributes,
+                                    primitive->n_attributes,
+                                    n_instances,
+                                    COGL_DRAW_CACHE_VERTEX_ARRAY);
 }
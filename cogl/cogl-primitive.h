@@ -915,6 +915,36 @@ cogl_primitive_draw (CoglPrimitive *primitive,
                      CoglFramebuffer *framebuffer,
                      CoglPipeline *pipeline);
 
+/**
+ * cogl_primitive_draw_instanced:
+ * @primitive: A #CoglPrimitive geometry object
+ * @framebuffer: A destination #CoglFramebuffer
+ * @pipeline: A #CoglPipeline state object
+ * @n_instances: The number of copies of @primitive to draw
+ *
+ * Draws @n_instances copies of the given @primitive geometry to
+ * @framebuffer in a single draw call. This works the same as
+ * cogl_primitive_draw() except that any attributes of @primitive
+ * with a non-zero divisor set using
+ * cogl_attribute_set_instance_divisor() advance once per instance
+ * instead of once per vertex. This can be used to draw many copies
+ * of the same mesh with a different position or color for each one.
+ *
+ * If the %COGL_FEATURE_ID_INSTANCING feature isn't available then
+ * Cogl will copy the vertices of every instance into a temporary
+ * buffer and draw that instead. This still only needs one draw call
+ * but it requires reading back the attribute buffers so it is much
+ * slower.
+ *
+ * Stability: unstable
+ * Since: 2.0
+ */
+void
+cogl_primitive_draw_instanced (CoglPrimitive *primitive,
+                               CoglFramebuffer *framebuffer,
+                               CoglPipeline *pipeline,
+                               int n_instances);
+
 
 COGL_END_DECLS
 
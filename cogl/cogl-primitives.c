@@ -693,22 +693,29 @@ _cogl_rectangle_immediate (CoglFramebuffer *framebuffer,
      code might be called while the journal is already being flushed
      such as when flushing the clip state */
   CoglContext *ctx = framebuffer->context;
-  float vertices[8] =
-    {
-      x_1, y_1,
-      x_1, y_2,
-      x_2, y_1,
-      x_2, y_2
-    };
   CoglAttributeBuffer *attribute_buffer;
   CoglAttribute *attributes[1];
+  size_t offset;
+  float *vertices;
+
+  vertices = _cogl_stream_buffer_map (ctx->stream_buffer,
+                                      sizeof (float) * 8,
+                                      &attribute_buffer,
+                                      &offset);
+  vertices[0] = x_1;
+  vertices[1] = y_1;
+  vertices[2] = x_1;
+  vertices[3] = y_2;
+  vertices[4] = x_2;
+  vertices[5] = y_1;
+  vertices[6] = x_2;
+  vertices[7] = y_2;
+  _cogl_stream_buffer_unmap (ctx->stream_buffer);
 
-  attribute_buffer =
-    cogl_attribute_buffer_new (ctx, sizeof (vertices), vertices);
   attributes[0] = cogl_attribute_new (attribute_buffer,
                                       "cogl_position_in",
                                       sizeof (float) * 2, /* stride */
-                                      0, /* offset */
+                                      offset,
                                       2, /* n_components */
                                       COGL_ATTRIBUTE_TYPE_FLOAT);
 
@@ -723,7 +730,6 @@ _cogl_rectangle_immediate (CoglFramebuffer *framebuffer,
                                      COGL_DRAW_SKIP_PIPELINE_VALIDATION |
                                      COGL_DRAW_SKIP_FRAMEBUFFER_FLUSH);
 
-
   cogl_object_unref (attributes[0]);
-  cogl_object_unref (attribute_buffer);
+  _cogl_stream_buffer_release (ctx->stream_buffer);
 }
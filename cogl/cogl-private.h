@@ -66,6 +66,12 @@ typedef enum
    * is first allocated or when it is shown or resized */
   COGL_PRIVATE_FEATURE_DIRTY_EVENTS,
   COGL_PRIVATE_FEATURE_ENABLE_PROGRAM_POINT_SIZE,
+  COGL_PRIVATE_FEATURE_GPU_TIMER_DISJOINT,
+  /* Buffers can be mapped without waiting for the GPU to finish
+   * with them */
+  COGL_PRIVATE_FEATURE_MAP_BUFFER_UNSYNCHRONIZED,
+  /* Buffers can be kept mapped while the GPU is reading from them */
+  COGL_PRIVATE_FEATURE_MAP_BUFFER_PERSISTENT,
   /* These features let us avoid conditioning code based on the exact
    * driver being used and instead check for broad opengl feature
    * sets that can be shared by several GL apis */
@@ -146,6 +152,18 @@ _cogl_pixel_format_get_bytes_per_pixel (CoglPixelFormat format);
 CoglBool
 _cogl_pixel_format_is_endian_dependant (CoglPixelFormat format);
 
+/*
+ * _cogl_pixel_format_is_compressed:
+ * @format: a #CoglPixelFormat
+ *
+ * Queries whether @format is one of the block compressed formats.
+ * These have no bytes per pixel and can't be used with a #CoglBitmap.
+ *
+ * Return value: %TRUE if @format is compressed, else %FALSE.
+ */
+CoglBool
+_cogl_pixel_format_is_compressed (CoglPixelFormat format);
+
 /*
  * COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT(format):
  * @format: a #CoglPixelFormat
@@ -153,10 +171,12 @@ _cogl_pixel_format_is_endian_dependant (CoglPixelFormat format);
  * Returns TRUE if the pixel format can take a premult bit. This is
  * currently true for all formats that have an alpha channel except
  * COGL_PIXEL_FORMAT_A_8 (because that doesn't have any other
- * components to multiply by the alpha).
+ * components to multiply by the alpha) and the compressed formats
+ * (which are always stored unpremultiplied).
  */
 #define COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT(format) \
-  (((format) & COGL_A_BIT) && (format) != COGL_PIXEL_FORMAT_A_8)
+  (((format) & COGL_A_BIT) && (format) != COGL_PIXEL_FORMAT_A_8 && \
+   !((format) & COGL_COMPRESSED_BIT))
 
 COGL_END_DECLS
 
@@ -1,124 +1,319 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
-#ifdef COGL_ENABLE_PROFILE
+#include <stdio.h>
+#include <string.h>
+
+#include <test-fixtures/test-unit.h>
 
 #include "cogl-profile.h"
 #include "cogl-debug.h"
-#include "cogl-i18n-private.h"
+#include "cogl-context-private.h"
+#include "cogl-config-private.h"
 
-#include <stdlib.h>
+/* The number of events kept in each context's ring buffer. This
+ * needs to be a power of two. Once it fills up the oldest events are
+ * overwritten so the trace always contains the most recent frames */
+#define COGL_TRACE_BUFFER_SIZE (1 << 16)
 
-UProfContext *_cogl_uprof_context;
+#define COGL_TRACE_DEFAULT_FILENAME "cogl-trace.json"
 
-static CoglBool
-debug_option_getter (void *user_data)
+typedef enum
 {
-  unsigned int shift = GPOINTER_TO_UINT (user_data);
-  return COGL_DEBUG_ENABLED (shift);
+  COGL_TRACE_EVENT_TYPE_BEGIN,
+  COGL_TRACE_EVENT_TYPE_END,
+  COGL_TRACE_EVENT_TYPE_COUNTER
+} CoglTraceEventType;
+
+typedef struct
+{
+  /* Microseconds since the buffer was created */
+  int64_t timestamp;
+  int64_t value;
+  const char *name;
+  CoglTraceEventType type;
+} CoglTraceEvent;
+
+struct _CoglTraceBuffer
+{
+  UTimer *timer;
+  CoglTraceEvent *events;
+  /* The total number of events ever recorded. The next event is
+   * written at n_events % COGL_TRACE_BUFFER_SIZE */
+  uint64_t n_events;
+};
+
+static CoglTraceBuffer *
+get_trace_buffer (CoglContext *context)
+{
+  CoglTraceBuffer *buffer = context->trace_buffer;
+
+  if (U_UNLIKELY (buffer == NULL))
+    {
+      buffer = u_slice_new (CoglTraceBuffer);
+      buffer->timer = u_timer_new ();
+      buffer->events = u_new (CoglTraceEvent, COGL_TRACE_BUFFER_SIZE);
+      buffer->n_events = 0;
+      context->trace_buffer = buffer;
+    }
+
+  return buffer;
+}
+
+static void
+free_trace_buffer (CoglTraceBuffer *buffer)
+{
+  u_timer_destroy (buffer->timer);
+  u_free (buffer->events);
+  u_slice_free (CoglTraceBuffer, buffer);
 }
 
 static void
-debug_option_setter (CoglBool value, void *user_data)
+add_event (CoglContext *context,
+           CoglTraceEventType type,
+           const char *name,
+           int64_t value)
 {
-  unsigned int shift = GPOINTER_TO_UINT (user_data);
+  CoglTraceBuffer *buffer;
+  CoglTraceEvent *event;
+  unsigned long microseconds;
+  double seconds;
 
-  if (value)
-    COGL_DEBUG_SET_FLAG (shift);
-  else
-    COGL_DEBUG_CLEAR_FLAG (shift);
+  if (context == NULL)
+    return;
+
+  buffer = get_trace_buffer (context);
+
+  seconds = u_timer_elapsed (buffer->timer, &microseconds);
+
+  event = buffer->events + (buffer->n_events &
+                            (COGL_TRACE_BUFFER_SIZE - 1));
+  event->timestamp = (int64_t) seconds * 1000000 + microseconds;
+  event->value = value;
+  event->name = name;
+  event->type = type;
+
+  buffer->n_events++;
+}
+
+void
+_cogl_trace_begin (CoglContext *context, const char *name)
+{
+  add_event (context, COGL_TRACE_EVENT_TYPE_BEGIN, name, 0);
+}
+
+void
+_cogl_trace_end (CoglContext *context, const char *name)
+{
+  add_event (context, COGL_TRACE_EVENT_TYPE_END, name, 0);
+}
+
+void
+_cogl_trace_counter (CoglContext *context,
+                     const char *name,
+                     int64_t value)
+{
+  add_event (context, COGL_TRACE_EVENT_TYPE_COUNTER, name, value);
 }
 
 static void
-print_exit_report (void)
+append_json_string (UString *json, const char *str)
+{
+  u_string_append_c (json, '"');
+
+  for (; *str; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        u_string_append_c (json, '\\');
+      u_string_append_c (json, *str);
+    }
+
+  u_string_append_c (json, '"');
+}
+
+static char *
+trace_buffer_to_json (CoglTraceBuffer *buffer)
 {
-  if (getenv ("COGL_PROFILE_OUTPUT_REPORT"))
+  UString *json = u_string_new ("{\"traceEvents\":[");
+  uint64_t first_event, i;
+  CoglBool first = TRUE;
+  int depth = 0;
+
+  if (buffer->n_events > COGL_TRACE_BUFFER_SIZE)
+    first_event = buffer->n_events - COGL_TRACE_BUFFER_SIZE;
+  else
+    first_event = 0;
+
+  for (i = first_event; i < buffer->n_events; i++)
     {
-      UProfContext *mainloop_context;
-      UProfTimerResult *mainloop_timer;
-      UProfReport *report;
-
-      /* NB: uprof provides a shared context for mainloop statistics
-       * which needs to be setup by the application which controls the
-       * mainloop.
-       *
-       * If no "Mainloop" timer has been setup then we print a warning
-       * since we can't provide a meaningful Cogl report without one.
-       */
-      mainloop_context = uprof_get_mainloop_context ();
-      mainloop_timer = uprof_context_get_timer_result (mainloop_context,
-                                                       "Mainloop");
-      /* just bail out if the mainloop timer wasn't hit */
-      if (!mainloop_timer)
+      const CoglTraceEvent *event =
+        buffer->events + (i & (COGL_TRACE_BUFFER_SIZE - 1));
+      const char *phase;
+
+      switch (event->type)
         {
-          u_warning ("\n\n"
-                     "No UProf \"Mainloop\" timer was setup by the "
-                     "application therefore we\ncan't provide a meaningful "
-                     "profile report.\n"
-                     "\n"
-                     "This should be done automatically if you are using Clutter "
-                     "(if\nbuilt with --enable-profile)\n"
-                     "\n"
-                     "If you aren't using Clutter then you can declare a "
-                     "\"Mainloop\" UProf\ntimer in your application like this:\n\n"
-                     "  UPROF_STATIC_TIMER (mainloop_timer, \n"
-                     "                      NULL,\n"
-                     "                      \"Mainloop\",\n"
-                     "                      \"Time in glib mainloop\",\n"
-                     "                      0);\n"
-                     "\n"
-                     "And start/stop it around your mainloop like this:\n"
-                     "\n"
-                     "  UPROF_TIMER_START (uprof_get_mainloop_context (), mainloop_timer);\n"
-                     "  u_main_loop_run (loop);\n"
-                     "  UPROF_TIMER_STOP (uprof_get_mainloop_context (), mainloop_timer);\n");
-          return;
+        case COGL_TRACE_EVENT_TYPE_BEGIN:
+          phase = "B";
+          depth++;
+          break;
+
+        case COGL_TRACE_EVENT_TYPE_END:
+          /* If the buffer has wrapped around then the begin event for
+           * this might have been overwritten. The trace viewer
+           * doesn't cope well with unmatched end events so they are
+           * skipped */
+          if (depth == 0)
+            continue;
+          phase = "E";
+          depth--;
+          break;
+
+        case COGL_TRACE_EVENT_TYPE_COUNTER:
+          phase = "C";
+          break;
+
+        default:
+          u_warn_if_reached ();
+          continue;
         }
 
-      report = uprof_report_new ("Cogl report");
-      uprof_report_add_context (report, _cogl_uprof_context);
-      uprof_report_print (report);
-      uprof_report_unref (report);
+      if (!first)
+        u_string_append_c (json, ',');
+      first = FALSE;
+
+      u_string_append (json, "\n{\"name\":");
+      append_json_string (json, event->name);
+      u_string_append_printf (json,
+                              ",\"cat\":\"cogl\",\"ph\":\"%s\","
+                              "\"ts\":%lld,"
+                              "\"pid\":1,\"tid\":1",
+                              phase,
+                              (long long) event->timestamp);
+
+      if (event->type == COGL_TRACE_EVENT_TYPE_COUNTER)
+        u_string_append_printf (json,
+                                ",\"args\":{\"value\":%lld}",
+                                (long long) event->value);
+
+      u_string_append_c (json, '}');
     }
-  uprof_context_unref (_cogl_uprof_context);
+
+  u_string_append (json, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  return u_string_free (json, FALSE);
 }
 
-void
-_cogl_uprof_init (void)
+CoglBool
+_cogl_trace_write_json (CoglContext *context,
+                        const char *filename)
 {
-  _cogl_uprof_context = uprof_context_new ("Cogl");
-  uprof_context_link (_cogl_uprof_context, uprof_get_mainloop_context ());
-#define OPT(MASK_NAME, GROUP, NAME, NAME_FORMATTED, DESCRIPTION) \
-  U_STMT_START { \
-    int shift = COGL_DEBUG_ ## MASK_NAME; \
-    uprof_context_add_boolean_option (_cogl_uprof_context, \
-                                      _(GROUP), \
-                                      NAME, \
-                                      _(NAME_FORMATTED), \
-                                      _(DESCRIPTION),    \
-                                      debug_option_getter, \
-                                      debug_option_setter, \
-                                      GUINT_TO_POINTER (shift)); \
-  } U_STMT_END;
-
-#include "cogl-debug-options.h"
-#undef OPT
-
-  atexit (print_exit_report);
+  CoglBool ret;
+  char *json;
+
+  if (context->trace_buffer == NULL)
+    return FALSE;
+
+  json = trace_buffer_to_json (context->trace_buffer);
+  ret = u_file_set_contents (filename, json, -1, NULL);
+  u_free (json);
+
+  return ret;
 }
 
 void
-_cogl_profile_trace_message (const char *format, ...)
+_cogl_trace_context_free (CoglContext *context)
 {
-  va_list ap;
+  const char *filename;
 
-  va_start (ap, format);
-  u_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, format, ap);
-  va_end (ap);
+  if (context->trace_buffer == NULL)
+    return;
 
-  if (_cogl_uprof_context)
-    uprof_context_vtrace_message (_cogl_uprof_context, format, ap);
+  filename = u_getenv ("COGL_TRACE_FILE");
+  if (filename == NULL)
+    filename = _cogl_config_trace_file;
+  if (filename == NULL)
+    filename = COGL_TRACE_DEFAULT_FILENAME;
+
+  if (!_cogl_trace_write_json (context, filename))
+    u_warning ("Failed to write the Cogl trace to %s", filename);
+
+  free_trace_buffer (context->trace_buffer);
+  context->trace_buffer = NULL;
 }
 
-#endif
+UNIT_TEST (check_trace_ring_buffer,
+           0, /* no requirements */
+           0 /* no failure cases */)
+{
+  char *filename = u_build_filename (u_get_tmp_dir (),
+                                     "cogl-test-trace.json",
+                                     NULL);
+  char *contents;
+  size_t length;
+  int i;
+
+  u_assert (test_ctx->trace_buffer == NULL);
+
+  _cogl_trace_begin (test_ctx, "outer");
+  _cogl_trace_counter (test_ctx, "counter", 42);
+  _cogl_trace_end (test_ctx, "outer");
+
+  u_assert (_cogl_trace_write_json (test_ctx, filename));
+  u_assert (u_file_get_contents (filename, &contents, &length, NULL));
+  u_assert (strstr (contents, "{\"name\":\"outer\",\"cat\":\"cogl\","
+                    "\"ph\":\"B\""));
+  u_assert (strstr (contents, "\"ph\":\"E\""));
+  u_assert (strstr (contents, "\"args\":{\"value\":42}"));
+  u_free (contents);
+
+  /* Overflow the ring buffer so that the begin event is lost. The
+   * matching end event should be dropped from the output */
+  _cogl_trace_begin (test_ctx, "lost");
+  for (i = 0; i < COGL_TRACE_BUFFER_SIZE; i++)
+    _cogl_trace_counter (test_ctx, "counter", i);
+  _cogl_trace_end (test_ctx, "lost");
+
+  u_assert (_cogl_trace_write_json (test_ctx, filename));
+  u_assert (u_file_get_contents (filename, &contents, &length, NULL));
+  u_assert (strstr (contents, "lost") == NULL);
+  u_assert (strstr (contents, "outer") == NULL);
+  u_free (contents);
+
+  remove (filename);
+  u_free (filename);
+
+  /* Don't let the test context write out a trace when it is
+   * destroyed */
+  free_trace_buffer (test_ctx->trace_buffer);
+  test_ctx->trace_buffer = NULL;
+}
@@ -31,38 +31,86 @@
 #ifndef __COGL_PROFILE_H__
 #define __COGL_PROFILE_H__
 
+#include "cogl-context.h"
+#include "cogl-debug.h"
 
-#ifdef COGL_ENABLE_PROFILE
+/* Cogl has a built-in trace recorder that is always compiled in. When
+ * COGL_DEBUG=trace is set the timers and counters below are recorded
+ * with a timestamp into a ring buffer owned by the context. The most
+ * recent events are written out as Chrome trace-event JSON when the
+ * context is destroyed so they can be loaded into chrome://tracing.
+ *
+ * When tracing isn't enabled starting or stopping a timer only costs
+ * a check of the debug flag.
+ */
+
+typedef struct _CoglTraceBuffer CoglTraceBuffer;
+
+typedef struct _CoglTraceCounter
+{
+  const char *name;
+  int64_t value;
+} CoglTraceCounter;
+
+/* The parent, description and flags arguments aren't used in the
+ * trace output but they are kept to document what each timer and
+ * counter measures */
+#define COGL_STATIC_TIMER(NAME, PARENT, DISPLAY_NAME, DESCRIPTION, FLAGS) \
+  static const char NAME[] = DISPLAY_NAME
+
+#define COGL_STATIC_COUNTER(NAME, DISPLAY_NAME, DESCRIPTION, FLAGS) \
+  static CoglTraceCounter NAME = { DISPLAY_NAME, 0 }
 
-#include <uprof.h>
+#define COGL_TIMER_START(CONTEXT, TIMER)            U_STMT_START {       \
+        if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_TRACE)))          \
+          _cogl_trace_begin ((CONTEXT), (TIMER));                        \
+                                                    } U_STMT_END
 
-extern UProfContext *_cogl_uprof_context;
+#define COGL_TIMER_STOP(CONTEXT, TIMER)             U_STMT_START {       \
+        if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_TRACE)))          \
+          _cogl_trace_end ((CONTEXT), (TIMER));                          \
+                                                    } U_STMT_END
 
-#define COGL_STATIC_TIMER    UPROF_STATIC_TIMER
-#define COGL_STATIC_COUNTER  UPROF_STATIC_COUNTER
-#define COGL_COUNTER_INC     UPROF_COUNTER_INC
-#define COGL_COUNTER_DEC     UPROF_COUNTER_DEC
-#define COGL_TIMER_START     UPROF_TIMER_START
-#define COGL_TIMER_STOP      UPROF_TIMER_STOP
+#define COGL_COUNTER_INC(CONTEXT, COUNTER)          U_STMT_START {       \
+        (COUNTER).value++;                                               \
+        if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_TRACE)))          \
+          _cogl_trace_counter ((CONTEXT),                                \
+                               (COUNTER).name,                           \
+                               (COUNTER).value);                         \
+                                                    } U_STMT_END
 
+#define COGL_COUNTER_DEC(CONTEXT, COUNTER)          U_STMT_START {       \
+        (COUNTER).value--;                                               \
+        if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_TRACE)))          \
+          _cogl_trace_counter ((CONTEXT),                                \
+                               (COUNTER).name,                           \
+                               (COUNTER).value);                         \
+                                                    } U_STMT_END
+
+/* The name must be a string with static storage because only the
+ * pointer is recorded */
 void
-_cogl_uprof_init (void);
+_cogl_trace_begin (CoglContext *context, const char *name);
 
 void
-_cogl_profile_trace_message (const char *format, ...);
+_cogl_trace_end (CoglContext *context, const char *name);
 
-#else
+void
+_cogl_trace_counter (CoglContext *context,
+                     const char *name,
+                     int64_t value);
 
-#define COGL_STATIC_TIMER(A,B,C,D,E) extern void _cogl_dummy_decl (void)
-#define COGL_STATIC_COUNTER(A,B,C,D) extern void _cogl_dummy_decl (void)
-#define COGL_COUNTER_INC(A,B) U_STMT_START{ (void)0; }U_STMT_END
-#define COGL_COUNTER_DEC(A,B) U_STMT_START{ (void)0; }U_STMT_END
-#define COGL_TIMER_START(A,B) U_STMT_START{ (void)0; }U_STMT_END
-#define COGL_TIMER_STOP(A,B) U_STMT_START{ (void)0; }U_STMT_END
+/* Writes the events currently in the context's ring buffer to
+ * @filename as Chrome trace-event JSON */
+CoglBool
+_cogl_trace_write_json (CoglContext *context,
+                        const char *filename);
 
-#define _cogl_profile_trace_message u_message
+/* Called when the context is destroyed. This writes out the trace if
+ * anything was recorded and frees the ring buffer */
+void
+_cogl_trace_context_free (CoglContext *context);
 
-#endif
+#define _cogl_profile_trace_message u_message
 
 #endif /* __COGL_PROFILE_H__ */
-
@@ -0,0 +1,178 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef _COGL_PROGRAM_CACHE_PRIVATE_H_
+#define _COGL_PROGRAM_CACHE_PRIVATE_H_
+
+#include <stdint.h>
+
+#include "cogl-types.h"
+
+/*
+ * A persistent cache of linked program binaries stored as files in a
+ * directory so that the programs don't have to be compiled again
+ * when the application is next run. The cache doesn't know anything
+ * about GL. The GLSL progend passes it the binaries that it gets back
+ * from glGetProgramBinary() along with a key made from the hashes of
+ * the generated shader source.
+ *
+ * The cache is only used if the COGL_PROGRAM_CACHE_DIR environment
+ * variable or config option is set. COGL_PROGRAM_CACHE_MAX_SIZE can
+ * be used to set the maximum number of bytes that the files may take
+ * up. When the directory goes over this size the least recently used
+ * files are removed.
+ *
+ * Each file has a header containing a checksum of the binary so that
+ * truncated or corrupt files are detected and removed when they are
+ * loaded.
+ */
+
+typedef struct _CoglProgramCache CoglProgramCache;
+
+/* The initial value to use with _cogl_program_cache_hash() */
+#define COGL_PROGRAM_CACHE_HASH_INIT UINT64_C (0xcbf29ce484222325)
+
+/*
+ * _cogl_program_cache_new:
+ * @directory: The directory to store the files in. It will be created
+ *   if it doesn't exist.
+ * @driver_key: A string describing the driver. This is mixed into
+ *   every key so that binaries from a different driver or driver
+ *   version won't be used.
+ * @max_size: The maximum number of bytes that all of the files in
+ *   the directory may take up
+ *
+ * Returns: a new #CoglProgramCache or %NULL if the directory couldn't
+ *   be created.
+ */
+CoglProgramCache *
+_cogl_program_cache_new (const char *directory,
+                         const char *driver_key,
+                         size_t max_size);
+
+/*
+ * _cogl_program_cache_new_from_config:
+ * @driver_key: A string describing the driver
+ *
+ * Creates a program cache using the directory and size configured
+ * with the COGL_PROGRAM_CACHE_DIR and COGL_PROGRAM_CACHE_MAX_SIZE
+ * options.
+ *
+ * Returns: a new #CoglProgramCache or %NULL if no directory is
+ *   configured.
+ */
+CoglProgramCache *
+_cogl_program_cache_new_from_config (const char *driver_key);
+
+void
+_cogl_program_cache_free (CoglProgramCache *cache);
+
+/*
+ * _cogl_program_cache_hash:
+ * @hash: The hash of any previous data or
+ *   %COGL_PROGRAM_CACHE_HASH_INIT
+ * @data: The data to add to the hash
+ * @length: The length of @data in bytes
+ *
+ * Adds @data to a running 64-bit hash. This is used to hash the
+ * shader source as it is generated.
+ *
+ * Returns: the new hash value
+ */
+uint64_t
+_cogl_program_cache_hash (uint64_t hash,
+                          const void *data,
+                          size_t length);
+
+/*
+ * _cogl_program_cache_get_key:
+ * @cache: A #CoglProgramCache
+ * @n_shader_hashes: The number of hashes in @shader_hashes
+ * @shader_hashes: The hashes of the source of each shader in the
+ *   program
+ *
+ * Combines the hashes of the shaders with the driver key to make
+ * the key that the program is stored under.
+ */
+uint64_t
+_cogl_program_cache_get_key (CoglProgramCache *cache,
+                             int n_shader_hashes,
+                             const uint64_t *shader_hashes);
+
+/*
+ * _cogl_program_cache_load:
+ * @cache: A #CoglProgramCache
+ * @key: The key for the program
+ * @binary_format: A return location for the format of the binary
+ * @length: A return location for the length of the binary
+ *
+ * Looks for a binary stored under @key. If the file is found but it
+ * is corrupt then it will be removed.
+ *
+ * Returns: the binary which should be freed with u_free() or %NULL
+ *   if there is no valid binary for the key.
+ */
+void *
+_cogl_program_cache_load (CoglProgramCache *cache,
+                          uint64_t key,
+                          uint32_t *binary_format,
+                          size_t *length);
+
+/*
+ * _cogl_program_cache_store:
+ * @cache: A #CoglProgramCache
+ * @key: The key for the program
+ * @binary_format: The format of the binary
+ * @binary: The binary data
+ * @length: The length of @binary
+ *
+ * Writes the binary to the cache directory, replacing any existing
+ * file for the key. If this takes the directory over the maximum
+ * size then the least recently used files will be removed.
+ */
+void
+_cogl_program_cache_store (CoglProgramCache *cache,
+                           uint64_t key,
+                           uint32_t binary_format,
+                           const void *binary,
+                           size_t length);
+
+/*
+ * _cogl_program_cache_remove:
+ * @cache: A #CoglProgramCache
+ * @key: The key for the program
+ *
+ * Removes the file for @key. This should be used if the driver
+ * rejects a binary that was loaded from the cache.
+ */
+void
+_cogl_program_cache_remove (CoglProgramCache *cache,
+                            uint64_t key);
+
+#endif /* _COGL_PROGRAM_CACHE_PRIVATE_H_ */
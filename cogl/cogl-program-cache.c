@@ -0,0 +1,601 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <test-fixtures/test-unit.h>
+
+#include "cogl-util.h"
+#include "cogl-config-private.h"
+#include "cogl-program-cache-private.h"
+
+#define COGL_PROGRAM_CACHE_DEFAULT_MAX_SIZE (16 * 1024 * 1024)
+
+/* This should be bumped whenever the layout of the header changes */
+#define COGL_PROGRAM_CACHE_VERSION 1
+
+#define COGL_PROGRAM_CACHE_SUFFIX ".bin"
+
+/* The files are named after the key as 16 hex digits */
+#define COGL_PROGRAM_CACHE_NAME_LENGTH \
+  (16 + sizeof (COGL_PROGRAM_CACHE_SUFFIX) - 1)
+
+static const char
+program_cache_magic[8] = { 'C', 'O', 'G', 'L', 'P', 'R', 'O', 'G' };
+
+/* The files are only ever read on the machine that wrote them so the
+   header is just stored in the native byte order */
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t binary_format;
+  uint64_t key;
+  uint32_t length;
+  uint32_t checksum;
+} CoglProgramCacheHeader;
+
+struct _CoglProgramCache
+{
+  char *directory;
+  uint64_t driver_hash;
+  size_t max_size;
+};
+
+typedef struct
+{
+  char *filename;
+  off_t size;
+  time_t mtime;
+} CoglProgramCacheFile;
+
+uint64_t
+_cogl_program_cache_hash (uint64_t hash,
+                          const void *data,
+                          size_t length)
+{
+  const uint8_t *p = data;
+  size_t i;
+
+  /* 64-bit FNV-1a */
+  for (i = 0; i < length; i++)
+    {
+      hash ^= p[i];
+      hash *= UINT64_C (0x100000001b3);
+    }
+
+  return hash;
+}
+
+static uint32_t
+get_checksum (const void *data,
+              size_t length)
+{
+  uint64_t hash = _cogl_program_cache_hash (COGL_PROGRAM_CACHE_HASH_INIT,
+                                            data,
+                                            length);
+
+  return (uint32_t) (hash ^ (hash >> 32));
+}
+
+CoglProgramCache *
+_cogl_program_cache_new (const char *directory,
+                         const char *driver_key,
+                         size_t max_size)
+{
+  CoglProgramCache *cache;
+
+  if (u_mkdir_with_parents (directory, 0700) != 0)
+    {
+      u_warning ("Failed to create the program cache directory \"%s\"",
+                 directory);
+      return NULL;
+    }
+
+  cache = u_new (CoglProgramCache, 1);
+  cache->directory = u_strdup (directory);
+  cache->driver_hash = _cogl_program_cache_hash (COGL_PROGRAM_CACHE_HASH_INIT,
+                                                 driver_key,
+                                                 strlen (driver_key));
+  cache->max_size = max_size;
+
+  return cache;
+}
+
+CoglProgramCache *
+_cogl_program_cache_new_from_config (const char *driver_key)
+{
+  const char *directory;
+  const char *max_size_string;
+  size_t max_size = COGL_PROGRAM_CACHE_DEFAULT_MAX_SIZE;
+
+  directory = u_getenv ("COGL_PROGRAM_CACHE_DIR");
+  if (directory == NULL)
+    directory = _cogl_config_program_cache_dir;
+
+  if (directory == NULL || *directory == '\0')
+    return NULL;
+
+  max_size_string = u_getenv ("COGL_PROGRAM_CACHE_MAX_SIZE");
+  if (max_size_string == NULL)
+    max_size_string = _cogl_config_program_cache_max_size;
+
+  if (max_size_string)
+    max_size = strtoul (max_size_string, NULL, 10);
+
+  return _cogl_program_cache_new (directory, driver_key, max_size);
+}
+
+void
+_cogl_program_cache_free (CoglProgramCache *cache)
+{
+  u_free (cache->directory);
+  u_free (cache);
+}
+
+uint64_t
+_cogl_program_cache_get_key (CoglProgramCache *cache,
+                             int n_shader_hashes,
+                             const uint64_t *shader_hashes)
+{
+  return _cogl_program_cache_hash (cache->driver_hash,
+                                   shader_hashes,
+                                   sizeof (uint64_t) * n_shader_hashes);
+}
+
+static char *
+get_filename (CoglProgramCache *cache,
+              uint64_t key)
+{
+  char name[COGL_PROGRAM_CACHE_NAME_LENGTH + 1];
+
+  snprintf (name, sizeof (name),
+            "%08x%08x" COGL_PROGRAM_CACHE_SUFFIX,
+            (unsigned int) (key >> 32),
+            (unsigned int) key);
+
+  return u_build_filename (cache->directory, name, NULL);
+}
+
+void *
+_cogl_program_cache_load (CoglProgramCache *cache,
+                          uint64_t key,
+                          uint32_t *binary_format,
+                          size_t *length)
+{
+  char *filename = get_filename (cache, key);
+  CoglProgramCacheHeader header;
+  char *contents;
+  size_t contents_length;
+  void *binary = NULL;
+
+  if (!u_file_get_contents (filename, &contents, &contents_length, NULL))
+    goto out;
+
+  if (contents_length < sizeof (header))
+    goto corrupt;
+
+  memcpy (&header, contents, sizeof (header));
+
+  if (memcmp (header.magic,
+              program_cache_magic,
+              sizeof (program_cache_magic)) ||
+      header.version != COGL_PROGRAM_CACHE_VERSION ||
+      header.key != key ||
+      header.length != contents_length - sizeof (header) ||
+      header.checksum != get_checksum (contents + sizeof (header),
+                                       header.length))
+    goto corrupt;
+
+  binary = u_memdup (contents + sizeof (header), header.length);
+  *binary_format = header.binary_format;
+  *length = header.length;
+
+  /* Update the modification time so that the eviction will treat
+   * this file as recently used */
+  utime (filename, NULL);
+
+  goto free_contents;
+
+ corrupt:
+  /* The file may have been truncated or overwritten by something
+   * else. It will just be replaced so it isn't worth a warning */
+  u_unlink (filename);
+
+ free_contents:
+  u_free (contents);
+
+ out:
+  u_free (filename);
+
+  return binary;
+}
+
+static CoglBool
+is_cache_filename (const char *name)
+{
+  int i;
+
+  if (strlen (name) != COGL_PROGRAM_CACHE_NAME_LENGTH ||
+      strcmp (name + 16, COGL_PROGRAM_CACHE_SUFFIX))
+    return FALSE;
+
+  for (i = 0; i < 16; i++)
+    if (!u_ascii_isxdigit (name[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+static int
+compare_file_mtime_cb (const void *a,
+                       const void *b)
+{
+  const CoglProgramCacheFile *file_a = a;
+  const CoglProgramCacheFile *file_b = b;
+
+  if (file_a->mtime < file_b->mtime)
+    return -1;
+  else if (file_a->mtime > file_b->mtime)
+    return 1;
+  else
+    return 0;
+}
+
+static void
+evict_files (CoglProgramCache *cache)
+{
+  UArray *files;
+  UDir *dir;
+  const char *name;
+  size_t total_size = 0;
+  int i;
+
+  /* The directory might be shared with other processes so rather
+   * than trying to keep track of the total size we just scan the
+   * directory again. This only happens after a program had to be
+   * compiled anyway */
+  dir = u_dir_open (cache->directory, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  files = u_array_new (FALSE, FALSE, sizeof (CoglProgramCacheFile));
+
+  while ((name = u_dir_read_name (dir)))
+    {
+      CoglProgramCacheFile file;
+      struct stat buf;
+
+      if (!is_cache_filename (name))
+        continue;
+
+      file.filename = u_build_filename (cache->directory, name, NULL);
+
+      if (u_stat (file.filename, &buf) != 0)
+        {
+          u_free (file.filename);
+          continue;
+        }
+
+      file.size = buf.st_size;
+      file.mtime = buf.st_mtime;
+      total_size += file.size;
+
+      u_array_append_val (files, file);
+    }
+
+  u_dir_close (dir);
+
+  if (total_size > cache->max_size)
+    {
+      qsort (files->data,
+             files->len,
+             sizeof (CoglProgramCacheFile),
+             compare_file_mtime_cb);
+
+      for (i = 0; i < files->len && total_size > cache->max_size; i++)
+        {
+          CoglProgramCacheFile *file =
+            &u_array_index (files, CoglProgramCacheFile, i);
+
+          if (u_unlink (file->filename) == 0)
+            total_size -= file->size;
+        }
+    }
+
+  for (i = 0; i < files->len; i++)
+    u_free (u_array_index (files, CoglProgramCacheFile, i).filename);
+
+  u_array_free (files, TRUE);
+}
+
+void
+_cogl_program_cache_store (CoglProgramCache *cache,
+                           uint64_t key,
+                           uint32_t binary_format,
+                           const void *binary,
+                           size_t length)
+{
+  CoglProgramCacheHeader header;
+  char *filename;
+  char *contents;
+  UError *error = NULL;
+
+  /* Don't bother storing binaries that would immediately be evicted */
+  if (length + sizeof (header) > cache->max_size ||
+      length > UINT32_MAX)
+    return;
+
+  memcpy (header.magic, program_cache_magic, sizeof (program_cache_magic));
+  header.version = COGL_PROGRAM_CACHE_VERSION;
+  header.binary_format = binary_format;
+  header.key = key;
+  header.length = length;
+  header.checksum = get_checksum (binary, length);
+
+  contents = u_malloc (sizeof (header) + length);
+  memcpy (contents, &header, sizeof (header));
+  memcpy (contents + sizeof (header), binary, length);
+
+  filename = get_filename (cache, key);
+
+  /* This writes to a temporary file first and then renames it so
+   * another process won't see a partially written file */
+  if (!u_file_set_contents (filename,
+                            contents,
+                            sizeof (header) + length,
+                            &error))
+    {
+      u_warning ("Failed to write program cache file \"%s\": %s",
+                 filename,
+                 error->message);
+      u_error_free (error);
+    }
+  else
+    evict_files (cache);
+
+  u_free (filename);
+  u_free (contents);
+}
+
+void
+_cogl_program_cache_remove (CoglProgramCache *cache,
+                            uint64_t key)
+{
+  char *filename = get_filename (cache, key);
+
+  u_unlink (filename);
+
+  u_free (filename);
+}
+
+#ifdef ENABLE_UNIT_TESTS
+
+static char *
+create_test_directory (void)
+{
+  char *name = u_strdup_printf ("cogl-program-cache-test-%d", (int) getpid ());
+  char *directory = u_build_filename (u_get_tmp_dir (), name, NULL);
+
+  u_free (name);
+
+  return directory;
+}
+
+static void
+remove_test_directory (const char *directory)
+{
+  UDir *dir = u_dir_open (directory, 0, NULL);
+  const char *name;
+
+  if (dir)
+    {
+      while ((name = u_dir_read_name (dir)))
+        {
+          char *filename = u_build_filename (directory, name, NULL);
+          u_unlink (filename);
+          u_free (filename);
+        }
+
+      u_dir_close (dir);
+    }
+
+  rmdir (directory);
+}
+
+static void
+set_file_age (CoglProgramCache *cache,
+              uint64_t key,
+              time_t age)
+{
+  char *filename = get_filename (cache, key);
+  struct utimbuf times;
+
+  times.actime = times.modtime = time (NULL) - age;
+  utime (filename, &times);
+
+  u_free (filename);
+}
+
+static CoglBool
+check_binary (CoglProgramCache *cache,
+              uint64_t key,
+              const char *expected)
+{
+  uint32_t binary_format;
+  size_t length;
+  void *binary = _cogl_program_cache_load (cache,
+                                           key,
+                                           &binary_format,
+                                           &length);
+  CoglBool ret;
+
+  if (binary == NULL)
+    return FALSE;
+
+  ret = (binary_format == 42 &&
+         length == strlen (expected) &&
+         !memcmp (binary, expected, length));
+
+  u_free (binary);
+
+  return ret;
+}
+
+static CoglBool
+has_binary (CoglProgramCache *cache,
+            uint64_t key)
+{
+  uint32_t binary_format;
+  size_t length;
+  void *binary = _cogl_program_cache_load (cache,
+                                           key,
+                                           &binary_format,
+                                           &length);
+
+  u_free (binary);
+
+  return binary != NULL;
+}
+
+UNIT_TEST (check_program_cache,
+           0, /* no requirements */
+           0 /* no failure cases */)
+{
+  char *directory = create_test_directory ();
+  const uint64_t shader_hashes[] = { 1, 2 };
+  CoglProgramCache *cache, *other_driver_cache;
+  uint64_t key, other_driver_key;
+  char *filename, *contents;
+  size_t length;
+
+  cache = _cogl_program_cache_new (directory, "driver 1", 1024);
+  u_assert (cache);
+
+  /* The same shaders with a different driver should have a
+   * different key */
+  other_driver_cache = _cogl_program_cache_new (directory, "driver 2", 1024);
+  key = _cogl_program_cache_get_key (cache, 2, shader_hashes);
+  other_driver_key = _cogl_program_cache_get_key (other_driver_cache,
+                                                  2, shader_hashes);
+  u_assert (key != other_driver_key);
+  _cogl_program_cache_free (other_driver_cache);
+
+  /* Round trip */
+  u_assert (!check_binary (cache, key, "binary"));
+  _cogl_program_cache_store (cache, key, 42, "binary", 6);
+  u_assert (check_binary (cache, key, "binary"));
+  u_assert (!check_binary (cache, other_driver_key, "binary"));
+
+  /* Corrupt the binary. The load should fail and remove the file */
+  filename = get_filename (cache, key);
+  u_assert (u_file_get_contents (filename, &contents, &length, NULL));
+  contents[length - 1] ^= 1;
+  u_assert (u_file_set_contents (filename, contents, length, NULL));
+  u_free (contents);
+  u_assert (!check_binary (cache, key, "binary"));
+  u_assert (!u_file_test (filename, U_FILE_TEST_EXISTS));
+
+  /* Truncated file */
+  _cogl_program_cache_store (cache, key, 42, "binary", 6);
+  u_assert (u_file_set_contents (filename, "COGL", 4, NULL));
+  u_assert (!check_binary (cache, key, "binary"));
+  u_assert (!u_file_test (filename, U_FILE_TEST_EXISTS));
+  u_free (filename);
+
+  _cogl_program_cache_free (cache);
+
+  remove_test_directory (directory);
+  u_free (directory);
+}
+
+UNIT_TEST (check_program_cache_eviction,
+           0, /* no requirements */
+           0 /* no failure cases */)
+{
+  char *directory = create_test_directory ();
+  char binary[200], big_binary[1024];
+  size_t file_size = sizeof (CoglProgramCacheHeader) + sizeof (binary);
+  CoglProgramCache *cache;
+  int i;
+
+  memset (binary, 'x', sizeof (binary));
+  memset (big_binary, 'x', sizeof (big_binary));
+
+  /* Make room for three files */
+  cache = _cogl_program_cache_new (directory, "driver", file_size * 3);
+
+  for (i = 0; i < 3; i++)
+    {
+      _cogl_program_cache_store (cache, i, 42, binary, sizeof (binary));
+      /* Make the files look like they were written in order */
+      set_file_age (cache, i, 100 - i);
+    }
+
+  /* Loading the oldest file should make it the most recently used */
+  u_assert (has_binary (cache, 0));
+
+  /* This should take the directory over the limit so that file 1
+   * gets evicted because it is now the least recently used */
+  _cogl_program_cache_store (cache, 3, 42, "y", 1);
+
+  u_assert (has_binary (cache, 0));
+  u_assert (!has_binary (cache, 1));
+  u_assert (has_binary (cache, 2));
+  u_assert (check_binary (cache, 3, "y"));
+
+  /* Binaries that are bigger than the whole cache aren't stored */
+  _cogl_program_cache_store (cache, 4, 42, big_binary, sizeof (big_binary));
+  u_assert (!has_binary (cache, 4));
+  u_assert (has_binary (cache, 0));
+
+  _cogl_program_cache_free (cache);
+
+  remove_test_directory (directory);
+  u_free (directory);
+}
+
+#endif /* ENABLE_UNIT_TESTS */
@@ -0,0 +1,90 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_READBACK_PRIVATE_H__
+#define __COGL_READBACK_PRIVATE_H__
+
+#include "cogl-readback.h"
+#include "cogl-object-private.h"
+#include "cogl-list.h"
+#include "cogl-fence.h"
+
+struct _CoglReadPixelsClosure
+{
+  /* Link in CoglContext::read_pixels_queue once the data is ready */
+  CoglList link;
+  CoglBool queued;
+  /* Set while the callback is being invoked. The dispatcher frees
+   * the closure once the callback returns so cancelling it from
+   * within the callback does nothing */
+  CoglBool dispatching;
+
+  CoglFramebuffer *framebuffer;
+
+  /* The bitmap the application asked us to fill */
+  CoglBitmap *bitmap;
+  /* The bitmap actually passed to the driver. This shares the
+   * storage of @bitmap but has the premultiplied state of the
+   * framebuffer so that the driver doesn't need to map the buffer to
+   * convert it straight after queuing the read */
+  CoglBitmap *read_bitmap;
+
+  /* Whether we asked the driver not to flip the rows and so need to
+   * do it ourselves once the data is ready */
+  CoglBool needs_flip;
+
+  /* Set while waiting for the GPU */
+  CoglFenceClosure *fence;
+
+  CoglReadPixelsCallback callback;
+  void *user_data;
+};
+
+typedef struct _CoglCaptureRingSlot
+{
+  CoglCaptureRing *ring;
+  CoglBitmap *bitmap;
+  CoglReadPixelsClosure *pending;
+
+  CoglReadPixelsCallback callback;
+  void *user_data;
+} CoglCaptureRingSlot;
+
+struct _CoglCaptureRing
+{
+  CoglObject _parent;
+
+  int n_buffers;
+  CoglCaptureRingSlot *slots;
+  /* Slots are handed out in order so that the callbacks also come
+   * back in the order the captures were made */
+  int next_slot;
+};
+
+#endif /* __COGL_READBACK_PRIVATE_H__ */
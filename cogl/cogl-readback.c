@@ -0,0 +1,423 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-readback-private.h"
+#include "cogl-context-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-poll-private.h"
+#include "cogl-private.h"
+#include "cogl-error-private.h"
+
+static void _cogl_capture_ring_free (CoglCaptureRing *ring);
+
+COGL_OBJECT_DEFINE (CaptureRing, capture_ring);
+
+static void
+free_closure (CoglReadPixelsClosure *closure)
+{
+  cogl_object_unref (closure->read_bitmap);
+  cogl_object_unref (closure->bitmap);
+  cogl_object_unref (closure->framebuffer);
+
+  u_slice_free (CoglReadPixelsClosure, closure);
+}
+
+static CoglBool
+flip_bitmap (CoglBitmap *bitmap,
+             CoglError **error)
+{
+  int rowstride = cogl_bitmap_get_rowstride (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  uint8_t *temprow;
+  uint8_t *pixels;
+  int y;
+
+  pixels = _cogl_bitmap_map (bitmap,
+                             COGL_BUFFER_ACCESS_READ |
+                             COGL_BUFFER_ACCESS_WRITE,
+                             0, /* hints */
+                             error);
+  if (pixels == NULL)
+    return FALSE;
+
+  temprow = u_alloca (rowstride * sizeof (uint8_t));
+
+  for (y = 0; y < height / 2; y++)
+    {
+      memcpy (temprow, pixels + y * rowstride, rowstride);
+      memcpy (pixels + y * rowstride,
+              pixels + (height - y - 1) * rowstride, rowstride);
+      memcpy (pixels + (height - y - 1) * rowstride, temprow, rowstride);
+    }
+
+  _cogl_bitmap_unmap (bitmap);
+
+  return TRUE;
+}
+
+static void
+notify_closure (CoglReadPixelsClosure *closure)
+{
+  CoglPixelFormat format = cogl_bitmap_get_format (closure->bitmap);
+  CoglBitmap *result = closure->bitmap;
+  CoglError *ignore_error = NULL;
+
+  /* By now the GPU has written the data so mapping the buffer to fix
+   * up the premultiplied state or the row order won't stall. Both of
+   * these are no-ops for the common case of reading an offscreen
+   * framebuffer in its own format */
+  if (!_cogl_bitmap_convert_premult_status (closure->read_bitmap,
+                                            format,
+                                            &ignore_error) ||
+      (closure->needs_flip &&
+       !flip_bitmap (closure->bitmap, &ignore_error)))
+    {
+      cogl_error_free (ignore_error);
+      result = NULL;
+    }
+
+  closure->callback (closure->framebuffer, result, closure->user_data);
+}
+
+static void
+_cogl_dispatch_read_pixels_cb (CoglContext *context)
+{
+  CoglList queue;
+
+  /* The callbacks may well start new reads which could complete
+   * immediately so we steal the queue to make sure only one set is
+   * dispatched at a time */
+  _cogl_list_init (&queue);
+  _cogl_list_insert_list (&queue, &context->read_pixels_queue);
+  _cogl_list_init (&context->read_pixels_queue);
+
+  _cogl_closure_disconnect (context->read_pixels_dispatch_idle);
+  context->read_pixels_dispatch_idle = NULL;
+
+  /* A callback may cancel any of the other closures in the queue so
+   * we can't hold on to the next link while iterating */
+  while (!_cogl_list_empty (&queue))
+    {
+      CoglReadPixelsClosure *closure =
+        _cogl_container_of (queue.next, CoglReadPixelsClosure, link);
+
+      _cogl_list_remove (&closure->link);
+      closure->queued = FALSE;
+
+      closure->dispatching = TRUE;
+      notify_closure (closure);
+      free_closure (closure);
+    }
+}
+
+static void
+queue_closure (CoglReadPixelsClosure *closure)
+{
+  CoglContext *ctx = closure->framebuffer->context;
+
+  /* Reads are reported in the order they complete which, because
+   * fences are checked in order, is also the order they were
+   * started. This is what allows a capture ring to hand out its
+   * buffers in sequence */
+  _cogl_list_insert (ctx->read_pixels_queue.prev, &closure->link);
+  closure->queued = TRUE;
+
+  if (!ctx->read_pixels_dispatch_idle)
+    {
+      ctx->read_pixels_dispatch_idle =
+        _cogl_poll_renderer_add_idle (ctx->display->renderer,
+                                      (CoglIdleCallback)
+                                      _cogl_dispatch_read_pixels_cb,
+                                      ctx,
+                                      NULL);
+    }
+}
+
+static void
+read_pixels_fence_cb (CoglFence *fence,
+                      void *user_data)
+{
+  CoglReadPixelsClosure *closure = user_data;
+
+  /* The fence closure is freed as soon as we return and the fence
+   * code still uses the framebuffer after calling us so we can't
+   * notify the application from here in case it drops the last
+   * reference to the framebuffer. Instead the closure is queued for
+   * an idle which will be dispatched straight away */
+  closure->fence = NULL;
+  queue_closure (closure);
+}
+
+CoglReadPixelsClosure *
+cogl_framebuffer_read_pixels_async (CoglFramebuffer *framebuffer,
+                                    int x,
+                                    int y,
+                                    CoglReadPixelsFlags source,
+                                    CoglBitmap *bitmap,
+                                    CoglReadPixelsCallback callback,
+                                    void *user_data,
+                                    CoglError **error)
+{
+  CoglContext *ctx;
+  CoglReadPixelsClosure *closure;
+  CoglPixelFormat format, read_format;
+  CoglBitmap *read_bitmap;
+  CoglBool needs_flip = FALSE;
+
+  _COGL_RETURN_VAL_IF_FAIL (source & COGL_READ_PIXELS_COLOR_BUFFER, NULL);
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_framebuffer (framebuffer), NULL);
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_bitmap (bitmap), NULL);
+  _COGL_RETURN_VAL_IF_FAIL (callback != NULL, NULL);
+
+  if (!cogl_framebuffer_allocate (framebuffer, error))
+    return NULL;
+
+  ctx = cogl_framebuffer_get_context (framebuffer);
+
+  /* Ask the driver to read in the premultiplied state of the
+   * framebuffer. Otherwise it would have to map the bitmap straight
+   * away to convert it which would wait for the read to complete */
+  format = cogl_bitmap_get_format (bitmap);
+  if (COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT (format))
+    read_format = ((format & ~COGL_PREMULT_BIT) |
+                   (framebuffer->internal_format & COGL_PREMULT_BIT));
+  else
+    read_format = format;
+
+  if (read_format != format)
+    read_bitmap = _cogl_bitmap_new_shared (bitmap,
+                                           read_format,
+                                           cogl_bitmap_get_width (bitmap),
+                                           cogl_bitmap_get_height (bitmap),
+                                           cogl_bitmap_get_rowstride (bitmap));
+  else
+    read_bitmap = cogl_object_ref (bitmap);
+
+  /* Similarly if the driver would have to flip the rows on the CPU
+   * then we do that ourselves after the data is ready. Offscreen
+   * framebuffers never need flipping */
+  if (!cogl_is_offscreen (framebuffer) &&
+      (source & COGL_READ_PIXELS_NO_FLIP) == 0 &&
+      !_cogl_has_private_feature (ctx,
+                                  COGL_PRIVATE_FEATURE_MESA_PACK_INVERT))
+    {
+      source |= COGL_READ_PIXELS_NO_FLIP;
+      needs_flip = TRUE;
+    }
+
+  _cogl_framebuffer_flush_journal (framebuffer);
+
+  if (!ctx->driver_vtable->framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                                x, y,
+                                                                source,
+                                                                read_bitmap,
+                                                                error))
+    {
+      cogl_object_unref (read_bitmap);
+      return NULL;
+    }
+
+  closure = u_slice_new0 (CoglReadPixelsClosure);
+  closure->framebuffer = cogl_object_ref (framebuffer);
+  closure->bitmap = cogl_object_ref (bitmap);
+  closure->read_bitmap = read_bitmap;
+  closure->needs_flip = needs_flip;
+  closure->callback = callback;
+  closure->user_data = user_data;
+
+  closure->fence = cogl_framebuffer_add_fence_callback (framebuffer,
+                                                        read_pixels_fence_cb,
+                                                        closure);
+
+  /* Without fences we can't tell when the GPU is done so the data
+   * will be waited for when the application maps the buffer. We
+   * still report it from the idle so that the callback is never
+   * invoked re-entrantly */
+  if (closure->fence == NULL)
+    queue_closure (closure);
+
+  return closure;
+}
+
+void
+cogl_framebuffer_cancel_read_pixels_async (CoglFramebuffer *framebuffer,
+                                           CoglReadPixelsClosure *closure)
+{
+  _COGL_RETURN_IF_FAIL (closure);
+  _COGL_RETURN_IF_FAIL (closure->framebuffer == framebuffer);
+
+  /* The callback has already been invoked and the dispatcher will
+   * free the closure when it returns */
+  if (closure->dispatching)
+    return;
+
+  if (closure->fence)
+    cogl_framebuffer_cancel_fence_callback (framebuffer, closure->fence);
+  if (closure->queued)
+    _cogl_list_remove (&closure->link);
+
+  free_closure (closure);
+}
+
+static void
+capture_ring_read_cb (CoglFramebuffer *framebuffer,
+                      CoglBitmap *bitmap,
+                      void *user_data)
+{
+  CoglCaptureRingSlot *slot = user_data;
+  CoglReadPixelsCallback callback = slot->callback;
+  void *callback_data = slot->user_data;
+  /* The application may drop its last reference to the ring from the
+   * callback so we keep it alive until we've finished with the slot */
+  CoglCaptureRing *ring = cogl_object_ref (slot->ring);
+
+  /* The closure is freed once we return. The slot stays busy for the
+   * duration of the callback so that the application can't start a
+   * new capture into the bitmap it's currently looking at */
+  callback (framebuffer, bitmap, callback_data);
+
+  slot->pending = NULL;
+
+  cogl_object_unref (ring);
+}
+
+CoglCaptureRing *
+cogl_capture_ring_new (CoglContext *context,
+                       int width,
+                       int height,
+                       CoglPixelFormat format,
+                       int n_buffers)
+{
+  CoglCaptureRing *ring;
+  int i;
+
+  _COGL_RETURN_VAL_IF_FAIL (n_buffers > 0, NULL);
+
+  ring = u_slice_new0 (CoglCaptureRing);
+  ring->n_buffers = n_buffers;
+  ring->slots = u_new0 (CoglCaptureRingSlot, n_buffers);
+
+  for (i = 0; i < n_buffers; i++)
+    {
+      CoglCaptureRingSlot *slot = ring->slots + i;
+
+      slot->ring = ring;
+      /* This creates a bitmap backed by a pixel buffer so that the
+       * driver can read into it without waiting */
+      slot->bitmap = cogl_bitmap_new_with_size (context,
+                                                width, height,
+                                                format);
+    }
+
+  return _cogl_capture_ring_object_new (ring);
+}
+
+static void
+_cogl_capture_ring_free (CoglCaptureRing *ring)
+{
+  int i;
+
+  for (i = 0; i < ring->n_buffers; i++)
+    {
+      CoglCaptureRingSlot *slot = ring->slots + i;
+
+      if (slot->pending)
+        cogl_framebuffer_cancel_read_pixels_async (slot->pending->framebuffer,
+                                                   slot->pending);
+
+      cogl_object_unref (slot->bitmap);
+    }
+
+  u_free (ring->slots);
+  u_slice_free (CoglCaptureRing, ring);
+}
+
+CoglBool
+cogl_capture_ring_capture (CoglCaptureRing *ring,
+                           CoglFramebuffer *framebuffer,
+                           int x,
+                           int y,
+                           CoglReadPixelsFlags source,
+                           CoglReadPixelsCallback callback,
+                           void *user_data)
+{
+  CoglCaptureRingSlot *slot;
+  CoglError *ignore_error = NULL;
+
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_capture_ring (ring), FALSE);
+  _COGL_RETURN_VAL_IF_FAIL (callback != NULL, FALSE);
+
+  slot = ring->slots + ring->next_slot;
+
+  /* Reads complete in the order they were queued so if the next slot
+   * is still busy then all of them are */
+  if (slot->pending)
+    return FALSE;
+
+  slot->callback = callback;
+  slot->user_data = user_data;
+  slot->pending = cogl_framebuffer_read_pixels_async (framebuffer,
+                                                      x, y,
+                                                      source,
+                                                      slot->bitmap,
+                                                      capture_ring_read_cb,
+                                                      slot,
+                                                      &ignore_error);
+  if (slot->pending == NULL)
+    {
+      cogl_error_free (ignore_error);
+      return FALSE;
+    }
+
+  ring->next_slot = (ring->next_slot + 1) % ring->n_buffers;
+
+  return TRUE;
+}
+
+int
+cogl_capture_ring_get_n_pending (CoglCaptureRing *ring)
+{
+  int n_pending = 0;
+  int i;
+
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_capture_ring (ring), 0);
+
+  for (i = 0; i < ring->n_buffers; i++)
+    if (ring->slots[i].pending)
+      n_pending++;
+
+  return n_pending;
+}
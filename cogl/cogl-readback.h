@@ -0,0 +1,267 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#if !defined(__COGL_H_INSIDE__) && !defined(COGL_COMPILATION)
+#error "Only <cogl/cogl.h> can be included directly."
+#endif
+
+#ifndef __COGL_READBACK_H__
+#define __COGL_READBACK_H__
+
+#include <cogl/cogl-types.h>
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-framebuffer.h>
+#include <cogl/cogl-bitmap.h>
+
+COGL_BEGIN_DECLS
+
+/**
+ * SECTION:cogl-readback
+ * @short_description: Functions for reading back framebuffer contents
+ *   without stalling
+ *
+ * cogl_framebuffer_read_pixels_into_bitmap() has to wait for the GPU
+ * to finish rendering before it can return. The functions here
+ * instead queue a read into a #CoglBitmap and notify the application
+ * once the GPU has written the data so that it can be mapped without
+ * blocking. When the bitmap is backed by a #CoglPixelBuffer, such as
+ * one created with cogl_bitmap_new_with_size(), the transfer happens
+ * asynchronously on the GPU.
+ *
+ * Notifications are dispatched from cogl_poll_renderer_dispatch() so
+ * applications need to integrate Cogl with their main loop as
+ * described in the documentation for cogl_poll_renderer_get_info().
+ *
+ * For continuous capture, such as recording every frame, a
+ * #CoglCaptureRing manages a small set of pixel buffers that are
+ * cycled between so that reads can be in flight while the
+ * application consumes the previous ones.
+ */
+
+/**
+ * CoglReadPixelsCallback:
+ * @framebuffer: The #CoglFramebuffer that was read from
+ * @bitmap: The #CoglBitmap containing the data, or %NULL if the
+ *   read failed
+ * @user_data: The private data passed when the read was started
+ *
+ * The callback prototype used with cogl_framebuffer_read_pixels_async()
+ * and cogl_capture_ring_capture() for notification that the pixel data
+ * is ready. The bitmap can be mapped with cogl_buffer_map() on the
+ * result of cogl_bitmap_get_buffer() without blocking.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef void (* CoglReadPixelsCallback) (CoglFramebuffer *framebuffer,
+                                         CoglBitmap *bitmap,
+                                         void *user_data);
+
+/**
+ * CoglReadPixelsClosure:
+ *
+ * An opaque type representing a pending asynchronous read returned
+ * by cogl_framebuffer_read_pixels_async().
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef struct _CoglReadPixelsClosure CoglReadPixelsClosure;
+
+/**
+ * cogl_framebuffer_read_pixels_async:
+ * @framebuffer: A #CoglFramebuffer
+ * @x: The x position to read from
+ * @y: The y position to read from
+ * @source: Identifies which auxillary buffer you want to read
+ *          (only COGL_READ_PIXELS_COLOR_BUFFER supported currently)
+ * @bitmap: The bitmap to store the results in.
+ * @callback: (scope notified): A #CoglReadPixelsCallback to be called
+ *            once the data is available
+ * @user_data: (closure): Private data that will be passed to the callback
+ * @error: A #CoglError to catch exceptional errors
+ *
+ * Starts reading a region of @framebuffer into @bitmap in the same
+ * way as cogl_framebuffer_read_pixels_into_bitmap() but without
+ * waiting for rendering to complete. Once the GPU has finished
+ * writing the data @callback will be called from
+ * cogl_poll_renderer_dispatch(). The callback is always invoked
+ * asynchronously, even if the driver had to fall back to a
+ * synchronous read.
+ *
+ * The contents of @bitmap are undefined until the callback is called
+ * and it should not be modified in the meantime. A reference is
+ * taken on both @framebuffer and @bitmap until the callback returns
+ * or the read is cancelled.
+ *
+ * The read can only be made asynchronous when @bitmap is backed by a
+ * #CoglPixelBuffer and the driver can read directly into the
+ * requested format. Otherwise the data is converted on the CPU at
+ * the time of this call.
+ *
+ * Return value: A #CoglReadPixelsClosure that can be passed to
+ *   cogl_framebuffer_cancel_read_pixels_async(), or %NULL if the read
+ *   could not be started in which case @error will be set and
+ *   @callback will never be called. The closure is freed
+ *   automatically after the callback returns.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglReadPixelsClosure *
+cogl_framebuffer_read_pixels_async (CoglFramebuffer *framebuffer,
+                                    int x,
+                                    int y,
+                                    CoglReadPixelsFlags source,
+                                    CoglBitmap *bitmap,
+                                    CoglReadPixelsCallback callback,
+                                    void *user_data,
+                                    CoglError **error);
+
+/**
+ * cogl_framebuffer_cancel_read_pixels_async:
+ * @framebuffer: The #CoglFramebuffer the read was started on
+ * @closure: The #CoglReadPixelsClosure returned from
+ *           cogl_framebuffer_read_pixels_async()
+ *
+ * Cancels a read previously started with
+ * cogl_framebuffer_read_pixels_async(); the callback will not be
+ * called. The contents of the bitmap are undefined afterwards.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_framebuffer_cancel_read_pixels_async (CoglFramebuffer *framebuffer,
+                                           CoglReadPixelsClosure *closure);
+
+/**
+ * CoglCaptureRing:
+ *
+ * A set of pixel buffers that are cycled between to continuously read
+ * back framebuffer contents without waiting for the GPU.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef struct _CoglCaptureRing CoglCaptureRing;
+
+/**
+ * cogl_capture_ring_new:
+ * @context: A #CoglContext
+ * @width: The width of the region that will be captured
+ * @height: The height of the region that will be captured
+ * @format: The #CoglPixelFormat to read the data as
+ * @n_buffers: The number of buffers in the ring. This is usually 2
+ *   or 3.
+ *
+ * Creates a ring of @n_buffers pixel buffers each big enough to hold
+ * a @width x @height region in @format. Using more buffers allows
+ * more reads to be in flight at once at the cost of extra memory and
+ * latency.
+ *
+ * Return value: (transfer full): A newly allocated #CoglCaptureRing
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglCaptureRing *
+cogl_capture_ring_new (CoglContext *context,
+                       int width,
+                       int height,
+                       CoglPixelFormat format,
+                       int n_buffers);
+
+/**
+ * cogl_capture_ring_capture:
+ * @ring: A #CoglCaptureRing
+ * @framebuffer: The #CoglFramebuffer to read from
+ * @x: The x position to read from
+ * @y: The y position to read from
+ * @source: Identifies which auxillary buffer you want to read
+ *          (only COGL_READ_PIXELS_COLOR_BUFFER supported currently)
+ * @callback: (scope notified): A #CoglReadPixelsCallback to be called
+ *            once the data is available
+ * @user_data: (closure): Private data that will be passed to the callback
+ *
+ * Starts reading a region of @framebuffer into the next free buffer
+ * of @ring. The callback is invoked as for
+ * cogl_framebuffer_read_pixels_async(). The buffer is given back to
+ * the ring as soon as the callback returns so the application must
+ * copy out any data it wants to keep before then.
+ *
+ * If every buffer in the ring is still waiting for a previous read
+ * then nothing is read and %FALSE is returned. Continuous capture
+ * would typically treat that as a dropped frame.
+ *
+ * Return value: %TRUE if the read was started or %FALSE otherwise.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglBool
+cogl_capture_ring_capture (CoglCaptureRing *ring,
+                           CoglFramebuffer *framebuffer,
+                           int x,
+                           int y,
+                           CoglReadPixelsFlags source,
+                           CoglReadPixelsCallback callback,
+                           void *user_data);
+
+/**
+ * cogl_capture_ring_get_n_pending:
+ * @ring: A #CoglCaptureRing
+ *
+ * Return value: The number of buffers in @ring that are waiting for
+ *   a read to complete.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_capture_ring_get_n_pending (CoglCaptureRing *ring);
+
+/**
+ * cogl_is_capture_ring:
+ * @object: A #CoglObject pointer
+ *
+ * Gets whether the given object references a #CoglCaptureRing.
+ *
+ * Return value: %TRUE if the object references a #CoglCaptureRing
+ *   and %FALSE otherwise.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglBool
+cogl_is_capture_ring (void *object);
+
+COGL_END_DECLS
+
+#endif /* __COGL_READBACK_H__ */
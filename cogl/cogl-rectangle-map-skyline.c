@@ -0,0 +1,737 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ulib.h>
+
+#include "cogl-util.h"
+#include "cogl-rectangle-map-skyline.h"
+
+#include <test-fixtures/test-unit.h>
+
+/* Implements the same interface as CoglRectangleMap but packs the
+   rectangles using a skyline. The skyline is the top edge of the
+   allocated space, stored as a list of horizontal segments that
+   together span the width of the map. New rectangles are placed on
+   the skyline at the position where their top edge ends up lowest,
+   which for lots of similarly sized rectangles such as glyphs ends
+   up filling the map in rows without the fragmentation that the
+   binary tree gets.
+
+   Any space that ends up trapped underneath a rectangle because it
+   didn't sit flat on the skyline is remembered in a list of free
+   rectangles, as is the space of any removed rectangles. These are
+   tried first with a best-area-fit search before growing the
+   skyline. This is the "skyline with waste map" algorithm described
+   in Jukka Jylänki's "A Thousand Ways to Pack the Bin". */
+
+typedef struct _CoglRectangleMapSkylineSegment
+{
+  unsigned int x, y;
+  unsigned int width;
+} CoglRectangleMapSkylineSegment;
+
+typedef struct _CoglRectangleMapSkylineAllocation
+{
+  CoglRectangleMapEntry rectangle;
+  void *data;
+} CoglRectangleMapSkylineAllocation;
+
+struct _CoglRectangleMapSkyline
+{
+  unsigned int width, height;
+
+  unsigned int n_rectangles;
+
+  unsigned int space_remaining;
+
+  UDestroyNotify value_destroy_func;
+
+  /* Array of CoglRectangleMapSkylineSegments sorted by x. Adjacent
+     segments always have a different height */
+  UArray *segments;
+
+  /* Array of CoglRectangleMapEntries for the unused space below the
+     skyline */
+  UArray *free_rectangles;
+
+  /* Hash table of allocations keyed by their position so that they
+     can be found again in _remove */
+  UHashTable *allocations;
+};
+
+CoglRectangleMapSkyline *
+_cogl_rectangle_map_skyline_new (unsigned int width,
+                                 unsigned int height,
+                                 UDestroyNotify value_destroy_func)
+{
+  CoglRectangleMapSkyline *skyline = u_new (CoglRectangleMapSkyline, 1);
+  CoglRectangleMapSkylineSegment segment;
+
+  skyline->width = width;
+  skyline->height = height;
+  skyline->n_rectangles = 0;
+  skyline->space_remaining = width * height;
+  skyline->value_destroy_func = value_destroy_func;
+
+  skyline->segments =
+    u_array_new (FALSE, FALSE, sizeof (CoglRectangleMapSkylineSegment));
+  segment.x = 0;
+  segment.y = 0;
+  segment.width = width;
+  u_array_append_val (skyline->segments, segment);
+
+  skyline->free_rectangles =
+    u_array_new (FALSE, FALSE, sizeof (CoglRectangleMapEntry));
+
+  skyline->allocations = u_hash_table_new (u_direct_hash, u_direct_equal);
+
+  return skyline;
+}
+
+/* The key doesn't depend on the size of the map so that it stays
+   valid when the map grows. Textures can't be anywhere near 65536
+   pixels wide so the position fits in 32 bits */
+static void *
+_cogl_rectangle_map_skyline_get_key (unsigned int x,
+                                     unsigned int y)
+{
+  return U_UINT_TO_POINTER ((y << 16) | x);
+}
+
+static void
+_cogl_rectangle_map_skyline_add_free_rectangle (CoglRectangleMapSkyline *skyline,
+                                                unsigned int x,
+                                                unsigned int y,
+                                                unsigned int width,
+                                                unsigned int height)
+{
+  UArray *free_rectangles = skyline->free_rectangles;
+  CoglRectangleMapEntry rectangle = { x, y, width, height };
+  CoglBool merged;
+  int i;
+
+  /* Merge with any free rectangle that shares a whole edge with this
+     one so that the space from neighbouring removed rectangles can be
+     reused for a bigger one. Merging may make the result line up with
+     another rectangle so this is repeated until nothing changes */
+  do
+    {
+      merged = FALSE;
+
+      for (i = 0; i < free_rectangles->len; i++)
+        {
+          CoglRectangleMapEntry *other =
+            &u_array_index (free_rectangles, CoglRectangleMapEntry, i);
+
+          if (other->y == rectangle.y &&
+              other->height == rectangle.height &&
+              (other->x + other->width == rectangle.x ||
+               rectangle.x + rectangle.width == other->x))
+            {
+              rectangle.x = MIN (rectangle.x, other->x);
+              rectangle.width += other->width;
+              merged = TRUE;
+            }
+          else if (other->x == rectangle.x &&
+                   other->width == rectangle.width &&
+                   (other->y + other->height == rectangle.y ||
+                    rectangle.y + rectangle.height == other->y))
+            {
+              rectangle.y = MIN (rectangle.y, other->y);
+              rectangle.height += other->height;
+              merged = TRUE;
+            }
+
+          if (merged)
+            {
+              u_array_remove_index_fast (free_rectangles, i);
+              break;
+            }
+        }
+    }
+  while (merged);
+
+  u_array_append_val (free_rectangles, rectangle);
+}
+
+static CoglBool
+_cogl_rectangle_map_skyline_add_to_free_rectangle (CoglRectangleMapSkyline *skyline,
+                                                   unsigned int width,
+                                                   unsigned int height,
+                                                   CoglRectangleMapEntry *rectangle)
+{
+  UArray *free_rectangles = skyline->free_rectangles;
+  CoglRectangleMapEntry found;
+  unsigned int best_area = UINT_MAX, best_short_side = UINT_MAX;
+  int best_index = -1;
+  int i;
+
+  /* Pick the free rectangle that leaves the least area over, using
+     the shortest leftover side to break ties */
+  for (i = 0; i < free_rectangles->len; i++)
+    {
+      CoglRectangleMapEntry *free_rectangle =
+        &u_array_index (free_rectangles, CoglRectangleMapEntry, i);
+      unsigned int area, short_side;
+
+      if (free_rectangle->width < width || free_rectangle->height < height)
+        continue;
+
+      area = free_rectangle->width * free_rectangle->height - width * height;
+      short_side = MIN (free_rectangle->width - width,
+                        free_rectangle->height - height);
+
+      if (area < best_area ||
+          (area == best_area && short_side < best_short_side))
+        {
+          best_index = i;
+          best_area = area;
+          best_short_side = short_side;
+
+          if (area == 0)
+            break;
+        }
+    }
+
+  if (best_index == -1)
+    return FALSE;
+
+  found = u_array_index (free_rectangles, CoglRectangleMapEntry, best_index);
+  u_array_remove_index_fast (free_rectangles, best_index);
+
+  rectangle->x = found.x;
+  rectangle->y = found.y;
+  rectangle->width = width;
+  rectangle->height = height;
+
+  /* Split the leftover space into two rectangles. The split is made
+     along the shorter leftover side so that the bigger of the two
+     pieces is as big as possible */
+  if (found.width - width < found.height - height)
+    {
+      if (found.width > width)
+        _cogl_rectangle_map_skyline_add_free_rectangle (skyline,
+                                                        found.x + width,
+                                                        found.y,
+                                                        found.width - width,
+                                                        height);
+      if (found.height > height)
+        _cogl_rectangle_map_skyline_add_free_rectangle (skyline,
+                                                        found.x,
+                                                        found.y + height,
+                                                        found.width,
+                                                        found.height - height);
+    }
+  else
+    {
+      if (found.width > width)
+        _cogl_rectangle_map_skyline_add_free_rectangle (skyline,
+                                                        found.x + width,
+                                                        found.y,
+                                                        found.width - width,
+                                                        found.height);
+      if (found.height > height)
+        _cogl_rectangle_map_skyline_add_free_rectangle (skyline,
+                                                        found.x,
+                                                        found.y + height,
+                                                        width,
+                                                        found.height - height);
+    }
+
+  return TRUE;
+}
+
+/* Checks whether a rectangle can be placed with its left edge at the
+   start of the given segment. If so it returns the y position it
+   would have and the area that would be wasted underneath it */
+static CoglBool
+_cogl_rectangle_map_skyline_fits (CoglRectangleMapSkyline *skyline,
+                                  int segment_index,
+                                  unsigned int width,
+                                  unsigned int height,
+                                  unsigned int *y_out,
+                                  unsigned int *waste_out)
+{
+  CoglRectangleMapSkylineSegment *segments =
+    (CoglRectangleMapSkylineSegment *) skyline->segments->data;
+  unsigned int width_left;
+  unsigned int y = 0, waste = 0;
+  int i;
+
+  if (segments[segment_index].x + width > skyline->width)
+    return FALSE;
+
+  /* The rectangle has to sit on the highest segment that it spans */
+  for (i = segment_index, width_left = width; width_left > 0; i++)
+    {
+      y = MAX (y, segments[i].y);
+      width_left -= MIN (width_left, segments[i].width);
+    }
+
+  if (y + height > skyline->height)
+    return FALSE;
+
+  for (i = segment_index, width_left = width; width_left > 0; i++)
+    {
+      unsigned int span = MIN (width_left, segments[i].width);
+
+      waste += span * (y - segments[i].y);
+      width_left -= span;
+    }
+
+  *y_out = y;
+  *waste_out = waste;
+
+  return TRUE;
+}
+
+static void
+_cogl_rectangle_map_skyline_place (CoglRectangleMapSkyline *skyline,
+                                   int segment_index,
+                                   const CoglRectangleMapEntry *rectangle)
+{
+  UArray *segments = skyline->segments;
+  CoglRectangleMapSkylineSegment new_segment;
+  CoglRectangleMapSkylineSegment *segment;
+  unsigned int end = rectangle->x + rectangle->width;
+  unsigned int width_left;
+  int i;
+
+  /* Remember any space that will be trapped under the rectangle */
+  for (i = segment_index, width_left = rectangle->width; width_left > 0; i++)
+    {
+      segment = &u_array_index (segments, CoglRectangleMapSkylineSegment, i);
+
+      if (segment->y < rectangle->y)
+        _cogl_rectangle_map_skyline_add_free_rectangle
+          (skyline,
+           segment->x,
+           segment->y,
+           MIN (width_left, segment->width),
+           rectangle->y - segment->y);
+
+      width_left -= MIN (width_left, segment->width);
+    }
+
+  /* Remove the segments that are completely covered by the rectangle
+     and trim the one that is partially covered */
+  while (segment_index < segments->len)
+    {
+      segment = &u_array_index (segments,
+                                CoglRectangleMapSkylineSegment,
+                                segment_index);
+
+      if (segment->x + segment->width <= end)
+        u_array_remove_index (segments, segment_index);
+      else
+        {
+          if (segment->x < end)
+            {
+              segment->width -= end - segment->x;
+              segment->x = end;
+            }
+          break;
+        }
+    }
+
+  new_segment.x = rectangle->x;
+  new_segment.y = rectangle->y + rectangle->height;
+  new_segment.width = rectangle->width;
+  u_array_insert_val (segments, segment_index, new_segment);
+
+  /* Merge with the neighbours if they end up at the same height */
+  if (segment_index + 1 < segments->len)
+    {
+      CoglRectangleMapSkylineSegment *next =
+        &u_array_index (segments,
+                        CoglRectangleMapSkylineSegment,
+                        segment_index + 1);
+
+      if (next->y == new_segment.y)
+        {
+          u_array_index (segments,
+                         CoglRectangleMapSkylineSegment,
+                         segment_index).width += next->width;
+          u_array_remove_index (segments, segment_index + 1);
+        }
+    }
+  if (segment_index > 0)
+    {
+      CoglRectangleMapSkylineSegment *prev =
+        &u_array_index (segments,
+                        CoglRectangleMapSkylineSegment,
+                        segment_index - 1);
+
+      if (prev->y == new_segment.y)
+        {
+          prev->width += u_array_index (segments,
+                                        CoglRectangleMapSkylineSegment,
+                                        segment_index).width;
+          u_array_remove_index (segments, segment_index);
+        }
+    }
+}
+
+static CoglBool
+_cogl_rectangle_map_skyline_add_to_skyline (CoglRectangleMapSkyline *skyline,
+                                            unsigned int width,
+                                            unsigned int height,
+                                            CoglRectangleMapEntry *rectangle)
+{
+  CoglRectangleMapSkylineSegment *segments =
+    (CoglRectangleMapSkylineSegment *) skyline->segments->data;
+  unsigned int best_top = UINT_MAX, best_waste = UINT_MAX;
+  int best_index = -1;
+  int i;
+
+  /* Find the position where the top of the rectangle ends up lowest,
+     preferring the one that wastes the least space */
+  for (i = 0; i < skyline->segments->len; i++)
+    {
+      unsigned int y, waste;
+
+      if (_cogl_rectangle_map_skyline_fits (skyline, i,
+                                            width, height,
+                                            &y, &waste) &&
+          (y + height < best_top ||
+           (y + height == best_top && waste < best_waste)))
+        {
+          best_index = i;
+          best_top = y + height;
+          best_waste = waste;
+        }
+    }
+
+  if (best_index == -1)
+    return FALSE;
+
+  rectangle->x = segments[best_index].x;
+  rectangle->y = best_top - height;
+  rectangle->width = width;
+  rectangle->height = height;
+
+  _cogl_rectangle_map_skyline_place (skyline, best_index, rectangle);
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_rectangle_map_skyline_add (CoglRectangleMapSkyline *skyline,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 void *data,
+                                 CoglRectangleMapEntry *rectangle)
+{
+  CoglRectangleMapSkylineAllocation *allocation;
+
+  _COGL_RETURN_VAL_IF_FAIL (width > 0 && height > 0, FALSE);
+
+  if (!_cogl_rectangle_map_skyline_add_to_free_rectangle (skyline,
+                                                          width, height,
+                                                          rectangle) &&
+      !_cogl_rectangle_map_skyline_add_to_skyline (skyline,
+                                                   width, height,
+                                                   rectangle))
+    return FALSE;
+
+  allocation = u_slice_new (CoglRectangleMapSkylineAllocation);
+  allocation->rectangle = *rectangle;
+  allocation->data = data;
+
+  u_hash_table_insert (skyline->allocations,
+                       _cogl_rectangle_map_skyline_get_key (rectangle->x,
+                                                            rectangle->y),
+                       allocation);
+
+  skyline->n_rectangles++;
+  skyline->space_remaining -= width * height;
+
+  return TRUE;
+}
+
+void
+_cogl_rectangle_map_skyline_remove (CoglRectangleMapSkyline *skyline,
+                                    const CoglRectangleMapEntry *rectangle)
+{
+  void *key = _cogl_rectangle_map_skyline_get_key (rectangle->x,
+                                                   rectangle->y);
+  CoglRectangleMapSkylineAllocation *allocation =
+    u_hash_table_lookup (skyline->allocations, key);
+
+  /* This should only happen if someone tried to remove a rectangle
+     that was not in the map */
+  if (allocation == NULL ||
+      allocation->rectangle.width != rectangle->width ||
+      allocation->rectangle.height != rectangle->height)
+    u_return_if_reached ();
+
+  if (skyline->value_destroy_func)
+    skyline->value_destroy_func (allocation->data);
+
+  u_hash_table_remove (skyline->allocations, key);
+  u_slice_free (CoglRectangleMapSkylineAllocation, allocation);
+
+  /* The space isn't given back to the skyline but it can be reused
+     by later allocations that fit into it */
+  _cogl_rectangle_map_skyline_add_free_rectangle (skyline,
+                                                  rectangle->x,
+                                                  rectangle->y,
+                                                  rectangle->width,
+                                                  rectangle->height);
+
+  u_assert (skyline->n_rectangles > 0);
+  skyline->n_rectangles--;
+  skyline->space_remaining += rectangle->width * rectangle->height;
+}
+
+void
+_cogl_rectangle_map_skyline_grow (CoglRectangleMapSkyline *skyline,
+                                  unsigned int width,
+                                  unsigned int height)
+{
+  _COGL_RETURN_IF_FAIL (width >= skyline->width &&
+                        height >= skyline->height);
+
+  /* Extending the height doesn't need anything except updating the
+     size because the skyline is measured from the bottom. The extra
+     width becomes a new segment at the bottom */
+  if (width > skyline->width)
+    {
+      CoglRectangleMapSkylineSegment *last =
+        &u_array_index (skyline->segments,
+                        CoglRectangleMapSkylineSegment,
+                        skyline->segments->len - 1);
+
+      if (last->y == 0)
+        last->width += width - skyline->width;
+      else
+        {
+          CoglRectangleMapSkylineSegment segment;
+
+          segment.x = skyline->width;
+          segment.y = 0;
+          segment.width = width - skyline->width;
+          u_array_append_val (skyline->segments, segment);
+        }
+    }
+
+  skyline->space_remaining +=
+    width * height - skyline->width * skyline->height;
+  skyline->width = width;
+  skyline->height = height;
+}
+
+unsigned int
+_cogl_rectangle_map_skyline_get_width (CoglRectangleMapSkyline *skyline)
+{
+  return skyline->width;
+}
+
+unsigned int
+_cogl_rectangle_map_skyline_get_height (CoglRectangleMapSkyline *skyline)
+{
+  return skyline->height;
+}
+
+unsigned int
+_cogl_rectangle_map_skyline_get_remaining_space (CoglRectangleMapSkyline *skyline)
+{
+  return skyline->space_remaining;
+}
+
+unsigned int
+_cogl_rectangle_map_skyline_get_n_rectangles (CoglRectangleMapSkyline *skyline)
+{
+  return skyline->n_rectangles;
+}
+
+typedef struct _CoglRectangleMapSkylineForeachClosure
+{
+  CoglRectangleMapCallback callback;
+  void *data;
+} CoglRectangleMapSkylineForeachClosure;
+
+static void
+_cogl_rectangle_map_skyline_foreach_cb (void *key,
+                                        void *value,
+                                        void *user_data)
+{
+  CoglRectangleMapSkylineAllocation *allocation = value;
+  CoglRectangleMapSkylineForeachClosure *closure = user_data;
+
+  closure->callback (&allocation->rectangle,
+                     allocation->data,
+                     closure->data);
+}
+
+void
+_cogl_rectangle_map_skyline_foreach (CoglRectangleMapSkyline *skyline,
+                                     CoglRectangleMapCallback callback,
+                                     void *data)
+{
+  CoglRectangleMapSkylineForeachClosure closure;
+
+  closure.callback = callback;
+  closure.data = data;
+
+  u_hash_table_foreach (skyline->allocations,
+                        _cogl_rectangle_map_skyline_foreach_cb,
+                        &closure);
+}
+
+static void
+_cogl_rectangle_map_skyline_free_cb (void *key,
+                                     void *value,
+                                     void *user_data)
+{
+  CoglRectangleMapSkylineAllocation *allocation = value;
+  CoglRectangleMapSkyline *skyline = user_data;
+
+  if (skyline->value_destroy_func)
+    skyline->value_destroy_func (allocation->data);
+
+  u_slice_free (CoglRectangleMapSkylineAllocation, allocation);
+}
+
+void
+_cogl_rectangle_map_skyline_free (CoglRectangleMapSkyline *skyline)
+{
+  u_hash_table_foreach (skyline->allocations,
+                        _cogl_rectangle_map_skyline_free_cb,
+                        skyline);
+  u_hash_table_destroy (skyline->allocations);
+
+  u_array_free (skyline->free_rectangles, TRUE);
+  u_array_free (skyline->segments, TRUE);
+
+  u_free (skyline);
+}
+
+typedef struct _CheckSkylineState
+{
+  CoglRectangleMapEntry *rectangles;
+  int n_rectangles;
+} CheckSkylineState;
+
+static void
+check_skyline_get_rectangles_cb (const CoglRectangleMapEntry *entry,
+                                 void *rectangle_data,
+                                 void *user_data)
+{
+  CheckSkylineState *state = user_data;
+
+  state->rectangles[state->n_rectangles++] = *entry;
+}
+
+static void
+check_skyline_no_overlaps (CoglRectangleMapSkyline *skyline)
+{
+  CheckSkylineState state;
+  int i, j;
+
+  state.rectangles = u_new (CoglRectangleMapEntry, skyline->n_rectangles);
+  state.n_rectangles = 0;
+
+  _cogl_rectangle_map_skyline_foreach (skyline,
+                                       check_skyline_get_rectangles_cb,
+                                       &state);
+  u_assert_cmpint (state.n_rectangles, ==, skyline->n_rectangles);
+
+  for (i = 0; i < state.n_rectangles; i++)
+    {
+      CoglRectangleMapEntry *a = state.rectangles + i;
+
+      u_assert (a->x + a->width <= skyline->width);
+      u_assert (a->y + a->height <= skyline->height);
+
+      for (j = i + 1; j < state.n_rectangles; j++)
+        {
+          CoglRectangleMapEntry *b = state.rectangles + j;
+
+          u_assert (a->x >= b->x + b->width ||
+                    b->x >= a->x + a->width ||
+                    a->y >= b->y + b->height ||
+                    b->y >= a->y + a->height);
+        }
+    }
+
+  u_free (state.rectangles);
+}
+
+UNIT_TEST (check_rectangle_map_skyline_packing,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  CoglRectangleMapSkyline *skyline =
+    _cogl_rectangle_map_skyline_new (256, 256, NULL);
+  CoglRectangleMapEntry rectangles[64];
+  CoglRectangleMapEntry rectangle;
+  int i;
+
+  /* A mix of glyph-like sizes */
+  for (i = 0; i < U_N_ELEMENTS (rectangles); i++)
+    u_assert (_cogl_rectangle_map_skyline_add (skyline,
+                                               8 + (i * 5) % 17,
+                                               10 + (i * 3) % 13,
+                                               NULL,
+                                               rectangles + i));
+  check_skyline_no_overlaps (skyline);
+
+  /* Removing every other rectangle should let a rectangle of the same
+     size go back into the same space without growing the skyline */
+  for (i = 0; i < U_N_ELEMENTS (rectangles); i += 2)
+    _cogl_rectangle_map_skyline_remove (skyline, rectangles + i);
+  u_assert_cmpint (skyline->n_rectangles, ==, U_N_ELEMENTS (rectangles) / 2);
+
+  u_assert (_cogl_rectangle_map_skyline_add (skyline,
+                                             rectangles[0].width,
+                                             rectangles[0].height,
+                                             NULL,
+                                             &rectangle));
+  u_assert_cmpint (rectangle.x, ==, rectangles[0].x);
+  u_assert_cmpint (rectangle.y, ==, rectangles[0].y);
+  check_skyline_no_overlaps (skyline);
+
+  /* Nothing bigger than the map should fit */
+  u_assert (!_cogl_rectangle_map_skyline_add (skyline, 257, 1, NULL,
+                                              &rectangle));
+
+  /* Until it is grown, after which the existing rectangles should
+     stay where they are */
+  _cogl_rectangle_map_skyline_grow (skyline, 512, 256);
+  u_assert (_cogl_rectangle_map_skyline_add (skyline, 257, 1, NULL,
+                                             &rectangle));
+  check_skyline_no_overlaps (skyline);
+
+  _cogl_rectangle_map_skyline_free (skyline);
+}
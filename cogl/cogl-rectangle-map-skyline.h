@@ -0,0 +1,80 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_RECTANGLE_MAP_SKYLINE_H
+#define __COGL_RECTANGLE_MAP_SKYLINE_H
+
+#include <ulib.h>
+#include "cogl-types.h"
+#include "cogl-rectangle-map.h"
+
+typedef struct _CoglRectangleMapSkyline CoglRectangleMapSkyline;
+
+CoglRectangleMapSkyline *
+_cogl_rectangle_map_skyline_new (unsigned int width,
+                                 unsigned int height,
+                                 UDestroyNotify value_destroy_func);
+
+CoglBool
+_cogl_rectangle_map_skyline_add (CoglRectangleMapSkyline *skyline,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 void *data,
+                                 CoglRectangleMapEntry *rectangle);
+
+void
+_cogl_rectangle_map_skyline_remove (CoglRectangleMapSkyline *skyline,
+                                    const CoglRectangleMapEntry *rectangle);
+
+void
+_cogl_rectangle_map_skyline_grow (CoglRectangleMapSkyline *skyline,
+                                  unsigned int width,
+                                  unsigned int height);
+
+unsigned int
+_cogl_rectangle_map_skyline_get_width (CoglRectangleMapSkyline *skyline);
+
+unsigned int
+_cogl_rectangle_map_skyline_get_height (CoglRectangleMapSkyline *skyline);
+
+unsigned int
+_cogl_rectangle_map_skyline_get_remaining_space (CoglRectangleMapSkyline *skyline);
+
+unsigned int
+_cogl_rectangle_map_skyline_get_n_rectangles (CoglRectangleMapSkyline *skyline);
+
+void
+_cogl_rectangle_map_skyline_foreach (CoglRectangleMapSkyline *skyline,
+                                     CoglRectangleMapCallback callback,
+                                     void *data);
+
+void
+_cogl_rectangle_map_skyline_free (CoglRectangleMapSkyline *skyline);
+
+#endif /* __COGL_RECTANGLE_MAP_SKYLINE_H */
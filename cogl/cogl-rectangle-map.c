@@ -39,13 +39,20 @@
 
 #include "cogl-util.h"
 #include "cogl-rectangle-map.h"
+#include "cogl-rectangle-map-skyline.h"
 #include "cogl-debug.h"
 
+#include <test-fixtures/test-unit.h>
+
 /* Implements a data structure which keeps track of unused
    sub-rectangles within a larger rectangle using a binary tree
    structure. The algorithm for this is based on the description here:
 
    http://www.blackpawn.com/texts/lightmaps/default.html
+
+   Maps created with COGL_RECTANGLE_MAP_TYPE_SKYLINE instead forward
+   everything to the skyline allocator in
+   cogl-rectangle-map-skyline.c.
 */
 
 #if defined (COGL_ENABLE_DEBUG) && defined (HAVE_CAIRO)
@@ -73,6 +80,10 @@ typedef enum
 
 struct _CoglRectangleMap
 {
+  /* If this is set then the map is using the skyline allocator and
+     none of the other members are used */
+  CoglRectangleMapSkyline *skyline;
+
   CoglRectangleMapNode *root;
 
   unsigned int n_rectangles;
@@ -148,6 +159,7 @@ _cogl_rectangle_map_new (unsigned int width,
   root->rectangle.height = height;
   root->largest_gap = width * height;
 
+  map->skyline = NULL;
   map->root = root;
   map->n_rectangles = 0;
   map->value_destroy_func = value_destroy_func;
@@ -158,6 +170,33 @@ _cogl_rectangle_map_new (unsigned int width,
   return map;
 }
 
+CoglRectangleMap *
+_cogl_rectangle_map_new_with_type (CoglRectangleMapType type,
+                                   unsigned int width,
+                                   unsigned int height,
+                                   UDestroyNotify value_destroy_func)
+{
+  CoglRectangleMap *map;
+
+  if (type == COGL_RECTANGLE_MAP_TYPE_TREE)
+    return _cogl_rectangle_map_new (width, height, value_destroy_func);
+
+  map = u_new0 (CoglRectangleMap, 1);
+  map->skyline = _cogl_rectangle_map_skyline_new (width,
+                                                  height,
+                                                  value_destroy_func);
+
+  return map;
+}
+
+CoglRectangleMapType
+_cogl_rectangle_map_get_type (CoglRectangleMap *map)
+{
+  return (map->skyline ?
+          COGL_RECTANGLE_MAP_TYPE_SKYLINE :
+          COGL_RECTANGLE_MAP_TYPE_TREE);
+}
+
 static void
 _cogl_rectangle_map_stack_push (UArray *stack,
                                 CoglRectangleMapNode *node,
@@ -360,6 +399,12 @@ _cogl_rectangle_map_add (CoglRectangleMap *map,
   UArray *stack = map->stack;
   CoglRectangleMapNode *found_node = NULL;
 
+  if (map->skyline)
+    return _cogl_rectangle_map_skyline_add (map->skyline,
+                                            width, height,
+                                            data,
+                                            rectangle);
+
   /* Zero-sized rectangles break the algorithm for removing rectangles
      so we'll disallow them */
   _COGL_RETURN_VAL_IF_FAIL (width > 0 && height > 0, FALSE);
@@ -486,6 +531,12 @@ _cogl_rectangle_map_remove (CoglRectangleMap *map,
   CoglRectangleMapNode *node = map->root;
   unsigned int rectangle_size = rectangle->width * rectangle->height;
 
+  if (map->skyline)
+    {
+      _cogl_rectangle_map_skyline_remove (map->skyline, rectangle);
+      return;
+    }
+
   /* We can do a binary-chop down the search tree to find the rectangle */
   while (node->type == COGL_RECTANGLE_MAP_BRANCH)
     {
@@ -567,27 +618,117 @@ _cogl_rectangle_map_remove (CoglRectangleMap *map,
 #endif
 }
 
+/* Creates a new root for the map that has the old root as its left
+   branch and an empty leaf covering the extra space as its right
+   branch. Only one of the dimensions can be grown at a time so that
+   the node can be split in one direction like the other branches */
+static CoglRectangleMapNode *
+_cogl_rectangle_map_grow_root (CoglRectangleMapNode *old_root,
+                               unsigned int width,
+                               unsigned int height)
+{
+  CoglRectangleMapNode *root = _cogl_rectangle_map_node_new ();
+  CoglRectangleMapNode *extra = _cogl_rectangle_map_node_new ();
+
+  extra->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
+  extra->parent = root;
+
+  if (width > old_root->rectangle.width)
+    {
+      extra->rectangle.x = old_root->rectangle.width;
+      extra->rectangle.y = 0;
+      extra->rectangle.width = width - old_root->rectangle.width;
+      extra->rectangle.height = height;
+    }
+  else
+    {
+      extra->rectangle.x = 0;
+      extra->rectangle.y = old_root->rectangle.height;
+      extra->rectangle.width = width;
+      extra->rectangle.height = height - old_root->rectangle.height;
+    }
+
+  extra->largest_gap = extra->rectangle.width * extra->rectangle.height;
+
+  root->type = COGL_RECTANGLE_MAP_BRANCH;
+  root->parent = NULL;
+  root->rectangle.x = 0;
+  root->rectangle.y = 0;
+  root->rectangle.width = width;
+  root->rectangle.height = height;
+  root->d.branch.left = old_root;
+  root->d.branch.right = extra;
+  root->largest_gap = MAX (old_root->largest_gap, extra->largest_gap);
+
+  old_root->parent = root;
+
+  return root;
+}
+
+void
+_cogl_rectangle_map_grow (CoglRectangleMap *map,
+                          unsigned int width,
+                          unsigned int height)
+{
+  unsigned int old_width, old_height;
+
+  if (map->skyline)
+    {
+      _cogl_rectangle_map_skyline_grow (map->skyline, width, height);
+      return;
+    }
+
+  old_width = map->root->rectangle.width;
+  old_height = map->root->rectangle.height;
+
+  _COGL_RETURN_IF_FAIL (width >= old_width && height >= old_height);
+
+  if (width > old_width)
+    map->root = _cogl_rectangle_map_grow_root (map->root, width, old_height);
+  if (height > old_height)
+    map->root = _cogl_rectangle_map_grow_root (map->root, width, height);
+
+  map->space_remaining += width * height - old_width * old_height;
+
+#ifdef COGL_ENABLE_DEBUG
+  if (U_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DUMP_ATLAS_IMAGE)))
+    _cogl_rectangle_map_verify (map);
+#endif
+}
+
 unsigned int
 _cogl_rectangle_map_get_width (CoglRectangleMap *map)
 {
+  if (map->skyline)
+    return _cogl_rectangle_map_skyline_get_width (map->skyline);
+
   return map->root->rectangle.width;
 }
 
 unsigned int
 _cogl_rectangle_map_get_height (CoglRectangleMap *map)
 {
+  if (map->skyline)
+    return _cogl_rectangle_map_skyline_get_height (map->skyline);
+
   return map->root->rectangle.height;
 }
 
 unsigned int
 _cogl_rectangle_map_get_remaining_space (CoglRectangleMap *map)
 {
+  if (map->skyline)
+    return _cogl_rectangle_map_skyline_get_remaining_space (map->skyline);
+
   return map->space_remaining;
 }
 
 unsigned int
 _cogl_rectangle_map_get_n_rectangles (CoglRectangleMap *map)
 {
+  if (map->skyline)
+    return _cogl_rectangle_map_skyline_get_n_rectangles (map->skyline);
+
   return map->n_rectangles;
 }
 
@@ -675,6 +816,12 @@ _cogl_rectangle_map_foreach (CoglRectangleMap *map,
 {
   CoglRectangleMapForeachClosure closure;
 
+  if (map->skyline)
+    {
+      _cogl_rectangle_map_skyline_foreach (map->skyline, callback, data);
+      return;
+    }
+
   closure.callback = callback;
   closure.data = data;
 
@@ -697,6 +844,13 @@ _cogl_rectangle_map_free_cb (CoglRectangleMapNode *node, void *data)
 void
 _cogl_rectangle_map_free (CoglRectangleMap *map)
 {
+  if (map->skyline)
+    {
+      _cogl_rectangle_map_skyline_free (map->skyline);
+      u_free (map);
+      return;
+    }
+
   _cogl_rectangle_map_internal_foreach (map,
                                         _cogl_rectangle_map_free_cb,
                                         map);
@@ -762,3 +916,47 @@ _cogl_rectangle_map_dump_image (CoglRectangleMap *map)
 }
 
 #endif /* COGL_ENABLE_DEBUG && HAVE_CAIRO */
+
+static void
+check_rectangle_map_count_cb (const CoglRectangleMapEntry *entry,
+                              void *rectangle_data,
+                              void *user_data)
+{
+  int *count = user_data;
+
+  (*count)++;
+}
+
+UNIT_TEST (check_rectangle_map_grow,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  CoglRectangleMap *map = _cogl_rectangle_map_new (64, 64, NULL);
+  CoglRectangleMapEntry rectangles[3];
+  int count = 0;
+  int i;
+
+  u_assert (_cogl_rectangle_map_add (map, 64, 32, NULL, rectangles + 0));
+  u_assert (_cogl_rectangle_map_add (map, 32, 32, NULL, rectangles + 1));
+  u_assert (!_cogl_rectangle_map_add (map, 64, 64, NULL, rectangles + 2));
+
+  /* Growing both dimensions should leave room for a rectangle the
+     size of the old map without moving the existing ones */
+  _cogl_rectangle_map_grow (map, 128, 128);
+  u_assert_cmpint (_cogl_rectangle_map_get_width (map), ==, 128);
+  u_assert_cmpint (_cogl_rectangle_map_get_height (map), ==, 128);
+  u_assert_cmpint (_cogl_rectangle_map_get_remaining_space (map),
+                   ==,
+                   128 * 128 - 64 * 32 - 32 * 32);
+  u_assert (_cogl_rectangle_map_add (map, 64, 64, NULL, rectangles + 2));
+
+  _cogl_rectangle_map_foreach (map, check_rectangle_map_count_cb, &count);
+  u_assert_cmpint (count, ==, 3);
+
+  /* Removing everything should merge the tree back into one leaf */
+  for (i = 0; i < U_N_ELEMENTS (rectangles); i++)
+    _cogl_rectangle_map_remove (map, rectangles + i);
+  u_assert (_cogl_rectangle_map_add (map, 128, 128, NULL, rectangles + 0));
+
+  _cogl_rectangle_map_free (map);
+}
@@ -45,11 +45,31 @@ struct _CoglRectangleMapEntry
   unsigned int width, height;
 };
 
+typedef enum
+{
+  /* Splits the free space with a binary tree. This is good at fitting
+     rectangles of widely varying sizes */
+  COGL_RECTANGLE_MAP_TYPE_TREE,
+  /* Packs the rectangles along a skyline. This is faster and wastes
+     less space for lots of similarly sized rectangles such as
+     glyphs */
+  COGL_RECTANGLE_MAP_TYPE_SKYLINE
+} CoglRectangleMapType;
+
 CoglRectangleMap *
 _cogl_rectangle_map_new (unsigned int width,
                          unsigned int height,
                          UDestroyNotify value_destroy_func);
 
+CoglRectangleMap *
+_cogl_rectangle_map_new_with_type (CoglRectangleMapType type,
+                                   unsigned int width,
+                                   unsigned int height,
+                                   UDestroyNotify value_destroy_func);
+
+CoglRectangleMapType
+_cogl_rectangle_map_get_type (CoglRectangleMap *map);
+
 CoglBool
 _cogl_rectangle_map_add (CoglRectangleMap *map,
                          unsigned int width,
@@ -61,6 +81,13 @@ void
 _cogl_rectangle_map_remove (CoglRectangleMap *map,
                             const CoglRectangleMapEntry *rectangle);
 
+/* Makes the map bigger without moving any of the existing
+   rectangles. The new space is added to the right and bottom */
+void
+_cogl_rectangle_map_grow (CoglRectangleMap *map,
+                          unsigned int width,
+                          unsigned int height);
+
 unsigned int
 _cogl_rectangle_map_get_width (CoglRectangleMap *map);
 
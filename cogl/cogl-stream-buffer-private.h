@@ -0,0 +1,143 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_STREAM_BUFFER_PRIVATE_H__
+#define __COGL_STREAM_BUFFER_PRIVATE_H__
+
+#include "cogl-context.h"
+#include "cogl-attribute-buffer.h"
+#include "cogl-fence-private.h"
+
+/* The stream buffer is a ring of vertex data shared by everything in
+ * the context that uploads geometry to draw it once, such as the
+ * journal. Instead of allocating a buffer for every upload, regions
+ * are handed out from one large attribute buffer in order. The ring
+ * is split into segments. When the write position leaves a segment a
+ * fence is inserted after the draws that used it, and the segment
+ * isn't written again until the GPU has passed that fence. */
+
+#define COGL_STREAM_BUFFER_N_SEGMENTS 4
+
+typedef enum
+{
+  /* The buffer is emulated with malloc so the data is read as soon as
+   * the draw call is made and no synchronization is needed */
+  COGL_STREAM_BUFFER_MODE_CLIENT,
+  /* The buffer stays mapped for its whole lifetime */
+  COGL_STREAM_BUFFER_MODE_PERSISTENT,
+  /* Each region is mapped without waiting for the GPU */
+  COGL_STREAM_BUFFER_MODE_UNSYNCHRONIZED,
+  /* There are no fences so the whole buffer is orphaned whenever no
+   * regions are waiting to be drawn */
+  COGL_STREAM_BUFFER_MODE_ORPHAN
+} CoglStreamBufferMode;
+
+typedef struct
+{
+  CoglFenceSync fence;
+  CoglBool has_fence;
+  /* Set when the write position has left the segment but the draws
+   * using it haven't been fenced yet */
+  CoglBool needs_fence;
+} CoglStreamBufferSegment;
+
+typedef struct
+{
+  /* The number of times the write position has gone back to the
+   * start of the buffer */
+  unsigned int n_wraparounds;
+  /* The number of times a region had to wait for the GPU */
+  unsigned int n_stalls;
+  /* The number of times the buffer has been replaced, either to grow
+   * it or because a region was still waiting to be drawn */
+  unsigned int n_reallocations;
+  /* The number of times the whole buffer was orphaned because no
+   * regions were pending */
+  unsigned int n_orphans;
+  unsigned int n_allocations;
+} CoglStreamBufferStats;
+
+typedef struct _CoglStreamBuffer
+{
+  CoglContext *context;
+
+  CoglStreamBufferMode mode;
+
+  CoglAttributeBuffer *buffer;
+  size_t size;
+
+  /* The write position */
+  size_t offset;
+  int segment;
+
+  /* The start of the buffer in persistent mode */
+  uint8_t *persistent_data;
+
+  /* The number of regions that have been handed out but not yet
+   * released */
+  int n_pending;
+
+  /* The buffer that the current mapping was made from, or NULL */
+  CoglBuffer *mapped_buffer;
+
+  CoglStreamBufferSegment segments[COGL_STREAM_BUFFER_N_SEGMENTS];
+
+  CoglStreamBufferStats stats;
+} CoglStreamBuffer;
+
+CoglStreamBuffer *
+_cogl_stream_buffer_new (CoglContext *context);
+
+void
+_cogl_stream_buffer_free (CoglStreamBuffer *stream);
+
+/* Reserves @size bytes at the write position and maps them for
+ * writing. The buffer containing the region and its offset within
+ * the buffer are returned in @buffer_out and @offset_out. The buffer
+ * isn't referenced so the caller needs to take a reference if it
+ * keeps it, for example by creating an attribute for it.
+ *
+ * The region must be unmapped with _cogl_stream_buffer_unmap before
+ * drawing from it. Once all of the draws using it have been issued
+ * it must be released with _cogl_stream_buffer_release. Only one
+ * region can be mapped at a time but there can be several that
+ * haven't been released yet. */
+void *
+_cogl_stream_buffer_map (CoglStreamBuffer *stream,
+                         size_t size,
+                         CoglAttributeBuffer **buffer_out,
+                         size_t *offset_out);
+
+void
+_cogl_stream_buffer_unmap (CoglStreamBuffer *stream);
+
+void
+_cogl_stream_buffer_release (CoglStreamBuffer *stream);
+
+#endif /* __COGL_STREAM_BUFFER_PRIVATE_H__ */
@@ -0,0 +1,555 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-util.h"
+#include "cogl-context-private.h"
+#include "cogl-private.h"
+#include "cogl-buffer-private.h"
+#include "cogl-attribute-buffer.h"
+#include "cogl-stream-buffer-private.h"
+#include "cogl-fence-private.h"
+#include "cogl-error-private.h"
+#include "cogl-profile.h"
+
+#include <test-fixtures/test-unit.h>
+
+#define COGL_STREAM_BUFFER_DEFAULT_SIZE (1024 * 1024)
+
+/* Regions are aligned so that any attribute type can be read from
+ * the start of them */
+#define COGL_STREAM_BUFFER_ALIGNMENT 16
+
+COGL_STATIC_COUNTER (stream_buffer_wraparound_counter,
+                     "stream buffer wraparound counter",
+                     "Increments each time the stream buffer goes back "
+                     "to the start",
+                     0 /* no application private data */);
+
+COGL_STATIC_COUNTER (stream_buffer_stall_counter,
+                     "stream buffer stall counter",
+                     "Increments each time the stream buffer has to "
+                     "wait for the GPU before reusing a region",
+                     0 /* no application private data */);
+
+COGL_STATIC_COUNTER (stream_buffer_reallocation_counter,
+                     "stream buffer reallocation counter",
+                     "Increments each time the stream buffer is "
+                     "replaced with a new buffer",
+                     0 /* no application private data */);
+
+static void
+discard_segments (CoglStreamBuffer *stream)
+{
+  int i;
+
+  for (i = 0; i < COGL_STREAM_BUFFER_N_SEGMENTS; i++)
+    {
+      CoglStreamBufferSegment *segment = &stream->segments[i];
+
+      if (segment->has_fence)
+        _cogl_fence_sync_destroy (stream->context, &segment->fence);
+
+      segment->has_fence = FALSE;
+      segment->needs_fence = FALSE;
+    }
+}
+
+static void
+free_buffer (CoglStreamBuffer *stream)
+{
+  if (stream->buffer == NULL)
+    return;
+
+  if (stream->persistent_data)
+    {
+      cogl_buffer_unmap (COGL_BUFFER (stream->buffer));
+      stream->persistent_data = NULL;
+    }
+
+  /* Any draws that haven't been issued yet will have taken their own
+   * reference on the buffer so it's safe to drop ours */
+  cogl_object_unref (stream->buffer);
+  stream->buffer = NULL;
+
+  discard_segments (stream);
+}
+
+static void
+allocate_buffer (CoglStreamBuffer *stream,
+                 size_t size)
+{
+  CoglContext *ctx = stream->context;
+
+  free_buffer (stream);
+
+  stream->size = size;
+  stream->offset = 0;
+  stream->segment = 0;
+
+  stream->buffer = cogl_attribute_buffer_new_with_size (ctx, size);
+  /* The stream data is never read back */
+  _cogl_buffer_discard_shadow (COGL_BUFFER (stream->buffer));
+  cogl_buffer_set_update_hint (COGL_BUFFER (stream->buffer),
+                               COGL_BUFFER_UPDATE_HINT_STREAM);
+
+  if (stream->mode == COGL_STREAM_BUFFER_MODE_PERSISTENT)
+    {
+      CoglError *ignore_error = NULL;
+
+      stream->persistent_data =
+        cogl_buffer_map (COGL_BUFFER (stream->buffer),
+                         COGL_BUFFER_ACCESS_WRITE,
+                         COGL_BUFFER_MAP_HINT_PERSISTENT,
+                         &ignore_error);
+
+      /* If the persistent mapping fails then we can still map each
+       * region separately */
+      if (stream->persistent_data == NULL)
+        {
+          cogl_error_free (ignore_error);
+          stream->mode = COGL_STREAM_BUFFER_MODE_UNSYNCHRONIZED;
+        }
+    }
+}
+
+static void
+reallocate_buffer (CoglStreamBuffer *stream,
+                   size_t size)
+{
+  stream->stats.n_reallocations++;
+  COGL_COUNTER_INC (stream->context, stream_buffer_reallocation_counter);
+
+  allocate_buffer (stream, size);
+}
+
+CoglStreamBuffer *
+_cogl_stream_buffer_new (CoglContext *context)
+{
+  CoglStreamBuffer *stream = u_slice_new0 (CoglStreamBuffer);
+
+  stream->context = context;
+
+  if (!_cogl_has_private_feature (context, COGL_PRIVATE_FEATURE_VBOS))
+    stream->mode = COGL_STREAM_BUFFER_MODE_CLIENT;
+  else if (!cogl_has_feature (context, COGL_FEATURE_ID_FENCE))
+    stream->mode = COGL_STREAM_BUFFER_MODE_ORPHAN;
+  else if (_cogl_has_private_feature
+           (context, COGL_PRIVATE_FEATURE_MAP_BUFFER_PERSISTENT))
+    stream->mode = COGL_STREAM_BUFFER_MODE_PERSISTENT;
+  else if (_cogl_has_private_feature
+           (context, COGL_PRIVATE_FEATURE_MAP_BUFFER_UNSYNCHRONIZED))
+    stream->mode = COGL_STREAM_BUFFER_MODE_UNSYNCHRONIZED;
+  else
+    stream->mode = COGL_STREAM_BUFFER_MODE_ORPHAN;
+
+  /* The buffer is created lazily so that a context that never draws
+   * anything transient doesn't need it */
+
+  return stream;
+}
+
+void
+_cogl_stream_buffer_free (CoglStreamBuffer *stream)
+{
+  free_buffer (stream);
+
+  u_slice_free (CoglStreamBuffer, stream);
+}
+
+static CoglBool
+is_synchronized (CoglStreamBuffer *stream)
+{
+  return (stream->mode == COGL_STREAM_BUFFER_MODE_PERSISTENT ||
+          stream->mode == COGL_STREAM_BUFFER_MODE_UNSYNCHRONIZED);
+}
+
+static CoglBool
+enter_segment (CoglStreamBuffer *stream,
+               int segment_num)
+{
+  CoglContext *ctx = stream->context;
+  CoglStreamBufferSegment *segment = &stream->segments[segment_num];
+
+  if (!is_synchronized (stream))
+    return TRUE;
+
+  /* The draws that used the segment last time round haven't been
+   * fenced yet so there is no way to know when the GPU will be
+   * finished with it */
+  if (segment->needs_fence)
+    return FALSE;
+
+  if (segment->has_fence)
+    {
+      if (!_cogl_fence_sync_is_complete (ctx, &segment->fence, FALSE))
+        {
+          stream->stats.n_stalls++;
+          COGL_COUNTER_INC (ctx, stream_buffer_stall_counter);
+
+          _cogl_fence_sync_is_complete (ctx, &segment->fence, TRUE);
+        }
+
+      _cogl_fence_sync_destroy (ctx, &segment->fence);
+      segment->has_fence = FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+leave_segment (CoglStreamBuffer *stream,
+               int segment_num)
+{
+  if (is_synchronized (stream))
+    stream->segments[segment_num].needs_fence = TRUE;
+}
+
+static CoglBool
+wrap_around (CoglStreamBuffer *stream)
+{
+  stream->stats.n_wraparounds++;
+  COGL_COUNTER_INC (stream->context, stream_buffer_wraparound_counter);
+
+  /* Without fences the only way to avoid overwriting data that the
+   * GPU is still using is to orphan the buffer. That's only possible
+   * if there are no regions that are still waiting to be drawn. */
+  if (stream->mode == COGL_STREAM_BUFFER_MODE_ORPHAN &&
+      stream->n_pending > 0)
+    return FALSE;
+
+  leave_segment (stream, stream->segment);
+
+  if (!enter_segment (stream, 0))
+    return FALSE;
+
+  stream->offset = 0;
+  stream->segment = 0;
+
+  return TRUE;
+}
+
+/* Moves the write position past a region of @size bytes and returns
+ * the offset of the region */
+static size_t
+reserve (CoglStreamBuffer *stream,
+         size_t size,
+         CoglBool *wrapped)
+{
+  size_t segment_size;
+  size_t start;
+  int last_segment;
+
+  *wrapped = FALSE;
+
+  /* The region has to fit in the ring while leaving some room for
+   * the segments that the GPU might still be using */
+  if (stream->buffer == NULL)
+    allocate_buffer (stream,
+                     MAX (COGL_STREAM_BUFFER_DEFAULT_SIZE,
+                          _cogl_util_next_p2 (size * 2)));
+  else if (size > stream->size / 2)
+    reallocate_buffer (stream, _cogl_util_next_p2 (size * 2));
+
+  /* Without fences there is no way to know when the GPU has finished
+   * with a region, so mapping a range that has been written before
+   * would make the driver wait. Instead, whenever every region handed
+   * out so far has been drawn, the whole buffer is orphaned and the
+   * write position starts again on the new storage. Only nested
+   * regions are appended after a pending one. */
+  if (stream->mode == COGL_STREAM_BUFFER_MODE_ORPHAN &&
+      stream->n_pending == 0 &&
+      stream->offset > 0)
+    {
+      stream->stats.n_orphans++;
+
+      /* If the buffer can't be mapped then the data will be uploaded
+       * with glBufferSubData which can't orphan, so use a new buffer
+       * object instead */
+      if (!cogl_has_feature (stream->context,
+                             COGL_FEATURE_ID_MAP_BUFFER_FOR_WRITE))
+        allocate_buffer (stream, stream->size);
+
+      stream->offset = 0;
+      stream->segment = 0;
+      *wrapped = TRUE;
+    }
+
+  if (stream->offset + size > stream->size)
+    {
+      if (!wrap_around (stream))
+        reallocate_buffer (stream, stream->size);
+      *wrapped = TRUE;
+    }
+
+  segment_size = stream->size / COGL_STREAM_BUFFER_N_SEGMENTS;
+  last_segment = (stream->offset + size - 1) / segment_size;
+
+  while (stream->segment < last_segment)
+    {
+      leave_segment (stream, stream->segment);
+
+      if (!enter_segment (stream, stream->segment + 1))
+        {
+          /* Start again on a fresh buffer where every segment is
+           * free */
+          reallocate_buffer (stream, stream->size);
+          *wrapped = TRUE;
+          last_segment = (size - 1) / segment_size;
+          continue;
+        }
+
+      stream->segment++;
+    }
+
+  start = stream->offset;
+  stream->offset = ((start + size + COGL_STREAM_BUFFER_ALIGNMENT - 1) &
+                    ~(size_t) (COGL_STREAM_BUFFER_ALIGNMENT - 1));
+
+  return start;
+}
+
+void *
+_cogl_stream_buffer_map (CoglStreamBuffer *stream,
+                         size_t size,
+                         CoglAttributeBuffer **buffer_out,
+                         size_t *offset_out)
+{
+  CoglBuffer *buffer;
+  CoglBufferMapHint hints;
+  CoglBool wrapped;
+  size_t offset;
+
+  _COGL_RETURN_VAL_IF_FAIL (stream->mapped_buffer == NULL, NULL);
+  _COGL_RETURN_VAL_IF_FAIL (size > 0, NULL);
+
+  offset = reserve (stream, size, &wrapped);
+
+  stream->n_pending++;
+  stream->stats.n_allocations++;
+
+  *buffer_out = stream->buffer;
+  *offset_out = offset;
+
+  buffer = COGL_BUFFER (stream->buffer);
+
+  switch (stream->mode)
+    {
+    case COGL_STREAM_BUFFER_MODE_CLIENT:
+      /* The buffer is just malloc'd memory */
+      return buffer->data + offset;
+
+    case COGL_STREAM_BUFFER_MODE_PERSISTENT:
+      return stream->persistent_data + offset;
+
+    case COGL_STREAM_BUFFER_MODE_UNSYNCHRONIZED:
+      hints = (COGL_BUFFER_MAP_HINT_DISCARD_RANGE |
+               COGL_BUFFER_MAP_HINT_UNSYNCHRONIZED);
+      break;
+
+    case COGL_STREAM_BUFFER_MODE_ORPHAN:
+    default:
+      /* Discarding the whole buffer lets the driver give us new
+       * storage instead of waiting for the GPU. A nested region is
+       * after everything written since the last orphan so nothing
+       * the GPU is using can overlap it */
+      if (wrapped)
+        hints = COGL_BUFFER_MAP_HINT_DISCARD;
+      else if (_cogl_has_private_feature
+               (stream->context,
+                COGL_PRIVATE_FEATURE_MAP_BUFFER_UNSYNCHRONIZED))
+        hints = (COGL_BUFFER_MAP_HINT_DISCARD_RANGE |
+                 COGL_BUFFER_MAP_HINT_UNSYNCHRONIZED);
+      else
+        hints = COGL_BUFFER_MAP_HINT_DISCARD_RANGE;
+      break;
+    }
+
+  stream->mapped_buffer = buffer;
+
+  return _cogl_buffer_map_range_for_fill_or_fallback (buffer,
+                                                      offset,
+                                                      size,
+                                                      hints);
+}
+
+void
+_cogl_stream_buffer_unmap (CoglStreamBuffer *stream)
+{
+  if (stream->mapped_buffer == NULL)
+    return;
+
+  _cogl_buffer_unmap_for_fill_or_fallback (stream->mapped_buffer);
+  stream->mapped_buffer = NULL;
+}
+
+void
+_cogl_stream_buffer_release (CoglStreamBuffer *stream)
+{
+  CoglContext *ctx = stream->context;
+  int i;
+
+  _COGL_RETURN_IF_FAIL (stream->n_pending > 0);
+
+  /* Regions can be nested, for example when the clip stack draws
+   * rectangles while the journal is being flushed. The fences are
+   * only inserted once everything has been drawn so that they cover
+   * all of the draws from the segments */
+  if (--stream->n_pending > 0)
+    return;
+
+  if (!is_synchronized (stream))
+    return;
+
+  for (i = 0; i < COGL_STREAM_BUFFER_N_SEGMENTS; i++)
+    {
+      CoglStreamBufferSegment *segment = &stream->segments[i];
+
+      if (!segment->needs_fence)
+        continue;
+
+      segment->needs_fence = FALSE;
+
+      _cogl_fence_sync_insert (ctx, &segment->fence);
+
+      /* If the fence couldn't be created then the only safe thing to
+       * do is wait for the GPU now */
+      if (segment->fence.type == FENCE_TYPE_ERROR)
+        {
+          stream->stats.n_stalls++;
+          COGL_COUNTER_INC (ctx, stream_buffer_stall_counter);
+          ctx->glFinish ();
+        }
+      else
+        segment->has_fence = TRUE;
+    }
+}
+
+UNIT_TEST (check_stream_buffer_wraparound,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  CoglStreamBuffer *stream = _cogl_stream_buffer_new (test_ctx);
+  CoglAttributeBuffer *buffer, *first_buffer;
+  size_t offset, region_size;
+  int i;
+
+  /* Force the mode that doesn't need a GPU so that only the
+   * bookkeeping is tested */
+  stream->mode = COGL_STREAM_BUFFER_MODE_CLIENT;
+
+  region_size = COGL_STREAM_BUFFER_DEFAULT_SIZE / 4;
+
+  _cogl_stream_buffer_map (stream, region_size, &first_buffer, &offset);
+  _cogl_stream_buffer_unmap (stream);
+  _cogl_stream_buffer_release (stream);
+  u_assert_cmpint (offset, ==, 0);
+  u_assert_cmpint (stream->size, ==, COGL_STREAM_BUFFER_DEFAULT_SIZE);
+
+  for (i = 1; i <= 4; i++)
+    {
+      _cogl_stream_buffer_map (stream, region_size, &buffer, &offset);
+      _cogl_stream_buffer_unmap (stream);
+      _cogl_stream_buffer_release (stream);
+
+      /* The regions are aligned */
+      u_assert_cmpint (offset % COGL_STREAM_BUFFER_ALIGNMENT, ==, 0);
+      u_assert (offset + region_size <= stream->size);
+      u_assert (buffer == first_buffer);
+    }
+
+  /* The fifth region doesn't fit so the write position goes back to
+   * the start instead of allocating a new buffer */
+  u_assert_cmpint (offset, ==, 0);
+  u_assert_cmpint (stream->stats.n_wraparounds, ==, 1);
+  u_assert_cmpint (stream->stats.n_reallocations, ==, 0);
+
+  /* A region that is too big for the ring makes it grow */
+  _cogl_stream_buffer_map (stream,
+                           COGL_STREAM_BUFFER_DEFAULT_SIZE,
+                           &buffer,
+                           &offset);
+  _cogl_stream_buffer_unmap (stream);
+  _cogl_stream_buffer_release (stream);
+  u_assert_cmpint (offset, ==, 0);
+  u_assert_cmpint (stream->stats.n_reallocations, ==, 1);
+  u_assert (stream->size >= COGL_STREAM_BUFFER_DEFAULT_SIZE * 2);
+
+  u_assert_cmpint (stream->stats.n_allocations, ==, 6);
+  u_assert_cmpint (stream->n_pending, ==, 0);
+
+  _cogl_stream_buffer_free (stream);
+}
+
+UNIT_TEST (check_stream_buffer_orphan,
+           TEST_REQUIREMENT_MAP_WRITE,
+           0 /* no failure cases */)
+{
+  CoglStreamBuffer *stream = _cogl_stream_buffer_new (test_ctx);
+  CoglAttributeBuffer *buffer;
+  size_t offset;
+
+  stream->mode = COGL_STREAM_BUFFER_MODE_ORPHAN;
+
+  _cogl_stream_buffer_map (stream, 64, &buffer, &offset);
+  _cogl_stream_buffer_unmap (stream);
+  _cogl_stream_buffer_release (stream);
+  u_assert_cmpint (offset, ==, 0);
+  u_assert_cmpint (stream->stats.n_orphans, ==, 0);
+
+  /* Nothing is pending so the next region starts again on orphaned
+   * storage instead of being appended */
+  _cogl_stream_buffer_map (stream, 64, &buffer, &offset);
+  _cogl_stream_buffer_unmap (stream);
+  u_assert_cmpint (offset, ==, 0);
+  u_assert_cmpint (stream->stats.n_orphans, ==, 1);
+
+  /* A nested region can't orphan the buffer because the first region
+   * hasn't been drawn yet */
+  _cogl_stream_buffer_map (stream, 64, &buffer, &offset);
+  _cogl_stream_buffer_unmap (stream);
+  u_assert_cmpint (offset, >=, 64);
+  u_assert_cmpint (stream->stats.n_orphans, ==, 1);
+
+  _cogl_stream_buffer_release (stream);
+  _cogl_stream_buffer_release (stream);
+
+  _cogl_stream_buffer_map (stream, 64, &buffer, &offset);
+  _cogl_stream_buffer_unmap (stream);
+  _cogl_stream_buffer_release (stream);
+  u_assert_cmpint (offset, ==, 0);
+  u_assert_cmpint (stream->stats.n_orphans, ==, 2);
+  u_assert_cmpint (stream->stats.n_wraparounds, ==, 0);
+  u_assert_cmpint (stream->n_pending, ==, 0);
+
+  _cogl_stream_buffer_free (stream);
+}
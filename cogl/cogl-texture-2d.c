@@ -47,6 +47,8 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-error-private.h"
+#include "cogl-compressed-format-private.h"
+#include "cogl-ktx-private.h"
 #ifdef COGL_HAS_EGL_SUPPORT
 #include "cogl-winsys-egl-private.h"
 #endif
@@ -58,6 +60,8 @@
 #include "cogl-wayland-server.h"
 #endif
 
+#include <test-fixtures/test-unit.h>
+
 static void _cogl_texture_2d_free (CoglTexture2D *tex_2d);
 
 COGL_TEXTURE_DEFINE (Texture2D, texture_2d);
@@ -104,6 +108,8 @@ _cogl_texture_2d_create_base (CoglContext *ctx,
   _cogl_texture_init (tex, ctx, width, height, internal_format, loader,
                       &cogl_texture_2d_vtable);
 
+  tex_2d->internal_format = internal_format;
+
   tex_2d->mipmaps_dirty = TRUE;
   tex_2d->auto_mipmap = TRUE;
 
@@ -130,11 +136,144 @@ cogl_texture_2d_new_with_size (CoglContext *ctx,
                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE, loader);
 }
 
+static CoglBool _cogl_texture_2d_set_region (CoglTexture *tex,
+                                             int src_x,
+                                             int src_y,
+                                             int dst_x,
+                                             int dst_y,
+                                             int width,
+                                             int height,
+                                             int level,
+                                             CoglBitmap *bmp,
+                                             CoglError **error);
+
+/* This is used instead of the driver's allocate function when the
+ * driver can't take the compressed data directly. Each level is
+ * decoded on the CPU and the texture is allocated from the first one
+ * as if it was created from a bitmap */
+static CoglBool
+allocate_from_decoded_data (CoglTexture2D *tex_2d,
+                            CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglContext *ctx = tex->context;
+  CoglTextureLoader *loader = tex->loader;
+  CoglPixelFormat format = loader->src.compressed.format;
+  int width = loader->src.compressed.width;
+  int height = loader->src.compressed.height;
+  int n_levels = loader->src.compressed.n_levels;
+  uint8_t *data = loader->src.compressed.data;
+  const uint8_t *level_data = data;
+  CoglBool owns_data = FALSE;
+  CoglBool ret = TRUE;
+  int level;
+
+  for (level = 0; level < n_levels && ret; level++)
+    {
+      int level_width = MAX (width >> level, 1);
+      int level_height = MAX (height >> level, 1);
+      CoglBitmap *bmp;
+      uint8_t *pixels;
+
+      bmp = _cogl_bitmap_new_with_malloc_buffer (ctx,
+                                                 level_width,
+                                                 level_height,
+                                                 COGL_PIXEL_FORMAT_RGBA_8888,
+                                                 error);
+      if (bmp == NULL)
+        {
+          ret = FALSE;
+          break;
+        }
+
+      pixels = _cogl_bitmap_map (bmp,
+                                 COGL_BUFFER_ACCESS_WRITE,
+                                 COGL_BUFFER_MAP_HINT_DISCARD,
+                                 error);
+      if (pixels == NULL)
+        {
+          cogl_object_unref (bmp);
+          ret = FALSE;
+          break;
+        }
+
+      ret = _cogl_compressed_format_decode (format,
+                                            level_width,
+                                            level_height,
+                                            level_data,
+                                            cogl_bitmap_get_rowstride (bmp),
+                                            pixels,
+                                            error);
+      _cogl_bitmap_unmap (bmp);
+
+      if (!ret)
+        {
+          cogl_object_unref (bmp);
+          break;
+        }
+
+      level_data += _cogl_compressed_format_get_image_size (format,
+                                                            level_width,
+                                                            level_height);
+
+      if (level == 0)
+        {
+          /* Switch the loader over to the decoded bitmap. The
+           * compressed data is now owned by this function */
+          owns_data = TRUE;
+          loader->src_type = COGL_TEXTURE_SOURCE_TYPE_BITMAP;
+          loader->src.bitmap.bitmap = bmp;
+          loader->src.bitmap.can_convert_in_place = TRUE;
+
+          /* The compressed data is never premultiplied so the
+           * decoded texture shouldn't be either */
+          tex->premultiplied = FALSE;
+          tex_2d->internal_format = COGL_PIXEL_FORMAT_RGBA_8888;
+
+          ret = ctx->driver_vtable->texture_2d_allocate (tex, error);
+        }
+      else
+        {
+          ret = _cogl_texture_2d_set_region (tex,
+                                             0, 0, /* src_x/y */
+                                             0, 0, /* dst_x/y */
+                                             level_width,
+                                             level_height,
+                                             level,
+                                             bmp,
+                                             error);
+          cogl_object_unref (bmp);
+        }
+    }
+
+  /* The levels from the data are the whole mipmap chain, the same as
+   * when the compressed data is given to GL directly. Generating
+   * mipmaps would overwrite all but the first level so it is disabled
+   * and sampling is limited to the levels that were set above */
+  if (ret)
+    {
+      tex_2d->auto_mipmap = FALSE;
+      tex_2d->mipmaps_dirty = FALSE;
+    }
+
+  if (owns_data)
+    u_free (data);
+
+  return ret;
+}
+
 static CoglBool
 _cogl_texture_2d_allocate (CoglTexture *tex,
                            CoglError **error)
 {
   CoglContext *ctx = tex->context;
+  CoglTextureLoader *loader = tex->loader;
+
+  if (loader &&
+      loader->src_type == COGL_TEXTURE_SOURCE_TYPE_COMPRESSED &&
+      !_cogl_compressed_format_is_supported (ctx,
+                                             loader->src.compressed.format))
+    return allocate_from_decoded_data (COGL_TEXTURE_2D (tex), error);
 
   return ctx->driver_vtable->texture_2d_allocate (tex, error);
 }
@@ -166,6 +305,28 @@ cogl_texture_2d_new_from_bitmap (CoglBitmap *bmp)
                                            FALSE); /* can't convert in place */
 }
 
+/* Takes ownership of @data */
+static CoglTexture2D *
+_cogl_texture_2d_new_from_compressed (CoglContext *ctx,
+                                      int width,
+                                      int height,
+                                      CoglPixelFormat format,
+                                      int n_levels,
+                                      uint8_t *data)
+{
+  CoglTextureLoader *loader;
+
+  loader = _cogl_texture_create_loader ();
+  loader->src_type = COGL_TEXTURE_SOURCE_TYPE_COMPRESSED;
+  loader->src.compressed.width = width;
+  loader->src.compressed.height = height;
+  loader->src.compressed.format = format;
+  loader->src.compressed.n_levels = n_levels;
+  loader->src.compressed.data = data;
+
+  return _cogl_texture_2d_create_base (ctx, width, height, format, loader);
+}
+
 CoglTexture2D *
 cogl_texture_2d_new_from_file (CoglContext *ctx,
                                const char *filename,
@@ -176,6 +337,21 @@ cogl_texture_2d_new_from_file (CoglContext *ctx,
 
   _COGL_RETURN_VAL_IF_FAIL (error == NULL || *error == NULL, NULL);
 
+  if (_cogl_ktx_is_ktx_file (filename))
+    {
+      CoglKtxImage image;
+
+      if (!_cogl_ktx_load_from_file (filename, &image, error))
+        return NULL;
+
+      return _cogl_texture_2d_new_from_compressed (ctx,
+                                                   image.width,
+                                                   image.height,
+                                                   image.format,
+                                                   image.n_levels,
+                                                   image.data);
+    }
+
   bmp = cogl_bitmap_new_from_file (ctx, filename, error);
   if (bmp == NULL)
     return NULL;
@@ -228,6 +404,44 @@ cogl_texture_2d_new_from_data (CoglContext *ctx,
   return tex_2d;
 }
 
+CoglTexture2D *
+cogl_texture_2d_new_from_compressed_data (CoglContext *ctx,
+                                          int width,
+                                          int height,
+                                          CoglPixelFormat format,
+                                          int n_levels,
+                                          size_t data_size,
+                                          const uint8_t *data,
+                                          CoglError **error)
+{
+  CoglTexture2D *tex_2d;
+  size_t needed_size;
+
+  _COGL_RETURN_VAL_IF_FAIL (_cogl_pixel_format_is_compressed (format), NULL);
+  _COGL_RETURN_VAL_IF_FAIL (width > 0 && height > 0, NULL);
+  _COGL_RETURN_VAL_IF_FAIL (n_levels >= 1, NULL);
+  _COGL_RETURN_VAL_IF_FAIL (data != NULL, NULL);
+
+  needed_size = _cogl_compressed_format_get_data_size (format,
+                                                       width, height,
+                                                       n_levels);
+  _COGL_RETURN_VAL_IF_FAIL (data_size >= needed_size, NULL);
+
+  tex_2d = _cogl_texture_2d_new_from_compressed (ctx,
+                                                 width, height,
+                                                 format,
+                                                 n_levels,
+                                                 u_memdup (data, needed_size));
+
+  if (!cogl_texture_allocate (COGL_TEXTURE (tex_2d), error))
+    {
+      cogl_object_unref (tex_2d);
+      return NULL;
+    }
+
+  return tex_2d;
+}
+
 #if defined (COGL_HAS_EGL_SUPPORT) && defined (EGL_KHR_image_base)
 /* NB: The reason we require the width, height and format to be passed
  * even though they may seem redundant is because GLES 1/2 don't
@@ -599,6 +813,15 @@ _cogl_texture_2d_set_region (CoglTexture *tex,
   CoglContext *ctx = tex->context;
   CoglTexture2D *tex_2d = COGL_TEXTURE_2D (tex);
 
+  if (_cogl_pixel_format_is_compressed (tex_2d->internal_format))
+    {
+      _cogl_set_error (error,
+                       COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_FORMAT,
+                       "Compressed textures can't be updated");
+      return FALSE;
+    }
+
   if (!ctx->driver_vtable->texture_2d_copy_from_bitmap (tex_2d,
                                                         src_x,
                                                         src_y,
@@ -683,3 +906,87 @@ cogl_texture_2d_vtable =
     _cogl_texture_2d_is_foreign,
     _cogl_texture_2d_set_auto_mipmap
   };
+
+static void
+check_decoded_texture (CoglPixelFormat format,
+                       const uint8_t *data,
+                       size_t data_size,
+                       uint32_t level0_color,
+                       uint32_t level1_color,
+                       int y)
+{
+  CoglTexture2D *tex_2d;
+  CoglPipeline *pipeline;
+  CoglError *error = NULL;
+
+  tex_2d = cogl_texture_2d_new_from_compressed_data (test_ctx,
+                                                     4, 4,
+                                                     format,
+                                                     2, /* n_levels */
+                                                     data_size,
+                                                     data,
+                                                     &error);
+  u_assert (error == NULL);
+  u_assert (tex_2d != NULL);
+
+  /* The data should have been decoded instead of given to GL */
+  u_assert (!_cogl_pixel_format_is_compressed (tex_2d->internal_format));
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, COGL_TEXTURE (tex_2d));
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST_MIPMAP_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline, 0, y, 4, y + 4);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline, 4, y, 6, y + 2);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (tex_2d);
+
+  test_utils_check_pixel (test_fb, 1, y + 1, level0_color);
+  test_utils_check_pixel (test_fb, 5, y + 1, level1_color);
+}
+
+UNIT_TEST (check_compressed_texture_decode_fallback,
+           TEST_REQUIREMENT_GL,
+           0 /* no failure cases */)
+{
+  /* Solid red and green ETC1 blocks which decode with the small
+   * positive modifier added to each component */
+  static const uint8_t etc1[] =
+    { 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  /* Solid blue and yellow DXT1 blocks */
+  static const uint8_t dxt1[] =
+    { 0x1f, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00,
+      0xe0, 0xff, 0xe0, 0xff, 0x00, 0x00, 0x00, 0x00 };
+  unsigned long features[U_N_ELEMENTS (test_ctx->features)];
+
+  /* Pretend the driver can't sample any of the formats so that they
+   * have to be decoded on the CPU */
+  memcpy (features, test_ctx->features, sizeof (features));
+  COGL_FLAGS_SET (test_ctx->features, COGL_FEATURE_ID_TEXTURE_ETC1, FALSE);
+  COGL_FLAGS_SET (test_ctx->features, COGL_FEATURE_ID_TEXTURE_ETC2, FALSE);
+  COGL_FLAGS_SET (test_ctx->features, COGL_FEATURE_ID_TEXTURE_S3TC, FALSE);
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  /* Only two levels are given so the rest of the mipmap chain must
+   * not be generated over the second one */
+  check_decoded_texture (COGL_PIXEL_FORMAT_ETC1_RGB_8,
+                         etc1, sizeof (etc1),
+                         0xff0202ff, 0x02ff02ff,
+                         0);
+  check_decoded_texture (COGL_PIXEL_FORMAT_S3TC_DXT1_RGB,
+                         dxt1, sizeof (dxt1),
+                         0x0000ffff, 0xffff00ff,
+                         10);
+
+  memcpy (test_ctx->features, features, sizeof (features));
+}
@@ -116,6 +116,12 @@ cogl_texture_2d_new_with_size (CoglContext *ctx,
  *
  * Creates a low-level #CoglTexture2D texture from an image file.
  *
+ * KTX and KTX2 files containing one of the compressed
+ * #CoglPixelFormat<!-- -->s are also accepted. Their mipmap levels are
+ * uploaded as they are in the file instead of being generated by
+ * Cogl. See cogl_texture_2d_new_from_compressed_data() for what
+ * happens when the driver doesn't support the format.
+ *
  * The storage for the texture is not allocated before this function
  * returns. You can call cogl_texture_allocate() to explicitly
  * allocate the underlying storage or preferably let Cogl
@@ -189,6 +195,58 @@ cogl_texture_2d_new_from_data (CoglContext *ctx,
                                const uint8_t *data,
                                CoglError **error);
 
+/**
+ * cogl_texture_2d_new_from_compressed_data:
+ * @ctx: A #CoglContext
+ * @width: width of the texture in pixels
+ * @height: height of the texture in pixels
+ * @format: one of the compressed #CoglPixelFormat<!-- -->s
+ * @n_levels: the number of mipmap levels in @data
+ * @data_size: the size of @data in bytes
+ * @data: the compressed blocks of each mipmap level, one level after
+ *    the other starting with the full size image
+ * @error: A #CoglError for exceptions
+ *
+ * Creates a low-level #CoglTexture2D texture from block compressed
+ * data. Each mipmap level is half the size of the previous one,
+ * rounded down but never less than 1, and takes up a whole number of
+ * blocks.
+ *
+ * If the driver supports @format then the data is given to the GPU
+ * as it is. Otherwise the ETC and S3TC formats are decoded on the CPU
+ * so that they can still be used, at the cost of taking up more GPU
+ * memory. There is no software decoder for the BPTC and ASTC formats
+ * so if %COGL_FEATURE_ID_TEXTURE_BPTC or
+ * %COGL_FEATURE_ID_TEXTURE_ASTC aren't available this will fail with
+ * %COGL_TEXTURE_ERROR_FORMAT.
+ *
+ * Cogl can't generate mipmaps for compressed textures so if the
+ * texture will be used with a mipmap filter then @data should
+ * contain all of the levels down to 1x1. Compressed textures can't
+ * be updated with cogl_texture_set_region() and their alpha is never
+ * premultiplied.
+ *
+ * <note>This api will always immediately allocate GPU memory for the
+ * texture and upload the given data so that the @data pointer does
+ * not need to remain valid once this function returns.</note>
+ *
+ * Returns: (transfer full): A newly allocated #CoglTexture2D or %NULL
+ *          if the texture couldn't be created in which case @error
+ *          will be set.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglTexture2D *
+cogl_texture_2d_new_from_compressed_data (CoglContext *ctx,
+                                          int width,
+                                          int height,
+                                          CoglPixelFormat format,
+                                          int n_levels,
+                                          size_t data_size,
+                                          const uint8_t *data,
+                                          CoglError **error);
+
 /**
  * cogl_texture_2d_new_from_bitmap:
  * @bitmap: A #CoglBitmap
@@ -152,7 +152,8 @@ typedef enum _CoglTextureSoureType {
   COGL_TEXTURE_SOURCE_TYPE_SIZED = 1,
   COGL_TEXTURE_SOURCE_TYPE_BITMAP,
   COGL_TEXTURE_SOURCE_TYPE_EGL_IMAGE,
-  COGL_TEXTURE_SOURCE_TYPE_GL_FOREIGN
+  COGL_TEXTURE_SOURCE_TYPE_GL_FOREIGN,
+  COGL_TEXTURE_SOURCE_TYPE_COMPRESSED
 } CoglTextureSourceType;
 
 typedef struct _CoglTextureLoader
@@ -184,6 +185,15 @@ typedef struct _CoglTextureLoader
       unsigned int gl_handle;
       CoglPixelFormat format;
     } gl_foreign;
+    struct {
+      int width;
+      int height;
+      CoglPixelFormat format;
+      int n_levels;
+      /* All of the levels packed together starting with the largest.
+       * This is owned by the loader */
+      uint8_t *data;
+    } compressed;
   } src;
 } CoglTextureLoader;
 
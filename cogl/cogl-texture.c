@@ -159,6 +159,9 @@ _cogl_texture_free_loader (CoglTexture *texture)
         case COGL_TEXTURE_SOURCE_TYPE_BITMAP:
           cogl_object_unref (loader->src.bitmap.bitmap);
           break;
+        case COGL_TEXTURE_SOURCE_TYPE_COMPRESSED:
+          u_free (loader->src.compressed.data);
+          break;
         }
       u_slice_free (CoglTextureLoader, loader);
       texture->loader = NULL;
@@ -377,6 +380,13 @@ cogl_texture_set_region_from_bitmap (CoglTexture *texture,
                                      int level,
                                      CoglError **error)
 {
+  CoglBool ret;
+  COGL_STATIC_TIMER (texture_upload_timer,
+                     "Mainloop", /* parent */
+                     "Texture Upload",
+                     "The time spent uploading texture data",
+                     0 /* no application private data */);
+
   _COGL_RETURN_VAL_IF_FAIL ((cogl_bitmap_get_width (bmp) - src_x)
                             >= width, FALSE);
   _COGL_RETURN_VAL_IF_FAIL ((cogl_bitmap_get_height (bmp) - src_y)
@@ -395,13 +405,19 @@ cogl_texture_set_region_from_bitmap (CoglTexture *texture,
      always stored in an RGBA texture even if the texture format is
      advertised as RGB. */
 
-  return texture->vtable->set_region (texture,
-                                      src_x, src_y,
-                                      dst_x, dst_y,
-                                      width, height,
-                                      level,
-                                      bmp,
-                                      error);
+  COGL_TIMER_START (texture->context, texture_upload_timer);
+
+  ret = texture->vtable->set_region (texture,
+                                     src_x, src_y,
+                                     dst_x, dst_y,
+                                     width, height,
+                                     level,
+                                     bmp,
+                                     error);
+
+  COGL_TIMER_STOP (texture->context, texture_upload_timer);
+
+  return ret;
 }
 
 CoglBool
@@ -966,7 +982,15 @@ cogl_texture_get_data (CoglTexture *texture,
 
   /* Default to internal format if none specified */
   if (format == COGL_PIXEL_FORMAT_ANY)
-    format = texture_format;
+    {
+      /* Compressed textures can only be read back decompressed */
+      if (_cogl_pixel_format_is_compressed (texture_format))
+        format = COGL_PIXEL_FORMAT_RGBA_8888;
+      else
+        format = texture_format;
+    }
+
+  _COGL_RETURN_VAL_IF_FAIL (!_cogl_pixel_format_is_compressed (format), 0);
 
   tex_width = cogl_texture_get_width (texture);
   tex_height = cogl_texture_get_height (texture);
@@ -1297,6 +1321,13 @@ CoglBool
 cogl_texture_allocate (CoglTexture *texture,
                        CoglError **error)
 {
+  COGL_STATIC_TIMER (texture_allocate_timer,
+                     "Mainloop", /* parent */
+                     "Texture Allocate",
+                     "The time spent allocating textures including "
+                     "uploading their initial data",
+                     0 /* no application private data */);
+
   if (texture->allocated)
     return TRUE;
 
@@ -1308,7 +1339,9 @@ cogl_texture_allocate (CoglTexture *texture,
                      "A red-green texture was requested but the driver "
                      "does not support them");
 
+  COGL_TIMER_START (texture->context, texture_allocate_timer);
   texture->allocated = texture->vtable->allocate (texture, error);
+  COGL_TIMER_STOP (texture->context, texture_allocate_timer);
 
   return texture->allocated;
 }
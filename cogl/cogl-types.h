@@ -225,6 +225,16 @@ typedef struct _CoglColor               CoglColor;
 #define COGL_DEPTH_BIT          (1 << 10)
 #define COGL_STENCIL_BIT        (1 << 11)
 
+/**
+ * COGL_COMPRESSED_BIT:
+ *
+ * A flag that can be masked with a #CoglPixelFormat to determine if
+ * it represents a block compressed format. The bytes per pixel of a
+ * compressed format is always zero because the data can only be
+ * addressed in whole blocks.
+ */
+#define COGL_COMPRESSED_BIT     (1 << 12)
+
 #define COGL_FORMAT_ENUM(X) ((X)<<24)
 
 /* XXX: Notes to those adding new formats here...
@@ -232,11 +242,12 @@ typedef struct _CoglColor               CoglColor;
  * First this diagram outlines how we allocate the 32bits of a
  * CoglPixelFormat currently...
  *
- *                            7 bits for flags
- *                       |------|
+ *                           8 bits for flags
+ *                      |-------|
  *  enum        unused             6 bits for the bytes-per-pixel
- *  |------| |----------|        |----|
- *  00000000 xxxxxxxx xxxSDPFB ABxxxxxx
+ *  |------| |---------|         |----|
+ *  00000000 xxxxxxxx xxCSDPFB ABxxxxxx
+ *                      ^ compressed
  *                       ^ stencil
  *                        ^ depth
  *                         ^ premult
@@ -264,7 +275,7 @@ typedef struct _CoglColor               CoglColor;
  *    increment of the last sequence number in the most significant
  *    byte.
  *
- * The last sequence number used was 1
+ * The last sequence number used was 13
  *
  * Update this note whenever a new sequence number is used.
  */
@@ -301,6 +312,30 @@ typedef struct _CoglColor               CoglColor;
  * @COGL_PIXEL_FORMAT_DEPTH_16: Depth, 16 bits
  * @COGL_PIXEL_FORMAT_DEPTH_32: Depth, 32 bits
  * @COGL_PIXEL_FORMAT_DEPTH_24_STENCIL_8: Depth/Stencil, 24/8 bits
+ * @COGL_PIXEL_FORMAT_ETC1_RGB_8: ETC1 compressed RGB, 4x4 blocks of
+ *   8 bytes
+ * @COGL_PIXEL_FORMAT_ETC2_RGB_8: ETC2 compressed RGB, 4x4 blocks of
+ *   8 bytes
+ * @COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1: ETC2 compressed RGB with
+ *   punch-through alpha, 4x4 blocks of 8 bytes
+ * @COGL_PIXEL_FORMAT_ETC2_RGBA_8: ETC2 compressed RGB with EAC alpha,
+ *   4x4 blocks of 16 bytes
+ * @COGL_PIXEL_FORMAT_S3TC_DXT1_RGB: S3TC DXT1 compressed RGB, 4x4
+ *   blocks of 8 bytes
+ * @COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA: S3TC DXT1 compressed RGB with
+ *   1-bit alpha, 4x4 blocks of 8 bytes
+ * @COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA: S3TC DXT3 compressed RGBA, 4x4
+ *   blocks of 16 bytes
+ * @COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA: S3TC DXT5 compressed RGBA, 4x4
+ *   blocks of 16 bytes
+ * @COGL_PIXEL_FORMAT_BPTC_RGBA: BPTC (BC7) compressed RGBA, 4x4
+ *   blocks of 16 bytes
+ * @COGL_PIXEL_FORMAT_ASTC_4x4_RGBA: ASTC compressed RGBA, 4x4 blocks
+ *   of 16 bytes
+ * @COGL_PIXEL_FORMAT_ASTC_6x6_RGBA: ASTC compressed RGBA, 6x6 blocks
+ *   of 16 bytes
+ * @COGL_PIXEL_FORMAT_ASTC_8x8_RGBA: ASTC compressed RGBA, 8x8 blocks
+ *   of 16 bytes
  *
  * Pixel formats used by Cogl. For the formats with a byte per
  * component, the order of the components specify the order in
@@ -317,6 +352,12 @@ typedef struct _CoglColor               CoglColor;
  * would be in 1-5. Therefore the order in memory depends on the
  * endianness of the system.
  *
+ * The compressed formats all have %COGL_COMPRESSED_BIT set. They can
+ * only be used to create textures with
+ * cogl_texture_2d_new_from_compressed_data() or by loading a KTX
+ * file and they can't be used to update or read back a region of a
+ * texture. Their alpha, where present, is never premultiplied.
+ *
  * Since: 0.8
  */
 typedef enum { /*< prefix=COGL_PIXEL_FORMAT >*/
@@ -357,7 +398,23 @@ typedef enum { /*< prefix=COGL_PIXEL_FORMAT >*/
   COGL_PIXEL_FORMAT_DEPTH_16 = (2 | COGL_DEPTH_BIT),
   COGL_PIXEL_FORMAT_DEPTH_32 = (4 | COGL_DEPTH_BIT),
 
-  COGL_PIXEL_FORMAT_DEPTH_24_STENCIL_8 = (4 | COGL_DEPTH_BIT | COGL_STENCIL_BIT)
+  COGL_PIXEL_FORMAT_DEPTH_24_STENCIL_8 = (4 | COGL_DEPTH_BIT | COGL_STENCIL_BIT),
+
+  COGL_PIXEL_FORMAT_ETC1_RGB_8 = (COGL_COMPRESSED_BIT | COGL_FORMAT_ENUM(2)),
+  COGL_PIXEL_FORMAT_ETC2_RGB_8 = (COGL_COMPRESSED_BIT | COGL_FORMAT_ENUM(3)),
+  COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1 = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(4)),
+  COGL_PIXEL_FORMAT_ETC2_RGBA_8 = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(5)),
+
+  COGL_PIXEL_FORMAT_S3TC_DXT1_RGB = (COGL_COMPRESSED_BIT | COGL_FORMAT_ENUM(6)),
+  COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(7)),
+  COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(8)),
+  COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(9)),
+
+  COGL_PIXEL_FORMAT_BPTC_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(10)),
+
+  COGL_PIXEL_FORMAT_ASTC_4x4_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(11)),
+  COGL_PIXEL_FORMAT_ASTC_6x6_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(12)),
+  COGL_PIXEL_FORMAT_ASTC_8x8_RGBA = (COGL_COMPRESSED_BIT | COGL_A_BIT | COGL_FORMAT_ENUM(13))
 } CoglPixelFormat;
 
 /**
@@ -0,0 +1,93 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef _COGL_WORKER_POOL_PRIVATE_H_
+#define _COGL_WORKER_POOL_PRIVATE_H_
+
+#include "cogl-types.h"
+
+/*
+ * A small pool of threads used to split up expensive CPU work, such
+ * as converting large bitmaps, into bands of rows that can be
+ * processed in parallel. The calling thread also processes bands and
+ * _cogl_worker_pool_run_rows() only returns once all of the rows have
+ * been handled so the pool can be used as if the work was done
+ * synchronously.
+ *
+ * The threads are only created the first time some work is split
+ * up. The maximum number of threads, including the calling thread,
+ * can be set with the COGL_MAX_WORKER_THREADS environment variable
+ * or config option. Setting it to 1 makes all of the work happen on
+ * the calling thread.
+ */
+
+typedef struct _CoglWorkerPool CoglWorkerPool;
+
+typedef void (* CoglWorkerRowsFunc) (int first_row,
+                                     int n_rows,
+                                     void *user_data);
+
+CoglWorkerPool *
+_cogl_worker_pool_new (void);
+
+void
+_cogl_worker_pool_free (CoglWorkerPool *pool);
+
+/*
+ * _cogl_worker_pool_get_max_threads:
+ * @pool: A #CoglWorkerPool
+ *
+ * Returns: the maximum number of threads that will be used to
+ *   process the rows, including the calling thread.
+ */
+int
+_cogl_worker_pool_get_max_threads (CoglWorkerPool *pool);
+
+/*
+ * _cogl_worker_pool_run_rows:
+ * @pool: A #CoglWorkerPool
+ * @n_rows: The total number of rows
+ * @min_rows_per_band: The minimum number of rows that a band should
+ *   contain so that it is worth passing to another thread
+ * @func: The function to call for each band of rows
+ * @user_data: Data to pass to @func
+ *
+ * Splits the rows into bands and calls @func for each band, possibly
+ * from different threads at the same time. @func must therefore only
+ * touch the rows that it is given. This function doesn't return until
+ * all of the bands have been processed.
+ */
+void
+_cogl_worker_pool_run_rows (CoglWorkerPool *pool,
+                            int n_rows,
+                            int min_rows_per_band,
+                            CoglWorkerRowsFunc func,
+                            void *user_data);
+
+#endif /* _COGL_WORKER_POOL_PRIVATE_H_ */
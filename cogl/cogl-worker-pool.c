@@ -0,0 +1,281 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "cogl-util.h"
+#include "cogl-config-private.h"
+#include "cogl-worker-pool-private.h"
+
+/* Limit the default number of threads. The work that is split up is
+   mostly limited by memory bandwidth so more threads than this
+   doesn't help */
+#define COGL_WORKER_POOL_DEFAULT_MAX_THREADS 4
+
+/* The rows are split into a few more bands than there are threads
+   so that a thread that gets descheduled doesn't hold up the rest */
+#define COGL_WORKER_POOL_BANDS_PER_THREAD 2
+
+struct _CoglWorkerPool
+{
+  /* The maximum number of threads that can work on a job, including
+     the calling thread */
+  int max_threads;
+
+#ifdef HAVE_PTHREADS
+  pthread_t *threads;
+  int n_threads;
+
+  pthread_mutex_t mutex;
+  /* Signalled when there's a new job or when the threads should
+     quit */
+  pthread_cond_t work_cond;
+  /* Signalled when the last band of a job is finished */
+  pthread_cond_t done_cond;
+
+  /* The current job */
+  CoglWorkerRowsFunc func;
+  void *user_data;
+  int n_rows;
+  int rows_per_band;
+  int n_bands;
+  int next_band;
+  int n_bands_done;
+
+  CoglBool quit;
+#endif /* HAVE_PTHREADS */
+};
+
+static int
+get_max_threads (void)
+{
+  const char *max_threads_string;
+  int max_threads = 1;
+
+  max_threads_string = u_getenv ("COGL_MAX_WORKER_THREADS");
+  if (max_threads_string == NULL)
+    max_threads_string = _cogl_config_max_worker_threads;
+
+  if (max_threads_string)
+    max_threads = atoi (max_threads_string);
+  else
+    {
+#if defined (HAVE_PTHREADS) && defined (_SC_NPROCESSORS_ONLN)
+      max_threads = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+      max_threads = MIN (max_threads, COGL_WORKER_POOL_DEFAULT_MAX_THREADS);
+    }
+
+#ifndef HAVE_PTHREADS
+  max_threads = 1;
+#endif
+
+  return MAX (max_threads, 1);
+}
+
+CoglWorkerPool *
+_cogl_worker_pool_new (void)
+{
+  CoglWorkerPool *pool = u_slice_new0 (CoglWorkerPool);
+
+  pool->max_threads = get_max_threads ();
+
+#ifdef HAVE_PTHREADS
+  pthread_mutex_init (&pool->mutex, NULL);
+  pthread_cond_init (&pool->work_cond, NULL);
+  pthread_cond_init (&pool->done_cond, NULL);
+#endif
+
+  return pool;
+}
+
+int
+_cogl_worker_pool_get_max_threads (CoglWorkerPool *pool)
+{
+  return pool->max_threads;
+}
+
+#ifdef HAVE_PTHREADS
+
+/* Runs bands from the current job until there are none left. This
+   must be called with the mutex locked */
+static void
+run_bands_locked (CoglWorkerPool *pool)
+{
+  while (pool->next_band < pool->n_bands)
+    {
+      int band = pool->next_band++;
+      int first_row = band * pool->rows_per_band;
+      int n_rows = MIN (pool->rows_per_band, pool->n_rows - first_row);
+
+      pthread_mutex_unlock (&pool->mutex);
+
+      pool->func (first_row, n_rows, pool->user_data);
+
+      pthread_mutex_lock (&pool->mutex);
+
+      if (++pool->n_bands_done == pool->n_bands)
+        pthread_cond_signal (&pool->done_cond);
+    }
+}
+
+static void *
+worker_thread_func (void *data)
+{
+  CoglWorkerPool *pool = data;
+
+  pthread_mutex_lock (&pool->mutex);
+
+  while (TRUE)
+    {
+      while (!pool->quit && pool->next_band >= pool->n_bands)
+        pthread_cond_wait (&pool->work_cond, &pool->mutex);
+
+      if (pool->quit)
+        break;
+
+      run_bands_locked (pool);
+    }
+
+  pthread_mutex_unlock (&pool->mutex);
+
+  return NULL;
+}
+
+static void
+start_threads (CoglWorkerPool *pool)
+{
+  int i;
+
+  pool->threads = u_new (pthread_t, pool->max_threads - 1);
+
+  for (i = 0; i < pool->max_threads - 1; i++)
+    {
+      if (pthread_create (pool->threads + i,
+                          NULL, /* attributes */
+                          worker_thread_func,
+                          pool))
+        break;
+    }
+
+  pool->n_threads = i;
+
+  /* If creating the threads failed then we'll just have to cope with
+     the ones we have */
+  pool->max_threads = pool->n_threads + 1;
+}
+
+#endif /* HAVE_PTHREADS */
+
+void
+_cogl_worker_pool_run_rows (CoglWorkerPool *pool,
+                            int n_rows,
+                            int min_rows_per_band,
+                            CoglWorkerRowsFunc func,
+                            void *user_data)
+{
+#ifdef HAVE_PTHREADS
+  int n_bands;
+
+  min_rows_per_band = MAX (min_rows_per_band, 1);
+
+  n_bands = MIN (pool->max_threads * COGL_WORKER_POOL_BANDS_PER_THREAD,
+                 n_rows / min_rows_per_band);
+
+  if (n_bands <= 1 || pool->max_threads <= 1)
+    {
+      func (0, n_rows, user_data);
+      return;
+    }
+
+  if (pool->threads == NULL)
+    start_threads (pool);
+
+  pthread_mutex_lock (&pool->mutex);
+
+  pool->func = func;
+  pool->user_data = user_data;
+  pool->n_rows = n_rows;
+  pool->rows_per_band = (n_rows + n_bands - 1) / n_bands;
+  /* Rounding up the band size may mean that fewer bands are needed */
+  pool->n_bands = (n_rows + pool->rows_per_band - 1) / pool->rows_per_band;
+  pool->next_band = 0;
+  pool->n_bands_done = 0;
+
+  pthread_cond_broadcast (&pool->work_cond);
+
+  /* The calling thread works on the job too */
+  run_bands_locked (pool);
+
+  while (pool->n_bands_done < pool->n_bands)
+    pthread_cond_wait (&pool->done_cond, &pool->mutex);
+
+  pthread_mutex_unlock (&pool->mutex);
+
+#else /* HAVE_PTHREADS */
+
+  func (0, n_rows, user_data);
+
+#endif /* HAVE_PTHREADS */
+}
+
+void
+_cogl_worker_pool_free (CoglWorkerPool *pool)
+{
+#ifdef HAVE_PTHREADS
+  int i;
+
+  pthread_mutex_lock (&pool->mutex);
+  pool->quit = TRUE;
+  pthread_cond_broadcast (&pool->work_cond);
+  pthread_mutex_unlock (&pool->mutex);
+
+  for (i = 0; i < pool->n_threads; i++)
+    pthread_join (pool->threads[i], NULL);
+
+  u_free (pool->threads);
+
+  pthread_cond_destroy (&pool->done_cond);
+  pthread_cond_destroy (&pool->work_cond);
+  pthread_mutex_destroy (&pool->mutex);
+#endif
+
+  u_slice_free (CoglWorkerPool, pool);
+}
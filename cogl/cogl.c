@@ -190,3 +190,9 @@ _cogl_pixel_format_is_endian_dependant (CoglPixelFormat format)
 {
   return !(format & COGL_BITWISE_BIT);
 }
+
+CoglBool
+_cogl_pixel_format_is_compressed (CoglPixelFormat format)
+{
+  return !!(format & COGL_COMPRESSED_BIT);
+}
@@ -47,4 +47,8 @@ _cogl_gl_flush_attributes_state (CoglFramebuffer *framebuffer,
                                  CoglAttribute **attributes,
                                  int n_attributes);
 
+void
+_cogl_gl_attribute_invalidate (CoglContext *context,
+                               CoglAttribute *attribute);
+
 #endif /* _COGL_ATTRIBUTE_GL_PRIVATE_H_ */
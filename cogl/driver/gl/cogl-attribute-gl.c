@@ -37,6 +37,7 @@
 #endif
 
 #include <string.h>
+#include <stddef.h>
 
 #include "cogl-private.h"
 #include "cogl-util-gl-private.h"
@@ -49,6 +50,30 @@
 #include "cogl-pipeline-progend-glsl-private.h"
 #include "cogl-buffer-gl-private.h"
 
+/* The maximum number of vertex array objects that will be cached. If
+ * more than this many layouts are drawn then the cache is simply
+ * emptied and started again */
+#define COGL_VERTEX_ARRAY_CACHE_SIZE 1024
+
+typedef struct
+{
+  CoglAttribute *attribute;
+  int location;
+} CoglVertexArrayBinding;
+
+/* A vertex array object set up with the pointers for a list of
+ * buffered attributes. This is used both as the key and the value of
+ * the context's vertex_array_cache */
+typedef struct
+{
+  CoglContext *context;
+  GLuint vertex_array;
+  unsigned int hash;
+  int n_bindings;
+  /* This is over-allocated to hold n_bindings */
+  CoglVertexArrayBinding bindings[1];
+} CoglVertexArray;
+
 typedef struct _ForeachChangedBitState
 {
   CoglContext *context;
@@ -94,11 +119,37 @@ foreach_changed_bit_and_save (CoglContext *context,
   _cogl_bitmask_set_bits (current_bits, new_bits);
 }
 
+static void
+set_attribute_pointer (CoglContext *context,
+                       CoglAttribute *attribute,
+                       int attrib_location)
+{
+  CoglBuffer *buffer = COGL_BUFFER (attribute->d.buffered.attribute_buffer);
+  uint8_t *base;
+
+  /* Note: we don't try and catch errors with binding buffers here
+   * since OOM errors at this point indicate that nothing has yet been
+   * uploaded to attribute buffer which we consider to be a programmer
+   * error.
+   */
+  base = _cogl_buffer_gl_bind (buffer,
+                               COGL_BUFFER_BIND_TARGET_ATTRIBUTE_BUFFER,
+                               NULL);
+
+  GE( context, glVertexAttribPointer (attrib_location,
+                                      attribute->d.buffered.n_components,
+                                      attribute->d.buffered.type,
+                                      attribute->normalized,
+                                      attribute->d.buffered.stride,
+                                      base + attribute->d.buffered.offset) );
+
+  _cogl_buffer_gl_unbind (buffer);
+}
+
 static void
 setup_generic_buffered_attribute (CoglContext *context,
                                   CoglPipeline *pipeline,
-                                  CoglAttribute *attribute,
-                                  uint8_t *base)
+                                  CoglAttribute *attribute)
 {
   int name_index = attribute->name_state->name_index;
   int attrib_location =
@@ -107,14 +158,22 @@ setup_generic_buffered_attribute (CoglContext *context,
   if (attrib_location == -1)
     return;
 
-  GE( context, glVertexAttribPointer (attrib_location,
-                                      attribute->d.buffered.n_components,
-                                      attribute->d.buffered.type,
-                                      attribute->normalized,
-                                      attribute->d.buffered.stride,
-                                      base + attribute->d.buffered.offset) );
+  set_attribute_pointer (context, attribute, attrib_location);
   _cogl_bitmask_set (&context->enable_custom_attributes_tmp,
                      attrib_location, TRUE);
+
+  /* The divisor is part of the state of the attribute location rather
+   * than of the enabled array so any location that was last used
+   * with a divisor needs resetting */
+  if (attribute->d.buffered.divisor ||
+      _cogl_bitmask_get (&context->instanced_attributes, attrib_location))
+    {
+      GE( context, glVertexAttribDivisor (attrib_location,
+                                          attribute->d.buffered.divisor) );
+      _cogl_bitmask_set (&context->instanced_attributes,
+                         attrib_location,
+                         attribute->d.buffered.divisor != 0);
+    }
 }
 
 static void
@@ -165,6 +224,212 @@ setup_generic_const_attribute (CoglContext *context,
     }
 }
 
+static void
+bind_vertex_array (CoglContext *context,
+                   GLuint vertex_array)
+{
+  if (context->current_vertex_array != vertex_array)
+    {
+      GE( context, glBindVertexArray (vertex_array) );
+      context->current_vertex_array = vertex_array;
+    }
+}
+
+static size_t
+vertex_array_size (int n_bindings)
+{
+  return (offsetof (CoglVertexArray, bindings) +
+          sizeof (CoglVertexArrayBinding) * n_bindings);
+}
+
+static unsigned int
+vertex_array_hash (const void *key)
+{
+  const CoglVertexArray *array = key;
+
+  return array->hash;
+}
+
+static CoglBool
+vertex_array_equal (const void *a, const void *b)
+{
+  const CoglVertexArray *array_a = a;
+  const CoglVertexArray *array_b = b;
+  int i;
+
+  if (array_a->n_bindings != array_b->n_bindings)
+    return FALSE;
+
+  for (i = 0; i < array_a->n_bindings; i++)
+    if (array_a->bindings[i].attribute != array_b->bindings[i].attribute ||
+        array_a->bindings[i].location != array_b->bindings[i].location)
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+vertex_array_free (void *data)
+{
+  CoglVertexArray *array = data;
+  CoglContext *context = array->context;
+
+  /* Deleting the bound vertex array makes GL revert to array 0 */
+  if (context->current_vertex_array == array->vertex_array)
+    context->current_vertex_array = 0;
+
+  GE( context, glDeleteVertexArrays (1, &array->vertex_array) );
+
+  u_free (array);
+}
+
+static CoglVertexArray *
+create_vertex_array (CoglContext *context,
+                     const CoglVertexArray *key)
+{
+  size_t size = vertex_array_size (key->n_bindings);
+  CoglVertexArray *array = u_malloc (size);
+  int i;
+
+  memcpy (array, key, size);
+  array->context = context;
+
+  GE( context, glGenVertexArrays (1, &array->vertex_array) );
+  bind_vertex_array (context, array->vertex_array);
+
+  /* A new vertex array object starts with every array disabled and
+   * all of the divisors set to zero so there's no need to compare
+   * against the previous state like we do for the default object */
+  for (i = 0; i < array->n_bindings; i++)
+    {
+      CoglAttribute *attribute = array->bindings[i].attribute;
+      int location = array->bindings[i].location;
+
+      set_attribute_pointer (context, attribute, location);
+      GE( context, glEnableVertexAttribArray (location) );
+
+      if (attribute->d.buffered.divisor)
+        GE( context, glVertexAttribDivisor (location,
+                                            attribute->d.buffered.divisor) );
+
+      attribute->has_vertex_arrays = TRUE;
+    }
+
+  return array;
+}
+
+/* Tries to bind a cached vertex array object for the attributes,
+ * creating it if it's not in the cache yet. Returns FALSE if the
+ * attributes can't be stored in a vertex array object in which case
+ * they need to be set up on the default object instead. */
+static CoglBool
+flush_cached_vertex_array (CoglContext *context,
+                           CoglPipeline *pipeline,
+                           CoglAttribute **attributes,
+                           int n_attributes)
+{
+  CoglVertexArray *key;
+  CoglVertexArray *array;
+  unsigned int hash = 0;
+  int i;
+
+  key = u_alloca (vertex_array_size (n_attributes));
+  key->n_bindings = 0;
+
+  for (i = 0; i < n_attributes; i++)
+    {
+      CoglAttribute *attribute = attributes[i];
+      CoglVertexArrayBinding *binding;
+      CoglBuffer *buffer;
+      int name_index;
+      int location;
+
+      if (!attribute->is_buffered)
+        continue;
+
+      /* Client-side arrays can't be stored in a vertex array object */
+      buffer = COGL_BUFFER (attribute->d.buffered.attribute_buffer);
+      if (!(buffer->flags & COGL_BUFFER_FLAG_BUFFER_OBJECT))
+        return FALSE;
+
+      name_index = attribute->name_state->name_index;
+      location =
+        _cogl_pipeline_progend_glsl_get_attrib_location (pipeline, name_index);
+      if (location == -1)
+        continue;
+
+      binding = &key->bindings[key->n_bindings++];
+      binding->attribute = attribute;
+      binding->location = location;
+
+      hash = _cogl_util_one_at_a_time_hash (hash,
+                                            &attribute,
+                                            sizeof (attribute));
+      hash = _cogl_util_one_at_a_time_hash (hash,
+                                            &location,
+                                            sizeof (location));
+    }
+
+  if (key->n_bindings == 0)
+    return FALSE;
+
+  key->hash = _cogl_util_one_at_a_time_mix (hash);
+
+  if (context->vertex_array_cache == NULL)
+    context->vertex_array_cache =
+      u_hash_table_new_full (vertex_array_hash,
+                             vertex_array_equal,
+                             vertex_array_free,
+                             NULL);
+
+  array = u_hash_table_lookup (context->vertex_array_cache, key);
+
+  if (array)
+    bind_vertex_array (context, array->vertex_array);
+  else
+    {
+      if (u_hash_table_size (context->vertex_array_cache) >=
+          COGL_VERTEX_ARRAY_CACHE_SIZE)
+        u_hash_table_remove_all (context->vertex_array_cache);
+
+      array = create_vertex_array (context, key);
+      u_hash_table_insert (context->vertex_array_cache, array, array);
+    }
+
+  /* The values of constant attributes aren't part of the vertex
+   * array state so they always need to be set */
+  for (i = 0; i < n_attributes; i++)
+    if (!attributes[i]->is_buffered)
+      setup_generic_const_attribute (context, pipeline, attributes[i]);
+
+  return TRUE;
+}
+
+static CoglBool
+vertex_array_uses_attribute_cb (void *key,
+                                void *value,
+                                void *user_data)
+{
+  CoglVertexArray *array = value;
+  int i;
+
+  for (i = 0; i < array->n_bindings; i++)
+    if (array->bindings[i].attribute == user_data)
+      return TRUE;
+
+  return FALSE;
+}
+
+void
+_cogl_gl_attribute_invalidate (CoglContext *context,
+                               CoglAttribute *attribute)
+{
+  if (context->vertex_array_cache)
+    u_hash_table_foreach_remove (context->vertex_array_cache,
+                                 vertex_array_uses_attribute_cb,
+                                 attribute);
+}
+
 static void
 apply_attribute_enable_updates (CoglContext *context,
                                 CoglPipeline *pipeline)
@@ -264,44 +529,32 @@ _cogl_gl_flush_attributes_state (CoglFramebuffer *framebuffer,
                                  with_color_attrib,
                                  unknown_color_alpha);
 
-  _cogl_bitmask_clear_all (&ctx->enable_custom_attributes_tmp);
-
   /* Bind the attribute pointers. We need to do this after the
    * pipeline is flushed because when using GLSL that is the only
    * point when we can determine the attribute locations */
 
+  if ((flags & COGL_DRAW_CACHE_VERTEX_ARRAY) &&
+      ctx->glGenVertexArrays &&
+      flush_cached_vertex_array (ctx, pipeline, attributes, n_attributes))
+    goto done;
+
+  bind_vertex_array (ctx, ctx->default_vertex_array);
+
+  _cogl_bitmask_clear_all (&ctx->enable_custom_attributes_tmp);
+
   for (i = 0; i < n_attributes; i++)
     {
       CoglAttribute *attribute = attributes[i];
-      CoglAttributeBuffer *attribute_buffer;
-      CoglBuffer *buffer;
-      uint8_t *base;
 
       if (attribute->is_buffered)
-        {
-          attribute_buffer = cogl_attribute_get_buffer (attribute);
-          buffer = COGL_BUFFER (attribute_buffer);
-
-          /* Note: we don't try and catch errors with binding buffers
-           * here since OOM errors at this point indicate that nothing
-           * has yet been uploaded to attribute buffer which we
-           * consider to be a programmer error.
-           */
-          base =
-            _cogl_buffer_gl_bind (buffer,
-                                  COGL_BUFFER_BIND_TARGET_ATTRIBUTE_BUFFER,
-                                  NULL);
-
-          setup_generic_buffered_attribute (ctx, pipeline, attribute, base);
-
-          _cogl_buffer_gl_unbind (buffer);
-        }
+        setup_generic_buffered_attribute (ctx, pipeline, attribute);
       else
         setup_generic_const_attribute (ctx, pipeline, attribute);
     }
 
   apply_attribute_enable_updates (ctx, pipeline);
 
+done:
   if (copy)
     cogl_object_unref (copy);
 }
@@ -78,6 +78,15 @@
 #ifndef GL_MAP_INVALIDATE_BUFFER_BIT
 #define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
 #endif
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
 
 void
 _cogl_buffer_gl_create (CoglBuffer *buffer)
@@ -158,6 +167,38 @@ recreate_store (CoglBuffer *buffer,
   return TRUE;
 }
 
+/* Creates immutable storage that can stay mapped while the GPU reads
+ * from it. @gl_access should have the same map bits that will be used
+ * to map the buffer */
+static CoglBool
+create_persistent_store (CoglBuffer *buffer,
+                         GLbitfield gl_access,
+                         CoglError **error)
+{
+  CoglContext *ctx = buffer->context;
+  GLenum gl_target;
+  GLenum gl_error;
+
+  /* This assumes the buffer is already bound */
+
+  gl_target = convert_bind_target_to_gl_target (buffer->last_target);
+
+  /* Clear any GL errors */
+  while ((gl_error = ctx->glGetError ()) != GL_NO_ERROR)
+    ;
+
+  ctx->glBufferStorage (gl_target,
+                        buffer->size,
+                        NULL,
+                        gl_access);
+
+  if (_cogl_gl_util_catch_out_of_memory (ctx, error))
+    return FALSE;
+
+  buffer->store_created = TRUE;
+  return TRUE;
+}
+
 GLenum
 _cogl_buffer_access_to_gl_enum (CoglBufferAccess access)
 {
@@ -265,6 +306,34 @@ _cogl_buffer_gl_map_range (CoglBuffer *buffer,
                !(access & COGL_BUFFER_ACCESS_READ))
         gl_access |= GL_MAP_INVALIDATE_RANGE_BIT;
 
+      if ((hints & COGL_BUFFER_MAP_HINT_UNSYNCHRONIZED) &&
+          _cogl_has_private_feature
+          (ctx, COGL_PRIVATE_FEATURE_MAP_BUFFER_UNSYNCHRONIZED))
+        gl_access |= GL_MAP_UNSYNCHRONIZED_BIT;
+
+      if ((hints & COGL_BUFFER_MAP_HINT_PERSISTENT) &&
+          _cogl_has_private_feature
+          (ctx, COGL_PRIVATE_FEATURE_MAP_BUFFER_PERSISTENT))
+        {
+          gl_access |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+          if (!buffer->store_created)
+            {
+              if (!create_persistent_store (buffer,
+                                            gl_access &
+                                            (GL_MAP_READ_BIT |
+                                             GL_MAP_WRITE_BIT |
+                                             GL_MAP_PERSISTENT_BIT |
+                                             GL_MAP_COHERENT_BIT),
+                                            error))
+                {
+                  _cogl_buffer_gl_unbind (buffer);
+                  return NULL;
+                }
+              should_recreate_store = FALSE;
+            }
+        }
+
       if (should_recreate_store)
         {
           if (!recreate_store (buffer, error))
@@ -1097,13 +1097,21 @@ _cogl_framebuffer_gl_draw_attributes (CoglFramebuffer *framebuffer,
                                       int n_vertices,
                                       CoglAttribute **attributes,
                                       int n_attributes,
+                                      int n_instances,
                                       CoglDrawFlags flags)
 {
   _cogl_flush_attributes_state (framebuffer, pipeline, flags,
                                 attributes, n_attributes);
 
-  GE (framebuffer->context,
-      glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
+  if (n_instances == 1)
+    GE (framebuffer->context,
+        glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
+  else
+    GE (framebuffer->context,
+        glDrawArraysInstanced ((GLenum)mode,
+                               first_vertex,
+                               n_vertices,
+                               n_instances));
 }
 
 static size_t
@@ -1130,6 +1138,7 @@ _cogl_framebuffer_gl_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                               CoglIndices *indices,
                                               CoglAttribute **attributes,
                                               int n_attributes,
+                                              int n_instances,
                                               CoglDrawFlags flags)
 {
   CoglBuffer *buffer;
@@ -1166,11 +1175,20 @@ _cogl_framebuffer_gl_draw_indexed_attributes (CoglFramebuffer *framebuffer,
       break;
     }
 
-  GE (framebuffer->context,
-      glDrawElements ((GLenum)mode,
-                      n_vertices,
-                      indices_gl_type,
-                      base + buffer_offset + index_size * first_vertex));
+  if (n_instances == 1)
+    GE (framebuffer->context,
+        glDrawElements ((GLenum)mode,
+                        n_vertices,
+                        indices_gl_type,
+                        base + buffer_offset + index_size * first_vertex));
+  else
+    GE (framebuffer->context,
+        glDrawElementsInstanced ((GLenum)mode,
+                                 n_vertices,
+                                 indices_gl_type,
+                                 base + buffer_offset +
+                                 index_size * first_vertex,
+                                 n_instances));
 
   _cogl_buffer_gl_unbind (buffer);
 }
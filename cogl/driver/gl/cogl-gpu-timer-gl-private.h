@@ -0,0 +1,55 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef _COGL_GPU_TIMER_GL_PRIVATE_H_
+#define _COGL_GPU_TIMER_GL_PRIVATE_H_
+
+#include "cogl-types.h"
+#include "cogl-context.h"
+
+unsigned int
+_cogl_gpu_timer_gl_begin (CoglContext *context);
+
+void
+_cogl_gpu_timer_gl_end (CoglContext *context,
+                        unsigned int timer);
+
+CoglBool
+_cogl_gpu_timer_gl_get_result (CoglContext *context,
+                               unsigned int timer,
+                               int64_t *elapsed);
+
+void
+_cogl_gpu_timer_gl_free (CoglContext *context,
+                         unsigned int timer);
+
+CoglBool
+_cogl_gpu_timer_gl_check_disjoint (CoglContext *context);
+
+#endif /* _COGL_GPU_TIMER_GL_PRIVATE_H_ */
@@ -0,0 +1,113 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-context-private.h"
+#include "cogl-util-gl-private.h"
+#include "cogl-gpu-timer-gl-private.h"
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+unsigned int
+_cogl_gpu_timer_gl_begin (CoglContext *ctx)
+{
+  GLuint query = 0;
+
+  GE( ctx, glGenQueries (1, &query) );
+  if (query == 0)
+    return 0;
+
+  GE( ctx, glBeginQuery (GL_TIME_ELAPSED, query) );
+
+  return query;
+}
+
+void
+_cogl_gpu_timer_gl_end (CoglContext *ctx,
+                        unsigned int timer)
+{
+  GE( ctx, glEndQuery (GL_TIME_ELAPSED) );
+}
+
+CoglBool
+_cogl_gpu_timer_gl_get_result (CoglContext *ctx,
+                               unsigned int timer,
+                               int64_t *elapsed)
+{
+  GLint available = GL_FALSE;
+  uint64_t result = 0;
+
+  GE( ctx, glGetQueryObjectiv (timer, GL_QUERY_RESULT_AVAILABLE, &available) );
+  if (!available)
+    return FALSE;
+
+  GE( ctx, glGetQueryObjectui64v (timer, GL_QUERY_RESULT, &result) );
+  *elapsed = result;
+
+  return TRUE;
+}
+
+void
+_cogl_gpu_timer_gl_free (CoglContext *ctx,
+                         unsigned int timer)
+{
+  GLuint query = timer;
+
+  GE( ctx, glDeleteQueries (1, &query) );
+}
+
+CoglBool
+_cogl_gpu_timer_gl_check_disjoint (CoglContext *ctx)
+{
+  GLint disjoint = GL_FALSE;
+
+  /* Without GL_EXT_disjoint_timer_query there is no way to find out
+   * so we have to assume the results are fine */
+  if (!_cogl_has_private_feature (ctx,
+                                  COGL_PRIVATE_FEATURE_GPU_TIMER_DISJOINT))
+    return FALSE;
+
+  GE( ctx, glGetIntegerv (GL_GPU_DISJOINT_EXT, &disjoint) );
+
+  return disjoint;
+}
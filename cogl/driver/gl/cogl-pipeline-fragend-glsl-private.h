@@ -41,5 +41,8 @@ extern const CoglPipelineFragend _cogl_pipeline_glsl_fragend;
 GLuint
 _cogl_pipeline_fragend_glsl_get_shader (CoglPipeline *pipeline);
 
+uint64_t
+_cogl_pipeline_fragend_glsl_get_source_hash (CoglPipeline *pipeline);
+
 #endif /* __COGL_PIPELINE_FRAGEND_GLSL_PRIVATE_H */
 
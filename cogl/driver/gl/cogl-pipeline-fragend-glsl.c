@@ -91,6 +91,12 @@ typedef struct
   int ref_count;
 
   GLuint gl_shader;
+  /* If the program cache is being used then compiling the shader is
+     delayed until the progend finds that it needs to link a program
+     with it. The hash of the source is used as part of the key for
+     the cache */
+  CoglBool compile_pending;
+  uint64_t source_hash;
   UString *header, *source;
   UnitState *unit_state;
 
@@ -187,8 +193,27 @@ _cogl_pipeline_fragend_glsl_get_shader (CoglPipeline *pipeline)
 {
   CoglPipelineShaderState *shader_state = get_shader_state (pipeline);
 
+  if (shader_state == NULL)
+    return 0;
+
+  if (shader_state->compile_pending)
+    {
+      _COGL_GET_CONTEXT (ctx, 0);
+
+      _cogl_glsl_shader_compile (ctx, shader_state->gl_shader);
+      shader_state->compile_pending = FALSE;
+    }
+
+  return shader_state->gl_shader;
+}
+
+uint64_t
+_cogl_pipeline_fragend_glsl_get_source_hash (CoglPipeline *pipeline)
+{
+  CoglPipelineShaderState *shader_state = get_shader_state (pipeline);
+
   if (shader_state)
-    return shader_state->gl_shader;
+    return shader_state->source_hash;
   else
     return 0;
 }
@@ -1012,7 +1037,6 @@ _cogl_pipeline_fragend_glsl_end (CoglPipeline *pipeline,
     {
       const char *source_strings[2];
       GLint lengths[2];
-      GLint compile_status;
       GLuint shader;
       CoglPipelineSnippetData snippet_data;
 
@@ -1021,7 +1045,7 @@ _cogl_pipeline_fragend_glsl_end (CoglPipeline *pipeline,
                            "Increments each time a new GLSL "
                            "fragment shader is compiled",
                            0 /* no application private data */);
-      COGL_COUNTER_INC (_cogl_uprof_context, fragend_glsl_compile_counter);
+      COGL_COUNTER_INC (ctx, fragend_glsl_compile_counter);
 
       if (!_cogl_list_empty (&shader_state->layers))
         {
@@ -1088,19 +1112,19 @@ _cogl_pipeline_fragend_glsl_end (CoglPipeline *pipeline,
                                                      2, /* count */
                                                      source_strings, lengths);
 
-      GE( ctx, glCompileShader (shader) );
-      GE( ctx, glGetShaderiv (shader, GL_COMPILE_STATUS, &compile_status) );
-
-      if (!compile_status)
+      /* If the program might be loaded from the cache then there's
+       * no point in compiling the shader yet */
+      if (_cogl_context_get_program_cache (ctx))
         {
-          GLint len = 0;
-          char *shader_log;
-
-          GE( ctx, glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &len) );
-          shader_log = u_alloca (len);
-          GE( ctx, glGetShaderInfoLog (shader, len, &len, shader_log) );
-          u_warning ("Shader compilation failed:\n%s", shader_log);
+          shader_state->source_hash =
+            _cogl_glsl_shader_hash_source (GL_FRAGMENT_SHADER,
+                                           2, /* count */
+                                           source_strings,
+                                           lengths);
+          shader_state->compile_pending = TRUE;
         }
+      else
+        _cogl_glsl_shader_compile (ctx, shader);
 
       shader_state->header = NULL;
       shader_state->source = NULL;
@@ -972,7 +972,7 @@ _cogl_pipeline_flush_gl_state (CoglContext *ctx,
                      "The time spent flushing material state",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, pipeline_flush_timer);
+  COGL_TIMER_START (ctx, pipeline_flush_timer);
 
   /* Bail out asap if we've been asked to re-flush the already current
    * pipeline and we can see the pipeline hasn't changed */
@@ -1227,6 +1227,6 @@ done:
       unit1->dirty_gl_texture = FALSE;
     }
 
-  COGL_TIMER_STOP (_cogl_uprof_context, pipeline_flush_timer);
+  COGL_TIMER_STOP (ctx, pipeline_flush_timer);
 }
 
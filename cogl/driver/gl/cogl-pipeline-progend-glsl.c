@@ -55,6 +55,14 @@
 #include "cogl-attribute-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-pipeline-progend-glsl-private.h"
+#include "cogl-program-cache-private.h"
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
 
 /* These are used to generalise updating some uniforms that are
    required when building for drivers missing some fixed function
@@ -104,6 +112,77 @@ typedef struct _UnitState
   GLint combine_constant_uniform;
 } UnitState;
 
+static CoglBool
+load_program_binary (CoglContext *ctx,
+                     CoglProgramCache *program_cache,
+                     uint64_t program_key,
+                     GLuint gl_program)
+{
+  uint32_t binary_format;
+  size_t length;
+  void *binary;
+  GLint link_status;
+
+  binary = _cogl_program_cache_load (program_cache,
+                                     program_key,
+                                     &binary_format,
+                                     &length);
+  if (binary == NULL)
+    return FALSE;
+
+  /* The driver is allowed to reject a binary, for example if it has
+   * been upgraded in a way that doesn't change the version string. In
+   * that case the errors are ignored and the program is linked
+   * normally */
+  ctx->glProgramBinary (gl_program, binary_format, binary, length);
+  while (ctx->glGetError () != GL_NO_ERROR);
+
+  u_free (binary);
+
+  GE( ctx, glGetProgramiv (gl_program, GL_LINK_STATUS, &link_status) );
+
+  if (!link_status)
+    _cogl_program_cache_remove (program_cache, program_key);
+
+  return link_status;
+}
+
+static void
+store_program_binary (CoglContext *ctx,
+                      CoglProgramCache *program_cache,
+                      uint64_t program_key,
+                      GLuint gl_program)
+{
+  GLint link_status;
+  GLint length = 0;
+  GLenum binary_format;
+  void *binary;
+
+  GE( ctx, glGetProgramiv (gl_program, GL_LINK_STATUS, &link_status) );
+  if (!link_status)
+    return;
+
+  GE( ctx, glGetProgramiv (gl_program, GL_PROGRAM_BINARY_LENGTH, &length) );
+  if (length <= 0)
+    return;
+
+  binary = u_malloc (length);
+
+  GE( ctx, glGetProgramBinary (gl_program,
+                               length,
+                               &length,
+                               &binary_format,
+                               binary) );
+
+  _cogl_program_cache_store (program_cache,
+                             program_key,
+                             binary_format,
+                             binary,
+                             length);
+
+  u_free (binary);
+}
+
 typedef struct
 {
   CoglContext *ctx;
@@ -325,10 +404,19 @@ static void
 link_program (CoglContext *ctx, GLint gl_program)
 {
   GLint link_status;
+  COGL_STATIC_TIMER (link_timer,
+                     "Mainloop", /* parent */
+                     "GLSL Link",
+                     "The time spent linking GLSL programs",
+                     0 /* no application private data */);
 
+  COGL_TIMER_START (ctx, link_timer);
   GE( ctx, glLinkProgram (gl_program) );
 
+  /* Querying the link status is included in the timing because some
+     drivers defer the actual link until it is needed */
   GE( ctx, glGetProgramiv (gl_program, GL_LINK_STATUS, &link_status) );
+  COGL_TIMER_STOP (ctx, link_timer);
 
   if (!link_status)
     {
@@ -694,24 +782,66 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
 
   if (program_state->program == 0)
     {
+      CoglProgramCache *program_cache = _cogl_context_get_program_cache (ctx);
+      uint64_t program_key = 0;
       GLuint backend_shader;
 
       GE_RET( program_state->program, ctx, glCreateProgram () );
 
-      /* Attach any shaders from the GLSL backends */
-      if ((backend_shader = _cogl_pipeline_fragend_glsl_get_shader (pipeline)))
-        GE( ctx, glAttachShader (program_state->program, backend_shader) );
-      if ((backend_shader = _cogl_pipeline_vertend_glsl_get_shader (pipeline)))
-        GE( ctx, glAttachShader (program_state->program, backend_shader) );
+      if (program_cache)
+        {
+          uint64_t shader_hashes[2];
 
-      /* XXX: OpenGL as a special case requires the vertex position to
-       * be bound to generic attribute 0 so for simplicity we
-       * unconditionally bind the cogl_position_in attribute here...
-       */
-      GE( ctx, glBindAttribLocation (program_state->program,
-                                     0, "cogl_position_in"));
+          shader_hashes[0] =
+            _cogl_pipeline_fragend_glsl_get_source_hash (pipeline);
+          shader_hashes[1] =
+            _cogl_pipeline_vertend_glsl_get_source_hash (pipeline);
 
-      link_program (ctx, program_state->program);
+          program_key = _cogl_program_cache_get_key (program_cache,
+                                                     2, /* n_hashes */
+                                                     shader_hashes);
+        }
+
+      /* If the binary is in the cache then the shaders never need to
+       * be compiled */
+      if (program_cache == NULL ||
+          !load_program_binary (ctx,
+                                program_cache,
+                                program_key,
+                                program_state->program))
+        {
+          /* Attach any shaders from the GLSL backends */
+          if ((backend_shader =
+               _cogl_pipeline_fragend_glsl_get_shader (pipeline)))
+            GE( ctx, glAttachShader (program_state->program,
+                                     backend_shader) );
+          if ((backend_shader =
+               _cogl_pipeline_vertend_glsl_get_shader (pipeline)))
+            GE( ctx, glAttachShader (program_state->program,
+                                     backend_shader) );
+
+          /* XXX: OpenGL as a special case requires the vertex position to
+           * be bound to generic attribute 0 so for simplicity we
+           * unconditionally bind the cogl_position_in attribute here...
+           */
+          GE( ctx, glBindAttribLocation (program_state->program,
+                                         0, "cogl_position_in"));
+
+          /* Some drivers only keep the binary around if this hint is
+           * set before linking */
+          if (program_cache && ctx->glProgramParameteri)
+            GE( ctx, glProgramParameteri (program_state->program,
+                                          GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                          GL_TRUE) );
+
+          link_program (ctx, program_state->program);
+
+          if (program_cache)
+            store_program_binary (ctx,
+                                  program_cache,
+                                  program_key,
+                                  program_state->program);
+        }
 
       program_changed = TRUE;
     }
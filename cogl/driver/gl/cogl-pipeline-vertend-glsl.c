@@ -59,6 +59,12 @@ typedef struct
   unsigned int ref_count;
 
   GLuint gl_shader;
+  /* If the program cache is being used then compiling the shader is
+     delayed until the progend finds that it needs to link a program
+     with it. The hash of the source is used as part of the key for
+     the cache */
+  CoglBool compile_pending;
+  uint64_t source_hash;
   UString *header, *source;
 
   CoglPipelineCacheEntry *cache_entry;
@@ -140,8 +146,27 @@ _cogl_pipeline_vertend_glsl_get_shader (CoglPipeline *pipeline)
 {
   CoglPipelineShaderState *shader_state = get_shader_state (pipeline);
 
+  if (shader_state == NULL)
+    return 0;
+
+  if (shader_state->compile_pending)
+    {
+      _COGL_GET_CONTEXT (ctx, 0);
+
+      _cogl_glsl_shader_compile (ctx, shader_state->gl_shader);
+      shader_state->compile_pending = FALSE;
+    }
+
+  return shader_state->gl_shader;
+}
+
+uint64_t
+_cogl_pipeline_vertend_glsl_get_source_hash (CoglPipeline *pipeline)
+{
+  CoglPipelineShaderState *shader_state = get_shader_state (pipeline);
+
   if (shader_state)
-    return shader_state->gl_shader;
+    return shader_state->source_hash;
   else
     return 0;
 }
@@ -399,7 +424,6 @@ _cogl_pipeline_vertend_glsl_end (CoglPipeline *pipeline,
     {
       const char *source_strings[2];
       GLint lengths[2];
-      GLint compile_status;
       GLuint shader;
       CoglPipelineSnippetData snippet_data;
       CoglPipelineSnippetList *vertex_snippets;
@@ -411,7 +435,7 @@ _cogl_pipeline_vertend_glsl_end (CoglPipeline *pipeline,
                            "Increments each time a new GLSL "
                            "vertex shader is compiled",
                            0 /* no application private data */);
-      COGL_COUNTER_INC (_cogl_uprof_context, vertend_glsl_compile_counter);
+      COGL_COUNTER_INC (ctx, vertend_glsl_compile_counter);
 
       u_string_append (shader_state->header,
                        "void\n"
@@ -509,19 +533,19 @@ _cogl_pipeline_vertend_glsl_end (CoglPipeline *pipeline,
                                                      2, /* count */
                                                      source_strings, lengths);
 
-      GE( ctx, glCompileShader (shader) );
-      GE( ctx, glGetShaderiv (shader, GL_COMPILE_STATUS, &compile_status) );
-
-      if (!compile_status)
+      /* If the program might be loaded from the cache then there's
+       * no point in compiling the shader yet */
+      if (_cogl_context_get_program_cache (ctx))
         {
-          GLint len = 0;
-          char *shader_log;
-
-          GE( ctx, glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &len) );
-          shader_log = u_alloca (len);
-          GE( ctx, glGetShaderInfoLog (shader, len, &len, shader_log) );
-          u_warning ("Shader compilation failed:\n%s", shader_log);
+          shader_state->source_hash =
+            _cogl_glsl_shader_hash_source (GL_VERTEX_SHADER,
+                                           2, /* count */
+                                           source_strings,
+                                           lengths);
+          shader_state->compile_pending = TRUE;
         }
+      else
+        _cogl_glsl_shader_compile (ctx, shader);
 
       shader_state->header = NULL;
       shader_state->source = NULL;
@@ -45,6 +45,7 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-error-private.h"
 #include "cogl-util-gl-private.h"
+#include "cogl-compressed-format-private.h"
 
 void
 _cogl_texture_2d_gl_free (CoglTexture2D *tex_2d)
@@ -319,6 +320,115 @@ allocate_from_egl_image (CoglTexture2D *tex_2d,
 }
 #endif
 
+static CoglBool
+allocate_from_compressed_data (CoglTexture2D *tex_2d,
+                               CoglTextureLoader *loader,
+                               CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglContext *ctx = tex->context;
+  CoglPixelFormat format = loader->src.compressed.format;
+  int width = loader->src.compressed.width;
+  int height = loader->src.compressed.height;
+  int n_levels = loader->src.compressed.n_levels;
+  const uint8_t *data = loader->src.compressed.data;
+  int level_width = width;
+  int level_height = height;
+  GLenum gl_intformat;
+  GLenum gl_error;
+  GLuint gl_texture;
+  CoglBool out_of_memory = FALSE;
+  CoglBool failed = FALSE;
+  int level;
+
+  if (!cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_NPOT_BASIC) &&
+      (!_cogl_util_is_pot (width) ||
+       !_cogl_util_is_pot (height)))
+    {
+      _cogl_set_error (error, COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_SIZE,
+                       "Failed to create texture 2d due to size/format"
+                       " constraints");
+      return FALSE;
+    }
+
+  ctx->driver_vtable->pixel_format_to_gl (ctx,
+                                          format,
+                                          &gl_intformat,
+                                          NULL,
+                                          NULL);
+
+  gl_texture = ctx->texture_driver->gen (ctx, GL_TEXTURE_2D, format);
+
+  _cogl_bind_gl_texture_transient (GL_TEXTURE_2D, gl_texture, FALSE);
+
+  /* Clear any GL errors */
+  while ((gl_error = ctx->glGetError ()) != GL_NO_ERROR)
+    ;
+
+  /* The mipmap chain comes straight from the data. GL can't generate
+   * mipmaps for compressed textures itself */
+  for (level = 0; level < n_levels; level++)
+    {
+      size_t level_size =
+        _cogl_compressed_format_get_image_size (format,
+                                                level_width,
+                                                level_height);
+
+      ctx->glCompressedTexImage2D (GL_TEXTURE_2D,
+                                   level,
+                                   gl_intformat,
+                                   level_width,
+                                   level_height,
+                                   0,
+                                   level_size,
+                                   data);
+
+      data += level_size;
+      level_width = MAX (level_width >> 1, 1);
+      level_height = MAX (level_height >> 1, 1);
+    }
+
+  while ((gl_error = ctx->glGetError ()) != GL_NO_ERROR)
+    {
+      if (gl_error == GL_OUT_OF_MEMORY)
+        out_of_memory = TRUE;
+      failed = TRUE;
+    }
+
+  if (failed)
+    {
+      if (out_of_memory)
+        _cogl_set_error (error, COGL_SYSTEM_ERROR,
+                         COGL_SYSTEM_ERROR_NO_MEMORY,
+                         "Out of memory");
+      else
+        _cogl_set_error (error, COGL_TEXTURE_ERROR,
+                         COGL_TEXTURE_ERROR_FORMAT,
+                         "The driver rejected the compressed texture data");
+      GE( ctx, glDeleteTextures (1, &gl_texture) );
+      return FALSE;
+    }
+
+  tex_2d->gl_texture = gl_texture;
+  tex_2d->gl_internal_format = gl_intformat;
+  tex_2d->internal_format = format;
+
+  tex_2d->auto_mipmap = FALSE;
+  tex_2d->mipmaps_dirty = FALSE;
+
+  _cogl_texture_set_allocated (tex, format, width, height);
+
+  /* Limit sampling to the levels that were given so that the texture
+   * is still complete if the data doesn't have a full mipmap chain.
+   * This has to wait until the texture is marked as allocated because
+   * it looks up the GL texture which would otherwise try to allocate
+   * it again */
+  _cogl_texture_gl_maybe_update_max_level (tex, n_levels - 1);
+
+  return TRUE;
+}
+
 static CoglBool
 allocate_from_gl_foreign (CoglTexture2D *tex_2d,
                           CoglTextureLoader *loader,
@@ -468,6 +578,8 @@ _cogl_texture_2d_gl_allocate (CoglTexture *tex,
 #endif
     case COGL_TEXTURE_SOURCE_TYPE_GL_FOREIGN:
       return allocate_from_gl_foreign (tex_2d, loader, error);
+    case COGL_TEXTURE_SOURCE_TYPE_COMPRESSED:
+      return allocate_from_compressed_data (tex_2d, loader, error);
     }
 
   u_return_val_if_reached (FALSE);
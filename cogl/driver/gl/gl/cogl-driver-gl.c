@@ -45,6 +45,8 @@
 #include "cogl-attribute-gl-private.h"
 #include "cogl-clip-stack-gl-private.h"
 #include "cogl-buffer-gl-private.h"
+#include "cogl-gpu-timer-gl-private.h"
+#include "cogl-compressed-format-private.h"
 
 static CoglBool
 _cogl_driver_pixel_format_from_gl_internal (CoglContext *context,
@@ -258,6 +260,68 @@ _cogl_driver_pixel_format_to_gl (CoglContext *context,
       gltype = GL_UNSIGNED_INT_24_8;
       break;
 
+      /* The compressed formats can only be uploaded with
+       * glCompressedTexImage2D so the format and type are only used
+       * when reading the texture back */
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+      /* There's no ETC1 format in big GL but all ETC1 data is also
+       * valid ETC2 data */
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+      glintformat = GL_COMPRESSED_RGB8_ETC2;
+      glformat = GL_RGB;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+      glintformat = GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+      glintformat = GL_COMPRESSED_RGBA8_ETC2_EAC;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+      glintformat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      glformat = GL_RGB;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+
     case COGL_PIXEL_FORMAT_ANY:
       u_assert_not_reached ();
       break;
@@ -653,12 +717,56 @@ _cogl_driver_update_features (CoglContext *ctx,
   if (ctx->glFenceSync)
     COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_FENCE, TRUE);
 
+  if (ctx->glMapBufferRange)
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_MAP_BUFFER_UNSYNCHRONIZED, TRUE);
+
+  if (ctx->glMapBufferRange && ctx->glBufferStorage)
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_MAP_BUFFER_PERSISTENT, TRUE);
+
+  /* GL_EXT_timer_query doesn't have all of the functions we need so
+   * it isn't enough for the function pointers to be resolved */
+  if (ctx->glBeginQuery &&
+      (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 3, 3) ||
+       _cogl_check_extension ("GL_ARB_timer_query", gl_extensions)))
+    COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_GPU_TIMING, TRUE);
+
+  if (_cogl_check_extension ("GL_EXT_disjoint_timer_query", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_GPU_TIMER_DISJOINT, TRUE);
+
+  if (ctx->glVertexAttribDivisor &&
+      ctx->glDrawArraysInstanced &&
+      ctx->glDrawElementsInstanced)
+    COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_INSTANCING, TRUE);
+
   if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 3, 0) ||
       _cogl_check_extension ("GL_ARB_texture_rg", gl_extensions))
     COGL_FLAGS_SET (ctx->features,
                     COGL_FEATURE_ID_TEXTURE_RG,
                     TRUE);
 
+  if (ctx->glCompressedTexImage2D)
+    {
+      if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 4, 3) ||
+          _cogl_check_extension ("GL_ARB_ES3_compatibility", gl_extensions))
+        COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_ETC2, TRUE);
+
+      if (_cogl_check_extension ("GL_EXT_texture_compression_s3tc",
+                                 gl_extensions))
+        COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_S3TC, TRUE);
+
+      if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 4, 2) ||
+          _cogl_check_extension ("GL_ARB_texture_compression_bptc",
+                                 gl_extensions))
+        COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_BPTC, TRUE);
+
+      if (_cogl_check_extension ("GL_KHR_texture_compression_astc_ldr",
+                                 gl_extensions))
+        COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_ASTC, TRUE);
+    }
+
   /* Cache features */
   for (i = 0; i < U_N_ELEMENTS (private_features); i++)
     ctx->private_features[i] |= private_features[i];
@@ -705,10 +813,16 @@ _cogl_driver_gl =
     _cogl_texture_2d_gl_copy_from_bitmap,
     _cogl_texture_2d_gl_get_data,
     _cogl_gl_flush_attributes_state,
+    _cogl_gl_attribute_invalidate,
     _cogl_clip_stack_gl_flush,
     _cogl_buffer_gl_create,
     _cogl_buffer_gl_destroy,
     _cogl_buffer_gl_map_range,
     _cogl_buffer_gl_unmap,
     _cogl_buffer_gl_set_data,
+    _cogl_gpu_timer_gl_begin,
+    _cogl_gpu_timer_gl_end,
+    _cogl_gpu_timer_gl_get_result,
+    _cogl_gpu_timer_gl_free,
+    _cogl_gpu_timer_gl_check_disjoint,
   };
@@ -44,6 +44,8 @@
 #include "cogl-attribute-gl-private.h"
 #include "cogl-clip-stack-gl-private.h"
 #include "cogl-buffer-gl-private.h"
+#include "cogl-gpu-timer-gl-private.h"
+#include "cogl-compressed-format-private.h"
 
 #ifndef GL_UNSIGNED_INT_24_8
 #define GL_UNSIGNED_INT_24_8 0x84FA
@@ -194,6 +196,74 @@ _cogl_driver_pixel_format_to_gl (CoglContext *context,
       gltype = GL_UNSIGNED_INT_24_8;
       break;
 
+      /* The compressed formats can only be uploaded with
+       * glCompressedTexImage2D so the format and type are only used
+       * when reading the texture back */
+    case COGL_PIXEL_FORMAT_ETC1_RGB_8:
+      if (cogl_has_feature (context, COGL_FEATURE_ID_TEXTURE_ETC1))
+        glintformat = GL_ETC1_RGB8_OES;
+      else
+        /* All ETC1 data is also valid ETC2 data */
+        glintformat = GL_COMPRESSED_RGB8_ETC2;
+      glformat = GL_RGB;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8:
+      glintformat = GL_COMPRESSED_RGB8_ETC2;
+      glformat = GL_RGB;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGB_8_A_1:
+      glintformat = GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ETC2_RGBA_8:
+      glintformat = GL_COMPRESSED_RGBA8_ETC2_EAC;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGB:
+      glintformat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      glformat = GL_RGB;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT1_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT3_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_S3TC_DXT5_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_BPTC_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ASTC_4x4_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ASTC_6x6_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+    case COGL_PIXEL_FORMAT_ASTC_8x8_RGBA:
+      glintformat = GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+      glformat = GL_RGBA;
+      gltype = GL_UNSIGNED_BYTE;
+      break;
+
     case COGL_PIXEL_FORMAT_ANY:
       u_assert_not_reached ();
       break;
@@ -213,6 +283,34 @@ _cogl_driver_pixel_format_to_gl (CoglContext *context,
   return required_format;
 }
 
+/* GLES version strings always start with "OpenGL ES N.M" */
+static void
+_cogl_get_gles_version (CoglContext *context,
+                        int *major_out,
+                        int *minor_out)
+{
+  const char *version_string = _cogl_context_get_gl_version (context);
+  const char *p;
+  int major = 0, minor = 0;
+
+  *major_out = 0;
+  *minor_out = 0;
+
+  if (version_string == NULL ||
+      !u_str_has_prefix (version_string, "OpenGL ES "))
+    return;
+
+  for (p = version_string + 10; *p >= '0' && *p <= '9'; p++)
+    major = major * 10 + *p - '0';
+  if (*p != '.')
+    return;
+  for (p++; *p >= '0' && *p <= '9'; p++)
+    minor = minor * 10 + *p - '0';
+
+  *major_out = major;
+  *minor_out = minor;
+}
+
 static CoglBool
 _cogl_driver_update_features (CoglContext *context,
                               CoglError **error)
@@ -220,6 +318,7 @@ _cogl_driver_update_features (CoglContext *context,
   unsigned long private_features
     [COGL_FLAGS_N_LONGS_FOR_SIZE (COGL_N_PRIVATE_FEATURES)] = { 0 };
   char **gl_extensions;
+  int gles_major, gles_minor;
   int i;
 
   /* We have to special case getting the pointer to the glGetString
@@ -355,6 +454,42 @@ _cogl_driver_update_features (CoglContext *context,
                     COGL_FEATURE_ID_TEXTURE_RG,
                     TRUE);
 
+  if (context->glBeginQuery &&
+      _cogl_check_extension ("GL_EXT_disjoint_timer_query", gl_extensions))
+    {
+      COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_GPU_TIMING, TRUE);
+      COGL_FLAGS_SET (private_features,
+                      COGL_PRIVATE_FEATURE_GPU_TIMER_DISJOINT, TRUE);
+    }
+
+  if (context->glVertexAttribDivisor &&
+      context->glDrawArraysInstanced &&
+      context->glDrawElementsInstanced)
+    COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_INSTANCING, TRUE);
+
+  _cogl_get_gles_version (context, &gles_major, &gles_minor);
+
+  if (_cogl_check_extension ("GL_OES_compressed_ETC1_RGB8_texture",
+                             gl_extensions))
+    COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TEXTURE_ETC1, TRUE);
+
+  /* ETC2 is part of core GLES 3.0 */
+  if (COGL_CHECK_GL_VERSION (gles_major, gles_minor, 3, 0))
+    COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TEXTURE_ETC2, TRUE);
+
+  if (_cogl_check_extension ("GL_EXT_texture_compression_s3tc",
+                             gl_extensions))
+    COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TEXTURE_S3TC, TRUE);
+
+  if (_cogl_check_extension ("GL_EXT_texture_compression_bptc",
+                             gl_extensions))
+    COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TEXTURE_BPTC, TRUE);
+
+  if (COGL_CHECK_GL_VERSION (gles_major, gles_minor, 3, 2) ||
+      _cogl_check_extension ("GL_KHR_texture_compression_astc_ldr",
+                             gl_extensions))
+    COGL_FLAGS_SET (context->features, COGL_FEATURE_ID_TEXTURE_ASTC, TRUE);
+
   /* Cache features */
   for (i = 0; i < U_N_ELEMENTS (private_features); i++)
     context->private_features[i] |= private_features[i];
@@ -390,10 +525,16 @@ _cogl_driver_gles =
     _cogl_texture_2d_gl_copy_from_bitmap,
     NULL, /* texture_2d_get_data */
     _cogl_gl_flush_attributes_state,
+    _cogl_gl_attribute_invalidate,
     _cogl_clip_stack_gl_flush,
     _cogl_buffer_gl_create,
     _cogl_buffer_gl_destroy,
     _cogl_buffer_gl_map_range,
     _cogl_buffer_gl_unmap,
     _cogl_buffer_gl_set_data,
+    _cogl_gpu_timer_gl_begin,
+    _cogl_gpu_timer_gl_end,
+    _cogl_gpu_timer_gl_get_result,
+    _cogl_gpu_timer_gl_free,
+    _cogl_gpu_timer_gl_check_disjoint,
   };
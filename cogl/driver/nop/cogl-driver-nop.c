@@ -43,6 +43,7 @@
 #include "cogl-texture-2d-nop-private.h"
 #include "cogl-attribute-nop-private.h"
 #include "cogl-clip-stack-nop-private.h"
+#include "cogl-gpu-timer-nop-private.h"
 
 static CoglBool
 _cogl_driver_update_features (CoglContext *ctx,
@@ -52,6 +53,10 @@ _cogl_driver_update_features (CoglContext *ctx,
 
   memset (ctx->private_features, 0, sizeof (ctx->private_features));
 
+  /* The GPU timers return synthetic results so that the timing API
+   * can be tested without a GPU */
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_GPU_TIMING, TRUE);
+
   return TRUE;
 }
 
@@ -81,5 +86,16 @@ _cogl_driver_nop =
     _cogl_texture_2d_nop_copy_from_bitmap,
     NULL, /* texture_2d_get_data */
     _cogl_nop_flush_attributes_state,
+    NULL, /* attribute_invalidate */
     _cogl_clip_stack_nop_flush,
+    NULL, /* buffer_create */
+    NULL, /* buffer_destroy */
+    NULL, /* buffer_map_range */
+    NULL, /* buffer_unmap */
+    NULL, /* buffer_set_data */
+    _cogl_gpu_timer_nop_begin,
+    _cogl_gpu_timer_nop_end,
+    _cogl_gpu_timer_nop_get_result,
+    _cogl_gpu_timer_nop_free,
+    NULL, /* gpu_timer_check_disjoint */
   };
@@ -76,6 +76,7 @@ _cogl_framebuffer_nop_draw_attributes (CoglFramebuffer *framebuffer,
                                        int n_vertices,
                                        CoglAttribute **attributes,
                                        int n_attributes,
+                                       int n_instances,
                                        CoglDrawFlags flags);
 
 void
@@ -87,6 +88,7 @@ _cogl_framebuffer_nop_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                                CoglIndices *indices,
                                                CoglAttribute **attributes,
                                                int n_attributes,
+                                               int n_instances,
                                                CoglDrawFlags flags);
 
 CoglBool
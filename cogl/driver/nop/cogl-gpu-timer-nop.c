@@ -0,0 +1,68 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-gpu-timer-nop-private.h"
+
+/* There is no GPU so every timer reports the same synthetic
+ * duration. This lets the timing API be tested with the nop driver */
+#define COGL_GPU_TIMER_NOP_ELAPSED 1000 /* nanoseconds */
+
+unsigned int
+_cogl_gpu_timer_nop_begin (CoglContext *context)
+{
+  static unsigned int next_timer = 1;
+
+  return next_timer++;
+}
+
+void
+_cogl_gpu_timer_nop_end (CoglContext *context,
+                         unsigned int timer)
+{
+}
+
+CoglBool
+_cogl_gpu_timer_nop_get_result (CoglContext *context,
+                                unsigned int timer,
+                                int64_t *elapsed)
+{
+  *elapsed = COGL_GPU_TIMER_NOP_ELAPSED;
+
+  return TRUE;
+}
+
+void
+_cogl_gpu_timer_nop_free (CoglContext *context,
+                          unsigned int timer)
+{
+}
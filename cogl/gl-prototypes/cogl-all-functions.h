@@ -273,6 +273,17 @@ COGL_EXT_FUNCTION (GLvoid *, glMapBufferRange,
                     GLbitfield access))
 COGL_EXT_END ()
 
+COGL_EXT_BEGIN (buffer_storage, 4, 4,
+                0, /* not in GLES */
+                "ARB:\0",
+                "buffer_storage\0")
+COGL_EXT_FUNCTION (void, glBufferStorage,
+                   (GLenum target,
+                    GLsizeiptr size,
+                    const GLvoid *data,
+                    GLbitfield flags))
+COGL_EXT_END ()
+
 #ifdef GL_ARB_sync
 COGL_EXT_BEGIN (sync, 3, 2,
                 0, /* not in GLES */
@@ -287,6 +298,85 @@ COGL_EXT_FUNCTION (void, glDeleteSync,
 COGL_EXT_END ()
 #endif
 
+COGL_EXT_BEGIN (get_program_binary, 4, 1,
+                0, /* not in GLES2 */
+                "ARB:\0OES\0",
+                "get_program_binary\0")
+COGL_EXT_FUNCTION (void, glGetProgramBinary,
+                   (GLuint program,
+                    GLsizei bufSize,
+                    GLsizei *length,
+                    GLenum *binaryFormat,
+                    GLvoid *binary))
+COGL_EXT_FUNCTION (void, glProgramBinary,
+                   (GLuint program,
+                    GLenum binaryFormat,
+                    const GLvoid *binary,
+                    GLsizei length))
+COGL_EXT_END ()
+
+/* Timer queries are in core GL 3.3. GLES can only get them through
+ * GL_EXT_disjoint_timer_query which uses EXT suffixed names for all
+ * of the query functions */
+COGL_EXT_BEGIN (timer_query, 3, 3,
+                0, /* not in GLES2 */
+                "ARB:\0EXT\0",
+                "timer_query\0disjoint_timer_query\0")
+COGL_EXT_FUNCTION (void, glGenQueries,
+                   (GLsizei n,
+                    GLuint *ids))
+COGL_EXT_FUNCTION (void, glDeleteQueries,
+                   (GLsizei n,
+                    const GLuint *ids))
+COGL_EXT_FUNCTION (void, glBeginQuery,
+                   (GLenum target,
+                    GLuint id))
+COGL_EXT_FUNCTION (void, glEndQuery,
+                   (GLenum target))
+COGL_EXT_FUNCTION (void, glGetQueryObjectiv,
+                   (GLuint id,
+                    GLenum pname,
+                    GLint *params))
+COGL_EXT_FUNCTION (void, glGetQueryObjectui64v,
+                   (GLuint id,
+                    GLenum pname,
+                    uint64_t *params))
+COGL_EXT_END ()
+
+/* Instanced arrays are in core GL 3.3. On GLES2 the EXT and ANGLE
+ * extensions provide all three functions */
+COGL_EXT_BEGIN (instanced_arrays, 3, 3,
+                0, /* not in GLES2 */
+                "ARB\0EXT\0ANGLE\0",
+                "instanced_arrays\0")
+COGL_EXT_FUNCTION (void, glVertexAttribDivisor,
+                   (GLuint index,
+                    GLuint divisor))
+COGL_EXT_FUNCTION (void, glDrawArraysInstanced,
+                   (GLenum mode,
+                    GLint first,
+                    GLsizei count,
+                    GLsizei primcount))
+COGL_EXT_FUNCTION (void, glDrawElementsInstanced,
+                   (GLenum mode,
+                    GLsizei count,
+                    GLenum type,
+                    const GLvoid *indices,
+                    GLsizei primcount))
+COGL_EXT_END ()
+
+/* glProgramParameteri is only in the ARB version of the extension so
+ * it is checked separately */
+COGL_EXT_BEGIN (program_parameteri, 4, 1,
+                0, /* not in GLES2 */
+                "ARB:\0",
+                "get_program_binary\0")
+COGL_EXT_FUNCTION (void, glProgramParameteri,
+                   (GLuint program,
+                    GLenum pname,
+                    GLint value))
+COGL_EXT_END ()
+
 /* Note the check for multitexturing is split into two parts because
  * GLES2 has glActiveTexture() but not glClientActiveTexture()
  */
@@ -32,34 +32,56 @@
 #include <math.h>
 #include <ulib.h>
 
+/*
+ * The table uses open addressing with Robin Hood probing. The
+ * capacity is always a power of two and the slots are stored in a
+ * single array so inserting never needs to allocate unless the table
+ * has to grow. Each slot caches the hash of its key so that probing,
+ * growing and removing never need to call the hash function again
+ * and the equal function is only called when the hashes match.
+ *
+ * An entry is never moved further than necessary from its home slot
+ * while it is being probed for: when an insert comes across an entry
+ * that is closer to its home slot than the new entry, the two are
+ * swapped. This keeps the probe lengths short and lets a lookup stop
+ * as soon as it finds an entry that is closer to home than the key
+ * would be. Removing an entry shifts the following entries of the
+ * cluster back by one slot so that no tombstones are needed.
+ */
+
 typedef struct _Slot Slot;
 
 struct _Slot {
 	void * key;
 	void * value;
-	Slot    *next;
+	/* The mixed hash of the key. Zero means the slot is empty */
+	unsigned int hash;
 };
 
-static void * KEYMARKER_REMOVED = &KEYMARKER_REMOVED;
-
 struct _UHashTable {
 	UHashFunc      hash_func;
 	UEqualFunc     key_equal_func;
 
-	Slot **table;
+	Slot *table;
 	int   table_size;
+	/* 32 minus log2 of table_size */
+	int   shift;
 	int   in_use;
-	int   threshold;
-	int   last_rehash;
 	UDestroyNotify value_destroy_func, key_destroy_func;
 };
 
 typedef struct {
 	UHashTable *ht;
 	int slot_index;
-	Slot *slot;
 } Iter;
 
+#define MIN_TABLE_SIZE 8
+
+/* The table grows when it would become more than 7/8 full and shrinks
+ * when it is less than 1/8 full after removing entries */
+#define IS_OVERLOADED(hash, in_use) ((in_use) > (hash)->table_size - (hash)->table_size / 8)
+#define IS_UNDERLOADED(hash) ((hash)->table_size > MIN_TABLE_SIZE && (hash)->in_use < (hash)->table_size / 8)
+
 static const unsigned int prime_tbl[] = {
 	11, 19, 37, 73, 109, 163, 251, 367, 557, 823, 1237,
 	1861, 2777, 4177, 6247, 9371, 14057, 21089, 31627,
@@ -107,145 +129,239 @@ u_spaced_primes_closest (unsigned int x)
 	return calc_prime (x);
 }
 
-UHashTable *
-u_hash_table_new (UHashFunc hash_func, UEqualFunc key_equal_func)
+/* Many of the hash functions, such as u_direct_hash, leave the low
+ * bits of the hash mostly unused and can produce regular patterns so
+ * the bits are mixed with the finalizer from MurmurHash3 before the
+ * slot is taken from the top bits */
+static inline unsigned int
+mix_hash (UHashTable *hash, const void *key)
 {
-	UHashTable *hash;
+	unsigned int hashcode = (*hash->hash_func) (key);
 
-	if (hash_func == NULL)
-		hash_func = u_direct_hash;
-	if (key_equal_func == NULL)
-		key_equal_func = u_direct_equal;
-	hash = u_new0 (UHashTable, 1);
+	hashcode ^= hashcode >> 16;
+	hashcode *= 0x85ebca6bU;
+	hashcode ^= hashcode >> 13;
+	hashcode *= 0xc2b2ae35U;
+	hashcode ^= hashcode >> 16;
 
-	hash->hash_func = hash_func;
-	hash->key_equal_func = key_equal_func;
+	/* Zero is reserved for empty slots */
+	return hashcode ? hashcode : 1;
+}
 
-	hash->table_size = u_spaced_primes_closest (1);
-	hash->table = u_new0 (Slot *, hash->table_size);
-	hash->last_rehash = hash->table_size;
+static inline int
+home_slot (UHashTable *hash, unsigned int hashcode)
+{
+	return hashcode >> hash->shift;
+}
 
-	return hash;
+static inline int
+probe_distance (UHashTable *hash, unsigned int hashcode, int slot_index)
+{
+	return (slot_index - home_slot (hash, hashcode)) & (hash->table_size - 1);
 }
 
-UHashTable *
-u_hash_table_new_full (UHashFunc hash_func, UEqualFunc key_equal_func,
-		       UDestroyNotify key_destroy_func, UDestroyNotify value_destroy_func)
+static void
+alloc_table (UHashTable *hash, int table_size)
 {
-	UHashTable *hash = u_hash_table_new (hash_func, key_equal_func);
-	if (hash == NULL)
-		return NULL;
+	int shift = 32;
+	int size;
 
-	hash->key_destroy_func = key_destroy_func;
-	hash->value_destroy_func = value_destroy_func;
+	for (size = 1; size < table_size; size <<= 1)
+		shift--;
 
-	return hash;
+	hash->table = u_new0 (Slot, table_size);
+	hash->table_size = table_size;
+	hash->shift = shift;
 }
 
-#if 0
+/* Inserts an entry that is known not to be in the table yet,
+ * starting the probe at the given slot. The entry must not belong in
+ * any of the slots before it */
 static void
-dump_hash_table (UHashTable *hash)
+insert_at (UHashTable *hash, int slot_index, int distance, void *key, void *value, unsigned int hashcode)
 {
-	int i;
+	int mask = hash->table_size - 1;
+	Slot entry;
+
+	entry.key = key;
+	entry.value = value;
+	entry.hash = hashcode;
+
+	while (TRUE) {
+		Slot *s = hash->table + slot_index;
+		int s_distance;
+
+		if (s->hash == 0) {
+			*s = entry;
+			return;
+		}
 
-	for (i = 0; i < hash->table_size; i++) {
-		Slot *s;
+		/* Take the slot from any entry that is closer to its home
+		 * slot and carry on looking for a slot for that entry */
+		s_distance = probe_distance (hash, s->hash, slot_index);
+		if (s_distance < distance) {
+			Slot tmp = *s;
 
-		for (s = hash->table [i]; s != NULL; s = s->next){
-			unsigned int hashcode = (*hash->hash_func) (s->key);
-			unsigned int slot = (hashcode) % hash->table_size;
-			printf ("key %p hash %x on slot %d correct slot %d tb size %d\n", s->key, hashcode, i, slot, hash->table_size);
+			*s = entry;
+			entry = tmp;
+			distance = s_distance;
 		}
+
+		slot_index = (slot_index + 1) & mask;
+		distance++;
 	}
 }
-#endif
 
-#ifdef SANITY_CHECK
 static void
-sanity_check (UHashTable *hash)
+insert_new (UHashTable *hash, unsigned int hashcode, void *key, void *value)
+{
+	insert_at (hash, home_slot (hash, hashcode), 0, key, value, hashcode);
+}
+
+static void
+resize (UHashTable *hash, int table_size)
 {
+	Slot *old_table = hash->table;
+	int old_size = hash->table_size;
 	int i;
 
-	for (i = 0; i < hash->table_size; i++) {
-		Slot *s;
-
-		for (s = hash->table [i]; s != NULL; s = s->next){
-			unsigned int hashcode = (*hash->hash_func) (s->key);
-			unsigned int slot = (hashcode) % hash->table_size;
-			if (slot != i) {
-				dump_hashcode_func = 1;
-				hashcode = (*hash->hash_func) (s->key);
-				dump_hashcode_func = 0;
-				u_error ("Key %p (bucket %d) on invalid bucket %d (hashcode %x) (tb size %d)", s->key, slot, i, hashcode, hash->table_size);
-			}
-		}
+	alloc_table (hash, table_size);
+
+	for (i = 0; i < old_size; i++) {
+		Slot *s = old_table + i;
+
+		if (s->hash)
+			insert_new (hash, s->hash, s->key, s->value);
 	}
+
+	u_free (old_table);
 }
-#else
 
-#define sanity_check(HASH) do {}while(0)
+static void
+maybe_shrink (UHashTable *hash)
+{
+	int table_size = hash->table_size;
+
+	if (!IS_UNDERLOADED (hash))
+		return;
 
-#endif
+	while (table_size > MIN_TABLE_SIZE && hash->in_use < table_size / 4)
+		table_size >>= 1;
 
-static void
-do_rehash (UHashTable *hash)
+	resize (hash, table_size);
+}
+
+static inline Slot *
+find_slot (UHashTable *hash, const void *key, unsigned int hashcode)
 {
-	int current_size, i;
-	Slot **table;
+	UEqualFunc equal = hash->key_equal_func;
+	Slot *table = hash->table;
+	int mask = hash->table_size - 1;
+	int shift = hash->shift;
+	int slot_index = hashcode >> shift;
+	int distance;
 
-	/* printf ("Resizing diff=%d slots=%d\n", hash->in_use - hash->last_rehash, hash->table_size); */
-	hash->last_rehash = hash->table_size;
-	current_size = hash->table_size;
-	hash->table_size = u_spaced_primes_closest (hash->in_use);
-	/* printf ("New size: %d\n", hash->table_size); */
-	table = hash->table;
-	hash->table = u_new0 (Slot *, hash->table_size);
+	for (distance = 0; ; distance++) {
+		Slot *s = table + slot_index;
+		unsigned int s_hash = s->hash;
 
-	for (i = 0; i < current_size; i++){
-		Slot *s, *next;
+		if (s_hash == hashcode && (*equal) (s->key, key))
+			return s;
 
-		for (s = table [i]; s != NULL; s = next){
-			unsigned int hashcode = ((*hash->hash_func) (s->key)) % hash->table_size;
-			next = s->next;
+		/* If we reach an empty slot or an entry that is closer to
+		 * its home slot than the key would be then the key would
+		 * have been inserted here */
+		if (s_hash == 0 || ((slot_index - (int) (s_hash >> shift)) & mask) < distance)
+			return NULL;
 
-			s->next = hash->table [hashcode];
-			hash->table [hashcode] = s;
-		}
+		slot_index = (slot_index + 1) & mask;
 	}
-	u_free (table);
 }
 
+/* Removes the entry in the given slot by shifting the rest of the
+ * cluster back by one slot */
 static void
-rehash (UHashTable *hash)
+remove_slot (UHashTable *hash, int slot_index)
 {
-	int diff = ABS (hash->last_rehash - hash->in_use);
+	int mask = hash->table_size - 1;
 
-	/* These are the factors to play with to change the rehashing strategy */
-	/* I played with them with a large range, and could not really get */
-	/* something that was too good, maybe the tests are not that great */
-	if (!(diff * 0.75 > hash->table_size * 2))
-		return;
-	do_rehash (hash);
-	sanity_check (hash);
+	while (TRUE) {
+		int next_index = (slot_index + 1) & mask;
+		Slot *next = hash->table + next_index;
+
+		if (next->hash == 0 || probe_distance (hash, next->hash, next_index) == 0)
+			break;
+
+		hash->table [slot_index] = *next;
+		slot_index = next_index;
+	}
+
+	hash->table [slot_index].hash = 0;
+	hash->in_use--;
+}
+
+static void
+destroy_slot (UHashTable *hash, Slot *s)
+{
+	if (hash->key_destroy_func != NULL)
+		(*hash->key_destroy_func)(s->key);
+	if (hash->value_destroy_func != NULL)
+		(*hash->value_destroy_func)(s->value);
+}
+
+UHashTable *
+u_hash_table_new (UHashFunc hash_func, UEqualFunc key_equal_func)
+{
+	UHashTable *hash;
+
+	if (hash_func == NULL)
+		hash_func = u_direct_hash;
+	if (key_equal_func == NULL)
+		key_equal_func = u_direct_equal;
+	hash = u_new0 (UHashTable, 1);
+
+	hash->hash_func = hash_func;
+	hash->key_equal_func = key_equal_func;
+
+	alloc_table (hash, MIN_TABLE_SIZE);
+
+	return hash;
+}
+
+UHashTable *
+u_hash_table_new_full (UHashFunc hash_func, UEqualFunc key_equal_func,
+		       UDestroyNotify key_destroy_func, UDestroyNotify value_destroy_func)
+{
+	UHashTable *hash = u_hash_table_new (hash_func, key_equal_func);
+	if (hash == NULL)
+		return NULL;
+
+	hash->key_destroy_func = key_destroy_func;
+	hash->value_destroy_func = value_destroy_func;
+
+	return hash;
 }
 
 void
 u_hash_table_insert_replace (UHashTable *hash, void * key, void * value, uboolean replace)
 {
-	unsigned int hashcode;
-	Slot *s;
 	UEqualFunc equal;
+	unsigned int hashcode;
+	int mask, slot_index, distance;
 
 	u_return_if_fail (hash != NULL);
-	sanity_check (hash);
 
 	equal = hash->key_equal_func;
-	if (hash->in_use >= hash->threshold)
-		rehash (hash);
+	hashcode = mix_hash (hash, key);
+	mask = hash->table_size - 1;
+	slot_index = home_slot (hash, hashcode);
+
+	/* Look for the key and the slot where it would be inserted at the
+	 * same time */
+	for (distance = 0; ; distance++) {
+		Slot *s = hash->table + slot_index;
 
-	hashcode = ((*hash->hash_func) (key)) % hash->table_size;
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal) (s->key, key)){
+		if (s->hash == hashcode && (*equal) (s->key, key)) {
 			if (replace){
 				if (hash->key_destroy_func != NULL)
 					(*hash->key_destroy_func)(s->key);
@@ -254,17 +370,22 @@ u_hash_table_insert_replace (UHashTable *hash, void * key, void * value, uboolea
 			if (hash->value_destroy_func != NULL)
 				(*hash->value_destroy_func) (s->value);
 			s->value = value;
-			sanity_check (hash);
 			return;
 		}
+
+		if (s->hash == 0 || probe_distance (hash, s->hash, slot_index) < distance)
+			break;
+
+		slot_index = (slot_index + 1) & mask;
 	}
-	s = u_new (Slot, 1);
-	s->key = key;
-	s->value = value;
-	s->next = hash->table [hashcode];
-	hash->table [hashcode] = s;
+
+	if (IS_OVERLOADED (hash, hash->in_use + 1)) {
+		resize (hash, hash->table_size * 2);
+		insert_new (hash, hashcode, key, value);
+	} else
+		insert_at (hash, slot_index, distance, key, value, hashcode);
+
 	hash->in_use++;
-	sanity_check (hash);
 }
 
 UList*
@@ -309,37 +430,31 @@ u_hash_table_size (UHashTable *hash)
 void *
 u_hash_table_lookup (UHashTable *hash, const void * key)
 {
-	void *orig_key, *value;
+	Slot *s;
 
-	if (u_hash_table_lookup_extended (hash, key, &orig_key, &value))
-		return value;
-	else
-		return NULL;
+	u_return_val_if_fail (hash != NULL, NULL);
+
+	s = find_slot (hash, key, mix_hash (hash, key));
+
+	return s ? s->value : NULL;
 }
 
 uboolean
 u_hash_table_lookup_extended (UHashTable *hash, const void * key, void * *orig_key, void * *value)
 {
-	UEqualFunc equal;
 	Slot *s;
-	unsigned int hashcode;
 
 	u_return_val_if_fail (hash != NULL, FALSE);
-	sanity_check (hash);
-	equal = hash->key_equal_func;
 
-	hashcode = ((*hash->hash_func) (key)) % hash->table_size;
+	s = find_slot (hash, key, mix_hash (hash, key));
+	if (s == NULL)
+		return FALSE;
 
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal)(s->key, key)){
-			if (orig_key)
-				*orig_key = s->key;
-			if (value)
-				*value = s->value;
-			return TRUE;
-		}
-	}
-	return FALSE;
+	if (orig_key)
+		*orig_key = s->key;
+	if (value)
+		*value = s->value;
+	return TRUE;
 }
 
 void
@@ -351,9 +466,9 @@ u_hash_table_foreach (UHashTable *hash, UHFunc func, void * user_data)
 	u_return_if_fail (func != NULL);
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s;
+		Slot *s = hash->table + i;
 
-		for (s = hash->table [i]; s != NULL; s = s->next)
+		if (s->hash)
 			(*func)(s->key, s->value, user_data);
 	}
 }
@@ -367,11 +482,10 @@ u_hash_table_find (UHashTable *hash, UHRFunc predicate, void * user_data)
 	u_return_val_if_fail (predicate != NULL, NULL);
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s;
+		Slot *s = hash->table + i;
 
-		for (s = hash->table [i]; s != NULL; s = s->next)
-			if ((*predicate)(s->key, s->value, user_data))
-				return s->value;
+		if (s->hash && (*predicate)(s->key, s->value, user_data))
+			return s->value;
 	}
 	return NULL;
 }
@@ -379,169 +493,113 @@ u_hash_table_find (UHashTable *hash, UHRFunc predicate, void * user_data)
 void
 u_hash_table_remove_all (UHashTable *hash)
 {
-	int i;
+	Slot *old_table;
+	int old_size, i;
 
 	u_return_if_fail (hash != NULL);
 
-	for (i = 0; i < hash->table_size; i++){
-		Slot *s;
+	/* Detach the old entries first in case the destroy notifies
+	 * look at the table */
+	old_table = hash->table;
+	old_size = hash->table_size;
+	alloc_table (hash, MIN_TABLE_SIZE);
+	hash->in_use = 0;
 
-		while (hash->table [i]) {
-			s = hash->table [i];
-			u_hash_table_remove (hash, s->key);
-		}
+	for (i = 0; i < old_size; i++){
+		if (old_table [i].hash)
+			destroy_slot (hash, old_table + i);
 	}
+
+	u_free (old_table);
 }
 
-uboolean
-u_hash_table_remove (UHashTable *hash, const void * key)
+static uboolean
+remove_key (UHashTable *hash, const void * key, uboolean notify)
 {
-	UEqualFunc equal;
-	Slot *s, *last;
-	unsigned int hashcode;
+	Slot *s;
+	Slot removed;
 
 	u_return_val_if_fail (hash != NULL, FALSE);
-	sanity_check (hash);
-	equal = hash->key_equal_func;
 
-	hashcode = ((*hash->hash_func)(key)) % hash->table_size;
-	last = NULL;
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal)(s->key, key)){
-			if (hash->key_destroy_func != NULL)
-				(*hash->key_destroy_func)(s->key);
-			if (hash->value_destroy_func != NULL)
-				(*hash->value_destroy_func)(s->value);
-			if (last == NULL)
-				hash->table [hashcode] = s->next;
-			else
-				last->next = s->next;
-			u_free (s);
-			hash->in_use--;
-			sanity_check (hash);
-			return TRUE;
-		}
-		last = s;
-	}
-	sanity_check (hash);
-	return FALSE;
+	s = find_slot (hash, key, mix_hash (hash, key));
+	if (s == NULL)
+		return FALSE;
+
+	removed = *s;
+	remove_slot (hash, s - hash->table);
+
+	if (notify)
+		destroy_slot (hash, &removed);
+
+	return TRUE;
 }
 
-unsigned int
-u_hash_table_foreach_remove (UHashTable *hash, UHRFunc func, void * user_data)
+uboolean
+u_hash_table_remove (UHashTable *hash, const void * key)
 {
-	int i;
-	int count = 0;
+	return remove_key (hash, key, TRUE);
+}
 
-	u_return_val_if_fail (hash != NULL, 0);
-	u_return_val_if_fail (func != NULL, 0);
+uboolean
+u_hash_table_steal (UHashTable *hash, const void * key)
+{
+	return remove_key (hash, key, FALSE);
+}
 
-	sanity_check (hash);
-	for (i = 0; i < hash->table_size; i++){
-		Slot *s, *last;
+static unsigned int
+foreach_remove (UHashTable *hash, UHRFunc func, void * user_data, uboolean notify)
+{
+	int mask = hash->table_size - 1;
+	int start, i;
+	int count = 0;
 
-		last = NULL;
-		for (s = hash->table [i]; s != NULL; ){
-			if ((*func)(s->key, s->value, user_data)){
-				Slot *n;
+	/* Start at the beginning of a cluster. The entries that remove_slot
+	 * shifts back can then never wrap around to a slot that has
+	 * already been visited */
+	for (start = 0; start < hash->table_size; start++){
+		Slot *s = hash->table + start;
 
-				if (hash->key_destroy_func != NULL)
-					(*hash->key_destroy_func)(s->key);
-				if (hash->value_destroy_func != NULL)
-					(*hash->value_destroy_func)(s->value);
-				if (last == NULL){
-					hash->table [i] = s->next;
-					n = s->next;
-				} else  {
-					last->next = s->next;
-					n = last->next;
-				}
-				u_free (s);
-				hash->in_use--;
-				count++;
-				s = n;
-			} else {
-				last = s;
-				s = s->next;
-			}
+		if (s->hash == 0 || probe_distance (hash, s->hash, start) == 0)
+			break;
+	}
+
+	for (i = 0; i < hash->table_size; i++){
+		int slot_index = (start + i) & mask;
+		Slot *s = hash->table + slot_index;
+
+		/* Removing an entry can shift the next entry into this slot
+		 * so keep checking the same slot */
+		while (s->hash && (*func)(s->key, s->value, user_data)){
+			Slot removed = *s;
+
+			remove_slot (hash, slot_index);
+			if (notify)
+				destroy_slot (hash, &removed);
+			count++;
 		}
 	}
-	sanity_check (hash);
+
 	if (count > 0)
-		rehash (hash);
+		maybe_shrink (hash);
 	return count;
 }
 
-uboolean
-u_hash_table_steal (UHashTable *hash, const void * key)
+unsigned int
+u_hash_table_foreach_remove (UHashTable *hash, UHRFunc func, void * user_data)
 {
-	UEqualFunc equal;
-	Slot *s, *last;
-	unsigned int hashcode;
-
-	u_return_val_if_fail (hash != NULL, FALSE);
-	sanity_check (hash);
-	equal = hash->key_equal_func;
-
-	hashcode = ((*hash->hash_func)(key)) % hash->table_size;
-	last = NULL;
-	for (s = hash->table [hashcode]; s != NULL; s = s->next){
-		if ((*equal)(s->key, key)) {
-			if (last == NULL)
-				hash->table [hashcode] = s->next;
-			else
-				last->next = s->next;
-			u_free (s);
-			hash->in_use--;
-			sanity_check (hash);
-			return TRUE;
-		}
-		last = s;
-	}
-	sanity_check (hash);
-	return FALSE;
+	u_return_val_if_fail (hash != NULL, 0);
+	u_return_val_if_fail (func != NULL, 0);
 
+	return foreach_remove (hash, func, user_data, TRUE);
 }
 
 unsigned int
 u_hash_table_foreach_steal (UHashTable *hash, UHRFunc func, void * user_data)
 {
-	int i;
-	int count = 0;
-
 	u_return_val_if_fail (hash != NULL, 0);
 	u_return_val_if_fail (func != NULL, 0);
 
-	sanity_check (hash);
-	for (i = 0; i < hash->table_size; i++){
-		Slot *s, *last;
-
-		last = NULL;
-		for (s = hash->table [i]; s != NULL; ){
-			if ((*func)(s->key, s->value, user_data)){
-				Slot *n;
-
-				if (last == NULL){
-					hash->table [i] = s->next;
-					n = s->next;
-				} else  {
-					last->next = s->next;
-					n = last->next;
-				}
-				u_free (s);
-				hash->in_use--;
-				count++;
-				s = n;
-			} else {
-				last = s;
-				s = s->next;
-			}
-		}
-	}
-	sanity_check (hash);
-	if (count > 0)
-		rehash (hash);
-	return count;
+	return foreach_remove (hash, func, user_data, FALSE);
 }
 
 void
@@ -552,17 +610,8 @@ u_hash_table_destroy (UHashTable *hash)
 	u_return_if_fail (hash != NULL);
 
 	for (i = 0; i < hash->table_size; i++){
-		Slot *s, *next;
-
-		for (s = hash->table [i]; s != NULL; s = next){
-			next = s->next;
-
-			if (hash->key_destroy_func != NULL)
-				(*hash->key_destroy_func)(s->key);
-			if (hash->value_destroy_func != NULL)
-				(*hash->value_destroy_func)(s->value);
-			u_free (s);
-		}
+		if (hash->table [i].hash)
+			destroy_slot (hash, hash->table + i);
 	}
 	u_free (hash->table);
 
@@ -572,22 +621,29 @@ u_hash_table_destroy (UHashTable *hash)
 void
 u_hash_table_print_stats (UHashTable *table)
 {
-	int i, max_chain_index, chain_size, max_chain_size;
-	Slot *node;
+	int i, max_distance_index, distance, max_distance, total_distance;
 
-	max_chain_size = 0;
-	max_chain_index = -1;
+	max_distance = 0;
+	max_distance_index = -1;
+	total_distance = 0;
 	for (i = 0; i < table->table_size; i++) {
-		chain_size = 0;
-		for (node = table->table [i]; node; node = node->next)
-			chain_size ++;
-		if (chain_size > max_chain_size) {
-			max_chain_size = chain_size;
-			max_chain_index = i;
+		Slot *s = table->table + i;
+
+		if (s->hash == 0)
+			continue;
+
+		distance = probe_distance (table, s->hash, i);
+		total_distance += distance;
+		if (distance > max_distance) {
+			max_distance = distance;
+			max_distance_index = i;
 		}
 	}
 
-	printf ("Size: %d Table Size: %d Max Chain Length: %d at %d\n", table->in_use, table->table_size, max_chain_size, max_chain_index);
+	printf ("Size: %d Table Size: %d Mean Probe Distance: %.2f Max Probe Distance: %d at %d\n",
+		table->in_use, table->table_size,
+		table->in_use ? (double) total_distance / table->in_use : 0.0,
+		max_distance, max_distance_index);
 }
 
 void
@@ -609,24 +665,20 @@ uboolean u_hash_table_iter_next (UHashTableIter *it, void * *key, void * *value)
 	u_assert (iter->slot_index != -2);
 	u_assert (sizeof (Iter) <= sizeof (UHashTableIter));
 
-	if (!iter->slot) {
-		while (TRUE) {
-			iter->slot_index ++;
-			if (iter->slot_index >= hash->table_size) {
-				iter->slot_index = -2;
-				return FALSE;
-			}
-			if (hash->table [iter->slot_index])
-				break;
+	while (TRUE) {
+		iter->slot_index ++;
+		if (iter->slot_index >= hash->table_size) {
+			iter->slot_index = -2;
+			return FALSE;
 		}
-		iter->slot = hash->table [iter->slot_index];
+		if (hash->table [iter->slot_index].hash)
+			break;
 	}
 
 	if (key)
-		*key = iter->slot->key;
+		*key = hash->table [iter->slot_index].key;
 	if (value)
-		*value = iter->slot->value;
-	iter->slot = iter->slot->next;
+		*value = hash->table [iter->slot_index].value;
 
 	return TRUE;
 }
@@ -195,14 +195,30 @@ void * u_memdup (const void * mem, unsigned int byte_size);
 #define u_renew(struct_type, mem, n_structs) u_realloc (mem, sizeof (struct_type) * n_structs)
 #define u_alloca(size)		alloca (size)
 
-#define u_slice_new(type)         ((type *) u_malloc (sizeof (type)))
-#define u_slice_new0(type)        ((type *) u_malloc0 (sizeof (type)))
-#define u_slice_free(type, mem)   u_free (mem)
-#define u_slice_free1(size, mem)  u_free (mem)
-#define u_slice_alloc(size)       u_malloc (size)
-#define u_slice_alloc0(size)      u_malloc0 (size)
-#define u_slice_dup(type, mem)    u_memdup (mem, sizeof (type))
-#define u_slice_copy(size, mem)   u_memdup (mem, size)
+/*
+ * Slices
+ *
+ * Memory allocated with u_slice_alloc() must be freed with
+ * u_slice_free1() with the same size.
+ */
+void * u_slice_alloc (size_t size);
+void * u_slice_alloc0 (size_t size);
+void * u_slice_copy (size_t size, const void *mem);
+void   u_slice_free1 (size_t size, void *mem);
+
+#define u_slice_new(type)         ((type *) u_slice_alloc (sizeof (type)))
+#define u_slice_new0(type)        ((type *) u_slice_alloc0 (sizeof (type)))
+#define u_slice_free(type, mem)   u_slice_free1 (sizeof (type), (mem))
+#define u_slice_dup(type, mem)    ((type *) u_slice_copy (sizeof (type), (mem)))
+
+typedef struct {
+	size_t chunk_size;	/* the largest allocation in the size class */
+	size_t n_live;		/* slices currently allocated */
+	size_t high_water;	/* the highest value n_live has reached */
+} USliceStats;
+
+int  u_slice_get_n_size_classes (void);
+void u_slice_get_stats (int size_class, USliceStats *stats);
 
 static inline char   *u_strdup (const char *str) { if (str) {return strdup (str);} return NULL; }
 char **u_strdupv (char **str_array);
@@ -0,0 +1,417 @@
+/*
+ * uslice.c: Slab allocator for small, fixed size allocations
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <ulib.h>
+
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+/*
+ * Slices are grouped into size classes that are a multiple of
+ * U_SLICE_ALIGNMENT bytes. Each size class has a free list of
+ * chunks and carves new chunks out of blocks of U_SLICE_BLOCK_SIZE
+ * bytes when the free list is empty. Blocks are never returned to the
+ * system, the same as with CoglMagazine, because the objects
+ * allocated through this API tend to be allocated and freed at a
+ * steady rate.
+ *
+ * To avoid taking the global lock for every allocation each thread
+ * also keeps a small magazine of free chunks per size class. The
+ * magazines are refilled from and flushed to the global free lists
+ * in batches.
+ *
+ * Setting the U_SLICE environment variable to "always-malloc" makes
+ * every slice come straight from u_malloc which can be useful with
+ * tools like valgrind. "disable-magazines" keeps the slab allocator
+ * but takes the global lock for every allocation.
+ *
+ * Allocations larger than U_SLICE_MAX_SIZE are passed on to
+ * u_malloc. The slab allocator is also only used if pthreads is
+ * available because otherwise it can't be made thread safe.
+ */
+
+#define U_SLICE_ALIGNMENT (2 * sizeof (void *))
+#define U_SLICE_MAX_SIZE 512
+#define U_SLICE_N_CLASSES (U_SLICE_MAX_SIZE / U_SLICE_ALIGNMENT)
+#define U_SLICE_BLOCK_SIZE 8192
+
+/* The maximum number of free chunks kept in each thread's magazine
+ * for a size class. When the magazine is empty it is refilled with
+ * half this number of chunks and when it overflows half of the
+ * chunks are returned to the global free list */
+#define U_SLICE_MAGAZINE_SIZE 32
+
+#define U_SLICE_SIZE_CLASS(size) (((size) - 1) / U_SLICE_ALIGNMENT)
+
+typedef enum
+{
+  U_SLICE_ALWAYS_MALLOC = 1 << 0,
+  U_SLICE_DISABLE_MAGAZINES = 1 << 1
+} USliceFlags;
+
+#ifdef HAVE_PTHREADS
+
+typedef struct _USliceChunk USliceChunk;
+
+struct _USliceChunk
+{
+  USliceChunk *next;
+};
+
+typedef struct
+{
+  USliceChunk *free_list;
+
+  /* The remaining space in the last block that was allocated for
+   * this size class */
+  char *block_pos;
+  char *block_end;
+
+  size_t n_live;
+  size_t high_water;
+} USliceClass;
+
+typedef struct
+{
+  USliceChunk *head;
+  int n_chunks;
+} USliceMagazine;
+
+typedef struct
+{
+  USliceMagazine magazines[U_SLICE_N_CLASSES];
+} USliceThreadCache;
+
+static USliceClass slice_classes[U_SLICE_N_CLASSES];
+static pthread_mutex_t slice_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t slice_once = PTHREAD_ONCE_INIT;
+static pthread_key_t slice_thread_cache_key;
+static unsigned int slice_flags;
+
+static USliceChunk *
+slice_class_alloc_locked (int size_class)
+{
+  USliceClass *class = slice_classes + size_class;
+  size_t chunk_size = (size_class + 1) * U_SLICE_ALIGNMENT;
+  USliceChunk *chunk;
+
+  if (class->free_list)
+    {
+      chunk = class->free_list;
+      class->free_list = chunk->next;
+      return chunk;
+    }
+
+  if (class->block_pos + chunk_size > class->block_end)
+    {
+      class->block_pos = u_malloc (U_SLICE_BLOCK_SIZE);
+      class->block_end = class->block_pos + U_SLICE_BLOCK_SIZE;
+    }
+
+  chunk = (USliceChunk *) class->block_pos;
+  class->block_pos += chunk_size;
+
+  return chunk;
+}
+
+static void
+slice_magazine_flush_locked (USliceMagazine *magazine,
+                             int size_class,
+                             int n_chunks)
+{
+  USliceClass *class = slice_classes + size_class;
+
+  while (n_chunks-- > 0 && magazine->head)
+    {
+      USliceChunk *chunk = magazine->head;
+
+      magazine->head = chunk->next;
+      magazine->n_chunks--;
+
+      chunk->next = class->free_list;
+      class->free_list = chunk;
+    }
+}
+
+static void
+slice_thread_cache_free (void *data)
+{
+  USliceThreadCache *cache = data;
+  int i;
+
+  pthread_mutex_lock (&slice_lock);
+
+  for (i = 0; i < U_SLICE_N_CLASSES; i++)
+    slice_magazine_flush_locked (cache->magazines + i,
+                                 i,
+                                 cache->magazines[i].n_chunks);
+
+  pthread_mutex_unlock (&slice_lock);
+
+  free (cache);
+}
+
+static void
+slice_init (void)
+{
+  static const UDebugKey keys[] =
+    {
+      { "always-malloc", U_SLICE_ALWAYS_MALLOC },
+      { "disable-magazines", U_SLICE_DISABLE_MAGAZINES }
+    };
+  const char *env = u_getenv ("U_SLICE");
+
+  if (env)
+    slice_flags = u_parse_debug_string (env, keys, U_N_ELEMENTS (keys));
+
+  pthread_key_create (&slice_thread_cache_key, slice_thread_cache_free);
+}
+
+static USliceThreadCache *
+slice_get_thread_cache (void)
+{
+  USliceThreadCache *cache;
+
+  if ((slice_flags & U_SLICE_DISABLE_MAGAZINES))
+    return NULL;
+
+  cache = pthread_getspecific (slice_thread_cache_key);
+
+  if (U_UNLIKELY (cache == NULL))
+    {
+      /* This can't be allocated with u_malloc because that aborts on
+       * failure and we can just fall back to the global free list */
+      cache = calloc (1, sizeof (USliceThreadCache));
+      if (cache)
+        pthread_setspecific (slice_thread_cache_key, cache);
+    }
+
+  return cache;
+}
+
+static void
+slice_update_stats (int size_class, int delta)
+{
+  USliceClass *class = slice_classes + size_class;
+  size_t n_live = __sync_add_and_fetch (&class->n_live, delta);
+  size_t high_water = class->high_water;
+
+  while (n_live > high_water)
+    {
+      size_t old = __sync_val_compare_and_swap (&class->high_water,
+                                                high_water,
+                                                n_live);
+      if (old == high_water)
+        break;
+      high_water = old;
+    }
+}
+
+void *
+u_slice_alloc (size_t size)
+{
+  USliceThreadCache *cache;
+  USliceChunk *chunk;
+  int size_class;
+
+  pthread_once (&slice_once, slice_init);
+
+  if (size == 0 || size > U_SLICE_MAX_SIZE ||
+      (slice_flags & U_SLICE_ALWAYS_MALLOC))
+    return u_malloc (size);
+
+  size_class = U_SLICE_SIZE_CLASS (size);
+  cache = slice_get_thread_cache ();
+
+  if (cache)
+    {
+      USliceMagazine *magazine = cache->magazines + size_class;
+
+      if (U_UNLIKELY (magazine->head == NULL))
+        {
+          int i;
+
+          pthread_mutex_lock (&slice_lock);
+
+          for (i = 0; i < U_SLICE_MAGAZINE_SIZE / 2; i++)
+            {
+              chunk = slice_class_alloc_locked (size_class);
+              chunk->next = magazine->head;
+              magazine->head = chunk;
+            }
+
+          pthread_mutex_unlock (&slice_lock);
+
+          magazine->n_chunks = U_SLICE_MAGAZINE_SIZE / 2;
+        }
+
+      chunk = magazine->head;
+      magazine->head = chunk->next;
+      magazine->n_chunks--;
+    }
+  else
+    {
+      pthread_mutex_lock (&slice_lock);
+      chunk = slice_class_alloc_locked (size_class);
+      pthread_mutex_unlock (&slice_lock);
+    }
+
+  slice_update_stats (size_class, 1);
+
+  return chunk;
+}
+
+void
+u_slice_free1 (size_t size, void *mem)
+{
+  USliceThreadCache *cache;
+  USliceChunk *chunk = mem;
+  int size_class;
+
+  if (mem == NULL)
+    return;
+
+  pthread_once (&slice_once, slice_init);
+
+  if (size == 0 || size > U_SLICE_MAX_SIZE ||
+      (slice_flags & U_SLICE_ALWAYS_MALLOC))
+    {
+      u_free (mem);
+      return;
+    }
+
+  size_class = U_SLICE_SIZE_CLASS (size);
+  cache = slice_get_thread_cache ();
+
+  slice_update_stats (size_class, -1);
+
+  if (cache)
+    {
+      USliceMagazine *magazine = cache->magazines + size_class;
+
+      chunk->next = magazine->head;
+      magazine->head = chunk;
+
+      if (U_UNLIKELY (++magazine->n_chunks > U_SLICE_MAGAZINE_SIZE))
+        {
+          pthread_mutex_lock (&slice_lock);
+          slice_magazine_flush_locked (magazine,
+                                       size_class,
+                                       U_SLICE_MAGAZINE_SIZE / 2);
+          pthread_mutex_unlock (&slice_lock);
+        }
+    }
+  else
+    {
+      USliceClass *class = slice_classes + size_class;
+
+      pthread_mutex_lock (&slice_lock);
+      chunk->next = class->free_list;
+      class->free_list = chunk;
+      pthread_mutex_unlock (&slice_lock);
+    }
+}
+
+int
+u_slice_get_n_size_classes (void)
+{
+  return U_SLICE_N_CLASSES;
+}
+
+void
+u_slice_get_stats (int size_class, USliceStats *stats)
+{
+  USliceClass *class;
+
+  u_return_if_fail (size_class >= 0 && size_class < U_SLICE_N_CLASSES);
+
+  class = slice_classes + size_class;
+
+  stats->chunk_size = (size_class + 1) * U_SLICE_ALIGNMENT;
+  stats->n_live = __sync_add_and_fetch (&class->n_live, 0);
+  stats->high_water = __sync_add_and_fetch (&class->high_water, 0);
+}
+
+#else /* HAVE_PTHREADS */
+
+void *
+u_slice_alloc (size_t size)
+{
+  return u_malloc (size);
+}
+
+void
+u_slice_free1 (size_t size, void *mem)
+{
+  u_free (mem);
+}
+
+int
+u_slice_get_n_size_classes (void)
+{
+  return U_SLICE_N_CLASSES;
+}
+
+void
+u_slice_get_stats (int size_class, USliceStats *stats)
+{
+  u_return_if_fail (size_class >= 0 && size_class < U_SLICE_N_CLASSES);
+
+  stats->chunk_size = (size_class + 1) * U_SLICE_ALIGNMENT;
+  stats->n_live = 0;
+  stats->high_water = 0;
+}
+
+#endif /* HAVE_PTHREADS */
+
+void *
+u_slice_alloc0 (size_t size)
+{
+  void *mem = u_slice_alloc (size);
+
+  if (mem)
+    memset (mem, 0, size);
+
+  return mem;
+}
+
+void *
+u_slice_copy (size_t size, const void *mem)
+{
+  void *copy;
+
+  if (mem == NULL)
+    return NULL;
+
+  copy = u_slice_alloc (size);
+  if (copy)
+    memcpy (copy, mem, size);
+
+  return copy;
+}
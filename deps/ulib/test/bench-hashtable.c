@@ -0,0 +1,395 @@
+/*
+ * Compares the performance of UHashTable against the chained hash
+ * table that ulib used before it switched to open addressing.
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ulib.h>
+
+/*
+ * A copy of the core of the old chained implementation so that the
+ * two can be compared. It allocates a Slot for every entry and picks
+ * the bucket with a prime modulus.
+ */
+
+typedef struct _ChainedSlot ChainedSlot;
+
+struct _ChainedSlot {
+	void *key;
+	void *value;
+	ChainedSlot *next;
+};
+
+typedef struct {
+	UHashFunc hash_func;
+	UEqualFunc key_equal_func;
+
+	ChainedSlot **table;
+	int table_size;
+	int in_use;
+	int last_rehash;
+} ChainedHashTable;
+
+static ChainedHashTable *
+chained_new (UHashFunc hash_func, UEqualFunc key_equal_func)
+{
+	ChainedHashTable *hash = u_new0 (ChainedHashTable, 1);
+
+	hash->hash_func = hash_func;
+	hash->key_equal_func = key_equal_func;
+	hash->table_size = u_spaced_primes_closest (1);
+	hash->table = u_new0 (ChainedSlot *, hash->table_size);
+	hash->last_rehash = hash->table_size;
+
+	return hash;
+}
+
+static void
+chained_rehash (ChainedHashTable *hash)
+{
+	int diff = ABS (hash->last_rehash - hash->in_use);
+	int current_size, i;
+	ChainedSlot **table;
+
+	if (!(diff * 0.75 > hash->table_size * 2))
+		return;
+
+	hash->last_rehash = hash->table_size;
+	current_size = hash->table_size;
+	hash->table_size = u_spaced_primes_closest (hash->in_use);
+	table = hash->table;
+	hash->table = u_new0 (ChainedSlot *, hash->table_size);
+
+	for (i = 0; i < current_size; i++) {
+		ChainedSlot *s, *next;
+
+		for (s = table [i]; s != NULL; s = next) {
+			unsigned int hashcode = ((*hash->hash_func) (s->key)) % hash->table_size;
+			next = s->next;
+
+			s->next = hash->table [hashcode];
+			hash->table [hashcode] = s;
+		}
+	}
+	u_free (table);
+}
+
+static void
+chained_insert (ChainedHashTable *hash, void *key, void *value)
+{
+	unsigned int hashcode;
+	ChainedSlot *s;
+
+	/* The old table had a threshold that was always zero so it
+	 * checked whether to rehash on every insert */
+	chained_rehash (hash);
+
+	hashcode = ((*hash->hash_func) (key)) % hash->table_size;
+	for (s = hash->table [hashcode]; s != NULL; s = s->next) {
+		if ((*hash->key_equal_func) (s->key, key)) {
+			s->value = value;
+			return;
+		}
+	}
+	s = u_new (ChainedSlot, 1);
+	s->key = key;
+	s->value = value;
+	s->next = hash->table [hashcode];
+	hash->table [hashcode] = s;
+	hash->in_use++;
+}
+
+static void *
+chained_lookup (ChainedHashTable *hash, const void *key)
+{
+	unsigned int hashcode = ((*hash->hash_func) (key)) % hash->table_size;
+	ChainedSlot *s;
+
+	for (s = hash->table [hashcode]; s != NULL; s = s->next)
+		if ((*hash->key_equal_func) (s->key, key))
+			return s->value;
+
+	return NULL;
+}
+
+static uboolean
+chained_remove (ChainedHashTable *hash, const void *key)
+{
+	unsigned int hashcode = ((*hash->hash_func) (key)) % hash->table_size;
+	ChainedSlot *s, *last = NULL;
+
+	for (s = hash->table [hashcode]; s != NULL; s = s->next) {
+		if ((*hash->key_equal_func) (s->key, key)) {
+			if (last == NULL)
+				hash->table [hashcode] = s->next;
+			else
+				last->next = s->next;
+			u_free (s);
+			hash->in_use--;
+			return TRUE;
+		}
+		last = s;
+	}
+	return FALSE;
+}
+
+static void
+chained_destroy (ChainedHashTable *hash)
+{
+	int i;
+
+	for (i = 0; i < hash->table_size; i++) {
+		ChainedSlot *s, *next;
+
+		for (s = hash->table [i]; s != NULL; s = next) {
+			next = s->next;
+			u_free (s);
+		}
+	}
+	u_free (hash->table);
+	u_free (hash);
+}
+
+/*
+ * The benchmark
+ */
+
+/* Small tables are rebuilt this many times over so that the timings
+ * cover enough operations to be measurable */
+#define MIN_OPS 1000000
+#define N_LOOKUP_ROUNDS 10
+
+typedef enum {
+	KEY_TYPE_POINTER,
+	KEY_TYPE_RANDOM,
+	KEY_TYPE_STRING
+} KeyType;
+
+typedef struct {
+	const char *name;
+	void * (* new) (UHashFunc hash_func, UEqualFunc key_equal_func);
+	void (* insert) (void *hash, void *key, void *value);
+	void * (* lookup) (void *hash, const void *key);
+	uboolean (* remove) (void *hash, const void *key);
+	void (* destroy) (void *hash);
+} Implementation;
+
+typedef struct {
+	double insert;
+	double lookup;
+	double miss;
+	double remove;
+} Timings;
+
+static void *
+u_hash_table_new_wrapper (UHashFunc hash_func, UEqualFunc key_equal_func)
+{
+	return u_hash_table_new (hash_func, key_equal_func);
+}
+
+static void
+u_hash_table_insert_wrapper (void *hash, void *key, void *value)
+{
+	u_hash_table_insert (hash, key, value);
+}
+
+static const Implementation implementations[] = {
+	{
+		"chained",
+		(void *) chained_new,
+		(void *) chained_insert,
+		(void *) chained_lookup,
+		(void *) chained_remove,
+		(void *) chained_destroy
+	},
+	{
+		"UHashTable",
+		u_hash_table_new_wrapper,
+		u_hash_table_insert_wrapper,
+		(void *) u_hash_table_lookup,
+		(void *) u_hash_table_remove,
+		(void *) u_hash_table_destroy
+	}
+};
+
+static void **
+make_keys (KeyType key_type, int n_keys, int offset)
+{
+	void **keys = u_new (void *, n_keys);
+	unsigned int seed = offset + 1;
+	int i;
+
+	for (i = 0; i < n_keys; i++) {
+		switch (key_type) {
+		case KEY_TYPE_POINTER:
+			/* Keys like the addresses of small objects */
+			keys [i] = u_malloc (48);
+			break;
+		case KEY_TYPE_RANDOM:
+			/* Keys like the hashes of pipeline state */
+			seed = seed * 1664525 + 1013904223;
+			keys [i] = U_UINT_TO_POINTER (seed);
+			break;
+		case KEY_TYPE_STRING:
+			keys [i] = u_strdup_printf ("key-%d", i + offset);
+			break;
+		}
+	}
+
+	return keys;
+}
+
+/* Returns a copy of the keys in a random order so that the lookups
+ * don't just walk through the table in order */
+static void **
+shuffle_keys (void **keys, int n_keys)
+{
+	void **shuffled = u_memdup (keys, sizeof (void *) * n_keys);
+	unsigned int seed = 12345;
+	int i;
+
+	for (i = n_keys - 1; i > 0; i--) {
+		int j;
+		void *tmp;
+
+		seed = seed * 1103515245 + 12345;
+		j = (seed >> 8) % (i + 1);
+		tmp = shuffled [i];
+		shuffled [i] = shuffled [j];
+		shuffled [j] = tmp;
+	}
+
+	return shuffled;
+}
+
+static void
+free_keys (KeyType key_type, void **keys, int n_keys)
+{
+	int i;
+
+	if (key_type != KEY_TYPE_RANDOM)
+		for (i = 0; i < n_keys; i++)
+			u_free (keys [i]);
+	u_free (keys);
+}
+
+static void
+run_benchmark (const Implementation *impl,
+	       KeyType key_type,
+	       void **keys, void **missing_keys, int n_keys,
+	       Timings *timings)
+{
+	UHashFunc hash_func = key_type == KEY_TYPE_STRING ? u_str_hash : u_direct_hash;
+	UEqualFunc key_equal_func = key_type == KEY_TYPE_STRING ? u_str_equal : u_direct_equal;
+	void **lookup_keys = shuffle_keys (keys, n_keys);
+	int n_rounds = MAX (1, MIN_OPS / n_keys);
+	UTimer *timer = u_timer_new ();
+	int round, i, j;
+
+	memset (timings, 0, sizeof (Timings));
+
+	for (round = 0; round < n_rounds; round++) {
+		void *hash = impl->new (hash_func, key_equal_func);
+
+		u_timer_start (timer);
+		for (i = 0; i < n_keys; i++)
+			impl->insert (hash, keys [i], keys [i]);
+		timings->insert += u_timer_elapsed (timer, NULL);
+
+		u_timer_start (timer);
+		for (j = 0; j < N_LOOKUP_ROUNDS; j++)
+			for (i = 0; i < n_keys; i++)
+				if (impl->lookup (hash, lookup_keys [i]) != lookup_keys [i])
+					u_error ("Lookup failed");
+		timings->lookup += u_timer_elapsed (timer, NULL);
+
+		u_timer_start (timer);
+		for (j = 0; j < N_LOOKUP_ROUNDS; j++)
+			for (i = 0; i < n_keys; i++)
+				if (impl->lookup (hash, missing_keys [i]))
+					u_error ("Lookup of a missing key succeeded");
+		timings->miss += u_timer_elapsed (timer, NULL);
+
+		u_timer_start (timer);
+		for (i = 0; i < n_keys; i++)
+			impl->remove (hash, lookup_keys [i]);
+		timings->remove += u_timer_elapsed (timer, NULL);
+
+		impl->destroy (hash);
+	}
+
+	/* Convert to nanoseconds per operation */
+	timings->insert *= 1e9 / ((double) n_keys * n_rounds);
+	timings->lookup *= 1e9 / ((double) n_keys * n_rounds * N_LOOKUP_ROUNDS);
+	timings->miss *= 1e9 / ((double) n_keys * n_rounds * N_LOOKUP_ROUNDS);
+	timings->remove *= 1e9 / ((double) n_keys * n_rounds);
+
+	u_timer_destroy (timer);
+	u_free (lookup_keys);
+}
+
+int
+main (int argc, char **argv)
+{
+	static const char *key_type_names[] = { "pointer", "random", "string" };
+	static const int n_keys[] = { 100, 10000, 1000000 };
+	KeyType key_type;
+	int i, j;
+
+	printf ("Time per operation:\n");
+
+	for (key_type = 0; key_type < U_N_ELEMENTS (key_type_names); key_type++) {
+		for (i = 0; i < U_N_ELEMENTS (n_keys); i++) {
+			void **keys = make_keys (key_type, n_keys [i], 0);
+			void **missing_keys = make_keys (key_type, n_keys [i], n_keys [i]);
+
+			printf ("%s keys, %d entries:\n", key_type_names [key_type], n_keys [i]);
+
+			for (j = 0; j < U_N_ELEMENTS (implementations); j++) {
+				Timings timings;
+
+				run_benchmark (implementations + j, key_type,
+					       keys, missing_keys, n_keys [i],
+					       &timings);
+
+				printf ("  %-10s insert %7.1fns  lookup %7.1fns  "
+					"miss %7.1fns  remove %7.1fns\n",
+					implementations [j].name,
+					timings.insert,
+					timings.lookup,
+					timings.miss,
+					timings.remove);
+			}
+
+			free_keys (key_type, missing_keys, n_keys [i]);
+			free_keys (key_type, keys, n_keys [i]);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
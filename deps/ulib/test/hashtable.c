@@ -163,6 +163,73 @@ RESULT hash_iter (void)
 #endif
 }
 
+static uboolean
+remove_odd (void * key, void * value, void * user_data)
+{
+	return ((U_POINTER_TO_UINT (key) >> 4) & 1) != 0;
+}
+
+static void
+count_destroy (void * data)
+{
+	(*(int *) data)++;
+}
+
+RESULT hash_remove (void)
+{
+	int n_destroyed = 0;
+	UHashTable *hash = u_hash_table_new_full (u_direct_hash, u_direct_equal, NULL, count_destroy);
+	int i;
+
+	/* Use keys with the low bits set to zero like pointers would have */
+	for (i = 0; i < 2000; i++)
+		u_hash_table_insert (hash, U_UINT_TO_POINTER (i << 4), &n_destroyed);
+
+	for (i = 0; i < 2000; i += 4) {
+		if (!u_hash_table_remove (hash, U_UINT_TO_POINTER (i << 4)))
+			return FAILED ("Did not remove %d", i);
+		if (u_hash_table_remove (hash, U_UINT_TO_POINTER (i << 4)))
+			return FAILED ("Removed %d twice", i);
+	}
+	if (n_destroyed != 500)
+		return FAILED ("Expected 500 values to be destroyed, got %d", n_destroyed);
+
+	for (i = 1; i < 2000; i += 4) {
+		if (!u_hash_table_steal (hash, U_UINT_TO_POINTER (i << 4)))
+			return FAILED ("Did not steal %d", i);
+	}
+	if (n_destroyed != 500)
+		return FAILED ("Stealing should not destroy the values");
+
+	for (i = 0; i < 2000; i++) {
+		uboolean found = u_hash_table_lookup (hash, U_UINT_TO_POINTER (i << 4)) != NULL;
+
+		if (found != (i % 4 >= 2))
+			return FAILED ("Unexpected lookup result for %d", i);
+	}
+
+	/* Put all of the keys back and remove the odd ones in one go */
+	for (i = 0; i < 2000; i++)
+		u_hash_table_replace (hash, U_UINT_TO_POINTER (i << 4), &n_destroyed);
+	n_destroyed = 0;
+	if (u_hash_table_foreach_remove (hash, remove_odd, NULL) != 1000)
+		return FAILED ("foreach_remove did not remove all of the odd keys");
+	if (n_destroyed != 1000)
+		return FAILED ("Expected 1000 values to be destroyed, got %d", n_destroyed);
+	if (u_hash_table_size (hash) != 1000)
+		return FAILED ("Expected 1000 keys to be left, got %d", u_hash_table_size (hash));
+
+	for (i = 0; i < 2000; i++) {
+		uboolean found = u_hash_table_lookup (hash, U_UINT_TO_POINTER (i << 4)) != NULL;
+
+		if (found != ((i & 1) == 0))
+			return FAILED ("Unexpected lookup result for %d after foreach_remove", i);
+	}
+
+	u_hash_table_destroy (hash);
+	return OK;
+}
+
 static Test hashtable_tests [] = {
 	{"t1", hash_t1},
 	{"t2", hash_t2},
@@ -170,6 +237,7 @@ static Test hashtable_tests [] = {
 	{"default", hash_default},
 	{"null_lookup", hash_null_lookup},
 	{"iter", hash_iter},
+	{"remove", hash_remove},
 	{NULL, NULL}
 };
 
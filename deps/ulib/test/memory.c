@@ -30,9 +30,69 @@ test_memory_zero_size_allocations ()
         return OK;
 }
 
+RESULT
+test_memory_slices ()
+{
+	USliceStats before, during, after;
+	void *slices[100];
+	char *large, *copy;
+	int size_class, i, j;
+
+	/* 24 bytes will be in the same size class as 17 bytes on both
+	 * 32-bit and 64-bit platforms */
+	for (size_class = 0; size_class < u_slice_get_n_size_classes (); size_class++) {
+		u_slice_get_stats (size_class, &before);
+		if (before.chunk_size >= 24)
+			break;
+	}
+
+	for (i = 0; i < 100; i++) {
+		slices[i] = u_slice_alloc0 (17);
+		for (j = 0; j < 17; j++)
+			if (((char *) slices[i])[j])
+				return FAILED ("u_slice_alloc0 returned memory that isn't cleared");
+		memset (slices[i], i, 17);
+	}
+
+	u_slice_get_stats (size_class, &during);
+
+	for (i = 0; i < 100; i++) {
+		for (j = 0; j < 17; j++)
+			if (((unsigned char *) slices[i])[j] != i)
+				return FAILED ("Slice %d was overwritten", i);
+		u_slice_free1 (17, slices[i]);
+	}
+
+	u_slice_get_stats (size_class, &after);
+
+	if (during.n_live != 0 || during.high_water != 0) {
+		/* The stats are only tracked when the slab allocator is used */
+		if (during.n_live != before.n_live + 100)
+			return FAILED ("Expected %d live slices, got %d",
+				       (int) before.n_live + 100, (int) during.n_live);
+		if (during.high_water < during.n_live)
+			return FAILED ("The high-water mark is lower than the live count");
+		if (after.n_live != before.n_live)
+			return FAILED ("Expected %d live slices after freeing, got %d",
+				       (int) before.n_live, (int) after.n_live);
+		if (after.high_water != during.high_water)
+			return FAILED ("The high-water mark changed after freeing");
+	}
+
+	large = u_slice_alloc0 (1000);
+	copy = u_slice_copy (1000, large);
+	for (i = 0; i < 1000; i++)
+		if (copy[i])
+			return FAILED ("Large slices weren't copied");
+	u_slice_free1 (1000, copy);
+	u_slice_free1 (1000, large);
+
+	return OK;
+}
 
 static Test memory_tests [] = {
         {       "zero_size_allocations", test_memory_zero_size_allocations},
+        {       "slices", test_memory_slices},
         {NULL, NULL}
 };
 
@@ -90,6 +90,12 @@ check_flags (TestFlags flags,
       return FALSE;
     }
 
+  if (flags & TEST_REQUIREMENT_GPU_TIMING &&
+      !cogl_has_feature (test_ctx, COGL_FEATURE_ID_GPU_TIMING))
+    {
+      return FALSE;
+    }
+
   if (flags & TEST_KNOWN_FAILURE)
     {
       return FALSE;
@@ -0,0 +1,115 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+#define TEXTURE_SIZE 8
+
+/* Individual mode ETC1 blocks with the same base color in both
+ * halves. Every pixel uses the small positive modifier of table 0 so
+ * each component ends up 2 higher than the base color */
+#define ETC1_RED_BLOCK 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+#define ETC1_GREEN_BLOCK 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+
+/* DXT1 blocks where both endpoints are the same color and every
+ * pixel uses the first one */
+#define DXT1_BLUE_BLOCK 0x1f, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00
+#define DXT1_YELLOW_BLOCK 0xe0, 0xff, 0xe0, 0xff, 0x00, 0x00, 0x00, 0x00
+
+/* An 8x8 level made of four blocks followed by a 4x4 level made of
+ * one block of a different color */
+static const uint8_t etc1_data[] =
+  {
+    ETC1_RED_BLOCK, ETC1_RED_BLOCK, ETC1_RED_BLOCK, ETC1_RED_BLOCK,
+    ETC1_GREEN_BLOCK
+  };
+
+static const uint8_t dxt1_data[] =
+  {
+    DXT1_BLUE_BLOCK, DXT1_BLUE_BLOCK, DXT1_BLUE_BLOCK, DXT1_BLUE_BLOCK,
+    DXT1_YELLOW_BLOCK
+  };
+
+static void
+test_format (CoglPixelFormat format,
+             const uint8_t *data,
+             size_t data_size,
+             uint32_t level0_color,
+             uint32_t level1_color,
+             int y)
+{
+  CoglTexture2D *texture;
+  CoglPipeline *pipeline;
+  CoglError *error = NULL;
+
+  texture = cogl_texture_2d_new_from_compressed_data (test_ctx,
+                                                      TEXTURE_SIZE,
+                                                      TEXTURE_SIZE,
+                                                      format,
+                                                      2, /* n_levels */
+                                                      data_size,
+                                                      data,
+                                                      &error);
+  g_assert (error == NULL);
+  g_assert (texture != NULL);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST_MIPMAP_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  /* Draw the texture at full size to sample the first level and at
+   * half size next to it to sample the second one */
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   pipeline,
+                                   0, y,
+                                   TEXTURE_SIZE,
+                                   y + TEXTURE_SIZE);
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   pipeline,
+                                   TEXTURE_SIZE, y,
+                                   TEXTURE_SIZE + TEXTURE_SIZE / 2,
+                                   y + TEXTURE_SIZE / 2);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (texture);
+
+  test_utils_check_pixel (test_fb, 1, y + 1, level0_color);
+  test_utils_check_pixel (test_fb,
+                          TEXTURE_SIZE - 2,
+                          y + TEXTURE_SIZE - 2,
+                          level0_color);
+  test_utils_check_pixel (test_fb,
+                          TEXTURE_SIZE + 1,
+                          y + 1,
+                          level1_color);
+  test_utils_check_pixel (test_fb,
+                          TEXTURE_SIZE + TEXTURE_SIZE / 2 - 2,
+                          y + TEXTURE_SIZE / 2 - 2,
+                          level1_color);
+}
+
+void
+test_compressed_texture (void)
+{
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  test_format (COGL_PIXEL_FORMAT_ETC1_RGB_8,
+               etc1_data, sizeof (etc1_data),
+               0xff0202ff,
+               0x02ff02ff,
+               0);
+  test_format (COGL_PIXEL_FORMAT_S3TC_DXT1_RGB,
+               dxt1_data, sizeof (dxt1_data),
+               0x0000ffff,
+               0xffff00ff,
+               TEXTURE_SIZE * 2);
+
+  if (cogl_test_verbose ())
+    u_print ("OK\n");
+}
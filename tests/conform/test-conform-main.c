@@ -59,6 +59,7 @@ main (int argc, char **argv)
 #ifdef COGL_HAS_COGL_PATH_SUPPORT
   ADD_TEST (test_path, 0, 0);
   ADD_TEST (test_path_clip, 0, 0);
+  ADD_TEST (test_path_stroke, 0, 0);
 #endif
   ADD_TEST (test_depth_test, 0, 0);
   ADD_TEST (test_color_mask, 0, 0);
@@ -82,6 +83,9 @@ main (int argc, char **argv)
   /* This test won't work on GLES because that doesn't support setting
    * the maximum texture level. */
   ADD_TEST (test_texture_mipmap_get_set, TEST_REQUIREMENT_GL, 0);
+  /* The compressed textures only have two mipmap levels so this also
+   * relies on setting the maximum texture level */
+  ADD_TEST (test_compressed_texture, TEST_REQUIREMENT_GL, 0);
   ADD_TEST (test_atlas_migration, 0, 0);
   ADD_TEST (test_read_texture_formats, 0, 0);
   ADD_TEST (test_write_texture_formats, 0, 0);
@@ -151,10 +155,20 @@ main (int argc, char **argv)
   ADD_TEST (test_fence, TEST_REQUIREMENT_FENCE, 0);
 #endif
 
+#ifdef COGL_HAS_COGL_GST_SUPPORT
+  ADD_TEST (test_gst_texture_pool, 0, 0);
+#endif
+
   ADD_TEST (test_texture_no_allocate, 0, 0);
 
   ADD_TEST (test_texture_rg, TEST_REQUIREMENT_TEXTURE_RG, 0);
 
+  ADD_TEST (test_read_pixels_async, 0, 0);
+
+  ADD_TEST (test_gpu_timing, TEST_REQUIREMENT_GPU_TIMING, 0);
+
+  ADD_TEST (test_instancing, TEST_REQUIREMENT_GLSL, 0);
+
   u_printerr ("Unknown test name \"%s\"\n", argv[1]);
 
   return 1;
@@ -262,6 +262,72 @@ test_short_verts (TestState *state, int offset_x, int offset_y)
   test_utils_check_pixel (test_fb, offset_x + 15, offset_y + 5, 0x00ff00ff);
 }
 
+static void
+test_modified_verts (TestState *state, int offset_x, int offset_y)
+{
+  CoglAttribute *attributes[2];
+  CoglAttributeBuffer *buffer, *green_buffer;
+  CoglPrimitive *primitive;
+
+  static const FloatVert red_verts[] =
+    {
+      { 0, 10, /**/ 1, 0, 0, 1 },
+      { 10, 10, /**/ 1, 0, 0, 1 },
+      { 5, 0, /**/ 1, 0, 0, 1 }
+    };
+
+  static const FloatVert green_verts[] =
+    {
+      { 0, 0, /**/ 0, 1, 0, 1 },
+      { 0, 0, /**/ 0, 1, 0, 1 },
+      { 0, 0, /**/ 0, 1, 0, 1 }
+    };
+
+  buffer = cogl_attribute_buffer_new (test_ctx,
+                                      sizeof (red_verts), red_verts);
+  green_buffer = cogl_attribute_buffer_new (test_ctx,
+                                            sizeof (green_verts),
+                                            green_verts);
+  attributes[0] = cogl_attribute_new (buffer,
+                                      "cogl_position_in",
+                                      sizeof (FloatVert),
+                                      U_STRUCT_OFFSET (FloatVert, x),
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_SHORT);
+  attributes[1] = cogl_attribute_new (buffer,
+                                      "color",
+                                      sizeof (FloatVert),
+                                      U_STRUCT_OFFSET (FloatVert, r),
+                                      4, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  primitive = cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                                  3, /* n_vertices */
+                                                  attributes,
+                                                  2); /* n_attributes */
+
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, offset_x, offset_y, 0.0f);
+  cogl_primitive_draw (primitive, test_fb, state->pipeline);
+
+  /* Changing the buffer of an attribute after it has been drawn
+   * should be picked up by the next draw of the same primitive */
+  cogl_attribute_set_buffer (attributes[1], green_buffer);
+
+  cogl_framebuffer_translate (test_fb, 10.0f, 0.0f, 0.0f);
+  cogl_primitive_draw (primitive, test_fb, state->pipeline);
+  cogl_framebuffer_pop_matrix (test_fb);
+
+  cogl_object_unref (primitive);
+  cogl_object_unref (attributes[1]);
+  cogl_object_unref (attributes[0]);
+  cogl_object_unref (green_buffer);
+  cogl_object_unref (buffer);
+
+  test_utils_check_pixel (test_fb, offset_x + 5, offset_y + 5, 0xff0000ff);
+  test_utils_check_pixel (test_fb, offset_x + 15, offset_y + 5, 0x00ff00ff);
+}
+
 static void
 paint (TestState *state)
 {
@@ -270,6 +336,7 @@ paint (TestState *state)
   test_float_verts (state, 0, 0);
   test_byte_verts (state, 0, 10);
   test_short_verts (state, 0, 20);
+  test_modified_verts (state, 0, 30);
 }
 
 void
@@ -0,0 +1,154 @@
+#include <cogl/cogl.h>
+
+#include <string.h>
+
+#include "test-utils.h"
+
+typedef struct _TestState
+{
+  CoglOnscreen *onscreen;
+  CoglPipeline *pipeline;
+  CoglPrimitive *primitive;
+  int n_events;
+  CoglFrameInfo *info;
+} TestState;
+
+static void
+dispatch (void)
+{
+  CoglRenderer *renderer = cogl_context_get_renderer (test_ctx);
+  CoglPollFD *poll_fds;
+  int n_poll_fds;
+  int64_t timeout;
+
+  cogl_poll_renderer_get_info (renderer, &poll_fds, &n_poll_fds, &timeout);
+  cogl_poll_renderer_dispatch (renderer, poll_fds, n_poll_fds);
+}
+
+static void
+frame_cb (CoglOnscreen *onscreen,
+          CoglFrameEvent event,
+          CoglFrameInfo *info,
+          void *user_data)
+{
+  TestState *state = user_data;
+
+  if (event != COGL_FRAME_EVENT_GPU_TIMINGS)
+    return;
+
+  g_assert (state->info == NULL);
+  state->info = cogl_object_ref (info);
+  state->n_events++;
+}
+
+static void
+wait_for_timings (TestState *state)
+{
+  int i;
+
+  cogl_framebuffer_finish (state->onscreen);
+
+  /* The results should be available almost straight away after
+   * finishing but the queries are only checked in the poll dispatch */
+  for (i = 0; i < 100 && state->info == NULL; i++)
+    dispatch ();
+}
+
+static void
+paint_labelled_frame (TestState *state)
+{
+  CoglFramebuffer *fb = state->onscreen;
+
+  /* This rectangle goes in the journal so it will be flushed as an
+   * unlabelled section when the label is pushed */
+  cogl_framebuffer_draw_rectangle (fb, state->pipeline, -1, -1, 0, 0);
+
+  cogl_framebuffer_push_gpu_timing_label (fb, "scene");
+
+  /* Primitives are timed separately */
+  cogl_primitive_draw (state->primitive, fb, state->pipeline);
+
+  /* This is flushed when the label is popped */
+  cogl_framebuffer_draw_rectangle (fb, state->pipeline, 0, 0, 1, 1);
+
+  cogl_framebuffer_pop_gpu_timing_label (fb);
+
+  cogl_onscreen_swap_buffers (state->onscreen);
+}
+
+static void
+check_labelled_frame (TestState *state)
+{
+  CoglFrameInfo *info = state->info;
+  int64_t total = 0;
+  int i;
+
+  g_assert_cmpint (state->n_events, ==, 1);
+  g_assert_cmpint (cogl_frame_info_get_n_gpu_timings (info), ==, 3);
+
+  g_assert (cogl_frame_info_get_gpu_timing_label (info, 0) == NULL);
+  g_assert_cmpstr (cogl_frame_info_get_gpu_timing_label (info, 1),
+                   ==,
+                   "scene");
+  g_assert_cmpstr (cogl_frame_info_get_gpu_timing_label (info, 2),
+                   ==,
+                   "scene");
+
+  for (i = 0; i < 3; i++)
+    {
+      int64_t duration = cogl_frame_info_get_gpu_timing_duration (info, i);
+      g_assert (duration >= 0);
+      total += duration;
+    }
+
+  g_assert (cogl_frame_info_get_gpu_time (info) == total);
+}
+
+void
+test_gpu_timing (void)
+{
+  TestState state;
+  CoglVertexP2 verts[] = { { -1, -1 }, { 1, -1 }, { 1, 1 } };
+  CoglError *error = NULL;
+
+  memset (&state, 0, sizeof (state));
+
+  state.onscreen = cogl_onscreen_new (test_ctx, 64, 64);
+  if (!cogl_framebuffer_allocate (state.onscreen, &error))
+    g_error ("Failed to allocate onscreen: %s", error->message);
+
+  cogl_onscreen_add_frame_callback (state.onscreen,
+                                    frame_cb,
+                                    &state,
+                                    NULL); /* destroy */
+
+  state.pipeline = cogl_pipeline_new (test_ctx);
+  state.primitive = cogl_primitive_new_p2 (test_ctx,
+                                           COGL_VERTICES_MODE_TRIANGLES,
+                                           3, verts);
+
+  cogl_set_gpu_timing_enabled (test_ctx, TRUE);
+  g_assert (cogl_get_gpu_timing_enabled (test_ctx));
+
+  paint_labelled_frame (&state);
+  wait_for_timings (&state);
+  check_labelled_frame (&state);
+
+  cogl_object_unref (state.info);
+  state.info = NULL;
+
+  /* Nothing should be reported once timing is disabled */
+  cogl_set_gpu_timing_enabled (test_ctx, FALSE);
+
+  paint_labelled_frame (&state);
+  wait_for_timings (&state);
+  g_assert_cmpint (state.n_events, ==, 1);
+  g_assert (state.info == NULL);
+
+  cogl_object_unref (state.primitive);
+  cogl_object_unref (state.pipeline);
+  cogl_object_unref (state.onscreen);
+
+  if (cogl_test_verbose ())
+    u_print ("OK\n");
+}
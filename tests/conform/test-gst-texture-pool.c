@@ -0,0 +1,158 @@
+#include <gst/gst.h>
+#include <cogl/cogl.h>
+#include <cogl-gst/cogl-gst.h>
+
+#include "test-utils.h"
+
+#define FRAME_SIZE 8
+
+#define RED 0xff0000ff
+#define GREEN 0x00ff00ff
+#define BLUE 0x0000ffff
+#define WHITE 0xffffffff
+
+typedef struct _TestState
+{
+  CoglGstVideoSink *sink;
+  GstPad *srcpad;
+} TestState;
+
+static void
+push_frame (TestState *state,
+            uint32_t color)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  int i;
+
+  buffer = gst_buffer_new_allocate (NULL, FRAME_SIZE * FRAME_SIZE * 4, NULL);
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < FRAME_SIZE * FRAME_SIZE; i++)
+    {
+      map.data[i * 4 + 0] = color >> 24;
+      map.data[i * 4 + 1] = color >> 16;
+      map.data[i * 4 + 2] = color >> 8;
+      map.data[i * 4 + 3] = color;
+    }
+  gst_buffer_unmap (buffer, &map);
+
+  g_assert_cmpint (gst_pad_push (state->srcpad, buffer), ==, GST_FLOW_OK);
+
+  /* The sink uploads the frame from a source on the main context */
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+static CoglTexture *
+get_frame_texture (TestState *state)
+{
+  CoglPipeline *pipeline = cogl_gst_video_sink_get_pipeline (state->sink);
+
+  return cogl_pipeline_get_layer_texture (pipeline, 0);
+}
+
+static void
+draw_frame (TestState *state,
+            int x)
+{
+  CoglPipeline *pipeline = cogl_gst_video_sink_get_pipeline (state->sink);
+
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline, x, 0, x + 10, 10);
+}
+
+static void
+start_stream (TestState *state)
+{
+  GstPad *sinkpad;
+  GstCaps *caps;
+  GstSegment segment;
+
+  state->sink = cogl_gst_video_sink_new (test_ctx);
+  gst_object_ref_sink (state->sink);
+  g_object_set (state->sink, "sync", FALSE, "async", FALSE, NULL);
+
+  state->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (GST_ELEMENT (state->sink), "sink");
+  g_assert_cmpint (gst_pad_link (state->srcpad, sinkpad), ==, GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (state->srcpad, TRUE);
+
+  gst_element_set_state (GST_ELEMENT (state->sink), GST_STATE_PLAYING);
+
+  gst_pad_push_event (state->srcpad, gst_event_new_stream_start ("test"));
+
+  caps = gst_caps_new_simple ("video/x-raw",
+                              "format", G_TYPE_STRING, "RGBA",
+                              "width", G_TYPE_INT, FRAME_SIZE,
+                              "height", G_TYPE_INT, FRAME_SIZE,
+                              "framerate", GST_TYPE_FRACTION, 30, 1,
+                              NULL);
+  g_assert (gst_pad_push_event (state->srcpad, gst_event_new_caps (caps)));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (state->srcpad, gst_event_new_segment (&segment));
+}
+
+static void
+stop_stream (TestState *state)
+{
+  gst_element_set_state (GST_ELEMENT (state->sink), GST_STATE_NULL);
+  gst_object_unref (state->srcpad);
+  gst_object_unref (state->sink);
+}
+
+void
+test_gst_texture_pool (void)
+{
+  TestState state;
+  CoglTexture *green_texture;
+  CoglTexture *texture;
+
+  gst_init (NULL, NULL);
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  start_stream (&state);
+
+  push_frame (&state, RED);
+  get_frame_texture (&state);
+
+  push_frame (&state, GREEN);
+  green_texture = get_frame_texture (&state);
+
+  /* Queue some drawing that samples from the green frame. The journal
+   * isn't flushed until the pixel is read back below */
+  draw_frame (&state, 0);
+
+  push_frame (&state, BLUE);
+  get_frame_texture (&state);
+
+  /* The green frame has gone back to the pool by now, but the journal
+   * still references it so it must not be updated in place */
+  push_frame (&state, WHITE);
+  texture = get_frame_texture (&state);
+  g_assert (texture != green_texture);
+
+  test_utils_check_pixel (test_fb, 5, 5, GREEN);
+
+  /* Flushing the journal dropped the last reference other than the
+   * pool's so the next frame can reuse the texture */
+  push_frame (&state, RED);
+  texture = get_frame_texture (&state);
+  g_assert (texture == green_texture);
+
+  draw_frame (&state, 20);
+  test_utils_check_pixel (test_fb, 25, 5, RED);
+
+  stop_stream (&state);
+
+  if (cogl_test_verbose ())
+    u_print ("OK\n");
+}
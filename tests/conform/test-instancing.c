@@ -0,0 +1,165 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+#define N_INSTANCES 4
+#define QUAD_SIZE 10
+
+typedef struct
+{
+  float x, y;
+  uint8_t r, g, b, a;
+} InstanceData;
+
+static const InstanceData instance_data[N_INSTANCES] =
+  {
+    { 0, 0, /**/ 255, 0, 0, 255 },
+    { QUAD_SIZE, 0, /**/ 0, 255, 0, 255 },
+    { QUAD_SIZE * 2, 0, /**/ 0, 0, 255, 255 },
+    { QUAD_SIZE * 3, 0, /**/ 255, 255, 0, 255 }
+  };
+
+static const uint32_t instance_colors[N_INSTANCES] =
+  {
+    0xff0000ff,
+    0x00ff00ff,
+    0x0000ffff,
+    0xffff00ff
+  };
+
+static CoglPrimitive *
+create_primitive (int color_divisor)
+{
+  static const CoglVertexP2 quad[] =
+    {
+      { 0, 0 },
+      { 0, QUAD_SIZE },
+      { QUAD_SIZE, 0 },
+      { QUAD_SIZE, QUAD_SIZE }
+    };
+  CoglAttributeBuffer *quad_buffer;
+  CoglAttributeBuffer *instance_buffer;
+  CoglAttribute *attributes[3];
+  CoglPrimitive *primitive;
+  int i;
+
+  quad_buffer = cogl_attribute_buffer_new (test_ctx, sizeof (quad), quad);
+  instance_buffer = cogl_attribute_buffer_new (test_ctx,
+                                               sizeof (instance_data),
+                                               instance_data);
+
+  attributes[0] = cogl_attribute_new (quad_buffer,
+                                      "cogl_position_in",
+                                      sizeof (CoglVertexP2),
+                                      U_STRUCT_OFFSET (CoglVertexP2, x),
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  attributes[1] = cogl_attribute_new (instance_buffer,
+                                      "instance_offset",
+                                      sizeof (InstanceData),
+                                      U_STRUCT_OFFSET (InstanceData, x),
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+  cogl_attribute_set_instance_divisor (attributes[1], 1);
+  attributes[2] = cogl_attribute_new (instance_buffer,
+                                      "cogl_color_in",
+                                      sizeof (InstanceData),
+                                      U_STRUCT_OFFSET (InstanceData, r),
+                                      4, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  cogl_attribute_set_instance_divisor (attributes[2], color_divisor);
+
+  g_assert_cmpint (cogl_attribute_get_instance_divisor (attributes[2]),
+                   ==,
+                   color_divisor);
+
+  /* The strip checks that the fallback path doesn't join the
+   * instances together */
+  primitive =
+    cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                        U_N_ELEMENTS (quad),
+                                        attributes,
+                                        U_N_ELEMENTS (attributes));
+
+  for (i = 0; i < U_N_ELEMENTS (attributes); i++)
+    cogl_object_unref (attributes[i]);
+  cogl_object_unref (instance_buffer);
+  cogl_object_unref (quad_buffer);
+
+  return primitive;
+}
+
+static void
+draw_row (CoglPipeline *pipeline,
+          int color_divisor,
+          int y)
+{
+  CoglPrimitive *primitive = create_primitive (color_divisor);
+
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, 0, y, 0);
+  cogl_primitive_draw_instanced (primitive, test_fb, pipeline, N_INSTANCES);
+  cogl_framebuffer_pop_matrix (test_fb);
+
+  cogl_object_unref (primitive);
+}
+
+static void
+check_row (int color_divisor,
+           int y)
+{
+  int i;
+
+  for (i = 0; i < N_INSTANCES; i++)
+    test_utils_check_pixel (test_fb,
+                            i * QUAD_SIZE + QUAD_SIZE / 2,
+                            y + QUAD_SIZE / 2,
+                            instance_colors[i / color_divisor]);
+
+  /* Nothing should be drawn past the last instance */
+  test_utils_check_pixel (test_fb,
+                          N_INSTANCES * QUAD_SIZE + QUAD_SIZE / 2,
+                          y + QUAD_SIZE / 2,
+                          0x000000ff);
+}
+
+void
+test_instancing (void)
+{
+  CoglPipeline *pipeline;
+  CoglSnippet *snippet;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX_TRANSFORM,
+                              "in vec2 instance_offset;",
+                              NULL);
+  cogl_snippet_set_replace (snippet,
+                            "cogl_position_out = "
+                            "cogl_modelview_projection_matrix * "
+                            "(cogl_position_in + "
+                            "vec4 (instance_offset, 0.0, 0.0));");
+  cogl_pipeline_add_snippet (pipeline, snippet);
+  cogl_object_unref (snippet);
+
+  /* Every instance gets its own color */
+  draw_row (pipeline, 1, 0);
+  /* Pairs of instances share a color */
+  draw_row (pipeline, 2, QUAD_SIZE * 2);
+
+  check_row (1, 0);
+  check_row (2, QUAD_SIZE * 2);
+
+  cogl_object_unref (pipeline);
+
+  if (cogl_test_verbose ())
+    u_print ("OK\n");
+}
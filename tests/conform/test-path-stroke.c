@@ -0,0 +1,110 @@
+#include <cogl/cogl.h>
+#include <cogl-path/cogl-path.h>
+
+#include <string.h>
+
+#include "test-utils.h"
+
+#define WHITE 0xffffffff
+#define BLACK 0x000000ff
+
+static void
+stroke_line (CoglPipeline *pipeline,
+             CoglPathLineCap line_cap,
+             float y)
+{
+  CoglPath *path = cogl_path_new (test_ctx);
+
+  cogl_path_set_stroke_width (path, 10);
+  cogl_path_set_line_cap (path, line_cap);
+  cogl_path_line (path, 20, y, 80, y);
+  cogl_path_stroke (path, test_fb, pipeline);
+
+  cogl_object_unref (path);
+}
+
+void
+test_path_stroke (void)
+{
+  CoglPipeline *white;
+  CoglPath *path;
+  float dashes[] = { 10, 10 };
+  int fb_width, fb_height;
+
+  fb_width = cogl_framebuffer_get_width (test_fb);
+  fb_height = cogl_framebuffer_get_height (test_fb);
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0, fb_width, fb_height, -1, 100);
+
+  cogl_framebuffer_clear4f (test_fb,
+                            COGL_BUFFER_BIT_COLOR,
+                            0.0f, 0.0f, 0.0f, 1.0f);
+
+  white = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4f (white, 1, 1, 1, 1);
+
+  /* Three lines from x=20 to x=80 with each of the cap styles */
+  stroke_line (white, COGL_PATH_LINE_CAP_BUTT, 20);
+  stroke_line (white, COGL_PATH_LINE_CAP_SQUARE, 40);
+  stroke_line (white, COGL_PATH_LINE_CAP_ROUND, 60);
+
+  /* A closed rectangle with mitered corners */
+  path = cogl_path_new (test_ctx);
+  cogl_path_set_stroke_width (path, 8);
+  cogl_path_rectangle (path, 110, 20, 170, 80);
+  cogl_path_stroke (path, test_fb, white);
+  /* The first stroke is streamed. Drawing the same rectangle again
+     uploads the geometry to buffers of its own */
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, 0, 100, 0);
+  cogl_path_stroke (path, test_fb, white);
+  cogl_framebuffer_pop_matrix (test_fb);
+  cogl_object_unref (path);
+
+  /* A dashed line */
+  path = cogl_path_new (test_ctx);
+  cogl_path_set_stroke_width (path, 6);
+  cogl_path_set_dash (path, dashes, 2, 0);
+  cogl_path_line (path, 20, 100, 80, 100);
+  cogl_path_stroke (path, test_fb, white);
+  cogl_object_unref (path);
+
+  cogl_object_unref (white);
+
+  /* The width covers 5 pixels either side of the line */
+  test_utils_check_pixel (test_fb, 50, 17, WHITE);
+  test_utils_check_pixel (test_fb, 50, 23, WHITE);
+  test_utils_check_pixel (test_fb, 50, 27, BLACK);
+
+  /* Butt caps stop at the end points */
+  test_utils_check_pixel (test_fb, 17, 20, BLACK);
+  test_utils_check_pixel (test_fb, 82, 20, BLACK);
+
+  /* Square caps extend by half of the width */
+  test_utils_check_pixel (test_fb, 17, 40, WHITE);
+  test_utils_check_pixel (test_fb, 82, 40, WHITE);
+  test_utils_check_pixel (test_fb, 17, 36, WHITE);
+
+  /* Round caps extend in the middle but not at the corners */
+  test_utils_check_pixel (test_fb, 17, 60, WHITE);
+  test_utils_check_pixel (test_fb, 16, 56, BLACK);
+
+  /* The miter fills in the outer corner of the rectangle but the
+     inside is left untouched */
+  test_utils_check_pixel (test_fb, 107, 17, WHITE);
+  test_utils_check_pixel (test_fb, 173, 83, WHITE);
+  test_utils_check_pixel (test_fb, 140, 50, BLACK);
+  test_utils_check_pixel (test_fb, 107, 117, WHITE);
+  test_utils_check_pixel (test_fb, 173, 183, WHITE);
+  test_utils_check_pixel (test_fb, 140, 150, BLACK);
+
+  /* The dashes alternate every 10 pixels */
+  test_utils_check_pixel (test_fb, 25, 100, WHITE);
+  test_utils_check_pixel (test_fb, 35, 100, BLACK);
+  test_utils_check_pixel (test_fb, 45, 100, WHITE);
+  test_utils_check_pixel (test_fb, 55, 100, BLACK);
+
+  if (cogl_test_verbose ())
+    u_print ("OK\n");
+}
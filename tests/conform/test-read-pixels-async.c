@@ -0,0 +1,301 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+#define N_BUFFERS 2
+
+typedef struct _TestState
+{
+  int fb_width;
+  int fb_height;
+  int n_callbacks;
+  /* The order the ring callbacks were received in */
+  int order[N_BUFFERS];
+} TestState;
+
+static void
+dispatch (void)
+{
+  CoglRenderer *renderer = cogl_context_get_renderer (test_ctx);
+  CoglPollFD *poll_fds;
+  int n_poll_fds;
+  int64_t timeout;
+
+  cogl_poll_renderer_get_info (renderer, &poll_fds, &n_poll_fds, &timeout);
+  cogl_poll_renderer_dispatch (renderer, poll_fds, n_poll_fds);
+}
+
+static void
+check_bitmap (CoglBitmap *bitmap)
+{
+  CoglBuffer *buffer = cogl_bitmap_get_buffer (bitmap);
+  int rowstride = cogl_bitmap_get_rowstride (bitmap);
+  int width = cogl_bitmap_get_width (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  uint8_t *data;
+
+  data = cogl_buffer_map (buffer, COGL_BUFFER_ACCESS_READ, 0, NULL);
+  g_assert (data != NULL);
+
+  /* The top half was drawn red and the bottom half green. Checking
+   * both makes sure the rows were flipped for onscreen framebuffers */
+  test_utils_compare_pixel (data + rowstride * (height / 4) + (width / 2) * 4,
+                            0xff0000ff);
+  test_utils_compare_pixel (data +
+                            rowstride * (height * 3 / 4) +
+                            (width / 2) * 4,
+                            0x00ff00ff);
+
+  cogl_buffer_unmap (buffer);
+}
+
+static void
+read_cb (CoglFramebuffer *framebuffer,
+         CoglBitmap *bitmap,
+         void *user_data)
+{
+  TestState *state = user_data;
+
+  g_assert (framebuffer == test_fb);
+  g_assert (bitmap != NULL);
+
+  check_bitmap (bitmap);
+
+  state->n_callbacks++;
+}
+
+static CoglReadPixelsClosure *self_cancel_closure;
+
+static void
+self_cancel_cb (CoglFramebuffer *framebuffer,
+                CoglBitmap *bitmap,
+                void *user_data)
+{
+  TestState *state = user_data;
+
+  /* Cancelling a read from its own callback should be harmless */
+  cogl_framebuffer_cancel_read_pixels_async (framebuffer,
+                                             self_cancel_closure);
+
+  state->n_callbacks++;
+}
+
+static int ring_serials[N_BUFFERS] = { 0, 1 };
+static TestState *ring_state;
+
+static void
+ring_cb (CoglFramebuffer *framebuffer,
+         CoglBitmap *bitmap,
+         void *user_data)
+{
+  int *serial = user_data;
+
+  g_assert (bitmap != NULL);
+
+  check_bitmap (bitmap);
+
+  ring_state->order[ring_state->n_callbacks++] = *serial;
+}
+
+static CoglCaptureRing *unref_ring;
+
+static void
+unref_ring_cb (CoglFramebuffer *framebuffer,
+               CoglBitmap *bitmap,
+               void *user_data)
+{
+  TestState *state = user_data;
+
+  /* Dropping the last reference to the ring from the callback frees
+   * it, which should cancel the other capture still in flight */
+  cogl_object_unref (unref_ring);
+  unref_ring = NULL;
+
+  state->n_callbacks++;
+}
+
+static void
+paint (TestState *state)
+{
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 state->fb_width, state->fb_height,
+                                 -1, 100);
+
+  cogl_pipeline_set_color4ub (pipeline, 0xff, 0x00, 0x00, 0xff);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline,
+                                   0, 0,
+                                   state->fb_width, state->fb_height / 2);
+
+  cogl_pipeline_set_color4ub (pipeline, 0x00, 0xff, 0x00, 0xff);
+  cogl_framebuffer_draw_rectangle (test_fb, pipeline,
+                                   0, state->fb_height / 2,
+                                   state->fb_width, state->fb_height);
+
+  cogl_object_unref (pipeline);
+}
+
+static void
+test_single_read (TestState *state)
+{
+  CoglBitmap *bitmap;
+  CoglReadPixelsClosure *closure;
+  CoglError *error = NULL;
+
+  bitmap = cogl_bitmap_new_with_size (test_ctx,
+                                      state->fb_width,
+                                      state->fb_height,
+                                      COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+
+  state->n_callbacks = 0;
+
+  closure = cogl_framebuffer_read_pixels_async (test_fb,
+                                                0, 0,
+                                                COGL_READ_PIXELS_COLOR_BUFFER,
+                                                bitmap,
+                                                read_cb,
+                                                state,
+                                                &error);
+  g_assert (error == NULL);
+  g_assert (closure != NULL);
+
+  /* The callback should never be invoked directly */
+  g_assert_cmpint (state->n_callbacks, ==, 0);
+
+  while (state->n_callbacks == 0)
+    dispatch ();
+
+  g_assert_cmpint (state->n_callbacks, ==, 1);
+
+  /* A cancelled read should never be reported */
+  closure = cogl_framebuffer_read_pixels_async (test_fb,
+                                                0, 0,
+                                                COGL_READ_PIXELS_COLOR_BUFFER,
+                                                bitmap,
+                                                read_cb,
+                                                state,
+                                                &error);
+  g_assert (error == NULL);
+  cogl_framebuffer_cancel_read_pixels_async (test_fb, closure);
+
+  cogl_framebuffer_finish (test_fb);
+  dispatch ();
+
+  g_assert_cmpint (state->n_callbacks, ==, 1);
+
+  self_cancel_closure =
+    cogl_framebuffer_read_pixels_async (test_fb,
+                                        0, 0,
+                                        COGL_READ_PIXELS_COLOR_BUFFER,
+                                        bitmap,
+                                        self_cancel_cb,
+                                        state,
+                                        &error);
+  g_assert (error == NULL);
+
+  while (state->n_callbacks == 1)
+    dispatch ();
+
+  g_assert_cmpint (state->n_callbacks, ==, 2);
+
+  cogl_object_unref (bitmap);
+}
+
+static void
+test_capture_ring (TestState *state)
+{
+  CoglCaptureRing *ring;
+  int i;
+
+  ring = cogl_capture_ring_new (test_ctx,
+                                state->fb_width,
+                                state->fb_height,
+                                COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                N_BUFFERS);
+  g_assert (cogl_is_capture_ring (ring));
+
+  ring_state = state;
+  state->n_callbacks = 0;
+
+  for (i = 0; i < N_BUFFERS; i++)
+    g_assert (cogl_capture_ring_capture (ring,
+                                         test_fb,
+                                         0, 0,
+                                         COGL_READ_PIXELS_COLOR_BUFFER,
+                                         ring_cb,
+                                         ring_serials + i));
+
+  /* Every buffer is busy so the next frame should be dropped */
+  g_assert (!cogl_capture_ring_capture (ring,
+                                        test_fb,
+                                        0, 0,
+                                        COGL_READ_PIXELS_COLOR_BUFFER,
+                                        ring_cb,
+                                        ring_serials));
+  g_assert_cmpint (cogl_capture_ring_get_n_pending (ring), ==, N_BUFFERS);
+
+  while (state->n_callbacks < N_BUFFERS)
+    dispatch ();
+
+  g_assert_cmpint (cogl_capture_ring_get_n_pending (ring), ==, 0);
+
+  for (i = 0; i < N_BUFFERS; i++)
+    g_assert_cmpint (state->order[i], ==, i);
+
+  /* Freeing the ring with a read in flight should cancel it */
+  g_assert (cogl_capture_ring_capture (ring,
+                                       test_fb,
+                                       0, 0,
+                                       COGL_READ_PIXELS_COLOR_BUFFER,
+                                       ring_cb,
+                                       ring_serials));
+  cogl_object_unref (ring);
+
+  cogl_framebuffer_finish (test_fb);
+  dispatch ();
+
+  g_assert_cmpint (state->n_callbacks, ==, N_BUFFERS);
+
+  unref_ring = cogl_capture_ring_new (test_ctx,
+                                      state->fb_width,
+                                      state->fb_height,
+                                      COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                      N_BUFFERS);
+  state->n_callbacks = 0;
+
+  for (i = 0; i < N_BUFFERS; i++)
+    g_assert (cogl_capture_ring_capture (unref_ring,
+                                         test_fb,
+                                         0, 0,
+                                         COGL_READ_PIXELS_COLOR_BUFFER,
+                                         unref_ring_cb,
+                                         state));
+
+  while (state->n_callbacks == 0)
+    dispatch ();
+
+  cogl_framebuffer_finish (test_fb);
+  dispatch ();
+
+  g_assert (unref_ring == NULL);
+  g_assert_cmpint (state->n_callbacks, ==, 1);
+}
+
+void
+test_read_pixels_async (void)
+{
+  TestState state;
+
+  state.fb_width = cogl_framebuffer_get_width (test_fb);
+  state.fb_height = cogl_framebuffer_get_height (test_fb);
+
+  paint (&state);
+
+  test_single_read (&state);
+  test_capture_ring (&state);
+
+  if (cogl_test_verbose ())
+    u_print ("OK\n");
+}
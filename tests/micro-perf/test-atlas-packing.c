@@ -0,0 +1,619 @@
+#include <config.h>
+
+/* NB: This is built with COGL_COMPILATION so that it can use the
+ * private rectangle map API which means it can't just include
+ * <cogl/cogl.h> */
+#include <cogl/cogl-types.h>
+#include <cogl/cogl-rectangle-map.h>
+
+#include <ulib.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Replays traces of atlas allocations through each of the
+ * CoglRectangleMap packing algorithms and reports how well they pack
+ * and how long each allocation takes.
+ *
+ * The replay mimics what _cogl_atlas_allocate_space does: when an
+ * allocation doesn't fit, all of the existing rectangles plus the new
+ * one are sorted by size and re-added to a new map which is doubled
+ * in size if the current one is nearly full. Creating real atlas
+ * textures would need a GPU so only the rectangle packing is
+ * simulated. The number of these reorganizations and the size of the
+ * final atlas are what determine the hitches and texture memory
+ * caused by the atlas.
+ *
+ * Each trace is also replayed with the atlas growing in place like
+ * COGL_ATLAS_GROWTH_EXTEND, where the map is doubled in size without
+ * moving anything.
+ *
+ * For each trace this reports the number of reorganizations, how many
+ * pixels had to be copied by them, the size and fraction used of the
+ * final atlas and the average fraction of the atlas that was used
+ * each time an allocation didn't fit, which is the best measure of
+ * how well the algorithm packs.
+ *
+ * Pass --json to get the results in a form that can be compared
+ * between runs. COGL_BENCHMARK_MIN_TIME sets how long in seconds
+ * each trace is repeated for to measure the timings.
+ */
+
+#define DEFAULT_MIN_TIME 0.2
+#define MAX_ATLAS_SIZE 4096
+
+typedef struct _TraceOp
+{
+  /* A width of zero means remove the allocation made by the add
+   * operation at index 'removed' */
+  int width, height;
+  int removed;
+} TraceOp;
+
+typedef struct _Trace
+{
+  const char *name;
+  int initial_size;
+  int n_ops;
+  TraceOp *ops;
+} Trace;
+
+typedef struct _Atlas
+{
+  CoglRectangleMapType type;
+  CoglBool extend;
+  CoglRectangleMap *map;
+  /* Position of the allocation made by each op */
+  CoglRectangleMapEntry *positions;
+  int n_reorganizations;
+  int n_failures;
+  /* Number of pixels that had to be copied to a new texture */
+  double copied_area;
+  /* Sum of the fraction of the map that was used each time an
+   * allocation didn't fit */
+  double full_fraction;
+  int n_full;
+} Atlas;
+
+typedef struct _Allocation
+{
+  CoglRectangleMapEntry rectangle;
+  int op;
+} Allocation;
+
+typedef struct _Result
+{
+  int n_reorganizations;
+  int n_failures;
+  double copied_area;
+  double fill_when_full;
+  unsigned int width, height;
+  unsigned int used_area;
+  int n_inserts;
+  double ns_per_insert;
+} Result;
+
+static const struct
+{
+  const char *name;
+  CoglRectangleMapType type;
+  CoglBool extend;
+} modes[] =
+  {
+    { "tree", COGL_RECTANGLE_MAP_TYPE_TREE, FALSE },
+    { "skyline", COGL_RECTANGLE_MAP_TYPE_SKYLINE, FALSE },
+    { "tree+extend", COGL_RECTANGLE_MAP_TYPE_TREE, TRUE },
+    { "skyline+extend", COGL_RECTANGLE_MAP_TYPE_SKYLINE, TRUE }
+  };
+
+/* A simple LCG so that the traces are the same on every platform */
+static unsigned int
+trace_random (unsigned int *seed, unsigned int max)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return ((*seed >> 16) & 0x7fff) % max;
+}
+
+static void
+trace_add (Trace *trace, int width, int height)
+{
+  trace->ops[trace->n_ops].width = width;
+  trace->ops[trace->n_ops].height = height;
+  trace->ops[trace->n_ops].removed = -1;
+  trace->n_ops++;
+}
+
+static void
+trace_remove (Trace *trace, int op)
+{
+  trace->ops[trace->n_ops].width = 0;
+  trace->ops[trace->n_ops].height = 0;
+  trace->ops[trace->n_ops].removed = op;
+  trace->n_ops++;
+}
+
+/* The glyphs for a few thousand characters of text in a range of font
+ * sizes. Cogl-pango adds a pixel of padding on each side of every
+ * glyph */
+static void
+make_glyph_trace (Trace *trace)
+{
+  static const int font_sizes[] = { 10, 12, 14, 16, 20, 24, 32, 48 };
+  unsigned int seed = 1;
+  int i;
+
+  trace->name = "glyphs";
+  trace->initial_size = 1024;
+  trace->n_ops = 0;
+  trace->ops = u_new (TraceOp, 4000);
+
+  for (i = 0; i < 4000; i++)
+    {
+      int size = font_sizes[trace_random (&seed, U_N_ELEMENTS (font_sizes))];
+
+      trace_add (trace,
+                 size * (30 + trace_random (&seed, 50)) / 100 + 2,
+                 size * (40 + trace_random (&seed, 70)) / 100 + 2);
+    }
+}
+
+static void
+get_icon_size (unsigned int *seed, int *width, int *height)
+{
+  static const int icon_sizes[] = { 16, 22, 24, 32, 48, 64 };
+  unsigned int kind = trace_random (seed, 10);
+
+  if (kind < 7)
+    {
+      /* A standard icon size */
+      *width = icon_sizes[trace_random (seed, U_N_ELEMENTS (icon_sizes))];
+      *height = *width;
+    }
+  else if (kind < 9)
+    {
+      /* A thumbnail */
+      *width = 64 + trace_random (seed, 97);
+      *height = 48 + trace_random (seed, 81);
+    }
+  else
+    {
+      /* Some odd-shaped UI element such as a border or a separator */
+      *width = 4 + trace_random (seed, 197);
+      *height = 4 + trace_random (seed, 37);
+    }
+}
+
+/* Images of mixed sizes uploaded as atlas textures */
+static void
+make_icon_trace (Trace *trace)
+{
+  unsigned int seed = 2;
+  int i;
+
+  trace->name = "icons";
+  trace->initial_size = 512;
+  trace->n_ops = 0;
+  trace->ops = u_new (TraceOp, 600);
+
+  for (i = 0; i < 600; i++)
+    {
+      int width, height;
+
+      get_icon_size (&seed, &width, &height);
+      trace_add (trace, width, height);
+    }
+}
+
+/* The same mix of images but with some of them being freed again
+ * while new ones are added, as happens when scrolling through a view
+ * of thumbnails */
+static void
+make_icon_churn_trace (Trace *trace)
+{
+  unsigned int seed = 3;
+  int *live = u_new (int, 2000);
+  int n_live = 0;
+  int i;
+
+  trace->name = "icons-churn";
+  trace->initial_size = 512;
+  trace->n_ops = 0;
+  trace->ops = u_new (TraceOp, 4000);
+
+  for (i = 0; i < 2000; i++)
+    {
+      int width, height;
+
+      get_icon_size (&seed, &width, &height);
+      live[n_live++] = trace->n_ops;
+      trace_add (trace, width, height);
+
+      /* Keep about 300 images alive at a time */
+      if (n_live > 300 || (n_live > 1 && trace_random (&seed, 4) == 0))
+        {
+          int index = trace_random (&seed, n_live);
+
+          trace_remove (trace, live[index]);
+          live[index] = live[--n_live];
+        }
+    }
+
+  u_free (live);
+}
+
+static void
+get_allocations_cb (const CoglRectangleMapEntry *entry,
+                    void *rectangle_data,
+                    void *user_data)
+{
+  Allocation **allocation = user_data;
+
+  (*allocation)->rectangle = *entry;
+  (*allocation)->op = U_POINTER_TO_INT (rectangle_data) - 1;
+  (*allocation)++;
+}
+
+static int
+compare_allocation_size_cb (const void *a,
+                            const void *b)
+{
+  const Allocation *aa = a;
+  const Allocation *ab = b;
+  unsigned int a_size = aa->rectangle.width * aa->rectangle.height;
+  unsigned int b_size = ab->rectangle.width * ab->rectangle.height;
+
+  return a_size < b_size ? 1 : a_size > b_size ? -1 : 0;
+}
+
+/* This is the same as _cogl_atlas_extend */
+static CoglBool
+atlas_extend (Atlas *atlas,
+              const Trace *trace,
+              int op)
+{
+  const TraceOp *trace_op = trace->ops + op;
+  unsigned int old_width = _cogl_rectangle_map_get_width (atlas->map);
+  unsigned int old_height = _cogl_rectangle_map_get_height (atlas->map);
+  unsigned int map_width = old_width, map_height = old_height;
+
+  do
+    {
+      if (map_width < map_height)
+        map_width <<= 1;
+      else
+        map_height <<= 1;
+
+      if (map_width > MAX_ATLAS_SIZE || map_height > MAX_ATLAS_SIZE)
+        return FALSE;
+    }
+  while ((trace_op->width > map_width - old_width ||
+          trace_op->height > old_height) &&
+         (trace_op->width > map_width ||
+          trace_op->height > map_height - old_height));
+
+  _cogl_rectangle_map_grow (atlas->map, map_width, map_height);
+  atlas->n_reorganizations++;
+  atlas->copied_area += old_width * old_height;
+
+  return _cogl_rectangle_map_add (atlas->map,
+                                  trace_op->width, trace_op->height,
+                                  U_INT_TO_POINTER (op + 1),
+                                  atlas->positions + op);
+}
+
+/* This is the same as _cogl_atlas_allocate_space except that it
+ * doesn't need any textures */
+static void
+atlas_allocate (Atlas *atlas,
+                const Trace *trace,
+                int op)
+{
+  const TraceOp *trace_op = trace->ops + op;
+  Allocation *allocations, *allocation;
+  unsigned int map_width, map_height;
+  int n_allocations;
+  int i;
+
+  if (atlas->map &&
+      _cogl_rectangle_map_add (atlas->map,
+                               trace_op->width, trace_op->height,
+                               U_INT_TO_POINTER (op + 1),
+                               atlas->positions + op))
+    return;
+
+  if (atlas->map)
+    {
+      unsigned int area = (_cogl_rectangle_map_get_width (atlas->map) *
+                           _cogl_rectangle_map_get_height (atlas->map));
+
+      atlas->full_fraction +=
+        (double) (area - _cogl_rectangle_map_get_remaining_space (atlas->map)) /
+        area;
+      atlas->n_full++;
+
+      if (atlas->extend)
+        {
+          if (!atlas_extend (atlas, trace, op))
+            {
+              atlas->positions[op].width = 0;
+              atlas->n_failures++;
+            }
+          return;
+        }
+    }
+
+  n_allocations =
+    atlas->map ? _cogl_rectangle_map_get_n_rectangles (atlas->map) : 0;
+  allocations = u_new (Allocation, n_allocations + 1);
+
+  allocation = allocations;
+  if (atlas->map)
+    _cogl_rectangle_map_foreach (atlas->map,
+                                 get_allocations_cb,
+                                 &allocation);
+
+  allocation->rectangle.width = trace_op->width;
+  allocation->rectangle.height = trace_op->height;
+  allocation->op = op;
+  n_allocations++;
+
+  qsort (allocations, n_allocations, sizeof (Allocation),
+         compare_allocation_size_cb);
+
+  if (atlas->map)
+    {
+      map_width = _cogl_rectangle_map_get_width (atlas->map);
+      map_height = _cogl_rectangle_map_get_height (atlas->map);
+
+      if ((map_width * map_height -
+           _cogl_rectangle_map_get_remaining_space (atlas->map) +
+           trace_op->width * trace_op->height) * 53 / 50 >
+          map_width * map_height)
+        {
+          if (map_width < map_height)
+            map_width <<= 1;
+          else
+            map_height <<= 1;
+        }
+    }
+  else
+    map_width = map_height = trace->initial_size;
+
+  while (map_width <= MAX_ATLAS_SIZE && map_height <= MAX_ATLAS_SIZE)
+    {
+      CoglRectangleMap *new_map =
+        _cogl_rectangle_map_new_with_type (atlas->type,
+                                           map_width,
+                                           map_height,
+                                           NULL);
+
+      for (i = 0; i < n_allocations; i++)
+        if (!_cogl_rectangle_map_add (new_map,
+                                      allocations[i].rectangle.width,
+                                      allocations[i].rectangle.height,
+                                      U_INT_TO_POINTER (allocations[i].op + 1),
+                                      atlas->positions + allocations[i].op))
+          break;
+
+      if (i >= n_allocations)
+        {
+          if (atlas->map)
+            {
+              _cogl_rectangle_map_free (atlas->map);
+              atlas->n_reorganizations++;
+
+              /* Everything except the new allocation gets copied */
+              for (i = 0; i < n_allocations; i++)
+                if (allocations[i].op != op)
+                  atlas->copied_area += (allocations[i].rectangle.width *
+                                         allocations[i].rectangle.height);
+            }
+          atlas->map = new_map;
+          u_free (allocations);
+          return;
+        }
+
+      _cogl_rectangle_map_free (new_map);
+
+      if (map_width < map_height)
+        map_width <<= 1;
+      else
+        map_height <<= 1;
+    }
+
+  /* The allocation doesn't fit in any atlas. The existing positions
+   * might have been overwritten by the failed attempts so put them
+   * back */
+  for (i = 0; i < n_allocations; i++)
+    atlas->positions[allocations[i].op] = allocations[i].rectangle;
+  atlas->positions[op].width = 0;
+  atlas->n_failures++;
+
+  u_free (allocations);
+}
+
+static void
+replay_trace (const Trace *trace,
+              CoglRectangleMapType type,
+              CoglBool extend,
+              Result *result)
+{
+  Atlas atlas;
+  int i;
+
+  atlas.type = type;
+  atlas.extend = extend;
+  atlas.map = NULL;
+  atlas.positions = u_new0 (CoglRectangleMapEntry, trace->n_ops);
+  atlas.n_reorganizations = 0;
+  atlas.n_failures = 0;
+  atlas.copied_area = 0.0;
+  atlas.full_fraction = 0.0;
+  atlas.n_full = 0;
+
+  result->n_inserts = 0;
+
+  for (i = 0; i < trace->n_ops; i++)
+    {
+      const TraceOp *op = trace->ops + i;
+
+      if (op->width > 0)
+        {
+          atlas_allocate (&atlas, trace, i);
+          result->n_inserts++;
+        }
+      else if (atlas.positions[op->removed].width > 0)
+        _cogl_rectangle_map_remove (atlas.map,
+                                    atlas.positions + op->removed);
+    }
+
+  result->n_reorganizations = atlas.n_reorganizations;
+  result->n_failures = atlas.n_failures;
+  result->copied_area = atlas.copied_area;
+  result->fill_when_full =
+    atlas.n_full > 0 ? atlas.full_fraction * 100.0 / atlas.n_full : 0.0;
+
+  if (atlas.map)
+    {
+      result->width = _cogl_rectangle_map_get_width (atlas.map);
+      result->height = _cogl_rectangle_map_get_height (atlas.map);
+      result->used_area =
+        (result->width * result->height -
+         _cogl_rectangle_map_get_remaining_space (atlas.map));
+
+      _cogl_rectangle_map_free (atlas.map);
+    }
+  else
+    {
+      result->width = result->height = 0;
+      result->used_area = 0;
+    }
+  u_free (atlas.positions);
+}
+
+static void
+run_trace (const Trace *trace,
+           CoglRectangleMapType type,
+           CoglBool extend,
+           double min_time,
+           Result *result)
+{
+  UTimer *timer = u_timer_new ();
+  int n_iterations = 0;
+  double elapsed;
+
+  u_timer_start (timer);
+
+  do
+    {
+      replay_trace (trace, type, extend, result);
+      n_iterations++;
+      elapsed = u_timer_elapsed (timer, NULL);
+    }
+  while (elapsed < min_time);
+
+  result->ns_per_insert =
+    elapsed * 1e9 / ((double) n_iterations * result->n_inserts);
+
+  u_timer_destroy (timer);
+}
+
+int
+main (int argc, char **argv)
+{
+  Trace traces[3];
+  const char *min_time_env;
+  double min_time = DEFAULT_MIN_TIME;
+  CoglBool json = FALSE;
+  CoglBool first = TRUE;
+  int i, j;
+
+  for (i = 1; i < argc; i++)
+    if (!strcmp (argv[i], "--json"))
+      json = TRUE;
+
+  min_time_env = u_getenv ("COGL_BENCHMARK_MIN_TIME");
+  if (min_time_env)
+    min_time = strtod (min_time_env, NULL);
+
+  make_glyph_trace (&traces[0]);
+  make_icon_trace (&traces[1]);
+  make_icon_churn_trace (&traces[2]);
+
+  if (json)
+    u_print ("{\n"
+             "  \"min_time\": %g,\n"
+             "  \"traces\": [",
+             min_time);
+  else
+    u_print ("%-12s %-15s %7s %7s %9s %10s %11s %10s %10s\n",
+             "trace", "mode", "reorgs", "failed", "copied",
+             "atlas", "efficiency", "fill-full", "ns/insert");
+
+  for (i = 0; i < U_N_ELEMENTS (traces); i++)
+    for (j = 0; j < U_N_ELEMENTS (modes); j++)
+      {
+        Result result;
+        double efficiency;
+
+        run_trace (traces + i,
+                   modes[j].type, modes[j].extend,
+                   min_time,
+                   &result);
+
+        efficiency = (result.used_area * 100.0 /
+                      MAX (result.width * result.height, 1));
+
+        if (json)
+          u_print ("%s\n"
+                   "    { \"trace\": \"%s\", "
+                   "\"mode\": \"%s\", "
+                   "\"reorganizations\": %d, "
+                   "\"failures\": %d, "
+                   "\"copied_pixels\": %.0f, "
+                   "\"width\": %u, "
+                   "\"height\": %u, "
+                   "\"efficiency\": %.2f, "
+                   "\"fill_when_full\": %.2f, "
+                   "\"ns_per_insert\": %.2f }",
+                   first ? "" : ",",
+                   traces[i].name,
+                   modes[j].name,
+                   result.n_reorganizations,
+                   result.n_failures,
+                   result.copied_area,
+                   result.width,
+                   result.height,
+                   efficiency,
+                   result.fill_when_full,
+                   result.ns_per_insert);
+        else
+          {
+            char *size = u_strdup_printf ("%ux%u",
+                                          result.width, result.height);
+
+            u_print ("%-12s %-15s %7d %7d %8.2fM %10s %10.1f%% "
+                     "%9.1f%% %10.1f\n",
+                     traces[i].name,
+                     modes[j].name,
+                     result.n_reorganizations,
+                     result.n_failures,
+                     result.copied_area / 1e6,
+                     size,
+                     efficiency,
+                     result.fill_when_full,
+                     result.ns_per_insert);
+
+            u_free (size);
+          }
+
+        first = FALSE;
+      }
+
+  if (json)
+    u_print ("\n  ]\n}\n");
+
+  for (i = 0; i < U_N_ELEMENTS (traces); i++)
+    u_free (traces[i].ops);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include <config.h>
+
+/* NB: This is built with COGL_COMPILATION so that it can use the
+ * private bitmap API which means it can't just include <cogl/cogl.h> */
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-object.h>
+#include <cogl/cogl-bitmap.h>
+#include <cogl/cogl-error.h>
+
+#include <ulib.h>
+#include <stdlib.h>
+
+/* This benchmark converts 1080p and 4K sized bitmaps between a few
+ * common formats, first with all of the work done on the calling
+ * thread and then with the rows split between Cogl's worker threads.
+ * The number of worker threads used for the second run can be
+ * changed with the COGL_MAX_WORKER_THREADS environment variable.
+ *
+ * It doesn't need a real GPU so it can be run with COGL_DRIVER=nop
+ */
+
+#define N_ITERATIONS 10
+
+/* All of the formats fit in 4 bytes per pixel */
+#define BYTES_PER_PIXEL 4
+
+/* Private API exported for the benchmarks */
+CoglBool
+_cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
+                                  CoglBitmap *dst_bmp,
+                                  CoglError **error);
+
+typedef struct
+{
+  const char *name;
+  int width, height;
+} Size;
+
+typedef struct
+{
+  const char *name;
+  CoglPixelFormat src_format;
+  CoglPixelFormat dst_format;
+} Conversion;
+
+static const Size sizes[] =
+  {
+    { "1080p", 1920, 1080 },
+    { "4K", 3840, 2160 }
+  };
+
+static const Conversion conversions[] =
+  {
+    { "RGB_888 -> RGBA_8888",
+      COGL_PIXEL_FORMAT_RGB_888, COGL_PIXEL_FORMAT_RGBA_8888 },
+    { "BGRA_8888 -> RGBA_8888",
+      COGL_PIXEL_FORMAT_BGRA_8888, COGL_PIXEL_FORMAT_RGBA_8888 },
+    { "RGBA_8888 -> RGBA_8888_PRE",
+      COGL_PIXEL_FORMAT_RGBA_8888, COGL_PIXEL_FORMAT_RGBA_8888_PRE },
+    { "ARGB_8888 -> BGRA_8888_PRE",
+      COGL_PIXEL_FORMAT_ARGB_8888, COGL_PIXEL_FORMAT_BGRA_8888_PRE },
+    { "RGBA_8888 -> RGBA_1010102",
+      COGL_PIXEL_FORMAT_RGBA_8888, COGL_PIXEL_FORMAT_RGBA_1010102 }
+  };
+
+static CoglBool
+run_conversion (CoglContext *ctx,
+                const Size *size,
+                const Conversion *conversion)
+{
+  int rowstride = size->width * BYTES_PER_PIXEL;
+  uint8_t *src_data = u_malloc (rowstride * size->height);
+  uint8_t *dst_data = u_malloc (rowstride * size->height);
+  CoglBitmap *src_bmp, *dst_bmp;
+  CoglError *error = NULL;
+  UTimer *timer;
+  double elapsed;
+  int i;
+
+  for (i = 0; i < rowstride * size->height; i++)
+    src_data[i] = i * 7;
+
+  src_bmp = cogl_bitmap_new_for_data (ctx,
+                                      size->width,
+                                      size->height,
+                                      conversion->src_format,
+                                      rowstride,
+                                      src_data);
+  dst_bmp = cogl_bitmap_new_for_data (ctx,
+                                      size->width,
+                                      size->height,
+                                      conversion->dst_format,
+                                      rowstride,
+                                      dst_data);
+
+  timer = u_timer_new ();
+  u_timer_start (timer);
+
+  for (i = 0; i < N_ITERATIONS; i++)
+    if (!_cogl_bitmap_convert_into_bitmap (src_bmp, dst_bmp, &error))
+      break;
+
+  elapsed = u_timer_elapsed (timer, NULL);
+  u_timer_destroy (timer);
+
+  cogl_object_unref (dst_bmp);
+  cogl_object_unref (src_bmp);
+  u_free (dst_data);
+  u_free (src_data);
+
+  if (error)
+    {
+      u_printerr ("Conversion failed: %s\n", error->message);
+      cogl_error_free (error);
+      return FALSE;
+    }
+
+  u_print ("  %-6s %-28s %8.3fms\n",
+           size->name,
+           conversion->name,
+           elapsed * 1000.0 / N_ITERATIONS);
+
+  return TRUE;
+}
+
+static CoglBool
+run_benchmark (const char *name)
+{
+  CoglContext *ctx;
+  CoglError *error = NULL;
+  CoglBool ret = TRUE;
+  int i, j;
+
+  /* The worker pool reads the thread limit when it is created so a
+   * new context is needed for each run */
+  ctx = cogl_context_new (NULL, &error);
+  if (!ctx)
+    {
+      u_printerr ("Failed to create context: %s\n", error->message);
+      return FALSE;
+    }
+
+  u_print ("%s\n", name);
+
+  for (i = 0; i < U_N_ELEMENTS (sizes) && ret; i++)
+    for (j = 0; j < U_N_ELEMENTS (conversions) && ret; j++)
+      ret = run_conversion (ctx, sizes + i, conversions + j);
+
+  cogl_object_unref (ctx);
+
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  char *max_threads = u_strdup (u_getenv ("COGL_MAX_WORKER_THREADS"));
+  CoglBool ret;
+
+  u_setenv ("COGL_MAX_WORKER_THREADS", "1", TRUE);
+  ret = run_benchmark ("single-threaded:");
+
+  if (max_threads)
+    u_setenv ("COGL_MAX_WORKER_THREADS", max_threads, TRUE);
+  else
+    u_unsetenv ("COGL_MAX_WORKER_THREADS");
+  u_free (max_threads);
+
+  if (ret)
+    ret = run_benchmark ("threaded:");
+
+  return ret ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1013 @@
+#include <config.h>
+
+/* NB: This is built with COGL_COMPILATION so that it can benchmark
+ * private API which means it can't just include <cogl/cogl.h> */
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-onscreen.h>
+#include <cogl/cogl-framebuffer.h>
+#include <cogl/cogl-pipeline.h>
+#include <cogl/cogl-pipeline-layer-state.h>
+#include <cogl/cogl-pipeline-state.h>
+#include <cogl/cogl-matrix-stack.h>
+#include <cogl/cogl-texture.h>
+#include <cogl/cogl-texture-2d.h>
+#include <cogl/cogl-bitmap.h>
+#include <cogl/cogl-renderer.h>
+#include <cogl/cogl-pipeline-private.h>
+#include <cogl/cogl-rectangle-map.h>
+
+#ifdef COGL_BENCHMARK_HAVE_PATH
+#include <cogl-path/cogl-path.h>
+#endif
+
+#ifdef COGL_BENCHMARK_HAVE_PANGO
+#include <cogl-pango/cogl-pango.h>
+#endif
+
+#include <ulib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef __GLIBC__
+#include <dlfcn.h>
+#endif
+
+/* This is a collection of benchmarks for the parts of Cogl that run
+ * on the CPU. None of them depend on what the GPU does with the
+ * results so they are meant to be run with COGL_DRIVER=nop, although
+ * they also work with a software rasterizer such as Mesa's llvmpipe.
+ *
+ * Each benchmark is run with an increasing number of iterations until
+ * it takes at least COGL_BENCHMARK_MIN_TIME seconds (0.2 by default)
+ * and then the time and number of allocations per iteration are
+ * reported, along with the number of texture uploads made with
+ * cogl_texture_set_region. Pass --json to get the results in a form that can be
+ * compared between runs. Any other arguments are used to select the
+ * benchmarks to run by name prefix.
+ */
+
+#define FRAMEBUFFER_WIDTH 800
+#define FRAMEBUFFER_HEIGHT 600
+
+#define DEFAULT_MIN_TIME 0.2
+#define MAX_ITERATIONS (1 << 28)
+
+/* The journal is flushed after this many rectangles so that the
+ * journal benchmarks measure both logging and flushing */
+#define RECTANGLES_PER_FLUSH 100
+
+/* The pipeline state to hash and compare. Hashing the uniforms isn't
+ * implemented because nothing that builds a hash table of pipelines
+ * needs it */
+#define PIPELINE_STATE \
+  (COGL_PIPELINE_STATE_ALL_SPARSE & ~COGL_PIPELINE_STATE_UNIFORMS)
+
+#define BITMAP_SIZE 256
+#define ATLAS_SIZE 512
+#define N_ATLAS_ALLOCATIONS 256
+
+/* Private API exported for the benchmarks */
+CoglBool
+_cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
+                                  CoglBitmap *dst_bmp,
+                                  CoglError **error);
+
+typedef struct _Data
+{
+  CoglContext *ctx;
+  CoglFramebuffer *fb;
+  CoglPipeline *solid_pipeline;
+  CoglPipeline *textured_pipeline;
+} Data;
+
+typedef struct _Benchmark
+{
+  const char *name;
+  void * (* setup) (Data *data);
+  void (* run) (Data *data, void *state, int n_iterations);
+  void (* teardown) (void *state);
+} Benchmark;
+
+typedef struct _Result
+{
+  int n_iterations;
+  double ns_per_op;
+  double allocs_per_op;
+  double uploads_per_op;
+} Result;
+
+/* Counting allocations relies on being able to wrap malloc which we
+ * only know how to do with glibc. Everything that goes through ulib,
+ * including the slice allocator's slabs, ends up here */
+#ifdef __GLIBC__
+
+#define HAVE_ALLOCATION_COUNTS
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static unsigned long n_allocations;
+
+void *
+malloc (size_t size)
+{
+  __sync_add_and_fetch (&n_allocations, 1);
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members, size_t size)
+{
+  __sync_add_and_fetch (&n_allocations, 1);
+  return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  __sync_add_and_fetch (&n_allocations, 1);
+  return __libc_realloc (ptr, size);
+}
+
+static unsigned long
+get_n_allocations (void)
+{
+  return __sync_add_and_fetch (&n_allocations, 0);
+}
+
+#else /* __GLIBC__ */
+
+static unsigned long
+get_n_allocations (void)
+{
+  return 0;
+}
+
+#endif /* __GLIBC__ */
+
+/* Texture uploads are counted by wrapping cogl_texture_set_region in
+ * the same way. This only sees calls that go through the PLT, ie.
+ * the ones made by the other libraries such as cogl-pango */
+#ifdef __GLIBC__
+
+#define HAVE_UPLOAD_COUNTS
+
+static unsigned long n_uploads;
+
+CoglBool
+cogl_texture_set_region (CoglTexture *texture,
+                         int width,
+                         int height,
+                         CoglPixelFormat format,
+                         int rowstride,
+                         const uint8_t *data,
+                         int dst_x,
+                         int dst_y,
+                         int level,
+                         CoglError **error)
+{
+  static CoglBool (* real_set_region) (CoglTexture *texture,
+                                       int width,
+                                       int height,
+                                       CoglPixelFormat format,
+                                       int rowstride,
+                                       const uint8_t *data,
+                                       int dst_x,
+                                       int dst_y,
+                                       int level,
+                                       CoglError **error);
+
+  if (real_set_region == NULL)
+    real_set_region = dlsym (RTLD_NEXT, "cogl_texture_set_region");
+
+  __sync_add_and_fetch (&n_uploads, 1);
+
+  return real_set_region (texture,
+                          width, height,
+                          format,
+                          rowstride,
+                          data,
+                          dst_x, dst_y,
+                          level,
+                          error);
+}
+
+static unsigned long
+get_n_uploads (void)
+{
+  return __sync_add_and_fetch (&n_uploads, 0);
+}
+
+#else /* __GLIBC__ */
+
+static unsigned long
+get_n_uploads (void)
+{
+  return 0;
+}
+
+#endif /* __GLIBC__ */
+
+static void
+draw_rectangles (Data *data,
+                 int n_iterations,
+                 CoglBool interleave)
+{
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      CoglPipeline *pipeline = data->solid_pipeline;
+      float x = (i * 7) % FRAMEBUFFER_WIDTH;
+      float y = (i * 13) % FRAMEBUFFER_HEIGHT;
+
+      if (interleave && (i & 1))
+        pipeline = data->textured_pipeline;
+
+      /* Changing the modelview makes the journal transform the
+       * vertices on the CPU which is the common case for UI toolkits */
+      cogl_framebuffer_push_matrix (data->fb);
+      cogl_framebuffer_translate (data->fb, x, y, 0);
+      cogl_framebuffer_draw_rectangle (data->fb, pipeline, 0, 0, 10, 10);
+      cogl_framebuffer_pop_matrix (data->fb);
+
+      if ((i + 1) % RECTANGLES_PER_FLUSH == 0)
+        cogl_framebuffer_finish (data->fb);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+}
+
+static void
+run_journal_rectangles (Data *data, void *state, int n_iterations)
+{
+  draw_rectangles (data, n_iterations, FALSE);
+}
+
+static void
+run_journal_interleaved (Data *data, void *state, int n_iterations)
+{
+  draw_rectangles (data, n_iterations, TRUE);
+}
+
+static void
+run_pipeline_copy (Data *data, void *state, int n_iterations)
+{
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      CoglPipeline *copy = cogl_pipeline_copy (data->textured_pipeline);
+
+      /* Copies are lazy so modify it to make it allocate its own
+       * state like an application would */
+      cogl_pipeline_set_color4f (copy, 1, 0, 0, 1);
+      cogl_object_unref (copy);
+    }
+}
+
+/* Builds a pipeline with a few levels of ancestry and layer state so
+ * that hashing and comparing it has to walk up the hierarchy */
+static CoglPipeline *
+create_deep_pipeline (Data *data)
+{
+  CoglPipeline *parent = cogl_pipeline_copy (data->textured_pipeline);
+  CoglPipeline *pipeline;
+  CoglColor constant;
+
+  cogl_pipeline_set_blend (parent,
+                           "RGBA = ADD (SRC_COLOR, DST_COLOR*(1-SRC_COLOR[A]))",
+                           NULL);
+  pipeline = cogl_pipeline_copy (parent);
+  cogl_object_unref (parent);
+
+  cogl_pipeline_set_color4f (pipeline, 0.5, 0.5, 0.5, 0.5);
+  cogl_color_init_from_4f (&constant, 1, 1, 1, 1);
+  cogl_pipeline_set_layer_combine_constant (pipeline, 0, &constant);
+
+  return pipeline;
+}
+
+static void *
+setup_pipeline_pair (Data *data)
+{
+  CoglPipeline **pipelines = u_new (CoglPipeline *, 2);
+
+  /* Two separately built pipelines so that comparing them can't take
+   * the shortcut for identical pointers */
+  pipelines[0] = create_deep_pipeline (data);
+  pipelines[1] = create_deep_pipeline (data);
+
+  return pipelines;
+}
+
+static void
+teardown_pipeline_pair (void *state)
+{
+  CoglPipeline **pipelines = state;
+
+  cogl_object_unref (pipelines[0]);
+  cogl_object_unref (pipelines[1]);
+  u_free (pipelines);
+}
+
+static void
+run_pipeline_hash (Data *data, void *state, int n_iterations)
+{
+  CoglPipeline **pipelines = state;
+  unsigned int hash = 0;
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    hash ^= _cogl_pipeline_hash (pipelines[i & 1],
+                                 PIPELINE_STATE,
+                                 COGL_PIPELINE_LAYER_STATE_ALL_SPARSE,
+                                 COGL_PIPELINE_EVAL_FLAG_NONE);
+
+  /* Make sure the result is used */
+  if (hash == 0xdeadbeef)
+    u_print ("!");
+}
+
+static void
+run_pipeline_equal (Data *data, void *state, int n_iterations)
+{
+  CoglPipeline **pipelines = state;
+  int n_equal = 0;
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    n_equal += _cogl_pipeline_equal (pipelines[0],
+                                     pipelines[1],
+                                     PIPELINE_STATE,
+                                     COGL_PIPELINE_LAYER_STATE_ALL_SPARSE,
+                                     COGL_PIPELINE_EVAL_FLAG_NONE);
+
+  if (n_equal != n_iterations)
+    u_printerr ("pipeline/equal: pipelines unexpectedly differ\n");
+}
+
+static void *
+setup_matrix_stack (Data *data)
+{
+  return cogl_matrix_stack_new (data->ctx);
+}
+
+static void
+run_matrix_stack (Data *data, void *state, int n_iterations)
+{
+  CoglMatrixStack *stack = state;
+  CoglMatrix matrix;
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      cogl_matrix_stack_push (stack);
+      cogl_matrix_stack_translate (stack, i & 63, 10, 0);
+      cogl_matrix_stack_rotate (stack, 45, 0, 0, 1);
+      cogl_matrix_stack_scale (stack, 2, 2, 1);
+      cogl_matrix_stack_get (stack, &matrix);
+      cogl_matrix_stack_pop (stack);
+    }
+}
+
+typedef struct
+{
+  uint8_t *src_data;
+  uint8_t *dst_data;
+  CoglBitmap *src_bmp;
+  CoglBitmap *dst_bmp;
+} BitmapState;
+
+static void *
+setup_bitmap_conversion (Data *data)
+{
+  BitmapState *state = u_new0 (BitmapState, 1);
+  int rowstride = BITMAP_SIZE * 4;
+  int i;
+
+  state->src_data = u_malloc (rowstride * BITMAP_SIZE);
+  state->dst_data = u_malloc (rowstride * BITMAP_SIZE);
+
+  for (i = 0; i < rowstride * BITMAP_SIZE; i++)
+    state->src_data[i] = i * 7;
+
+  state->src_bmp = cogl_bitmap_new_for_data (data->ctx,
+                                             BITMAP_SIZE, BITMAP_SIZE,
+                                             COGL_PIXEL_FORMAT_RGB_888,
+                                             rowstride,
+                                             state->src_data);
+  state->dst_bmp = cogl_bitmap_new_for_data (data->ctx,
+                                             BITMAP_SIZE, BITMAP_SIZE,
+                                             COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                             rowstride,
+                                             state->dst_data);
+
+  return state;
+}
+
+static void
+teardown_bitmap_conversion (void *user_data)
+{
+  BitmapState *state = user_data;
+
+  cogl_object_unref (state->dst_bmp);
+  cogl_object_unref (state->src_bmp);
+  u_free (state->dst_data);
+  u_free (state->src_data);
+  u_free (state);
+}
+
+static void
+run_bitmap_conversion (Data *data, void *user_data, int n_iterations)
+{
+  BitmapState *state = user_data;
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    _cogl_bitmap_convert_into_bitmap (state->src_bmp, state->dst_bmp, NULL);
+}
+
+static void
+atlas_allocate (CoglRectangleMapType type, int n_iterations)
+{
+  int i, j;
+
+  /* This only measures the rectangle packing. Creating a real atlas
+   * would also need a driver that can report the supported texture
+   * sizes which the nop driver can't do */
+  for (i = 0; i < n_iterations; i++)
+    {
+      CoglRectangleMap *map = _cogl_rectangle_map_new_with_type (type,
+                                                                 ATLAS_SIZE,
+                                                                 ATLAS_SIZE,
+                                                                 NULL);
+      CoglRectangleMapEntry rectangle;
+
+      /* A mix of glyph-like sizes */
+      for (j = 0; j < N_ATLAS_ALLOCATIONS; j++)
+        _cogl_rectangle_map_add (map,
+                                 8 + (j * 5) % 17,
+                                 10 + (j * 3) % 13,
+                                 U_INT_TO_POINTER (j + 1),
+                                 &rectangle);
+
+      _cogl_rectangle_map_free (map);
+    }
+}
+
+static void
+run_atlas_allocate (Data *data, void *state, int n_iterations)
+{
+  atlas_allocate (COGL_RECTANGLE_MAP_TYPE_TREE, n_iterations);
+}
+
+static void
+run_atlas_allocate_skyline (Data *data, void *state, int n_iterations)
+{
+  atlas_allocate (COGL_RECTANGLE_MAP_TYPE_SKYLINE, n_iterations);
+}
+
+#ifdef COGL_BENCHMARK_HAVE_PATH
+
+static void
+run_path_fill (Data *data, void *state, int n_iterations)
+{
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      CoglPath *path = cogl_path_new (data->ctx);
+
+      cogl_path_round_rectangle (path, 10, 10, 200, 100, 20, 10);
+      cogl_path_ellipse (path, 300, 300, 80, 40);
+      cogl_path_move_to (path, 400, 100);
+      cogl_path_curve_to (path, 500, 0, 600, 200, 500, 250);
+      cogl_path_curve_to (path, 450, 275, 420, 200, 400, 100);
+      cogl_path_close (path);
+
+      /* Filling the path is what tessellates it */
+      cogl_path_fill (path, data->fb, data->solid_pipeline);
+
+      cogl_object_unref (path);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+}
+
+static void
+run_path_stroke_wide (Data *data, void *state, int n_iterations)
+{
+  float dashes[] = { 12, 4 };
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      CoglPath *path = cogl_path_new (data->ctx);
+
+      cogl_path_set_stroke_width (path, 6);
+      cogl_path_set_line_join (path, COGL_PATH_LINE_JOIN_ROUND);
+      cogl_path_set_line_cap (path, COGL_PATH_LINE_CAP_ROUND);
+      cogl_path_set_dash (path, dashes, 2, 0);
+
+      cogl_path_round_rectangle (path, 10, 10, 200, 100, 20, 10);
+      cogl_path_move_to (path, 400, 100);
+      cogl_path_curve_to (path, 500, 0, 600, 200, 500, 250);
+      cogl_path_curve_to (path, 450, 275, 420, 200, 400, 100);
+
+      /* Stroking the path is what builds the triangles */
+      cogl_path_stroke (path, data->fb, data->solid_pipeline);
+
+      cogl_object_unref (path);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+}
+
+static void *
+setup_path_zoom (Data *data)
+{
+  CoglPath *path = cogl_path_new (data->ctx);
+
+  cogl_path_move_to (path, 0, 50);
+  cogl_path_curve_to (path, 0, 0, 100, 0, 100, 50);
+  cogl_path_curve_to (path, 100, 100, 0, 100, 0, 50);
+  cogl_path_move_to (path, 120, 20);
+  cogl_path_curve_to (path, 220, -20, 260, 120, 140, 90);
+  cogl_path_close (path);
+
+  return path;
+}
+
+static void
+run_path_fill_zoom (Data *data, void *state, int n_iterations)
+{
+  CoglPath *path = state;
+  int i;
+
+  /* Simulates a zoom animation that bounces between a few scales.
+     Each frame uses a slightly different scale but the path should
+     only need to be tessellated once per scale bucket */
+  for (i = 0; i < n_iterations; i++)
+    {
+      float scale = 1.0f + (i % 64) / 64.0f;
+
+      cogl_framebuffer_push_matrix (data->fb);
+      cogl_framebuffer_scale (data->fb, scale, scale, 1.0f);
+      cogl_path_fill (path, data->fb, data->solid_pipeline);
+      cogl_framebuffer_pop_matrix (data->fb);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+}
+
+#endif /* COGL_BENCHMARK_HAVE_PATH */
+
+#ifdef COGL_BENCHMARK_HAVE_PANGO
+
+typedef struct
+{
+  CoglPangoFontMap *font_map;
+  PangoContext *context;
+  PangoLayout *layout;
+} GlyphCacheState;
+
+static GlyphCacheState *
+create_glyph_cache_state (Data *data,
+                          CoglBool use_worker_threads,
+                          CoglBool use_distance_field)
+{
+  GlyphCacheState *state = u_new0 (GlyphCacheState, 1);
+  PangoFontDescription *desc;
+
+  state->font_map = COGL_PANGO_FONT_MAP (cogl_pango_font_map_new (data->ctx));
+  cogl_pango_font_map_set_use_worker_threads (state->font_map,
+                                              use_worker_threads);
+  cogl_pango_font_map_set_use_distance_field (state->font_map,
+                                              use_distance_field);
+  state->context =
+    pango_font_map_create_context (PANGO_FONT_MAP (state->font_map));
+  state->layout = pango_layout_new (state->context);
+
+  desc = pango_font_description_from_string ("Sans 12");
+  pango_layout_set_font_description (state->layout, desc);
+  pango_font_description_free (desc);
+
+  pango_layout_set_text (state->layout,
+                         "The quick brown fox jumps over the lazy dog. "
+                         "0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+                         -1);
+
+  /* Populate the cache so that the benchmark only measures lookups */
+  cogl_pango_ensure_glyph_cache_for_layout (state->layout);
+
+  return state;
+}
+
+static void *
+setup_glyph_cache (Data *data)
+{
+  return create_glyph_cache_state (data, FALSE, FALSE);
+}
+
+static void
+teardown_glyph_cache (void *user_data)
+{
+  GlyphCacheState *state = user_data;
+
+  g_object_unref (state->layout);
+  g_object_unref (state->context);
+  g_object_unref (state->font_map);
+  u_free (state);
+}
+
+static void
+run_glyph_cache (Data *data, void *user_data, int n_iterations)
+{
+  GlyphCacheState *state = user_data;
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    cogl_pango_ensure_glyph_cache_for_layout (state->layout);
+}
+
+/* Measures the time taken before a layout can be drawn with a new
+ * font map. All of the glyphs are new so this is dominated by
+ * rasterizing them and uploading them to the atlas */
+static void
+first_frame (Data *data, CoglBool use_worker_threads, int n_iterations)
+{
+  int i;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      GlyphCacheState *state =
+        create_glyph_cache_state (data, use_worker_threads, FALSE);
+
+      teardown_glyph_cache (state);
+    }
+}
+
+static void
+run_glyph_cache_first_frame (Data *data, void *user_data, int n_iterations)
+{
+  first_frame (data, FALSE, n_iterations);
+}
+
+static void
+run_glyph_cache_first_frame_threaded (Data *data,
+                                      void *user_data,
+                                      int n_iterations)
+{
+  first_frame (data, TRUE, n_iterations);
+}
+
+/* Measures preparing the same text at every pixel size from 8 to 24
+ * with a new font map, as happens when text is zoomed. Normally
+ * every size needs its own set of glyphs but in distance field mode
+ * they should all share one */
+static void
+all_sizes (Data *data, CoglBool use_distance_field, int n_iterations)
+{
+  int i, size;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      GlyphCacheState *state =
+        create_glyph_cache_state (data, FALSE, use_distance_field);
+
+      for (size = 8; size <= 24; size++)
+        {
+          PangoFontDescription *desc = pango_font_description_new ();
+
+          pango_font_description_set_family (desc, "Sans");
+          pango_font_description_set_absolute_size (desc,
+                                                    size * PANGO_SCALE);
+          pango_layout_set_font_description (state->layout, desc);
+          pango_font_description_free (desc);
+
+          cogl_pango_ensure_glyph_cache_for_layout (state->layout);
+        }
+
+      teardown_glyph_cache (state);
+    }
+}
+
+static void
+run_glyph_cache_all_sizes (Data *data, void *user_data, int n_iterations)
+{
+  all_sizes (data, FALSE, n_iterations);
+}
+
+static void
+run_glyph_cache_all_sizes_distance_field (Data *data,
+                                          void *user_data,
+                                          int n_iterations)
+{
+  all_sizes (data, TRUE, n_iterations);
+}
+
+/* Draws a screen full of small labels with a different color and
+ * position for each one, as in a dashboard */
+static void
+draw_labels (Data *data,
+             GlyphCacheState *state,
+             CoglBool batch,
+             int n_iterations)
+{
+  int i, label;
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      if (batch)
+        cogl_pango_font_map_begin_batch (state->font_map);
+
+      for (label = 0; label < 200; label++)
+        {
+          CoglColor color;
+
+          cogl_color_init_from_4ub (&color, label, 255 - label, 128, 255);
+          cogl_pango_show_layout (data->fb,
+                                  state->layout,
+                                  (label % 10) * 64,
+                                  (label / 10) * 24,
+                                  &color);
+        }
+
+      if (batch)
+        cogl_pango_font_map_end_batch (state->font_map);
+
+      cogl_framebuffer_finish (data->fb);
+    }
+}
+
+static void
+run_text_labels (Data *data, void *user_data, int n_iterations)
+{
+  draw_labels (data, user_data, FALSE, n_iterations);
+}
+
+static void
+run_text_labels_batched (Data *data, void *user_data, int n_iterations)
+{
+  draw_labels (data, user_data, TRUE, n_iterations);
+}
+
+#endif /* COGL_BENCHMARK_HAVE_PANGO */
+
+static const Benchmark benchmarks[] =
+  {
+    { "journal/rectangle", NULL, run_journal_rectangles, NULL },
+    { "journal/rectangle-interleaved", NULL, run_journal_interleaved, NULL },
+    { "pipeline/copy", NULL, run_pipeline_copy, NULL },
+    { "pipeline/hash",
+      setup_pipeline_pair, run_pipeline_hash, teardown_pipeline_pair },
+    { "pipeline/equal",
+      setup_pipeline_pair, run_pipeline_equal, teardown_pipeline_pair },
+    { "matrix-stack/push-transform-get-pop",
+      setup_matrix_stack, run_matrix_stack, cogl_object_unref },
+    { "bitmap/convert-256x256-rgb888-to-rgba8888-pre",
+      setup_bitmap_conversion,
+      run_bitmap_conversion,
+      teardown_bitmap_conversion },
+    { "atlas/rectangle-map-add-256", NULL, run_atlas_allocate, NULL },
+    { "atlas/skyline-add-256", NULL, run_atlas_allocate_skyline, NULL },
+#ifdef COGL_BENCHMARK_HAVE_PATH
+    { "path/fill", NULL, run_path_fill, NULL },
+    { "path/fill-zoom",
+      setup_path_zoom, run_path_fill_zoom, cogl_object_unref },
+    { "path/stroke-wide", NULL, run_path_stroke_wide, NULL },
+#endif
+#ifdef COGL_BENCHMARK_HAVE_PANGO
+    { "glyph-cache/lookup-layout",
+      setup_glyph_cache, run_glyph_cache, teardown_glyph_cache },
+    { "glyph-cache/first-frame", NULL, run_glyph_cache_first_frame, NULL },
+    { "glyph-cache/first-frame-worker-threads",
+      NULL, run_glyph_cache_first_frame_threaded, NULL },
+    { "glyph-cache/sizes-8-to-24", NULL, run_glyph_cache_all_sizes, NULL },
+    { "glyph-cache/sizes-8-to-24-distance-field",
+      NULL, run_glyph_cache_all_sizes_distance_field, NULL },
+    { "text/labels-200",
+      setup_glyph_cache, run_text_labels, teardown_glyph_cache },
+    { "text/labels-200-batched",
+      setup_glyph_cache, run_text_labels_batched, teardown_glyph_cache },
+#endif
+  };
+
+static void
+run_benchmark (Data *data,
+               const Benchmark *benchmark,
+               double min_time,
+               Result *result)
+{
+  void *state = benchmark->setup ? benchmark->setup (data) : NULL;
+  UTimer *timer = u_timer_new ();
+  int n_iterations = 1;
+  unsigned long start_allocations;
+  unsigned long start_uploads;
+  double elapsed;
+
+  /* Warm up any caches first so that they don't count against the
+   * first measurement */
+  benchmark->run (data, state, 1);
+
+  while (TRUE)
+    {
+      start_allocations = get_n_allocations ();
+      start_uploads = get_n_uploads ();
+
+      u_timer_start (timer);
+      benchmark->run (data, state, n_iterations);
+      elapsed = u_timer_elapsed (timer, NULL);
+
+      if (elapsed >= min_time || n_iterations >= MAX_ITERATIONS)
+        break;
+
+      /* Aim a little past the minimum time so that we usually only
+       * need one more run */
+      if (elapsed <= 0.0)
+        n_iterations *= 100;
+      else
+        n_iterations = MIN (n_iterations * 100,
+                            n_iterations * (min_time * 1.2 / elapsed) + 1);
+      n_iterations = MIN (n_iterations, MAX_ITERATIONS);
+    }
+
+  result->n_iterations = n_iterations;
+  result->ns_per_op = elapsed * 1e9 / n_iterations;
+  result->allocs_per_op =
+    (double) (get_n_allocations () - start_allocations) / n_iterations;
+  result->uploads_per_op =
+    (double) (get_n_uploads () - start_uploads) / n_iterations;
+
+  u_timer_destroy (timer);
+
+  if (benchmark->teardown)
+    benchmark->teardown (state);
+}
+
+static const char *
+get_driver_name (CoglContext *ctx)
+{
+  switch (cogl_renderer_get_driver (cogl_context_get_renderer (ctx)))
+    {
+    case COGL_DRIVER_NOP:
+      return "nop";
+    case COGL_DRIVER_GL:
+      return "gl";
+    case COGL_DRIVER_GL3:
+      return "gl3";
+    case COGL_DRIVER_GLES2:
+      return "gles2";
+    case COGL_DRIVER_WEBGL:
+      return "webgl";
+    default:
+      return "unknown";
+    }
+}
+
+static CoglBool
+is_selected (const char *name, int argc, char **argv)
+{
+  CoglBool have_filter = FALSE;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (argv[i][0] == '-')
+        continue;
+
+      have_filter = TRUE;
+
+      if (u_str_has_prefix (name, argv[i]))
+        return TRUE;
+    }
+
+  return !have_filter;
+}
+
+int
+main (int argc, char **argv)
+{
+  Data data;
+  CoglError *error = NULL;
+  CoglOnscreen *onscreen;
+  CoglTexture2D *texture;
+  const char *min_time_env;
+  double min_time = DEFAULT_MIN_TIME;
+  CoglBool json = FALSE;
+  CoglBool first = TRUE;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    if (!strcmp (argv[i], "--json"))
+      json = TRUE;
+
+  min_time_env = u_getenv ("COGL_BENCHMARK_MIN_TIME");
+  if (min_time_env)
+    min_time = strtod (min_time_env, NULL);
+
+  data.ctx = cogl_context_new (NULL, &error);
+  if (!data.ctx)
+    {
+      u_printerr ("Failed to create context: %s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  onscreen = cogl_onscreen_new (data.ctx,
+                                FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+  data.fb = COGL_FRAMEBUFFER (onscreen);
+  if (!cogl_framebuffer_allocate (data.fb, &error))
+    {
+      u_printerr ("Failed to allocate framebuffer: %s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  cogl_framebuffer_orthographic (data.fb,
+                                 0, 0,
+                                 FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT,
+                                 -1, 100);
+
+  data.solid_pipeline = cogl_pipeline_new (data.ctx);
+  cogl_pipeline_set_color4f (data.solid_pipeline, 1, 0, 0, 1);
+
+  texture = cogl_texture_2d_new_with_size (data.ctx, 64, 64);
+  data.textured_pipeline = cogl_pipeline_new (data.ctx);
+  cogl_pipeline_set_layer_texture (data.textured_pipeline, 0,
+                                   COGL_TEXTURE (texture));
+  cogl_object_unref (texture);
+
+  if (json)
+    u_print ("{\n"
+             "  \"driver\": \"%s\",\n"
+             "  \"min_time\": %g,\n"
+             "  \"benchmarks\": [",
+             get_driver_name (data.ctx),
+             min_time);
+  else
+    u_print ("%-48s %12s %12s %10s %10s\n",
+             "benchmark", "iterations", "ns/op", "allocs/op", "uploads/op");
+
+  for (i = 0; i < U_N_ELEMENTS (benchmarks); i++)
+    {
+      const Benchmark *benchmark = benchmarks + i;
+      Result result;
+
+      if (!is_selected (benchmark->name, argc, argv))
+        continue;
+
+      run_benchmark (&data, benchmark, min_time, &result);
+
+      if (json)
+        {
+          u_print ("%s\n"
+                   "    { \"name\": \"%s\", "
+                   "\"iterations\": %d, "
+                   "\"ns_per_op\": %.2f, ",
+                   first ? "" : ",",
+                   benchmark->name,
+                   result.n_iterations,
+                   result.ns_per_op);
+#ifdef HAVE_ALLOCATION_COUNTS
+          u_print ("\"allocs_per_op\": %.3f, ", result.allocs_per_op);
+#else
+          u_print ("\"allocs_per_op\": null, ");
+#endif
+#ifdef HAVE_UPLOAD_COUNTS
+          u_print ("\"uploads_per_op\": %.3f }", result.uploads_per_op);
+#else
+          u_print ("\"uploads_per_op\": null }");
+#endif
+        }
+      else
+        {
+          u_print ("%-48s %12d %12.1f ",
+                   benchmark->name,
+                   result.n_iterations,
+                   result.ns_per_op);
+#ifdef HAVE_ALLOCATION_COUNTS
+          u_print ("%10.2f ", result.allocs_per_op);
+#else
+          u_print ("%10s ", "-");
+#endif
+#ifdef HAVE_UPLOAD_COUNTS
+          u_print ("%10.2f\n", result.uploads_per_op);
+#else
+          u_print ("%10s\n", "-");
+#endif
+        }
+
+      first = FALSE;
+    }
+
+  if (json)
+    u_print ("\n  ]\n}\n");
+
+  cogl_object_unref (data.textured_pipeline);
+  cogl_object_unref (data.solid_pipeline);
+  cogl_object_unref (data.fb);
+  cogl_object_unref (data.ctx);
+
+  return EXIT_SUCCESS;
+}
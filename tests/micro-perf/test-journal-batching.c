@@ -0,0 +1,176 @@
+#include <config.h>
+
+/* NB: This is built with COGL_COMPILATION so that it can toggle the
+ * debug flags which means it can't just include <cogl/cogl.h> */
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-onscreen.h>
+#include <cogl/cogl-framebuffer.h>
+#include <cogl/cogl-pipeline.h>
+#include <cogl/cogl-pipeline-layer-state.h>
+#include <cogl/cogl-pipeline-state.h>
+#include <cogl/cogl-texture-2d.h>
+#include <cogl/cogl-debug.h>
+
+#include <ulib.h>
+#include <stdlib.h>
+
+/* This benchmark logs a scene made out of lots of small labels into
+ * the journal. Each label is a solid background rectangle followed by
+ * a run of textured glyph quads so consecutive entries keep switching
+ * between two pipelines. It reports how many batches and draw calls
+ * the journal needed with and without reordering the entries.
+ *
+ * It doesn't need a real GPU so it can be run with COGL_DRIVER=nop
+ */
+
+#define FRAMEBUFFER_WIDTH 800
+#define FRAMEBUFFER_HEIGHT 600
+
+#define LABEL_WIDTH 100
+#define LABEL_HEIGHT 20
+#define GLYPHS_PER_LABEL 10
+#define N_FRAMES 100
+
+/* Private API exported for the benchmarks */
+void
+_cogl_framebuffer_get_journal_stats (CoglFramebuffer *framebuffer,
+                                     int *n_entries,
+                                     int *n_batches,
+                                     int *n_draw_calls);
+
+typedef struct _Data
+{
+  CoglContext *ctx;
+  CoglFramebuffer *fb;
+  CoglPipeline *background_pipeline;
+  CoglPipeline *glyph_pipeline;
+} Data;
+
+static void
+draw_labels (Data *data)
+{
+  int x, y, i;
+
+  for (y = 0; y + LABEL_HEIGHT <= FRAMEBUFFER_HEIGHT; y += LABEL_HEIGHT)
+    for (x = 0; x + LABEL_WIDTH <= FRAMEBUFFER_WIDTH; x += LABEL_WIDTH)
+      {
+        /* Leave a gap between the labels so that they don't touch */
+        cogl_framebuffer_draw_rectangle (data->fb,
+                                         data->background_pipeline,
+                                         x + 1, y + 1,
+                                         x + LABEL_WIDTH - 1,
+                                         y + LABEL_HEIGHT - 1);
+
+        for (i = 0; i < GLYPHS_PER_LABEL; i++)
+          {
+            float glyph_width = (LABEL_WIDTH - 4) / GLYPHS_PER_LABEL;
+            float glyph_x = x + 2 + i * glyph_width;
+
+            cogl_framebuffer_draw_textured_rectangle (data->fb,
+                                                      data->glyph_pipeline,
+                                                      glyph_x, y + 3,
+                                                      glyph_x + glyph_width,
+                                                      y + LABEL_HEIGHT - 3,
+                                                      0, 0, 1, 1);
+          }
+      }
+}
+
+static void
+run_benchmark (Data *data, const char *name)
+{
+  int start_entries, start_batches, start_draw_calls;
+  int end_entries, end_batches, end_draw_calls;
+  UTimer *timer = u_timer_new ();
+  double elapsed;
+  int frame;
+
+  _cogl_framebuffer_get_journal_stats (data->fb,
+                                       &start_entries,
+                                       &start_batches,
+                                       &start_draw_calls);
+
+  u_timer_start (timer);
+
+  for (frame = 0; frame < N_FRAMES; frame++)
+    {
+      draw_labels (data);
+      cogl_framebuffer_finish (data->fb);
+    }
+
+  elapsed = u_timer_elapsed (timer, NULL);
+  u_timer_destroy (timer);
+
+  _cogl_framebuffer_get_journal_stats (data->fb,
+                                       &end_entries,
+                                       &end_batches,
+                                       &end_draw_calls);
+
+  u_print ("%-10s entries/frame = %d, batches/frame = %d, "
+           "draw calls/frame = %d, time/frame = %.3fms\n",
+           name,
+           (end_entries - start_entries) / N_FRAMES,
+           (end_batches - start_batches) / N_FRAMES,
+           (end_draw_calls - start_draw_calls) / N_FRAMES,
+           elapsed * 1000.0 / N_FRAMES);
+}
+
+int
+main (int argc, char **argv)
+{
+  Data data;
+  CoglOnscreen *onscreen;
+  CoglTexture2D *glyph_texture;
+  CoglError *error = NULL;
+  static const uint8_t glyph_data[] = { 0xff, 0x00, 0x00, 0xff };
+
+  data.ctx = cogl_context_new (NULL, &error);
+  if (!data.ctx)
+    {
+      u_printerr ("Failed to create context: %s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  onscreen = cogl_onscreen_new (data.ctx,
+                                FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+  data.fb = COGL_FRAMEBUFFER (onscreen);
+
+  if (!cogl_framebuffer_allocate (data.fb, &error))
+    {
+      u_printerr ("Failed to allocate framebuffer: %s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  cogl_framebuffer_orthographic (data.fb,
+                                 0, 0,
+                                 FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT,
+                                 -1,
+                                 100);
+
+  data.background_pipeline = cogl_pipeline_new (data.ctx);
+  cogl_pipeline_set_color4f (data.background_pipeline, 0.2, 0.2, 0.2, 1);
+
+  glyph_texture = cogl_texture_2d_new_from_data (data.ctx,
+                                                 2, 2,
+                                                 COGL_PIXEL_FORMAT_A_8,
+                                                 2, /* rowstride */
+                                                 glyph_data,
+                                                 NULL);
+  data.glyph_pipeline = cogl_pipeline_new (data.ctx);
+  cogl_pipeline_set_layer_texture (data.glyph_pipeline, 0,
+                                   COGL_TEXTURE (glyph_texture));
+
+  COGL_DEBUG_SET_FLAG (COGL_DEBUG_DISABLE_JOURNAL_REORDER);
+  run_benchmark (&data, "ordered:");
+
+  COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_DISABLE_JOURNAL_REORDER);
+  run_benchmark (&data, "reordered:");
+
+  cogl_object_unref (glyph_texture);
+  cogl_object_unref (data.glyph_pipeline);
+  cogl_object_unref (data.background_pipeline);
+  cogl_object_unref (data.fb);
+  cogl_object_unref (data.ctx);
+
+  return EXIT_SUCCESS;
+}